@@ -10,9 +10,16 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <IlmThreadPool.h>
 #include <ImfAcesFile.h>
 #include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfInputFile.h>
+#include <ImfOutputFile.h>
 #include <ImfRgbaFile.h>
+#include <ImfStandardAttributes.h>
+#include <ImfThreading.h>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <stdlib.h>
@@ -56,8 +63,14 @@ usageMessage (const char argv0[], bool verbose = false)
                 "* The \"chromaticities\" header attribute must specify\n"
                 "  the ACES RGB primaries and white point.\n"
                 "\n"
+                "Input files that already are ACES image files are\n"
+                "copied without decompressing and recompressing them.\n"
+                "\n"
                 "Options:\n"
                 "\n"
+                "-j n      uses n threads to read and write the image\n"
+                "          files (default is the number of CPU cores)\n"
+                "\n"
                 "-v        verbose mode\n"
                 "\n"
                 "-h        prints this message\n";
@@ -68,33 +81,80 @@ usageMessage (const char argv0[], bool verbose = false)
     exit (1);
 }
 
-void
-exr2aces (const char inFileName[], const char outFileName[], bool verbose)
+//
+// The channels that an AcesOutputFile with the given
+// RgbaChannels writes (see RgbaOutputFile).
+//
+
+ChannelList
+acesChannels (RgbaChannels ch)
 {
-    Array2D<Rgba> p;
-    Header        h;
-    RgbaChannels  ch;
-    Box2i         dw;
-    int           width;
-    int           height;
+    ChannelList channels;
+
+    if (ch & (WRITE_Y | WRITE_C))
+    {
+        if (ch & WRITE_Y) channels.insert ("Y", Channel (HALF, 1, 1));
 
+        if (ch & WRITE_C)
+        {
+            channels.insert ("RY", Channel (HALF, 2, 2, true));
+            channels.insert ("BY", Channel (HALF, 2, 2, true));
+        }
+    }
+    else
     {
-        if (verbose) cout << "Reading file " << inFileName << endl;
+        if (ch & WRITE_R) channels.insert ("R", Channel (HALF, 1, 1));
+        if (ch & WRITE_G) channels.insert ("G", Channel (HALF, 1, 1));
+        if (ch & WRITE_B) channels.insert ("B", Channel (HALF, 1, 1));
+    }
 
-        AcesInputFile in (inFileName);
+    if (ch & WRITE_A) channels.insert ("A", Channel (HALF, 1, 1));
 
-        h  = in.header ();
-        ch = in.channels ();
-        dw = h.dataWindow ();
+    return channels;
+}
 
-        width  = dw.max.x - dw.min.x + 1;
-        height = dw.max.y - dw.min.y + 1;
-        p.resizeErase (height, width);
+//
+// An input file already is an ACES image file if it contains
+// scan lines, compressed with one of the ACES compression methods,
+// of exactly the channels that the output file would contain,
+// and if it needs no color conversion (see AcesInputFile).
+// Its chunks can then be copied without decompressing them.
+//
 
-        in.setFrameBuffer (ComputeBasePointer (&p[0][0], dw), 1, width);
-        in.readPixels (dw.min.y, dw.max.y);
+bool
+isAcesFile (InputFile& in, RgbaChannels ch, Compression compression)
+{
+    const Header& h = in.header ();
+
+    if (in.header ().hasTileDescription () || h.compression () != compression ||
+        !(h.channels () == acesChannels (ch)))
+    {
+        return false;
     }
 
+    Chromaticities chr;
+
+    if (hasChromaticities (h)) chr = chromaticities (h);
+
+    if (hasAdoptedNeutral (h)) chr.white = adoptedNeutral (h);
+
+    const Chromaticities& acesChr = acesChromaticities ();
+
+    return chr.red == acesChr.red && chr.green == acesChr.green &&
+           chr.blue == acesChr.blue && chr.white == acesChr.white;
+}
+
+void
+exr2aces (const char inFileName[], const char outFileName[], bool verbose)
+{
+    if (verbose) cout << "Reading file " << inFileName << endl;
+
+    AcesInputFile in (inFileName);
+
+    Header       h  = in.header ();
+    RgbaChannels ch = in.channels ();
+    Box2i        dw = h.dataWindow ();
+
     switch (h.compression ())
     {
         case NO_COMPRESSION: break;
@@ -105,13 +165,67 @@ exr2aces (const char inFileName[], const char outFileName[], bool verbose)
         default: h.compression () = PIZ_COMPRESSION;
     }
 
+    //
+    // ACES image files contain scan lines; tiled input is converted.
+    // Tiled files may have RANDOM_Y line order, which is not valid
+    // for scan line files, and their chunk count does not match the
+    // number of scan line blocks.
+    //
+
+    if (h.hasTileDescription ())
+    {
+        h.erase ("tiles");
+        h.erase ("chunkCount");
+        h.lineOrder () = INCREASING_Y;
+    }
+
     {
-        if (verbose) cout << "Writing file " << outFileName << endl;
+        InputFile rawIn (inFileName);
+
+        if (isAcesFile (rawIn, ch, h.compression ()))
+        {
+            if (verbose)
+                cout << "Copying pixels to file " << outFileName << endl;
 
-        AcesOutputFile out (outFileName, h, ch);
+            addChromaticities (h, acesChromaticities ());
+            addAdoptedNeutral (h, acesChromaticities ().white);
 
-        out.setFrameBuffer (ComputeBasePointer (&p[0][0], dw), 1, width);
-        out.writePixels (height);
+            OutputFile out (outFileName, h);
+            out.copyPixels (rawIn);
+            return;
+        }
+    }
+
+    if (verbose) cout << "Writing file " << outFileName << endl;
+
+    AcesOutputFile out (outFileName, h, ch);
+
+    //
+    // Convert the pixels in bands of scan lines, in the order in
+    // which they are stored in the output file, so that only one
+    // band is held in memory.
+    //
+
+    const int bandHeight = 256;
+
+    int  width      = dw.max.x - dw.min.x + 1;
+    int  numBands   = (dw.max.y - dw.min.y + bandHeight) / bandHeight;
+    bool decreasing = h.lineOrder () == DECREASING_Y;
+
+    Array2D<Rgba> p (bandHeight, width);
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        int y1 = dw.min.y + (decreasing ? numBands - 1 - b : b) * bandHeight;
+        int y2 = min (y1 + bandHeight - 1, dw.max.y);
+
+        Box2i band (V2i (dw.min.x, y1), V2i (dw.max.x, y2));
+
+        in.setFrameBuffer (ComputeBasePointer (&p[0][0], band), 1, width);
+        in.readPixels (y1, y2);
+
+        out.setFrameBuffer (ComputeBasePointer (&p[0][0], band), 1, width);
+        out.writePixels (y2 - y1 + 1);
     }
 }
 
@@ -123,6 +237,8 @@ main (int argc, char** argv)
     const char* inFile  = 0;
     const char* outFile = 0;
     bool        verbose = false;
+    int         threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
 
     //
     // Parse the command line.
@@ -134,7 +250,25 @@ main (int argc, char** argv)
 
     while (i < argc)
     {
-        if (!strcmp (argv[i], "-v"))
+        if (!strcmp (argv[i], "-j"))
+        {
+            //
+            // Set number of threads
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-v"))
         {
             //
             // Verbose mode
@@ -176,6 +310,7 @@ main (int argc, char** argv)
 
     try
     {
+        setGlobalThreadCount (threads);
         exr2aces (inFile, outFile, verbose);
     }
     catch (const exception& e)
@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // Copyright (c) Contributors to the OpenEXR Project.
 
+#include <IlmThreadPool.h>
 #include <ImathConfig.h>
 #include <ImfCheckFile.h>
+#include <ImfThreading.h>
+#include <openexr.h>
 
 #include <cstdint>
 #include <fstream>
@@ -21,6 +24,7 @@ using std::cout;
 using std::endl;
 using std::ifstream;
 using std::streampos;
+using std::string;
 using std::vector;
 
 void
@@ -34,9 +38,55 @@ usageMessage (const char argv0[])
         << "  -t : avoid spending excessive time (some files will not be fully checked)\n";
     cerr << "  -s : use stream API instead of file API\n";
     cerr << "  -c : add core library checks\n";
+    cerr
+        << "  -p : only run core library checks, decoding every chunk in parallel,\n"
+           "       and report each bad chunk (replaces the other checks)\n";
+    cerr
+        << "  -j n : use n threads for -p (default is the number of CPU cores)\n";
+    cerr << "  -M n : limit chunk data held by -p to n megabytes (default 256)\n";
     cerr << "  -v : print OpenEXR and Imath software library version info\n";
 }
 
+vector<char>
+readFile (const char* filename)
+{
+    //
+    // open file as stream, check size
+    //
+    ifstream instream (filename, ifstream::binary);
+
+    if (!instream)
+    {
+        cerr << "internal error: bad file '" << filename
+             << "' for in-memory stream" << endl;
+        return vector<char> ();
+    }
+
+    instream.seekg (0, instream.end);
+    streampos length = instream.tellg ();
+    instream.seekg (0, instream.beg);
+
+    const uintptr_t kMaxSize = uintptr_t (-1) / 4;
+    if (length < 0 || length > (streampos) kMaxSize)
+    {
+        cerr << "internal error: bad file length " << length
+             << " for in-memory stream" << endl;
+        return vector<char> ();
+    }
+
+    //
+    // read into memory
+    //
+    vector<char> data (length);
+    instream.read (data.data (), length);
+    if (instream.gcount () != length)
+    {
+        cerr << "internal error: failed to read file " << filename << endl;
+        return vector<char> ();
+    }
+    return data;
+}
+
 bool
 exrCheck (
     const char* filename,
@@ -47,42 +97,15 @@ exrCheck (
 {
     if (useStream)
     {
-        //
-        // open file as stream, check size
-        //
-        ifstream instream (filename, ifstream::binary);
+        vector<char> data = readFile (filename);
+        if (data.empty ()) return true;
 
-        if (!instream)
-        {
-            cerr << "internal error: bad file '" << filename
-                 << "' for in-memory stream" << endl;
-            return true;
-        }
-
-        instream.seekg (0, instream.end);
-        streampos length = instream.tellg ();
-        instream.seekg (0, instream.beg);
-
-        const uintptr_t kMaxSize = uintptr_t (-1) / 4;
-        if (length < 0 || length > (streampos) kMaxSize)
-        {
-            cerr << "internal error: bad file length " << length
-                 << " for in-memory stream" << endl;
-            return true;
-        }
-
-        //
-        // read into memory
-        //
-        vector<char> data (length);
-        instream.read (data.data (), length);
-        if (instream.gcount () != length)
-        {
-            cerr << "internal error: failed to read file " << filename << endl;
-            return true;
-        }
         return checkOpenEXRFile (
-            data.data (), length, reduceMemory, reduceTime, enableCoreCheck);
+            data.data (),
+            data.size (),
+            reduceMemory,
+            reduceTime,
+            enableCoreCheck);
     }
     else
     {
@@ -91,6 +114,50 @@ exrCheck (
     }
 }
 
+bool
+exrCheckChunks (const char* filename, bool useStream, size_t memoryBudget)
+{
+    vector<ChunkCheckReport> reports;
+    bool                     hasError;
+
+    if (useStream)
+    {
+        vector<char> data = readFile (filename);
+        if (data.empty ()) return true;
+
+        hasError = checkOpenEXRFileChunks (
+            data.data (), data.size (), reports, memoryBudget);
+    }
+    else
+    {
+        hasError = checkOpenEXRFileChunks (filename, reports, memoryBudget);
+    }
+
+    if (hasError) cout << "bad\n";
+
+    for (size_t i = 0; i < reports.size (); ++i)
+    {
+        const ChunkCheckReport& r = reports[i];
+
+        cout << "  ";
+        if (r.part >= 0) cout << "part " << r.part << ", ";
+        if (r.chunk >= 0)
+        {
+            cout << "chunk " << r.chunk << " (";
+            if (r.tiled)
+                cout << "tile " << r.tileX << " " << r.tileY << ", level "
+                     << r.levelX << " " << r.levelY;
+            else
+                cout << "y " << r.y;
+            cout << "), ";
+        }
+        cout << exr_get_error_code_as_string (r.errorCode) << ": "
+             << r.message << "\n";
+    }
+
+    return hasError;
+}
+
 int
 main (int argc, char** argv)
 {
@@ -105,6 +172,10 @@ main (int argc, char** argv)
     bool enableCoreCheck = false;
     bool badFileFound    = false;
     bool useStream       = false;
+    bool checkChunks     = false;
+    int  numThreads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+    size_t memoryBudget = 0;
     for (int i = 1; i < argc; ++i)
     {
         if (!strcmp (argv[i], "-h"))
@@ -135,6 +206,30 @@ main (int argc, char** argv)
         {
             enableCoreCheck = true;
         }
+        else if (!strcmp (argv[i], "-p"))
+        {
+            checkChunks = true;
+        }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            if (i > argc - 2 || (numThreads = atoi (argv[i + 1])) < 0)
+            {
+                usageMessage (argv[0]);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp (argv[i], "-M"))
+        {
+            int megabytes;
+            if (i > argc - 2 || (megabytes = atoi (argv[i + 1])) <= 0)
+            {
+                usageMessage (argv[0]);
+                return 1;
+            }
+            memoryBudget = size_t (megabytes) << 20;
+            ++i;
+        }
         else if (!strcmp (argv[i], "-v"))
         {
             std::cout << OPENEXR_PACKAGE_STRING
@@ -162,6 +257,18 @@ main (int argc, char** argv)
             cout << " file " << argv[i] << ' ';
             cout.flush ();
 
+            if (checkChunks)
+            {
+                setGlobalThreadCount (numThreads);
+
+                if (exrCheckChunks (argv[i], useStream, memoryBudget))
+                    badFileFound = true;
+                else
+                    cout << "OK\n";
+
+                continue;
+            }
+
             bool hasError = exrCheck (
                 argv[i], reduceMemory, reduceTime, useStream, enableCoreCheck);
             if (hasError)
@@ -11,6 +11,13 @@
 
 #include "EnvmapImage.h"
 #include <ImathFun.h>
+#include <ImfSimd.h>
+#include <ImfSystemSpecific.h>
+
+#if defined __SSE2__ || (_MSC_VER && (_M_IX86 || _M_X64))
+#    define ENVMAP_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
 
 #include "namespaceAlias.h"
 using namespace IMF;
@@ -108,6 +115,204 @@ dirToPosCube (const Box2i& dataWindow, const V3f& dir)
     return CubeMap::pixelPosition (face, dataWindow, posInFace);
 }
 
+#ifdef ENVMAP_HAVE_SSE2
+
+inline __m128
+loadPixel (const Rgba& p)
+{
+    //
+    // Load the four half channels of pixel p, and convert them to float.
+    //
+    // Move the exponent and mantissa bits into the positions of
+    // the corresponding float bits, and multiply by 2^112 to
+    // re-bias the exponent.  The multiplication also converts
+    // denormalized halfs correctly.  Halfs that are infinite or
+    // NaN get the maximum float exponent.
+    //
+
+    __m128i h = _mm_loadl_epi64 ((const __m128i*) &p);
+
+    h = _mm_unpacklo_epi16 (h, _mm_setzero_si128 ());
+
+    const __m128i expMant = _mm_and_si128 (h, _mm_set1_epi32 (0x7fff));
+    const __m128i sign    = _mm_slli_epi32 (_mm_xor_si128 (h, expMant), 16);
+
+    __m128 f = _mm_mul_ps (
+        _mm_castsi128_ps (_mm_slli_epi32 (expMant, 13)),
+        _mm_castsi128_ps (_mm_set1_epi32 ((254 - 15) << 23)));
+
+    const __m128i infNan = _mm_and_si128 (
+        _mm_cmpgt_epi32 (expMant, _mm_set1_epi32 (0x7bff)),
+        _mm_set1_epi32 (255 << 23));
+
+    return _mm_or_ps (f, _mm_castsi128_ps (_mm_or_si128 (sign, infNan)));
+}
+
+#    ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+
+__attribute__ ((target ("f16c"))) inline __m128
+loadPixelF16c (const Rgba& p)
+{
+    return _mm_cvtph_ps (_mm_loadl_epi64 ((const __m128i*) &p));
+}
+
+#    endif
+
+template <__m128 (*load) (const Rgba&)>
+inline void
+addSample (
+    const Array2D<Rgba>& pixels,
+    const Box2i&         dataWindow,
+    const V2f&           pos,
+    float                w,
+    __m128&              c)
+{
+    //
+    // Add w times a point sample of the environment map at 2D
+    // position pos to c.  This computes the same bilinear
+    // interpolation as EnvmapImage::sample(), but on all four
+    // channels at once, and without rounding the sample to half.
+    //
+
+    int   x1 = IMATH::floor (pos.x);
+    int   x2 = x1 + 1;
+    float sx = x2 - pos.x;
+    float tx = 1 - sx;
+
+    x1 = clamp (x1, dataWindow.min.x, dataWindow.max.x) - dataWindow.min.x;
+    x2 = clamp (x2, dataWindow.min.x, dataWindow.max.x) - dataWindow.min.x;
+
+    int   y1 = IMATH::floor (pos.y);
+    int   y2 = y1 + 1;
+    float sy = y2 - pos.y;
+    float ty = 1 - sy;
+
+    y1 = clamp (y1, dataWindow.min.y, dataWindow.max.y) - dataWindow.min.y;
+    y2 = clamp (y2, dataWindow.min.y, dataWindow.max.y) - dataWindow.min.y;
+
+    __m128 p1 = _mm_add_ps (
+        _mm_mul_ps (load (pixels[y1][x1]), _mm_set1_ps (sx)),
+        _mm_mul_ps (load (pixels[y1][x2]), _mm_set1_ps (tx)));
+
+    __m128 p2 = _mm_add_ps (
+        _mm_mul_ps (load (pixels[y2][x1]), _mm_set1_ps (sx)),
+        _mm_mul_ps (load (pixels[y2][x2]), _mm_set1_ps (tx)));
+
+    __m128 p = _mm_add_ps (
+        _mm_mul_ps (p1, _mm_set1_ps (sy)), _mm_mul_ps (p2, _mm_set1_ps (ty)));
+
+    c = _mm_add_ps (c, _mm_mul_ps (p, _mm_set1_ps (w)));
+}
+
+//
+// The n by n point samples of EnvmapImage::filteredLookup(), added up.
+// Returns the sum of the samples, and the sum of their weights in wt.
+//
+
+typedef V2f (*DirToPos) (const Box2i&, const V3f&);
+
+template <__m128 (*load) (const Rgba&)>
+inline __m128
+addSamples (
+    const Array2D<Rgba>& pixels,
+    const Box2i&         dataWindow,
+    DirToPos             dirToPos,
+    const V3f&           d,
+    const V3f&           dx,
+    const V3f&           dy,
+    int                  n,
+    float&               wt)
+{
+    __m128 cs = _mm_setzero_ps ();
+
+    for (int y = 0; y < n; ++y)
+    {
+        float ry = float (2 * y + 2) / float (n + 1) - 1;
+        float wy = 1 - abs (ry);
+        V3f   ddy (ry * dy);
+
+        for (int x = 0; x < n; ++x)
+        {
+            float rx = float (2 * x + 2) / float (n + 1) - 1;
+            float wx = 1 - abs (rx);
+            V3f   ddx (rx * dx);
+
+            V2f   pos = dirToPos (dataWindow, d + ddx + ddy);
+            float w   = wx * wy;
+            wt += w;
+
+            addSample<load> (pixels, dataWindow, pos, w, cs);
+        }
+    }
+
+    return cs;
+}
+
+__m128
+addSamplesSse2 (
+    const Array2D<Rgba>& pixels,
+    const Box2i&         dataWindow,
+    DirToPos             dirToPos,
+    const V3f&           d,
+    const V3f&           dx,
+    const V3f&           dy,
+    int                  n,
+    float&               wt)
+{
+    return addSamples<loadPixel> (
+        pixels, dataWindow, dirToPos, d, dx, dy, n, wt);
+}
+
+#    ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+
+//
+// The F16C version is flattened, so that the half to float conversion,
+// which needs the F16C target, is inlined into the sample loop.
+//
+
+__attribute__ ((target ("f16c"), flatten)) __m128
+addSamplesF16c (
+    const Array2D<Rgba>& pixels,
+    const Box2i&         dataWindow,
+    DirToPos             dirToPos,
+    const V3f&           d,
+    const V3f&           dx,
+    const V3f&           dy,
+    int                  n,
+    float&               wt)
+{
+    return addSamples<loadPixelF16c> (
+        pixels, dataWindow, dirToPos, d, dx, dy, n, wt);
+}
+
+#    endif
+
+//
+// F16C is selected at run time, if the CPU supports it.
+//
+
+typedef __m128 (*AddSamples) (
+    const Array2D<Rgba>&,
+    const Box2i&,
+    DirToPos,
+    const V3f&,
+    const V3f&,
+    const V3f&,
+    int,
+    float&);
+
+AddSamples
+chooseAddSamples ()
+{
+#    ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+    if (CpuId ().f16c) return addSamplesF16c;
+#    endif
+
+    return addSamplesSse2;
+}
+
+#endif
+
 } // namespace
 
 Rgba
@@ -154,6 +359,20 @@ EnvmapImage::filteredLookup (V3f d, float r, int n) const
 
     float wt = 0;
 
+#ifdef ENVMAP_HAVE_SSE2
+
+    static const AddSamples addSamplesImpl = chooseAddSamples ();
+
+    __m128 cs =
+        addSamplesImpl (_pixels, _dataWindow, dirToPos, d, dx, dy, n, wt);
+
+    float cv[4];
+    _mm_storeu_ps (cv, _mm_mul_ps (cs, _mm_set1_ps (1 / wt)));
+
+    return Rgba (cv[0], cv[1], cv[2], cv[3]);
+
+#else
+
     float cr = 0;
     float cg = 0;
     float cb = 0;
@@ -193,6 +412,8 @@ EnvmapImage::filteredLookup (V3f d, float r, int n) const
     c.a = ca * wt;
 
     return c;
+
+#endif
 }
 
 Rgba
@@ -14,15 +14,52 @@
 #include "namespaceAlias.h"
 
 #include "Iex.h"
+#include "IlmThreadPool.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <resizeImage.h>
 #include <string.h>
+#include <vector>
+
+#if defined __SSE2__ || (_MSC_VER && (_M_IX86 || _M_X64))
+#    define BLUR_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
 
 using namespace IMF;
 using namespace std;
 using namespace IMATH;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+namespace
+{
+
+//
+// Default size of the cube faces of the proxy image for brute-force
+// blurring, and of the output image.
+//
+
+const int MAX_IN_WIDTH = 40;
+const int OUT_WIDTH    = 100;
+
+//
+// Default number of proxy image pixels per standard deviation of the
+// glossy blur kernel.  The proxy and the output image grow with the
+// exponent of the kernel, so that narrow kernels are not sampled too
+// coarsely.
+//
+
+const double PIXELS_PER_KERNEL_WIDTH = 4;
+
+//
+// Number of pixels that a task should process
+//
+
+const int pixelsPerTask = 4096;
 
 inline int
 toInt (float x)
@@ -30,22 +67,398 @@ toInt (float x)
     return int (x + 0.5f);
 }
 
-inline double
-sqr (double x)
+struct EnvmapPixel
+{
+    V3f    dir;    // normalized direction from the center of the map
+    double weight; // proportional to the solid angle of the pixel
+    double length; // length of the unnormalized direction (cube faces)
+    int    x;      // location in the image's pixel array
+    int    y;
+};
+
+int
+numRows (const EnvmapImage& image)
+{
+    //
+    // The pixels of an environment map image are processed in rows.
+    // For cube-face maps the rows of the six faces are enumerated
+    // one face after the other; for latitude-longitude maps the rows
+    // are the scan lines of the image.
+    //
+
+    const Box2i& dw = image.dataWindow ();
+
+    if (image.type () == ENVMAP_CUBE) return CubeMap::sizeOfFace (dw) * 6;
+
+    return dw.max.y - dw.min.y + 1;
+}
+
+void
+rowPixels (const EnvmapImage& image, int r, vector<EnvmapPixel>& pixels)
+{
+    //
+    // Compute the directions, the solid angle weights and the
+    // locations of the pixels in row r of an environment map.
+    //
+
+    const Box2i& dw = image.dataWindow ();
+
+    pixels.clear ();
+
+    if (image.type () == ENVMAP_CUBE)
+    {
+        int         sof   = CubeMap::sizeOfFace (dw);
+        CubeMapFace face  = CubeMapFace (r / sof);
+        int         y     = r % sof;
+        bool        yEdge = (y == 0 || y == sof - 1);
+
+        for (int x = 0; x < sof; ++x)
+        {
+            bool xEdge = (x == 0 || x == sof - 1);
+
+            V2f posInFace (x, y);
+            V3f dir = CubeMap::direction (face, dw, posInFace);
+            V2f pos = CubeMap::pixelPosition (face, dw, posInFace);
+
+            //
+            // The solid angle subtended by pixel (x,y), as seen from
+            // the center of the cube, is proportional to the cosine of
+            // the angle between the viewing direction and the normal of
+            // the cube face, and inversely proportional to the square of
+            // the distance of the pixel from the center of the cube.
+            // With dir, the unnormalized direction to the pixel, both
+            // factors are expressed in terms of dir.length().
+            //
+
+            double len    = dir.length ();
+            double weight = 1 / (len * len * len);
+
+            //
+            // Pixels at the edges and corners of the
+            // cube are duplicated; we must adjust the
+            // pixel weights accordingly.
+            //
+
+            if (xEdge && yEdge)
+                weight /= 3;
+            else if (xEdge || yEdge)
+                weight /= 2;
+
+            EnvmapPixel p;
+            p.dir    = dir / len;
+            p.weight = weight;
+            p.length = len;
+            p.x      = toInt (pos.x) - dw.min.x;
+            p.y      = toInt (pos.y) - dw.min.y;
+
+            pixels.push_back (p);
+        }
+    }
+    else
+    {
+        //
+        // All pixels in a scan line of a latitude-longitude map have
+        // the same solid angle; it is proportional to the area of the
+        // band of the sphere between the latitudes halfway to the
+        // neighboring scan lines.  The first and the last pixel in
+        // each scan line coincide; each of them gets half the weight.
+        //
+
+        int w = dw.max.x - dw.min.x + 1;
+        int h = dw.max.y - dw.min.y + 1;
+
+        double dLat = (h > 1) ? M_PI / (h - 1) : M_PI;
+        double lat  = (h > 1) ? M_PI / 2 - r * dLat : 0;
+        double lo   = max (lat - dLat / 2, -M_PI / 2);
+        double hi   = min (lat + dLat / 2, M_PI / 2);
+
+        double rowWeight = (sin (hi) - sin (lo)) / max (w - 1, 1);
+
+        for (int x = 0; x < w; ++x)
+        {
+            bool xEdge = (w > 1 && (x == 0 || x == w - 1));
+
+            V2f pos (dw.min.x + x, dw.min.y + r);
+
+            EnvmapPixel p;
+            p.dir    = LatLongMap::direction (dw, pos);
+            p.weight = xEdge ? rowWeight / 2 : rowWeight;
+            p.length = 1;
+            p.x      = x;
+            p.y      = r;
+
+            pixels.push_back (p);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//
+// Brute-force convolution
+//
+//-----------------------------------------------------------------------------
+
+struct Samples
 {
-    return x * x;
+    //
+    // The pixels of the input image for the brute-force convolution.
+    // The directions, solid angles and colors are stored in separate
+    // arrays so that the inner loop can process several pixels at a
+    // time.  The colors are premultiplied by the solid angles.  The
+    // arrays are padded with zero-weight pixels to a multiple of four.
+    //
+
+    vector<float> x, y, z, w;
+    vector<float> r, g, b, a;
+};
+
+double
+originalWeight (const EnvmapPixel& p)
+{
+    //
+    // The pixel weight of earlier versions of exrenvmap -b: the
+    // duplicated edge pixels are weighted like in rowPixels(), but
+    // the weight grows with the distance of the pixel from the
+    // center of the cube, instead of being proportional to the
+    // pixel's solid angle.
+    //
+
+    return p.weight * p.length * p.length * p.length * p.length;
 }
 
 void
-blurImage (EnvmapImage& image1, bool verbose)
+gatherSamples (const EnvmapImage& image, bool original, Samples& s)
+{
+    //
+    // If original is true, the samples of a cube-face map reproduce
+    // the weighting of earlier versions of exrenvmap -b.  Those
+    // multiplied each pixel by originalWeight(), scaled such that
+    // the weights averaged to 1, and convolved the result with the
+    // kernel dot (d1, d2), where d1 and d2 are unnormalized
+    // directions.  The average of the kernel values alone was
+    // used as the normalization factor.
+    //
+
+    const Array2D<Rgba>& pixels = image.pixels ();
+    vector<EnvmapPixel>  row;
+
+    original = original && image.type () == ENVMAP_CUBE;
+
+    double averageWeight = 1;
+
+    if (original)
+    {
+        double total = 0;
+        size_t count = 0;
+
+        for (int r = 0; r < numRows (image); ++r)
+        {
+            rowPixels (image, r, row);
+
+            for (size_t i = 0; i < row.size (); ++i)
+                total += originalWeight (row[i]);
+
+            count += row.size ();
+        }
+
+        averageWeight = total / max (count, size_t (1));
+    }
+
+    for (int r = 0; r < numRows (image); ++r)
+    {
+        rowPixels (image, r, row);
+
+        for (size_t i = 0; i < row.size (); ++i)
+        {
+            const EnvmapPixel& p     = row[i];
+            const Rgba&        pixel = pixels[p.y][p.x];
+
+            double w = p.weight;
+            double c = p.weight;
+
+            if (original)
+            {
+                w = p.length * averageWeight;
+                c = p.length * originalWeight (p);
+            }
+
+            s.x.push_back (p.dir.x);
+            s.y.push_back (p.dir.y);
+            s.z.push_back (p.dir.z);
+            s.w.push_back (w);
+            s.r.push_back (pixel.r * c);
+            s.g.push_back (pixel.g * c);
+            s.b.push_back (pixel.b * c);
+            s.a.push_back (pixel.a * c);
+        }
+    }
+
+    while (s.x.size () % 4)
+    {
+        s.x.push_back (0);
+        s.y.push_back (0);
+        s.z.push_back (0);
+        s.w.push_back (0);
+        s.r.push_back (0);
+        s.g.push_back (0);
+        s.b.push_back (0);
+        s.a.push_back (0);
+    }
+}
+
+Rgba
+convolve (const Samples& s, const V3f& dir, int exponent)
 {
     //
-    // Ideally we would blur the input image directly by convolving
-    // it with a 180-degree wide blur kernel.  Unfortunately this
-    // is prohibitively expensive when the input image is large.
-    // In order to keep running times reasonable, we perform the
-    // blur on a small proxy image that will later be re-sampled
-    // to the desired output resolution.
+    // Compute the weighted average of all input pixels, where the
+    // weight of an input pixel in direction d1 is proportional to
+    // the pixel's solid angle, times pow (max (0, d1.dot(dir)), e).
+    //
+
+    size_t n = s.x.size ();
+    float  total[5];
+
+#ifdef BLUR_HAVE_SSE2
+
+    const __m128 zero = _mm_setzero_ps ();
+    const __m128 one  = _mm_set1_ps (1.0f);
+    const __m128 dx   = _mm_set1_ps (dir.x);
+    const __m128 dy   = _mm_set1_ps (dir.y);
+    const __m128 dz   = _mm_set1_ps (dir.z);
+
+    __m128 tw = zero;
+    __m128 tr = zero;
+    __m128 tg = zero;
+    __m128 tb = zero;
+    __m128 ta = zero;
+
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128 c = _mm_add_ps (
+            _mm_add_ps (
+                _mm_mul_ps (dx, _mm_loadu_ps (&s.x[i])),
+                _mm_mul_ps (dy, _mm_loadu_ps (&s.y[i]))),
+            _mm_mul_ps (dz, _mm_loadu_ps (&s.z[i])));
+
+        c = _mm_max_ps (c, zero);
+
+        __m128 k = one;
+
+        for (int e = exponent; e; e >>= 1)
+        {
+            if (e & 1) k = _mm_mul_ps (k, c);
+
+            c = _mm_mul_ps (c, c);
+        }
+
+        tw = _mm_add_ps (tw, _mm_mul_ps (k, _mm_loadu_ps (&s.w[i])));
+        tr = _mm_add_ps (tr, _mm_mul_ps (k, _mm_loadu_ps (&s.r[i])));
+        tg = _mm_add_ps (tg, _mm_mul_ps (k, _mm_loadu_ps (&s.g[i])));
+        tb = _mm_add_ps (tb, _mm_mul_ps (k, _mm_loadu_ps (&s.b[i])));
+        ta = _mm_add_ps (ta, _mm_mul_ps (k, _mm_loadu_ps (&s.a[i])));
+    }
+
+    const __m128 t[5] = {tw, tr, tg, tb, ta};
+
+    for (int j = 0; j < 5; ++j)
+    {
+        float lanes[4];
+        _mm_storeu_ps (lanes, t[j]);
+        total[j] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+#else
+
+    for (int j = 0; j < 5; ++j)
+        total[j] = 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        float c = max (0.0f, dir.x * s.x[i] + dir.y * s.y[i] + dir.z * s.z[i]);
+        float k = 1;
+
+        for (int e = exponent; e; e >>= 1)
+        {
+            if (e & 1) k *= c;
+
+            c *= c;
+        }
+
+        total[0] += k * s.w[i];
+        total[1] += k * s.r[i];
+        total[2] += k * s.g[i];
+        total[3] += k * s.b[i];
+        total[4] += k * s.a[i];
+    }
+
+#endif
+
+    Rgba pixel (0, 0, 0, 0);
+
+    if (total[0] > 0)
+    {
+        pixel.r = total[1] / total[0];
+        pixel.g = total[2] / total[0];
+        pixel.b = total[3] / total[0];
+        pixel.a = total[4] / total[0];
+    }
+
+    return pixel;
+}
+
+class ConvolveTask : public Task
+{
+public:
+    ConvolveTask (
+        TaskGroup*     group,
+        const Samples& samples,
+        int            exponent,
+        EnvmapImage&   image,
+        int            r1,
+        int            r2)
+        : Task (group)
+        , _samples (samples)
+        , _exponent (exponent)
+        , _image (image)
+        , _r1 (r1)
+        , _r2 (r2)
+    {}
+
+    void execute () override
+    {
+        Array2D<Rgba>&      pixels = _image.pixels ();
+        vector<EnvmapPixel> row;
+
+        for (int r = _r1; r < _r2; ++r)
+        {
+            rowPixels (_image, r, row);
+
+            for (size_t i = 0; i < row.size (); ++i)
+            {
+                pixels[row[i].y][row[i].x] =
+                    convolve (_samples, row[i].dir, _exponent);
+            }
+        }
+    }
+
+private:
+    const Samples& _samples;
+    int            _exponent;
+    EnvmapImage&   _image;
+    int            _r1;
+    int            _r2;
+};
+
+void
+bruteForceBlur (
+    const EnvmapImage& image1,
+    EnvmapImage&       image2,
+    int                exponent,
+    bool               originalWeights,
+    int                inWidth,
+    int                outWidth,
+    bool               verbose)
+{
     //
     // Here's how it works:
     //
@@ -54,47 +467,38 @@ blurImage (EnvmapImage& image1, bool verbose)
     //
     // * Repeatedly resample the image, each time shrinking
     //   it to no less than half its current size, until the
-    //   width of each cube face is MAX_IN_WIDTH pixels.
-    //
-    // * Multiply each pixel by a weight that is proportional
-    //   to the solid angle subtended by the pixel as seen
-    //   from the center of the environment cube.
+    //   width of each cube face is at most inWidth pixels.
     //
     // * Create an output image in cube-face format.
-    //   The cube faces of the output image are OUT_WIDTH
+    //   The cube faces of the output image are outWidth
     //   pixels wide.
     //
     // * For each pixel of the output image:
     //
-    //       Set the output pixel's color to black
-    //
     //       Determine the direction, d2, from the center of the
     //       output environment cube to the center of the output
-    //	     pixel.
+    //       pixel.
     //
-    //       For each pixel of the input image:
+    //       For each pixel of the input image, determine the
+    //       direction, d1, from the center of the input environment
+    //       cube to the center of the input pixel, and the solid
+    //       angle, s, subtended by the input pixel.
     //
-    //           Determine the direction, d1, from the center of
-    //           the input environment cube to the center of the
-    //           input pixel.
+    //       Set the output pixel's color to the average of the
+    //       input pixels' colors, weighted by
+    //       s * pow (max (0, d1.dot(d2)), exponent).
     //
-    //           Multiply the input pixel's color by max (0, d1.dot(d2))
-    //           and add the result to the output pixel.
+    // The output pixels are divided into tasks that run in
+    // the global thread pool.
     //
 
-    const int MAX_IN_WIDTH = 40;
-    const int OUT_WIDTH    = 100;
-
-    if (verbose) cout << "blurring map image" << endl;
-
-    EnvmapImage  image2;
-    EnvmapImage* iptr1 = &image1;
-    EnvmapImage* iptr2 = &image2;
+    EnvmapImage        proxy1;
+    EnvmapImage        proxy2;
+    const EnvmapImage* iptr = &image1;
 
     int w = image1.dataWindow ().max.x - image1.dataWindow ().min.x + 1;
-    int h = w * 6;
 
-    if (iptr1->type () == ENVMAP_LATLONG)
+    if (image1.type () == ENVMAP_LATLONG)
     {
         //
         // Convert the input image from latitude-longitude
@@ -104,26 +508,23 @@ blurImage (EnvmapImage& image1, bool verbose)
         if (verbose) cout << "    converting to cube-face format" << endl;
 
         w /= 4;
-        h = w * 6;
 
-        Box2i dw (V2i (0, 0), V2i (w - 1, h - 1));
-        resizeCube (*iptr1, *iptr2, dw, 1, 7);
+        Box2i dw (V2i (0, 0), V2i (w - 1, w * 6 - 1));
+        resizeCube (*iptr, proxy1, dw, 1, 7);
 
-        swap (iptr1, iptr2);
+        iptr = &proxy1;
     }
 
-    while (w > MAX_IN_WIDTH)
+    while (w > inWidth)
     {
         //
         // Shrink the image.
         //
 
-        if (w >= MAX_IN_WIDTH * 2)
+        if (w >= inWidth * 2)
             w /= 2;
         else
-            w = MAX_IN_WIDTH;
-
-        h = w * 6;
+            w = inWidth;
 
         if (verbose)
         {
@@ -132,254 +533,304 @@ blurImage (EnvmapImage& image1, bool verbose)
                  << w << " by " << w << " pixels" << endl;
         }
 
-        Box2i dw (V2i (0, 0), V2i (w - 1, h - 1));
-        resizeCube (*iptr1, *iptr2, dw, 1, 7);
+        EnvmapImage& proxy = (iptr == &proxy1) ? proxy2 : proxy1;
 
-        swap (iptr1, iptr2);
+        Box2i dw (V2i (0, 0), V2i (w - 1, w * 6 - 1));
+        resizeCube (*iptr, proxy, dw, 1, 7);
+
+        iptr = &proxy;
     }
 
     if (verbose) cout << "    computing pixel weights" << endl;
 
-    {
-        //
-        // Multiply each pixel by a weight that is proportional
-        // to the solid angle subtended by the pixel.
-        //
+    Samples samples;
+    gatherSamples (*iptr, originalWeights, samples);
 
-        Box2i dw  = iptr1->dataWindow ();
-        int   sof = CubeMap::sizeOfFace (dw);
+    if (verbose) cout << "    generating blurred image" << endl;
 
-        Array2D<Rgba>& pixels = iptr1->pixels ();
+    Box2i dw2 (V2i (0, 0), V2i (outWidth - 1, outWidth * 6 - 1));
+    image2.resize (ENVMAP_CUBE, dw2);
 
-        double weightTotal = 0;
+    int rows        = numRows (image2);
+    int rowsPerTask = max (1, pixelsPerTask / outWidth);
 
-        for (int f = CUBEFACE_POS_X; f <= CUBEFACE_NEG_Z; ++f)
-        {
-            if (verbose) cout << "        face " << f << endl;
+    TaskGroup taskGroup;
 
-            CubeMapFace face = CubeMapFace (f);
-            V3f         faceDir (0, 0, 0);
-            int         ix = 0, iy = 0, iz = 0;
+    for (int r = 0; r < rows; r += rowsPerTask)
+    {
+        ThreadPool::addGlobalTask (new ConvolveTask (
+            &taskGroup,
+            samples,
+            exponent,
+            image2,
+            r,
+            min (r + rowsPerTask, rows)));
+    }
+}
 
-            switch (face)
-            {
-                case CUBEFACE_POS_X:
-                    faceDir = V3f (1, 0, 0);
-                    ix      = 0;
-                    iy      = 1;
-                    iz      = 2;
-                    break;
-
-                case CUBEFACE_NEG_X:
-                    faceDir = V3f (-1, 0, 0);
-                    ix      = 0;
-                    iy      = 1;
-                    iz      = 2;
-                    break;
-
-                case CUBEFACE_POS_Y:
-                    faceDir = V3f (0, 1, 0);
-                    ix      = 1;
-                    iy      = 0;
-                    iz      = 2;
-                    break;
-
-                case CUBEFACE_NEG_Y:
-                    faceDir = V3f (0, -1, 0);
-                    ix      = 1;
-                    iy      = 0;
-                    iz      = 2;
-                    break;
-
-                case CUBEFACE_POS_Z:
-                    faceDir = V3f (0, 0, 1);
-                    ix      = 2;
-                    iy      = 0;
-                    iz      = 1;
-                    break;
-
-                case CUBEFACE_NEG_Z:
-                    faceDir = V3f (0, 0, -1);
-                    ix      = 2;
-                    iy      = 0;
-                    iz      = 1;
-                    break;
-            }
+//-----------------------------------------------------------------------------
+//
+// Spherical harmonics projection
+//
+//-----------------------------------------------------------------------------
 
-            for (int y = 0; y < sof; ++y)
-            {
-                bool yEdge = (y == 0 || y == sof - 1);
+const int NUM_SH = 9;
 
-                for (int x = 0; x < sof; ++x)
-                {
-                    bool xEdge = (x == 0 || x == sof - 1);
+void
+shBasis (const V3f& d, double y[NUM_SH])
+{
+    //
+    // Real spherical harmonics for bands 0, 1 and 2
+    //
 
-                    V2f posInFace (x, y);
+    y[0] = 0.282095;
+    y[1] = 0.488603 * d.y;
+    y[2] = 0.488603 * d.z;
+    y[3] = 0.488603 * d.x;
+    y[4] = 1.092548 * d.x * d.y;
+    y[5] = 1.092548 * d.y * d.z;
+    y[6] = 0.315392 * (3 * d.z * d.z - 1);
+    y[7] = 1.092548 * d.x * d.z;
+    y[8] = 0.546274 * (d.x * d.x - d.y * d.y);
+}
 
-                    V3f dir =
-                        CubeMap::direction (face, dw, posInFace).normalized ();
+struct ShSums
+{
+    double weight;
+    double c[NUM_SH][4];
 
-                    V2f pos = CubeMap::pixelPosition (face, dw, posInFace);
+    ShSums () : weight (0) { memset (c, 0, sizeof (c)); }
+};
 
-                    //
-                    // The solid angle subtended by pixel (x,y), as seen
-                    // from the center of the cube, is proportional to the
-                    // square of the distance of the pixel from the center
-                    // of the cube and proportional to the dot product of
-                    // the viewing direction and the normal of the cube
-                    // face that contains the pixel.
-                    //
+class ProjectTask : public Task
+{
+public:
+    ProjectTask (
+        TaskGroup*         group,
+        const EnvmapImage& image,
+        int                r1,
+        int                r2,
+        ShSums&            sums)
+        : Task (group), _image (image), _r1 (r1), _r2 (r2), _sums (sums)
+    {}
+
+    void execute () override
+    {
+        const Array2D<Rgba>& pixels = _image.pixels ();
+        vector<EnvmapPixel>  row;
 
-                    double weight =
-                        (dir ^ faceDir) *
-                        (sqr (dir[iy] / dir[ix]) + sqr (dir[iz] / dir[ix]) + 1);
+        for (int r = _r1; r < _r2; ++r)
+        {
+            rowPixels (_image, r, row);
 
-                    //
-                    // Pixels at the edges and corners of the
-                    // cube are duplicated; we must adjust the
-                    // pixel weights accordingly.
-                    //
+            for (size_t i = 0; i < row.size (); ++i)
+            {
+                const EnvmapPixel& p     = row[i];
+                const Rgba&        pixel = pixels[p.y][p.x];
 
-                    if (xEdge && yEdge)
-                        weight /= 3;
-                    else if (xEdge || yEdge)
-                        weight /= 2;
+                double y[NUM_SH];
+                shBasis (p.dir, y);
 
-                    Rgba& pixel = pixels[toInt (pos.y)][toInt (pos.x)];
+                double rgba[4] = {
+                    pixel.r * p.weight,
+                    pixel.g * p.weight,
+                    pixel.b * p.weight,
+                    pixel.a * p.weight};
 
-                    pixel.r *= weight;
-                    pixel.g *= weight;
-                    pixel.b *= weight;
-                    pixel.a *= weight;
+                for (int j = 0; j < NUM_SH; ++j)
+                    for (int k = 0; k < 4; ++k)
+                        _sums.c[j][k] += y[j] * rgba[k];
 
-                    weightTotal += weight;
-                }
+                _sums.weight += p.weight;
             }
         }
+    }
 
-        //
-        // The weighting operation above has made the overall image darker.
-        // Apply a correction to recover the image's original brightness.
-        //
+private:
+    const EnvmapImage& _image;
+    int                _r1;
+    int                _r2;
+    ShSums&            _sums;
+};
+
+void
+shBlur (
+    const EnvmapImage& image1, EnvmapImage& image2, int outWidth, bool verbose)
+{
+    //
+    // The blurred image is the irradiance, E(N), due to the input
+    // image, divided by pi.  E(N) is computed as described in
+    // Ramamoorthi and Hanrahan, "An Efficient Representation for
+    // Irradiance Environment Maps", SIGGRAPH 2001:
+    //
+    // * Project the input image onto the first nine spherical
+    //   harmonics, Y[j].  Every pixel of the input image
+    //   contributes to the projection, weighted by its solid angle.
+    //
+    // * Convolution with the cosine kernel scales the coefficients
+    //   for band l by A[l], with A = {pi, 2*pi/3, pi/4}.
+    //
+    // * For each pixel of the output image, evaluate the sum of the
+    //   scaled coefficients times Y[j](N).
+    //
+    // The projection is divided into tasks that run in the global
+    // thread pool; each task accumulates its own partial sums.
+    //
 
-        int    w         = dw.max.x - dw.min.x + 1;
-        int    h         = dw.max.y - dw.min.y + 1;
-        size_t numPixels = w * h;
-        double weight    = numPixels / weightTotal;
+    if (verbose) cout << "    projecting onto spherical harmonics" << endl;
 
-        Rgba* p   = &pixels[0][0];
-        Rgba* end = p + numPixels;
+    int rows   = numRows (image1);
+    int length = image1.dataWindow ().max.x - image1.dataWindow ().min.x + 1;
 
-        while (p < end)
-        {
-            p->r *= weight;
-            p->g *= weight;
-            p->b *= weight;
-            p->a *= weight;
+    if (image1.type () == ENVMAP_CUBE)
+        length = CubeMap::sizeOfFace (image1.dataWindow ());
 
-            ++p;
+    int rowsPerTask = max (1, pixelsPerTask / length);
+
+    vector<ShSums> sums ((rows + rowsPerTask - 1) / rowsPerTask);
+
+    {
+        TaskGroup taskGroup;
+
+        for (int r = 0, i = 0; r < rows; r += rowsPerTask, ++i)
+        {
+            ThreadPool::addGlobalTask (new ProjectTask (
+                &taskGroup,
+                image1,
+                r,
+                min (r + rowsPerTask, rows),
+                sums[i]));
         }
     }
 
+    ShSums total;
+
+    for (size_t i = 0; i < sums.size (); ++i)
     {
-        if (verbose) cout << "    generating blurred image" << endl;
+        total.weight += sums[i].weight;
 
-        Box2i dw1  = iptr1->dataWindow ();
-        int   sof1 = CubeMap::sizeOfFace (dw1);
+        for (int j = 0; j < NUM_SH; ++j)
+            for (int k = 0; k < 4; ++k)
+                total.c[j][k] += sums[i].c[j][k];
+    }
 
-        Box2i dw2 (V2i (0, 0), V2i (OUT_WIDTH - 1, OUT_WIDTH * 6 - 1));
-        int   sof2 = CubeMap::sizeOfFace (dw2);
+    //
+    // The solid angle weights are only proportional to the solid
+    // angles; scale them such that they add up to 4*pi.  Fold the
+    // kernel coefficients A[l] and the division by pi into the
+    // spherical harmonics coefficients.
+    //
+
+    const double a[NUM_SH] = {
+        1, 2. / 3, 2. / 3, 2. / 3, .25, .25, .25, .25, .25};
+
+    double scale = (total.weight > 0) ? 4 * M_PI / total.weight : 0;
+
+    for (int j = 0; j < NUM_SH; ++j)
+        for (int k = 0; k < 4; ++k)
+            total.c[j][k] *= a[j] * scale;
+
+    if (verbose) cout << "    generating blurred image" << endl;
+
+    Box2i dw2 (V2i (0, 0), V2i (outWidth - 1, outWidth * 6 - 1));
+    image2.resize (ENVMAP_CUBE, dw2);
 
-        iptr2->resize (ENVMAP_CUBE, dw2);
-        iptr2->clear ();
+    Array2D<Rgba>&      pixels = image2.pixels ();
+    vector<EnvmapPixel> row;
 
-        Array2D<Rgba>& pixels1 = iptr1->pixels ();
-        Array2D<Rgba>& pixels2 = iptr2->pixels ();
+    for (int r = 0; r < numRows (image2); ++r)
+    {
+        rowPixels (image2, r, row);
 
-        for (int f2 = CUBEFACE_POS_X; f2 <= CUBEFACE_NEG_Z; ++f2)
+        for (size_t i = 0; i < row.size (); ++i)
         {
-            if (verbose) cout << "        face " << f2 << endl;
+            double y[NUM_SH];
+            shBasis (row[i].dir, y);
 
-            CubeMapFace face2 = CubeMapFace (f2);
+            double rgba[4] = {0, 0, 0, 0};
 
-            for (int y2 = 0; y2 < sof2; ++y2)
-            {
-                for (int x2 = 0; x2 < sof2; ++x2)
-                {
-                    V2f posInFace2 (x2, y2);
+            for (int j = 0; j < NUM_SH; ++j)
+                for (int k = 0; k < 4; ++k)
+                    rgba[k] += total.c[j][k] * y[j];
 
-                    V3f dir2 = CubeMap::direction (face2, dw2, posInFace2);
+            Rgba& pixel = pixels[row[i].y][row[i].x];
 
-                    V2f pos2 = CubeMap::pixelPosition (face2, dw2, posInFace2);
+            pixel.r = rgba[0];
+            pixel.g = rgba[1];
+            pixel.b = rgba[2];
+            pixel.a = rgba[3];
+        }
+    }
+}
 
-                    double weightTotal = 0;
-                    double rTotal      = 0;
-                    double gTotal      = 0;
-                    double bTotal      = 0;
-                    double aTotal      = 0;
+} // namespace
 
-                    Rgba& pixel2 = pixels2[toInt (pos2.y)][toInt (pos2.x)];
+void
+blurImage (
+    EnvmapImage& image1,
+    BlurMethod   method,
+    int          exponent,
+    int          inWidth,
+    int          outWidth,
+    bool         verbose)
+{
+    if (verbose) cout << "blurring map image" << endl;
 
-                    for (int f1 = CUBEFACE_POS_X; f1 <= CUBEFACE_NEG_Z; ++f1)
-                    {
-                        CubeMapFace face1 = CubeMapFace (f1);
+    if (inWidth < 0 || outWidth < 0)
+        throw IEX_NAMESPACE::ArgExc ("Invalid blurred image size.");
 
-                        for (int y1 = 0; y1 < sof1; ++y1)
-                        {
-                            for (int x1 = 0; x1 < sof1; ++x1)
-                            {
-                                V2f posInFace1 (x1, y1);
+    if (method == BLUR_GLOSSY && exponent < 1)
+        throw IEX_NAMESPACE::ArgExc ("Invalid glossy blur exponent.");
 
-                                V3f dir1 =
-                                    CubeMap::direction (face1, dw1, posInFace1);
+    //
+    // The standard deviation of the kernel pow (cos (a), e) is about
+    // 1 / sqrt (e) radians.  Near the center of a cube face that is
+    // w pixels wide, a pixel subtends pi / (2 * w) radians.
+    //
 
-                                V2f pos1 = CubeMap::pixelPosition (
-                                    face1, dw1, posInFace1);
+    int kernelWidth = 0;
 
-                                double weight = dir1 ^ dir2;
+    if (method == BLUR_GLOSSY)
+    {
+        kernelWidth = int (ceil (
+            PIXELS_PER_KERNEL_WIDTH * M_PI / 2 * sqrt (double (exponent))));
+    }
 
-                                if (weight <= 0) continue;
+    if (inWidth == 0) inWidth = max (MAX_IN_WIDTH, kernelWidth);
 
-                                Rgba& pixel1 =
-                                    pixels1[toInt (pos1.y)][toInt (pos1.x)];
+    if (outWidth == 0) outWidth = max (OUT_WIDTH, kernelWidth);
 
-                                weightTotal += weight;
-                                rTotal += pixel1.r * weight;
-                                gTotal += pixel1.g * weight;
-                                bTotal += pixel1.b * weight;
-                                aTotal += pixel1.a * weight;
-                            }
-                        }
-                    }
+    EnvmapImage image2;
 
-                    pixel2.r = rTotal / weightTotal;
-                    pixel2.g = gTotal / weightTotal;
-                    pixel2.b = bTotal / weightTotal;
-                    pixel2.a = aTotal / weightTotal;
-                }
-            }
-        }
+    switch (method)
+    {
+        case BLUR_DIFFUSE:
+
+            bruteForceBlur (
+                image1, image2, 1, true, inWidth, outWidth, verbose);
+            break;
+
+        case BLUR_DIFFUSE_SH: shBlur (image1, image2, outWidth, verbose); break;
 
-        swap (iptr1, iptr2);
+        case BLUR_GLOSSY:
+
+            bruteForceBlur (
+                image1, image2, exponent, false, inWidth, outWidth, verbose);
+            break;
     }
 
     //
-    // Depending on how many times we've re-sampled the image,
-    // the result is now either in image1 or in image2.
-    // If necessary, copy the result into image1.
+    // Copy the result into image1.
     //
 
-    if (iptr1 != &image1)
-    {
-        if (verbose) cout << "    copying" << endl;
+    if (verbose) cout << "    copying" << endl;
 
-        Box2i dw = iptr1->dataWindow ();
-        image1.resize (ENVMAP_CUBE, dw);
+    Box2i dw = image2.dataWindow ();
+    image1.resize (ENVMAP_CUBE, dw);
 
-        int    w    = dw.max.x - dw.min.x + 1;
-        int    h    = dw.max.y - dw.min.y + 1;
-        size_t size = w * h * sizeof (Rgba);
+    int    w    = dw.max.x - dw.min.x + 1;
+    int    h    = dw.max.y - dw.min.y + 1;
+    size_t size = w * h * sizeof (Rgba);
 
-        memcpy (&image1.pixels ()[0][0], &iptr1->pixels ()[0][0], size);
-    }
+    memcpy (&image1.pixels ()[0][0], &image2.pixels ()[0][0], size);
 }
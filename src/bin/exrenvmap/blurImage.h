@@ -16,10 +16,60 @@
 //	a white diffuse reflector with surface normal N would have if it
 //	was illuminated using the original non-blurred image.
 //
+//	The blur method can be one of the following:
+//
+//	BLUR_DIFFUSE	The image is convolved with the cosine kernel,
+//			max (0, dot (N, L)), by brute force.  In order to
+//			keep running times reasonable, the convolution is
+//			performed on a small proxy of the input image.
+//			For compatibility with earlier versions, the
+//			pixels of the proxy are weighted as before, which
+//			slightly favors the corners of the cube faces.
+//
+//	BLUR_DIFFUSE_SH	The full-resolution input image is projected onto
+//			the first nine spherical harmonics (bands 0, 1
+//			and 2), and the blurred image is computed from the
+//			projection.  This is much faster than BLUR_DIFFUSE.
+//			The result usually differs from the exact
+//			convolution by no more than a few percent; the
+//			error is largest near small, very bright light
+//			sources such as the sun.
+//
+//	BLUR_GLOSSY	Like BLUR_DIFFUSE, but the kernel is
+//			pow (max (0, dot (N, L)), e), for a given integer
+//			exponent e.  The result is the color of a glossy
+//			(Phong) reflector rather than a diffuse one.
+//			The pixels are weighted by their solid angles.
+//
+//	The cube faces of the proxy image are at most inWidth pixels
+//	wide, and the cube faces of the blurred image are outWidth
+//	pixels wide.  If inWidth or outWidth is 0, a default is used:
+//	40 and 100 pixels respectively, or, for BLUR_GLOSSY, enough
+//	pixels to resolve the kernel, which narrows as e grows.
+//	Larger sizes are more accurate; the time for the brute-force
+//	convolution grows with the product of the two numbers of
+//	pixels.
+//
+//	The convolution is divided into tasks that run in the
+//	global thread pool.
+//
 //-----------------------------------------------------------------------------
 
 #include <readInputImage.h>
 
-void blurImage (EnvmapImage& image, bool verbose);
+enum BlurMethod
+{
+    BLUR_DIFFUSE,
+    BLUR_DIFFUSE_SH,
+    BLUR_GLOSSY
+};
+
+void blurImage (
+    EnvmapImage& image,
+    BlurMethod   method,
+    int          exponent,
+    int          inWidth,
+    int          outWidth,
+    bool         verbose);
 
 #endif
@@ -10,8 +10,10 @@
 //-----------------------------------------------------------------------------
 
 #include <EnvmapImage.h>
+#include <IlmThreadPool.h>
 #include <ImfEnvmap.h>
 #include <ImfHeader.h>
+#include <ImfThreading.h>
 #include <blurImage.h>
 #include <makeCubeMap.h>
 #include <makeLatLongMap.h>
@@ -100,6 +102,26 @@ usageMessage (const char argv0[], bool verbose = false)
                 "           the original non-blurred image.\n"
                 "           Generating the blurred image can be fairly slow.\n"
                 "\n"
+                "-bsh       like -b, but the blurred image is computed from\n"
+                "           a spherical harmonics approximation of the full-\n"
+                "           resolution input image.  This is much faster\n"
+                "           than -b; the result usually differs from -b by\n"
+                "           no more than a few percent.\n"
+                "\n"
+                "-g e       blurs the environment map image like -b, but\n"
+                "           with a glossy filter kernel, cos(a)^e, where a\n"
+                "           is the angle from the center of the kernel,\n"
+                "           and e is a positive integer.  The result is\n"
+                "           the color of a glossy (Phong) reflector.\n"
+                "\n"
+                "-bw i o    with -b or -g, filters a copy of the input\n"
+                "           image with cube faces that are at most i\n"
+                "           pixels wide, and makes the cube faces of the\n"
+                "           blurred image o pixels wide (-bsh uses only\n"
+                "           o).  Larger sizes are more accurate but\n"
+                "           slower.  The defaults are 40 and 100, and\n"
+                "           grow with e for -g.\n"
+                "\n"
                 "-t x y     sets the output file's tile size to x by y pixels\n"
                 "           (default is 64 by 64)\n"
                 "\n"
@@ -118,6 +140,9 @@ usageMessage (const char argv0[], bool verbose = false)
                 "           (none/rle/zip/piz/pxr24/b44/b44a/dwaa/dwab,\n"
                 "           default is zip)\n"
                 "\n"
+                "-j n       uses n threads to blur and resample the image\n"
+                "           (default is the number of CPU cores)\n"
+                "\n"
                 "-v         verbose mode\n"
                 "\n"
                 "-h         prints this message\n";
@@ -197,7 +222,13 @@ main (int argc, char** argv)
     float             padBottom         = 0;
     float             filterRadius      = 1;
     int               numSamples        = 5;
-    bool              diffuseBlur       = false;
+    bool              blur              = false;
+    BlurMethod        blurMethod        = BLUR_DIFFUSE;
+    int               blurExponent      = 1;
+    int               blurInWidth       = 0;
+    int               blurOutWidth      = 0;
+    int               threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
     bool              verbose           = false;
 
     //
@@ -313,9 +344,61 @@ main (int argc, char** argv)
             // Diffuse blur
             //
 
-            diffuseBlur = true;
+            blur       = true;
+            blurMethod = BLUR_DIFFUSE;
+            i += 1;
+        }
+        else if (!strcmp (argv[i], "-bsh"))
+        {
+            //
+            // Diffuse blur, using spherical harmonics
+            //
+
+            blur       = true;
+            blurMethod = BLUR_DIFFUSE_SH;
             i += 1;
         }
+        else if (!strcmp (argv[i], "-g"))
+        {
+            //
+            // Glossy blur
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            blur         = true;
+            blurMethod   = BLUR_GLOSSY;
+            blurExponent = strtol (argv[i + 1], 0, 0);
+
+            if (blurExponent <= 0)
+            {
+                cerr << "Glossy blur exponent must be greater than zero."
+                     << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-bw"))
+        {
+            //
+            // Set the sizes of the images for brute-force blurring
+            //
+
+            if (i > argc - 3) usageMessage (argv[0]);
+
+            blurInWidth  = strtol (argv[i + 1], 0, 0);
+            blurOutWidth = strtol (argv[i + 2], 0, 0);
+
+            if (blurInWidth <= 0 || blurOutWidth <= 0)
+            {
+                cerr << "Blurred image size must be greater than zero."
+                     << endl;
+                return 1;
+            }
+
+            i += 3;
+        }
         else if (!strcmp (argv[i], "-t"))
         {
             //
@@ -383,6 +466,24 @@ main (int argc, char** argv)
             compression = getCompression (argv[i + 1]);
             i += 2;
         }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            //
+            // Set number of threads
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
         else if (!strcmp (argv[i], "-v"))
         {
             //
@@ -425,6 +526,8 @@ main (int argc, char** argv)
 
     try
     {
+        setGlobalThreadCount (threads);
+
         EnvmapImage  image;
         Header       header;
         RgbaChannels channels;
@@ -439,7 +542,16 @@ main (int argc, char** argv)
             header,
             channels);
 
-        if (diffuseBlur) blurImage (image, verbose);
+        if (blur)
+        {
+            blurImage (
+                image,
+                blurMethod,
+                blurExponent,
+                blurInWidth,
+                blurOutWidth,
+                verbose);
+        }
 
         if (type == ENVMAP_CUBE)
         {
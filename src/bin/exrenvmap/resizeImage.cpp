@@ -14,12 +14,152 @@
 #include <resizeImage.h>
 
 #include "Iex.h"
+#include "IlmThreadPool.h"
+#include <algorithm>
+#include <math.h>
 #include <string.h>
+#include <vector>
 
 #include "namespaceAlias.h"
 using namespace IMF;
 using namespace std;
 using namespace IMATH;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+namespace
+{
+
+//
+// Number of output pixels that a ResizeTask should compute
+//
+
+const int pixelsPerTask = 4096;
+
+class ResizeLatLongTask : public Task
+{
+public:
+    ResizeLatLongTask (
+        TaskGroup*           group,
+        const EnvmapImage&   image1,
+        EnvmapImage&         image2,
+        const vector<float>& sinLon,
+        const vector<float>& cosLon,
+        float                radius,
+        int                  numSamples,
+        int                  y1,
+        int                  y2)
+        : Task (group)
+        , _image1 (image1)
+        , _image2 (image2)
+        , _sinLon (sinLon)
+        , _cosLon (cosLon)
+        , _radius (radius)
+        , _numSamples (numSamples)
+        , _y1 (y1)
+        , _y2 (y2)
+    {}
+
+    void execute () override
+    {
+        const Box2i&   dw     = _image2.dataWindow ();
+        Array2D<Rgba>& pixels = _image2.pixels ();
+        int            w      = dw.max.x - dw.min.x + 1;
+
+        for (int y = _y1; y < _y2; ++y)
+        {
+            //
+            // The direction for pixel (x,y) is computed from the
+            // sine and cosine of the longitude of column x, which
+            // are looked up in a table, and of the latitude of row y.
+            // The result is the same as LatLongMap::direction().
+            //
+
+            float lat    = LatLongMap::latLong (dw, V2f (0, y)).x;
+            float sinLat = sin (lat);
+            float cosLat = cos (lat);
+
+            for (int x = 0; x < w; ++x)
+            {
+                V3f dir (_sinLon[x] * cosLat, sinLat, _cosLon[x] * cosLat);
+
+                pixels[y][x] =
+                    _image1.filteredLookup (dir, _radius, _numSamples);
+            }
+        }
+    }
+
+private:
+    const EnvmapImage&   _image1;
+    EnvmapImage&         _image2;
+    const vector<float>& _sinLon;
+    const vector<float>& _cosLon;
+    float                _radius;
+    int                  _numSamples;
+    int                  _y1;
+    int                  _y2;
+};
+
+class ResizeCubeTask : public Task
+{
+public:
+    ResizeCubeTask (
+        TaskGroup*         group,
+        const EnvmapImage& image1,
+        EnvmapImage&       image2,
+        float              radius,
+        int                numSamples,
+        int                r1,
+        int                r2)
+        : Task (group)
+        , _image1 (image1)
+        , _image2 (image2)
+        , _radius (radius)
+        , _numSamples (numSamples)
+        , _r1 (r1)
+        , _r2 (r2)
+    {}
+
+    void execute () override
+    {
+        //
+        // Rows r1 through r2-1 are enumerated across all six cube
+        // faces: row r is row r % sof of face r / sof.
+        //
+
+        const Box2i&   dw     = _image2.dataWindow ();
+        Array2D<Rgba>& pixels = _image2.pixels ();
+        int            sof    = CubeMap::sizeOfFace (dw);
+
+        for (int r = _r1; r < _r2; ++r)
+        {
+            CubeMapFace face = CubeMapFace (r / sof);
+            int         y    = r % sof;
+
+            for (int x = 0; x < sof; ++x)
+            {
+                V2f posInFace (x, y);
+
+                V3f dir = CubeMap::direction (face, dw, posInFace);
+                V2f pos = CubeMap::pixelPosition (face, dw, posInFace);
+
+                pixels[int (pos.y + 0.5f)][int (pos.x + 0.5f)] =
+                    _image1.filteredLookup (dir, _radius, _numSamples);
+            }
+        }
+    }
+
+private:
+    const EnvmapImage& _image1;
+    EnvmapImage&       _image2;
+    float              _radius;
+    int                _numSamples;
+    int                _r1;
+    int                _r2;
+};
+
+} // namespace
 
 void
 resizeLatLong (
@@ -36,15 +176,40 @@ resizeLatLong (
     image2.resize (ENVMAP_LATLONG, image2DataWindow);
     image2.clear ();
 
-    Array2D<Rgba>& pixels = image2.pixels ();
+    //
+    // Tabulate the sine and cosine of the longitude of each column.
+    //
 
-    for (int y = 0; y < h; ++y)
+    vector<float> sinLon (w);
+    vector<float> cosLon (w);
+
+    for (int x = 0; x < w; ++x)
     {
-        for (int x = 0; x < w; ++x)
-        {
-            V3f dir      = LatLongMap::direction (image2DataWindow, V2f (x, y));
-            pixels[y][x] = image1.filteredLookup (dir, radius, numSamples);
-        }
+        float lon = LatLongMap::latLong (image2DataWindow, V2f (x, 0)).y;
+        sinLon[x] = sin (lon);
+        cosLon[x] = cos (lon);
+    }
+
+    //
+    // Resample the input image, in parallel bands of scan lines.
+    //
+
+    int rowsPerTask = max (1, pixelsPerTask / w);
+
+    TaskGroup taskGroup;
+
+    for (int y = 0; y < h; y += rowsPerTask)
+    {
+        ThreadPool::addGlobalTask (new ResizeLatLongTask (
+            &taskGroup,
+            image1,
+            image2,
+            sinLon,
+            cosLon,
+            radius,
+            numSamples,
+            y,
+            min (y + rowsPerTask, h)));
     }
 }
 
@@ -79,7 +244,7 @@ resizeCube (
     }
 
     //
-    // Resampe the input image
+    // Resample the input image
     //
 
     int   sof    = CubeMap::sizeOfFace (image2DataWindow);
@@ -88,27 +253,24 @@ resizeCube (
     image2.resize (ENVMAP_CUBE, image2DataWindow);
     image2.clear ();
 
-    Array2D<Rgba>& pixels = image2.pixels ();
-
-    for (int f = CUBEFACE_POS_X; f <= CUBEFACE_NEG_Z; ++f)
-    {
-        CubeMapFace face = CubeMapFace (f);
-
-        for (int y = 0; y < sof; ++y)
-        {
-            for (int x = 0; x < sof; ++x)
-            {
-                V2f posInFace (x, y);
+    //
+    // Resample the input image, in parallel bands of rows.
+    //
 
-                V3f dir =
-                    CubeMap::direction (face, image2DataWindow, posInFace);
+    int rows        = sof * 6;
+    int rowsPerTask = max (1, pixelsPerTask / max (sof, 1));
 
-                V2f pos =
-                    CubeMap::pixelPosition (face, image2DataWindow, posInFace);
+    TaskGroup taskGroup;
 
-                pixels[int (pos.y + 0.5f)][int (pos.x + 0.5f)] =
-                    image1.filteredLookup (dir, radius, numSamples);
-            }
-        }
+    for (int r = 0; r < rows; r += rowsPerTask)
+    {
+        ThreadPool::addGlobalTask (new ResizeCubeTask (
+            &taskGroup,
+            image1,
+            image2,
+            radius,
+            numSamples,
+            r,
+            min (r + rowsPerTask, rows)));
     }
 }
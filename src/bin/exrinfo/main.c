@@ -4,6 +4,7 @@
 */
 
 #include <openexr.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -22,7 +23,10 @@ usage (const char* argv0)
 {
     fprintf (
         stderr,
-        "Usage: %s [-v|--verbose] [-a|--all-metadata] [-s|--strict] <filename> [<filename> ...]\n\n",
+        "Usage: %s [-v|--verbose] [-a|--all-metadata] [-s|--strict] [-S|--stats] <filename> [<filename> ...]\n\n"
+        "  -S, --stats   decode the pixels of the flat image parts and print\n"
+        "                how many chunks were read and decoded, and how long\n"
+        "                reading, decompressing and unpacking took\n\n",
         argv0);
 }
 
@@ -73,6 +77,179 @@ stdin_reader (
     return nread;
 }
 
+static exr_result_t
+decode_chunk (
+    exr_context_t           e,
+    int                     part,
+    const exr_chunk_info_t* cinfo,
+    exr_decode_pipeline_t*  decoder,
+    uint8_t**               buf,
+    size_t*                 bufsize)
+{
+    exr_result_t rv;
+    size_t       bytes = 0;
+    uint8_t*     ptr;
+
+    if (decoder->channels == NULL)
+        rv = exr_decoding_initialize (e, part, cinfo, decoder);
+    else
+        rv = exr_decoding_update (e, part, cinfo, decoder);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    for (int c = 0; c < decoder->channel_count; ++c)
+    {
+        const exr_coding_channel_info_t* ch = decoder->channels + c;
+        bytes += (size_t) ch->width * (size_t) ch->height *
+                 (size_t) ch->user_bytes_per_element;
+    }
+
+    if (bytes > *bufsize)
+    {
+        ptr = (uint8_t*) realloc (*buf, bytes);
+        if (!ptr) return EXR_ERR_OUT_OF_MEMORY;
+        *buf     = ptr;
+        *bufsize = bytes;
+    }
+
+    ptr = *buf;
+    for (int c = 0; c < decoder->channel_count; ++c)
+    {
+        exr_coding_channel_info_t* ch = decoder->channels + c;
+        ch->decode_to_ptr             = ptr;
+        ch->user_pixel_stride         = ch->user_bytes_per_element;
+        ch->user_line_stride          = ch->user_pixel_stride * ch->width;
+        ptr += (size_t) ch->width * (size_t) ch->height *
+               (size_t) ch->user_bytes_per_element;
+    }
+
+    rv = exr_decoding_choose_default_routines (e, part, decoder);
+    if (rv == EXR_ERR_SUCCESS) rv = exr_decoding_run (e, part, decoder);
+    return rv;
+}
+
+static exr_result_t
+decode_tiles (
+    exr_context_t          e,
+    int                    part,
+    int                    lx,
+    int                    ly,
+    exr_decode_pipeline_t* decoder,
+    uint8_t**              buf,
+    size_t*                bufsize)
+{
+    exr_result_t     rv;
+    exr_chunk_info_t cinfo;
+    int32_t          levw, levh, tilew, tileh;
+
+    rv = exr_get_level_sizes (e, part, lx, ly, &levw, &levh);
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_get_tile_sizes (e, part, lx, ly, &tilew, &tileh);
+
+    for (int ty = 0; rv == EXR_ERR_SUCCESS && ty * tileh < levh; ++ty)
+    {
+        for (int tx = 0; rv == EXR_ERR_SUCCESS && tx * tilew < levw; ++tx)
+        {
+            rv = exr_read_tile_chunk_info (e, part, tx, ty, lx, ly, &cinfo);
+            if (rv == EXR_ERR_SUCCESS)
+                rv = decode_chunk (e, part, &cinfo, decoder, buf, bufsize);
+        }
+    }
+    return rv;
+}
+
+static exr_result_t
+decode_part (exr_context_t e, int part)
+{
+    exr_result_t          rv;
+    exr_storage_t         storage;
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    uint8_t*              buf     = NULL;
+    size_t                bufsize = 0;
+
+    rv = exr_get_storage (e, part, &storage);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (storage == EXR_STORAGE_SCANLINE)
+    {
+        exr_attr_box2i_t dw;
+        exr_chunk_info_t cinfo;
+        int32_t          lines;
+
+        rv = exr_get_data_window (e, part, &dw);
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_get_scanlines_per_chunk (e, part, &lines);
+
+        for (int64_t y = dw.min.y; rv == EXR_ERR_SUCCESS && y <= dw.max.y;
+             y += lines)
+        {
+            rv = exr_read_scanline_chunk_info (e, part, (int) y, &cinfo);
+            if (rv == EXR_ERR_SUCCESS)
+                rv = decode_chunk (e, part, &cinfo, &decoder, &buf, &bufsize);
+        }
+    }
+    else if (storage == EXR_STORAGE_TILED)
+    {
+        exr_tile_level_mode_t levelmode;
+        exr_tile_round_mode_t roundmode;
+        uint32_t              xsize, ysize;
+        int32_t               levelsx, levelsy;
+
+        rv = exr_get_tile_descriptor (
+            e, part, &xsize, &ysize, &levelmode, &roundmode);
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_get_tile_levels (e, part, &levelsx, &levelsy);
+
+        for (int ly = 0; rv == EXR_ERR_SUCCESS && ly < levelsy; ++ly)
+        {
+            for (int lx = 0; rv == EXR_ERR_SUCCESS && lx < levelsx; ++lx)
+            {
+                if (levelmode == EXR_TILE_MIPMAP_LEVELS && lx != ly) continue;
+                rv = decode_tiles (e, part, lx, ly, &decoder, &buf, &bufsize);
+            }
+        }
+    }
+
+    exr_decoding_destroy (e, &decoder);
+    free (buf);
+    return rv;
+}
+
+static void
+print_stats (const exr_stats_t* s)
+{
+    static const char* compressionnames[] = {
+        "none",
+        "rle",
+        "zips",
+        "zip",
+        "piz",
+        "pxr24",
+        "b44",
+        "b44a",
+        "dwaa",
+        "dwab"};
+
+    printf ("  statistics:\n");
+    printf (
+        "   read: %" PRIu64 " calls, %" PRIu64 " bytes, %.3f ms\n",
+        s->reads,
+        s->bytes_read,
+        (double) s->read_ns * 1e-6);
+    for (int c = 0; c < EXR_COMPRESSION_LAST_TYPE; ++c)
+    {
+        if (s->chunks_decoded[c] == 0) continue;
+        printf (
+            "   decoded: %" PRIu64 " '%s' chunks\n",
+            s->chunks_decoded[c],
+            c < 10 ? compressionnames[c] : "<UNKNOWN>");
+    }
+    printf (
+        "   decompressed: %" PRIu64 " bytes, %.3f ms\n",
+        s->bytes_decompressed,
+        (double) s->decompress_ns * 1e-6);
+    printf ("   unpacked: %.3f ms\n", (double) s->unpack_ns * 1e-6);
+}
+
 static int
 process_stdin (int verbose, int allmeta, int strict)
 {
@@ -102,7 +279,8 @@ process_stdin (int verbose, int allmeta, int strict)
 }
 
 static int
-process_file (const char* filename, int verbose, int allmeta, int strict)
+process_file (
+    const char* filename, int verbose, int allmeta, int strict, int stats)
 {
     int                       failcount = 0;
     exr_result_t              rv;
@@ -114,11 +292,29 @@ process_file (const char* filename, int verbose, int allmeta, int strict)
 
     if (strict) cinit.flags |= EXR_CONTEXT_FLAG_STRICT_HEADER;
 
+    if (stats) cinit.flags |= EXR_CONTEXT_FLAG_COLLECT_STATS;
+
     rv = exr_start_read (&e, filename, &cinit);
 
     if (rv == EXR_ERR_SUCCESS)
     {
         exr_print_context_info (e, verbose || allmeta);
+
+        if (stats)
+        {
+            exr_stats_t s;
+            int         parts = 0;
+
+            exr_get_count (e, &parts);
+            for (int p = 0; rv == EXR_ERR_SUCCESS && p < parts; ++p)
+                rv = decode_part (e, p);
+
+            if (rv != EXR_ERR_SUCCESS) ++failcount;
+
+            exr_get_stats (e, &s);
+            print_stats (&s);
+        }
+
         exr_finish (&e);
     }
     else
@@ -129,7 +325,7 @@ process_file (const char* filename, int verbose, int allmeta, int strict)
 int
 main (int argc, const char* argv[])
 {
-    int rv = 0, nfiles = 0, verbose = 0, allmeta = 0, strict = 0;
+    int rv = 0, nfiles = 0, verbose = 0, allmeta = 0, strict = 0, stats = 0;
 
     for (int a = 1; a < argc; ++a)
     {
@@ -151,6 +347,10 @@ main (int argc, const char* argv[])
         {
             strict = 1;
         }
+        else if (!strcmp (argv[a], "-S") || !strcmp (argv[a], "--stats"))
+        {
+            stats = 1;
+        }
         else if (!strcmp (argv[a], "-"))
         {
             ++nfiles;
@@ -164,7 +364,7 @@ main (int argc, const char* argv[])
         else
         {
             ++nfiles;
-            rv += process_file (argv[a], verbose, allmeta, strict);
+            rv += process_file (argv[a], verbose, allmeta, strict, stats);
         }
     }
 
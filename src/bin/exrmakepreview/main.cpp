@@ -29,8 +29,9 @@ usageMessage (const char argv0[], bool verbose = false)
         cerr << "\n"
                 "Reads an OpenEXR image from infile, generates a preview\n"
                 "image, adds it to the image's header, and saves the result\n"
-                "in outfile.  Infile and outfile must not refer to the same\n"
-                "file (the program cannot edit an image file \"in place\").\n"
+                "in outfile.  If infile and outfile are the same file, and\n"
+                "the file already has a preview image of the same size, only\n"
+                "the header of the file is rewritten.\n"
                 "\n"
                 "Options:\n"
                 "\n"
@@ -126,12 +127,6 @@ main (int argc, char** argv)
 
     if (inFile == 0 || outFile == 0) usageMessage (argv[0]);
 
-    if (!strcmp (inFile, outFile))
-    {
-        cerr << "Input and output cannot be the same file." << endl;
-        return 1;
-    }
-
     if (previewWidth <= 0)
     {
         cerr << "Preview image width must be greater than zero." << endl;
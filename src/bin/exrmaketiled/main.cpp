@@ -12,7 +12,9 @@
 
 #include "makeTiled.h"
 
+#include <IlmThreadPool.h>
 #include <ImfHeader.h>
+#include <ImfThreading.h>
 
 #include <exception>
 #include <iostream>
@@ -71,6 +73,9 @@ usageMessage (const char argv0[], bool verbose = false)
                 "          (none/rle/zip/piz/pxr24/b44/b44a/dwaa/dwab,\n"
                 "          default is zip)\n"
                 "\n"
+                "-j n      uses n threads to read, filter and write the\n"
+                "          image (default is the number of CPU cores)\n"
+                "\n"
                 "-v        verbose mode\n"
                 "\n"
                 "-h        prints this message\n"
@@ -140,18 +145,18 @@ getExtrapolation (const string& str)
 {
     Extrapolation e;
 
-    if (str == "black" || str == "BLACK") { e = BLACK; }
+    if (str == "black" || str == "BLACK") { e = EXTRAPOLATE_BLACK; }
     else if (str == "clamp" || str == "CLAMP")
     {
-        e = CLAMP;
+        e = EXTRAPOLATE_CLAMP;
     }
     else if (str == "periodic" || str == "PERIODIC")
     {
-        e = PERIODIC;
+        e = EXTRAPOLATE_PERIODIC;
     }
     else if (str == "mirror" || str == "MIRROR")
     {
-        e = MIRROR;
+        e = EXTRAPOLATE_MIRROR;
     }
     else
     {
@@ -185,9 +190,11 @@ main (int argc, char** argv)
     int               tileSizeX    = 64;
     int               tileSizeY    = 64;
     set<string>       doNotFilter;
-    Extrapolation     extX    = CLAMP;
-    Extrapolation     extY    = CLAMP;
+    Extrapolation     extX    = EXTRAPOLATE_CLAMP;
+    Extrapolation     extY    = EXTRAPOLATE_CLAMP;
     bool              verbose = false;
+    int               threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
 
     //
     // Parse the command line.
@@ -298,6 +305,24 @@ main (int argc, char** argv)
             compression = getCompression (argv[i + 1]);
             i += 2;
         }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            //
+            // Set number of threads
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
         else if (!strcmp (argv[i], "-v"))
         {
             //
@@ -350,6 +375,8 @@ main (int argc, char** argv)
 
     try
     {
+        setGlobalThreadCount (threads);
+
         //
         // check input
         //
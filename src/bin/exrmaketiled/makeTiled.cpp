@@ -7,18 +7,33 @@
 //
 //	Produce a tiled version of an OpenEXR image.
 //
+//	The image is processed in bands that are one row of tiles high.
+//	The bands of the input image are read one at a time.  Each lower-
+//	resolution level is computed band by band, as soon as the bands
+//	it depends on are available, and every band is written to the
+//	output file right away.  Bands are discarded as soon as no other
+//	level needs them, so only a few bands per level are kept in
+//	memory, independent of the size of the image.
+//
+//	The output file has INCREASING_Y line order, so the tiles of the
+//	lower-resolution levels, which are computed before the full-
+//	resolution level is complete, are buffered in the output file
+//	until they can be stored in order.  The buffered tiles are
+//	compressed, and they are at most the lower-resolution levels of
+//	the image.
+//
 //----------------------------------------------------------------------------
 
 #include "makeTiled.h"
-#include "Image.h"
 
 #include "Iex.h"
-#include "ImathFun.h"
+#include "IlmThreadPool.h"
 #include "ImfChannelList.h"
 #include "ImfDeepScanLineInputPart.h"
 #include "ImfDeepScanLineOutputPart.h"
 #include "ImfDeepTiledInputPart.h"
 #include "ImfDeepTiledOutputPart.h"
+#include "ImfFlatImageLevels.h"
 #include "ImfFrameBuffer.h"
 #include "ImfInputPart.h"
 #include "ImfMisc.h"
@@ -26,445 +41,704 @@
 #include "ImfStandardAttributes.h"
 #include "ImfTiledInputPart.h"
 #include "ImfTiledOutputPart.h"
+#include "half.h"
 
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <map>
+#include <string.h>
 #include <vector>
 
 #include "namespaceAlias.h"
 using namespace IMF;
 using namespace IMATH_NAMESPACE;
 using namespace std;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 
 namespace
 {
 
-string
-extToString (Extrapolation ext)
+template <class T>
+void
+subsampleRowX (const T in[], T out[], int w, int offset)
 {
-    string str;
-
-    switch (ext)
-    {
-        case BLACK: str = "black"; break;
+    //
+    // Resample a row of pixels, skipping every other pixel,
+    // without low-pass filtering.
+    //
 
-        case CLAMP: str = "clamp"; break;
+    for (int x = 0; x < w; ++x)
+        out[x] = in[2 * x + offset];
+}
 
-        case PERIODIC: str = "periodic"; break;
+struct LevelChannel
+{
+    string    name;
+    PixelType type;
+    bool      filter;
+};
 
-        case MIRROR: str = "mirror"; break;
-    }
+enum Reduction
+{
+    READ,
+    REDUCE_X,
+    REDUCE_Y
+};
 
-    return str;
-}
+//
+// A Level holds a band-by-band representation of one resolution level
+// of the output image, or of the intermediate image that is produced
+// while a MIPMAP_LEVELS image is shrunk first horizontally and then
+// vertically.  Bands are one row of tiles high.  The bands of the full-
+// resolution level are read from the input file; the bands of every
+// other level are computed from its parent level, which is one half as
+// wide (REDUCE_X) or one half as high (REDUCE_Y).
+//
+// Each row of pixels in a band has one extra pixel at the end whose
+// value is always zero, so that horizontal filters with BLACK
+// extrapolation can refer to it instead of testing for pixels outside
+// the row.
+//
 
-int
-mirror (int x, int w)
+class Level
 {
-    int d = divp (x, w);
-    int m = modp (x, w);
-    return (d & 1) ? w - 1 - m : m;
-}
+public:
+    Level (
+        const vector<LevelChannel>& channels,
+        const Box2i&                dataWindow,
+        int                         bandHeight,
+        Level*                      parent    = 0,
+        Reduction                   reduction = READ,
+        Extrapolation               ext       = EXTRAPOLATE_CLAMP,
+        bool                        odd       = false);
+
+    Level (const Level& other) = delete;
+    Level& operator= (const Level& other) = delete;
+
+    void readFrom (InputPart* in);
+    void writeTo (TiledOutputPart* out, int lx, int ly);
+
+    bool isStored () const { return _out != 0; }
+    int  lx () const { return _lx; }
+    int ly () const { return _ly; }
 
-template <class T>
-double
-sampleX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
-{
     //
-    // Sample an image channel at location (x, y), where
-    // x is a floating point number, and y is an integer.
+    // Bands are produced in order, by calling advance() repeatedly.
+    // ready() returns true if the next band can be computed from
+    // bands that the parent level has already produced, that is,
+    // without waiting for more of the input file to be read.
     //
 
-    int    xs = IMATH_NAMESPACE::floor (x);
-    int    xt = xs + 1;
-    double s  = xt - x;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
+    bool done () const { return _nextBand >= _numBands; }
+    bool ready () const;
+    void advance ();
 
-    switch (ext)
-    {
-        case BLACK:
+    //
+    // Discard bands that are no longer needed by any level that
+    // is computed from this one.
+    //
 
-            vs = (xs >= 0 && xs < w) ? double (channel (xs, y)) : 0.0;
-            vt = (xt >= 0 && xt < w) ? double (channel (xt, y)) : 0.0;
-            break;
+    void releaseBands ();
 
-        case CLAMP:
+    void reduceRows (int y1, int y2);
 
-            xs = IMATH_NAMESPACE::clamp (xs, 0, w - 1);
-            xt = IMATH_NAMESPACE::clamp (xt, 0, w - 1);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+private:
+    int bandOf (int y) const { return y / _bandHeight; }
 
-        case PERIODIC:
+    bool bandIsNeeded (int b) const;
+    void ensureBand (int b);
+    void parentRows (int y, vector<int>& rows) const;
 
-            xs = modp (xs, w);
-            xt = modp (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+    char*       row (int y, int c);
+    FrameBuffer bandFrameBuffer (int b);
 
-        case MIRROR:
+    template <class T> void reduceRow (int y, int c);
 
-            xs = mirror (xs, w);
-            xt = mirror (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
-    }
+    const vector<LevelChannel>& _channels;
+    Box2i                       _dataWindow;
+    int                         _width;
+    int                         _height;
+    int                         _bandHeight;
+    int                         _numBands;
+    int                         _nextBand;
 
-    return s * vs + t * vt;
-}
+    Level*         _parent;
+    vector<Level*> _children;
+    Reduction      _reduction;
+    Extrapolation  _ext;
+    int            _offset;
 
-template <class T>
-double
-sampleY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+    vector<LevelFilterTaps> _taps;
+    vector<int>             _firstParentRow;
+    vector<int>             _lastParentRow;
+    vector<char>            _zeroRow;
+
+    vector<size_t> _pixelSize;
+    vector<size_t> _rowSize;
+    vector<size_t> _channelOffset;
+    size_t         _bandSize;
+
+    map<int, vector<char>> _bands;
+
+    InputPart*       _in;
+    TiledOutputPart* _out;
+    int              _lx;
+    int              _ly;
+};
+
+class ReduceTask : public Task
+{
+public:
+    ReduceTask (TaskGroup* group, Level& level, int y1, int y2)
+        : Task (group), _level (level), _y1 (y1), _y2 (y2)
+    {}
+
+    void execute () override { _level.reduceRows (_y1, _y2); }
+
+private:
+    Level& _level;
+    int    _y1;
+    int    _y2;
+};
+
+//
+// Number of pixels that a ReduceTask should process
+//
+
+const int pixelsPerTask = 16384;
+
+Level::Level (
+    const vector<LevelChannel>& channels,
+    const Box2i&                dataWindow,
+    int                         bandHeight,
+    Level*                      parent,
+    Reduction                   reduction,
+    Extrapolation               ext,
+    bool                        odd)
+    : _channels (channels)
+    , _dataWindow (dataWindow)
+    , _width (dataWindow.max.x - dataWindow.min.x + 1)
+    , _height (dataWindow.max.y - dataWindow.min.y + 1)
+    , _bandHeight (bandHeight)
+    , _numBands ((_height + bandHeight - 1) / bandHeight)
+    , _nextBand (0)
+    , _parent (parent)
+    , _reduction (reduction)
+    , _ext (ext)
+    , _offset (0)
+    , _bandSize (0)
+    , _in (0)
+    , _out (0)
+    , _lx (0)
+    , _ly (0)
 {
     //
-    // Sample an image channel at location (x, y), where
-    // x is an integer, and y is a floating point number.
+    // Set up the layout of the bands: the pixels of each channel are
+    // stored in a separate block of rows, aligned to eight bytes.
     //
 
-    int    ys = IMATH_NAMESPACE::floor (y);
-    int    yt = ys + 1;
-    double s  = yt - y;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
-
-    switch (ext)
+    for (size_t c = 0; c < _channels.size (); ++c)
     {
-        case BLACK:
+        size_t pixelSize = pixelTypeSize (_channels[c].type);
+        size_t rowSize   = ((_width + 1) * pixelSize + 7) & ~size_t (7);
 
-            vs = (ys >= 0 && ys < h) ? double (channel (x, ys)) : 0.0;
-            vt = (yt >= 0 && yt < h) ? double (channel (x, yt)) : 0.0;
-            break;
+        _pixelSize.push_back (pixelSize);
+        _rowSize.push_back (rowSize);
+        _channelOffset.push_back (_bandSize);
+        _bandSize += rowSize * _bandHeight;
+    }
 
-        case CLAMP:
+    if (!_parent) return;
 
-            ys = IMATH_NAMESPACE::clamp (ys, 0, h - 1);
-            yt = IMATH_NAMESPACE::clamp (yt, 0, h - 1);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+    _parent->_children.push_back (this);
 
-        case PERIODIC:
+    bool filter    = false;
+    bool subsample = false;
 
-            ys = modp (ys, h);
-            yt = modp (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+    for (size_t c = 0; c < _channels.size (); ++c)
+    {
+        if (_channels[c].filter)
+            filter = true;
+        else
+            subsample = true;
+    }
 
-        case MIRROR:
+    if (_reduction == REDUCE_X)
+    {
+        //
+        // For pixels (0, y) and (w1 - 1, y), the low-pass filter in
+        // the parent level is centered on pixels (0.5, y) and
+        // (w0 - 1.5, y) respectively.  Without low-pass filtering, in
+        // order to keep the image from sliding to the right if it is
+        // resampled repeatedly, we skip the rightmost pixel of every
+        // row on even passes, and the leftmost pixel on odd passes.
+        //
+
+        int    w0 = _parent->_width;
+        int    w1 = _width;
+        double f  = (w1 > 1) ? double (w0 - 2) / (w1 - 1) : 1;
+
+        _taps.resize (w1);
+
+        for (int x = 0; x < w1; ++x)
+            computeLevelFilterTaps (x * f, w0, _ext, w0, _taps[x]);
+
+        _offset = odd ? ((w0 - 1) - 2 * (w1 - 1)) : 0;
 
-            ys = mirror (ys, h);
-            yt = mirror (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+        for (int y = 0; y < _height; ++y)
+        {
+            _firstParentRow.push_back (y);
+            _lastParentRow.push_back (y);
+        }
     }
+    else
+    {
+        //
+        // Same as above, but vertically: without low-pass filtering,
+        // we skip the top pixel of every column on even passes, and
+        // the bottom pixel on odd passes.  BLACK extrapolation refers
+        // to _zeroRow for pixels outside the parent level.
+        //
+
+        int    h0 = _parent->_height;
+        int    h1 = _height;
+        double f  = (h1 > 1) ? double (h0 - 2) / (h1 - 1) : 1;
 
-    return s * vs + t * vt;
+        _taps.resize (h1);
+        _offset = odd ? ((h0 - 1) - 2 * (h1 - 1)) : 0;
+
+        for (int y = 0; y < h1; ++y)
+        {
+            computeLevelFilterTaps (y * f, h0, _ext, -1, _taps[y]);
+
+            int first = h0;
+            int last  = -1;
+
+            if (filter)
+            {
+                first = min (first, _taps[y].first);
+                last  = max (last, _taps[y].last);
+            }
+
+            if (subsample)
+            {
+                first = min (first, 2 * y + _offset);
+                last  = max (last, 2 * y + _offset);
+            }
+
+            _firstParentRow.push_back (max (first, 0));
+            _lastParentRow.push_back (min (last, h0 - 1));
+        }
+
+        _zeroRow.resize (_parent->_width * sizeof (float));
+    }
 }
 
-template <class T>
-T
-filterX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
+void
+Level::readFrom (InputPart* in)
 {
-    //
-    // Horizontal four-tap filter, centered on pixel (x + 0.5, y)
-    //
+    _in = in;
+}
 
-    return T (
-        0.125 * sampleX (channel, w, x - 1, y, ext) +
-        0.375 * sampleX (channel, w, x, y, ext) +
-        0.375 * sampleX (channel, w, x + 1, y, ext) +
-        0.125 * sampleX (channel, w, x + 2, y, ext));
+void
+Level::writeTo (TiledOutputPart* out, int lx, int ly)
+{
+    _out = out;
+    _lx  = lx;
+    _ly  = ly;
 }
 
-template <class T>
-T
-filterY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+bool
+Level::ready () const
 {
-    //
-    // Vertical four-tap filter, centered on pixel (x, y + 0.5)
-    //
+    if (done ()) return false;
 
-    return T (
-        0.125 * sampleY (channel, h, x, y - 1, ext) +
-        0.375 * sampleY (channel, h, x, y, ext) +
-        0.375 * sampleY (channel, h, x, y + 1, ext) +
-        0.125 * sampleY (channel, h, x, y + 2, ext));
+    if (!_parent) return true;
+
+    int y = min (_height, (_nextBand + 1) * _bandHeight) - 1;
+    return _parent->bandOf (_lastParentRow[y]) < _parent->_nextBand;
 }
 
-template <class T>
 void
-reduceX (
-    const TypedImageChannel<T>& channel0,
-    TypedImageChannel<T>&       channel1,
-    bool                        filter,
-    Extrapolation&              ext,
-    bool                        odd)
+Level::advance ()
 {
-    //
-    // Shrink an image channel, channel0, horizontally
-    // by a factor of 2, and store the result in channel1.
-    //
+    ensureBand (_nextBand);
+    ++_nextBand;
+}
 
-    int w0 = channel0.image ().width ();
-    int w1 = channel1.image ().width ();
-    int h1 = channel1.image ().height ();
+bool
+Level::bandIsNeeded (int b) const
+{
+    int lastRow = min (_height, (b + 1) * _bandHeight) - 1;
 
-    if (filter)
+    for (size_t i = 0; i < _children.size (); ++i)
     {
+        const Level& child = *_children[i];
+
+        if (child.done ()) continue;
+
         //
-        // Low-pass filter and resample.
-        // For pixels (0, y) and (w1 - 1, y) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (0.5, y) and (w0 - 1.5, y) respectively.
+        // With PERIODIC extrapolation, the bottom rows of the child
+        // level depend on the top rows of this level.
         //
 
-        double f = (w1 > 1) ? double (w0 - 2) / (w1 - 1) : 1;
+        if (b == 0 && child._reduction == REDUCE_Y &&
+            child._ext == EXTRAPOLATE_PERIODIC)
+            return true;
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterX (channel0, w0, x * f, y, ext);
+        int y = child._nextBand * child._bandHeight;
+
+        if (lastRow >= child._firstParentRow[y]) return true;
     }
-    else
+
+    return false;
+}
+
+void
+Level::releaseBands ()
+{
+    map<int, vector<char>>::iterator i = _bands.begin ();
+
+    while (i != _bands.end ())
     {
-        //
-        // Resample, skipping every other pixel, without
-        // low-pass filtering.  In order to keep the image
-        // from sliding to the right if the channel is
-        // resampled repeatedly, we skip the rightmost
-        // pixel of every row on even passes, and the
-        // leftmost pixel on odd passes.
-        //
+        if (bandIsNeeded (i->first))
+            ++i;
+        else
+            _bands.erase (i++);
+    }
+}
+
+void
+Level::parentRows (int y, vector<int>& rows) const
+{
+    //
+    // Find the rows in the parent level that are needed
+    // in order to compute row y of this level.
+    //
 
-        int offset = odd ? ((w0 - 1) - 2 * (w1 - 1)) : 0;
+    if (_reduction == REDUCE_X)
+    {
+        rows.push_back (y);
+        return;
+    }
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (2 * x + offset, y);
+    for (size_t c = 0; c < _channels.size (); ++c)
+    {
+        if (_channels[c].filter)
+        {
+            for (int i = 0; i < 4; ++i)
+                for (int j = 0; j < 2; ++j)
+                    if (_taps[y].index[i][j] >= 0)
+                        rows.push_back (_taps[y].index[i][j]);
+        }
+        else
+        {
+            rows.push_back (2 * y + _offset);
+        }
     }
 }
 
-template <class T>
 void
-reduceY (
-    const TypedImageChannel<T>& channel0,
-    TypedImageChannel<T>&       channel1,
-    bool                        filter,
-    Extrapolation               ext,
-    bool                        odd)
+Level::ensureBand (int b)
 {
     //
-    // Shrink an image channel, channel0, vertically
-    // by a factor of 2, and store the result in channel1.
+    // Compute band b if it doesn't exist yet.  The bands of the
+    // parent level that band b depends on are computed first.
+    // Usually they exist already, but with PERIODIC extrapolation,
+    // the top band of a level depends on the bottom band of its
+    // parent.
     //
 
-    int w1 = channel1.image ().width ();
-    int h0 = channel0.image ().height ();
-    int h1 = channel1.image ().height ();
+    if (_bands.find (b) != _bands.end ()) return;
 
-    if (filter)
+    int y1 = b * _bandHeight;
+    int y2 = min (_height, y1 + _bandHeight);
+
+    if (_parent)
     {
-        //
-        // Low-pass filter and resample.
-        // For pixels (x, 0) and (x, h1 - 1) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (x, 0.5) and (x, h0 - 1.5) respectively.
-        //
+        vector<int> rows;
 
-        double f = (h1 > 1) ? double (h0 - 2) / (h1 - 1) : 1;
+        for (int y = y1; y < y2; ++y)
+            parentRows (y, rows);
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterY (channel0, h0, x, y * f, ext);
+        set<int> parentBands;
+
+        for (size_t i = 0; i < rows.size (); ++i)
+            parentBands.insert (_parent->bandOf (rows[i]));
+
+        for (set<int>::iterator i = parentBands.begin ();
+             i != parentBands.end ();
+             ++i)
+            _parent->ensureBand (*i);
+    }
+
+    _bands[b].resize (_bandSize);
+
+    if (_in)
+    {
+        _in->setFrameBuffer (bandFrameBuffer (b));
+        _in->readPixels (_dataWindow.min.y + y1, _dataWindow.min.y + y2 - 1);
     }
     else
     {
-        //
-        // Resample, skipping every other pixel, without
-        // low-pass filtering.  In order to keep the image
-        // from sliding towards the top if the channel is
-        // resampled repeatedly, we skip the top pixel of
-        // every column on even passes, and the bottom pixel
-        // on odd passes.
-        //
+        int rowsPerTask = max (1, pixelsPerTask / _width);
 
-        int offset = odd ? ((h0 - 1) - 2 * (h1 - 1)) : 0;
+        TaskGroup taskGroup;
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (x, 2 * y + offset);
+        for (int y = y1; y < y2; y += rowsPerTask)
+        {
+            ThreadPool::addGlobalTask (new ReduceTask (
+                &taskGroup, *this, y, min (y + rowsPerTask, y2)));
+        }
+    }
+
+    if (_out)
+    {
+        _out->setFrameBuffer (bandFrameBuffer (b));
+        _out->writeTiles (0, _out->numXTiles (_lx) - 1, b, b, _lx, _ly);
     }
 }
 
-void
-reduceX (
-    const ChannelList& channels,
-    const set<string>& doNotFilter,
-    Extrapolation      ext,
-    bool               odd,
-    const Image&       image0,
-    Image&             image1)
+char*
+Level::row (int y, int c)
 {
-    //
-    // Shrink image image0 horizontally by a factor of 2,
-    // and store the result in image image1.
-    //
+    vector<char>& band = _bands.find (bandOf (y))->second;
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+    return &band[0] + _channelOffset[c] + (y % _bandHeight) * _rowSize[c];
+}
+
+FrameBuffer
+Level::bandFrameBuffer (int b)
+{
+    int y1 = b * _bandHeight;
+    int y2 = min (_height, y1 + _bandHeight);
+
+    Box2i box (
+        V2i (_dataWindow.min.x, _dataWindow.min.y + y1),
+        V2i (_dataWindow.max.x, _dataWindow.min.y + y2 - 1));
+
+    FrameBuffer fb;
+
+    for (size_t c = 0; c < _channels.size (); ++c)
     {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
+        fb.insert (
+            _channels[c].name,
+            Slice::Make (
+                _channels[c].type,
+                row (y1, c),
+                box,
+                _pixelSize[c],
+                _rowSize[c]));
+    }
 
-        switch (channel.type)
+    return fb;
+}
+
+void
+Level::reduceRows (int y1, int y2)
+{
+    for (int y = y1; y < y2; ++y)
+    {
+        for (size_t c = 0; c < _channels.size (); ++c)
         {
-            case IMF::HALF:
-
-                reduceX (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::FLOAT:
-
-                reduceX (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::UINT:
-
-                reduceX (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-            default: break;
+            switch (_channels[c].type)
+            {
+                case IMF::HALF: reduceRow<half> (y, c); break;
+
+                case IMF::FLOAT: reduceRow<float> (y, c); break;
+
+                case IMF::UINT: reduceRow<unsigned int> (y, c); break;
+
+                default: break;
+            }
         }
     }
 }
 
+template <class T>
 void
-reduceY (
-    const ChannelList& channels,
-    const set<string>& doNotFilter,
-    Extrapolation      ext,
-    bool               odd,
-    const Image&       image0,
-    Image&             image1)
+Level::reduceRow (int y, int c)
 {
-    //
-    // Shrink image image0 vertically by a factor of 2,
-    // and store the result in image image1.
-    //
+    T* out = reinterpret_cast<T*> (row (y, c));
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+    if (_reduction == REDUCE_X)
     {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
+        const T* in = reinterpret_cast<const T*> (_parent->row (y, c));
 
-        switch (channel.type)
+        if (_channels[c].filter)
+            filterLevelRowX (in, out, _width, &_taps[0]);
+        else
+            subsampleRowX (in, out, _width, _offset);
+    }
+    else if (_channels[c].filter)
+    {
+        const LevelFilterTaps& f = _taps[y];
+        const T*               in[4][2];
+
+        for (int i = 0; i < 4; ++i)
         {
-            case IMF::HALF:
-
-                reduceY (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::FLOAT:
-
-                reduceY (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-
-            case IMF::UINT:
-
-                reduceY (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-            default: break;
+            for (int j = 0; j < 2; ++j)
+            {
+                in[i][j] = (f.index[i][j] < 0)
+                               ? reinterpret_cast<const T*> (&_zeroRow[0])
+                               : reinterpret_cast<const T*> (
+                                     _parent->row (f.index[i][j], c));
+            }
         }
+
+        filterLevelRowY (in, out, _width, f);
+    }
+    else
+    {
+        memcpy (out, _parent->row (2 * y + _offset, c), _width * sizeof (T));
     }
 }
 
 void
-storeLevel (
+generateLevels (
+    InputPart&         in,
     TiledOutputPart&   out,
-    const ChannelList& channels,
-    int                lx,
-    int                ly,
-    const Image&       image)
+    const ChannelList& channelList,
+    const set<string>& doNotFilter,
+    Extrapolation      extX,
+    Extrapolation      extY,
+    bool               verbose)
 {
+    vector<LevelChannel> channels;
+
+    for (ChannelList::ConstIterator i = channelList.begin ();
+         i != channelList.end ();
+         ++i)
+    {
+        LevelChannel channel;
+        channel.name   = i.name ();
+        channel.type   = i.channel ().type;
+        channel.filter = (doNotFilter.find (i.name ()) == doNotFilter.end ());
+        channels.push_back (channel);
+    }
+
     //
-    // Store the pixels for level (lx, ly) in output file out.
+    // Set up the levels, parents before children.  Levels are stored
+    // in a deque so that their addresses remain stable while the
+    // deque grows.
     //
 
-    FrameBuffer fb;
+    int          bandHeight = out.tileYSize ();
+    deque<Level> levels;
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+    levels.emplace_back (channels, out.dataWindowForLevel (0, 0), bandHeight);
+    levels.back ().readFrom (&in);
+    levels.back ().writeTo (&out, 0, 0);
+
+    if (out.levelMode () == MIPMAP_LEVELS)
+    {
+        //
+        // Shrink each level first horizontally and then vertically.
+        //
+
+        for (int l = 1; l < out.numLevels (); ++l)
+        {
+            Level& parent = levels.back ();
+
+            levels.emplace_back (
+                channels,
+                out.dataWindowForLevel (l, l - 1),
+                bandHeight,
+                &parent,
+                REDUCE_X,
+                extX,
+                l & 1);
+
+            Level& reducedX = levels.back ();
+
+            levels.emplace_back (
+                channels,
+                out.dataWindowForLevel (l, l),
+                bandHeight,
+                &reducedX,
+                REDUCE_Y,
+                extY,
+                l & 1);
+
+            levels.back ().writeTo (&out, l, l);
+        }
+    }
+    else if (out.levelMode () == RIPMAP_LEVELS)
     {
-        const char* name = i.name ();
-        fb.insert (name, image.channel (name).slice ());
+        //
+        // Level (0, ly) is computed from level (0, ly - 1),
+        // level (lx, ly) from level (lx - 1, ly).
+        //
+
+        Level* column = &levels.front ();
+
+        for (int ly = 0; ly < out.numYLevels (); ++ly)
+        {
+            if (ly > 0)
+            {
+                levels.emplace_back (
+                    channels,
+                    out.dataWindowForLevel (0, ly),
+                    bandHeight,
+                    column,
+                    REDUCE_Y,
+                    extY,
+                    (ly - 1) & 1);
+
+                column = &levels.back ();
+                column->writeTo (&out, 0, ly);
+            }
+
+            for (int lx = 1; lx < out.numXLevels (); ++lx)
+            {
+                Level& parent = levels.back ();
+
+                levels.emplace_back (
+                    channels,
+                    out.dataWindowForLevel (lx, ly),
+                    bandHeight,
+                    &parent,
+                    REDUCE_X,
+                    extX,
+                    (lx - 1) & 1);
+
+                levels.back ().writeTo (&out, lx, ly);
+            }
+        }
     }
 
-    out.setFrameBuffer (fb);
+    //
+    // Read the input one band at a time.  After each band, advance
+    // every other level as far as possible, and discard the bands
+    // that are no longer needed.
+    //
+
+    while (!levels.front ().done ())
+    {
+        for (size_t i = 0; i < levels.size (); ++i)
+        {
+            Level& level   = levels[i];
+            bool   wasDone = level.done ();
+
+            if (i == 0)
+                level.advance ();
+            else
+                while (level.ready ())
+                    level.advance ();
+
+            if (verbose && !wasDone && level.done () && level.isStored ())
+            {
+                cout << "level (" << level.lx () << ", " << level.ly () << ")"
+                     << endl;
+            }
+        }
 
-    for (int y = 0; y < out.numYTiles (ly); ++y)
-        for (int x = 0; x < out.numXTiles (lx); ++x)
-            out.writeTile (x, y, lx, ly);
+        for (size_t i = 0; i < levels.size (); ++i)
+            levels[i].releaseBands ();
+    }
 }
 
 } // namespace
@@ -484,15 +758,11 @@ makeTiled (
     Extrapolation      extY,
     bool               verbose)
 {
-    Image          image0;
-    Image          image1;
-    Image          image2;
     Header         header;
-    FrameBuffer    fb;
     vector<Header> headers;
 
     //
-    // Load the input image
+    // Check the input image
     //
 
     MultiPartInputFile input (inFileName);
@@ -504,8 +774,7 @@ makeTiled (
 
         if (p == partnum)
         {
-            InputPart in (input, p);
-            header = in.header ();
+            header = input.header (p);
             if (hasEnvmap (header) && mode != ONE_LEVEL)
             {
                 //
@@ -520,13 +789,10 @@ makeTiled (
                     "Use exrenvmap instead.");
             }
 
-            image0.resize (header.dataWindow ());
-
             for (ChannelList::ConstIterator i = header.channels ().begin ();
                  i != header.channels ().end ();
                  ++i)
             {
-                const char*    name    = i.name ();
                 const Channel& channel = i.channel ();
 
                 if (channel.xSampling != 1 || channel.ySampling != 1)
@@ -535,20 +801,11 @@ makeTiled (
                         "Sub-sampled image channels are "
                         "not supported in tiled files.");
                 }
-
-                image0.addChannel (name, channel.type);
-                image1.addChannel (name, channel.type);
-                image2.addChannel (name, channel.type);
-                fb.insert (name, image0.channel (name).slice ());
             }
 
-            in.setFrameBuffer (fb);
-            in.readPixels (
-                header.dataWindow ().min.y, header.dataWindow ().max.y);
-
             //
             // Generate the header for the output file by modifying
-            // the input file's header
+            // the input file's header.
             //
 
             header.setTileDescription (
@@ -558,8 +815,7 @@ makeTiled (
             header.lineOrder ()   = INCREASING_Y;
 
             if (mode != ONE_LEVEL)
-                addWrapmodes (
-                    header, extToString (extX) + "," + extToString (extY));
+                addWrapmodes (header, wrapmodesForExtrapolation (extX, extY));
 
             //
             // set tileDescription, type, and chunckcount for multipart
@@ -578,7 +834,8 @@ makeTiled (
     }
 
     //
-    // Store the highest-resolution level of the image in the output file
+    // Copy the input image into the output file, and, if necessary,
+    // generate the lower-resolution mipmap or ripmap levels.
     //
 
     MultiPartOutputFile output (outFileName, &headers[0], headers.size ());
@@ -589,110 +846,19 @@ makeTiled (
         {
             try
             {
+                InputPart       in (input, partnum);
                 TiledOutputPart out (output, partnum);
-                //    TiledOutputFile out (outFileName, header);
-
-                out.setFrameBuffer (fb);
-
-                if (verbose)
-                    cout << "writing file " << outFileName
-                         << "\n"
-                            "level (0, 0)"
-                         << endl;
-
-                for (int y = 0; y < out.numYTiles (0); ++y)
-                    for (int x = 0; x < out.numXTiles (0); ++x)
-                        out.writeTile (x, y, 0);
 
-                //
-                // If necessary, generate the lower-resolution mipmap
-                // or ripmap levels, and store them in the output file.
-                //
+                if (verbose) cout << "writing file " << outFileName << endl;
 
-                if (mode == MIPMAP_LEVELS)
-                {
-                    for (int l = 1; l < out.numLevels (); ++l)
-                    {
-                        image1.resize (out.dataWindowForLevel (l, l - 1));
-
-                        reduceX (
-                            header.channels (),
-                            doNotFilter,
-                            extX,
-                            l & 1,
-                            image0,
-                            image1);
-
-                        image0.resize (out.dataWindowForLevel (l, l));
-
-                        reduceY (
-                            header.channels (),
-                            doNotFilter,
-                            extY,
-                            l & 1,
-                            image1,
-                            image0);
-
-                        if (verbose)
-                            cout << "level (" << l << ", " << l << ")" << endl;
-
-                        storeLevel (out, header.channels (), l, l, image0);
-                    }
-                }
-
-                if (mode == RIPMAP_LEVELS)
-                {
-                    Image* iptr0 = &image0;
-                    Image* iptr1 = &image1;
-                    Image* iptr2 = &image2;
-
-                    for (int ly = 0; ly < out.numYLevels (); ++ly)
-                    {
-                        if (ly < out.numYLevels () - 1)
-                        {
-                            iptr2->resize (out.dataWindowForLevel (0, ly + 1));
-
-                            reduceY (
-                                header.channels (),
-                                doNotFilter,
-                                extY,
-                                ly & 1,
-                                *iptr0,
-                                *iptr2);
-                        }
-
-                        for (int lx = 0; lx < out.numXLevels (); ++lx)
-                        {
-                            if (lx != 0 || ly != 0)
-                            {
-                                if (verbose)
-                                    cout << "level (" << lx << ", " << ly << ")"
-                                         << endl;
-
-                                storeLevel (
-                                    out, header.channels (), lx, ly, *iptr0);
-                            }
-
-                            if (lx < out.numXLevels () - 1)
-                            {
-                                iptr1->resize (
-                                    out.dataWindowForLevel (lx + 1, ly));
-
-                                reduceX (
-                                    header.channels (),
-                                    doNotFilter,
-                                    extX,
-                                    lx & 1,
-                                    *iptr0,
-                                    *iptr1);
-
-                                swap (iptr0, iptr1);
-                            }
-                        }
-
-                        swap (iptr2, iptr0);
-                    }
-                }
+                generateLevels (
+                    in,
+                    out,
+                    header.channels (),
+                    doNotFilter,
+                    extX,
+                    extY,
+                    verbose);
             }
             catch (const exception& e)
             {
@@ -24,12 +24,16 @@
 #include <ImfTiledInputPart.h>
 #include <ImfTiledOutputPart.h>
 
+#include <ImfThreading.h>
+
 #include <Iex.h>
+#include <IlmThreadPool.h>
 #include <OpenEXRConfig.h>
 
 #include <algorithm>
 #include <assert.h>
 #include <cctype>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <stdlib.h>
@@ -50,6 +54,9 @@ using std::string;
 using std::vector;
 
 using namespace OPENEXR_IMF_NAMESPACE;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 
 #if defined(ANDROID) || defined(__ANDROID_API__)
 #    define IMF_PATH_SEPARATOR "/"
@@ -111,6 +118,70 @@ copy_scanlinedeep (
     out.copyPixels (in);
 }
 
+//
+// Copies one part of a multipart file into a new single-part file.
+// The parts of a file are separated by concurrent SeparateTasks; any
+// error is returned in error rather than thrown.
+//
+
+class SeparateTask : public Task
+{
+public:
+    SeparateTask (
+        TaskGroup*          group,
+        MultiPartInputFile& input,
+        const string&       outname,
+        int                 part,
+        bool                override,
+        string&             error)
+        : Task (group)
+        , _input (input)
+        , _outname (outname)
+        , _part (part)
+        , _override (override)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            Header header = _input.header (_part);
+
+            MultiPartOutputFile out (_outname.c_str (), &header, 1, _override);
+
+            std::string type = header.type ();
+            if (type == SCANLINEIMAGE)
+            {
+                copy_scanline (_input, out, _part, 0);
+            }
+            else if (type == TILEDIMAGE)
+            {
+                copy_tile (_input, out, _part, 0);
+            }
+            else if (type == DEEPSCANLINE)
+            {
+                copy_scanlinedeep (_input, out, _part, 0);
+            }
+            else if (type == DEEPTILE)
+            {
+                copy_tiledeep (_input, out, _part, 0);
+            }
+        }
+        catch (std::exception& e)
+        {
+            _error = e.what ();
+        }
+    }
+
+private:
+    MultiPartInputFile& _input;
+    string              _outname;
+    int                 _part;
+    bool                _override;
+    string&             _error;
+};
+
 bool
 is_number (const std::string& s)
 {
@@ -294,9 +365,7 @@ convert (
         int parts = SplitChannels (
             output_channels.begin (), output_channels.end (), true, hero);
 
-        vector<Header>      output_headers (parts);
-        vector<FrameBuffer> output_framebuffers (parts);
-        FrameBuffer         input_framebuffer;
+        vector<Header> output_headers (parts);
 
         //
         // make all output headers the same as the input header but
@@ -321,26 +390,8 @@ convert (
 
         const ChannelList& in_chanlist = infile.header (0).channels ();
 
-        int channel_count = 0;
-        for (ChannelList::ConstIterator i = in_chanlist.begin ();
-             i != in_chanlist.end ();
-             ++i)
-        {
-            ++channel_count;
-        }
-
-        Box2i dataWindow = infile.header (0).dataWindow ();
-        int   pixel_count =
-            (dataWindow.size ().y + 1) * (dataWindow.size ().x + 1);
-        int pixel_width = dataWindow.size ().x + 1;
-
-        // offset in pixels between base of array and 0,0
-        int pixel_base = dataWindow.min.y * pixel_width + dataWindow.min.x;
-
-        vector<vector<char>> channelstore (channel_count);
-
         //
-        // insert channels into correct header and framebuffers
+        // insert channels into correct header
         //
         for (size_t i = 0; i < input_channels.size (); i++)
         {
@@ -355,27 +406,6 @@ convert (
             {
                 h.setView (output_channels[i].view);
             }
-
-            // compute size of channel
-            size_t samplesize = sizeof (float);
-            if (chan.channel ().type == HALF) { samplesize = sizeof (half); }
-            channelstore[i].resize (samplesize * pixel_count);
-
-            output_framebuffers[part].insert (
-                output_channels[i].name,
-                Slice (
-                    chan.channel ().type,
-                    &channelstore[i][0] - pixel_base * samplesize,
-                    samplesize,
-                    pixel_width * samplesize));
-
-            input_framebuffer.insert (
-                input_channels[i].internal_name,
-                Slice (
-                    chan.channel ().type,
-                    &channelstore[i][0] - pixel_base * samplesize,
-                    samplesize,
-                    pixel_width * samplesize));
         }
 
         //
@@ -386,20 +416,124 @@ convert (
         InputPart inpart (infile, 0);
 
         //
-        // read file
+        // Parts whose channels are exactly the input file's channels
+        // are copied chunk by chunk, without decompressing and
+        // re-compressing the pixels.
         //
-        inpart.setFrameBuffer (input_framebuffer);
-        inpart.readPixels (dataWindow.min.y, dataWindow.max.y);
+        bool         tiled = infile.header (0).hasTileDescription ();
+        vector<bool> raw_copy (parts);
+        bool         decode = false;
+
+        for (int i = 0; i < parts; i++)
+        {
+            raw_copy[i] =
+                !tiled && output_headers[i].channels () == in_chanlist;
+
+            if (raw_copy[i])
+            {
+                OutputPart outpart (outfile, i);
+                outpart.copyPixels (inpart);
+            }
+            else
+            {
+                decode = true;
+            }
+        }
+
+        if (!decode) return;
 
         //
-        // write each part
+        // The other parts are written in bands of scan lines.  Each
+        // band is read from the input file only once, and then written
+        // to all those parts; only one band of pixels is held in memory.
+        // The band height is a multiple of the number of scan lines per
+        // chunk for all compression methods, so that chunks are not
+        // decompressed more than once.
         //
+        const int band_height = 256;
+
+        const Header& header      = infile.header (0);
+        Box2i         dataWindow  = header.dataWindow ();
+        int           pixel_width = dataWindow.size ().x + 1;
+        int  band_count = (dataWindow.size ().y + band_height) / band_height;
+        bool decreasing = header.lineOrder () == DECREASING_Y;
 
-        for (size_t i = 0; i < output_framebuffers.size (); i++)
+        vector<vector<char>> channelstore (input_channels.size ());
+
+        for (size_t i = 0; i < input_channels.size (); i++)
         {
-            OutputPart outpart (outfile, i);
-            outpart.setFrameBuffer (output_framebuffers[i]);
-            outpart.writePixels (dataWindow.max.y + 1 - dataWindow.min.y);
+            const Channel& chan =
+                in_chanlist[input_channels[i].internal_name.c_str ()];
+
+            // compute size of channel
+            size_t samplesize = sizeof (float);
+            if (chan.type == HALF) { samplesize = sizeof (half); }
+            channelstore[i].resize (samplesize * pixel_width * band_height);
+        }
+
+        vector<OutputPart*> outparts (parts);
+
+        for (int i = 0; i < parts; i++)
+        {
+            outparts[i] = raw_copy[i] ? 0 : new OutputPart (outfile, i);
+        }
+
+        for (int b = 0; b < band_count; b++)
+        {
+            int band = decreasing ? band_count - 1 - b : b;
+            int y1   = dataWindow.min.y + band * band_height;
+            int y2   = min (y1 + band_height - 1, dataWindow.max.y);
+
+            vector<FrameBuffer> output_framebuffers (parts);
+            FrameBuffer         input_framebuffer;
+
+            for (size_t i = 0; i < input_channels.size (); i++)
+            {
+                int            part = output_channels[i].part_number;
+                const Channel& chan =
+                    in_chanlist[input_channels[i].internal_name.c_str ()];
+
+                if (raw_copy[part]) continue;
+
+                size_t samplesize = sizeof (float);
+                if (chan.type == HALF) { samplesize = sizeof (half); }
+
+                // offset in pixels between base of the band and 0,0
+                intptr_t pixel_base =
+                    intptr_t (y1) * pixel_width + dataWindow.min.x;
+                char* base = &channelstore[i][0] - pixel_base * samplesize;
+
+                Slice slice (
+                    chan.type, base, samplesize, pixel_width * samplesize);
+
+                output_framebuffers[part].insert (
+                    output_channels[i].name, slice);
+
+                input_framebuffer.insert (
+                    input_channels[i].internal_name, slice);
+            }
+
+            //
+            // read band
+            //
+            inpart.setFrameBuffer (input_framebuffer);
+            inpart.readPixels (y1, y2);
+
+            //
+            // write band to each part
+            //
+            for (int i = 0; i < parts; i++)
+            {
+                if (raw_copy[i]) continue;
+
+                outparts[i]->setFrameBuffer (output_framebuffers[i]);
+                outparts[i]->writePixels (y2 + 1 - y1);
+            }
+        }
+
+        for (int i = 0; i < parts; i++)
+        {
+            delete outparts[i];
         }
     }
     catch (IEX_NAMESPACE::BaseExc& e)
@@ -636,35 +770,35 @@ separate (vector<const char*> in, const char* out, bool override)
     filename_check (fornamecheck, in[0]);
 
     //
-    // separate outputs
+    // separate outputs; the output files are written concurrently,
+    // each by its own task
     //
-    for (int p = 0; p < numOutputs; p++)
-    {
-        Header header = inputimage->header (p);
+    vector<string> errors (numOutputs);
 
-        MultiPartOutputFile out (
-            fornamecheck[p].c_str (), &header, 1, override);
+    {
+        TaskGroup taskGroup;
 
-        std::string type = header.type ();
-        if (type == "scanlineimage")
-        {
-            cout << "scanlineimage" << endl;
-            copy_scanline (*inputimage, out, p, 0);
-        }
-        else if (type == "tiledimage")
-        {
-            cout << "tiledimage" << endl;
-            copy_tile (*inputimage, out, p, 0);
-        }
-        else if (type == "deepscanline")
+        for (int p = 0; p < numOutputs; p++)
         {
-            cout << "deepscanline" << endl;
-            copy_scanlinedeep (*inputimage, out, p, 0);
+            cout << inputimage->header (p).type () << endl;
+
+            ThreadPool::addGlobalTask (new SeparateTask (
+                &taskGroup,
+                *inputimage,
+                fornamecheck[p],
+                p,
+                override,
+                errors[p]));
         }
-        else if (type == "deeptile")
+    }
+
+    for (int p = 0; p < numOutputs; p++)
+    {
+        if (!errors[p].empty ())
         {
-            cout << "deeptile" << endl;
-            copy_tiledeep (*inputimage, out, p, 0);
+            cerr << "\n"
+                 << "ERROR: " << errors[p] << endl;
+            exit (1);
         }
     }
 
@@ -693,6 +827,8 @@ usageMessage (const char argv[])
 
     cout << "-view name           (after specifying -i) "
             "assign following inputs to view 'name'\n";
+    cout << "-j n                 use n threads (default is the number "
+            "of CPU cores)\n";
     exit (1);
 }
 
@@ -707,9 +843,12 @@ main (int argc, char* argv[])
     const char*         outFile  = 0;
     bool                override = false;
 
+    int threads = ThreadPool::estimateThreadCountForFileIO ();
+
     int i = 1;
     int mode =
-        0; // 0-do not read input, 1-infiles, 2-outfile, 3-override, 4-view
+        0; // 0-do not read input, 1-infiles, 2-outfile, 3-override, 4-view,
+           // 5-threads
 
     while (i < argc)
     {
@@ -733,6 +872,10 @@ main (int argc, char* argv[])
             }
             mode = 4;
         }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            mode = 5;
+        }
         else
         {
             switch (mode)
@@ -747,6 +890,7 @@ main (int argc, char* argv[])
                     view = argv[i];
                     mode = 1;
                     break;
+                case 5: threads = atoi (argv[i]); break;
             }
         }
         i++;
@@ -778,6 +922,15 @@ main (int argc, char* argv[])
     cout << "output:\n      " << outFile << endl;
     cout << "override:" << override << "\n" << endl;
 
+    if (threads < 0)
+    {
+        cerr << "\n"
+             << "ERROR: number of threads cannot be negative" << endl;
+        exit (1);
+    }
+
+    setGlobalThreadCount (threads);
+
     if (!strcmp (argv[1], "-combine"))
     {
         cout << "-combine multipart input " << endl;
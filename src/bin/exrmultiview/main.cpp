@@ -11,6 +11,8 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <IlmThreadPool.h>
+#include <ImfThreading.h>
 #include <makeMultiView.h>
 
 #include <exception>
@@ -55,7 +57,16 @@ usageMessage (const char argv0[], bool verbose = false)
                 "\n"
                 "-z x      sets the data compression method to x\n"
                 "          (none/rle/zip/piz/pxr24/b44/b44a/dwaa/dwab,\n"
-                "          default is piz)\n"
+                "          default is piz, or the compression of each\n"
+                "          input file with -p)\n"
+                "\n"
+                "-p        writes a multi-part file with one part per\n"
+                "          view; the chunks of input files whose\n"
+                "          compression does not change are copied\n"
+                "          without decompressing them\n"
+                "\n"
+                "-j n      uses n threads to read and write the image\n"
+                "          files (default is the number of CPU cores)\n"
                 "\n"
                 "-v        verbose mode\n"
                 "\n"
@@ -125,8 +136,11 @@ main (int argc, char** argv)
     vector<string>      views;
     vector<const char*> inFiles;
     const char*         outFile     = 0;
-    Compression         compression = PIZ_COMPRESSION;
+    Compression         compression = NUM_COMPRESSION_METHODS;
+    bool                multiPart   = false;
     bool                verbose     = false;
+    int                 threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
 
     //
     // Parse the command line.
@@ -149,6 +163,33 @@ main (int argc, char** argv)
             compression = getCompression (argv[i + 1]);
             i += 2;
         }
+        else if (!strcmp (argv[i], "-p"))
+        {
+            //
+            // Multi-part output
+            //
+
+            multiPart = true;
+            i += 1;
+        }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            //
+            // Set number of threads
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
         else if (!strcmp (argv[i], "-v"))
         {
             //
@@ -216,7 +257,10 @@ main (int argc, char** argv)
 
     try
     {
-        makeMultiView (views, inFiles, outFile, compression, verbose);
+        setGlobalThreadCount (threads);
+
+        makeMultiView (
+            views, inFiles, outFile, compression, multiPart, verbose);
     }
     catch (const exception& e)
     {
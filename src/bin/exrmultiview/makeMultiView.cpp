@@ -16,40 +16,158 @@
 #include <ImfChannelList.h>
 #include <ImfFrameBuffer.h>
 #include <ImfInputFile.h>
+#include <ImfMultiPartOutputFile.h>
 #include <ImfMultiView.h>
 #include <ImfOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
 #include <ImfStandardAttributes.h>
+#include <ImfTiledOutputPart.h>
 #include <algorithm>
 #include <iostream>
-#include <map>
+#include <memory>
 
 #include "namespaceAlias.h"
 using namespace IMF;
 using namespace IMATH_NAMESPACE;
 using namespace std;
 
+namespace
+{
+
+//
+// An input file, and the names of its channels in the output file.
+//
+
+struct ViewInput
+{
+    InputFile*     file;
+    vector<string> inNames;
+    vector<string> outNames;
+};
+
+//
+// Write the pixels of the output image in bands of scan lines.
+// Each band is assembled from the input files and then written;
+// only one band of pixels is held in memory.  The band height is
+// a multiple of the number of scan lines per chunk of every
+// compression method, so that chunks are decompressed only once,
+// and of the y sampling rate of every channel.  Reading and writing
+// a band are multithreaded by the library (see ImfThreading.h).
+//
+
+template <class OutputType>
 void
-makeMultiView (
+writeBands (
+    const vector<ViewInput>& inputs, const Header& header, OutputType& out)
+{
+    const Box2i&       dw       = header.dataWindow ();
+    const ChannelList& channels = header.channels ();
+
+    int bandHeight = 256;
+
+    for (ChannelList::ConstIterator i = channels.begin ();
+         i != channels.end ();
+         ++i)
+    {
+        while (bandHeight % i.channel ().ySampling)
+            bandHeight += 256;
+    }
+
+    Image band;
+
+    for (ChannelList::ConstIterator i = channels.begin ();
+         i != channels.end ();
+         ++i)
+    {
+        band.addChannel (i.name (), i.channel ());
+    }
+
+    int  numBands   = (dw.max.y - dw.min.y + bandHeight) / bandHeight;
+    bool decreasing = header.lineOrder () == DECREASING_Y;
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        int y1 = dw.min.y + (decreasing ? numBands - 1 - b : b) * bandHeight;
+        int y2 = min (y1 + bandHeight - 1, dw.max.y);
+
+        band.resize (
+            Box2i (V2i (dw.min.x, y1), V2i (dw.max.x, y1 + bandHeight - 1)));
+
+        FrameBuffer outFb;
+
+        for (ChannelList::ConstIterator i = channels.begin ();
+             i != channels.end ();
+             ++i)
+        {
+            band.channel (i.name ()).black ();
+            outFb.insert (i.name (), band.channel (i.name ()).slice ());
+        }
+
+        for (size_t i = 0; i < inputs.size (); ++i)
+        {
+            const ViewInput& in   = inputs[i];
+            const Box2i&     inDw = in.file->header ().dataWindow ();
+
+            int r1 = max (y1, inDw.min.y);
+            int r2 = min (y2, inDw.max.y);
+
+            if (r1 > r2) continue;
+
+            FrameBuffer inFb;
+
+            for (size_t j = 0; j < in.inNames.size (); ++j)
+            {
+                inFb.insert (
+                    in.inNames[j], band.channel (in.outNames[j]).slice ());
+            }
+
+            in.file->setFrameBuffer (inFb);
+            in.file->readPixels (r1, r2);
+        }
+
+        out.setFrameBuffer (outFb);
+        out.writePixels (y2 - y1 + 1);
+    }
+}
+
+void
+checkSingleView (InputFile& in, const char fileName[])
+{
+    if (hasMultiView (in.header ()))
+    {
+        THROW (
+            IEX_NAMESPACE::NoImplExc,
+            "The image in file "
+                << fileName
+                << " is already a "
+                   "multi-view image.  Cannot combine multiple multi-view "
+                   "images.");
+    }
+}
+
+void
+makeSinglePart (
     const vector<string>&      viewNames,
     const vector<const char*>& inFileNames,
     const char*                outFileName,
     Compression                compression,
     bool                       verbose)
 {
-    Header      header;
-    Image       image;
-    FrameBuffer outFb;
+    Header                        header;
+    vector<unique_ptr<InputFile>> files;
+    vector<ViewInput>             inputs (viewNames.size ());
 
     //
-    // Find the size of the dataWindow, check files
+    // Open the input files, find the size of the data window,
+    // and name the channels of the output file.
     //
 
-    Box2i d;
+    Box2i       d;
+    ChannelList channels;
 
     for (size_t i = 0; i < viewNames.size (); ++i)
     {
-        InputFile in (inFileNames[i]);
-
         if (verbose)
         {
             cout << "reading file " << inFileNames[i]
@@ -58,16 +176,10 @@ makeMultiView (
                  << viewNames[i] << " view" << endl;
         }
 
-        if (hasMultiView (in.header ()))
-        {
-            THROW (
-                IEX_NAMESPACE::NoImplExc,
-                "The image in file "
-                    << inFileNames[i]
-                    << " is already a "
-                       "multi-view image.  Cannot combine multiple multi-view "
-                       "images.");
-        }
+        files.emplace_back (new InputFile (inFileNames[i]));
+        InputFile& in = *files.back ();
+
+        checkSingleView (in, inFileNames[i]);
 
         header = in.header ();
         if (i == 0) { d = header.dataWindow (); }
@@ -75,70 +187,175 @@ makeMultiView (
         {
             d.extendBy (header.dataWindow ());
         }
+
+        inputs[i].file = &in;
+
+        for (ChannelList::ConstIterator j = in.header ().channels ().begin ();
+             j != in.header ().channels ().end ();
+             ++j)
+        {
+            string outChanName = insertViewName (j.name (), viewNames, i);
+
+            channels.insert (outChanName, j.channel ());
+            inputs[i].inNames.push_back (j.name ());
+            inputs[i].outNames.push_back (outChanName);
+        }
     }
 
-    image.resize (d);
+    header.channels ()    = channels;
+    header.dataWindow ()  = d;
+    header.compression () = compression;
+
+    //
+    // Tiled files may have RANDOM_Y line order, which is not valid
+    // for scan line files, and the chunk count of the input does not
+    // match the number of scan line blocks of the output.
+    //
 
-    header.dataWindow () = d;
+    if (header.hasTileDescription ())
+    {
+        header.erase ("tiles");
+        header.lineOrder () = INCREASING_Y;
+    }
 
-    // blow away channels; we'll rebuild them
-    header.channels () = ChannelList ();
+    header.erase ("chunkCount");
+    addMultiView (header, viewNames);
 
     //
-    // Read the input image files
+    // Write the output image file
     //
 
+    OutputFile out (outFileName, header);
+
+    if (verbose) cout << "writing file " << outFileName << endl;
+
+    writeBands (inputs, header, out);
+}
+
+void
+makeMultiPart (
+    const vector<string>&      viewNames,
+    const vector<const char*>& inFileNames,
+    const char*                outFileName,
+    Compression                compression,
+    bool                       verbose)
+{
+    vector<unique_ptr<InputFile>> files;
+    vector<Header>                headers;
+    vector<bool>                  raw;
+
     for (size_t i = 0; i < viewNames.size (); ++i)
     {
-        InputFile in (inFileNames[i]);
+        files.emplace_back (new InputFile (inFileNames[i]));
+        InputFile& in = *files.back ();
 
-        if (verbose)
-        {
-            cout << "reading file " << inFileNames[i]
-                 << " "
-                    "for "
-                 << viewNames[i] << " view" << endl;
-        }
+        checkSingleView (in, inFileNames[i]);
 
-        FrameBuffer inFb;
+        Header header = in.header ();
+        header.setName (viewNames[i]);
+        header.setView (viewNames[i]);
 
-        for (ChannelList::ConstIterator j = in.header ().channels ().begin ();
-             j != in.header ().channels ().end ();
-             ++j)
-        {
-            const Channel& inChannel  = j.channel ();
-            string         inChanName = j.name ();
-            string outChanName = insertViewName (inChanName, viewNames, i);
+        if (compression != NUM_COMPRESSION_METHODS)
+            header.compression () = compression;
+
+        //
+        // Files that keep their compression method are copied
+        // chunk by chunk.  The others are converted to scan lines.
+        //
 
-            image.addChannel (outChanName, inChannel);
-            image.channel (outChanName).black ();
+        raw.push_back (header.compression () == in.header ().compression ());
 
-            header.channels ().insert (outChanName, inChannel);
+        if (raw.back () && in.header ().hasTileDescription ())
+        {
+            header.setType (TILEDIMAGE);
+        }
+        else
+        {
+            header.setType (SCANLINEIMAGE);
+            header.erase ("chunkCount");
 
-            inFb.insert (inChanName, image.channel (outChanName).slice ());
-            outFb.insert (outChanName, image.channel (outChanName).slice ());
+            if (header.hasTileDescription ())
+            {
+                header.erase ("tiles");
+                header.lineOrder () = INCREASING_Y;
+            }
         }
 
-        in.setFrameBuffer (inFb);
-        in.readPixels (
-            in.header ().dataWindow ().min.y, in.header ().dataWindow ().max.y);
+        headers.push_back (header);
     }
 
     //
-    // Write the output image file
+    // All parts share the display window, pixel aspect ratio, time
+    // code and chromaticities of the first view.
     //
 
+    MultiPartOutputFile out (
+        outFileName, &headers[0], int (headers.size ()), true);
+
+    for (size_t i = 0; i < viewNames.size (); ++i)
     {
-        header.compression () = compression;
-        addMultiView (header, viewNames);
+        InputFile& in = *files[i];
+
+        if (verbose)
+        {
+            cout << (raw[i] ? "copying" : "converting") << " file "
+                 << inFileNames[i] << " to part " << i << " of "
+                 << outFileName << " for " << viewNames[i] << " view"
+                 << endl;
+        }
 
-        OutputFile out (outFileName, header);
+        if (raw[i] && in.header ().hasTileDescription ())
+        {
+            TiledOutputPart part (out, int (i));
+            part.copyPixels (in);
+        }
+        else if (raw[i])
+        {
+            OutputPart part (out, int (i));
+            part.copyPixels (in);
+        }
+        else
+        {
+            vector<ViewInput> inputs (1);
+            inputs[0].file = &in;
 
-        if (verbose) cout << "writing file " << outFileName << endl;
+            for (ChannelList::ConstIterator j =
+                     in.header ().channels ().begin ();
+                 j != in.header ().channels ().end ();
+                 ++j)
+            {
+                inputs[0].inNames.push_back (j.name ());
+                inputs[0].outNames.push_back (j.name ());
+            }
 
-        out.setFrameBuffer (outFb);
+            OutputPart part (out, int (i));
+            writeBands (inputs, out.header (int (i)), part);
+        }
+    }
+}
+
+} // namespace
+
+void
+makeMultiView (
+    const vector<string>&      viewNames,
+    const vector<const char*>& inFileNames,
+    const char*                outFileName,
+    Compression                compression,
+    bool                       multiPart,
+    bool                       verbose)
+{
+    if (multiPart)
+    {
+        makeMultiPart (
+            viewNames, inFileNames, outFileName, compression, verbose);
+    }
+    else
+    {
+        if (compression == NUM_COMPRESSION_METHODS)
+            compression = PIZ_COMPRESSION;
 
-        out.writePixels (
-            header.dataWindow ().max.y - header.dataWindow ().min.y + 1);
+        makeSinglePart (
+            viewNames, inFileNames, outFileName, compression, verbose);
     }
 }
@@ -11,6 +11,14 @@
 //	Combine multiple single-view images
 //	into one multi-view image.
 //
+//	If multiPart is false, the views are stored in the channels
+//	of a single-part image, compressed with the given method.
+//	If multiPart is true, each view is stored in its own part;
+//	the chunks of input files that keep their compression method
+//	are copied without decompressing them.  Compression
+//	NUM_COMPRESSION_METHODS selects the default: PIZ for a
+//	single-part image, or the compression of each input file.
+//
 //----------------------------------------------------------------------------
 
 #include "namespaceAlias.h"
@@ -23,6 +31,7 @@ void makeMultiView (
     const std::vector<const char*>& inFileNames,
     const char*                     outFileName,
     IMF::Compression                compression,
+    bool                            multiPart,
     bool                            verbose);
 
 #endif
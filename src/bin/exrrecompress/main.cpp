@@ -0,0 +1,315 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	exrrecompress -- program that re-encodes the pixel data of
+//	OpenEXR images with a different compression method.
+//
+//-----------------------------------------------------------------------------
+
+#include <IlmThreadPool.h>
+#include <ImfRecompressFile.h>
+#include <ImfThreading.h>
+#include <openexr.h>
+
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+void
+usageMessage (const char argv0[], bool verbose = false)
+{
+    cerr << "Usage: " << argv0 << " [options] infile outfile" << endl;
+
+    if (verbose)
+    {
+        cerr << "\n"
+                "Reads an OpenEXR image from infile, compresses the pixel\n"
+                "data of every part with a new compression method, and\n"
+                "saves the result in outfile.  All other header\n"
+                "attributes, the part structure and the tile layout of\n"
+                "the image are preserved.  Deep images are not supported.\n"
+                "\n"
+                "Options:\n"
+                "\n"
+                "-z x      sets the data compression method to x\n"
+                "          (none/rle/zips/zip/piz/pxr24/b44/b44a/dwaa/dwab,\n"
+                "          default is zip)\n"
+                "\n"
+                "-l x      sets the compression level to x: the zlib level\n"
+                "          (1 to 9) for zip and zips, or the quality for\n"
+                "          dwaa and dwab (default is the level of the\n"
+                "          input file, or 45)\n"
+                "\n"
+                "-j n      uses n threads to decompress and compress the\n"
+                "          image (default is the number of CPU cores)\n"
+                "\n"
+                "-v        verbose mode, prints the throughput of the\n"
+                "          read, decompress, compress and write stages\n"
+                "\n"
+                "-h        prints this message\n";
+
+        cerr << endl;
+    }
+
+    exit (1);
+}
+
+Compression
+getCompression (const string& str)
+{
+    Compression c;
+
+    if (str == "no" || str == "none" || str == "NO" || str == "NONE")
+    {
+        c = NO_COMPRESSION;
+    }
+    else if (str == "rle" || str == "RLE")
+    {
+        c = RLE_COMPRESSION;
+    }
+    else if (str == "zips" || str == "ZIPS")
+    {
+        c = ZIPS_COMPRESSION;
+    }
+    else if (str == "zip" || str == "ZIP")
+    {
+        c = ZIP_COMPRESSION;
+    }
+    else if (str == "piz" || str == "PIZ")
+    {
+        c = PIZ_COMPRESSION;
+    }
+    else if (str == "pxr24" || str == "PXR24")
+    {
+        c = PXR24_COMPRESSION;
+    }
+    else if (str == "b44" || str == "B44")
+    {
+        c = B44_COMPRESSION;
+    }
+    else if (str == "b44a" || str == "B44A")
+    {
+        c = B44A_COMPRESSION;
+    }
+    else if (str == "dwaa" || str == "DWAA")
+    {
+        c = DWAA_COMPRESSION;
+    }
+    else if (str == "dwab" || str == "DWAB")
+    {
+        c = DWAB_COMPRESSION;
+    }
+    else
+    {
+        cerr << "Unknown compression method \"" << str << "\"." << endl;
+        exit (1);
+    }
+
+    return c;
+}
+
+void
+printStage (const char name[], uint64_t bytes, double seconds)
+{
+    cout << "    " << left << setw (12) << name << right << fixed
+         << setprecision (3) << setw (10) << seconds << " s";
+
+    if (seconds > 0)
+    {
+        cout << setprecision (1) << setw (10) << bytes / seconds / 1.0e6
+             << " MB/s";
+    }
+
+    cout << endl;
+}
+
+void
+printStats (const RecompressStats& s)
+{
+    cout << "read " << s.chunksRead << " chunks, " << s.bytesRead
+         << " bytes (" << s.bytesUnpacked << " bytes uncompressed)\n"
+         << "wrote " << s.chunksWritten << " chunks, " << s.bytesWritten
+         << " bytes\n"
+         << "stage times (summed over threads) and throughput:\n";
+
+    printStage ("read", s.bytesRead, s.readTime);
+    printStage ("decompress", s.bytesUnpacked, s.decompressTime);
+    printStage ("compress", s.bytesUnpacked, s.compressTime);
+    printStage ("write", s.bytesWritten, s.writeTime);
+    printStage ("total", s.bytesUnpacked, s.totalTime);
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    const char* inFile      = 0;
+    const char* outFile     = 0;
+    Compression compression = ZIP_COMPRESSION;
+    const char* level       = 0;
+    bool        verbose     = false;
+    int         threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
+    //
+    // Parse the command line.
+    //
+
+    if (argc < 2) usageMessage (argv[0], true);
+
+    int i = 1;
+
+    while (i < argc)
+    {
+        if (!strcmp (argv[i], "-z"))
+        {
+            //
+            // Set compression method
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            compression = getCompression (argv[i + 1]);
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-l"))
+        {
+            //
+            // Set compression level
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            level = argv[i + 1];
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            //
+            // Set number of threads
+            //
+
+            if (i > argc - 2) usageMessage (argv[0]);
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-v"))
+        {
+            //
+            // Verbose mode
+            //
+
+            verbose = true;
+            i += 1;
+        }
+        else if (!strcmp (argv[i], "-h"))
+        {
+            //
+            // Print help message
+            //
+
+            usageMessage (argv[0], true);
+        }
+        else
+        {
+            //
+            // Image file name
+            //
+
+            if (inFile == 0)
+                inFile = argv[i];
+            else
+                outFile = argv[i];
+
+            i += 1;
+        }
+    }
+
+    if (inFile == 0 || outFile == 0) usageMessage (argv[0]);
+
+    if (!strcmp (inFile, outFile))
+    {
+        cerr << "Input and output cannot be the same file." << endl;
+        return 1;
+    }
+
+    float dwaLevel = -1;
+
+    if (level)
+    {
+        char* end = 0;
+
+        if (compression == DWAA_COMPRESSION ||
+            compression == DWAB_COMPRESSION)
+        {
+            dwaLevel = strtof (level, &end);
+
+            if (end == level || *end != 0 || !(dwaLevel >= 0) ||
+                !isfinite (dwaLevel))
+            {
+                cerr << "Compression level must be a non-negative number."
+                     << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            //
+            // The zlib level is passed to OpenEXRCore, which compresses
+            // the pixel data, as the default for all files.
+            //
+
+            long l = strtol (level, &end, 0);
+
+            if (end == level || *end != 0 || l < 1 || l > 9)
+            {
+                cerr << "Compression level must be between 1 and 9." << endl;
+                return 1;
+            }
+
+            exr_set_default_zip_compression_level (int (l));
+        }
+    }
+
+    int exitStatus = 0;
+
+    try
+    {
+        setGlobalThreadCount (threads);
+
+        RecompressStats stats;
+        recompressFile (inFile, outFile, compression, &stats, dwaLevel);
+
+        if (verbose) printStats (stats);
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what () << endl;
+        exitStatus = 1;
+    }
+
+    return exitStatus;
+}
@@ -11,23 +11,11 @@
 //-----------------------------------------------------------------------------
 
 #include <ImathNamespace.h>
-#include <ImfDeepScanLineInputPart.h>
-#include <ImfDeepScanLineOutputPart.h>
-#include <ImfDeepTiledInputPart.h>
-#include <ImfDeepTiledOutputPart.h>
-#include <ImfInputFile.h>
-#include <ImfInputPart.h>
 #include <ImfIntAttribute.h>
 #include <ImfMultiPartInputFile.h>
-#include <ImfMultiPartOutputFile.h>
 #include <ImfNamespace.h>
-#include <ImfOutputFile.h>
-#include <ImfOutputPart.h>
-#include <ImfPartType.h>
 #include <ImfStandardAttributes.h>
-#include <ImfTiledInputPart.h>
-#include <ImfTiledOutputFile.h>
-#include <ImfTiledOutputPart.h>
+#include <ImfUpdateHeaders.h>
 #include <ImfVecAttribute.h>
 
 #include <exception>
@@ -51,9 +39,10 @@ usageMessage (const char argv0[], bool verbose = false)
         cerr << "\n"
                 "Reads OpenEXR image file infile, sets the values of one\n"
                 "or more attributes in the headers of the file, and saves\n"
-                "the result in outfile.  Infile and outfile must not refer\n"
-                "to the same file (the program cannot edit an image file "
-                "\"in place\").\n"
+                "the result in outfile.  The pixel data are copied without\n"
+                "being uncompressed.  Infile and outfile may refer to the\n"
+                "same file; if the new headers are exactly as large as the\n"
+                "old ones, only the headers are rewritten.\n"
                 "\n"
                 "Command for selecting headers:\n"
                 "\n"
@@ -203,6 +192,8 @@ usageMessage (const char argv0[], bool verbose = false)
                 "\n"
                 "Other Commands:\n"
                 "\n"
+                "  -v        verbose mode\n"
+                "\n"
                 "  -h        prints this message\n";
 
         cerr << endl;
@@ -601,8 +592,9 @@ main (int argc, char** argv)
         const char* outFileName = 0;
 
         SetAttrVector attrs;
-        int           part = -1;
-        int           i    = 1;
+        int           part    = -1;
+        bool          verbose = false;
+        int           i       = 1;
 
         while (i < argc)
         {
@@ -724,6 +716,11 @@ main (int argc, char** argv)
             {
                 getNameAndInt (argc, argv, i, part, attrs);
             }
+            else if (!strcmp (argv[i], "-v"))
+            {
+                verbose = true;
+                i += 1;
+            }
             else if (!strcmp (argv[i], "-h"))
             {
                 usageMessage (argv[0], true);
@@ -741,24 +738,25 @@ main (int argc, char** argv)
 
         if (inFileName == 0 || outFileName == 0) usageMessage (argv[0]);
 
-        if (!strcmp (inFileName, outFileName))
-        {
-            cerr << "Input and output cannot be the same file." << endl;
-            return 1;
-        }
-
         //
         // Load the headers from the input file
         // and add attributes to the headers.
         //
 
-        MultiPartInputFile in (inFileName);
-        int                numParts = in.parts ();
-        vector<Header>     headers;
+        vector<Header> headers;
+        int            numParts;
+
+        {
+            MultiPartInputFile in (inFileName);
+            numParts = in.parts ();
+
+            for (int part = 0; part < numParts; ++part)
+                headers.push_back (in.header (part));
+        }
 
         for (int part = 0; part < numParts; ++part)
         {
-            Header h = in.header (part);
+            Header& h = headers[part];
 
             for (size_t i = 0; i < attrs.size (); ++i)
             {
@@ -781,47 +779,22 @@ main (int argc, char** argv)
                     return 1;
                 }
             }
-
-            headers.push_back (h);
         }
 
         //
-        // Crete an output file with the modified headers,
-        // and copy the pixels from the input file to the
-        // output file.
+        // Store the modified headers, followed by the
+        // unmodified pixel data of the input file.
         //
 
-        MultiPartOutputFile out (outFileName, &headers[0], numParts);
-
-        for (int p = 0; p < numParts; ++p)
+        if (updateFileHeaders (inFileName, outFileName, &headers[0], numParts))
         {
-            const Header& h    = in.header (p);
-            const string& type = h.type ();
-
-            if (type == SCANLINEIMAGE)
-            {
-                InputPart  inPart (in, p);
-                OutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == TILEDIMAGE)
-            {
-                TiledInputPart  inPart (in, p);
-                TiledOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == DEEPSCANLINE)
-            {
-                DeepScanLineInputPart  inPart (in, p);
-                DeepScanLineOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == DEEPTILE)
-            {
-                DeepTiledInputPart  inPart (in, p);
-                DeepTiledOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
+            if (verbose) cout << "updated headers of " << inFileName << endl;
+        }
+        else
+        {
+            if (verbose)
+                cout << "copied " << inFileName << " to " << outFileName
+                     << endl;
         }
     }
     catch (const exception& e)
@@ -15,11 +15,21 @@
 #include "IlmThreadSemaphore.h"
 
 #include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
 using namespace std;
 
 ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -28,6 +38,64 @@ ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_ENTER
 #    define ENABLE_THREADING
 #endif
 
+namespace
+{
+
+//
+// The processors of a NUMA node, from the node's cpulist in sysfs,
+// which looks like "0-31,64-95".  Empty if the node does not exist or
+// the information is not available on this platform.
+//
+
+vector<int>
+nodeProcessors (int node)
+{
+    vector<int> cpus;
+
+#ifdef __linux__
+    if (node < 0) return cpus;
+
+    ifstream in (
+        "/sys/devices/system/node/node" + to_string (node) + "/cpulist");
+    string list;
+
+    if (!in || !getline (in, list)) return cpus;
+
+    size_t pos = 0;
+
+    while (pos < list.size ())
+    {
+        size_t end = list.find (',', pos);
+        if (end == string::npos) end = list.size ();
+
+        string range = list.substr (pos, end - pos);
+        size_t dash  = range.find ('-');
+
+        try
+        {
+            int first = stoi (range);
+            int last  = dash == string::npos ? first
+                                             : stoi (range.substr (dash + 1));
+
+            for (int c = first; c <= last; ++c)
+                cpus.push_back (c);
+        }
+        catch (...)
+        {
+            // ignore what we cannot parse, e.g. trailing whitespace
+        }
+
+        pos = end + 1;
+    }
+#else
+    (void) node;
+#endif
+
+    return cpus;
+}
+
+} // namespace
+
 #if defined(__GNU_LIBRARY__) &&                                                \
     (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 21))
 #    define ENABLE_SEM_DTOR_WORKAROUND
@@ -37,11 +105,12 @@ ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 struct TaskGroup::Data
 {
-    Data ();
+    Data (int priority);
     ~Data ();
 
     void             addTask ();
     void             removeTask ();
+    const int        priority;
     std::atomic<int> numPending;
     Semaphore        isEmpty; // used to signal that the taskgroup is empty
 #    if defined(ENABLE_SEM_DTOR_WORKAROUND)
@@ -112,6 +181,7 @@ struct ThreadPool::Data
 
     std::atomic<int>                 provUsers;
     std::atomic<ThreadPoolProvider*> provider;
+    std::atomic<int>                 node; // NUMA node of the threads, or -1
 };
 
 namespace
@@ -119,16 +189,24 @@ namespace
 
 class DefaultWorkerThread;
 
+//
+// The queued tasks, one FIFO per priority, highest priority first.
+//
+
+typedef map<int, deque<Task*>, greater<int>> TaskQueue;
+
 struct DefaultWorkData
 {
     Semaphore          taskSemaphore; // threads wait on this for ready tasks
     mutable std::mutex taskMutex;     // mutual exclusion for the tasks list
-    vector<Task*>      tasks;         // the list of tasks to execute
+    TaskQueue          tasks;         // the tasks to execute
 
     Semaphore threadSemaphore;      // signaled when a thread starts executing
     mutable std::mutex threadMutex; // mutual exclusion for threads list
     vector<DefaultWorkerThread*> threads; // the list of all threads
 
+    vector<int> processors; // where the threads may run, empty for anywhere
+
     std::atomic<bool> hasThreads;
     std::atomic<bool> stopping;
 
@@ -168,6 +246,25 @@ DefaultWorkerThread::run ()
 
     _data->threadSemaphore.post ();
 
+#    ifdef __linux__
+    //
+    // Bind the thread to the processors of the pool's NUMA node.
+    // Failure, for instance because the processors are outside
+    // the process's cpuset, leaves the thread unbound.
+    //
+
+    if (!_data->processors.empty ())
+    {
+        cpu_set_t set;
+        CPU_ZERO (&set);
+
+        for (int c: _data->processors)
+            if (c < CPU_SETSIZE) CPU_SET (c, &set);
+
+        pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+    }
+#    endif
+
     while (true)
     {
         //
@@ -180,13 +277,16 @@ DefaultWorkerThread::run ()
             std::unique_lock<std::mutex> taskLock (_data->taskMutex);
 
             //
-            // If there is a task pending, pop off the next task in the FIFO
+            // If there is a task pending, pop off the next task in the
+            // FIFO of the highest priority
             //
 
             if (!_data->tasks.empty ())
             {
-                Task* task = _data->tasks.back ();
-                _data->tasks.pop_back ();
+                TaskQueue::iterator level = _data->tasks.begin ();
+                Task*               task  = level->second.front ();
+                level->second.pop_front ();
+                if (level->second.empty ()) _data->tasks.erase (level);
                 // release the mutex while we process
                 taskLock.unlock ();
 
@@ -211,7 +311,7 @@ DefaultWorkerThread::run ()
 class DefaultThreadPoolProvider : public ThreadPoolProvider
 {
 public:
-    DefaultThreadPoolProvider (int count);
+    DefaultThreadPoolProvider (int count, int node);
     virtual ~DefaultThreadPoolProvider ();
 
     virtual int  numThreads () const;
@@ -224,8 +324,9 @@ private:
     DefaultWorkData _data;
 };
 
-DefaultThreadPoolProvider::DefaultThreadPoolProvider (int count)
+DefaultThreadPoolProvider::DefaultThreadPoolProvider (int count, int node)
 {
+    _data.processors = nodeProcessors (node);
     setNumThreads (count);
 }
 
@@ -297,9 +398,9 @@ DefaultThreadPoolProvider::addTask (Task* task)
             std::lock_guard<std::mutex> taskLock (_data.taskMutex);
 
             //
-            // Push the new task into the FIFO
+            // Push the new task into the FIFO of its group's priority
             //
-            _data.tasks.push_back (task);
+            _data.tasks[task->group ()->priority ()].push_back (task);
         }
 
         //
@@ -381,7 +482,7 @@ class NullThreadPoolProvider : public ThreadPoolProvider
 // struct TaskGroup::Data
 //
 
-TaskGroup::Data::Data () : numPending (0), isEmpty (1)
+TaskGroup::Data::Data (int p) : priority (p), numPending (0), isEmpty (1)
 {
     // empty
 }
@@ -458,7 +559,7 @@ TaskGroup::Data::removeTask ()
 // struct ThreadPool::Data
 //
 
-ThreadPool::Data::Data () : provUsers (0), provider (NULL)
+ThreadPool::Data::Data () : provUsers (0), provider (NULL), node (-1)
 {
     // empty
 }
@@ -568,7 +669,7 @@ Task::group ()
 TaskGroup::TaskGroup ()
     :
 #ifdef ENABLE_THREADING
-    _data (new Data ())
+    _data (new Data (TASK_PRIORITY_NORMAL))
 #else
     _data (nullptr)
 #endif
@@ -576,6 +677,17 @@ TaskGroup::TaskGroup ()
     // empty
 }
 
+TaskGroup::TaskGroup (int priority)
+    :
+#ifdef ENABLE_THREADING
+    _data (new Data (priority))
+#else
+    _data (nullptr)
+#endif
+{
+    (void) priority;
+}
+
 TaskGroup::~TaskGroup ()
 {
 #ifdef ENABLE_THREADING
@@ -591,6 +703,16 @@ TaskGroup::finishOneTask ()
 #endif
 }
 
+int
+TaskGroup::priority () const
+{
+#ifdef ENABLE_THREADING
+    return _data->priority;
+#else
+    return TASK_PRIORITY_NORMAL;
+#endif
+}
+
 //
 // class ThreadPoolProvider
 //
@@ -617,7 +739,28 @@ ThreadPool::ThreadPool (unsigned nthreads)
     if (nthreads == 0)
         _data->setProvider (new NullThreadPoolProvider);
     else
-        _data->setProvider (new DefaultThreadPoolProvider (int (nthreads)));
+        _data->setProvider (new DefaultThreadPoolProvider (int (nthreads), -1));
+#endif
+}
+
+ThreadPool::ThreadPool (unsigned nthreads, int node)
+    :
+#ifdef ENABLE_THREADING
+    _data (new Data)
+#else
+    _data (nullptr)
+#endif
+{
+#ifdef ENABLE_THREADING
+    if (!nodeProcessors (node).empty ()) _data->node = node;
+
+    if (nthreads == 0)
+        _data->setProvider (new NullThreadPoolProvider);
+    else
+        _data->setProvider (
+            new DefaultThreadPoolProvider (int (nthreads), _data->node));
+#else
+    (void) node;
 #endif
 }
 
@@ -673,7 +816,8 @@ ThreadPool::setNumThreads (int count)
         if (count == 0)
             _data->setProvider (new NullThreadPoolProvider);
         else
-            _data->setProvider (new DefaultThreadPoolProvider (count));
+            _data->setProvider (
+                new DefaultThreadPoolProvider (count, _data->node));
     }
 #else
     // just blindly ignore
@@ -681,10 +825,21 @@ ThreadPool::setNumThreads (int count)
 #endif
 }
 
+int
+ThreadPool::node () const
+{
+#ifdef ENABLE_THREADING
+    return _data->node;
+#else
+    return -1;
+#endif
+}
+
 void
 ThreadPool::setThreadProvider (ThreadPoolProvider* provider)
 {
 #ifdef ENABLE_THREADING
+    _data->node = -1;
     _data->setProvider (provider);
 #else
     throw IEX_INTERNAL_NAMESPACE::ArgExc (
@@ -722,6 +877,24 @@ ThreadPool::addGlobalTask (Task* task)
     globalThreadPool ().addTask (task);
 }
 
+ThreadPool&
+ThreadPool::nodeThreadPool (int node)
+{
+    static std::mutex                     poolsMutex;
+    static vector<unique_ptr<ThreadPool>> pools (numNodes ());
+
+    if (node < 0 || node >= int (pools.size ()))
+        throw IEX_INTERNAL_NAMESPACE::ArgExc (
+            "Attempt to get the thread pool of a nonexistent NUMA node.");
+
+    std::lock_guard<std::mutex> lock (poolsMutex);
+
+    if (!pools[node])
+        pools[node].reset (new ThreadPool (numNodeProcessors (node), node));
+
+    return *pools[node];
+}
+
 unsigned
 ThreadPool::estimateThreadCountForFileIO ()
 {
@@ -732,4 +905,27 @@ ThreadPool::estimateThreadCountForFileIO ()
 #endif
 }
 
+int
+ThreadPool::numNodes ()
+{
+    int n = 0;
+
+    while (!nodeProcessors (n).empty ())
+        ++n;
+
+    return n > 0 ? n : 1;
+}
+
+unsigned
+ThreadPool::numNodeProcessors (int node)
+{
+    vector<int> cpus = nodeProcessors (node);
+
+    if (!cpus.empty ()) return unsigned (cpus.size ());
+    if (node == 0 && numNodes () == 1)
+        return std::thread::hardware_concurrency ();
+
+    return 0;
+}
+
 ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -23,6 +23,19 @@
 //	single TaskGroup.  The destructor of the TaskGroup waits for all
 //	tasks in the group to finish.
 //
+//	A TaskGroup can be given a priority.  When worker threads pick
+//	the next task to execute, they take queued tasks of a higher
+//	priority before tasks of a lower priority; tasks of the same
+//	priority are executed in the order in which they were added.
+//	This lets an interactive read overtake background work that is
+//	already waiting in the queue, at the granularity of single tasks.
+//
+//	On machines with several NUMA nodes, a ThreadPool can be bound
+//	to one node: its worker threads then only run on the processors
+//	of that node, and memory they touch first is allocated there.
+//	An application can keep one pool per node and have each file
+//	use the pool of the node that should decode it.
+//
 //	Note: if you plan to use the ThreadPool interface in your own
 //	applications note that the implementation of the ThreadPool calls
 //	operator delete on tasks as they complete.  If you define a custom
@@ -40,11 +53,27 @@ ILMTHREAD_INTERNAL_NAMESPACE_HEADER_ENTER
 class TaskGroup;
 class Task;
 
+//-------------------------------------------------------
+// Suggested task priorities.  Any int may be used; larger
+// values are executed first.
+//-------------------------------------------------------
+
+enum TaskPriority
+{
+    TASK_PRIORITY_BACKGROUND  = -100,
+    TASK_PRIORITY_NORMAL      = 0,
+    TASK_PRIORITY_INTERACTIVE = 100
+};
+
 //-------------------------------------------------------
 // ThreadPoolProvider -- this is a pure virtual interface
 // enabling custom overloading of the threads used and how
 // the implementation of the processing of tasks
 // is implemented
+//
+// A provider that supports priorities should consult
+// task->group()->priority() in addTask(); providers that
+// ignore it remain correct, just without preemption.
 //-------------------------------------------------------
 class ILMTHREAD_EXPORT_TYPE ThreadPoolProvider
 {
@@ -87,6 +116,19 @@ public:
     ILMTHREAD_EXPORT
     static unsigned estimateThreadCountForFileIO ();
 
+    //-------------------------------------------------------
+    // The number of NUMA nodes of the machine, and the number
+    // of processors of one node.  Where this information is
+    // not available, the machine is reported as a single node
+    // with hardware_concurrency() processors.
+    //-------------------------------------------------------
+
+    ILMTHREAD_EXPORT
+    static int numNodes ();
+
+    ILMTHREAD_EXPORT
+    static unsigned numNodeProcessors (int node);
+
     //-------------------------------------------------------
     // Constructor -- creates numThreads worker threads which
     // wait until a task is available,
@@ -95,6 +137,15 @@ public:
 
     ILMTHREAD_EXPORT ThreadPool (unsigned numThreads = 0);
 
+    //-------------------------------------------------------
+    // Constructor -- as above, but the worker threads only
+    // run on the processors of the given NUMA node.  A node
+    // of -1, or one that does not exist, leaves the threads
+    // unbound.
+    //-------------------------------------------------------
+
+    ILMTHREAD_EXPORT ThreadPool (unsigned numThreads, int node);
+
     //-----------------------------------------------------------
     // Destructor -- waits for all tasks to complete, joins all
     // the threads to the calling thread, and then destroys them.
@@ -117,6 +168,14 @@ public:
     ILMTHREAD_EXPORT int  numThreads () const;
     ILMTHREAD_EXPORT void setNumThreads (int count);
 
+    //--------------------------------------------------------
+    // The NUMA node the worker threads are bound to, or -1.
+    // A thread provider set with setThreadProvider() is not
+    // bound by the pool.
+    //--------------------------------------------------------
+
+    ILMTHREAD_EXPORT int node () const;
+
     //--------------------------------------------------------
     // Set the thread provider for the pool.
     //
@@ -134,7 +193,8 @@ public:
     // Add a task for processing.  The ThreadPool can handle any
     // number of tasks regardless of the number of worker threads.
     // The tasks are first added onto a queue, and are executed
-    // by threads as they become available, in FIFO order.
+    // by threads as they become available, highest priority of
+    // their TaskGroup first, and in FIFO order within a priority.
     //------------------------------------------------------------
 
     ILMTHREAD_EXPORT void addTask (Task* task);
@@ -146,6 +206,14 @@ public:
     ILMTHREAD_EXPORT static ThreadPool& globalThreadPool ();
     ILMTHREAD_EXPORT static void        addGlobalTask (Task* task);
 
+    //-------------------------------------------------------
+    // A pool per NUMA node, created on first use with one
+    // worker thread per processor of the node.  Nodes outside
+    // [0, numNodes()) throw an ArgExc.
+    //-------------------------------------------------------
+
+    ILMTHREAD_EXPORT static ThreadPool& nodeThreadPool (int node);
+
     struct ILMTHREAD_HIDDEN Data;
 
 protected:
@@ -174,6 +242,7 @@ class ILMTHREAD_EXPORT_TYPE TaskGroup
 {
 public:
     ILMTHREAD_EXPORT TaskGroup ();
+    ILMTHREAD_EXPORT explicit TaskGroup (int priority);
     ILMTHREAD_EXPORT ~TaskGroup ();
 
     TaskGroup (const TaskGroup& other) = delete;
@@ -186,6 +255,10 @@ public:
     // as it finishes tasks
     ILMTHREAD_EXPORT void finishOneTask ();
 
+    // the priority of the tasks in the group, TASK_PRIORITY_NORMAL
+    // unless another priority was given to the constructor
+    ILMTHREAD_EXPORT int priority () const;
+
     struct ILMTHREAD_HIDDEN Data;
     Data* const             _data;
 };
@@ -62,7 +62,7 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 // ACES red, green, blue and white-point chromaticities.
 //
 
-const Chromaticities& acesChromaticities ();
+IMF_EXPORT const Chromaticities& acesChromaticities ();
 
 //
 // ACES output file.
@@ -73,6 +73,8 @@
 #include "ImfHeader.h"
 #include "ImfMisc.h"
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
+#include "ImfSystemSpecific.h"
 #include <Iex.h>
 #include <ImathBox.h>
 #include <ImathFun.h>
@@ -137,61 +139,53 @@ shiftAndRound (int x, int shift)
     return (x + a + b) >> shift;
 }
 
-int
-pack (
-    const unsigned short s[16],
-    unsigned char        b[14],
-    bool                 optFlatFields,
-    bool                 exactMax)
+const int bias = 0x20;
+
+inline void
+runningDifferences (const int d[16], int r[15])
 {
     //
-    // Pack a block of 4 by 4 16-bit pixels (32 bytes) into
-    // either 14 or 3 bytes.
+    // Convert the absolute differences, d[0] ... d[15], of a 4 by 4
+    // pixel block into biased running differences, r[0] ... r[14].
     //
 
-    //
-    // Integers s[0] ... s[15] represent floating-point numbers
-    // in what is essentially a sign-magnitude format.  Convert
-    // s[0] .. s[15] into a new set of integers, t[0] ... t[15],
-    // such that if t[i] is greater than t[j], the floating-point
-    // number that corresponds to s[i] is always greater than
-    // the floating-point number that corresponds to s[j].
-    //
-    // Also, replace any bit patterns that represent NaNs or
-    // infinities with bit patterns that represent floating-point
-    // zeroes.
-    //
-    //	bit pattern	floating-point		bit pattern
-    //	in s[i]		value			in t[i]
-    //
-    //  0x7fff		NAN			0x8000
-    //  0x7ffe		NAN			0x8000
-    //	  ...					  ...
-    //  0x7c01		NAN			0x8000
-    //  0x7c00		+infinity		0x8000
-    //  0x7bff		+HALF_MAX		0xfbff
-    //  0x7bfe					0xfbfe
-    //  0x7bfd					0xfbfd
-    //	  ...					  ...
-    //  0x0002		+2 * HALF_MIN		0x8002
-    //  0x0001		+HALF_MIN		0x8001
-    //  0x0000		+0.0			0x8000
-    //  0x8000		-0.0			0x7fff
-    //  0x8001		-HALF_MIN		0x7ffe
-    //  0x8002		-2 * HALF_MIN		0x7ffd
-    //	  ...					  ...
-    //  0xfbfd					0x0f02
-    //  0xfbfe					0x0401
-    //  0xfbff		-HALF_MAX		0x0400
-    //  0xfc00		-infinity		0x8000
-    //  0xfc01		NAN			0x8000
-    //	  ...					  ...
-    //  0xfffe		NAN			0x8000
-    //  0xffff		NAN			0x8000
-    //
+    r[0] = d[0] - d[4] + bias;
+    r[1] = d[4] - d[8] + bias;
+    r[2] = d[8] - d[12] + bias;
 
-    unsigned short t[16];
+    r[3] = d[0] - d[1] + bias;
+    r[4] = d[4] - d[5] + bias;
+    r[5] = d[8] - d[9] + bias;
+    r[6] = d[12] - d[13] + bias;
 
+    r[7]  = d[1] - d[2] + bias;
+    r[8]  = d[5] - d[6] + bias;
+    r[9]  = d[9] - d[10] + bias;
+    r[10] = d[13] - d[14] + bias;
+
+    r[11] = d[2] - d[3] + bias;
+    r[12] = d[6] - d[7] + bias;
+    r[13] = d[10] - d[11] + bias;
+    r[14] = d[14] - d[15] + bias;
+}
+
+//
+// Find a shift value such that after rounding off the rightmost
+// bits and shifting, all running differences between the pixels
+// of a block are between -32 and +31 (see pack(), below).
+// Returns the shift value; t[0] ... t[15], tMax, d[0] ... d[15],
+// rMin and rMax receive the values that pack() needs.
+//
+
+int
+roundDifferences_scalar (
+    const unsigned short s[16],
+    unsigned short       t[16],
+    unsigned short&      tMax,
+    int                  d[16],
+    int&                 rMin,
+    int&                 rMax)
+{
     for (int i = 0; i < 16; ++i)
     {
         if ((s[i] & 0x7c00) == 0x7c00)
@@ -206,7 +200,7 @@ pack (
     // Find the maximum, tMax, of t[0] ... t[15].
     //
 
-    unsigned short tMax = 0;
+    tMax = 0;
 
     for (int i = 0; i < 16; ++i)
         if (tMax < t[i]) tMax = t[i];
@@ -220,12 +214,7 @@ pack (
     //
 
     int shift = -1;
-    int d[16];
     int r[15];
-    int rMin;
-    int rMax;
-
-    const int bias = 0x20;
 
     do
     {
@@ -245,24 +234,7 @@ pack (
         // Convert d[0] .. d[15] into running differences
         //
 
-        r[0] = d[0] - d[4] + bias;
-        r[1] = d[4] - d[8] + bias;
-        r[2] = d[8] - d[12] + bias;
-
-        r[3] = d[0] - d[1] + bias;
-        r[4] = d[4] - d[5] + bias;
-        r[5] = d[8] - d[9] + bias;
-        r[6] = d[12] - d[13] + bias;
-
-        r[7]  = d[1] - d[2] + bias;
-        r[8]  = d[5] - d[6] + bias;
-        r[9]  = d[9] - d[10] + bias;
-        r[10] = d[13] - d[14] + bias;
-
-        r[11] = d[2] - d[3] + bias;
-        r[12] = d[6] - d[7] + bias;
-        r[13] = d[10] - d[11] + bias;
-        r[14] = d[14] - d[15] + bias;
+        runningDifferences (d, r);
 
         rMin = r[0];
         rMax = r[0];
@@ -275,6 +247,356 @@ pack (
         }
     } while (rMin < 0 || rMax > 0x3f);
 
+    return shift;
+}
+
+void
+unpack14_scalar (const unsigned char b[14], unsigned short s[16])
+{
+    //
+    // Unpack a 14-byte block into 4 by 4 16-bit pixels.
+    //
+
+#if defined(DEBUG)
+    assert (b[2] != 0xfc);
+#endif
+
+    s[0] = (b[0] << 8) | b[1];
+
+    unsigned short shift = (b[2] >> 2);
+    unsigned short bias  = (0x20u << shift);
+
+    s[4]  = s[0] + ((((b[2] << 4) | (b[3] >> 4)) & 0x3fu) << shift) - bias;
+    s[8]  = s[4] + ((((b[3] << 2) | (b[4] >> 6)) & 0x3fu) << shift) - bias;
+    s[12] = s[8] + ((b[4] & 0x3fu) << shift) - bias;
+
+    s[1]  = s[0] + ((unsigned int) (b[5] >> 2) << shift) - bias;
+    s[5]  = s[4] + ((((b[5] << 4) | (b[6] >> 4)) & 0x3fu) << shift) - bias;
+    s[9]  = s[8] + ((((b[6] << 2) | (b[7] >> 6)) & 0x3fu) << shift) - bias;
+    s[13] = s[12] + ((b[7] & 0x3fu) << shift) - bias;
+
+    s[2]  = s[1] + ((unsigned int) (b[8] >> 2) << shift) - bias;
+    s[6]  = s[5] + ((((b[8] << 4) | (b[9] >> 4)) & 0x3fu) << shift) - bias;
+    s[10] = s[9] + ((((b[9] << 2) | (b[10] >> 6)) & 0x3fu) << shift) - bias;
+    s[14] = s[13] + ((b[10] & 0x3fu) << shift) - bias;
+
+    s[3]  = s[2] + ((unsigned int) (b[11] >> 2) << shift) - bias;
+    s[7]  = s[6] + ((((b[11] << 4) | (b[12] >> 4)) & 0x3fu) << shift) - bias;
+    s[11] = s[10] + ((((b[12] << 2) | (b[13] >> 6)) & 0x3fu) << shift) - bias;
+    s[15] = s[14] + ((b[13] & 0x3fu) << shift) - bias;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (s[i] & 0x8000)
+            s[i] &= 0x7fff;
+        else
+            s[i] = ~s[i];
+    }
+}
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+
+//
+// SSE4.1 versions of roundDifferences() and unpack14().  They
+// perform the same integer operations as the scalar code, but
+// on all sixteen pixels of a block at once, so the compressed
+// and uncompressed pixel data are bit-for-bit identical to the
+// results of the scalar code.  They are compiled with a target
+// attribute, and B44Compressor::initializeFuncs() selects them
+// if the processor supports SSE4.1.
+//
+// A 4 by 4 pixel block fits in two registers with eight 16-bit
+// lanes each; each 64-bit half of a register holds one row.
+//
+
+__attribute__ ((target ("sse4.1"))) inline __m128i
+orderedBits (__m128i s)
+{
+    //
+    // Convert half bit patterns into the integers t described
+    // in pack(), below.
+    //
+
+    const __m128i sign    = _mm_set1_epi16 ((short) 0x8000);
+    const __m128i expMask = _mm_set1_epi16 (0x7c00);
+
+    __m128i special = _mm_cmpeq_epi16 (_mm_and_si128 (s, expMask), expMask);
+    __m128i t = _mm_xor_si128 (s, _mm_or_si128 (_mm_srai_epi16 (s, 15), sign));
+
+    return _mm_blendv_epi8 (t, sign, special);
+}
+
+__attribute__ ((target ("sse4.1"))) int
+roundDifferences_sse4 (
+    const unsigned short s[16],
+    unsigned short       t[16],
+    unsigned short&      tMax,
+    int                  d[16],
+    int&                 rMin,
+    int&                 rMax)
+{
+    __m128i t0 = orderedBits (_mm_loadu_si128 ((const __m128i*) s));
+    __m128i t1 = orderedBits (_mm_loadu_si128 ((const __m128i*) (s + 8)));
+
+    _mm_storeu_si128 ((__m128i*) t, t0);
+    _mm_storeu_si128 ((__m128i*) (t + 8), t1);
+
+    //
+    // _mm_minpos_epu16() finds the minimum of eight unsigned 16-bit
+    // integers; the maximum of t is the complement of the minimum
+    // of the complement of t.
+    //
+
+    const __m128i ones = _mm_set1_epi32 (-1);
+
+    __m128i notMax = _mm_xor_si128 (_mm_max_epu16 (t0, t1), ones);
+    tMax = (unsigned short) ~_mm_extract_epi16 (_mm_minpos_epu16 (notMax), 0);
+
+    //
+    // Twice the differences between tMax and t (see shiftAndRound()),
+    // one row of the block per register, in 32-bit lanes.
+    //
+
+    __m128i vMax = _mm_set1_epi16 ((short) tMax);
+    __m128i x0   = _mm_sub_epi16 (vMax, t0);
+    __m128i x1   = _mm_sub_epi16 (vMax, t1);
+    __m128i x[4];
+
+    x[0] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (x0), 1);
+    x[1] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (_mm_srli_si128 (x0, 8)), 1);
+    x[2] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (x1), 1);
+    x[3] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (_mm_srli_si128 (x1, 8)), 1);
+
+    const __m128i one  = _mm_set1_epi32 (1);
+    const __m128i zero = _mm_setzero_si128 ();
+
+    int     shift = -1;
+    __m128i dv[4];
+
+    do
+    {
+        shift += 1;
+
+        __m128i a     = _mm_set1_epi32 ((1 << shift) - 1);
+        __m128i count = _mm_cvtsi32_si128 (shift + 1);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i b = _mm_and_si128 (_mm_srl_epi32 (x[i], count), one);
+
+            dv[i] = _mm_srl_epi32 (
+                _mm_add_epi32 (_mm_add_epi32 (x[i], a), b), count);
+        }
+
+        //
+        // Differences between horizontally adjacent pixels (lane 3
+        // of each row is unused), and between vertically adjacent
+        // pixels in the first column (only lane 0 is used).  Unused
+        // lanes are set to zero, which is always in range.
+        //
+
+        __m128i minDiff = zero;
+        __m128i maxDiff = zero;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i h = _mm_blend_epi16 (
+                _mm_sub_epi32 (dv[i], _mm_srli_si128 (dv[i], 4)), zero, 0xc0);
+
+            minDiff = _mm_min_epi32 (minDiff, h);
+            maxDiff = _mm_max_epi32 (maxDiff, h);
+
+            if (i < 3)
+            {
+                __m128i v = _mm_blend_epi16 (
+                    _mm_sub_epi32 (dv[i], dv[i + 1]), zero, 0xfc);
+
+                minDiff = _mm_min_epi32 (minDiff, v);
+                maxDiff = _mm_max_epi32 (maxDiff, v);
+            }
+        }
+
+        minDiff = _mm_min_epi32 (minDiff, _mm_srli_si128 (minDiff, 8));
+        minDiff = _mm_min_epi32 (minDiff, _mm_srli_si128 (minDiff, 4));
+        maxDiff = _mm_max_epi32 (maxDiff, _mm_srli_si128 (maxDiff, 8));
+        maxDiff = _mm_max_epi32 (maxDiff, _mm_srli_si128 (maxDiff, 4));
+
+        rMin = _mm_cvtsi128_si32 (minDiff) + bias;
+        rMax = _mm_cvtsi128_si32 (maxDiff) + bias;
+    } while (rMin < 0 || rMax > 0x3f);
+
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_si128 ((__m128i*) (d + 4 * i), dv[i]);
+
+    return shift;
+}
+
+__attribute__ ((target ("sse4.1"))) void
+unpack14_sse4 (const unsigned char b[14], unsigned short s[16])
+{
+#if defined(DEBUG)
+    assert (b[2] != 0xfc);
+#endif
+
+    //
+    // Load the 14 input bytes without reading past the end of the
+    // block: bytes 0 to 7 go to positions 0 to 7, and bytes 6 to 13
+    // go to positions 8 to 15.
+    //
+
+    __m128i in = _mm_unpacklo_epi64 (
+        _mm_loadl_epi64 ((const __m128i*) b),
+        _mm_loadl_epi64 ((const __m128i*) (b + 6)));
+
+    //
+    // Move the big-endian 16-bit word that contains each 6-bit
+    // difference into the lane of the pixel that the difference
+    // belongs to; lane 0 receives t[0].  Then shift each word to
+    // the right, by multiplying it with a power of two and keeping
+    // the high 16 bits of the product, and mask off the difference.
+    //
+
+    const __m128i shuffle0 = _mm_setr_epi8 (
+        1, 0, 6, 5, 11, 10, 14, 13, 3, 2, 6, 5, 11, 10, 14, 13);
+
+    const __m128i shuffle1 = _mm_setr_epi8 (
+        4, 3, 7, 6, 12, 11, 15, 14, 5, 4, 10, 7, 13, 12, -128, 15);
+
+    const __m128i scale0 =
+        _mm_setr_epi16 (0, 64, 64, 64, 4096, 4096, 4096, 4096);
+
+    const __m128i scale1 =
+        _mm_setr_epi16 (1024, 1024, 1024, 1024, 256, 256, 256, 256);
+
+    const __m128i mask = _mm_set1_epi16 (0x3f);
+
+    __m128i w0 = _mm_shuffle_epi8 (in, shuffle0);
+    __m128i w1 = _mm_shuffle_epi8 (in, shuffle1);
+
+    __m128i s0 = _mm_and_si128 (_mm_mulhi_epu16 (w0, scale0), mask);
+    __m128i s1 = _mm_and_si128 (_mm_mulhi_epu16 (w1, scale1), mask);
+
+    //
+    // Scale and unbias the differences, and put t[0] in lane 0.
+    //
+
+    __m128i shift = _mm_cvtsi32_si128 (b[2] >> 2);
+    __m128i bias  = _mm_sll_epi16 (_mm_set1_epi16 (0x20), shift);
+
+    s0 = _mm_sub_epi16 (_mm_sll_epi16 (s0, shift), bias);
+    s1 = _mm_sub_epi16 (_mm_sll_epi16 (s1, shift), bias);
+    s0 = _mm_insert_epi16 (s0, _mm_extract_epi16 (w0, 0), 0);
+
+    //
+    // Running sums down the first column, t[0], t[4], t[8], t[12],
+    // then along each row.
+    //
+
+    const __m128i lane0 = _mm_setr_epi16 (-1, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i lane4 = _mm_setr_epi16 (0, 0, 0, 0, -1, 0, 0, 0);
+
+    s0 = _mm_add_epi16 (s0, _mm_slli_si128 (_mm_and_si128 (s0, lane0), 8));
+    s1 = _mm_add_epi16 (s1, _mm_srli_si128 (_mm_and_si128 (s0, lane4), 8));
+    s1 = _mm_add_epi16 (s1, _mm_slli_si128 (_mm_and_si128 (s1, lane0), 8));
+
+    s0 = _mm_add_epi16 (s0, _mm_slli_epi64 (s0, 16));
+    s0 = _mm_add_epi16 (s0, _mm_slli_epi64 (s0, 32));
+    s1 = _mm_add_epi16 (s1, _mm_slli_epi64 (s1, 16));
+    s1 = _mm_add_epi16 (s1, _mm_slli_epi64 (s1, 32));
+
+    //
+    // Convert t back to half bit patterns: t & 0x7fff if the sign
+    // bit of t is set, ~t otherwise.
+    //
+
+    const __m128i ones = _mm_set1_epi32 (-1);
+    const __m128i mag  = _mm_set1_epi16 (0x7fff);
+
+    s0 = _mm_xor_si128 (
+        _mm_xor_si128 (s0, ones), _mm_and_si128 (_mm_srai_epi16 (s0, 15), mag));
+
+    s1 = _mm_xor_si128 (
+        _mm_xor_si128 (s1, ones), _mm_and_si128 (_mm_srai_epi16 (s1, 15), mag));
+
+    _mm_storeu_si128 ((__m128i*) s, s0);
+    _mm_storeu_si128 ((__m128i*) (s + 8), s1);
+}
+
+#endif /* IMF_HAVE_X86_TARGET_ATTRIBUTE */
+
+//
+// Default to the scalar versions; initializeFuncs() may replace
+// them with vectorized versions.
+//
+
+auto roundDifferences = roundDifferences_scalar;
+auto unpack14         = unpack14_scalar;
+
+int
+pack (
+    const unsigned short s[16],
+    unsigned char        b[14],
+    bool                 optFlatFields,
+    bool                 exactMax)
+{
+    //
+    // Pack a block of 4 by 4 16-bit pixels (32 bytes) into
+    // either 14 or 3 bytes.
+    //
+
+    //
+    // Integers s[0] ... s[15] represent floating-point numbers
+    // in what is essentially a sign-magnitude format.  Convert
+    // s[0] .. s[15] into a new set of integers, t[0] ... t[15],
+    // such that if t[i] is greater than t[j], the floating-point
+    // number that corresponds to s[i] is always greater than
+    // the floating-point number that corresponds to s[j].
+    //
+    // Also, replace any bit patterns that represent NaNs or
+    // infinities with bit patterns that represent floating-point
+    // zeroes.
+    //
+    //	bit pattern	floating-point		bit pattern
+    //	in s[i]		value			in t[i]
+    //
+    //  0x7fff		NAN			0x8000
+    //  0x7ffe		NAN			0x8000
+    //	  ...					  ...
+    //  0x7c01		NAN			0x8000
+    //  0x7c00		+infinity		0x8000
+    //  0x7bff		+HALF_MAX		0xfbff
+    //  0x7bfe					0xfbfe
+    //  0x7bfd					0xfbfd
+    //	  ...					  ...
+    //  0x0002		+2 * HALF_MIN		0x8002
+    //  0x0001		+HALF_MIN		0x8001
+    //  0x0000		+0.0			0x8000
+    //  0x8000		-0.0			0x7fff
+    //  0x8001		-HALF_MIN		0x7ffe
+    //  0x8002		-2 * HALF_MIN		0x7ffd
+    //	  ...					  ...
+    //  0xfbfd					0x0f02
+    //  0xfbfe					0x0401
+    //  0xfbff		-HALF_MAX		0x0400
+    //  0xfc00		-infinity		0x8000
+    //  0xfc01		NAN			0x8000
+    //	  ...					  ...
+    //  0xfffe		NAN			0x8000
+    //  0xffff		NAN			0x8000
+    //
+
+    unsigned short t[16];
+    unsigned short tMax;
+
+    int d[16];
+    int r[15];
+    int rMin;
+    int rMax;
+
+    int shift = roundDifferences (s, t, tMax, d, rMin, rMax);
+
+    runningDifferences (d, r);
+
     if (rMin == bias && rMax == bias && optFlatFields)
     {
         //
@@ -327,50 +649,6 @@ pack (
     return 14;
 }
 
-inline void
-unpack14 (const unsigned char b[14], unsigned short s[16])
-{
-    //
-    // Unpack a 14-byte block into 4 by 4 16-bit pixels.
-    //
-
-#if defined(DEBUG)
-    assert (b[2] != 0xfc);
-#endif
-
-    s[0] = (b[0] << 8) | b[1];
-
-    unsigned short shift = (b[2] >> 2);
-    unsigned short bias  = (0x20u << shift);
-
-    s[4]  = s[0] + ((((b[2] << 4) | (b[3] >> 4)) & 0x3fu) << shift) - bias;
-    s[8]  = s[4] + ((((b[3] << 2) | (b[4] >> 6)) & 0x3fu) << shift) - bias;
-    s[12] = s[8] + ((b[4] & 0x3fu) << shift) - bias;
-
-    s[1]  = s[0] + ((unsigned int) (b[5] >> 2) << shift) - bias;
-    s[5]  = s[4] + ((((b[5] << 4) | (b[6] >> 4)) & 0x3fu) << shift) - bias;
-    s[9]  = s[8] + ((((b[6] << 2) | (b[7] >> 6)) & 0x3fu) << shift) - bias;
-    s[13] = s[12] + ((b[7] & 0x3fu) << shift) - bias;
-
-    s[2]  = s[1] + ((unsigned int) (b[8] >> 2) << shift) - bias;
-    s[6]  = s[5] + ((((b[8] << 4) | (b[9] >> 4)) & 0x3fu) << shift) - bias;
-    s[10] = s[9] + ((((b[9] << 2) | (b[10] >> 6)) & 0x3fu) << shift) - bias;
-    s[14] = s[13] + ((b[10] & 0x3fu) << shift) - bias;
-
-    s[3]  = s[2] + ((unsigned int) (b[11] >> 2) << shift) - bias;
-    s[7]  = s[6] + ((((b[11] << 4) | (b[12] >> 4)) & 0x3fu) << shift) - bias;
-    s[11] = s[10] + ((((b[12] << 2) | (b[13] >> 6)) & 0x3fu) << shift) - bias;
-    s[15] = s[14] + ((b[13] & 0x3fu) << shift) - bias;
-
-    for (int i = 0; i < 16; ++i)
-    {
-        if (s[i] & 0x8000)
-            s[i] &= 0x7fff;
-        else
-            s[i] = ~s[i];
-    }
-}
-
 inline void
 unpack3 (const unsigned char b[3], unsigned short s[16])
 {
@@ -993,4 +1271,18 @@ B44Compressor::uncompress (
     return static_cast<int> (outEnd - _outBuffer);
 }
 
+void
+B44Compressor::initializeFuncs ()
+{
+    CpuId cpuId;
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+    if (cpuId.sse4_1)
+    {
+        roundDifferences = roundDifferences_sse4;
+        unpack14         = unpack14_sse4;
+    }
+#endif
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
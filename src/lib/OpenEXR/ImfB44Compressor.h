@@ -56,6 +56,8 @@ public:
         IMATH_NAMESPACE::Box2i range,
         const char*&           outPtr);
 
+    static void initializeFuncs ();
+
 private:
     struct ChannelData;
 
@@ -40,7 +40,18 @@ ChannelList::insert (const char name[], const Channel& channel)
             IEX_NAMESPACE::ArgExc,
             "Image channel name cannot be an empty string.");
 
-    _map[name] = channel;
+    //
+    // Channels are usually inserted in sorted order, for example
+    // when a file's channel list is read; append those without
+    // searching the map.
+    //
+
+    Name key (name);
+
+    if (!_map.empty () && _map.rbegin ()->first < key)
+        _map.emplace_hint (_map.end (), key, channel);
+    else
+        _map[key] = channel;
 }
 
 void
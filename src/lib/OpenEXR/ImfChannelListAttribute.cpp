@@ -15,6 +15,10 @@
 
 #include "IexBaseExc.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #if defined(_MSC_VER)
 // suppress warning about non-exported base classes
 #    pragma warning(disable : 4251)
@@ -24,6 +28,7 @@
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 using namespace OPENEXR_IMF_INTERNAL_NAMESPACE;
+using std::vector;
 
 namespace
 {
@@ -42,6 +47,76 @@ checkIsNullTerminated (const char (&str)[N], const char* what)
     throw IEX_NAMESPACE::InputExc (s);
 }
 
+//
+// Values larger than this are read from the stream field by field.
+//
+
+const int MAX_BULK_READ_SIZE = 1 << 20;
+
+//
+// Read a Channel struct and add it to channels under the given name.
+//
+
+template <class S, class T>
+void
+readChannel (T& in, const char name[], ChannelList& channels)
+{
+    int  type;
+    bool pLinear;
+    int  xSampling;
+    int  ySampling;
+
+    Xdr::read<S> (in, type);
+    Xdr::read<S> (in, pLinear);
+    Xdr::skip<S> (in, 3);
+    Xdr::read<S> (in, xSampling);
+    Xdr::read<S> (in, ySampling);
+
+    //
+    // prevent invalid values being written to PixelType enum
+    // by forcing all unknown types to NUM_PIXELTYPES which is also an invalid
+    // pixel type, but can be used as a PixelType enum value
+    // (Header::sanityCheck will throw an exception when files with invalid PixelTypes are read)
+    //
+    if (type != OPENEXR_IMF_INTERNAL_NAMESPACE::UINT &&
+        type != OPENEXR_IMF_INTERNAL_NAMESPACE::HALF &&
+        type != OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+    {
+        type = OPENEXR_IMF_INTERNAL_NAMESPACE::NUM_PIXELTYPES;
+    }
+
+    channels.insert (
+        name, Channel (PixelType (type), xSampling, ySampling, pLinear));
+}
+
+//
+// Return the number of bytes taken by the channel list at the start
+// of buf, including the end of list marker, or 0 if the list does not
+// end within the first n bytes or contains a name that is too long.
+//
+
+size_t
+channelListSize (const char buf[], size_t n)
+{
+    size_t i = 0;
+
+    while (i < n)
+    {
+        const char* end = static_cast<const char*> (
+            memchr (buf + i, 0, std::min (n - i, size_t (Name::SIZE))));
+
+        if (!end) return 0;
+
+        size_t length = end - (buf + i);
+
+        if (length == 0) return i + 1;
+
+        i += length + 1 + 16; // name, terminator and Channel struct
+    }
+
+    return 0;
+}
+
 } // namespace
 
 template <>
@@ -86,49 +161,66 @@ template <>
 IMF_EXPORT void
 ChannelListAttribute::readValueFrom (IStream& is, int size, int version)
 {
-    while (true)
+    //
+    // Reading the list one field at a time costs a virtual stream
+    // call per name character, which dominates opening files with
+    // many channels.  If the value fits in a reasonably sized buffer,
+    // read it at once and parse it from memory.
+    //
+
+    if (size > 0 && size <= MAX_BULK_READ_SIZE)
     {
         //
-        // Read name; zero length name means end of channel list
+        // As with other attribute types, a value that reaches
+        // past the end of the file is an error.
         //
 
-        char name[Name::SIZE];
-        Xdr::read<StreamIO> (is, Name::MAX_LENGTH, name);
+        vector<char> buf (size);
+        is.read (&buf[0], size);
 
-        if (name[0] == 0) break;
+        size_t n = channelListSize (&buf[0], size);
 
-        checkIsNullTerminated (name, "channel name");
+        if (n != size_t (size))
+        {
+            //
+            // The size field does not match the list.  Go back to
+            // the end of the list, or to its start if it does not
+            // end within size bytes, as the field by field loop
+            // below would.
+            //
+
+            is.seekg (is.tellg () - (size - n));
+        }
 
-        //
-        // Read Channel struct
-        //
+        if (n > 0)
+        {
+            const char* p = &buf[0];
 
-        int  type;
-        bool pLinear;
-        int  xSampling;
-        int  ySampling;
+            while (*p)
+            {
+                const char* name = p;
+                p += strlen (name) + 1;
+                readChannel<CharPtrIO> (p, name, _value);
+            }
 
-        Xdr::read<StreamIO> (is, type);
-        Xdr::read<StreamIO> (is, pLinear);
-        Xdr::skip<StreamIO> (is, 3);
-        Xdr::read<StreamIO> (is, xSampling);
-        Xdr::read<StreamIO> (is, ySampling);
+            return;
+        }
+    }
 
+    while (true)
+    {
         //
-        // prevent invalid values being written to PixelType enum
-        // by forcing all unknown types to NUM_PIXELTYPES which is also an invalid
-        // pixel type, but can be used as a PixelType enum value
-        // (Header::sanityCheck will throw an exception when files with invalid PixelTypes are read)
+        // Read name; zero length name means end of channel list
         //
-        if (type != OPENEXR_IMF_INTERNAL_NAMESPACE::UINT &&
-            type != OPENEXR_IMF_INTERNAL_NAMESPACE::HALF &&
-            type != OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
-        {
-            type = OPENEXR_IMF_INTERNAL_NAMESPACE::NUM_PIXELTYPES;
-        }
 
-        _value.insert (
-            name, Channel (PixelType (type), xSampling, ySampling, pLinear));
+        char name[Name::SIZE];
+        Xdr::read<StreamIO> (is, Name::MAX_LENGTH, name);
+
+        if (name[0] == 0) break;
+
+        checkIsNullTerminated (name, "channel name");
+
+        readChannel<StreamIO> (is, name, _value);
     }
 }
 
@@ -34,6 +34,7 @@
 #include <assert.h>
 #include <fstream>
 #include <string>
+#include <string.h>
 #include <vector>
 
 #include "ImfNamespace.h"
@@ -1038,14 +1039,23 @@ DeepScanLineOutputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
     // is compatible with the image file header.
     //
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&             channels = _data->header.channels ();
+    DeepFrameBuffer::ConstIterator j        = frameBuffer.begin ();
+
+    //
+    // The channels and the slices are both sorted by name,
+    // so the slice for each channel is found in a single pass.
+    //
 
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        DeepFrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
 
-        if (j == frameBuffer.end ()) continue;
+        if (j == frameBuffer.end ()) break;
+
+        if (strcmp (j.name (), i.name ()) > 0) continue;
 
         if (i.channel ().type != j.slice ().type)
         {
@@ -1105,12 +1115,15 @@ DeepScanLineOutputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
 
     vector<OutSliceInfo*> slices;
 
+    j = frameBuffer.begin ();
+
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        DeepFrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
 
-        if (j == frameBuffer.end ())
+        if (j == frameBuffer.end () || strcmp (j.name (), i.name ()) > 0)
         {
             //
             // Channel i is not present in the frame buffer.
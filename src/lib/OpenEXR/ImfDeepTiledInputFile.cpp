@@ -1153,15 +1153,24 @@ DeepTiledInputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
     // compatible with the image file header.
     //
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&         channels = _data->header.channels ();
+    ChannelList::ConstIterator i        = channels.begin ();
+
+    //
+    // The slices and the channels are both sorted by name,
+    // so the channel for each slice is found in a single pass.
+    //
 
     for (DeepFrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
          ++j)
     {
-        ChannelList::ConstIterator i = channels.find (j.name ());
+        while (i != channels.end () && strcmp (i.name (), j.name ()) < 0)
+            ++i;
+
+        if (i == channels.end ()) break;
 
-        if (i == channels.end ()) continue;
+        if (strcmp (i.name (), j.name ()) > 0) continue;
 
         if (i.channel ().xSampling != j.slice ().xSampling ||
             i.channel ().ySampling != j.slice ().ySampling)
@@ -1202,8 +1211,8 @@ DeepTiledInputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
     // Initialize the slice table for readPixels().
     //
 
-    vector<TInSliceInfo*>      slices;
-    ChannelList::ConstIterator i = channels.begin ();
+    vector<TInSliceInfo*> slices;
+    i = channels.begin ();
 
     for (DeepFrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
@@ -86,6 +86,9 @@ struct IMF_EXPORT_TYPE PreviewRgba;
 class IMF_EXPORT_TYPE OStream;
 class IMF_EXPORT_TYPE IStream;
 
+// statistics
+struct IMF_EXPORT_TYPE Statistics;
+
 class IMF_EXPORT_TYPE IDManifest;
 class IMF_EXPORT_TYPE CompressedIDManifest;
 
@@ -134,7 +134,18 @@ FrameBuffer::insert (const char name[], const Slice& slice)
             "Frame buffer slice name cannot be an empty string.");
     }
 
-    _map[name] = slice;
+    //
+    // Slices are usually inserted in sorted order, for example
+    // when a frame buffer is built from a file's channel list;
+    // append those without searching the map.
+    //
+
+    Name key (name);
+
+    if (!_map.empty () && _map.rbegin ()->first < key)
+        _map.emplace_hint (_map.end (), key, slice);
+    else
+        _map[key] = slice;
 }
 
 void
@@ -11,6 +11,7 @@
 
 #include "Iex.h"
 #include <IlmThreadConfig.h>
+#include <ImfB44Compressor.h>
 #include <ImfBoxAttribute.h>
 #include <ImfChannelListAttribute.h>
 #include <ImfChromaticitiesAttribute.h>
@@ -23,6 +24,7 @@
 #include <ImfFloatAttribute.h>
 #include <ImfFloatVectorAttribute.h>
 #include <ImfHeader.h>
+#include <ImfHeaderCacheLookup.h>
 #include <ImfIDManifestAttribute.h>
 #include <ImfIntAttribute.h>
 #include <ImfKeyCodeAttribute.h>
@@ -32,6 +34,7 @@
 #include <ImfOpaqueAttribute.h>
 #include <ImfPartType.h>
 #include <ImfPreviewImageAttribute.h>
+#include <ImfPxr24Compressor.h>
 #include <ImfRationalAttribute.h>
 #include <ImfStdIO.h>
 #include <ImfStringAttribute.h>
@@ -1354,11 +1357,25 @@ Header::writeTo (
 void
 Header::readFrom (OPENEXR_IMF_INTERNAL_NAMESPACE::IStream& is, int& version)
 {
+    //
+    // If the header is the same as one that has been read before,
+    // copy the attributes from the earlier header.
+    //
+
+    HeaderCacheLookup cached (is, version);
+
+    if (cached.find (*this))
+    {
+        _readsNothing = false;
+        return;
+    }
+
     //
     // Read all attributes.
     //
 
-    int attrCount = 0;
+    int            attrCount = 0;
+    vector<string> names;
 
     while (true)
     {
@@ -1378,11 +1395,16 @@ Header::readFrom (OPENEXR_IMF_INTERNAL_NAMESPACE::IStream& is, int& version)
                 _readsNothing = true;
             else
                 _readsNothing = false;
+
+            if (attrCount > 0) cached.insert (*this, names);
+
             break;
         }
 
         attrCount++;
 
+        if (cached.enabled ()) names.push_back (name);
+
         checkIsNullTerminated (name, "attribute name");
 
         //
@@ -1509,6 +1531,8 @@ staticInitialize ()
 
         DwaCompressor::initializeFuncs ();
         Zip::initializeFuncs ();
+        Pxr24Compressor::initializeFuncs ();
+        B44Compressor::initializeFuncs ();
 
         initialized = true;
     }
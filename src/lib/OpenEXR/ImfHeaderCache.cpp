@@ -0,0 +1,317 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	Reuse of headers across files
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfHeaderCache.h"
+#include "ImfHeaderCacheLookup.h"
+
+#include "ImfHeader.h"
+#include "ImfIO.h"
+#include "ImfOpaqueAttribute.h"
+
+#include <IlmThreadConfig.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#if ILMTHREAD_THREADING_ENABLED
+#    include <mutex>
+#endif
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+const int    DEFAULT_CACHE_SIZE = 0; // disabled
+const size_t MAX_HEADER_SIZE    = 1 << 20;
+const size_t COMPARE_BLOCK_SIZE = 256;
+
+struct Entry
+{
+    int            version;
+    string         bytes; // the header as stored in the file
+    Header         header;
+    vector<string> names; // the attributes that were read from the file
+};
+
+typedef std::shared_ptr<const Entry> EntryPtr;
+
+struct Cache
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex mutex;
+#endif
+    std::atomic<int>      size;
+    vector<EntryPtr>      entries; // most recently used first
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+
+    Cache () : size (DEFAULT_CACHE_SIZE), hits (0), misses (0) {}
+};
+
+Cache&
+cache ()
+{
+    static Cache c;
+    return c;
+}
+
+//
+// Moves an entry to the front of the cache, or inserts it there, and
+// removes the least recently used entries that do not fit.  The cache
+// must be locked.
+//
+
+void
+moveToFront (Cache& c, const EntryPtr& entry)
+{
+    vector<EntryPtr>::iterator i = c.entries.begin ();
+
+    while (i != c.entries.end () && *i != entry)
+        ++i;
+
+    if (i != c.entries.end ()) c.entries.erase (i);
+
+    c.entries.insert (c.entries.begin (), entry);
+
+    if (c.entries.size () > size_t (c.size)) c.entries.resize (c.size);
+}
+
+//
+// Checks that the attribute types of a cached header are still known
+// or unknown, as they were when the header was parsed.  Attributes of
+// unknown types are stored as OpaqueAttributes; registering or
+// unregistering a type changes how the header would be parsed now.
+//
+
+bool
+typesUnchanged (const Entry& e)
+{
+    for (size_t i = 0; i < e.names.size (); ++i)
+    {
+        const Attribute& attr = e.header[e.names[i]];
+        bool opaque = dynamic_cast<const OpaqueAttribute*> (&attr) != 0;
+
+        if (Attribute::knownType (attr.typeName ()) == opaque) return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+void
+setHeaderCacheSize (int numHeaders)
+{
+    Cache& c = cache ();
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (c.mutex);
+#endif
+
+    c.size = numHeaders < 0 ? 0 : numHeaders;
+
+    if (c.entries.size () > size_t (c.size)) c.entries.resize (c.size);
+}
+
+int
+headerCacheSize ()
+{
+    return cache ().size;
+}
+
+void
+clearHeaderCache ()
+{
+    Cache& c = cache ();
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (c.mutex);
+#endif
+
+    c.entries.clear ();
+}
+
+HeaderCacheStatistics
+headerCacheStatistics ()
+{
+    HeaderCacheStatistics s;
+    s.hits   = cache ().hits;
+    s.misses = cache ().misses;
+    return s;
+}
+
+void
+resetHeaderCacheStatistics ()
+{
+    cache ().hits   = 0;
+    cache ().misses = 0;
+}
+
+HeaderCacheLookup::HeaderCacheLookup (IStream& is, int version)
+    : _is (is)
+    , _version (version)
+    , _enabled (cache ().size > 0)
+    , _atEnd (false)
+    , _start (0)
+{
+    if (_enabled) _start = _is.tellg ();
+}
+
+bool
+HeaderCacheLookup::readBytes (size_t n)
+{
+    if (_bytes.size () >= n) return true;
+    if (_atEnd) return false;
+
+    size_t old = _bytes.size ();
+    _bytes.resize (n);
+
+    try
+    {
+        _is.read (&_bytes[old], int (n - old));
+    }
+    catch (...)
+    {
+        //
+        // The stream ends before n bytes.
+        //
+
+        _is.clear ();
+        _bytes.resize (old);
+        _atEnd = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+HeaderCacheLookup::matches (const string& bytes)
+{
+    //
+    // Compare block by block, so that only a little more of the
+    // stream is read than the part that matches.
+    //
+
+    for (size_t i = 0; i < bytes.size (); i += COMPARE_BLOCK_SIZE)
+    {
+        size_t n = std::min (bytes.size () - i, COMPARE_BLOCK_SIZE);
+
+        if (!readBytes (i + n) || memcmp (&_bytes[i], &bytes[i], n))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+HeaderCacheLookup::find (Header& header)
+{
+    if (!_enabled) return false;
+
+    Cache&           c = cache ();
+    vector<EntryPtr> candidates;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (c.mutex);
+#endif
+        for (size_t i = 0; i < c.entries.size (); ++i)
+            if (c.entries[i]->version == _version)
+                candidates.push_back (c.entries[i]);
+    }
+
+    for (size_t i = 0; i < candidates.size (); ++i)
+    {
+        const Entry& e = *candidates[i];
+        size_t       n = e.bytes.size ();
+
+        if (!matches (e.bytes) || !typesUnchanged (e)) continue;
+
+        for (size_t j = 0; j < e.names.size (); ++j)
+            header.insert (e.names[j], e.header[e.names[j]]);
+
+        _is.seekg (_start + n);
+        ++c.hits;
+
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (c.mutex);
+#endif
+        moveToFront (c, candidates[i]);
+        return true;
+    }
+
+    if (!_bytes.empty () || _atEnd) _is.seekg (_start);
+
+    return false;
+}
+
+void
+HeaderCacheLookup::insert (const Header& header, const vector<string>& names)
+{
+    if (!_enabled) return;
+
+    Cache& c = cache ();
+    ++c.misses;
+
+    uint64_t end = _is.tellg ();
+    size_t   n   = size_t (end - _start);
+
+    if (n > MAX_HEADER_SIZE) return;
+
+    //
+    // Use the bytes that find() has read, if they cover the header;
+    // otherwise read the header again.
+    //
+
+    std::shared_ptr<Entry> entry (new Entry);
+
+    if (_bytes.size () >= n)
+        entry->bytes.assign (_bytes, 0, n);
+    else
+    {
+        entry->bytes.resize (n);
+        _is.seekg (_start);
+        _is.read (&entry->bytes[0], int (n));
+    }
+
+    entry->version = _version;
+    entry->header  = header;
+    entry->names   = names;
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (c.mutex);
+#endif
+
+    //
+    // Replace any entry for the same bytes, which is out of date, or
+    // was added by another thread meanwhile.
+    //
+
+    for (size_t i = 0; i < c.entries.size (); ++i)
+    {
+        if (c.entries[i]->version == _version &&
+            c.entries[i]->bytes == entry->bytes)
+        {
+            c.entries.erase (c.entries.begin () + i);
+            break;
+        }
+    }
+
+    if (c.size > 0) moveToFront (c, entry);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
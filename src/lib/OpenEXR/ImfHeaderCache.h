@@ -0,0 +1,74 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_HEADER_CACHE_H
+#define INCLUDED_IMF_HEADER_CACHE_H
+
+//-----------------------------------------------------------------------------
+//
+//	Reuse of headers across files
+//
+//	The frames of an image sequence almost always have identical
+//	headers.  If enabled with setHeaderCacheSize(), Header::readFrom(),
+//	and therefore every input file class, keeps the most recently
+//	read headers in a process-wide cache, together with the bytes
+//	they were read from.  If the bytes at the start of the next
+//	header in a file are the same as those of a cached header, with
+//	the same file version flags, the attributes are copied from the
+//	cached header instead of being parsed again.  The result is the
+//	same either way.
+//
+//	The cache is disabled by default, and then costs nothing.  When
+//	it is enabled, looking up a header reads the stream a little
+//	beyond the point where the header stops matching a cached one,
+//	and a header that is not found is read from the stream again
+//	to be added to the cache.
+//
+//	The validation of the header by the input file classes, which
+//	depends on how the file is opened, is not skipped.  Headers
+//	larger than 1 MB, for example with large preview images, are
+//	not cached, so the cache holds at most numHeaders MB.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfExport.h"
+#include "ImfNamespace.h"
+
+#include <cstdint>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// The maximum number of headers in the cache.  The size is 0 by
+// default, which disables the cache; setting it back to 0 frees the
+// cached headers.
+//
+
+IMF_EXPORT void setHeaderCacheSize (int numHeaders);
+IMF_EXPORT int  headerCacheSize ();
+
+//
+// Remove all headers from the cache.
+//
+
+IMF_EXPORT void clearHeaderCache ();
+
+//
+// The number of headers that were copied from the cache, and the
+// number of headers that were parsed while the cache was enabled.
+//
+
+struct IMF_EXPORT_TYPE HeaderCacheStatistics
+{
+    uint64_t hits;
+    uint64_t misses;
+};
+
+IMF_EXPORT HeaderCacheStatistics headerCacheStatistics ();
+IMF_EXPORT void                  resetHeaderCacheStatistics ();
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,63 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_HEADER_CACHE_LOOKUP_H
+#define INCLUDED_IMF_HEADER_CACHE_LOOKUP_H
+
+//-----------------------------------------------------------------------------
+//
+//	class HeaderCacheLookup
+//
+//	The interface between Header::readFrom() and the header cache
+//	(see ImfHeaderCache.h).  A HeaderCacheLookup is created where a
+//	header starts in a stream.  find() compares the bytes in the
+//	stream with those of the cached headers; if one matches, find()
+//	copies its attributes into the header and leaves the stream at
+//	the end of the header.  Otherwise the stream is left where the
+//	header starts, and once the header has been parsed, insert()
+//	adds it to the cache.  While the cache is disabled, none of
+//	these functions access the stream.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class HeaderCacheLookup
+{
+public:
+    HeaderCacheLookup (IStream& is, int version);
+
+    bool enabled () const { return _enabled; }
+
+    bool find (Header& header);
+
+    //
+    // names are the names of the attributes that were read from
+    // the stream, in the order in which they were read.
+    //
+
+    void insert (const Header& header, const std::vector<std::string>& names);
+
+private:
+    bool readBytes (size_t n);
+    bool matches (const std::string& bytes);
+
+    IStream&    _is;
+    int         _version;
+    bool        _enabled;
+    bool        _atEnd; // the stream ended while find () read it
+    uint64_t    _start; // position of the header in the stream
+    std::string _bytes; // bytes read by find ()
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
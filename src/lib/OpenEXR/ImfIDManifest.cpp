@@ -13,11 +13,19 @@
 #include <ImfIDManifest.h>
 #include <zlib.h>
 
+#include "IlmThreadPool.h"
+#include <IlmThreadConfig.h>
+
 #include <algorithm>
+#include <atomic>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if ILMTHREAD_THREADING_ENABLED
+#    include <mutex>
+#endif
+
 //
 // debugging only
 //
@@ -28,6 +36,9 @@
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 using namespace OPENEXR_IMF_INTERNAL_NAMESPACE;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 using std::fill;
 using std::make_pair;
 using std::map;
@@ -299,15 +310,27 @@ writePascalString (char*& outPtr, const string& str)
     Xdr::write<CharPtrIO> ((char*&) outPtr, (const char*) str.c_str (), length);
 }
 
-} // namespace
-
-IDManifest::IDManifest (const char* data, const char* endOfData)
-{
-    init (data, endOfData);
-}
-
+//
+// parse a serialized manifest, passing its contents to 'builder',
+// which must provide:
+//
+//   void addGroups (int count)
+//   ChannelGroupManifest& group (int index)
+//       allocate the channel groups, and return a group to receive the
+//       header (channels, components and schemes) read from the manifest
+//   void beginTable (int group, int tableSize)
+//   void addEntry (int group, uint64_t id)
+//       start a new entry in the table. Throws if id is already present
+//   void setText (int group, size_t component, int index, const string& text)
+//       set a component of the last entry added: 'index' is the position
+//       of 'text' in the table of unique strings
+//   void finish (vector<string>& strings)
+//       called once the whole manifest has been read, with the table of
+//       unique strings. The builder may take the contents of 'strings'
+//
+template <class Builder>
 void
-IDManifest::init (const char* data, const char* endOfData)
+readManifest (const char* data, const char* endOfData, Builder& builder)
 {
 
     unsigned int version;
@@ -433,21 +456,27 @@ IDManifest::init (const char* data, const char* endOfData)
 
     Xdr::read<CharPtrIO> (data, manifestEntries);
 
-    _manifest.clear ();
+    if (manifestEntries < 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Bad number of groups in IDManifest");
+    }
 
-    _manifest.resize (manifestEntries);
+    builder.addGroups (manifestEntries);
 
     for (int manifestEntry = 0; manifestEntry < manifestEntries;
          ++manifestEntry)
     {
 
-        ChannelGroupManifest& m = _manifest[manifestEntry];
+        IDManifest::ChannelGroupManifest& m = builder.group (manifestEntry);
 
         //
         // read header of this manifest entry
         //
-        readStringList (data, endOfData, m._channels);
-        readStringList (data, endOfData, m._components);
+        readStringList (data, endOfData, m.getChannels ());
+
+        vector<string> components;
+        readStringList (data, endOfData, components);
+        m.setComponents (components);
 
         char lifetime;
         if (endOfData < data + 4)
@@ -456,9 +485,13 @@ IDManifest::init (const char* data, const char* endOfData)
         }
         Xdr::read<CharPtrIO> (data, lifetime);
 
-        m.setLifetime (IdLifetime (lifetime));
-        readPascalString (data, endOfData, m._hashScheme);
-        readPascalString (data, endOfData, m._encodingScheme);
+        m.setLifetime (IDManifest::IdLifetime (lifetime));
+
+        string scheme;
+        readPascalString (data, endOfData, scheme);
+        m.setHashScheme (scheme);
+        readPascalString (data, endOfData, scheme);
+        m.setEncodingScheme (scheme);
 
         if (endOfData < data + 5)
         {
@@ -470,6 +503,8 @@ IDManifest::init (const char* data, const char* endOfData)
         int tableSize;
         Xdr::read<CharPtrIO> (data, tableSize);
 
+        builder.beginTable (manifestEntry, tableSize);
+
         uint64_t previousId = 0;
 
         for (int entry = 0; entry < tableSize; ++entry)
@@ -504,30 +539,91 @@ IDManifest::init (const char* data, const char* endOfData)
             id += previousId;
             previousId = id;
 
-            //
-            // insert into table - insert tells us if it was already there
-            //
-            pair<map<uint64_t, vector<string>>::iterator, bool> insertion =
-                m._table.insert (make_pair (id, vector<string> ()));
-            if (insertion.second == false)
-            {
-                throw IEX_NAMESPACE::InputExc (
-                    "ID manifest contains multiple entries for the same ID");
-            }
-            (insertion.first)->second.resize (m.getComponents ().size ());
-            for (size_t i = 0; i < m.getComponents ().size (); ++i)
+            builder.addEntry (manifestEntry, id);
+
+            for (size_t i = 0; i < components.size (); ++i)
             {
                 int stringIndex = readVariableLengthInteger (data, endOfData);
-                if (size_t (stringIndex) > stringList.size () ||
+                if (size_t (stringIndex) >= stringList.size () ||
                     stringIndex < 0)
                 {
                     throw IEX_NAMESPACE::InputExc (
                         "Bad string index in IDManifest");
                 }
-                (insertion.first)->second[i] = stringList[mapping[stringIndex]];
+                int unique = mapping[stringIndex];
+                builder.setText (manifestEntry, i, unique, stringList[unique]);
             }
         }
     }
+
+    builder.finish (stringList);
+}
+
+//
+// builder for readManifest which fills in the std::map based
+// tables of an IDManifest
+//
+class ManifestBuilder
+{
+public:
+    ManifestBuilder (vector<IDManifest::ChannelGroupManifest>& manifest)
+        : _manifest (manifest)
+    {}
+
+    void addGroups (int count)
+    {
+        _manifest.clear ();
+        _manifest.resize (count);
+    }
+
+    IDManifest::ChannelGroupManifest& group (int index)
+    {
+        return _manifest[index];
+    }
+
+    void beginTable (int, int) {}
+
+    void addEntry (int group, uint64_t id)
+    {
+        IDManifest::ChannelGroupManifest& m    = _manifest[group];
+        size_t                            size = m.size ();
+
+        _entry = m.insert (id, vector<string> (m.getComponents ().size ()));
+
+        //
+        // insert tells us if it was already there
+        //
+        if (m.size () == size)
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "ID manifest contains multiple entries for the same ID");
+        }
+    }
+
+    void setText (int, size_t component, int, const string& text)
+    {
+        _entry.text ()[component] = text;
+    }
+
+    void finish (vector<string>&) {}
+
+private:
+    vector<IDManifest::ChannelGroupManifest>&  _manifest;
+    IDManifest::ChannelGroupManifest::Iterator _entry;
+};
+
+} // namespace
+
+IDManifest::IDManifest (const char* data, const char* endOfData)
+{
+    init (data, endOfData);
+}
+
+void
+IDManifest::init (const char* data, const char* endOfData)
+{
+    ManifestBuilder builder (_manifest);
+    readManifest (data, endOfData, builder);
 }
 
 IDManifest::IDManifest (const CompressedIDManifest& compressed)
@@ -1645,4 +1741,503 @@ IDManifest::MurmurHash64 (const vector<string>& idString)
     return MurmurHash64 (str);
 }
 
+namespace
+{
+
+void
+hashStrings (const std::string* idStrings, size_t count, unsigned int* hashes)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        MurmurHash3_x86_32 (
+            idStrings[i].c_str (), idStrings[i].size (), 0, &hashes[i]);
+    }
+}
+
+void
+hashStrings (const std::string* idStrings, size_t count, uint64_t* hashes)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t out[2];
+        MurmurHash3_x64_128 (
+            idStrings[i].c_str (), idStrings[i].size (), 0, out);
+        hashes[i] = out[0];
+    }
+}
+
+//
+// number of strings hashed by each task of a batch
+//
+const size_t hashBatchSize = 4096;
+
+template <class T>
+class HashBatchTask : public Task
+{
+public:
+    HashBatchTask (
+        TaskGroup* group, const std::string* idStrings, size_t count, T* hashes)
+        : Task (group), _idStrings (idStrings), _count (count), _hashes (hashes)
+    {}
+
+    void execute () override { hashStrings (_idStrings, _count, _hashes); }
+
+private:
+    const std::string* _idStrings;
+    size_t             _count;
+    T*                 _hashes;
+};
+
+template <class T>
+void
+hashBatch (const std::string* idStrings, size_t count, T* hashes)
+{
+    if (count <= hashBatchSize)
+    {
+        hashStrings (idStrings, count, hashes);
+        return;
+    }
+
+    TaskGroup group;
+    for (size_t first = 0; first < count; first += hashBatchSize)
+    {
+        ThreadPool::addGlobalTask (new HashBatchTask<T> (
+            &group,
+            idStrings + first,
+            std::min (hashBatchSize, count - first),
+            hashes + first));
+    }
+}
+
+} // namespace
+
+void
+IDManifest::MurmurHash32 (
+    const std::string* idStrings, size_t count, unsigned int* hashes)
+{
+    hashBatch (idStrings, count, hashes);
+}
+
+void
+IDManifest::MurmurHash64 (
+    const std::string* idStrings, size_t count, uint64_t* hashes)
+{
+    hashBatch (idStrings, count, hashes);
+}
+
+//
+// IDManifestLookup implementation
+//
+
+namespace
+{
+
+const uint32_t emptySlot = 0xffffffff;
+
+//
+// a channel group, with its entries stored in flat arrays
+//
+struct LookupGroup
+{
+    IDManifest::ChannelGroupManifest header;
+
+    vector<uint64_t> ids;   // id of each entry, in manifest order
+    vector<uint32_t> text;  // components of each entry, as indices into the
+                            // string table: ids.size() * components
+    vector<uint32_t> slots; // open addressed hash table of indices into ids
+    bool             duplicateIds;
+
+    LookupGroup () : duplicateIds (false) {}
+
+    size_t components () const { return header.getComponents ().size (); }
+
+    //
+    // build the hash table, with at most 50% of the slots occupied so
+    // that probe sequences stay short
+    //
+    void buildIndex ()
+    {
+        size_t tableSize = 16;
+        while (tableSize < ids.size () * 2)
+            tableSize *= 2;
+
+        slots.assign (tableSize, emptySlot);
+
+        size_t mask = tableSize - 1;
+        for (size_t e = 0; e < ids.size (); ++e)
+        {
+            size_t slot = fmix64 (ids[e]) & mask;
+            while (slots[slot] != emptySlot)
+            {
+                if (ids[slots[slot]] == ids[e])
+                {
+                    duplicateIds = true;
+                    return;
+                }
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = uint32_t (e);
+        }
+    }
+
+    // index of the entry for 'id', or emptySlot
+    uint32_t entry (uint64_t id) const
+    {
+        size_t mask = slots.size () - 1;
+        size_t slot = fmix64 (id) & mask;
+        while (slots[slot] != emptySlot)
+        {
+            if (ids[slots[slot]] == id) { return slots[slot]; }
+            slot = (slot + 1) & mask;
+        }
+        return emptySlot;
+    }
+};
+
+class IndexGroupTask : public Task
+{
+public:
+    IndexGroupTask (TaskGroup* group, LookupGroup& lookupGroup)
+        : Task (group), _lookupGroup (lookupGroup)
+    {}
+
+    void execute () override { _lookupGroup.buildIndex (); }
+
+private:
+    LookupGroup& _lookupGroup;
+};
+
+//
+// builder for readManifest which stores each channel group in flat
+// arrays, sharing the string table of the serialized manifest
+//
+class LookupBuilder
+{
+public:
+    LookupBuilder (vector<LookupGroup>& groups, vector<string>& strings)
+        : _groups (groups), _strings (strings)
+    {}
+
+    void addGroups (int count)
+    {
+        _groups.clear ();
+        _groups.resize (count);
+    }
+
+    IDManifest::ChannelGroupManifest& group (int index)
+    {
+        return _groups[index].header;
+    }
+
+    void beginTable (int group, int tableSize)
+    {
+        if (tableSize < 0)
+        {
+            throw IEX_NAMESPACE::InputExc ("Bad table size in IDManifest");
+        }
+        LookupGroup& g = _groups[group];
+        g.ids.reserve (tableSize);
+        g.text.reserve (size_t (tableSize) * g.components ());
+    }
+
+    void addEntry (int group, uint64_t id)
+    {
+        LookupGroup& g = _groups[group];
+        g.ids.push_back (id);
+        g.text.resize (g.ids.size () * g.components ());
+    }
+
+    void setText (int group, size_t component, int index, const string&)
+    {
+        LookupGroup& g = _groups[group];
+        g.text[(g.ids.size () - 1) * g.components () + component] = index;
+    }
+
+    void finish (vector<string>& strings) { _strings.swap (strings); }
+
+private:
+    vector<LookupGroup>& _groups;
+    vector<string>&      _strings;
+};
+
+} // namespace
+
+struct IDManifestLookup::Data
+{
+    CompressedIDManifest compressed;
+    std::atomic<bool>    decoded;
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex mutex;
+#endif
+
+    vector<string>      strings; // every distinct string in the manifest
+    vector<LookupGroup> groups;
+
+    Data () : decoded (false) {}
+
+    void decode ();
+    void index ();
+    void intern (const IDManifest& manifest);
+};
+
+void
+IDManifestLookup::Data::decode ()
+{
+    vector<Bytef> uncomp (compressed._uncompressedDataSize);
+    uLong outSize = static_cast<uLong> (compressed._uncompressedDataSize);
+    uLong inSize  = static_cast<uLong> (compressed._compressedDataSize);
+    if (Z_OK != ::uncompress (
+                    uncomp.data (),
+                    &outSize,
+                    reinterpret_cast<const Bytef*> (compressed._data),
+                    inSize))
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest decompression (zlib) failed.");
+    }
+    if (outSize != compressed._uncompressedDataSize)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest decompression (zlib) failed: mismatch in decompressed data size");
+    }
+
+    LookupBuilder builder (groups, strings);
+    readManifest (
+        (const char*) uncomp.data (),
+        (const char*) uncomp.data () + outSize,
+        builder);
+
+    index ();
+}
+
+void
+IDManifestLookup::Data::index ()
+{
+    //
+    // index each channel group in its own task
+    //
+    {
+        TaskGroup taskGroup;
+        for (size_t g = 0; g < groups.size (); ++g)
+        {
+            ThreadPool::addGlobalTask (
+                new IndexGroupTask (&taskGroup, groups[g]));
+        }
+    }
+
+    for (size_t g = 0; g < groups.size (); ++g)
+    {
+        if (groups[g].duplicateIds)
+        {
+            groups.clear ();
+            strings.clear ();
+            throw IEX_NAMESPACE::InputExc (
+                "ID manifest contains multiple entries for the same ID");
+        }
+    }
+}
+
+void
+IDManifestLookup::Data::intern (const IDManifest& manifest)
+{
+    indexedStringSet stringIndex;
+
+    groups.resize (manifest.size ());
+    for (size_t g = 0; g < manifest.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m = manifest[g];
+        LookupGroup&                            l = groups[g];
+
+        l.header.setChannels (m.getChannels ());
+        l.header.setComponents (m.getComponents ());
+        l.header.setLifetime (m.getLifetime ());
+        l.header.setHashScheme (m.getHashScheme ());
+        l.header.setEncodingScheme (m.getEncodingScheme ());
+
+        l.ids.reserve (m.size ());
+        l.text.reserve (m.size () * l.components ());
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i = m.begin ();
+             i != m.end ();
+             ++i)
+        {
+            l.ids.push_back (i.id ());
+            for (size_t c = 0; c < i.text ().size (); ++c)
+            {
+                pair<indexedStringSet::iterator, bool> insertion =
+                    stringIndex.insert (
+                        make_pair (i.text ()[c], int (strings.size ())));
+                if (insertion.second) { strings.push_back (i.text ()[c]); }
+                l.text.push_back (insertion.first->second);
+            }
+        }
+    }
+
+    index ();
+}
+
+IDManifestLookup::IDManifestLookup () : _data (new Data)
+{
+    _data->decoded = true;
+}
+
+IDManifestLookup::IDManifestLookup (const CompressedIDManifest& compressed)
+    : _data (new Data)
+{
+    _data->compressed = compressed;
+}
+
+IDManifestLookup::IDManifestLookup (const IDManifest& manifest)
+    : _data (new Data)
+{
+    _data->intern (manifest);
+    _data->decoded = true;
+}
+
+IDManifestLookup
+IDManifestLookup::shared (const CompressedIDManifest& compressed)
+{
+    typedef pair<size_t, uint64_t>                  Key;
+    typedef std::multimap<Key, std::weak_ptr<Data>> Cache;
+
+    static Cache cache;
+#if ILMTHREAD_THREADING_ENABLED
+    static std::mutex           cacheMutex;
+    std::lock_guard<std::mutex> lock (cacheMutex);
+#endif
+
+    uint64_t hash[2];
+    MurmurHash3_x64_128 (
+        compressed._data, compressed._compressedDataSize, 0, hash);
+    Key key (compressed._uncompressedDataSize, hash[0]);
+
+    IDManifestLookup lookup (compressed);
+    bool             found = false;
+
+    std::pair<Cache::iterator, Cache::iterator> range = cache.equal_range (key);
+
+    for (Cache::iterator i = range.first; i != range.second; ++i)
+    {
+        std::shared_ptr<Data> data = i->second.lock ();
+
+        if (data &&
+            data->compressed._compressedDataSize ==
+                compressed._compressedDataSize &&
+            memcmp (
+                data->compressed._data,
+                compressed._data,
+                compressed._compressedDataSize) == 0)
+        {
+            lookup._data = data;
+            found        = true;
+            break;
+        }
+    }
+
+    if (!found)
+    {
+        //
+        // remove the entries whose lookups have all been destroyed
+        // whenever the cache has doubled in size, so that the cost
+        // of the sweep is spread over the insertions
+        //
+        static size_t sweepSize = 16;
+
+        if (cache.size () >= sweepSize)
+        {
+            for (Cache::iterator i = cache.begin (); i != cache.end ();)
+            {
+                if (i->second.expired ())
+                    cache.erase (i++);
+                else
+                    ++i;
+            }
+            sweepSize = std::max (size_t (16), 2 * cache.size ());
+        }
+
+        cache.insert (make_pair (key, std::weak_ptr<Data> (lookup._data)));
+    }
+
+    return lookup;
+}
+
+const IDManifestLookup::Data&
+IDManifestLookup::decoded () const
+{
+    //
+    // only the first use takes the lock: once the tables are decoded
+    // they are never modified, and lookups just check the flag
+    //
+    if (!_data->decoded.load (std::memory_order_acquire))
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (_data->mutex);
+#endif
+        if (!_data->decoded.load (std::memory_order_relaxed))
+        {
+            _data->decode ();
+            _data->decoded.store (true, std::memory_order_release);
+        }
+    }
+    return *_data;
+}
+
+size_t
+IDManifestLookup::size () const
+{
+    return decoded ().groups.size ();
+}
+
+size_t
+IDManifestLookup::find (const string& channel) const
+{
+    const Data& data = decoded ();
+    for (size_t g = 0; g < data.groups.size (); ++g)
+    {
+        const set<string>& channels = data.groups[g].header.getChannels ();
+        if (channels.find (channel) != channels.end ()) { return g; }
+    }
+    return data.groups.size ();
+}
+
+const IDManifest::ChannelGroupManifest&
+IDManifestLookup::header (size_t group) const
+{
+    return decoded ().groups[group].header;
+}
+
+size_t
+IDManifestLookup::entries (size_t group) const
+{
+    return decoded ().groups[group].ids.size ();
+}
+
+size_t
+IDManifestLookup::uniqueStrings () const
+{
+    return decoded ().strings.size ();
+}
+
+bool
+IDManifestLookup::contains (size_t group, uint64_t idValue) const
+{
+    return decoded ().groups[group].entry (idValue) != emptySlot;
+}
+
+const std::string*
+IDManifestLookup::lookup (size_t group, uint64_t idValue, size_t component)
+    const
+{
+    const Data&        data = decoded ();
+    const LookupGroup& g    = data.groups[group];
+
+    if (component >= g.components ()) { return nullptr; }
+
+    uint32_t e = g.entry (idValue);
+    if (e == emptySlot) { return nullptr; }
+
+    return &data.strings[g.text[e * g.components () + component]];
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -13,6 +13,7 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -288,6 +289,18 @@ public:
     static uint64_t MurmurHash64 (const std::string& idString);
     IMF_EXPORT
     static uint64_t MurmurHash64 (const std::vector<std::string>& idString);
+
+    //
+    // hash 'count' strings into 'hashes' in one call, as used when building
+    // manifests at render time. Large batches are split across the global
+    // thread pool
+    //
+    IMF_EXPORT
+    static void MurmurHash32 (
+        const std::string* idStrings, size_t count, unsigned int* hashes);
+    IMF_EXPORT
+    static void MurmurHash64 (
+        const std::string* idStrings, size_t count, uint64_t* hashes);
 };
 
 //
@@ -319,6 +332,75 @@ public:
     unsigned char* _data;
 };
 
+//
+// Read-only view of a manifest optimized for ID lookups in large manifests
+//
+// The manifest is decompressed and parsed on first use rather than
+// on construction. Each channel group is indexed by an open-addressed
+// hash table, and every distinct string is stored only once, with entries
+// referring to strings by index. Copies of an IDManifestLookup share the
+// decoded tables, and are safe to use from multiple threads
+//
+class IMF_EXPORT_TYPE IDManifestLookup
+{
+public:
+    IMF_EXPORT
+    IDManifestLookup ();
+
+    IMF_EXPORT
+    explicit IDManifestLookup (const CompressedIDManifest& compressed);
+
+    IMF_EXPORT
+    explicit IDManifestLookup (const IDManifest& manifest);
+
+    //
+    // return a lookup for 'compressed' which shares its decoded tables
+    // with any existing lookup made from identical compressed data,
+    // for example the same manifest stored in each part of a multipart file
+    //
+    IMF_EXPORT
+    static IDManifestLookup shared (const CompressedIDManifest& compressed);
+
+    // number of channel groups in the manifest
+    IMF_EXPORT
+    size_t size () const;
+
+    // index of the first channel group which defines 'channel', or size()
+    IMF_EXPORT
+    size_t find (const std::string& channel) const;
+
+    // header of channel group 'group': channels, components and schemes
+    // (the returned ChannelGroupManifest contains no entries)
+    IMF_EXPORT
+    const IDManifest::ChannelGroupManifest& header (size_t group) const;
+
+    // number of entries in channel group 'group'
+    IMF_EXPORT
+    size_t entries (size_t group) const;
+
+    // number of distinct strings stored for the whole manifest
+    IMF_EXPORT
+    size_t uniqueStrings () const;
+
+    IMF_EXPORT
+    bool contains (size_t group, uint64_t idValue) const;
+
+    //
+    // text of 'component' of the entry for 'idValue' in channel group 'group',
+    // or a null pointer if there is no such entry
+    //
+    IMF_EXPORT
+    const std::string*
+    lookup (size_t group, uint64_t idValue, size_t component = 0) const;
+
+    struct IMF_HIDDEN Data;
+
+private:
+    std::shared_ptr<Data> _data;
+
+    IMF_HIDDEN const Data& decoded () const;
+};
+
 //
 // Read/Write Iterator object to access individual entries within a manifest
 //
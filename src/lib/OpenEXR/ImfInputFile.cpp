@@ -28,6 +28,7 @@
 #include "ImfDeepScanLineInputFile.h"
 
 #include "Iex.h"
+#include "IlmThreadPool.h"
 #include <ImathFun.h>
 #include <half.h>
 
@@ -36,6 +37,7 @@
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
+using ILMTHREAD_NAMESPACE::ThreadPool;
 using IMATH_NAMESPACE::Box2i;
 using IMATH_NAMESPACE::divp;
 using IMATH_NAMESPACE::modp;
@@ -70,6 +72,8 @@ struct InputFile::Data
     int offset;
 
     int numThreads;
+    int         taskPriority; // for deep files, which have no sFile or tFile
+    ThreadPool* threadPool;   // ditto
 
     int            partNumber;
     InputPartData* part;
@@ -99,6 +103,8 @@ InputFile::Data::Data (int numThreads)
     , compositor (0)
     , cachedTileY (-1)
     , numThreads (numThreads)
+    , taskPriority (ILMTHREAD_NAMESPACE::TASK_PRIORITY_NORMAL)
+    , threadPool (&ThreadPool::globalThreadPool ())
     , partNumber (-1)
     , part (NULL)
     , multiPartBackwardSupport (false)
@@ -254,9 +260,14 @@ bufferedReadPixels (InputFile::Data* ifd, int scanLine1, int scanLine2)
 
         //
         // Copy the data from our cached framebuffer into the user's
-        // framebuffer.
+        // framebuffer.  Both frame buffers are sorted by name, so
+        // the cached slice for each slice is found in a single pass.
         //
 
+        FrameBuffer::ConstIterator c;
+
+        if (ifd->cachedBuffer) c = ifd->cachedBuffer->begin ();
+
         for (FrameBuffer::ConstIterator k = ifd->tFileBuffer.begin ();
              k != ifd->tFileBuffer.end ();
              ++k)
@@ -274,10 +285,14 @@ bufferedReadPixels (InputFile::Data* ifd, int scanLine1, int scanLine2)
             while (modp (yStart, toSlice.ySampling) != 0)
                 ++yStart;
 
-            FrameBuffer::ConstIterator c = ifd->cachedBuffer->find (k.name ());
+            while (c != ifd->cachedBuffer->end () &&
+                   strcmp (c.name (), k.name ()) < 0)
+                ++c;
+
             intptr_t toBase = reinterpret_cast<intptr_t> (toSlice.base);
 
-            if (c != ifd->cachedBuffer->end ())
+            if (c != ifd->cachedBuffer->end () &&
+                strcmp (c.name (), k.name ()) == 0)
             {
                 //
                 // output channel was read from source image: copy to output slice
@@ -673,6 +688,12 @@ InputFile::initialize ()
 #include <iostream>
 InputFile::~InputFile ()
 {
+    //
+    // A read started with readPixelsAsync() uses the stream.
+    //
+
+    if (_data->sFile) _data->sFile->waitForPendingRead ();
+
     if (_data->_deleteStream) delete _data->_streamData->is;
 
     // unless this file was opened via the multipart API,
@@ -754,17 +775,23 @@ InputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
                 dataWindow.max.x - dataWindow.min.x + 1U,
                 _data->tFile->tileYSize ());
 
+            const ChannelList&         channels = _data->header.channels ();
+            ChannelList::ConstIterator c        = channels.begin ();
+
             for (FrameBuffer::ConstIterator k = frameBuffer.begin ();
                  k != frameBuffer.end ();
                  ++k)
             {
                 Slice s = k.slice ();
 
+                while (c != channels.end () &&
+                       strcmp (c.name (), k.name ()) < 0)
+                    ++c;
+
                 //
                 // omit adding channels that are not listed - 'fill' channels are added later
                 //
-                if (_data->header.channels ().find (k.name ()) !=
-                    _data->header.channels ().end ())
+                if (c != channels.end () && strcmp (c.name (), k.name ()) == 0)
                 {
                     switch (s.type)
                     {
@@ -836,8 +863,12 @@ InputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     }
     else
     {
+        //
+        // frameBuffer () returns the scan line file's copy,
+        // so there is no need to keep another one here.
+        //
+
         _data->sFile->setFrameBuffer (frameBuffer);
-        _data->tFileBuffer = frameBuffer;
     }
 }
 
@@ -905,6 +936,34 @@ InputFile::readPixels (int scanLine)
     readPixels (scanLine, scanLine);
 }
 
+std::future<void>
+InputFile::readPixelsAsync (
+    int scanLine1, int scanLine2, const ChunkCallback& callback)
+{
+    if (_data->sFile && !_data->compositor)
+        return _data->sFile->readPixelsAsync (scanLine1, scanLine2, callback);
+
+    std::promise<void> done;
+
+    try
+    {
+        readPixels (scanLine1, scanLine2);
+
+        if (callback)
+            callback (
+                std::min (scanLine1, scanLine2),
+                std::max (scanLine1, scanLine2));
+
+        done.set_value ();
+    }
+    catch (...)
+    {
+        done.set_exception (std::current_exception ());
+    }
+
+    return done.get_future ();
+}
+
 void
 InputFile::rawPixelData (
     int firstScanLine, const char*& pixelData, int& pixelDataSize)
@@ -997,6 +1056,50 @@ InputFile::rawTileData (
     }
 }
 
+Statistics
+InputFile::statistics () const
+{
+    //
+    // A scan line or tiled file that was opened without a
+    // MultiPartInputFile has its own stream and counters.
+    //
+
+    if (_data->sFile) return _data->sFile->statistics ();
+    if (_data->tFile) return _data->tFile->statistics ();
+
+    return _data->_streamData->statistics ();
+}
+
+void
+InputFile::setTaskPriority (int priority)
+{
+    _data->taskPriority = priority;
+
+    if (_data->sFile) _data->sFile->setTaskPriority (priority);
+    if (_data->tFile) _data->tFile->setTaskPriority (priority);
+}
+
+int
+InputFile::taskPriority () const
+{
+    return _data->taskPriority;
+}
+
+void
+InputFile::setThreadPool (ThreadPool* pool)
+{
+    _data->threadPool = pool ? pool : &ThreadPool::globalThreadPool ();
+
+    if (_data->sFile) _data->sFile->setThreadPool (pool);
+    if (_data->tFile) _data->tFile->setThreadPool (pool);
+}
+
+ThreadPool*
+InputFile::threadPool () const
+{
+    return _data->threadPool;
+}
+
 TiledInputFile*
 InputFile::tFile ()
 {
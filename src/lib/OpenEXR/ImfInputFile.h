@@ -18,6 +18,9 @@
 #include "ImfGenericInputFile.h"
 #include "ImfThreading.h"
 
+#include <functional>
+#include <future>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 class IMF_EXPORT_TYPE InputFile : public GenericInputFile
@@ -154,6 +157,27 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read pixel data without waiting for it:
+    //
+    // readPixelsAsync(s1,s2) reads the same scan lines as
+    // readPixels(s1,s2), but returns a future that becomes ready
+    // once the scan lines are in the frame buffer, and calls the
+    // callback, if any, with the y range of each chunk that has
+    // been read.  See ScanLineInputFile::readPixelsAsync() for the
+    // details.  Tiled and deep files are read before the function
+    // returns, and the callback is called once for the whole range.
+    //---------------------------------------------------------------
+
+    typedef std::function<void (int scanLineMin, int scanLineMax)>
+        ChunkCallback;
+
+    IMF_EXPORT
+    std::future<void> readPixelsAsync (
+        int                  scanLine1,
+        int                  scanLine2,
+        const ChunkCallback& callback = ChunkCallback ());
+
     //----------------------------------------------
     // Read a block of raw pixel data from the file,
     // without uncompressing it (this function is
@@ -199,6 +223,49 @@ public:
         const char*& pixelData,
         int&         pixelDataSize);
 
+    //---------------------------------------------------------
+    // Statistics about reading the file (see ImfStatistics.h).
+    // The counters are zero unless statistics were enabled
+    // when the file was opened.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    Statistics statistics () const;
+
+    //---------------------------------------------------------
+    // Priority of the thread pool tasks that readPixels() and
+    // readTiles() create for this file (see IlmThreadPool.h).
+    // Tasks of a file with a higher priority, for example
+    // IlmThread::TASK_PRIORITY_INTERACTIVE, are executed before
+    // queued tasks of files with a lower priority, such as
+    // frames that are being prefetched in the background.
+    // The default is IlmThread::TASK_PRIORITY_NORMAL.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setTaskPriority (int priority);
+
+    IMF_EXPORT
+    int taskPriority () const;
+
+    //---------------------------------------------------------
+    // The thread pool that runs the decoding tasks of this file,
+    // by default the global thread pool.  Passing a pool bound
+    // to a NUMA node (see IlmThreadPool.h) keeps the decoding on
+    // that node; the file's chunk buffers are then reallocated
+    // by the pool's threads, so that their memory is local to
+    // the node too.  A null pool selects the global pool again.
+    // The pool must outlive the reads of the file; to keep all
+    // of its threads busy, open the file with numThreads equal
+    // to the pool's numThreads().
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool);
+
+    IMF_EXPORT
+    ILMTHREAD_NAMESPACE::ThreadPool* threadPool () const;
+
     struct IMF_HIDDEN Data;
 
 private:
@@ -8,6 +8,7 @@
 
 #include "ImfInputFile.h"
 #include "ImfMultiPartInputFile.h"
+#include "ImfStatistics.h"
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
@@ -70,6 +71,13 @@ InputPart::readPixels (int scanLine)
     file->readPixels (scanLine);
 }
 
+std::future<void>
+InputPart::readPixelsAsync (
+    int scanLine1, int scanLine2, const ChunkCallback& callback)
+{
+    return file->readPixelsAsync (scanLine1, scanLine2, callback);
+}
+
 void
 InputPart::rawPixelData (
     int firstScanLine, const char*& pixelData, int& pixelDataSize)
@@ -96,4 +104,34 @@ InputPart::rawTileData (
     file->rawTileData (dx, dy, lx, ly, pixelData, pixelDataSize);
 }
 
+Statistics
+InputPart::statistics () const
+{
+    return file->statistics ();
+}
+
+void
+InputPart::setTaskPriority (int priority)
+{
+    file->setTaskPriority (priority);
+}
+
+int
+InputPart::taskPriority () const
+{
+    return file->taskPriority ();
+}
+
+void
+InputPart::setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool)
+{
+    file->setThreadPool (pool);
+}
+
+ILMTHREAD_NAMESPACE::ThreadPool*
+InputPart::threadPool () const
+{
+    return file->threadPool ();
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
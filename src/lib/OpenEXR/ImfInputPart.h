@@ -6,8 +6,12 @@
 #ifndef IMFINPUTPART_H_
 #define IMFINPUTPART_H_
 
+#include "IlmThreadForward.h"
 #include "ImfForward.h"
 
+#include <functional>
+#include <future>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 //-------------------------------------------------------------------
@@ -40,6 +44,15 @@ public:
     void readPixels (int scanLine1, int scanLine2);
     IMF_EXPORT
     void readPixels (int scanLine);
+
+    typedef std::function<void (int scanLineMin, int scanLineMax)>
+        ChunkCallback;
+
+    IMF_EXPORT
+    std::future<void> readPixelsAsync (
+        int                  scanLine1,
+        int                  scanLine2,
+        const ChunkCallback& callback = ChunkCallback ());
     IMF_EXPORT
     void rawPixelData (
         int firstScanLine, const char*& pixelData, int& pixelDataSize);
@@ -56,6 +69,16 @@ public:
         int&         ly,
         const char*& pixelData,
         int&         pixelDataSize);
+    IMF_EXPORT
+    Statistics statistics () const;
+    IMF_EXPORT
+    void setTaskPriority (int priority);
+    IMF_EXPORT
+    int taskPriority () const;
+    IMF_EXPORT
+    void setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool);
+    IMF_EXPORT
+    ILMTHREAD_NAMESPACE::ThreadPool* threadPool () const;
 
 private:
     InputFile* file;
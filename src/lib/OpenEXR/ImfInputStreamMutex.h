@@ -7,6 +7,7 @@
 #define IMFINPUTSTREAMMUTEX_H_
 
 #include "ImfForward.h"
+#include "ImfStatCounters.h"
 
 #include "IlmThreadConfig.h"
 
@@ -26,6 +27,20 @@ struct InputStreamMutex
 {
     OPENEXR_IMF_INTERNAL_NAMESPACE::IStream* is              = nullptr;
     uint64_t                                 currentPosition = 0;
+    StatCounters* stats; // null unless statistics are enabled
+
+    InputStreamMutex () : stats (newStatCounters ()) {}
+    ~InputStreamMutex () { delete stats; }
+
+    InputStreamMutex (const InputStreamMutex&)            = delete;
+    InputStreamMutex& operator= (const InputStreamMutex&) = delete;
+
+    Statistics statistics () const
+    {
+        Statistics s;
+        if (stats) stats->get (s);
+        return s;
+    }
 };
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
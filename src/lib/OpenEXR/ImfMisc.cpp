@@ -10,6 +10,7 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
 #include <Iex.h>
 #include <ImathFun.h>
 #include <ImfAttribute.h>
@@ -21,10 +22,20 @@
 #include <ImfPartType.h>
 #include <ImfStdIO.h>
 #include <ImfTileDescription.h>
+#include <ImfSystemSpecific.h>
 #include <ImfXdr.h>
 
 #include <codecvt>
+#include <cstring>
+#include <limits>
 #include <locale>
+#include <type_traits>
+
+//
+// The AVX, AVX2 and F16C row kernels are compiled with per-function
+// target attributes (IMF_HAVE_X86_TARGET_ATTRIBUTE in ImfSimd.h), so
+// that they need no special compiler flags, and are selected at run time.
+//
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
@@ -260,383 +271,623 @@ numLinesInBuffer (Compressor* compressor)
     return compressor ? compressor->numScanLines () : 1;
 }
 
-void
-copyIntoFrameBuffer (
-    const char*&       readPtr,
-    char*              writePtr,
-    char*              endPtr,
-    size_t             xStride,
-    bool               fill,
-    double             fillValue,
-    Compressor::Format format,
-    PixelType          typeInFrameBuffer,
-    PixelType          typeInFile)
+namespace
 {
+
+//
+// Row copy kernels for copyIntoFrameBuffer() and copyFromFrameBuffer().
+//
+// The kernels are generated from templates, one for every combination
+// of pixel data type in the frame buffer and in the file, line buffer
+// format, and stride class: "packed" kernels are used when the frame
+// buffer slice is tightly packed (xStride equals the size of a pixel),
+// which lets the compiler turn the loops into block copies or vector
+// code; "strided" kernels handle arbitrary strides.
+//
+// x and y sampling do not need separate kernels; by the time a row is
+// copied, the caller has already mapped the sampled pixels to writePtr
+// and endPtr.
+//
+
+inline size_t
+numPixelsInRow (const char* firstPtr, const char* lastPtr, size_t xStride)
+{
+    if (firstPtr > lastPtr) return 0;
+
     //
-    // Copy a horizontal row of pixels from an input
-    // file's line or tile buffer to a frame buffer.
+    // A zero xStride makes every pixel land in the same place; copy one.
     //
 
-    if (fill)
-    {
-        //
-        // The file contains no data for this channel.
-        // Store a default value in the frame buffer.
-        //
+    if (xStride == 0) return 1;
 
-        switch (typeInFrameBuffer)
-        {
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+    return size_t (lastPtr - firstPtr) / xStride + 1;
+}
 
-            {
-                unsigned int fillVal = (unsigned int) (fillValue);
+template <class T, bool Xdr>
+inline T
+readPixel (const char* readPtr)
+{
+    T value;
 
-                while (writePtr <= endPtr)
-                {
-                    *(unsigned int*) writePtr = fillVal;
-                    writePtr += xStride;
-                }
-            }
-            break;
+    if (Xdr)
+        Xdr::read<CharPtrIO> (readPtr, value);
+    else
+        memcpy (&value, readPtr, sizeof (T));
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+    return value;
+}
 
-            {
-                half fillVal = half (fillValue);
+template <class T, bool Xdr>
+inline void
+writePixel (char* writePtr, T value)
+{
+    if (Xdr)
+        Xdr::write<CharPtrIO> (writePtr, value);
+    else
+        memcpy (writePtr, &value, sizeof (T));
+}
 
-                while (writePtr <= endPtr)
-                {
-                    *(half*) writePtr = fillVal;
-                    writePtr += xStride;
-                }
-            }
-            break;
+//
+// Pixel data type conversions, as done by the functions in ImfConvert.h.
+//
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+inline void
+convertPixel (unsigned int& out, unsigned int in)
+{
+    out = in;
+}
 
-            {
-                float fillVal = float (fillValue);
+inline void
+convertPixel (unsigned int& out, half in)
+{
+    out = halfToUint (in);
+}
 
-                while (writePtr <= endPtr)
-                {
-                    *(float*) writePtr = fillVal;
-                    writePtr += xStride;
-                }
-            }
-            break;
+inline void
+convertPixel (unsigned int& out, float in)
+{
+    out = floatToUint (in);
+}
 
-            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
-        }
-    }
-    else if (format == Compressor::XDR)
-    {
-        //
-        // The the line or tile buffer is in XDR format.
-        //
-        // Convert the pixels from the file's machine-
-        // independent representation, and store the
-        // results in the frame buffer.
-        //
+inline void
+convertPixel (half& out, unsigned int in)
+{
+    out = uintToHalf (in);
+}
 
-        switch (typeInFrameBuffer)
-        {
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+inline void
+convertPixel (half& out, half in)
+{
+    out = in;
+}
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+inline void
+convertPixel (half& out, float in)
+{
+    out = floatToHalf (in);
+}
 
-                        while (writePtr <= endPtr)
-                        {
-                            Xdr::read<CharPtrIO> (
-                                readPtr, *(unsigned int*) writePtr);
-                            writePtr += xStride;
-                        }
-                        break;
+inline void
+convertPixel (float& out, unsigned int in)
+{
+    out = float (in);
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+inline void
+convertPixel (float& out, half in)
+{
+    out = float (in);
+}
 
-                        while (writePtr <= endPtr)
-                        {
-                            half h;
-                            Xdr::read<CharPtrIO> (readPtr, h);
-                            *(unsigned int*) writePtr = halfToUint (h);
-                            writePtr += xStride;
-                        }
-                        break;
+inline void
+convertPixel (float& out, float in)
+{
+    out = in;
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+//
+// Conversion of a slice's fill value to the frame buffer's pixel type.
+//
 
-                        while (writePtr <= endPtr)
-                        {
-                            float f;
-                            Xdr::read<CharPtrIO> (readPtr, f);
-                            *(unsigned int*) writePtr = floatToUint (f);
-                            writePtr += xStride;
-                        }
-                        break;
+template <class T>
+inline T
+fillValueAs (double fillValue)
+{
+    return T (float (fillValue));
+}
 
-                    default:
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+template <>
+inline unsigned int
+fillValueAs<unsigned int> (double fillValue)
+{
+    return (unsigned int) (fillValue);
+}
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+template <class FbType, bool Packed>
+void
+fillRow (
+    const char*& /*readPtr*/,
+    char*  writePtr,
+    char*  endPtr,
+    size_t xStride,
+    double fillValue)
+{
+    if (Packed) xStride = sizeof (FbType);
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+    size_t n     = numPixelsInRow (writePtr, endPtr, xStride);
+    FbType value = fillValueAs<FbType> (fillValue);
 
-                        while (writePtr <= endPtr)
-                        {
-                            unsigned int ui;
-                            Xdr::read<CharPtrIO> (readPtr, ui);
-                            *(half*) writePtr = uintToHalf (ui);
-                            writePtr += xStride;
-                        }
-                        break;
+    for (size_t i = 0; i < n; ++i)
+        memcpy (writePtr + i * xStride, &value, sizeof (FbType));
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+template <class FbType, class FileType, bool Xdr, bool Packed>
+void
+copyIntoRow (
+    const char*& readPtr,
+    char*        writePtr,
+    char*        endPtr,
+    size_t       xStride,
+    double /*fillValue*/)
+{
+    if (Packed) xStride = sizeof (FbType);
 
-                        while (writePtr <= endPtr)
-                        {
-                            Xdr::read<CharPtrIO> (readPtr, *(half*) writePtr);
-                            writePtr += xStride;
-                        }
-                        break;
+    size_t n = numPixelsInRow (writePtr, endPtr, xStride);
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+    if (std::is_same<FbType, FileType>::value && !Xdr && Packed)
+    {
+        memcpy (writePtr, readPtr, n * sizeof (FileType));
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            const char* pixelPtr = readPtr + i * sizeof (FileType);
+            FbType      out;
 
-                        while (writePtr <= endPtr)
-                        {
-                            float f;
-                            Xdr::read<CharPtrIO> (readPtr, f);
-                            *(half*) writePtr = floatToHalf (f);
-                            writePtr += xStride;
-                        }
-                        break;
-                    default:
+            convertPixel (out, readPixel<FileType, Xdr> (pixelPtr));
+            memcpy (writePtr + i * xStride, &out, sizeof (FbType));
+        }
+    }
 
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+    readPtr += n * sizeof (FileType);
+}
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+#ifdef IMF_HAVE_GCC_INLINEASM_X86
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+//
+// F16C version of copyIntoRow<float, half, false, true>().
+//
+// The conversion is exact, so this kernel produces the same results
+// as the scalar version.
+//
 
-                        while (writePtr <= endPtr)
-                        {
-                            unsigned int ui;
-                            Xdr::read<CharPtrIO> (readPtr, ui);
-                            *(float*) writePtr = float (ui);
-                            writePtr += xStride;
-                        }
-                        break;
+void
+copyIntoRowHalfToFloat_f16c (
+    const char*& readPtr, char* writePtr, char* endPtr, size_t, double)
+{
+    size_t n = numPixelsInRow (writePtr, endPtr, sizeof (float));
+    size_t i = 0;
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+    if (n >= 16)
+    {
+        for (; i + 16 <= n; i += 16)
+        {
+            __asm__("vcvtph2ps     (%0), %%ymm0 \n"
+                    "vcvtph2ps 0x10(%0), %%ymm1 \n"
+                    "vmovups   %%ymm0,     (%1) \n"
+                    "vmovups   %%ymm1, 0x20(%1) \n"
+                    : /* Output  */
+                    : /* Input   */ "r"(readPtr + i * sizeof (half)),
+                      "r"(writePtr + i * sizeof (float))
+#    ifndef __AVX__
+                    : /* Clobber */ "%xmm0", "%xmm1", "memory"
+#    else
+                    : /* Clobber */ "%ymm0", "%ymm1", "memory"
+#    endif /* __AVX__ */
+            );
+        }
 
-                        while (writePtr <= endPtr)
-                        {
-                            half h;
-                            Xdr::read<CharPtrIO> (readPtr, h);
-                            *(float*) writePtr = float (h);
-                            writePtr += xStride;
-                        }
-                        break;
+#    ifndef __AVX__
+        __asm__("vzeroupper \n");
+#    endif /* __AVX__ */
+    }
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+    for (; i < n; ++i)
+    {
+        half  in  = readPixel<half, false> (readPtr + i * sizeof (half));
+        float out = float (in);
+        memcpy (writePtr + i * sizeof (float), &out, sizeof (float));
+    }
 
-                        while (writePtr <= endPtr)
-                        {
-                            Xdr::read<CharPtrIO> (readPtr, *(float*) writePtr);
-                            writePtr += xStride;
-                        }
-                        break;
-                    default:
+    readPtr += n * sizeof (half);
+}
 
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+#endif /* IMF_HAVE_GCC_INLINEASM_X86 */
 
-            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+
+//
+// Vector versions of the packed, native byte order float to half,
+// float to unsigned int and unsigned int to float kernels.  They
+// produce the same results as the scalar versions:
+//
+// - vcvtps2ph rounds to nearest even, as half (float) does, but
+//   floatToHalf() also maps finite values between HALF_MAX and the
+//   rounding threshold for infinity to infinity, and NaNs with a
+//   payload are converted differently.  Groups of pixels that contain
+//   such values are converted by the scalar code.
+//
+// - floatToUint() maps negative values and NaNs to 0, and values
+//   that do not fit in 31 bits are converted by the scalar code.
+//
+// - An unsigned int is split into two 16-bit halves, which convert
+//   to float exactly, so their sum is rounded only once.
+//
+
+template <class FbType, class FileType>
+inline void
+convertPixels (const char* readPtr, char* writePtr, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        FbType out;
+
+        convertPixel (
+            out, readPixel<FileType, false> (readPtr + i * sizeof (FileType)));
+        memcpy (writePtr + i * sizeof (FbType), &out, sizeof (FbType));
+    }
+}
+
+__attribute__ ((target ("avx,f16c"))) void
+copyIntoRowFloatToHalf_f16c (
+    const char*& readPtr, char* writePtr, char* endPtr, size_t, double)
+{
+    size_t n = numPixelsInRow (writePtr, endPtr, sizeof (half));
+    size_t i = 0;
+
+    const __m256 absMask =
+        _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+    const __m256 halfMax =
+        _mm256_set1_ps (float (std::numeric_limits<half>::max ()));
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const char* in  = readPtr + i * sizeof (float);
+        char*       out = writePtr + i * sizeof (half);
+
+        __m256 f = _mm256_loadu_ps (reinterpret_cast<const float*> (in));
+        __m256 inRange =
+            _mm256_cmp_ps (_mm256_and_ps (f, absMask), halfMax, _CMP_LE_OQ);
+
+        if (_mm256_movemask_ps (inRange) == 0xff)
+        {
+            _mm_storeu_si128 (
+                reinterpret_cast<__m128i*> (out),
+                _mm256_cvtps_ph (f, _MM_FROUND_TO_NEAREST_INT));
+        }
+        else
+        {
+            convertPixels<half, float> (in, out, 8);
         }
     }
-    else
+
+    convertPixels<half, float> (
+        readPtr + i * sizeof (float), writePtr + i * sizeof (half), n - i);
+
+    readPtr += n * sizeof (float);
+}
+
+__attribute__ ((target ("avx"))) void
+copyIntoRowFloatToUint_avx (
+    const char*& readPtr, char* writePtr, char* endPtr, size_t, double)
+{
+    size_t n = numPixelsInRow (writePtr, endPtr, sizeof (unsigned int));
+    size_t i = 0;
+
+    const __m256 zero  = _mm256_setzero_ps ();
+    const __m256 limit = _mm256_set1_ps (2147483648.0f);
+
+    for (; i + 8 <= n; i += 8)
     {
+        const char* in  = readPtr + i * sizeof (float);
+        char*       out = writePtr + i * sizeof (unsigned int);
+
         //
-        // The the line or tile buffer is in NATIVE format.
-        // Copy the results into the frame buffer.
+        // maxps returns its second operand if either one is a NaN.
         //
 
-        switch (typeInFrameBuffer)
+        __m256 f = _mm256_loadu_ps (reinterpret_cast<const float*> (in));
+        f        = _mm256_max_ps (f, zero);
+
+        if (_mm256_movemask_ps (_mm256_cmp_ps (f, limit, _CMP_LT_OQ)) == 0xff)
         {
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+            _mm256_storeu_si256 (
+                reinterpret_cast<__m256i*> (out), _mm256_cvttps_epi32 (f));
+        }
+        else
+        {
+            convertPixels<unsigned int, float> (in, out, 8);
+        }
+    }
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+    convertPixels<unsigned int, float> (
+        readPtr + i * sizeof (float),
+        writePtr + i * sizeof (unsigned int),
+        n - i);
 
-                        while (writePtr <= endPtr)
-                        {
-                            for (size_t i = 0; i < sizeof (unsigned int); ++i)
-                                writePtr[i] = readPtr[i];
+    readPtr += n * sizeof (float);
+}
 
-                            readPtr += sizeof (unsigned int);
-                            writePtr += xStride;
-                        }
-                        break;
+__attribute__ ((target ("avx2"))) void
+copyIntoRowUintToFloat_avx2 (
+    const char*& readPtr, char* writePtr, char* endPtr, size_t, double)
+{
+    size_t n = numPixelsInRow (writePtr, endPtr, sizeof (float));
+    size_t i = 0;
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+    const __m256i lowBits = _mm256_set1_epi32 (0xffff);
+    const __m256  scale   = _mm256_set1_ps (65536.0f);
 
-                        while (writePtr <= endPtr)
-                        {
-                            half h                    = *(half*) readPtr;
-                            *(unsigned int*) writePtr = halfToUint (h);
-                            readPtr += sizeof (half);
-                            writePtr += xStride;
-                        }
-                        break;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i u = _mm256_loadu_si256 (
+            reinterpret_cast<const __m256i*> (readPtr + i * sizeof (int)));
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+        __m256 hi = _mm256_cvtepi32_ps (_mm256_srli_epi32 (u, 16));
+        __m256 lo = _mm256_cvtepi32_ps (_mm256_and_si256 (u, lowBits));
 
-                        while (writePtr <= endPtr)
-                        {
-                            float f;
+        _mm256_storeu_ps (
+            reinterpret_cast<float*> (writePtr + i * sizeof (float)),
+            _mm256_add_ps (_mm256_mul_ps (hi, scale), lo));
+    }
 
-                            for (size_t i = 0; i < sizeof (float); ++i)
-                                ((char*) &f)[i] = readPtr[i];
+    convertPixels<float, unsigned int> (
+        readPtr + i * sizeof (unsigned int),
+        writePtr + i * sizeof (float),
+        n - i);
 
-                            *(unsigned int*) writePtr = floatToUint (f);
-                            readPtr += sizeof (float);
-                            writePtr += xStride;
-                        }
-                        break;
+    readPtr += n * sizeof (unsigned int);
+}
 
-                    default:
+bool
+haveAvx ()
+{
+    static const bool avx = CpuId ().avx;
+    return avx;
+}
 
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+bool
+haveAvx2 ()
+{
+    static const bool avx2 = CpuId ().avx && __builtin_cpu_supports ("avx2");
+    return avx2;
+}
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+#endif /* IMF_HAVE_X86_TARGET_ATTRIBUTE */
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+#if defined(IMF_HAVE_GCC_INLINEASM_X86) ||                                     \
+    defined(IMF_HAVE_X86_TARGET_ATTRIBUTE)
 
-                        while (writePtr <= endPtr)
-                        {
-                            unsigned int ui;
+bool
+haveF16c ()
+{
+    static const bool f16c = CpuId ().avx && CpuId ().f16c;
+    return f16c;
+}
 
-                            for (size_t i = 0; i < sizeof (unsigned int); ++i)
-                                ((char*) &ui)[i] = readPtr[i];
+#endif
 
-                            *(half*) writePtr = uintToHalf (ui);
-                            readPtr += sizeof (unsigned int);
-                            writePtr += xStride;
-                        }
-                        break;
+void
+copyIntoRowUnknownType (const char*&, char*, char*, size_t, double)
+{
+    throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+template <class FbType>
+CopyIntoFrameBufferFunc
+selectFillRow (size_t xStride)
+{
+    bool packed = xStride == sizeof (FbType);
 
-                        // If we're tightly packed, just memcpy
-                        if (xStride == sizeof (half))
-                        {
-                            int numBytes = endPtr - writePtr + sizeof (half);
-                            memcpy (writePtr, readPtr, numBytes);
-                            readPtr += numBytes;
-                            writePtr += numBytes;
-                        }
-                        else
-                        {
-                            while (writePtr <= endPtr)
-                            {
-                                *(half*) writePtr = *(half*) readPtr;
-                                readPtr += sizeof (half);
-                                writePtr += xStride;
-                            }
-                        }
-                        break;
+    return packed ? fillRow<FbType, true> : fillRow<FbType, false>;
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+template <class FbType, class FileType>
+CopyIntoFrameBufferFunc
+selectCopyIntoRow (bool xdr, size_t xStride)
+{
+    bool packed = xStride == sizeof (FbType);
 
-                        while (writePtr <= endPtr)
-                        {
-                            float f;
+    if (xdr)
+    {
+        return packed ? copyIntoRow<FbType, FileType, true, true>
+                      : copyIntoRow<FbType, FileType, true, false>;
+    }
 
-                            for (size_t i = 0; i < sizeof (float); ++i)
-                                ((char*) &f)[i] = readPtr[i];
+    return packed ? copyIntoRow<FbType, FileType, false, true>
+                  : copyIntoRow<FbType, FileType, false, false>;
+}
 
-                            *(half*) writePtr = floatToHalf (f);
-                            readPtr += sizeof (float);
-                            writePtr += xStride;
-                        }
-                        break;
-                    default:
+template <class FbType>
+CopyIntoFrameBufferFunc
+selectCopyIntoRow (PixelType typeInFile, bool xdr, size_t xStride)
+{
+    switch (typeInFile)
+    {
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+            return selectCopyIntoRow<FbType, unsigned int> (xdr, xStride);
 
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+            return selectCopyIntoRow<FbType, half> (xdr, xStride);
 
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+            return selectCopyIntoRow<FbType, float> (xdr, xStride);
 
-                switch (typeInFile)
-                {
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+        default: return copyIntoRowUnknownType;
+    }
+}
 
-                        while (writePtr <= endPtr)
-                        {
-                            unsigned int ui;
+template <class T, bool Xdr, bool Packed>
+void
+copyFromRow (
+    char*& writePtr, const char*& readPtr, const char* endPtr, size_t xStride)
+{
+    if (Packed) xStride = sizeof (T);
 
-                            for (size_t i = 0; i < sizeof (unsigned int); ++i)
-                                ((char*) &ui)[i] = readPtr[i];
+    size_t n = numPixelsInRow (readPtr, endPtr, xStride);
 
-                            *(float*) writePtr = float (ui);
-                            readPtr += sizeof (unsigned int);
-                            writePtr += xStride;
-                        }
-                        break;
+    if (!Xdr && Packed)
+    {
+        memcpy (writePtr, readPtr, n * sizeof (T));
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            T value;
+            memcpy (&value, readPtr + i * xStride, sizeof (T));
+            writePixel<T, Xdr> (writePtr + i * sizeof (T), value);
+        }
+    }
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+    writePtr += n * sizeof (T);
+    readPtr += n * xStride;
+}
 
-                        while (writePtr <= endPtr)
-                        {
-                            half h             = *(half*) readPtr;
-                            *(float*) writePtr = float (h);
-                            readPtr += sizeof (half);
-                            writePtr += xStride;
-                        }
-                        break;
+void
+copyFromRowUnknownType (char*&, const char*&, const char*, size_t)
+{
+    throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
+}
 
-                    case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+template <class T>
+CopyFromFrameBufferFunc
+selectCopyFromRow (bool xdr, size_t xStride)
+{
+    bool packed = xStride == sizeof (T);
 
-                        while (writePtr <= endPtr)
-                        {
-                            for (size_t i = 0; i < sizeof (float); ++i)
-                                writePtr[i] = readPtr[i];
+    if (xdr)
+    {
+        return packed ? copyFromRow<T, true, true>
+                      : copyFromRow<T, true, false>;
+    }
 
-                            readPtr += sizeof (float);
-                            writePtr += xStride;
-                        }
-                        break;
-                    default:
+    return packed ? copyFromRow<T, false, true> : copyFromRow<T, false, false>;
+}
 
-                        throw IEX_NAMESPACE::ArgExc (
-                            "Unknown pixel data type.");
-                }
-                break;
+//
+// The XDR representation of pixel data is little-endian, so on
+// little-endian machines, XDR and NATIVE line buffers can share
+// the same kernels.
+//
 
-            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
+inline bool
+needsXdrKernel (Compressor::Format format)
+{
+    return format == Compressor::XDR && !GLOBAL_SYSTEM_LITTLE_ENDIAN;
+}
+
+} // namespace
+
+CopyIntoFrameBufferFunc
+findCopyIntoFrameBuffer (
+    bool               fill,
+    Compressor::Format format,
+    PixelType          typeInFrameBuffer,
+    PixelType          typeInFile,
+    size_t             xStride)
+{
+    bool xdr = needsXdrKernel (format);
+
+    if (fill)
+    {
+        switch (typeInFrameBuffer)
+        {
+            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+                return selectFillRow<unsigned int> (xStride);
+
+            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+                return selectFillRow<half> (xStride);
+
+            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+                return selectFillRow<float> (xStride);
+
+            default: return copyIntoRowUnknownType;
         }
     }
+
+    switch (typeInFrameBuffer)
+    {
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+            if (typeInFile == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT && !xdr &&
+                xStride == sizeof (unsigned int) && haveAvx ())
+            {
+                return copyIntoRowFloatToUint_avx;
+            }
+#endif
+
+            return selectCopyIntoRow<unsigned int> (typeInFile, xdr, xStride);
+
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+            if (typeInFile == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT && !xdr &&
+                xStride == sizeof (half) && haveF16c ())
+            {
+                return copyIntoRowFloatToHalf_f16c;
+            }
+#endif
+
+            return selectCopyIntoRow<half> (typeInFile, xdr, xStride);
+
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+            if (typeInFile == OPENEXR_IMF_INTERNAL_NAMESPACE::UINT && !xdr &&
+                xStride == sizeof (float) && haveAvx2 ())
+            {
+                return copyIntoRowUintToFloat_avx2;
+            }
+#endif
+
+#ifdef IMF_HAVE_GCC_INLINEASM_X86
+            if (typeInFile == OPENEXR_IMF_INTERNAL_NAMESPACE::HALF && !xdr &&
+                xStride == sizeof (float) && haveF16c ())
+            {
+                return copyIntoRowHalfToFloat_f16c;
+            }
+#endif
+
+            return selectCopyIntoRow<float> (typeInFile, xdr, xStride);
+
+        default: return copyIntoRowUnknownType;
+    }
+}
+
+void
+copyIntoFrameBuffer (
+    const char*&       readPtr,
+    char*              writePtr,
+    char*              endPtr,
+    size_t             xStride,
+    bool               fill,
+    double             fillValue,
+    Compressor::Format format,
+    PixelType          typeInFrameBuffer,
+    PixelType          typeInFile)
+{
+    //
+    // Copy a horizontal row of pixels from an input
+    // file's line or tile buffer to a frame buffer.
+    //
+
+    CopyIntoFrameBufferFunc copy = findCopyIntoFrameBuffer (
+        fill, format, typeInFrameBuffer, typeInFile, xStride);
+
+    copy (readPtr, writePtr, endPtr, xStride, fillValue);
 }
 
 void
@@ -1523,6 +1774,27 @@ convertInPlace (
     }
 }
 
+CopyFromFrameBufferFunc
+findCopyFromFrameBuffer (
+    Compressor::Format format, PixelType type, size_t xStride)
+{
+    bool xdr = needsXdrKernel (format);
+
+    switch (type)
+    {
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
+            return selectCopyFromRow<unsigned int> (xdr, xStride);
+
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
+            return selectCopyFromRow<half> (xdr, xStride);
+
+        case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
+            return selectCopyFromRow<float> (xdr, xStride);
+
+        default: return copyFromRowUnknownType;
+    }
+}
+
 void
 copyFromFrameBuffer (
     char*&             writePtr,
@@ -1532,100 +1804,15 @@ copyFromFrameBuffer (
     Compressor::Format format,
     PixelType          type)
 {
-    char*       localWritePtr = writePtr;
-    const char* localReadPtr  = readPtr;
     //
     // Copy a horizontal row of pixels from a frame
     // buffer to an output file's line or tile buffer.
     //
 
-    if (format == Compressor::XDR)
-    {
-        //
-        // The the line or tile buffer is in XDR format.
-        //
-
-        switch (type)
-        {
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
-
-                while (localReadPtr <= endPtr)
-                {
-                    Xdr::write<CharPtrIO> (
-                        localWritePtr, *(const unsigned int*) localReadPtr);
-                    localReadPtr += xStride;
-                }
-                break;
-
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
-
-                while (localReadPtr <= endPtr)
-                {
-                    Xdr::write<CharPtrIO> (
-                        localWritePtr, *(const half*) localReadPtr);
-                    localReadPtr += xStride;
-                }
-                break;
-
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
-
-                while (localReadPtr <= endPtr)
-                {
-                    Xdr::write<CharPtrIO> (
-                        localWritePtr, *(const float*) localReadPtr);
-                    localReadPtr += xStride;
-                }
-                break;
-
-            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
-        }
-    }
-    else
-    {
-        //
-        // The the line or tile buffer is in NATIVE format.
-        //
-
-        switch (type)
-        {
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
-
-                while (localReadPtr <= endPtr)
-                {
-                    for (size_t i = 0; i < sizeof (unsigned int); ++i)
-                        *localWritePtr++ = localReadPtr[i];
-
-                    localReadPtr += xStride;
-                }
-                break;
-
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
-
-                while (localReadPtr <= endPtr)
-                {
-                    *(half*) localWritePtr = *(const half*) localReadPtr;
-                    localWritePtr += sizeof (half);
-                    localReadPtr += xStride;
-                }
-                break;
-
-            case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
-
-                while (localReadPtr <= endPtr)
-                {
-                    for (size_t i = 0; i < sizeof (float); ++i)
-                        *localWritePtr++ = localReadPtr[i];
-
-                    localReadPtr += xStride;
-                }
-                break;
-
-            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel data type.");
-        }
-    }
+    CopyFromFrameBufferFunc copy =
+        findCopyFromFrameBuffer (format, type, xStride);
 
-    writePtr = localWritePtr;
-    readPtr  = localReadPtr;
+    copy (writePtr, readPtr, endPtr, xStride);
 }
 
 void
@@ -198,6 +198,30 @@ void copyIntoFrameBuffer (
     PixelType          typeInFrameBuffer,
     PixelType          typeInFile);
 
+//
+// Find the kernel that copyIntoFrameBuffer() uses for a given
+// combination of fill flag, line or tile buffer format, pixel data
+// types and frame buffer x stride.  Input files look up the kernel
+// for each slice once, in setFrameBuffer(), instead of dispatching
+// on the pixel types for every row they copy.  The xStride passed
+// to the kernel must be the same as the one passed here.
+//
+
+typedef void (*CopyIntoFrameBufferFunc) (
+    const char*& readPtr,
+    char*        writePtr,
+    char*        endPtr,
+    size_t       xStride,
+    double       fillValue);
+
+IMF_EXPORT
+CopyIntoFrameBufferFunc findCopyIntoFrameBuffer (
+    bool               fill,
+    Compressor::Format format,
+    PixelType          typeInFrameBuffer,
+    PixelType          typeInFile,
+    size_t             xStride);
+
 //
 // Copy a single channel of a horizontal row of pixels from an
 // input file's internal line buffer or tile buffer into a
@@ -330,6 +354,22 @@ void copyFromFrameBuffer (
     Compressor::Format format,
     PixelType          type);
 
+//
+// Find the kernel that copyFromFrameBuffer() uses for a given
+// line or tile buffer format, pixel data type and frame buffer
+// x stride (see findCopyIntoFrameBuffer(), above).
+//
+
+typedef void (*CopyFromFrameBufferFunc) (
+    char*&       writePtr,
+    const char*& readPtr,
+    const char*  endPtr,
+    size_t       xStride);
+
+IMF_EXPORT
+CopyFromFrameBufferFunc findCopyFromFrameBuffer (
+    Compressor::Format format, PixelType type, size_t xStride);
+
 //
 // Copy a single channel of a horizontal row of pixels from a
 // a frame buffer in a deep data file into an output file's
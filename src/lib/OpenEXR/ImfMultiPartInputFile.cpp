@@ -868,6 +868,12 @@ MultiPartInputFile::partComplete (int part) const
     return _data->parts[part]->completed;
 }
 
+Statistics
+MultiPartInputFile::statistics () const
+{
+    return _data->statistics ();
+}
+
 int
 MultiPartInputFile::parts () const
 {
@@ -58,6 +58,15 @@ public:
     IMF_EXPORT
     bool partComplete (int part) const;
 
+    //---------------------------------------------------------
+    // Statistics about reading all parts of the file (see
+    // ImfStatistics.h).  The counters are zero unless
+    // statistics were enabled when the file was opened.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    Statistics statistics () const;
+
     // ----------------------------------------
     // Flush internal part cache
     // Invalidates all 'Part' types previously
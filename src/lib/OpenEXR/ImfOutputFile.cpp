@@ -36,6 +36,7 @@
 #include <assert.h>
 #include <fstream>
 #include <string>
+#include <string.h>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -65,6 +66,13 @@ struct OutSliceInfo
     int         ySampling;
     bool        zero;
 
+    //
+    // Row copy kernel for the file's line buffer
+    // format, selected once for the slice's type and stride
+    //
+
+    CopyFromFrameBufferFunc copy;
+
     OutSliceInfo (
         PixelType   type      = HALF,
         const char* base      = 0,
@@ -84,6 +92,7 @@ OutSliceInfo::OutSliceInfo (
     , xSampling (xsm)
     , ySampling (ysm)
     , zero (z)
+    , copy (0)
 {
     // empty
 }
@@ -519,13 +528,7 @@ LineBufferTask::execute ()
                     const char* endPtr = reinterpret_cast<const char*> (
                         linePtr + dMaxX * slice.xStride);
 
-                    copyFromFrameBuffer (
-                        writePtr,
-                        readPtr,
-                        endPtr,
-                        slice.xStride,
-                        _ofd->format,
-                        slice.type);
+                    slice.copy (writePtr, readPtr, endPtr, slice.xStride);
                 }
             }
 
@@ -883,14 +886,23 @@ OutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     // is compatible with the image file header.
     //
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&         channels = _data->header.channels ();
+    FrameBuffer::ConstIterator j        = frameBuffer.begin ();
+
+    //
+    // The channels and the slices are both sorted by name,
+    // so the slice for each channel is found in a single pass.
+    //
 
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
+
+        if (j == frameBuffer.end ()) break;
 
-        if (j == frameBuffer.end ()) continue;
+        if (strcmp (j.name (), i.name ()) > 0) continue;
 
         if (i.channel ().type != j.slice ().type)
         {
@@ -928,12 +940,15 @@ OutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
 
     vector<OutSliceInfo> slices;
 
+    j = frameBuffer.begin ();
+
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
 
-        if (j == frameBuffer.end ())
+        if (j == frameBuffer.end () || strcmp (j.name (), i.name ()) > 0)
         {
             //
             // Channel i is not present in the frame buffer.
@@ -963,6 +978,9 @@ OutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
                 j.slice ().xSampling,
                 j.slice ().ySampling,
                 false)); // zero
+
+            slices.back ().copy = findCopyFromFrameBuffer (
+                _data->format, j.slice ().type, j.slice ().xStride);
         }
     }
 
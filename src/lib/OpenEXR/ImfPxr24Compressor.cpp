@@ -41,6 +41,8 @@
 #include "ImfHeader.h"
 #include "ImfMisc.h"
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
+#include "ImfSystemSpecific.h"
 
 #include <Iex.h>
 #include <ImathFun.h>
@@ -48,6 +50,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <half.h>
+#include <string.h>
 #include <zlib.h>
 
 using namespace std;
@@ -133,6 +136,506 @@ floatToFloat24 (float f)
     return (s >> 8) | i;
 }
 
+//
+// Conversion of the pixels of one channel in one scan line to and
+// from byte planes.  The split functions replace each of the n pixel
+// values in "in" with the difference between the value and its left
+// neighbor, and store the most significant bytes of the differences
+// in out[0] ... out[n-1], the next bytes in out[n] ... out[2*n-1],
+// and so on.  The join functions undo this.
+//
+// The ...Pixels functions convert pixels begin ... n-1, where
+// previousPixel, or pixel, is the (24-bit) value of pixel begin-1.
+//
+
+inline void
+splitUintPixels (
+    const char*    in,
+    int            begin,
+    int            n,
+    unsigned int   previousPixel,
+    unsigned char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        unsigned int pixel;
+        memcpy (&pixel, in + j * sizeof (pixel), sizeof (pixel));
+
+        unsigned int diff = pixel - previousPixel;
+        previousPixel     = pixel;
+
+        out[j]         = diff >> 24;
+        out[n + j]     = diff >> 16;
+        out[2 * n + j] = diff >> 8;
+        out[3 * n + j] = diff;
+    }
+}
+
+inline void
+splitHalfPixels (
+    const char*    in,
+    int            begin,
+    int            n,
+    unsigned int   previousPixel,
+    unsigned char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        unsigned short pixel;
+        memcpy (&pixel, in + j * sizeof (pixel), sizeof (pixel));
+
+        unsigned int diff = pixel - previousPixel;
+        previousPixel     = pixel;
+
+        out[j]     = diff >> 8;
+        out[n + j] = diff;
+    }
+}
+
+inline void
+splitFloatPixels (
+    const char*    in,
+    int            begin,
+    int            n,
+    unsigned int   previousPixel,
+    unsigned char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        float pixel;
+        memcpy (&pixel, in + j * sizeof (pixel), sizeof (pixel));
+
+        unsigned int pixel24 = floatToFloat24 (pixel);
+        unsigned int diff    = pixel24 - previousPixel;
+        previousPixel        = pixel24;
+
+        out[j]         = diff >> 16;
+        out[n + j]     = diff >> 8;
+        out[2 * n + j] = diff;
+    }
+}
+
+inline void
+joinUintPixels (
+    const unsigned char* in, int begin, int n, unsigned int pixel, char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        unsigned int diff = (in[j] << 24) | (in[n + j] << 16) |
+                            (in[2 * n + j] << 8) | in[3 * n + j];
+
+        pixel += diff;
+        memcpy (out + j * sizeof (pixel), &pixel, sizeof (pixel));
+    }
+}
+
+inline void
+joinHalfPixels (
+    const unsigned char* in, int begin, int n, unsigned int pixel, char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        unsigned int diff = (in[j] << 8) | in[n + j];
+
+        pixel += diff;
+
+        unsigned short bits = (unsigned short) pixel;
+        memcpy (out + j * sizeof (bits), &bits, sizeof (bits));
+    }
+}
+
+inline void
+joinFloatPixels (
+    const unsigned char* in, int begin, int n, unsigned int pixel, char* out)
+{
+    for (int j = begin; j < n; ++j)
+    {
+        unsigned int diff =
+            (in[j] << 24) | (in[n + j] << 16) | (in[2 * n + j] << 8);
+
+        pixel += diff;
+        memcpy (out + j * sizeof (pixel), &pixel, sizeof (pixel));
+    }
+}
+
+void
+splitUint_scalar (const char* in, int n, unsigned char* out)
+{
+    splitUintPixels (in, 0, n, 0, out);
+}
+
+void
+splitHalf_scalar (const char* in, int n, unsigned char* out)
+{
+    splitHalfPixels (in, 0, n, 0, out);
+}
+
+void
+splitFloat_scalar (const char* in, int n, unsigned char* out)
+{
+    splitFloatPixels (in, 0, n, 0, out);
+}
+
+void
+joinUint_scalar (const unsigned char* in, int n, char* out)
+{
+    joinUintPixels (in, 0, n, 0, out);
+}
+
+void
+joinHalf_scalar (const unsigned char* in, int n, char* out)
+{
+    joinHalfPixels (in, 0, n, 0, out);
+}
+
+void
+joinFloat_scalar (const unsigned char* in, int n, char* out)
+{
+    joinFloatPixels (in, 0, n, 0, out);
+}
+
+#ifdef IMF_HAVE_SSE2
+
+//
+// SSE2 versions of the split and join functions.  They process
+// sixteen pixels at a time, with the same integer arithmetic as
+// the scalar functions, so their results are bit-for-bit identical.
+// The remaining pixels are converted by the scalar functions.
+//
+
+inline __m128i
+floatToFloat24_sse2 (__m128i u)
+{
+    //
+    // floatToFloat24(), above, for four floats at a time
+    //
+
+    const __m128i expMask = _mm_set1_epi32 (0x7f800000);
+
+    __m128i s  = _mm_and_si128 (u, _mm_set1_epi32 ((int) 0x80000000));
+    __m128i e  = _mm_and_si128 (u, expMask);
+    __m128i m  = _mm_and_si128 (u, _mm_set1_epi32 (0x007fffff));
+    __m128i em = _mm_or_si128 (e, m);
+
+    //
+    // Finite values: round the significand, or truncate it if
+    // rounding would overflow the exponent.  The rounded values
+    // are less than 2^24, so a signed comparison is safe.
+    //
+
+    __m128i r = _mm_srli_epi32 (
+        _mm_add_epi32 (em, _mm_and_si128 (m, _mm_set1_epi32 (0x80))), 8);
+
+    __m128i overflow = _mm_cmpgt_epi32 (r, _mm_set1_epi32 (0x7f7fff));
+
+    __m128i finite = _mm_or_si128 (
+        _mm_and_si128 (overflow, _mm_srli_epi32 (em, 8)),
+        _mm_andnot_si128 (overflow, r));
+
+    //
+    // NANs and infinities: keep the 15 leftmost bits of the
+    // significand, and set the rightmost bit of NANs whose
+    // 15 leftmost bits are all zero.
+    //
+
+    const __m128i zero = _mm_setzero_si128 ();
+
+    __m128i m8 = _mm_srli_epi32 (m, 8);
+
+    __m128i forceNan = _mm_andnot_si128 (
+        _mm_cmpeq_epi32 (m, zero),
+        _mm_and_si128 (_mm_cmpeq_epi32 (m8, zero), _mm_set1_epi32 (1)));
+
+    __m128i special =
+        _mm_or_si128 (_mm_srli_epi32 (e, 8), _mm_or_si128 (m8, forceNan));
+
+    __m128i isSpecial = _mm_cmpeq_epi32 (e, expMask);
+
+    __m128i i = _mm_or_si128 (
+        _mm_and_si128 (isSpecial, special),
+        _mm_andnot_si128 (isSpecial, finite));
+
+    return _mm_or_si128 (_mm_srli_epi32 (s, 8), i);
+}
+
+inline __m128i
+differences32 (__m128i v, __m128i previous)
+{
+    //
+    // The differences between the four 32-bit values in v and their
+    // left neighbors; the last value in previous is the left neighbor
+    // of the first value in v.
+    //
+
+    return _mm_sub_epi32 (
+        v, _mm_or_si128 (_mm_slli_si128 (v, 4), _mm_srli_si128 (previous, 12)));
+}
+
+inline void
+transpose32 (__m128i v[4])
+{
+    //
+    // Transpose the bytes of sixteen 32-bit values, so that v[k]
+    // contains byte k, counting from the least significant byte,
+    // of each value.  Each pass interleaves the first 32 bytes with
+    // the last 32 bytes; four passes move byte k of value j from
+    // position 4*j+k to position 16*k+j.
+    //
+
+    for (int pass = 0; pass < 4; ++pass)
+    {
+        __m128i a = _mm_unpacklo_epi8 (v[0], v[2]);
+        __m128i b = _mm_unpackhi_epi8 (v[0], v[2]);
+        __m128i c = _mm_unpacklo_epi8 (v[1], v[3]);
+        __m128i d = _mm_unpackhi_epi8 (v[1], v[3]);
+
+        v[0] = a;
+        v[1] = b;
+        v[2] = c;
+        v[3] = d;
+    }
+}
+
+inline __m128i
+prefixSum32 (__m128i v, __m128i& previous)
+{
+    //
+    // The running sums of the four 32-bit values in v, starting with
+    // the values in previous, all of which are equal.  On return,
+    // previous contains four copies of the last sum.
+    //
+
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 4));
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 8));
+    v = _mm_add_epi32 (v, previous);
+
+    previous = _mm_shuffle_epi32 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    return v;
+}
+
+inline __m128i
+prefixSum16 (__m128i v, __m128i& previous)
+{
+    //
+    // Like prefixSum32(), for eight 16-bit values
+    //
+
+    v = _mm_add_epi16 (v, _mm_slli_si128 (v, 2));
+    v = _mm_add_epi16 (v, _mm_slli_si128 (v, 4));
+    v = _mm_add_epi16 (v, _mm_slli_si128 (v, 8));
+    v = _mm_add_epi16 (v, previous);
+
+    previous = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    previous = _mm_unpackhi_epi64 (previous, previous);
+    return v;
+}
+
+inline unsigned int
+lastValue32 (__m128i v)
+{
+    return _mm_cvtsi128_si32 (_mm_shuffle_epi32 (v, _MM_SHUFFLE (3, 3, 3, 3)));
+}
+
+void
+splitUint_sse2 (const char* in, int n, unsigned char* out)
+{
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        __m128i v[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i pixels = _mm_loadu_si128 ((const __m128i*) in + j / 4 + k);
+            v[k]           = differences32 (pixels, previous);
+            previous       = pixels;
+        }
+
+        transpose32 (v);
+
+        _mm_storeu_si128 ((__m128i*) (out + j), v[3]);
+        _mm_storeu_si128 ((__m128i*) (out + n + j), v[2]);
+        _mm_storeu_si128 ((__m128i*) (out + 2 * n + j), v[1]);
+        _mm_storeu_si128 ((__m128i*) (out + 3 * n + j), v[0]);
+    }
+
+    splitUintPixels (in, j, n, lastValue32 (previous), out);
+}
+
+void
+splitHalf_sse2 (const char* in, int n, unsigned char* out)
+{
+    const __m128i lowBytes = _mm_set1_epi16 (0xff);
+
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        __m128i d[2];
+
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i pixels = _mm_loadu_si128 ((const __m128i*) in + j / 8 + k);
+
+            d[k] = _mm_sub_epi16 (
+                pixels,
+                _mm_or_si128 (
+                    _mm_slli_si128 (pixels, 2),
+                    _mm_srli_si128 (previous, 14)));
+
+            previous = pixels;
+        }
+
+        __m128i hi = _mm_packus_epi16 (
+            _mm_srli_epi16 (d[0], 8), _mm_srli_epi16 (d[1], 8));
+
+        __m128i lo = _mm_packus_epi16 (
+            _mm_and_si128 (d[0], lowBytes), _mm_and_si128 (d[1], lowBytes));
+
+        _mm_storeu_si128 ((__m128i*) (out + j), hi);
+        _mm_storeu_si128 ((__m128i*) (out + n + j), lo);
+    }
+
+    unsigned int previousPixel =
+        (unsigned short) _mm_extract_epi16 (previous, 7);
+
+    splitHalfPixels (in, j, n, previousPixel, out);
+}
+
+void
+splitFloat_sse2 (const char* in, int n, unsigned char* out)
+{
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        __m128i v[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i pixels = floatToFloat24_sse2 (
+                _mm_loadu_si128 ((const __m128i*) in + j / 4 + k));
+
+            v[k]     = differences32 (pixels, previous);
+            previous = pixels;
+        }
+
+        transpose32 (v);
+
+        _mm_storeu_si128 ((__m128i*) (out + j), v[2]);
+        _mm_storeu_si128 ((__m128i*) (out + n + j), v[1]);
+        _mm_storeu_si128 ((__m128i*) (out + 2 * n + j), v[0]);
+    }
+
+    splitFloatPixels (in, j, n, lastValue32 (previous), out);
+}
+
+inline void
+join32 (
+    __m128i  b0,
+    __m128i  b1,
+    __m128i  b2,
+    __m128i  b3,
+    __m128i& previous,
+    char*    out)
+{
+    //
+    // Reassemble sixteen 32-bit differences from their bytes, b0
+    // being the least significant, and store their running sums.
+    //
+
+    __m128i lo[2] = {_mm_unpacklo_epi8 (b0, b1), _mm_unpackhi_epi8 (b0, b1)};
+    __m128i hi[2] = {_mm_unpacklo_epi8 (b2, b3), _mm_unpackhi_epi8 (b2, b3)};
+
+    __m128i* dout = (__m128i*) out;
+
+    for (int k = 0; k < 2; ++k)
+    {
+        __m128i v0 = _mm_unpacklo_epi16 (lo[k], hi[k]);
+        __m128i v1 = _mm_unpackhi_epi16 (lo[k], hi[k]);
+
+        _mm_storeu_si128 (dout + 2 * k, prefixSum32 (v0, previous));
+        _mm_storeu_si128 (dout + 2 * k + 1, prefixSum32 (v1, previous));
+    }
+}
+
+void
+joinUint_sse2 (const unsigned char* in, int n, char* out)
+{
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        join32 (
+            _mm_loadu_si128 ((const __m128i*) (in + 3 * n + j)),
+            _mm_loadu_si128 ((const __m128i*) (in + 2 * n + j)),
+            _mm_loadu_si128 ((const __m128i*) (in + n + j)),
+            _mm_loadu_si128 ((const __m128i*) (in + j)),
+            previous,
+            out + j * sizeof (unsigned int));
+    }
+
+    joinUintPixels (in, j, n, _mm_cvtsi128_si32 (previous), out);
+}
+
+void
+joinHalf_sse2 (const unsigned char* in, int n, char* out)
+{
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        __m128i hi = _mm_loadu_si128 ((const __m128i*) (in + j));
+        __m128i lo = _mm_loadu_si128 ((const __m128i*) (in + n + j));
+
+        __m128i v0 = _mm_unpacklo_epi8 (lo, hi);
+        __m128i v1 = _mm_unpackhi_epi8 (lo, hi);
+
+        __m128i* dout = (__m128i*) out + j / 8;
+
+        _mm_storeu_si128 (dout, prefixSum16 (v0, previous));
+        _mm_storeu_si128 (dout + 1, prefixSum16 (v1, previous));
+    }
+
+    unsigned int pixel = (unsigned short) _mm_extract_epi16 (previous, 0);
+    joinHalfPixels (in, j, n, pixel, out);
+}
+
+void
+joinFloat_sse2 (const unsigned char* in, int n, char* out)
+{
+    __m128i previous = _mm_setzero_si128 ();
+    int     j        = 0;
+
+    for (; j + 16 <= n; j += 16)
+    {
+        join32 (
+            _mm_setzero_si128 (),
+            _mm_loadu_si128 ((const __m128i*) (in + 2 * n + j)),
+            _mm_loadu_si128 ((const __m128i*) (in + n + j)),
+            _mm_loadu_si128 ((const __m128i*) (in + j)),
+            previous,
+            out + j * sizeof (float));
+    }
+
+    joinFloatPixels (in, j, n, _mm_cvtsi128_si32 (previous), out);
+}
+
+#endif
+
+auto splitUint  = splitUint_scalar;
+auto splitHalf  = splitHalf_scalar;
+auto splitFloat = splitFloat_scalar;
+auto joinUint   = joinUint_scalar;
+auto joinHalf   = joinHalf_scalar;
+auto joinFloat  = joinFloat_scalar;
+
 void
 notEnoughData ()
 {
@@ -256,84 +759,27 @@ Pxr24Compressor::compress (
 
             int n = numSamples (c.xSampling, minX, maxX);
 
-            unsigned char* ptr[4];
-            unsigned int   previousPixel = 0;
-
             switch (c.type)
             {
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    ptr[2]       = ptr[1] + n;
-                    ptr[3]       = ptr[2] + n;
-                    tmpBufferEnd = ptr[3] + n;
-
-                    for (int j = 0; j < n; ++j)
-                    {
-                        unsigned int pixel;
-                        char*        pPtr = (char*) &pixel;
-
-                        for (size_t k = 0; k < sizeof (pixel); ++k)
-                            *pPtr++ = *inPtr++;
-
-                        unsigned int diff = pixel - previousPixel;
-                        previousPixel     = pixel;
-
-                        *(ptr[0]++) = diff >> 24;
-                        *(ptr[1]++) = diff >> 16;
-                        *(ptr[2]++) = diff >> 8;
-                        *(ptr[3]++) = diff;
-                    }
-
+                    splitUint (inPtr, n, tmpBufferEnd);
+                    inPtr += n * sizeof (unsigned int);
+                    tmpBufferEnd += n * 4;
                     break;
 
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    tmpBufferEnd = ptr[1] + n;
-
-                    for (int j = 0; j < n; ++j)
-                    {
-                        half pixel;
-
-                        pixel = *(const half*) inPtr;
-                        inPtr += sizeof (half);
-
-                        unsigned int diff = pixel.bits () - previousPixel;
-                        previousPixel     = pixel.bits ();
-
-                        *(ptr[0]++) = diff >> 8;
-                        *(ptr[1]++) = diff;
-                    }
-
+                    splitHalf (inPtr, n, tmpBufferEnd);
+                    inPtr += n * sizeof (half);
+                    tmpBufferEnd += n * 2;
                     break;
 
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    ptr[2]       = ptr[1] + n;
-                    tmpBufferEnd = ptr[2] + n;
-
-                    for (int j = 0; j < n; ++j)
-                    {
-                        float pixel;
-                        char* pPtr = (char*) &pixel;
-
-                        for (size_t k = 0; k < sizeof (pixel); ++k)
-                            *pPtr++ = *inPtr++;
-
-                        unsigned int pixel24 = floatToFloat24 (pixel);
-                        unsigned int diff    = pixel24 - previousPixel;
-                        previousPixel        = pixel24;
-
-                        *(ptr[0]++) = diff >> 16;
-                        *(ptr[1]++) = diff >> 8;
-                        *(ptr[2]++) = diff;
-                    }
-
+                    splitFloat (inPtr, n, tmpBufferEnd);
+                    inPtr += n * sizeof (float);
+                    tmpBufferEnd += n * 3;
                     break;
 
                 default: assert (false);
@@ -399,83 +845,41 @@ Pxr24Compressor::uncompress (
 
             int n = numSamples (c.xSampling, minX, maxX);
 
-            const unsigned char* ptr[4];
-            unsigned int         pixel = 0;
+            const unsigned char* planes = tmpBufferEnd;
 
             switch (c.type)
             {
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::UINT:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    ptr[2]       = ptr[1] + n;
-                    ptr[3]       = ptr[2] + n;
-                    tmpBufferEnd = ptr[3] + n;
+                    tmpBufferEnd += n * 4;
 
                     if (static_cast<uLong> (tmpBufferEnd - _tmpBuffer) > tmpSize)
                         notEnoughData ();
 
-                    for (int j = 0; j < n; ++j)
-                    {
-                        unsigned int diff = (*(ptr[0]++) << 24) |
-                                            (*(ptr[1]++) << 16) |
-                                            (*(ptr[2]++) << 8) | *(ptr[3]++);
-
-                        pixel += diff;
-
-                        char* pPtr = (char*) &pixel;
-
-                        for (size_t k = 0; k < sizeof (pixel); ++k)
-                            *writePtr++ = *pPtr++;
-                    }
-
+                    joinUint (planes, n, writePtr);
+                    writePtr += n * sizeof (unsigned int);
                     break;
 
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::HALF:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    tmpBufferEnd = ptr[1] + n;
+                    tmpBufferEnd += n * 2;
 
                     if (static_cast<uLong> (tmpBufferEnd - _tmpBuffer) > tmpSize)
                         notEnoughData ();
 
-                    for (int j = 0; j < n; ++j)
-                    {
-                        unsigned int diff = (*(ptr[0]++) << 8) | *(ptr[1]++);
-
-                        pixel += diff;
-
-                        half* hPtr = (half*) writePtr;
-                        hPtr->setBits ((unsigned short) pixel);
-                        writePtr += sizeof (half);
-                    }
-
+                    joinHalf (planes, n, writePtr);
+                    writePtr += n * sizeof (half);
                     break;
 
                 case OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT:
 
-                    ptr[0]       = tmpBufferEnd;
-                    ptr[1]       = ptr[0] + n;
-                    ptr[2]       = ptr[1] + n;
-                    tmpBufferEnd = ptr[2] + n;
+                    tmpBufferEnd += n * 3;
 
                     if (static_cast<uLong> (tmpBufferEnd - _tmpBuffer) > tmpSize)
                         notEnoughData ();
 
-                    for (int j = 0; j < n; ++j)
-                    {
-                        unsigned int diff = (*(ptr[0]++) << 24) |
-                                            (*(ptr[1]++) << 16) |
-                                            (*(ptr[2]++) << 8);
-                        pixel += diff;
-
-                        char* pPtr = (char*) &pixel;
-
-                        for (size_t k = 0; k < sizeof (pixel); ++k)
-                            *writePtr++ = *pPtr++;
-                    }
-
+                    joinFloat (planes, n, writePtr);
+                    writePtr += n * sizeof (float);
                     break;
 
                 default: assert (false);
@@ -489,4 +893,22 @@ Pxr24Compressor::uncompress (
     return writePtr - _outBuffer;
 }
 
+void
+Pxr24Compressor::initializeFuncs ()
+{
+    CpuId cpuId;
+
+#ifdef IMF_HAVE_SSE2
+    if (cpuId.sse2)
+    {
+        splitUint  = splitUint_sse2;
+        splitHalf  = splitHalf_sse2;
+        splitFloat = splitFloat_sse2;
+        joinUint   = joinUint_sse2;
+        joinHalf   = joinHalf_sse2;
+        joinFloat  = joinFloat_sse2;
+    }
+#endif
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
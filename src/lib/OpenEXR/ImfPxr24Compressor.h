@@ -51,6 +51,8 @@ public:
         IMATH_NAMESPACE::Box2i range,
         const char*&           outPtr);
 
+    static void initializeFuncs ();
+
 private:
     int compress (
         const char*            inPtr,
@@ -10,8 +10,10 @@
 //
 //-----------------------------------------------------------------------------
 
+#include "IlmThreadPool.h"
 #include <Iex.h>
 #include <ImathFun.h>
+#include <ImfArray.h>
 #include <ImfChannelList.h>
 #include <ImfInputPart.h>
 #include <ImfMultiPartInputFile.h>
@@ -30,6 +32,9 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 using namespace std;
 using namespace IMATH_NAMESPACE;
 using namespace RgbaYca;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 
 namespace
 {
@@ -138,6 +143,14 @@ cachePadding (ptrdiff_t size)
     return 0;
 }
 
+//
+// When RgbaInputFile::FromYca converts many scan lines at once, the
+// work is split into tasks of up to ycaLinesPerTask scan lines, which
+// keeps the per-task overhead small compared to the work.
+//
+
+const int ycaLinesPerTask = 64;
+
 } // namespace
 
 class RgbaOutputFile::ToYca : public std::mutex
@@ -756,12 +769,43 @@ public:
     void readPixels (int scanLine1, int scanLine2);
 
 private:
+    class HorizTask;
+    class RgbaTask;
+
     void readPixels (int scanLine);
+
+    void readBand (
+        int  scanLine1,
+        int  scanLine2,
+        Rgba ycaBuf[],
+        Rgba horizBuf[],
+        int& firstLine,
+        int& lastLine);
+
+    void readYCAScanLines (
+        int  scanLine1,
+        int  scanLine2,
+        Rgba ycaBuf[],
+        Rgba horizBuf[],
+        int  firstLine);
+
     void rotateBuf1 (int d);
     void rotateBuf2 (int d);
+    int  clampYCAScanLine (int y) const;
     void readYCAScanLine (int y, Rgba buf[]);
+    void padYCAScanLine (Rgba buf[]) const;
     void padTmpBuf ();
 
+    void convertScanLine (
+        const Rgba* const ycaLines[], int y, Rgba buf[]) const;
+
+    void convertScanLines (
+        const Rgba* const ycaLines[], int scanLine1, int scanLine2) const;
+
+    void writeScanLine (int y, const Rgba buf[]) const;
+
+    FrameBuffer ycaFrameBuffer (Rgba* base, size_t yStride) const;
+
     InputPart& _inputPart;
     bool       _readC;
     int        _xMin;
@@ -779,6 +823,7 @@ private:
     Rgba*      _fbBase;
     size_t     _fbXStride;
     size_t     _fbYStride;
+    string     _channelNamePrefix;
 };
 
 RgbaInputFile::FromYca::FromYca (
@@ -827,61 +872,74 @@ RgbaInputFile::FromYca::setFrameBuffer (
 {
     if (_fbBase == 0)
     {
-        FrameBuffer fb;
+        _channelNamePrefix = channelNamePrefix;
+        _inputPart.setFrameBuffer (ycaFrameBuffer (&_tmpBuf[N2 - _xMin], 0));
+    }
 
+    _fbBase    = base;
+    _fbXStride = xStride;
+    _fbYStride = yStride;
+}
+
+FrameBuffer
+RgbaInputFile::FromYca::ycaFrameBuffer (Rgba* base, size_t yStride) const
+{
+    //
+    // Build a frame buffer that reads luminance/chroma pixel (x,y)
+    // into base[x + y * yStride].  Chroma is stored only at even x
+    // and y coordinates.
+    //
+
+    FrameBuffer fb;
+
+    fb.insert (
+        _channelNamePrefix + "Y",
+        Slice (
+            HALF,                           // type
+            (char*) &base[0].g,             // base
+            sizeof (Rgba),                  // xStride
+            sizeof (Rgba) * yStride,        // yStride
+            1,                              // xSampling
+            1,                              // ySampling
+            0.5));                          // fillValue
+
+    if (_readC)
+    {
         fb.insert (
-            channelNamePrefix + "Y",
+            _channelNamePrefix + "RY",
             Slice (
                 HALF,                           // type
-                (char*) &_tmpBuf[N2 - _xMin].g, // base
-                sizeof (Rgba),                  // xStride
-                0,                              // yStride
-                1,                              // xSampling
-                1,                              // ySampling
-                0.5));                          // fillValue
-
-        if (_readC)
-        {
-            fb.insert (
-                channelNamePrefix + "RY",
-                Slice (
-                    HALF,                           // type
-                    (char*) &_tmpBuf[N2 - _xMin].r, // base
-                    sizeof (Rgba) * 2,              // xStride
-                    0,                              // yStride
-                    2,                              // xSampling
-                    2,                              // ySampling
-                    0.0));                          // fillValue
-
-            fb.insert (
-                channelNamePrefix + "BY",
-                Slice (
-                    HALF,                           // type
-                    (char*) &_tmpBuf[N2 - _xMin].b, // base
-                    sizeof (Rgba) * 2,              // xStride
-                    0,                              // yStride
-                    2,                              // xSampling
-                    2,                              // ySampling
-                    0.0));                          // fillValue
-        }
+                (char*) &base[0].r,             // base
+                sizeof (Rgba) * 2,              // xStride
+                sizeof (Rgba) * yStride * 2,    // yStride
+                2,                              // xSampling
+                2,                              // ySampling
+                0.0));                          // fillValue
 
         fb.insert (
-            channelNamePrefix + "A",
+            _channelNamePrefix + "BY",
             Slice (
                 HALF,                           // type
-                (char*) &_tmpBuf[N2 - _xMin].a, // base
-                sizeof (Rgba),                  // xStride
-                0,                              // yStride
-                1,                              // xSampling
-                1,                              // ySampling
-                1.0));                          // fillValue
-
-        _inputPart.setFrameBuffer (fb);
+                (char*) &base[0].b,             // base
+                sizeof (Rgba) * 2,              // xStride
+                sizeof (Rgba) * yStride * 2,    // yStride
+                2,                              // xSampling
+                2,                              // ySampling
+                0.0));                          // fillValue
     }
 
-    _fbBase    = base;
-    _fbXStride = xStride;
-    _fbYStride = yStride;
+    fb.insert (
+        _channelNamePrefix + "A",
+        Slice (
+            HALF,                           // type
+            (char*) &base[0].a,             // base
+            sizeof (Rgba),                  // xStride
+            sizeof (Rgba) * yStride,        // yStride
+            1,                              // xSampling
+            1,                              // ySampling
+            1.0));                          // fillValue
+
+    return fb;
 }
 
 void
@@ -890,15 +948,407 @@ RgbaInputFile::FromYca::readPixels (int scanLine1, int scanLine2)
     int minY = min (scanLine1, scanLine2);
     int maxY = max (scanLine1, scanLine2);
 
+    if (maxY - minY + 1 < N)
+    {
+        //
+        // Only a few scan lines were requested; convert them one
+        // at a time, using the scan line cache in _buf1 and _buf2.
+        //
+
+        if (_lineOrder == INCREASING_Y)
+        {
+            for (int y = minY; y <= maxY; ++y)
+                readPixels (y);
+        }
+        else
+        {
+            for (int y = maxY; y >= minY; --y)
+                readPixels (y);
+        }
+
+        return;
+    }
+
+    if (_fbBase == 0)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "No frame buffer was specified as the "
+            "pixel data destination for image file "
+            "\"" << _inputPart.fileName ()
+                 << "\".");
+    }
+
+    //
+    // Convert the scan lines in bands of up to ycaBandSize lines,
+    // visiting the bands in the order in which they are stored in
+    // the file.  ycaBuf and horizBuf hold the luminance/chroma scan
+    // lines firstLine through lastLine that are needed for the
+    // current band; see readBand().
+    //
+
+    const int ycaBandSize = 256;
+
+    size_t      ycaStride = _width + N - 1;
+    int         maxLines  = ycaBandSize + N + 1;
+    Array<Rgba> ycaBuf (maxLines * ycaStride);
+    Array<Rgba> horizBuf (maxLines * _width);
+    int         firstLine = 0;
+    int         lastLine  = -1;
+
     if (_lineOrder == INCREASING_Y)
     {
-        for (int y = minY; y <= maxY; ++y)
-            readPixels (y);
+        for (int y = minY; y <= maxY; y += ycaBandSize)
+        {
+            readBand (
+                y,
+                min (y + ycaBandSize - 1, maxY),
+                ycaBuf,
+                horizBuf,
+                firstLine,
+                lastLine);
+        }
+    }
+    else
+    {
+        for (int y = maxY; y >= minY; y -= ycaBandSize)
+        {
+            readBand (
+                max (y - ycaBandSize + 1, minY),
+                y,
+                ycaBuf,
+                horizBuf,
+                firstLine,
+                lastLine);
+        }
+    }
+}
+
+//
+// Horizontal chroma reconstruction for a range of scan lines in a band
+//
+
+class RgbaInputFile::FromYca::HorizTask : public Task
+{
+public:
+    HorizTask (
+        TaskGroup*     group,
+        const FromYca& fromYca,
+        Rgba*          ycaBuf,
+        Rgba*          horizBuf,
+        size_t         ycaStride,
+        int            line1,
+        int            line2,
+        int            firstLine)
+        : Task (group)
+        , _fromYca (fromYca)
+        , _ycaBuf (ycaBuf)
+        , _horizBuf (horizBuf)
+        , _ycaStride (ycaStride)
+        , _line1 (line1)
+        , _line2 (line2)
+        , _firstLine (firstLine)
+    {}
+
+    void execute () override;
+
+private:
+    const FromYca& _fromYca;
+    Rgba*          _ycaBuf;
+    Rgba*          _horizBuf;
+    size_t         _ycaStride;
+    int            _line1;
+    int            _line2;
+    int            _firstLine;
+};
+
+void
+RgbaInputFile::FromYca::HorizTask::execute ()
+{
+    int width = _fromYca._width;
+
+    for (int y = _line1; y <= _line2; ++y)
+    {
+        if (y & 1) continue;
+
+        Rgba* ycaIn = _ycaBuf + (y - _firstLine) * _ycaStride;
+
+        _fromYca.padYCAScanLine (ycaIn);
+
+        reconstructChromaHoriz (
+            width, ycaIn, _horizBuf + (y - _firstLine) * width);
+    }
+}
+
+//
+// Conversion of a range of scan lines in a band to RGBA,
+// with the output stored directly in the user's frame buffer
+//
+
+class RgbaInputFile::FromYca::RgbaTask : public Task
+{
+public:
+    RgbaTask (
+        TaskGroup*        group,
+        const FromYca&    fromYca,
+        const Rgba* const ycaLines[],
+        int               scanLine1,
+        int               scanLine2)
+        : Task (group)
+        , _fromYca (fromYca)
+        , _ycaLines (ycaLines)
+        , _scanLine1 (scanLine1)
+        , _scanLine2 (scanLine2)
+    {}
+
+    void execute () override
+    {
+        _fromYca.convertScanLines (_ycaLines, _scanLine1, _scanLine2);
+    }
+
+private:
+    const FromYca&     _fromYca;
+    const Rgba* const* _ycaLines;
+    int                _scanLine1;
+    int                _scanLine2;
+};
+
+void
+RgbaInputFile::FromYca::readBand (
+    int  scanLine1,
+    int  scanLine2,
+    Rgba ycaBuf[],
+    Rgba horizBuf[],
+    int& firstLine,
+    int& lastLine)
+{
+    //
+    // Convert scan lines scanLine1 through scanLine2 to RGB format
+    // without going through the scan line cache:
+    //
+    // All luminance/chroma scan lines that are needed to convert the
+    // band, that is, the band itself plus N2+1 extra lines above and
+    // below, are read from the file with a single readPixels() call,
+    // so that the underlying input file can decompress them in
+    // parallel.  Horizontal chroma reconstruction, vertical chroma
+    // reconstruction, conversion to RGB and desaturation are then
+    // split into tasks for the global thread pool.
+    //
+    // The conversion is not done by the tasks that decode the chunks
+    // of the file: the vertical filter needs N2+1 lines on either side
+    // of each output line, which belong to other chunks, so an output
+    // line can only be converted once several chunks are in memory.
+    // Converting a band in parallel after its chunks have been decoded
+    // keeps the tasks independent of each other.
+    //
+    // On entry, ycaBuf and horizBuf contain luminance/chroma scan
+    // lines firstLine through lastLine, which were read for the
+    // previous band.  Lines that are needed again are moved into
+    // place instead of being read a second time.
+    //
+    // The results are identical to reading the scan lines one by one.
+    //
+
+    int ycaLine1 = scanLine1 - N2 - 1;
+    int ycaLine2 = scanLine2 + N2 + 1;
+    int newFirst = clampYCAScanLine (ycaLine1);
+    int newLast  = newFirst;
+
+    for (int y = ycaLine1; y <= ycaLine2; ++y)
+    {
+        newFirst = min (newFirst, clampYCAScanLine (y));
+        newLast  = max (newLast, clampYCAScanLine (y));
+    }
+
+    size_t ycaStride = _width + N - 1;
+    int    keepFirst = max (newFirst, firstLine);
+    int    keepLast  = min (newLast, lastLine);
+
+    if (keepFirst <= keepLast)
+    {
+        memmove (
+            ycaBuf + (keepFirst - newFirst) * ycaStride,
+            ycaBuf + (keepFirst - firstLine) * ycaStride,
+            (keepLast - keepFirst + 1) * ycaStride * sizeof (Rgba));
+
+        memmove (
+            horizBuf + (keepFirst - newFirst) * _width,
+            horizBuf + (keepFirst - firstLine) * _width,
+            (keepLast - keepFirst + 1) * _width * sizeof (Rgba));
+
+        readYCAScanLines (
+            newFirst, keepFirst - 1, ycaBuf, horizBuf, newFirst);
+
+        readYCAScanLines (keepLast + 1, newLast, ycaBuf, horizBuf, newFirst);
     }
     else
     {
-        for (int y = maxY; y >= minY; --y)
-            readPixels (y);
+        readYCAScanLines (newFirst, newLast, ycaBuf, horizBuf, newFirst);
+    }
+
+    firstLine = newFirst;
+    lastLine  = newLast;
+
+    Array<const Rgba*> ycaLines (ycaLine2 - ycaLine1 + 1);
+
+    //
+    // ycaLines[i] points to luminance/chroma scan line ycaLine1 + i,
+    // with out-of-range lines clamped the same way as in
+    // readYCAScanLine().
+    //
+
+    for (int i = 0; i <= ycaLine2 - ycaLine1; ++i)
+    {
+        int y = clampYCAScanLine (ycaLine1 + i);
+
+        if (y & 1)
+            ycaLines[i] = ycaBuf + (y - firstLine) * ycaStride + N2;
+        else
+            ycaLines[i] = horizBuf + (y - firstLine) * _width;
+    }
+
+    {
+        TaskGroup taskGroup;
+
+        for (int y = scanLine1; y <= scanLine2; y += ycaLinesPerTask)
+        {
+            ThreadPool::addGlobalTask (new RgbaTask (
+                &taskGroup,
+                *this,
+                ycaLines + (y - scanLine1),
+                y,
+                min (y + ycaLinesPerTask - 1, scanLine2)));
+        }
+    }
+}
+
+void
+RgbaInputFile::FromYca::readYCAScanLines (
+    int scanLine1, int scanLine2, Rgba ycaBuf[], Rgba horizBuf[], int firstLine)
+{
+    //
+    // Read luminance/chroma scan lines scanLine1 through scanLine2
+    // into ycaBuf, where scan line y begins at ycaBuf[(y - firstLine)
+    // * ycaStride + N2], and reconstruct the missing chroma samples
+    // of the even-numbered lines in horizBuf.
+    //
+
+    if (scanLine1 > scanLine2) return;
+
+    size_t ycaStride = _width + N - 1;
+
+    {
+        FrameBuffer lineFb = _inputPart.frameBuffer ();
+
+        _inputPart.setFrameBuffer (ycaFrameBuffer (
+            &ycaBuf[N2 - _xMin - ptrdiff_t (firstLine * ycaStride)],
+            ycaStride));
+
+        try
+        {
+            _inputPart.readPixels (scanLine1, scanLine2);
+        }
+        catch (...)
+        {
+            _inputPart.setFrameBuffer (lineFb);
+            throw;
+        }
+
+        _inputPart.setFrameBuffer (lineFb);
+    }
+
+    if (!_readC)
+    {
+        for (int y = scanLine1; y <= scanLine2; ++y)
+        {
+            Rgba* ycaIn = ycaBuf + (y - firstLine) * ycaStride + N2;
+
+            for (int i = 0; i < _width; ++i)
+            {
+                ycaIn[i].r = 0;
+                ycaIn[i].b = 0;
+            }
+        }
+    }
+
+    TaskGroup taskGroup;
+
+    for (int y = scanLine1; y <= scanLine2; y += ycaLinesPerTask)
+    {
+        ThreadPool::addGlobalTask (new HorizTask (
+            &taskGroup,
+            *this,
+            ycaBuf,
+            horizBuf,
+            ycaStride,
+            y,
+            min (y + ycaLinesPerTask - 1, scanLine2),
+            firstLine));
+    }
+}
+
+void
+RgbaInputFile::FromYca::convertScanLines (
+    const Rgba* const ycaLines[], int scanLine1, int scanLine2) const
+{
+    //
+    // ycaLines[i] points to luminance/chroma scan line
+    // scanLine1 - N2 - 1 + i.  Convert scan lines scanLine1
+    // through scanLine2 to RGBA and store them in the frame buffer.
+    //
+
+    Array<Rgba> buf (4 * _width);
+    Rgba*       rgba[3] = {buf, buf + _width, buf + 2 * _width};
+    Rgba*       outBuf  = buf + 3 * _width;
+
+    convertScanLine (ycaLines, scanLine1 - 1, rgba[0]);
+    convertScanLine (ycaLines + 1, scanLine1, rgba[1]);
+
+    for (int y = scanLine1; y <= scanLine2; ++y)
+    {
+        convertScanLine (ycaLines + (y - scanLine1) + 2, y + 1, rgba[2]);
+
+        fixSaturation (_yw, _width, rgba, outBuf);
+        writeScanLine (y, outBuf);
+
+        Rgba* tmp = rgba[0];
+        rgba[0]   = rgba[1];
+        rgba[1]   = rgba[2];
+        rgba[2]   = tmp;
+    }
+}
+
+void
+RgbaInputFile::FromYca::convertScanLine (
+    const Rgba* const ycaLines[], int y, Rgba buf[]) const
+{
+    //
+    // ycaLines[0] through ycaLines[N-1] point to luminance/chroma
+    // scan lines y-N2 through y+N2.  Odd-numbered lines have no
+    // chroma data; reconstruct it from the even-numbered lines above
+    // and below before converting to RGB.
+    //
+
+    if (y & 1)
+    {
+        reconstructChromaVert (_width, ycaLines, buf);
+        YCAtoRGBA (_yw, _width, buf, buf);
+    }
+    else
+    {
+        YCAtoRGBA (_yw, _width, ycaLines[N2], buf);
+    }
+}
+
+void
+RgbaInputFile::FromYca::writeScanLine (int y, const Rgba buf[]) const
+{
+    intptr_t base = reinterpret_cast<intptr_t> (_fbBase);
+    for (int i = 0; i < _width; ++i)
+    {
+        Rgba* ptr = reinterpret_cast<Rgba*> (
+            base + sizeof (Rgba) * (_fbYStride * y + _fbXStride * (i + _xMin)));
+        *ptr = buf[i];
     }
 }
 
@@ -1006,15 +1456,7 @@ RgbaInputFile::FromYca::readPixels (int scanLine)
     }
 
     fixSaturation (_yw, _width, _buf2, _tmpBuf);
-
-    intptr_t base = reinterpret_cast<intptr_t> (_fbBase);
-    for (int i = 0; i < _width; ++i)
-    {
-        Rgba* ptr = reinterpret_cast<Rgba*> (
-            base +
-            sizeof (Rgba) * (_fbYStride * scanLine + _fbXStride * (i + _xMin)));
-        *ptr = _tmpBuf[i];
-    }
+    writeScanLine (scanLine, _tmpBuf);
     _currentScanLine = scanLine;
 }
 
@@ -1046,6 +1488,24 @@ RgbaInputFile::FromYca::rotateBuf2 (int d)
         _buf2[i] = tmp[(i + d) % 3];
 }
 
+int
+RgbaInputFile::FromYca::clampYCAScanLine (int y) const
+{
+    //
+    // Scan lines outside the data window are replaced by the first or
+    // the last scan line that contains chroma data.  (The data window
+    // of a file with subsampled chroma begins at an even-numbered and
+    // ends at an odd-numbered scan line.)
+    //
+
+    if (y < _yMin)
+        return _yMin;
+    else if (y > _yMax)
+        return _yMax - 1;
+    else
+        return y;
+}
+
 void
 RgbaInputFile::FromYca::readYCAScanLine (int y, Rgba* buf)
 {
@@ -1053,10 +1513,7 @@ RgbaInputFile::FromYca::readYCAScanLine (int y, Rgba* buf)
     // Clamp y.
     //
 
-    if (y < _yMin)
-        y = _yMin;
-    else if (y > _yMax)
-        y = _yMax - 1;
+    y = clampYCAScanLine (y);
 
     //
     // Read scan line y into _tmpBuf.
@@ -1089,10 +1546,22 @@ RgbaInputFile::FromYca::readYCAScanLine (int y, Rgba* buf)
 void
 RgbaInputFile::FromYca::padTmpBuf ()
 {
+    padYCAScanLine (_tmpBuf);
+}
+
+void
+RgbaInputFile::FromYca::padYCAScanLine (Rgba buf[]) const
+{
+    //
+    // Extend a scan line with _width pixels, starting at buf[N2], by
+    // N2 pixels on either side, replicating the first and the last
+    // pixel that have chroma data.
+    //
+
     for (int i = 0; i < N2; ++i)
     {
-        _tmpBuf[i]               = _tmpBuf[N2];
-        _tmpBuf[_width + N2 + i] = _tmpBuf[_width + N2 - 2];
+        buf[i]               = buf[N2];
+        buf[_width + N2 + i] = buf[_width + N2 - 2];
     }
 }
 
@@ -1364,7 +1833,10 @@ RgbaInputFile::readPixels (int scanLine1, int scanLine2)
             Box2i    dataWindow = _inputPart->header ().dataWindow ();
             intptr_t base       = reinterpret_cast<intptr_t> (s->base);
 
-            for (int scanLine = scanLine1; scanLine <= scanLine2; scanLine++)
+            int minY = min (scanLine1, scanLine2);
+            int maxY = max (scanLine1, scanLine2);
+
+            for (int scanLine = minY; scanLine <= maxY; scanLine++)
             {
                 intptr_t rowBase = base + scanLine * s->yStride;
                 for (int x = dataWindow.min.x; x <= dataWindow.max.x; ++x)
@@ -9,7 +9,9 @@
 //
 //-----------------------------------------------------------------------------
 
+#include "ImfSimd.h"
 #include <ImfRgbaYca.h>
+#include <ImfSystemSpecific.h>
 #include <algorithm>
 #include <assert.h>
 
@@ -187,6 +189,204 @@ roundYCA (
     }
 }
 
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+
+//
+// Vector versions of the chroma reconstruction filters and of
+// YCAtoRGBA(), selected at run time.  The pixels are processed in
+// pairs: the four half channels of two adjacent Rgba pixels are
+// converted to one vector of eight floats, so that no shuffling is
+// needed to separate the channels.  The channels that pass through
+// unchanged are copied from the input halfs.
+//
+// The results are the same as those of the scalar code: the products
+// are summed in the same order, without fused multiply-adds, and
+// vcvtps2ph rounds like half (float) for every value the arithmetic
+// can produce.
+//
+
+namespace
+{
+
+const float reconstructCoeffs[N2 + 1] = {
+    0.002128f,
+    -0.007540f,
+    0.019597f,
+    -0.043159f,
+    0.087929f,
+    -0.186077f,
+    0.627123f,
+    0.627123f,
+    -0.186077f,
+    0.087929f,
+    -0.043159f,
+    0.019597f,
+    -0.007540f,
+    0.002128f};
+
+bool
+haveF16c ()
+{
+    static const bool f16c = CpuId ().avx && CpuId ().f16c;
+    return f16c;
+}
+
+__attribute__ ((target ("avx,f16c"))) inline __m256
+loadRgba2 (const Rgba* in)
+{
+    return _mm256_cvtph_ps (_mm_loadu_si128 ((const __m128i*) in));
+}
+
+__attribute__ ((target ("avx,f16c"))) inline __m128i
+toHalf (__m256 v)
+{
+    return _mm256_cvtps_ph (v, _MM_FROUND_TO_NEAREST_INT);
+}
+
+//
+// Applies the reconstruction filter to two pixels; in[2*k] points
+// to the pixels that are multiplied by reconstructCoeffs[k].
+//
+
+__attribute__ ((target ("avx,f16c"))) inline __m128i
+filterRgba2 (const Rgba* const in[N2 + 1])
+{
+    __m256 acc = _mm256_mul_ps (
+        loadRgba2 (in[0]), _mm256_set1_ps (reconstructCoeffs[0]));
+
+    for (int k = 1; k < N2 + 1; ++k)
+    {
+        acc = _mm256_add_ps (
+            acc,
+            _mm256_mul_ps (
+                loadRgba2 (in[k]), _mm256_set1_ps (reconstructCoeffs[k])));
+    }
+
+    return toHalf (acc);
+}
+
+__attribute__ ((target ("avx,f16c"))) int
+reconstructChromaHoriz_f16c (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    //
+    // For each pair of pixels, starting at an even j, the filter
+    // result for pixel j+1 replaces its r and b channels (halfs
+    // 4 and 6 in the pair); pixel j passes through unchanged.
+    //
+
+    int j = 0;
+
+    for (; j + 1 < n; j += 2)
+    {
+        const Rgba* taps[N2 + 1];
+
+        for (int k = 0; k < N2 + 1; ++k)
+            taps[k] = ycaIn + j + 2 * k;
+
+        __m128i center = _mm_loadu_si128 ((const __m128i*) (ycaIn + N2 + j));
+
+        _mm_storeu_si128 (
+            (__m128i*) (ycaOut + j),
+            _mm_blend_epi16 (center, filterRgba2 (taps), 0x50));
+    }
+
+    return j;
+}
+
+__attribute__ ((target ("avx,f16c"))) int
+reconstructChromaVert_f16c (int n, const Rgba* const ycaIn[N], Rgba ycaOut[])
+{
+    //
+    // The filter results replace the r and b channels of both
+    // pixels in a pair (halfs 0, 2, 4 and 6).
+    //
+
+    int i = 0;
+
+    for (; i + 1 < n; i += 2)
+    {
+        const Rgba* taps[N2 + 1];
+
+        for (int k = 0; k < N2 + 1; ++k)
+            taps[k] = ycaIn[2 * k] + i;
+
+        __m128i center = _mm_loadu_si128 ((const __m128i*) (ycaIn[N2] + i));
+
+        _mm_storeu_si128 (
+            (__m128i*) (ycaOut + i),
+            _mm_blend_epi16 (center, filterRgba2 (taps), 0x55));
+    }
+
+    return i;
+}
+
+__attribute__ ((target ("avx,f16c"))) int
+YCAtoRGBA_f16c (const V3f& yw, int n, const Rgba ycaIn[], Rgba rgbaOut[])
+{
+    const __m256  one     = _mm256_set1_ps (1.0f);
+    const __m256  ywx     = _mm256_set1_ps (yw.x);
+    const __m256  ywy     = _mm256_set1_ps (yw.y);
+    const __m256  ywz     = _mm256_set1_ps (yw.z);
+    const __m128i absMask = _mm_set1_epi16 (0x7fff);
+
+    int i = 0;
+
+    for (; i + 1 < n; i += 2)
+    {
+        //
+        // Each 128-bit lane holds one pixel, RY, Y, BY, A.
+        //
+
+        __m128i h  = _mm_loadu_si128 ((const __m128i*) (ycaIn + i));
+        __m256  in = _mm256_cvtph_ps (h);
+        __m256  Y  = _mm256_permute_ps (in, _MM_SHUFFLE (1, 1, 1, 1));
+        __m256  rb = _mm256_mul_ps (_mm256_add_ps (in, one), Y);
+        __m256  r  = _mm256_permute_ps (rb, _MM_SHUFFLE (0, 0, 0, 0));
+        __m256  b  = _mm256_permute_ps (rb, _MM_SHUFFLE (2, 2, 2, 2));
+
+        __m256 g = _mm256_div_ps (
+            _mm256_sub_ps (
+                _mm256_sub_ps (Y, _mm256_mul_ps (r, ywx)),
+                _mm256_mul_ps (b, ywz)),
+            ywy);
+
+        __m128i out = toHalf (_mm256_blend_ps (rb, g, 0x22));
+
+        //
+        // Alpha is copied from the input.  In the special case where
+        // both chroma channels are 0 (see below), so are r, g and b,
+        // from the luminance.
+        //
+
+        out = _mm_blend_epi16 (out, h, 0x88);
+
+        __m128i yyya = _mm_shufflehi_epi16 (
+            _mm_shufflelo_epi16 (h, _MM_SHUFFLE (3, 1, 1, 1)),
+            _MM_SHUFFLE (3, 1, 1, 1));
+
+        __m128i isZero = _mm_cmpeq_epi16 (
+            _mm_and_si128 (h, absMask), _mm_setzero_si128 ());
+
+        isZero = _mm_and_si128 (
+            _mm_shufflehi_epi16 (
+                _mm_shufflelo_epi16 (isZero, _MM_SHUFFLE (0, 0, 0, 0)),
+                _MM_SHUFFLE (0, 0, 0, 0)),
+            _mm_shufflehi_epi16 (
+                _mm_shufflelo_epi16 (isZero, _MM_SHUFFLE (2, 2, 2, 2)),
+                _MM_SHUFFLE (2, 2, 2, 2)));
+
+        out = _mm_blendv_epi8 (out, yyya, isZero);
+
+        _mm_storeu_si128 ((__m128i*) (rgbaOut + i), out);
+    }
+
+    return i;
+}
+
+} // namespace
+
+#endif /* IMF_HAVE_X86_TARGET_ATTRIBUTE */
+
 void
 reconstructChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
 {
@@ -196,8 +396,13 @@ reconstructChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
 
     int begin = N2;
     int end   = begin + n;
+    int j     = 0;
 
-    for (int i = begin, j = 0; i < end; ++i, ++j)
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+    if (haveF16c ()) j = reconstructChromaHoriz_f16c (n, ycaIn, ycaOut);
+#endif
+
+    for (int i = begin + j; i < end; ++i, ++j)
     {
         if (j & 1)
         {
@@ -233,7 +438,13 @@ reconstructChromaHoriz (int n, const Rgba ycaIn[/*n+N-1*/], Rgba ycaOut[/*n*/])
 void
 reconstructChromaVert (int n, const Rgba* const ycaIn[N], Rgba ycaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+    if (haveF16c ()) i = reconstructChromaVert_f16c (n, ycaIn, ycaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         ycaOut[i].r = ycaIn[0][i].r * 0.002128f + ycaIn[2][i].r * -0.007540f +
                       ycaIn[4][i].r * 0.019597f + ycaIn[6][i].r * -0.043159f +
@@ -263,7 +474,13 @@ YCAtoRGBA (
     const Rgba                  ycaIn[/*n*/],
     Rgba                        rgbaOut[/*n*/])
 {
-    for (int i = 0; i < n; ++i)
+    int i = 0;
+
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+    if (haveF16c ()) i = YCAtoRGBA_f16c (yw, n, ycaIn, rgbaOut);
+#endif
+
+    for (; i < n; ++i)
     {
         const Rgba& in  = ycaIn[i];
         Rgba&       out = rgbaOut[i];
@@ -5,8 +5,13 @@
 
 #include "ImfRle.h"
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
 #include <string.h>
 
+#if defined(IMF_HAVE_SSE2) && defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 namespace
@@ -15,6 +20,104 @@ namespace
 const int MIN_RUN_LENGTH = 3;
 const int MAX_RUN_LENGTH = 127;
 
+#ifdef IMF_HAVE_SSE2
+
+const int BLOCK_SIZE = sizeof (__m128i);
+
+//
+// Index of the lowest set bit in a non-zero mask.
+//
+
+inline int
+firstSetBit (unsigned int mask)
+{
+#    ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward (&index, mask);
+    return int (index);
+#    else
+    return __builtin_ctz (mask);
+#    endif
+}
+
+//
+// Number of bytes in the whole blocks that cover count bytes.
+//
+
+inline int
+blockBytes (int count)
+{
+    return (count + BLOCK_SIZE - 1) & ~(BLOCK_SIZE - 1);
+}
+
+#endif
+
+//
+// Returns the first byte in [runEnd, limit) that differs
+// from *runStart, or limit if there is none.
+//
+
+inline const char*
+equalRunEnd (const char* runStart, const char* runEnd, const char* limit)
+{
+#ifdef IMF_HAVE_SSE2
+    const __m128i v = _mm_set1_epi8 (*runStart);
+
+    while (limit - runEnd >= BLOCK_SIZE)
+    {
+        __m128i d    = _mm_loadu_si128 ((const __m128i*) runEnd);
+        int     mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (d, v));
+
+        if (mask != 0xffff) return runEnd + firstSetBit (~mask & 0xffff);
+
+        runEnd += BLOCK_SIZE;
+    }
+#endif
+
+    while (runEnd < limit && *runStart == *runEnd)
+        ++runEnd;
+
+    return runEnd;
+}
+
+//
+// Returns the first byte in [runEnd, limit) that starts a run
+// of MIN_RUN_LENGTH equal bytes, or limit if there is none.
+//
+
+inline const char*
+literalRunEnd (const char* runEnd, const char* limit, const char* inEnd)
+{
+#ifdef IMF_HAVE_SSE2
+    //
+    // The comparisons look at up to two bytes past each block.
+    //
+
+    while (limit - runEnd >= BLOCK_SIZE && inEnd - runEnd >= BLOCK_SIZE + 2)
+    {
+        __m128i a = _mm_loadu_si128 ((const __m128i*) runEnd);
+        __m128i b = _mm_loadu_si128 ((const __m128i*) (runEnd + 1));
+        __m128i c = _mm_loadu_si128 ((const __m128i*) (runEnd + 2));
+
+        int mask = _mm_movemask_epi8 (
+            _mm_and_si128 (_mm_cmpeq_epi8 (a, b), _mm_cmpeq_epi8 (b, c)));
+
+        if (mask != 0) return runEnd + firstSetBit (mask);
+
+        runEnd += BLOCK_SIZE;
+    }
+#endif
+
+    while (runEnd < limit &&
+           (inEnd - runEnd <= 2 || *runEnd != *(runEnd + 1) ||
+            *(runEnd + 1) != *(runEnd + 2)))
+    {
+        ++runEnd;
+    }
+
+    return runEnd;
+}
+
 } // namespace
 
 //
@@ -32,11 +135,11 @@ rleCompress (int inLength, const char in[], signed char out[])
 
     while (runStart < inEnd)
     {
-        while (runEnd < inEnd && *runStart == *runEnd &&
-               runEnd - runStart - 1 < MAX_RUN_LENGTH)
-        {
-            ++runEnd;
-        }
+        const char* limit = inEnd - runStart > MAX_RUN_LENGTH + 1
+                                ? runStart + MAX_RUN_LENGTH + 1
+                                : inEnd;
+
+        runEnd = equalRunEnd (runStart, runEnd, limit);
 
         if (runEnd - runStart >= MIN_RUN_LENGTH)
         {
@@ -54,20 +157,17 @@ rleCompress (int inLength, const char in[], signed char out[])
             // Incompressible run
             //
 
-            while (runEnd < inEnd &&
-                   ((runEnd + 1 >= inEnd || *runEnd != *(runEnd + 1)) ||
-                    (runEnd + 2 >= inEnd || *(runEnd + 1) != *(runEnd + 2))) &&
-                   runEnd - runStart < MAX_RUN_LENGTH)
-            {
-                ++runEnd;
-            }
+            limit = inEnd - runStart > MAX_RUN_LENGTH
+                        ? runStart + MAX_RUN_LENGTH
+                        : inEnd;
+
+            runEnd = literalRunEnd (runEnd, limit, inEnd);
 
             *outWrite++ = runStart - runEnd;
 
-            while (runStart < runEnd)
-            {
-                *outWrite++ = *(signed char*) (runStart++);
-            }
+            memcpy (outWrite, runStart, runEnd - runStart);
+            outWrite += runEnd - runStart;
+            runStart = runEnd;
         }
 
         ++runEnd;
@@ -100,7 +200,27 @@ rleUncompress (int inLength, int maxLength, const signed char in[], char out[])
             // 'count' bytes of remaining data
             if (inLength < 0) return 0;
 
-            memcpy (out, in, count);
+#ifdef IMF_HAVE_SSE2
+            //
+            // Calling memcpy() costs more than the copy itself for
+            // short runs.  Copy whole blocks instead if both buffers
+            // have room past the end of the run.
+            //
+
+            if (blockBytes (count) - count <= inLength &&
+                blockBytes (count) - count <= maxLength)
+            {
+                for (int i = 0; i < count; i += BLOCK_SIZE)
+                {
+                    _mm_storeu_si128 (
+                        (__m128i*) (out + i),
+                        _mm_loadu_si128 ((const __m128i*) (in + i)));
+                }
+            }
+            else
+#endif
+                memcpy (out, in, count);
+
             out += count;
             in += count;
         }
@@ -115,7 +235,18 @@ rleUncompress (int inLength, int maxLength, const signed char in[], char out[])
             // byte to be duplicated
             if (inLength < 0) return 0;
 
-            memset (out, *(char*) in, count + 1);
+#ifdef IMF_HAVE_SSE2
+            if (blockBytes (count + 1) - (count + 1) <= maxLength)
+            {
+                const __m128i v = _mm_set1_epi8 (*(char*) in);
+
+                for (int i = 0; i <= count; i += BLOCK_SIZE)
+                    _mm_storeu_si128 ((__m128i*) (out + i), v);
+            }
+            else
+#endif
+                memset (out, *(char*) in, count + 1);
+
             out += count + 1;
 
             in++;
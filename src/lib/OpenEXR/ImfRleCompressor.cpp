@@ -14,6 +14,7 @@
 #include "ImfCheckedArithmetic.h"
 #include "ImfNamespace.h"
 #include "ImfRle.h"
+#include "ImfZip.h"
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
@@ -63,45 +64,10 @@ RleCompressor::compress (
     }
 
     //
-    // Reorder the pixel data.
+    // Reorder the pixel data and apply the predictor, as Zip does.
     //
 
-    {
-        char*       t1   = _tmpBuffer;
-        char*       t2   = _tmpBuffer + (inSize + 1) / 2;
-        const char* stop = inPtr + inSize;
-
-        while (true)
-        {
-            if (inPtr < stop)
-                *(t1++) = *(inPtr++);
-            else
-                break;
-
-            if (inPtr < stop)
-                *(t2++) = *(inPtr++);
-            else
-                break;
-        }
-    }
-
-    //
-    // Predictor.
-    //
-
-    {
-        unsigned char* t    = (unsigned char*) _tmpBuffer + 1;
-        unsigned char* stop = (unsigned char*) _tmpBuffer + inSize;
-        int            p    = t[-1];
-
-        while (t < stop)
-        {
-            int d = int (t[0]) - p + (128 + 256);
-            p     = t[0];
-            t[0]  = d;
-            ++t;
-        }
-    }
+    Zip::deconstructBytes (inPtr, inSize, _tmpBuffer);
 
     //
     // Run-length encode the data.
@@ -139,44 +105,10 @@ RleCompressor::uncompress (
     }
 
     //
-    // Predictor.
+    // Predictor, and reorder the pixel data.
     //
 
-    {
-        unsigned char* t    = (unsigned char*) _tmpBuffer + 1;
-        unsigned char* stop = (unsigned char*) _tmpBuffer + outSize;
-
-        while (t < stop)
-        {
-            int d = int (t[-1]) + int (t[0]) - 128;
-            t[0]  = d;
-            ++t;
-        }
-    }
-
-    //
-    // Reorder the pixel data.
-    //
-
-    {
-        const char* t1   = _tmpBuffer;
-        const char* t2   = _tmpBuffer + (outSize + 1) / 2;
-        char*       s    = _outBuffer;
-        char*       stop = s + outSize;
-
-        while (true)
-        {
-            if (s < stop)
-                *(s++) = *(t1++);
-            else
-                break;
-
-            if (s < stop)
-                *(s++) = *(t2++);
-            else
-                break;
-        }
-    }
+    Zip::reconstructBytes (_tmpBuffer, outSize, _outBuffer);
 
     outPtr = _outBuffer;
     return outSize;
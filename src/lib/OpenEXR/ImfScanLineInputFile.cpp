@@ -22,6 +22,7 @@
 #include "ImfOptimizedPixelReading.h"
 #include "ImfPartType.h"
 #include "ImfStandardAttributes.h"
+#include "ImfStatCounters.h"
 #include "ImfStdIO.h"
 #include "ImfThreading.h"
 #include "ImfVersion.h"
@@ -31,6 +32,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -39,6 +41,7 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 using ILMTHREAD_NAMESPACE::Semaphore;
 using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TASK_PRIORITY_NORMAL;
 using ILMTHREAD_NAMESPACE::TaskGroup;
 using ILMTHREAD_NAMESPACE::ThreadPool;
 using IMATH_NAMESPACE::Box2i;
@@ -66,6 +69,14 @@ struct InSliceInfo
     bool      skip;
     double    fillValue;
 
+    //
+    // Row copy kernels for NATIVE and XDR line buffers,
+    // selected once for the slice's types and stride
+    //
+
+    CopyIntoFrameBufferFunc copyNative;
+    CopyIntoFrameBufferFunc copyXdr;
+
     InSliceInfo (
         PixelType typeInFrameBuffer = HALF,
         PixelType typeInFile        = HALF,
@@ -100,8 +111,16 @@ InSliceInfo::InSliceInfo (
     , fill (f)
     , skip (s)
     , fillValue (fv)
+    , copyNative (0)
+    , copyXdr (0)
 {
-    // empty
+    if (!skip)
+    {
+        copyNative =
+            findCopyIntoFrameBuffer (fill, Compressor::NATIVE, tifb, tifl, xs);
+        copyXdr =
+            findCopyIntoFrameBuffer (fill, Compressor::XDR, tifb, tifl, xs);
+    }
 }
 
 struct LineBuffer
@@ -151,6 +170,41 @@ LineBuffer::~LineBuffer ()
     delete compressor;
 }
 
+//
+// Replaces a line buffer's chunk buffer by one that is allocated and
+// first touched by a thread of the pool that will decode into it, so
+// that its pages are placed on that thread's NUMA node.  The lines
+// cached in the buffer are discarded.  If the new buffer cannot be
+// allocated, the old one is kept.
+//
+
+class ReallocateBufferTask : public Task
+{
+public:
+    ReallocateBufferTask (
+        TaskGroup* group, LineBuffer* lineBuffer, size_t size)
+        : Task (group), _lineBuffer (lineBuffer), _size (size)
+    {}
+
+    void execute () override
+    {
+        char* buffer = (char*) EXRAllocAligned (_size, 16);
+
+        if (buffer)
+        {
+            memset (buffer, 0, _size);
+            EXRFreeAligned (_lineBuffer->buffer);
+            _lineBuffer->buffer           = buffer;
+            _lineBuffer->uncompressedData = 0;
+            _lineBuffer->number           = -1;
+        }
+    }
+
+private:
+    LineBuffer* _lineBuffer;
+    size_t      _size;
+};
+
 /// helper struct used to detect the order that the channels are stored
 
 struct sliceOptimizationData
@@ -175,6 +229,8 @@ struct sliceOptimizationData
     }
 };
 
+struct AsyncRead;
+
 } // namespace
 
 struct ScanLineInputFile::Data
@@ -204,14 +260,18 @@ struct ScanLineInputFile::Data
     vector<LineBuffer*> lineBuffers;   // each holds one line buffer
     int                 linesInBuffer; // number of scanlines each buffer
                                        // holds
-    size_t lineBufferSize;             // size of the line buffer
-    int    partNumber;                 // part number
+    size_t           lineBufferSize;   // size of the line buffer
+    int              partNumber;       // part number
+    std::atomic<int> taskPriority;     // priority of the decoding tasks
+    ThreadPool*      threadPool;       // runs the decoding tasks
 
     bool             memoryMapped;     // if the stream is memory mapped
     OptimizationMode optimizationMode; // optimizibility of the input file
     vector<sliceOptimizationData>
         optimizationData; ///< channel ordering for optimized reading
 
+    AsyncRead* asyncRead; // in-flight readPixelsAsync (), or null
+
     Data (int numThreads);
     ~Data ();
 
@@ -226,7 +286,11 @@ struct ScanLineInputFile::Data
 };
 
 ScanLineInputFile::Data::Data (int numThreads)
-    : partNumber (-1), memoryMapped (false)
+    : partNumber (-1)
+    , taskPriority (TASK_PRIORITY_NORMAL)
+    , threadPool (&ThreadPool::globalThreadPool ())
+    , memoryMapped (false)
+    , asyncRead (0)
 {
     //
     // We need at least one lineBuffer, but if threading is used,
@@ -368,23 +432,29 @@ readPixelData (
     if (lineOffset == 0)
         THROW (IEX_NAMESPACE::InputExc, "Scan line " << minY << " is missing.");
 
+    StatTimer timer (streamData->stats, &StatCounters::readNs);
+
     //
     // Seek to the start of the scan line in the file,
     // if necessary.
     //
 
-    if (!isMultiPart (ifd->version))
-    {
-        if (ifd->nextLineBufferMinY != minY) streamData->is->seekg (lineOffset);
-    }
+    bool seek;
+
+    if (!isMultiPart (ifd->version)) { seek = ifd->nextLineBufferMinY != minY; }
     else
     {
         //
         // In a multi-part file, the file pointer may have been moved by
         // other parts, so we have to ask tellg() where we are.
         //
-        if (streamData->is->tellg () != ifd->lineOffsets[lineBufferNumber])
-            streamData->is->seekg (lineOffset);
+        seek = streamData->is->tellg () != ifd->lineOffsets[lineBufferNumber];
+    }
+
+    if (seek)
+    {
+        streamData->is->seekg (lineOffset);
+        addStat (streamData->stats, &StatCounters::seeks, 1);
     }
 
     //
@@ -431,6 +501,9 @@ readPixelData (
     else
         streamData->is->read (buffer, dataSize);
 
+    addStat (streamData->stats, &StatCounters::reads, 1);
+    addStat (streamData->stats, &StatCounters::bytesRead, dataSize);
+
     //
     // Keep track of which scan line is the next one in
     // the file, so that we can avoid redundant seekg()
@@ -457,7 +530,8 @@ public:
         LineBuffer*              lineBuffer,
         int                      scanLineMin,
         int                      scanLineMax,
-        OptimizationMode         optimizationMode);
+        OptimizationMode         optimizationMode,
+        StatCounters*            stats);
 
     virtual ~LineBufferTask ();
 
@@ -469,6 +543,8 @@ private:
     int                      _scanLineMin;
     int                      _scanLineMax;
     OptimizationMode         _optimizationMode;
+    StatCounters*            _stats;  // null if statistics are disabled
+    uint64_t                 _queued; // time the task was created
 };
 
 LineBufferTask::LineBufferTask (
@@ -477,13 +553,16 @@ LineBufferTask::LineBufferTask (
     LineBuffer*              lineBuffer,
     int                      scanLineMin,
     int                      scanLineMax,
-    OptimizationMode         optimizationMode)
+    OptimizationMode         optimizationMode,
+    StatCounters*            stats)
     : Task (group)
     , _ifd (ifd)
     , _lineBuffer (lineBuffer)
     , _scanLineMin (scanLineMin)
     , _scanLineMax (scanLineMax)
     , _optimizationMode (optimizationMode)
+    , _stats (stats)
+    , _queued (statStart (stats))
 {
     // empty
 }
@@ -500,6 +579,8 @@ LineBufferTask::~LineBufferTask ()
 void
 LineBufferTask::execute ()
 {
+    addTimeSince (_stats, &StatCounters::queueNs, _queued);
+
     try
     {
         //
@@ -520,6 +601,8 @@ LineBufferTask::execute ()
             if (_lineBuffer->compressor &&
                 static_cast<size_t> (_lineBuffer->dataSize) < uncompressedSize)
             {
+                StatTimer timer (_stats, &StatCounters::decompressNs);
+
                 _lineBuffer->format = _lineBuffer->compressor->format ();
 
                 _lineBuffer->dataSize = _lineBuffer->compressor->uncompress (
@@ -538,8 +621,12 @@ LineBufferTask::execute ()
                 _lineBuffer->format           = Compressor::XDR;
                 _lineBuffer->uncompressedData = _lineBuffer->buffer;
             }
+
+            addChunkDecoded (_stats, _ifd->header, uncompressedSize);
         }
 
+        StatTimer timer (_stats, &StatCounters::copyNs);
+
         int yStart, yStop, dy;
 
         if (_ifd->lineOrder == INCREASING_Y)
@@ -620,16 +707,17 @@ LineBufferTask::execute ()
                     char* endPtr = reinterpret_cast<char*> (
                         linePtr + intptr_t (dMaxX) * intptr_t (slice.xStride));
 
-                    copyIntoFrameBuffer (
+                    CopyIntoFrameBufferFunc copy =
+                        _lineBuffer->format == Compressor::XDR
+                            ? slice.copyXdr
+                            : slice.copyNative;
+
+                    copy (
                         readPtr,
                         writePtr,
                         endPtr,
                         slice.xStride,
-                        slice.fill,
-                        slice.fillValue,
-                        _lineBuffer->format,
-                        slice.typeInFrameBuffer,
-                        slice.typeInFile);
+                        slice.fillValue);
                 }
             }
         }
@@ -666,7 +754,8 @@ public:
         LineBuffer*              lineBuffer,
         int                      scanLineMin,
         int                      scanLineMax,
-        OptimizationMode         optimizationMode);
+        OptimizationMode         optimizationMode,
+        StatCounters*            stats);
 
     virtual ~LineBufferTaskIIF ();
 
@@ -694,6 +783,8 @@ private:
     int                      _scanLineMin;
     int                      _scanLineMax;
     OptimizationMode         _optimizationMode;
+    StatCounters*            _stats;  // null if statistics are disabled
+    uint64_t                 _queued; // time the task was created
 };
 
 LineBufferTaskIIF::LineBufferTaskIIF (
@@ -702,13 +793,16 @@ LineBufferTaskIIF::LineBufferTaskIIF (
     LineBuffer*              lineBuffer,
     int                      scanLineMin,
     int                      scanLineMax,
-    OptimizationMode         optimizationMode)
+    OptimizationMode         optimizationMode,
+    StatCounters*            stats)
     : Task (group)
     , _ifd (ifd)
     , _lineBuffer (lineBuffer)
     , _scanLineMin (scanLineMin)
     , _scanLineMax (scanLineMax)
     , _optimizationMode (optimizationMode)
+    , _stats (stats)
+    , _queued (statStart (stats))
 {
     /*
      //
@@ -819,6 +913,8 @@ LineBufferTaskIIF::getWritePointerStereo (
 void
 LineBufferTaskIIF::execute ()
 {
+    addTimeSince (_stats, &StatCounters::queueNs, _queued);
+
     try
     {
         //
@@ -839,6 +935,8 @@ LineBufferTaskIIF::execute ()
             if (_lineBuffer->compressor &&
                 static_cast<size_t> (_lineBuffer->dataSize) < uncompressedSize)
             {
+                StatTimer timer (_stats, &StatCounters::decompressNs);
+
                 _lineBuffer->format = _lineBuffer->compressor->format ();
 
                 _lineBuffer->dataSize = _lineBuffer->compressor->uncompress (
@@ -857,8 +955,12 @@ LineBufferTaskIIF::execute ()
                 _lineBuffer->format           = Compressor::XDR;
                 _lineBuffer->uncompressedData = _lineBuffer->buffer;
             }
+
+            addChunkDecoded (_stats, _ifd->header, uncompressedSize);
         }
 
+        StatTimer timer (_stats, &StatCounters::copyNs);
+
         int yStart, yStop, dy;
 
         if (_ifd->lineOrder == INCREASING_Y)
@@ -1063,7 +1165,10 @@ newLineBufferTask (
 
     try
     {
-        lineBuffer->wait ();
+        {
+            StatTimer timer (streamData->stats, &StatCounters::bufferWaitNs);
+            lineBuffer->wait ();
+        }
 
         if (lineBuffer->number != number)
         {
@@ -1117,13 +1222,25 @@ newLineBufferTask (
     {
 
         retTask = new LineBufferTaskIIF (
-            group, ifd, lineBuffer, scanLineMin, scanLineMax, optimizationMode);
+            group,
+            ifd,
+            lineBuffer,
+            scanLineMin,
+            scanLineMax,
+            optimizationMode,
+            streamData->stats);
     }
     else
 #endif
     {
         retTask = new LineBufferTask (
-            group, ifd, lineBuffer, scanLineMin, scanLineMax, optimizationMode);
+            group,
+            ifd,
+            lineBuffer,
+            scanLineMin,
+            scanLineMax,
+            optimizationMode,
+            streamData->stats);
     }
 
     return retTask;
@@ -1131,6 +1248,379 @@ newLineBufferTask (
 
 static const int gLargeChunkTableSize = 1024 * 1024;
 
+//
+// The state of a readPixelsAsync() call.  The task group is declared
+// last, so that it is destroyed first: its destructor waits until all
+// tasks of the read have finished.
+//
+// A task that reads a line buffer from the file is queued only once
+// the line buffer is free; until then it is parked here, and the task
+// that frees the line buffer queues it.  No worker thread ever waits
+// for a line buffer, so the read does not depend on the order in which
+// the thread pool runs its tasks.
+//
+
+struct AsyncRead
+{
+    AsyncRead (
+        int                                     priority,
+        int                                     chunks,
+        size_t                                  numBuffers,
+        ThreadPool*                             threadPool,
+        const ScanLineInputFile::ChunkCallback& callback,
+        const char*                             fileName);
+
+    void fail (const char* what);
+    void finishChunks (int n);
+    void startRead (Task* readTask, size_t buffer);
+    void releaseBuffer (size_t buffer);
+
+    std::promise<void>               done;
+    ScanLineInputFile::ChunkCallback callback;
+    std::atomic<int>                 remaining; // chunks not yet finished
+    std::atomic<bool>                failed;
+    string                           exception; // what() of the first error
+    string                           fileName;
+    ThreadPool*                      threadPool;
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex bufferMutex; // protects busy and the parked read
+#endif
+    vector<bool> busy;         // line buffers in use by the read
+    Task*        parkedRead;   // read waiting for a line buffer, or null
+    size_t       parkedBuffer; // the line buffer it waits for
+    TaskGroup    group;
+};
+
+AsyncRead::AsyncRead (
+    int                                     priority,
+    int                                     chunks,
+    size_t                                  numBuffers,
+    ThreadPool*                             threadPool,
+    const ScanLineInputFile::ChunkCallback& callback,
+    const char*                             fileName)
+    : callback (callback)
+    , remaining (chunks)
+    , failed (false)
+    , fileName (fileName)
+    , threadPool (threadPool)
+    , busy (numBuffers, false)
+    , parkedRead (0)
+    , parkedBuffer (0)
+    , group (priority)
+{
+    // empty
+}
+
+void
+AsyncRead::startRead (Task* readTask, size_t buffer)
+{
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (bufferMutex);
+#endif
+        if (busy[buffer])
+        {
+            //
+            // The line buffers are read one at a time, so at most
+            // one read is parked.
+            //
+
+            parkedRead   = readTask;
+            parkedBuffer = buffer;
+            return;
+        }
+
+        busy[buffer] = true;
+    }
+
+    threadPool->addTask (readTask);
+}
+
+void
+AsyncRead::releaseBuffer (size_t buffer)
+{
+    Task* readTask = 0;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (bufferMutex);
+#endif
+        if (parkedRead && parkedBuffer == buffer)
+        {
+            //
+            // Hand the line buffer over to the parked read.
+            //
+
+            readTask   = parkedRead;
+            parkedRead = 0;
+        }
+        else
+            busy[buffer] = false;
+    }
+
+    if (readTask) threadPool->addTask (readTask);
+}
+
+void
+AsyncRead::fail (const char* what)
+{
+    bool expected = false;
+    if (failed.compare_exchange_strong (expected, true)) exception = what;
+}
+
+void
+AsyncRead::finishChunks (int n)
+{
+    if (remaining.fetch_sub (n) != n) return;
+
+    //
+    // This was the last chunk.  The error, if any, is reported the
+    // way readPixels() reports it.
+    //
+
+    if (failed)
+    {
+        done.set_exception (std::make_exception_ptr (IEX_NAMESPACE::IoExc (
+            "Error reading pixel data from image file \"" + fileName +
+            "\". " + exception)));
+    }
+    else
+        done.set_value ();
+}
+
+//
+// Decodes one line buffer of an asynchronous read, with the task that
+// newLineBufferTask() created for it, then reports the scan lines.
+//
+
+class AsyncLineBufferTask : public Task
+{
+public:
+    AsyncLineBufferTask (
+        AsyncRead*  read,
+        Task*       decodeTask,
+        LineBuffer* lineBuffer,
+        size_t      buffer,
+        int         scanLineMin,
+        int         scanLineMax);
+
+    virtual ~AsyncLineBufferTask ();
+
+    virtual void execute ();
+
+private:
+    AsyncRead*  _read;
+    Task*       _decodeTask;
+    LineBuffer* _lineBuffer;
+    size_t      _buffer; // index of the line buffer
+    int         _scanLineMin;
+    int         _scanLineMax;
+};
+
+AsyncLineBufferTask::AsyncLineBufferTask (
+    AsyncRead*  read,
+    Task*       decodeTask,
+    LineBuffer* lineBuffer,
+    size_t      buffer,
+    int         scanLineMin,
+    int         scanLineMax)
+    : Task (&read->group)
+    , _read (read)
+    , _decodeTask (decodeTask)
+    , _lineBuffer (lineBuffer)
+    , _buffer (buffer)
+    , _scanLineMin (scanLineMin)
+    , _scanLineMax (scanLineMax)
+{
+    // empty
+}
+
+AsyncLineBufferTask::~AsyncLineBufferTask ()
+{
+    delete _decodeTask;
+}
+
+void
+AsyncLineBufferTask::execute ()
+{
+    _decodeTask->execute ();
+
+    bool ok = !_lineBuffer->hasException;
+
+    if (!ok)
+    {
+        _read->fail (_lineBuffer->exception.c_str ());
+        _lineBuffer->hasException = false;
+    }
+
+    //
+    // Deleting the decode task frees the line buffer for the
+    // next chunk.
+    //
+
+    delete _decodeTask;
+    _decodeTask = 0;
+
+    _read->releaseBuffer (_buffer);
+
+    if (ok && _read->callback)
+    {
+        try
+        {
+            _read->callback (_scanLineMin, _scanLineMax);
+        }
+        catch (std::exception& e)
+        {
+            _read->fail (e.what ());
+        }
+        catch (...)
+        {
+            _read->fail ("unrecognized exception");
+        }
+    }
+
+    _read->finishChunks (1);
+}
+
+//
+// Reads line buffer number l of an asynchronous read from the file,
+// queues the task that decodes it, and then starts the task that reads
+// the next line buffer.  Reading the line buffers one after another,
+// in file order, keeps the file access sequential.  The task is queued
+// only once its line buffer is free (see AsyncRead), so reading the
+// line buffer never waits.
+//
+
+class AsyncReadTask : public Task
+{
+public:
+    AsyncReadTask (
+        AsyncRead*               read,
+        InputStreamMutex*        streamData,
+        ScanLineInputFile::Data* ifd,
+        int                      l,
+        int                      stop,
+        int                      dl,
+        int                      scanLineMin,
+        int                      scanLineMax);
+
+    virtual void execute ();
+
+private:
+    AsyncRead*               _read;
+    InputStreamMutex*        _streamData;
+    ScanLineInputFile::Data* _ifd;
+    int                      _l;
+    int                      _stop;
+    int                      _dl;
+    int                      _scanLineMin;
+    int                      _scanLineMax;
+};
+
+AsyncReadTask::AsyncReadTask (
+    AsyncRead*               read,
+    InputStreamMutex*        streamData,
+    ScanLineInputFile::Data* ifd,
+    int                      l,
+    int                      stop,
+    int                      dl,
+    int                      scanLineMin,
+    int                      scanLineMax)
+    : Task (&read->group)
+    , _read (read)
+    , _streamData (streamData)
+    , _ifd (ifd)
+    , _l (l)
+    , _stop (stop)
+    , _dl (dl)
+    , _scanLineMin (scanLineMin)
+    , _scanLineMax (scanLineMax)
+{
+    // empty
+}
+
+void
+AsyncReadTask::execute ()
+{
+    Task*       decodeTask = 0;
+    LineBuffer* lineBuffer = _ifd->getLineBuffer (_l);
+
+    try
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        StatTimer lockTimer (_streamData->stats, &StatCounters::lockWaitNs);
+        std::lock_guard<std::mutex> lock (*_streamData);
+        lockTimer.stop ();
+#endif
+        decodeTask = newLineBufferTask (
+            0,
+            _streamData,
+            _ifd,
+            _l,
+            _scanLineMin,
+            _scanLineMax,
+            _ifd->optimizationMode);
+    }
+    catch (std::exception& e)
+    {
+        _read->fail (e.what ());
+    }
+    catch (...)
+    {
+        _read->fail ("unrecognized exception");
+    }
+
+    if (!decodeTask)
+    {
+        //
+        // Reading failed; the remaining line buffers are not read.
+        //
+
+        _read->releaseBuffer (_l % _ifd->lineBuffers.size ());
+        _read->finishChunks ((_stop - _l) * _dl);
+        return;
+    }
+
+    _ifd->threadPool->addTask (new AsyncLineBufferTask (
+        _read,
+        decodeTask,
+        lineBuffer,
+        _l % _ifd->lineBuffers.size (),
+        max (lineBuffer->minY, _scanLineMin),
+        min (lineBuffer->maxY, _scanLineMax)));
+
+    if (_l + _dl != _stop)
+    {
+        int next = _l + _dl;
+
+        _read->startRead (
+            new AsyncReadTask (
+                _read,
+                _streamData,
+                _ifd,
+                next,
+                _stop,
+                _dl,
+                _scanLineMin,
+                _scanLineMax),
+            next % _ifd->lineBuffers.size ());
+    }
+}
+
+//
+// Waits for the file's asynchronous read, if there is one, to finish.
+//
+
+void
+waitForAsyncRead (ScanLineInputFile::Data* ifd)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*ifd);
+#endif
+    delete ifd->asyncRead;
+    ifd->asyncRead = 0;
+}
+
 } // namespace
 
 void
@@ -1309,6 +1799,8 @@ ScanLineInputFile::ScanLineInputFile (
 
 ScanLineInputFile::~ScanLineInputFile ()
 {
+    waitForAsyncRead (_data);
+
     if (!_data->memoryMapped)
     {
         for (size_t i = 0; i < _data->lineBuffers.size (); i++)
@@ -1417,18 +1909,30 @@ detectOptimizationMode (const vector<sliceOptimizationData>& optData)
 void
 ScanLineInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
 {
+    waitForAsyncRead (_data);
+
 #if ILMTHREAD_THREADING_ENABLED
     std::lock_guard<std::mutex> lock (*_streamData);
 #endif
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&         channels = _data->header.channels ();
+    ChannelList::ConstIterator i        = channels.begin ();
+
+    //
+    // The slices and the channels are both sorted by name,
+    // so the channel for each slice is found in a single pass.
+    //
+
     for (FrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
          ++j)
     {
-        ChannelList::ConstIterator i = channels.find (j.name ());
+        while (i != channels.end () && strcmp (i.name (), j.name ()) < 0)
+            ++i;
+
+        if (i == channels.end ()) break;
 
-        if (i == channels.end ()) continue;
+        if (strcmp (i.name (), j.name ()) > 0) continue;
 
         if (i.channel ().xSampling != j.slice ().xSampling ||
             i.channel ().ySampling != j.slice ().ySampling)
@@ -1458,8 +1962,8 @@ ScanLineInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     // Initialize the slice table for readPixels().
     //
 
-    vector<InSliceInfo>        slices;
-    ChannelList::ConstIterator i = channels.begin ();
+    vector<InSliceInfo> slices;
+    i = channels.begin ();
 
     // current offset of channel: pixel data starts at offset*width into the
     // decompressed scanline buffer
@@ -1632,10 +2136,14 @@ ScanLineInputFile::isOptimizationEnabled () const
 void
 ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
 {
+    waitForAsyncRead (_data);
+
     try
     {
 #if ILMTHREAD_THREADING_ENABLED
+        StatTimer lockTimer (_streamData->stats, &StatCounters::lockWaitNs);
         std::lock_guard<std::mutex> lock (*_streamData);
+        lockTimer.stop ();
 #endif
         if (_data->slices.size () == 0)
             throw IEX_NAMESPACE::ArgExc (
@@ -1679,7 +2187,7 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
         //
 
         {
-            TaskGroup taskGroup;
+            TaskGroup taskGroup (_data->taskPriority);
 
             //
             // Add the line buffer tasks.
@@ -1693,7 +2201,7 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
 
             for (int l = start; l != stop; l += dl)
             {
-                ThreadPool::addGlobalTask (newLineBufferTask (
+                _data->threadPool->addTask (newLineBufferTask (
                     &taskGroup,
                     _streamData,
                     _data,
@@ -1754,10 +2262,100 @@ ScanLineInputFile::readPixels (int scanLine)
     readPixels (scanLine, scanLine);
 }
 
+void
+ScanLineInputFile::waitForPendingRead ()
+{
+    waitForAsyncRead (_data);
+}
+
+std::future<void>
+ScanLineInputFile::readPixelsAsync (
+    int scanLine1, int scanLine2, const ChunkCallback& callback)
+{
+    if (_data->slices.size () == 0)
+        throw IEX_NAMESPACE::ArgExc (
+            "No frame buffer specified as pixel data destination.");
+
+    int scanLineMin = min (scanLine1, scanLine2);
+    int scanLineMax = max (scanLine1, scanLine2);
+
+    if (scanLineMin < _data->minY || scanLineMax > _data->maxY)
+        throw IEX_NAMESPACE::ArgExc ("Tried to read scan line outside "
+                                     "the image file's data window.");
+
+    if (_data->threadPool->numThreads () == 0)
+    {
+        std::promise<void> done;
+
+        try
+        {
+            readPixels (scanLineMin, scanLineMax);
+            if (callback) callback (scanLineMin, scanLineMax);
+            done.set_value ();
+        }
+        catch (...)
+        {
+            done.set_exception (std::current_exception ());
+        }
+
+        return done.get_future ();
+    }
+
+    //
+    // The line buffers are read in file order, as in readPixels().
+    //
+
+    int start, stop, dl;
+
+    if (_data->lineOrder == INCREASING_Y)
+    {
+        start = (scanLineMin - _data->minY) / _data->linesInBuffer;
+        stop  = (scanLineMax - _data->minY) / _data->linesInBuffer + 1;
+        dl    = 1;
+    }
+    else
+    {
+        start = (scanLineMax - _data->minY) / _data->linesInBuffer;
+        stop  = (scanLineMin - _data->minY) / _data->linesInBuffer - 1;
+        dl    = -1;
+    }
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_data);
+#endif
+
+    delete _data->asyncRead;
+    _data->asyncRead = new AsyncRead (
+        _data->taskPriority,
+        (stop - start) * dl,
+        _data->lineBuffers.size (),
+        _data->threadPool,
+        callback,
+        fileName ());
+
+    std::future<void> result = _data->asyncRead->done.get_future ();
+
+    _data->asyncRead->startRead (
+        new AsyncReadTask (
+            _data->asyncRead,
+            _streamData,
+            _data,
+            start,
+            stop,
+            dl,
+            scanLineMin,
+            scanLineMax),
+        start % _data->lineBuffers.size ());
+
+    return result;
+}
+
 void
 ScanLineInputFile::rawPixelData (
     int firstScanLine, const char*& pixelData, int& pixelDataSize)
 {
+    waitForAsyncRead (_data);
+
     try
     {
 #if ILMTHREAD_THREADING_ENABLED
@@ -1796,6 +2394,8 @@ void
 ScanLineInputFile::rawPixelDataToBuffer (
     int scanLine, char* pixelData, int& pixelDataSize) const
 {
+    waitForAsyncRead (_data);
+
     if (_data->memoryMapped)
     {
         throw IEX_NAMESPACE::ArgExc ("Reading raw pixel data to a buffer "
@@ -1827,4 +2427,49 @@ ScanLineInputFile::rawPixelDataToBuffer (
     }
 }
 
+Statistics
+ScanLineInputFile::statistics () const
+{
+    return _streamData->statistics ();
+}
+
+void
+ScanLineInputFile::setTaskPriority (int priority)
+{
+    _data->taskPriority = priority;
+}
+
+int
+ScanLineInputFile::taskPriority () const
+{
+    return _data->taskPriority;
+}
+
+void
+ScanLineInputFile::setThreadPool (ThreadPool* pool)
+{
+    waitForAsyncRead (_data);
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+    _data->threadPool = pool ? pool : &ThreadPool::globalThreadPool ();
+
+    if (_data->memoryMapped || _data->threadPool->numThreads () == 0) return;
+
+    TaskGroup taskGroup;
+
+    for (size_t i = 0; i < _data->lineBuffers.size (); i++)
+    {
+        _data->threadPool->addTask (new ReallocateBufferTask (
+            &taskGroup, _data->lineBuffers[i], _data->lineBufferSize));
+    }
+}
+
+ThreadPool*
+ScanLineInputFile::threadPool () const
+{
+    return _data->threadPool;
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
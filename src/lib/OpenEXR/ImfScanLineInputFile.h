@@ -17,6 +17,9 @@
 #include "ImfGenericInputFile.h"
 #include "ImfThreading.h"
 
+#include <functional>
+#include <future>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 class IMF_EXPORT_TYPE ScanLineInputFile : public GenericInputFile
@@ -143,6 +146,45 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read pixel data without waiting for it:
+    //
+    // readPixelsAsync(s1,s2) reads the same scan lines as
+    // readPixels(s1,s2), but returns as soon as the work has been
+    // queued in the file's thread pool.  Reading the chunks from
+    // the file happens in the pool too, one chunk at a time, so no
+    // thread is dedicated to the read.  A chunk is read only once
+    // a line buffer is free for it, so no worker waits for a line
+    // buffer, whatever order the pool runs its tasks in; a worker
+    // waits for the file only while another thread, for example
+    // one reading another part, reads from it.  The returned
+    // future becomes ready when all scan lines are in the frame
+    // buffer; get() rethrows the first error, as readPixels()
+    // would have thrown.  Invalid arguments throw immediately.
+    //
+    // If a callback is given, it is called from a worker thread
+    // with the y range of each chunk once the chunk's scan lines
+    // are in the frame buffer.  The ranges cover [min (s1, s2),
+    // max (s1, s2)], but may arrive in any order.  The callback
+    // must not call back into the file.
+    //
+    // Only one read can be in flight per file: setFrameBuffer(),
+    // readPixels(), readPixelsAsync() and the destructor first
+    // wait for an earlier readPixelsAsync() to finish.  The frame
+    // buffer must stay valid until then.  If the file's thread
+    // pool has no threads, the read is performed before the
+    // function returns.
+    //---------------------------------------------------------------
+
+    typedef std::function<void (int scanLineMin, int scanLineMax)>
+        ChunkCallback;
+
+    IMF_EXPORT
+    std::future<void> readPixelsAsync (
+        int                  scanLine1,
+        int                  scanLine2,
+        const ChunkCallback& callback = ChunkCallback ());
+
     //----------------------------------------------
     // Read a block of raw pixel data from the file,
     // without uncompressing it (this function is
@@ -173,6 +215,49 @@ public:
     void rawPixelDataToBuffer (
         int scanLine, char* pixelData, int& pixelDataSize) const;
 
+    //---------------------------------------------------------
+    // Statistics about reading the file (see ImfStatistics.h).
+    // The counters are zero unless statistics were enabled
+    // when the file was opened.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    Statistics statistics () const;
+
+    //---------------------------------------------------------
+    // Priority of the thread pool tasks that readPixels() and
+    // readTiles() create for this file (see IlmThreadPool.h).
+    // Tasks of a file with a higher priority, for example
+    // IlmThread::TASK_PRIORITY_INTERACTIVE, are executed before
+    // queued tasks of files with a lower priority, such as
+    // frames that are being prefetched in the background.
+    // The default is IlmThread::TASK_PRIORITY_NORMAL.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setTaskPriority (int priority);
+
+    IMF_EXPORT
+    int taskPriority () const;
+
+    //---------------------------------------------------------
+    // The thread pool that runs the decoding tasks of this file,
+    // by default the global thread pool.  Passing a pool bound
+    // to a NUMA node (see IlmThreadPool.h) keeps the decoding on
+    // that node; the file's chunk buffers are then reallocated
+    // by the pool's threads, so that their memory is local to
+    // the node too.  A null pool selects the global pool again.
+    // The pool must outlive the reads of the file; to keep all
+    // of its threads busy, open the file with numThreads equal
+    // to the pool's numThreads().
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool);
+
+    IMF_EXPORT
+    ILMTHREAD_NAMESPACE::ThreadPool* threadPool () const;
+
     struct IMF_HIDDEN Data;
 
 private:
@@ -184,6 +269,8 @@ private:
 
     IMF_HIDDEN void initialize (const Header& header);
 
+    IMF_HIDDEN void waitForPendingRead ();
+
     friend class MultiPartInputFile;
     friend class InputFile;
 };
@@ -10,6 +10,11 @@
 // Compile time SSE detection:
 //    IMF_HAVE_SSE2 - Defined if it's safe to compile SSE2 optimizations
 //    IMF_HAVE_SSE4_1 - Defined if it's safe to compile SSE4.1 optimizations
+//    IMF_HAVE_X86_TARGET_ATTRIBUTE - Defined if optimizations that use
+//                                    SSE4.1, AVX, AVX2 or F16C instructions
+//                                    can be compiled with per-function
+//                                    target attributes, to be selected at
+//                                    run time
 //
 
 // GCC and Visual Studio SSE2 compiler flags
@@ -46,6 +51,12 @@
 #    define IMF_HAVE_NEON
 #endif
 
+// GCC and clang on x86-64 support the target attribute
+#if (defined(__x86_64__) || defined(_M_X64)) &&                                \
+    (defined(__GNUC__) || defined(__clang__))
+#    define IMF_HAVE_X86_TARGET_ATTRIBUTE 1
+#endif
+
 extern "C" {
 #ifdef IMF_HAVE_SSE2
 #    include <emmintrin.h>
@@ -60,6 +71,10 @@ extern "C" {
 #    include <arm_neon.h>
 #endif
 
+#ifdef IMF_HAVE_X86_TARGET_ATTRIBUTE
+#    include <immintrin.h>
+#endif
+
 }
 
 #endif
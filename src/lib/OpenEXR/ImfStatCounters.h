@@ -0,0 +1,141 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_STAT_COUNTERS_H
+#define INCLUDED_IMF_STAT_COUNTERS_H
+
+//-----------------------------------------------------------------------------
+//
+//	struct StatCounters, class StatTimer
+//
+//	The counters behind struct Statistics (see ImfStatistics.h).
+//	A file allocates its counters only if statistics are enabled
+//	when it is opened.  All updates check for null counters first,
+//	so disabled statistics cost a single branch per event.  Every
+//	update of a file's counters also updates the global counters.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfHeader.h"
+#include "ImfStatistics.h"
+
+#include <atomic>
+#include <chrono>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+struct StatCounters
+{
+    typedef std::atomic<uint64_t> Counter;
+
+    Counter bytesRead;
+    Counter reads;
+    Counter seeks;
+    Counter chunksDecoded[NUM_COMPRESSION_METHODS];
+    Counter bytesDecompressed;
+
+    Counter readNs;
+    Counter lockWaitNs;
+    Counter bufferWaitNs;
+    Counter queueNs;
+    Counter decompressNs;
+    Counter copyNs;
+
+    StatCounters ();
+
+    void get (Statistics& s) const;
+    void reset ();
+};
+
+//
+// Counters for a newly opened file: null if statistics are disabled.
+//
+
+StatCounters* newStatCounters ();
+
+StatCounters& globalStatCounters ();
+
+inline uint64_t
+statNow ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+               std::chrono::steady_clock::now ().time_since_epoch ())
+        .count ();
+}
+
+inline void
+addStat (
+    StatCounters* c, StatCounters::Counter StatCounters::*counter, uint64_t n)
+{
+    if (c)
+    {
+        (c->*counter).fetch_add (n, std::memory_order_relaxed);
+        (globalStatCounters ().*counter)
+            .fetch_add (n, std::memory_order_relaxed);
+    }
+}
+
+inline uint64_t
+statStart (StatCounters* c)
+{
+    return c ? statNow () : 0;
+}
+
+inline void
+addTimeSince (
+    StatCounters* c, StatCounters::Counter StatCounters::*counter, uint64_t t)
+{
+    if (c) addStat (c, counter, statNow () - t);
+}
+
+inline void
+addChunkDecoded (StatCounters* c, const Header& header, uint64_t size)
+{
+    if (!c) return;
+
+    Compression compression = header.compression ();
+
+    if (compression < NUM_COMPRESSION_METHODS)
+    {
+        StatCounters& g = globalStatCounters ();
+        c->chunksDecoded[compression].fetch_add (1, std::memory_order_relaxed);
+        g.chunksDecoded[compression].fetch_add (1, std::memory_order_relaxed);
+    }
+
+    addStat (c, &StatCounters::bytesDecompressed, size);
+}
+
+//
+// Adds the time between its construction and stop(), or its
+// destruction, to a counter.
+//
+
+class StatTimer
+{
+public:
+    StatTimer (StatCounters* c, StatCounters::Counter StatCounters::*counter)
+        : _c (c), _counter (counter), _start (statStart (c))
+    {}
+
+    ~StatTimer () { stop (); }
+
+    void stop ()
+    {
+        addTimeSince (_c, _counter, _start);
+        _c = 0;
+    }
+
+    StatTimer (const StatTimer&)            = delete;
+    StatTimer& operator= (const StatTimer&) = delete;
+
+private:
+    StatCounters*                        _c;
+    StatCounters::Counter StatCounters::*_counter;
+    uint64_t                             _start;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,125 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	Statistics about reading OpenEXR files
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfStatCounters.h"
+#include "ImfStatistics.h"
+
+#include <cstring>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+std::atomic<bool> enabled (false);
+
+double
+seconds (const StatCounters::Counter& ns)
+{
+    return ns.load (std::memory_order_relaxed) * 1e-9;
+}
+
+} // namespace
+
+Statistics::Statistics ()
+{
+    static_assert (
+        NUM_COMPRESSION_METHODS <= COMPRESSION_SLOTS,
+        "Statistics::chunksDecoded is too small");
+
+    memset (this, 0, sizeof (*this));
+}
+
+StatCounters::StatCounters ()
+{
+    reset ();
+}
+
+void
+StatCounters::get (Statistics& s) const
+{
+    s.bytesRead = bytesRead.load (std::memory_order_relaxed);
+    s.reads     = reads.load (std::memory_order_relaxed);
+    s.seeks     = seeks.load (std::memory_order_relaxed);
+
+    for (int i = 0; i < NUM_COMPRESSION_METHODS; ++i)
+        s.chunksDecoded[i] = chunksDecoded[i].load (std::memory_order_relaxed);
+
+    s.bytesDecompressed = bytesDecompressed.load (std::memory_order_relaxed);
+
+    s.readTime       = seconds (readNs);
+    s.lockWaitTime   = seconds (lockWaitNs);
+    s.bufferWaitTime = seconds (bufferWaitNs);
+    s.queueTime      = seconds (queueNs);
+    s.decompressTime = seconds (decompressNs);
+    s.copyTime       = seconds (copyNs);
+}
+
+void
+StatCounters::reset ()
+{
+    bytesRead = 0;
+    reads     = 0;
+    seeks     = 0;
+
+    for (int i = 0; i < NUM_COMPRESSION_METHODS; ++i)
+        chunksDecoded[i] = 0;
+
+    bytesDecompressed = 0;
+
+    readNs       = 0;
+    lockWaitNs   = 0;
+    bufferWaitNs = 0;
+    queueNs      = 0;
+    decompressNs = 0;
+    copyNs       = 0;
+}
+
+StatCounters*
+newStatCounters ()
+{
+    return enabled.load (std::memory_order_relaxed) ? new StatCounters : 0;
+}
+
+StatCounters&
+globalStatCounters ()
+{
+    static StatCounters counters;
+    return counters;
+}
+
+void
+setStatisticsEnabled (bool e)
+{
+    enabled = e;
+}
+
+bool
+statisticsEnabled ()
+{
+    return enabled;
+}
+
+Statistics
+globalStatistics ()
+{
+    Statistics s;
+    globalStatCounters ().get (s);
+    return s;
+}
+
+void
+resetGlobalStatistics ()
+{
+    globalStatCounters ().reset ();
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,82 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_STATISTICS_H
+#define INCLUDED_IMF_STATISTICS_H
+
+//-----------------------------------------------------------------------------
+//
+//	Statistics about reading OpenEXR files
+//
+//	If statistics are enabled, input files count the chunks of pixel
+//	data they read and decode, and measure the time spent in each
+//	stage of reading: reading the chunks from the file, waiting for
+//	other threads that use the same file, waiting for free line or
+//	tile buffers, waiting in the thread pool's queue, decompressing,
+//	and converting the pixels into the frame buffer.
+//
+//	The counters of a file cover all its parts, and can be queried
+//	with the file's statistics() method (see for example
+//	InputFile::statistics()).  The sums over all files are available
+//	from globalStatistics().  Statistics are off by default; only
+//	files that are opened while statistics are enabled collect them.
+//
+//	The times are in seconds, summed over all threads.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfCompression.h"
+#include "ImfExport.h"
+#include "ImfNamespace.h"
+
+#include <cstdint>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+struct IMF_EXPORT_TYPE Statistics
+{
+    //
+    // Capacity of chunksDecoded, which is indexed by Compression.
+    // It has room for compression methods that may be added later,
+    // so that the layout of the struct does not change when one is.
+    //
+
+    static const int COMPRESSION_SLOTS = 32;
+
+
+    uint64_t bytesRead; // compressed pixel data read from the file
+    uint64_t reads;     // number of chunks read
+    uint64_t seeks;     // number of seeks to the start of a chunk
+
+    uint64_t chunksDecoded[COMPRESSION_SLOTS];
+    uint64_t bytesDecompressed; // size of the decompressed chunks
+
+    double readTime;       // reading chunks from the file
+    double lockWaitTime;   // waiting for other threads to release the file
+    double bufferWaitTime; // waiting for a free line or tile buffer
+    double queueTime;      // decoding tasks waiting for a worker thread
+    double decompressTime; // decompressing chunks
+    double copyTime;       // converting pixels into the frame buffer
+
+    IMF_EXPORT Statistics ();
+};
+
+//
+// Enable or disable statistics for the files opened from now on.
+//
+
+IMF_EXPORT void setStatisticsEnabled (bool enabled);
+IMF_EXPORT bool statisticsEnabled ();
+
+//
+// Sums of the statistics of all files, and a way to start over.
+//
+
+IMF_EXPORT Statistics globalStatistics ();
+IMF_EXPORT void       resetGlobalStatistics ();
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -6,6 +6,7 @@
 #ifndef INCLUDED_IMF_THREADING_H
 #define INCLUDED_IMF_THREADING_H
 
+#include "IlmThreadForward.h"
 #include "ImfExport.h"
 #include "ImfNamespace.h"
 
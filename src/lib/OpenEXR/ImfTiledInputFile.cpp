@@ -26,6 +26,7 @@
 #include "ImfMultiPartInputFile.h"
 #include "ImfNamespace.h"
 #include "ImfPartType.h"
+#include "ImfStatCounters.h"
 #include "ImfStdIO.h"
 #include "ImfThreading.h"
 #include "ImfTileDescriptionAttribute.h"
@@ -35,13 +36,17 @@
 #include "ImfXdr.h"
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <new>
 #include <string>
+#include <string.h>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 using ILMTHREAD_NAMESPACE::Semaphore;
 using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TASK_PRIORITY_NORMAL;
 using ILMTHREAD_NAMESPACE::TaskGroup;
 using ILMTHREAD_NAMESPACE::ThreadPool;
 using IMATH_NAMESPACE::Box2i;
@@ -67,6 +72,14 @@ struct TInSliceInfo
     int       xTileCoords;
     int       yTileCoords;
 
+    //
+    // Row copy kernels for NATIVE and XDR tile buffers,
+    // selected once for the slice's types and stride
+    //
+
+    CopyIntoFrameBufferFunc copyNative;
+    CopyIntoFrameBufferFunc copyXdr;
+
     TInSliceInfo (
         PixelType typeInFrameBuffer = HALF,
         PixelType typeInFile        = HALF,
@@ -101,8 +114,16 @@ TInSliceInfo::TInSliceInfo (
     , fillValue (fv)
     , xTileCoords (xtc)
     , yTileCoords (ytc)
+    , copyNative (0)
+    , copyXdr (0)
 {
-    // empty
+    if (!skip)
+    {
+        copyNative =
+            findCopyIntoFrameBuffer (fill, Compressor::NATIVE, tifb, tifl, xs);
+        copyXdr =
+            findCopyIntoFrameBuffer (fill, Compressor::XDR, tifb, tifl, xs);
+    }
 }
 
 struct TileBuffer
@@ -156,6 +177,40 @@ TileBuffer::~TileBuffer ()
     delete compressor;
 }
 
+//
+// Replaces a tile buffer's chunk buffer by one that is allocated and
+// first touched by a thread of the pool that will decode into it, so
+// that its pages are placed on that thread's NUMA node.  If the new
+// buffer cannot be allocated, the old one is kept.
+//
+
+class ReallocateBufferTask : public Task
+{
+public:
+    ReallocateBufferTask (
+        TaskGroup* group, TileBuffer* tileBuffer, size_t size)
+        : Task (group), _tileBuffer (tileBuffer), _size (size)
+    {}
+
+    void execute () override
+    {
+        char* buffer = new (std::nothrow) char[_size];
+
+        if (buffer)
+        {
+            memset (buffer, 0, _size);
+            delete[] _tileBuffer->buffer;
+            _tileBuffer->buffer = buffer;
+        }
+    }
+
+private:
+    TileBuffer* _tileBuffer;
+    size_t      _size;
+};
+
+struct AsyncRead;
+
 } // namespace
 
 class MultiPartInputFile;
@@ -205,6 +260,9 @@ struct TiledInputFile::Data
 
     int numThreads; // number of threads
 
+    std::atomic<int> taskPriority; // priority of the decoding tasks
+    ThreadPool*      threadPool;   // runs the decoding tasks
+
     MultiPartInputFile* multiPartFile; // the MultiPartInputFile used to
                                        // support backward compatibility
 
@@ -232,6 +290,8 @@ struct TiledInputFile::Data
     inline TileBuffer* getTileBuffer (int number);
     // hash function from tile indices
     // into our vector of tile buffers
+
+    AsyncRead* asyncRead; // in-flight readTilesAsync (), or null
 };
 
 TiledInputFile::Data::Data (int numThreads)
@@ -240,10 +300,13 @@ TiledInputFile::Data::Data (int numThreads)
     , partNumber (-1)
     , multiPartBackwardSupport (false)
     , numThreads (numThreads)
+    , taskPriority (TASK_PRIORITY_NORMAL)
+    , threadPool (&ThreadPool::globalThreadPool ())
     , multiPartFile (nullptr)
     , memoryMapped (false)
     , _streamData (NULL)
     , _deleteStream (false)
+    , asyncRead (0)
 {
     //
     // We need at least one tileBuffer, but if threading is used,
@@ -362,16 +425,19 @@ readTileData (
                      << ") is missing.");
     }
 
+    StatTimer timer (streamData->stats, &StatCounters::readNs);
+
     //
     // In a multi-part file, the next chunk does not need to
     // belong to the same part, so we have to compare the
     // offset here.
     //
 
+    bool seek;
+
     if (!isMultiPart (ifd->version))
     {
-        if (streamData->currentPosition != tileOffset)
-            streamData->is->seekg (tileOffset);
+        seek = streamData->currentPosition != tileOffset;
     }
     else
     {
@@ -379,8 +445,13 @@ readTileData (
         // In a multi-part file, the file pointer may be moved by other
         // parts, so we have to ask tellg() where we are.
         //
-        if (streamData->is->tellg () != tileOffset)
-            streamData->is->seekg (tileOffset);
+        seek = streamData->is->tellg () != tileOffset;
+    }
+
+    if (seek)
+    {
+        streamData->is->seekg (tileOffset);
+        addStat (streamData->stats, &StatCounters::seeks, 1);
     }
 
     //
@@ -441,6 +512,9 @@ readTileData (
     else
         streamData->is->read (buffer, dataSize);
 
+    addStat (streamData->stats, &StatCounters::reads, 1);
+    addStat (streamData->stats, &StatCounters::bytesRead, dataSize);
+
     //
     // Keep track of which tile is the next one in
     // the file, so that we can avoid redundant seekg()
@@ -513,7 +587,10 @@ class TileBufferTask : public Task
 {
 public:
     TileBufferTask (
-        TaskGroup* group, TiledInputFile::Data* ifd, TileBuffer* tileBuffer);
+        TaskGroup*            group,
+        TiledInputFile::Data* ifd,
+        TileBuffer*           tileBuffer,
+        StatCounters*         stats);
 
     virtual ~TileBufferTask ();
 
@@ -522,11 +599,20 @@ public:
 private:
     TiledInputFile::Data* _ifd;
     TileBuffer*           _tileBuffer;
+    StatCounters*         _stats;  // null if statistics are disabled
+    uint64_t              _queued; // time the task was created
 };
 
 TileBufferTask::TileBufferTask (
-    TaskGroup* group, TiledInputFile::Data* ifd, TileBuffer* tileBuffer)
-    : Task (group), _ifd (ifd), _tileBuffer (tileBuffer)
+    TaskGroup*            group,
+    TiledInputFile::Data* ifd,
+    TileBuffer*           tileBuffer,
+    StatCounters*         stats)
+    : Task (group)
+    , _ifd (ifd)
+    , _tileBuffer (tileBuffer)
+    , _stats (stats)
+    , _queued (statStart (stats))
 {
     // empty
 }
@@ -543,6 +629,8 @@ TileBufferTask::~TileBufferTask ()
 void
 TileBufferTask::execute ()
 {
+    addTimeSince (_stats, &StatCounters::queueNs, _queued);
+
     try
     {
         //
@@ -573,6 +661,8 @@ TileBufferTask::execute ()
 
         if (_tileBuffer->compressor && _tileBuffer->dataSize < sizeOfTile)
         {
+            StatTimer timer (_stats, &StatCounters::decompressNs);
+
             _tileBuffer->format = _tileBuffer->compressor->format ();
 
             _tileBuffer->dataSize = _tileBuffer->compressor->uncompressTile (
@@ -592,6 +682,10 @@ TileBufferTask::execute ()
             _tileBuffer->uncompressedData = _tileBuffer->buffer;
         }
 
+        addChunkDecoded (_stats, _ifd->header, sizeOfTile);
+
+        StatTimer timer (_stats, &StatCounters::copyNs);
+
         //
         // Convert the tile of pixel data back from the machine-independent
         // representation, and store the result in the frame buffer.
@@ -652,16 +746,17 @@ TileBufferTask::execute ()
                     char* endPtr =
                         writePtr + (numPixelsPerScanLine - 1) * slice.xStride;
 
-                    copyIntoFrameBuffer (
+                    CopyIntoFrameBufferFunc copy =
+                        _tileBuffer->format == Compressor::XDR
+                            ? slice.copyXdr
+                            : slice.copyNative;
+
+                    copy (
                         readPtr,
                         writePtr,
                         endPtr,
                         slice.xStride,
-                        slice.fill,
-                        slice.fillValue,
-                        _tileBuffer->format,
-                        slice.typeInFrameBuffer,
-                        slice.typeInFile);
+                        slice.fillValue);
                 }
             }
         }
@@ -707,7 +802,10 @@ newTileBufferTask (
 
     try
     {
-        tileBuffer->wait ();
+        {
+            StatTimer timer (streamData->stats, &StatCounters::bufferWaitNs);
+            tileBuffer->wait ();
+        }
 
         tileBuffer->dx = dx;
         tileBuffer->dy = dy;
@@ -738,7 +836,397 @@ newTileBufferTask (
         throw;
     }
 
-    return new TileBufferTask (group, ifd, tileBuffer);
+    return new TileBufferTask (group, ifd, tileBuffer, streamData->stats);
+}
+
+//
+// The state of a readTilesAsync() call.  The task group is declared
+// last, so that it is destroyed first: its destructor waits until all
+// tasks of the read have finished.
+//
+// A task that reads a tile from the file is queued only once its tile
+// buffer is free; until then it is parked here, and the task that frees
+// the tile buffer queues it.  No worker thread ever waits for a tile
+// buffer, so the read does not depend on the order in which the thread
+// pool runs its tasks.
+//
+
+struct AsyncRead
+{
+    AsyncRead (
+        int                                 priority,
+        int                                 tiles,
+        size_t                              numBuffers,
+        ThreadPool*                         threadPool,
+        const TiledInputFile::TileCallback& callback,
+        const char*                         fileName);
+
+    void fail (const char* what);
+    void finishTiles (int n);
+    void startRead (Task* readTask, size_t buffer);
+    void releaseBuffer (size_t buffer);
+
+    std::promise<void>           done;
+    TiledInputFile::TileCallback callback;
+    std::atomic<int>             remaining; // tiles not yet finished
+    std::atomic<bool>            failed;
+    string                       exception; // what() of the first error
+    string                       fileName;
+    ThreadPool*                  threadPool;
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex bufferMutex; // protects busy and the parked read
+#endif
+    vector<bool> busy;         // tile buffers in use by the read
+    Task*        parkedRead;   // read waiting for a tile buffer, or null
+    size_t       parkedBuffer; // the tile buffer it waits for
+    TaskGroup    group;
+};
+
+AsyncRead::AsyncRead (
+    int                                 priority,
+    int                                 tiles,
+    size_t                              numBuffers,
+    ThreadPool*                         threadPool,
+    const TiledInputFile::TileCallback& callback,
+    const char*                         fileName)
+    : callback (callback)
+    , remaining (tiles)
+    , failed (false)
+    , fileName (fileName)
+    , threadPool (threadPool)
+    , busy (numBuffers, false)
+    , parkedRead (0)
+    , parkedBuffer (0)
+    , group (priority)
+{
+    // empty
+}
+
+void
+AsyncRead::startRead (Task* readTask, size_t buffer)
+{
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (bufferMutex);
+#endif
+        if (busy[buffer])
+        {
+            //
+            // The tiles are read one at a time, so at most one
+            // read is parked.
+            //
+
+            parkedRead   = readTask;
+            parkedBuffer = buffer;
+            return;
+        }
+
+        busy[buffer] = true;
+    }
+
+    threadPool->addTask (readTask);
+}
+
+void
+AsyncRead::releaseBuffer (size_t buffer)
+{
+    Task* readTask = 0;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (bufferMutex);
+#endif
+        if (parkedRead && parkedBuffer == buffer)
+        {
+            //
+            // Hand the tile buffer over to the parked read.
+            //
+
+            readTask   = parkedRead;
+            parkedRead = 0;
+        }
+        else
+            busy[buffer] = false;
+    }
+
+    if (readTask) threadPool->addTask (readTask);
+}
+
+void
+AsyncRead::fail (const char* what)
+{
+    bool expected = false;
+    if (failed.compare_exchange_strong (expected, true)) exception = what;
+}
+
+void
+AsyncRead::finishTiles (int n)
+{
+    if (remaining.fetch_sub (n) != n) return;
+
+    //
+    // This was the last tile.  The error, if any, is reported the
+    // way readTiles() reports it.
+    //
+
+    if (failed)
+    {
+        done.set_exception (std::make_exception_ptr (IEX_NAMESPACE::IoExc (
+            "Error reading pixel data from image file \"" + fileName +
+            "\". " + exception)));
+    }
+    else
+        done.set_value ();
+}
+
+//
+// Decodes one tile of an asynchronous read, with the task that
+// newTileBufferTask() created for it, then reports the tile.
+//
+
+class AsyncTileBufferTask : public Task
+{
+public:
+    AsyncTileBufferTask (
+        AsyncRead*      read,
+        TileBufferTask* decodeTask,
+        TileBuffer*     tileBuffer,
+        size_t          buffer);
+
+    virtual ~AsyncTileBufferTask ();
+
+    virtual void execute ();
+
+private:
+    AsyncRead*      _read;
+    TileBufferTask* _decodeTask;
+    TileBuffer*     _tileBuffer;
+    size_t          _buffer; // index of the tile buffer
+};
+
+AsyncTileBufferTask::AsyncTileBufferTask (
+    AsyncRead*      read,
+    TileBufferTask* decodeTask,
+    TileBuffer*     tileBuffer,
+    size_t          buffer)
+    : Task (&read->group)
+    , _read (read)
+    , _decodeTask (decodeTask)
+    , _tileBuffer (tileBuffer)
+    , _buffer (buffer)
+{
+    // empty
+}
+
+AsyncTileBufferTask::~AsyncTileBufferTask ()
+{
+    delete _decodeTask;
+}
+
+void
+AsyncTileBufferTask::execute ()
+{
+    _decodeTask->execute ();
+
+    bool ok = !_tileBuffer->hasException;
+    int  dx = _tileBuffer->dx;
+    int  dy = _tileBuffer->dy;
+    int  lx = _tileBuffer->lx;
+    int  ly = _tileBuffer->ly;
+
+    if (!ok)
+    {
+        _read->fail (_tileBuffer->exception.c_str ());
+        _tileBuffer->hasException = false;
+    }
+
+    //
+    // Deleting the decode task frees the tile buffer for the
+    // next tile.
+    //
+
+    delete _decodeTask;
+    _decodeTask = 0;
+
+    _read->releaseBuffer (_buffer);
+
+    if (ok && _read->callback)
+    {
+        try
+        {
+            _read->callback (dx, dy, lx, ly);
+        }
+        catch (std::exception& e)
+        {
+            _read->fail (e.what ());
+        }
+        catch (...)
+        {
+            _read->fail ("unrecognized exception");
+        }
+    }
+
+    _read->finishTiles (1);
+}
+
+//
+// Reads one tile of an asynchronous read from the file, queues the
+// task that decodes it, and then starts the task that reads the next
+// tile.  Reading the tiles one after another, in file order, keeps the
+// file access sequential.  The task is queued only once its tile buffer
+// is free (see AsyncRead), so reading the tile never waits.
+//
+
+class AsyncReadTask : public Task
+{
+public:
+    AsyncReadTask (
+        AsyncRead*            read,
+        TiledInputFile::Data* ifd,
+        int                   number,
+        int                   dx,
+        int                   dy,
+        int                   dx1,
+        int                   dx2,
+        int                   dyStop,
+        int                   dY,
+        int                   lx,
+        int                   ly);
+
+    virtual void execute ();
+
+private:
+    AsyncRead*            _read;
+    TiledInputFile::Data* _ifd;
+    int                   _number; // sequence number of the tile
+    int                   _dx;
+    int                   _dy;
+    int                   _dx1;
+    int                   _dx2;
+    int                   _dyStop;
+    int                   _dY;
+    int                   _lx;
+    int                   _ly;
+};
+
+AsyncReadTask::AsyncReadTask (
+    AsyncRead*            read,
+    TiledInputFile::Data* ifd,
+    int                   number,
+    int                   dx,
+    int                   dy,
+    int                   dx1,
+    int                   dx2,
+    int                   dyStop,
+    int                   dY,
+    int                   lx,
+    int                   ly)
+    : Task (&read->group)
+    , _read (read)
+    , _ifd (ifd)
+    , _number (number)
+    , _dx (dx)
+    , _dy (dy)
+    , _dx1 (dx1)
+    , _dx2 (dx2)
+    , _dyStop (dyStop)
+    , _dY (dY)
+    , _lx (lx)
+    , _ly (ly)
+{
+    // empty
+}
+
+void
+AsyncReadTask::execute ()
+{
+    InputStreamMutex* streamData = _ifd->_streamData;
+    TileBufferTask*   decodeTask = 0;
+    TileBuffer*       tileBuffer = _ifd->getTileBuffer (_number);
+
+    try
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        StatTimer lockTimer (streamData->stats, &StatCounters::lockWaitNs);
+        std::lock_guard<std::mutex> lock (*streamData);
+        lockTimer.stop ();
+#endif
+        decodeTask = newTileBufferTask (
+            0, streamData, _ifd, _number, _dx, _dy, _lx, _ly);
+    }
+    catch (std::exception& e)
+    {
+        _read->fail (e.what ());
+    }
+    catch (...)
+    {
+        _read->fail ("unrecognized exception");
+    }
+
+    int dx = _dx + 1;
+    int dy = _dy;
+
+    if (dx > _dx2)
+    {
+        dx = _dx1;
+        dy += _dY;
+    }
+
+    if (!decodeTask)
+    {
+        //
+        // Reading failed; the remaining tiles are not read.
+        //
+
+        int n = 1;
+
+        if (dy != _dyStop)
+        {
+            int rows = (_dyStop - dy) * _dY - 1;
+            n += rows * (_dx2 - _dx1 + 1) + (_dx2 - dx + 1);
+        }
+
+        _read->releaseBuffer (_number % _ifd->tileBuffers.size ());
+        _read->finishTiles (n);
+        return;
+    }
+
+    _ifd->threadPool->addTask (new AsyncTileBufferTask (
+        _read, decodeTask, tileBuffer, _number % _ifd->tileBuffers.size ()));
+
+    if (dy != _dyStop)
+    {
+        int next = _number + 1;
+
+        _read->startRead (
+            new AsyncReadTask (
+                _read,
+                _ifd,
+                next,
+                dx,
+                dy,
+                _dx1,
+                _dx2,
+                _dyStop,
+                _dY,
+                _lx,
+                _ly),
+            next % _ifd->tileBuffers.size ());
+    }
+}
+
+//
+// Waits for the file's asynchronous read, if there is one, to finish.
+//
+
+void
+waitForAsyncRead (TiledInputFile::Data* ifd)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*ifd);
+#endif
+    delete ifd->asyncRead;
+    ifd->asyncRead = 0;
 }
 
 } // namespace
@@ -1100,6 +1588,8 @@ TiledInputFile::initialize ()
 
 TiledInputFile::~TiledInputFile ()
 {
+    waitForAsyncRead (_data);
+
     if (!_data->memoryMapped)
         for (size_t i = 0; i < _data->tileBuffers.size (); i++)
             delete[] _data->tileBuffers[i]->buffer;
@@ -1132,6 +1622,8 @@ TiledInputFile::version () const
 void
 TiledInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
 {
+    waitForAsyncRead (_data);
+
 #if ILMTHREAD_THREADING_ENABLED
     std::lock_guard<std::mutex> lock (*_data->_streamData);
 #endif
@@ -1144,15 +1636,24 @@ TiledInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     // compatible with the image file header.
     //
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&         channels = _data->header.channels ();
+    ChannelList::ConstIterator i        = channels.begin ();
+
+    //
+    // The slices and the channels are both sorted by name,
+    // so the channel for each slice is found in a single pass.
+    //
 
     for (FrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
          ++j)
     {
-        ChannelList::ConstIterator i = channels.find (j.name ());
+        while (i != channels.end () && strcmp (i.name (), j.name ()) < 0)
+            ++i;
+
+        if (i == channels.end ()) break;
 
-        if (i == channels.end ()) continue;
+        if (strcmp (i.name (), j.name ()) > 0) continue;
 
         if (i.channel ().xSampling != j.slice ().xSampling ||
             i.channel ().ySampling != j.slice ().ySampling)
@@ -1173,8 +1674,8 @@ TiledInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     // Initialize the slice table for readPixels().
     //
 
-    vector<TInSliceInfo>       slices;
-    ChannelList::ConstIterator i = channels.begin ();
+    vector<TInSliceInfo> slices;
+    i = channels.begin ();
 
     for (FrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
@@ -1277,10 +1778,15 @@ TiledInputFile::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
     // Read a range of tiles from the file into the framebuffer
     //
 
+    waitForAsyncRead (_data);
+
     try
     {
 #if ILMTHREAD_THREADING_ENABLED
+        StatTimer lockTimer (
+            _data->_streamData->stats, &StatCounters::lockWaitNs);
         std::lock_guard<std::mutex> lock (*_data->_streamData);
+        lockTimer.stop ();
 #endif
         if (_data->slices.size () == 0)
             throw IEX_NAMESPACE::ArgExc ("No frame buffer specified "
@@ -1323,7 +1829,7 @@ TiledInputFile::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
         //
 
         {
-            TaskGroup taskGroup;
+            TaskGroup taskGroup (_data->taskPriority);
             int       tileNumber = 0;
 
             for (int dy = dyStart; dy != dyStop; dy += dY)
@@ -1336,7 +1842,7 @@ TiledInputFile::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
                             "Tile (" << dx << ", " << dy << ", " << lx << ","
                                      << ly << ") is not a valid tile.");
 
-                    ThreadPool::addGlobalTask (newTileBufferTask (
+                    _data->threadPool->addTask (newTileBufferTask (
                         &taskGroup,
                         _data->_streamData,
                         _data,
@@ -1399,6 +1905,114 @@ TiledInputFile::readTiles (int dx1, int dx2, int dy1, int dy2, int l)
     readTiles (dx1, dx2, dy1, dy2, l, l);
 }
 
+std::future<void>
+TiledInputFile::readTilesAsync (
+    int                 dx1,
+    int                 dx2,
+    int                 dy1,
+    int                 dy2,
+    int                 lx,
+    int                 ly,
+    const TileCallback& callback)
+{
+    if (_data->slices.size () == 0)
+        throw IEX_NAMESPACE::ArgExc ("No frame buffer specified "
+                                     "as pixel data destination.");
+
+    if (!isValidLevel (lx, ly))
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Level coordinate (" << lx << ", " << ly << ") is invalid.");
+
+    if (dx1 > dx2) std::swap (dx1, dx2);
+
+    if (dy1 > dy2) std::swap (dy1, dy2);
+
+    for (int dy = dy1; dy <= dy2; dy++)
+    {
+        for (int dx = dx1; dx <= dx2; dx++)
+        {
+            if (!isValidTile (dx, dy, lx, ly))
+                THROW (
+                    IEX_NAMESPACE::ArgExc,
+                    "Tile (" << dx << ", " << dy << ", " << lx << "," << ly
+                             << ") is not a valid tile.");
+        }
+    }
+
+    if (_data->threadPool->numThreads () == 0)
+    {
+        std::promise<void> done;
+
+        try
+        {
+            readTiles (dx1, dx2, dy1, dy2, lx, ly);
+
+            if (callback)
+            {
+                for (int dy = dy1; dy <= dy2; dy++)
+                    for (int dx = dx1; dx <= dx2; dx++)
+                        callback (dx, dy, lx, ly);
+            }
+
+            done.set_value ();
+        }
+        catch (...)
+        {
+            done.set_exception (std::current_exception ());
+        }
+
+        return done.get_future ();
+    }
+
+    //
+    // The tiles are read in file order, as in readTiles().
+    //
+
+    int dyStart = dy1;
+    int dyStop  = dy2 + 1;
+    int dY      = 1;
+
+    if (_data->lineOrder == DECREASING_Y)
+    {
+        dyStart = dy2;
+        dyStop  = dy1 - 1;
+        dY      = -1;
+    }
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_data);
+#endif
+
+    delete _data->asyncRead;
+    _data->asyncRead = new AsyncRead (
+        _data->taskPriority,
+        (dx2 - dx1 + 1) * (dy2 - dy1 + 1),
+        _data->tileBuffers.size (),
+        _data->threadPool,
+        callback,
+        fileName ());
+
+    std::future<void> result = _data->asyncRead->done.get_future ();
+
+    _data->asyncRead->startRead (
+        new AsyncReadTask (
+            _data->asyncRead,
+            _data,
+            0,
+            dx1,
+            dyStart,
+            dx1,
+            dx2,
+            dyStop,
+            dY,
+            lx,
+            ly),
+        0);
+
+    return result;
+}
+
 void
 TiledInputFile::readTile (int dx, int dy, int lx, int ly)
 {
@@ -1411,6 +2025,51 @@ TiledInputFile::readTile (int dx, int dy, int l)
     readTile (dx, dy, l, l);
 }
 
+Statistics
+TiledInputFile::statistics () const
+{
+    return _data->_streamData->statistics ();
+}
+
+void
+TiledInputFile::setTaskPriority (int priority)
+{
+    _data->taskPriority = priority;
+}
+
+int
+TiledInputFile::taskPriority () const
+{
+    return _data->taskPriority;
+}
+
+void
+TiledInputFile::setThreadPool (ThreadPool* pool)
+{
+    waitForAsyncRead (_data);
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_data->_streamData);
+#endif
+    _data->threadPool = pool ? pool : &ThreadPool::globalThreadPool ();
+
+    if (_data->memoryMapped || _data->threadPool->numThreads () == 0) return;
+
+    TaskGroup taskGroup;
+
+    for (size_t i = 0; i < _data->tileBuffers.size (); i++)
+    {
+        _data->threadPool->addTask (new ReallocateBufferTask (
+            &taskGroup, _data->tileBuffers[i], _data->tileBufferSize));
+    }
+}
+
+ThreadPool*
+TiledInputFile::threadPool () const
+{
+    return _data->threadPool;
+}
+
 void
 TiledInputFile::rawTileData (
     int&         dx,
@@ -1420,6 +2079,8 @@ TiledInputFile::rawTileData (
     const char*& pixelData,
     int&         pixelDataSize)
 {
+    waitForAsyncRead (_data);
+
     try
     {
 #if ILMTHREAD_THREADING_ENABLED
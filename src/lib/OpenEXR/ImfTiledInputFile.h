@@ -20,6 +20,9 @@
 #include "ImfTileDescription.h"
 #include <ImathBox.h>
 
+#include <functional>
+#include <future>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 class IMF_EXPORT_TYPE TiledInputFile : public GenericInputFile
@@ -330,6 +333,48 @@ public:
     IMF_EXPORT
     void readTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    //------------------------------------------------------------
+    // Read tiles without waiting for them:
+    //
+    // readTilesAsync() reads the same tiles as readTiles(), but
+    // returns as soon as the work has been queued in the file's
+    // thread pool.  Reading the tiles from the file happens in
+    // the pool too, one tile at a time, so no thread is dedicated
+    // to the read.  A tile is read only once a tile buffer is free
+    // for it, so no worker waits for a tile buffer, whatever order
+    // the pool runs its tasks in; a worker waits for the file only
+    // while another thread, for example one reading another part,
+    // reads from it.  The returned future becomes ready when all
+    // tiles are in the frame buffer; get() rethrows the first
+    // error, as readTiles() would have thrown.  Invalid arguments
+    // throw immediately.
+    //
+    // If a callback is given, it is called from a worker thread
+    // with the coordinates of each tile once the tile is in the
+    // frame buffer, in no particular order.  The callback must
+    // not call back into the file.
+    //
+    // Only one read can be in flight per file: setFrameBuffer(),
+    // readTile(), readTiles(), readTilesAsync() and the destructor
+    // first wait for an earlier readTilesAsync() to finish.  The
+    // frame buffer must stay valid until then.  If the file's
+    // thread pool has no threads, the tiles are read before the
+    // function returns.
+    //------------------------------------------------------------
+
+    typedef std::function<void (int dx, int dy, int lx, int ly)>
+        TileCallback;
+
+    IMF_EXPORT
+    std::future<void> readTilesAsync (
+        int                 dx1,
+        int                 dx2,
+        int                 dy1,
+        int                 dy2,
+        int                 lx,
+        int                 ly,
+        const TileCallback& callback = TileCallback ());
+
     //--------------------------------------------------
     // Read a tile of raw pixel data from the file,
     // without uncompressing it (this function is
@@ -349,6 +394,49 @@ public:
         const char*& pixelData,
         int&         pixelDataSize);
 
+    //---------------------------------------------------------
+    // Statistics about reading the file (see ImfStatistics.h).
+    // The counters are zero unless statistics were enabled
+    // when the file was opened.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    Statistics statistics () const;
+
+    //---------------------------------------------------------
+    // Priority of the thread pool tasks that readPixels() and
+    // readTiles() create for this file (see IlmThreadPool.h).
+    // Tasks of a file with a higher priority, for example
+    // IlmThread::TASK_PRIORITY_INTERACTIVE, are executed before
+    // queued tasks of files with a lower priority, such as
+    // frames that are being prefetched in the background.
+    // The default is IlmThread::TASK_PRIORITY_NORMAL.
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setTaskPriority (int priority);
+
+    IMF_EXPORT
+    int taskPriority () const;
+
+    //---------------------------------------------------------
+    // The thread pool that runs the decoding tasks of this file,
+    // by default the global thread pool.  Passing a pool bound
+    // to a NUMA node (see IlmThreadPool.h) keeps the decoding on
+    // that node; the file's chunk buffers are then reallocated
+    // by the pool's threads, so that their memory is local to
+    // the node too.  A null pool selects the global pool again.
+    // The pool must outlive the reads of the file; to keep all
+    // of its threads busy, open the file with numThreads equal
+    // to the pool's numThreads().
+    //---------------------------------------------------------
+
+    IMF_EXPORT
+    void setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool);
+
+    IMF_EXPORT
+    ILMTHREAD_NAMESPACE::ThreadPool* threadPool () const;
+
     struct IMF_HIDDEN Data;
 
 private:
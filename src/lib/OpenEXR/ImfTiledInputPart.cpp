@@ -6,6 +6,7 @@
 #include "ImfTiledInputPart.h"
 
 #include "ImfMultiPartInputFile.h"
+#include "ImfStatistics.h"
 #include "ImfTiledInputFile.h"
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -172,6 +173,19 @@ TiledInputPart::readTiles (int dx1, int dx2, int dy1, int dy2, int l)
     file->readTiles (dx1, dx2, dy1, dy2, l);
 }
 
+std::future<void>
+TiledInputPart::readTilesAsync (
+    int                 dx1,
+    int                 dx2,
+    int                 dy1,
+    int                 dy2,
+    int                 lx,
+    int                 ly,
+    const TileCallback& callback)
+{
+    return file->readTilesAsync (dx1, dx2, dy1, dy2, lx, ly, callback);
+}
+
 void
 TiledInputPart::rawTileData (
     int&         dx,
@@ -184,4 +198,34 @@ TiledInputPart::rawTileData (
     file->rawTileData (dx, dy, lx, ly, pixelData, pixelDataSize);
 }
 
+Statistics
+TiledInputPart::statistics () const
+{
+    return file->statistics ();
+}
+
+void
+TiledInputPart::setTaskPriority (int priority)
+{
+    file->setTaskPriority (priority);
+}
+
+int
+TiledInputPart::taskPriority () const
+{
+    return file->taskPriority ();
+}
+
+void
+TiledInputPart::setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool)
+{
+    file->setThreadPool (pool);
+}
+
+ILMTHREAD_NAMESPACE::ThreadPool*
+TiledInputPart::threadPool () const
+{
+    return file->threadPool ();
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
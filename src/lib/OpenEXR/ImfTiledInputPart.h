@@ -6,11 +6,15 @@
 #ifndef IMFTILEDINPUTPART_H_
 #define IMFTILEDINPUTPART_H_
 
+#include "IlmThreadForward.h"
 #include "ImfForward.h"
 
 #include "ImfTileDescription.h"
 #include <ImathBox.h>
 
+#include <functional>
+#include <future>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 //-----------------------------------------------------------------------------
@@ -78,6 +82,19 @@ public:
     void readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly);
     IMF_EXPORT
     void readTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
+
+    typedef std::function<void (int dx, int dy, int lx, int ly)>
+        TileCallback;
+
+    IMF_EXPORT
+    std::future<void> readTilesAsync (
+        int                 dx1,
+        int                 dx2,
+        int                 dy1,
+        int                 dy2,
+        int                 lx,
+        int                 ly,
+        const TileCallback& callback = TileCallback ());
     IMF_EXPORT
     void rawTileData (
         int&         dx,
@@ -86,6 +103,16 @@ public:
         int&         ly,
         const char*& pixelData,
         int&         pixelDataSize);
+    IMF_EXPORT
+    Statistics statistics () const;
+    IMF_EXPORT
+    void setTaskPriority (int priority);
+    IMF_EXPORT
+    int taskPriority () const;
+    IMF_EXPORT
+    void setThreadPool (ILMTHREAD_NAMESPACE::ThreadPool* pool);
+    IMF_EXPORT
+    ILMTHREAD_NAMESPACE::ThreadPool* threadPool () const;
 
 private:
     TiledInputFile* file;
@@ -38,8 +38,10 @@
 #include <algorithm>
 #include <assert.h>
 #include <fstream>
+#include <limits>
 #include <map>
 #include <string>
+#include <string.h>
 #include <vector>
 
 #include "ImfNamespace.h"
@@ -76,6 +78,13 @@ struct TOutSliceInfo
     int         xTileCoords;
     int         yTileCoords;
 
+    //
+    // Row copy kernel for the file's tile buffer
+    // format, selected once for the slice's type and stride
+    //
+
+    CopyFromFrameBufferFunc copy;
+
     TOutSliceInfo (
         PixelType   type        = HALF,
         const char* base        = 0,
@@ -95,6 +104,7 @@ TOutSliceInfo::TOutSliceInfo (
     , zero (z)
     , xTileCoords (xtc)
     , yTileCoords (ytc)
+    , copy (0)
 {
     // empty
 }
@@ -221,6 +231,8 @@ struct TiledOutputFile::Data
 
     TileMap   tileMap;
     TileCoord nextTileToWrite;
+    size_t    bufferedTileBytes; // total size of the tiles in tileMap
+    size_t    tileBufferLimit;   // maximum for bufferedTileBytes
 
     int partNumber; // the output part number
 
@@ -245,6 +257,8 @@ TiledOutputFile::Data::Data (int numThreads)
     , numXTiles (0)
     , numYTiles (0)
     , tileOffsetsPosition (0)
+    , bufferedTileBytes (0)
+    , tileBufferLimit (std::numeric_limits<size_t>::max ())
     , partNumber (-1)
 {
     //
@@ -498,49 +512,67 @@ bufferedTileWrite (
     // then write this tile immediately and check if we have buffered tiles
     // that can be written after this tile.
     //
-    // Otherwise, buffer the tile so it can be written to file later.
+    // Otherwise, buffer the tile so it can be written to file later, unless
+    // that would exceed the tile buffer limit.  In that case, write the tile
+    // now, out of order; readers find it via the tile offset table.
     //
 
     if (ofd->nextTileToWrite == currentTile)
     {
         writeTileData (
             streamData, ofd, dx, dy, lx, ly, pixelData, pixelDataSize);
-        ofd->nextTileToWrite = ofd->nextTileCoord (ofd->nextTileToWrite);
-
-        TileMap::iterator i = ofd->tileMap.find (ofd->nextTileToWrite);
 
         //
         // Step through the tiles and write all successive buffered tiles after
-        // the current one.
+        // the current one, skipping tiles that were written out of order.
         //
 
-        while (i != ofd->tileMap.end ())
+        while (true)
         {
-            //
-            // Write the tile, and then delete the tile's buffered data
-            //
+            ofd->nextTileToWrite = ofd->nextTileCoord (ofd->nextTileToWrite);
 
-            writeTileData (
-                streamData,
-                ofd,
-                i->first.dx,
-                i->first.dy,
-                i->first.lx,
-                i->first.ly,
-                i->second->pixelData,
-                i->second->pixelDataSize);
+            const TileCoord& next = ofd->nextTileToWrite;
 
-            delete i->second;
-            ofd->tileMap.erase (i);
+            if (!ofd->tileOffsets.isValidTile (
+                    next.dx, next.dy, next.lx, next.ly))
+            {
+                break;
+            }
 
-            //
-            // Proceed to the next tile
-            //
+            TileMap::iterator i = ofd->tileMap.find (next);
 
-            ofd->nextTileToWrite = ofd->nextTileCoord (ofd->nextTileToWrite);
-            i                    = ofd->tileMap.find (ofd->nextTileToWrite);
+            if (i != ofd->tileMap.end ())
+            {
+                //
+                // Write the tile, and then delete the tile's buffered data
+                //
+
+                writeTileData (
+                    streamData,
+                    ofd,
+                    next.dx,
+                    next.dy,
+                    next.lx,
+                    next.ly,
+                    i->second->pixelData,
+                    i->second->pixelDataSize);
+
+                ofd->bufferedTileBytes -= i->second->pixelDataSize;
+                delete i->second;
+                ofd->tileMap.erase (i);
+            }
+            else if (!ofd->tileOffsets (next.dx, next.dy, next.lx, next.ly))
+            {
+                break;
+            }
         }
     }
+    else if (
+        ofd->tileBufferLimit - ofd->bufferedTileBytes < size_t (pixelDataSize))
+    {
+        writeTileData (
+            streamData, ofd, dx, dy, lx, ly, pixelData, pixelDataSize);
+    }
     else
     {
         //
@@ -550,6 +582,8 @@ bufferedTileWrite (
 
         ofd->tileMap[currentTile] =
             new BufferedTile ((const char*) pixelData, pixelDataSize);
+
+        ofd->bufferedTileBytes += pixelDataSize;
     }
 }
 
@@ -748,13 +782,7 @@ TileBufferTask::execute ()
                     const char* endPtr =
                         readPtr + (numPixelsPerScanLine - 1) * slice.xStride;
 
-                    copyFromFrameBuffer (
-                        writePtr,
-                        readPtr,
-                        endPtr,
-                        slice.xStride,
-                        _ofd->format,
-                        slice.type);
+                    slice.copy (writePtr, readPtr, endPtr, slice.xStride);
                 }
             }
         }
@@ -1098,14 +1126,23 @@ TiledOutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     // is compatible with the image file header.
     //
 
-    const ChannelList& channels = _data->header.channels ();
+    const ChannelList&         channels = _data->header.channels ();
+    FrameBuffer::ConstIterator j        = frameBuffer.begin ();
+
+    //
+    // The channels and the slices are both sorted by name,
+    // so the slice for each channel is found in a single pass.
+    //
 
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
+
+        if (j == frameBuffer.end ()) break;
 
-        if (j == frameBuffer.end ()) continue;
+        if (strcmp (j.name (), i.name ()) > 0) continue;
 
         if (i.channel ().type != j.slice ().type)
             THROW (
@@ -1131,12 +1168,15 @@ TiledOutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
 
     vector<TOutSliceInfo> slices;
 
+    j = frameBuffer.begin ();
+
     for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
          ++i)
     {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+        while (j != frameBuffer.end () && strcmp (j.name (), i.name ()) < 0)
+            ++j;
 
-        if (j == frameBuffer.end ())
+        if (j == frameBuffer.end () || strcmp (j.name (), i.name ()) > 0)
         {
             //
             // Channel i is not present in the frame buffer.
@@ -1164,6 +1204,9 @@ TiledOutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
                 false, // zero
                 (j.slice ().xTileCoords) ? 1 : 0,
                 (j.slice ().yTileCoords) ? 1 : 0));
+
+            slices.back ().copy = findCopyFromFrameBuffer (
+                _data->format, j.slice ().type, j.slice ().xStride);
         }
     }
 
@@ -1408,6 +1451,21 @@ TiledOutputFile::writeTile (int dx, int dy, int l)
     writeTile (dx, dy, l, l);
 }
 
+void
+TiledOutputFile::setTileBufferLimit (size_t maxBytes)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+    _data->tileBufferLimit = maxBytes;
+}
+
+size_t
+TiledOutputFile::tileBufferLimit () const
+{
+    return _data->tileBufferLimit;
+}
+
 void
 TiledOutputFile::copyPixels (TiledInputFile& in)
 {
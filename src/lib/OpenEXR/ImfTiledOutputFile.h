@@ -368,6 +368,33 @@ public:
     IMF_EXPORT
     void writeTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    //------------------------------------------------------------------
+    // Limit on the memory used for tiles that are written out of order:
+    //
+    // If the line order is INCREASING_Y or DECREASING_Y, writeTile()
+    // keeps a compressed copy of each tile that arrives before the
+    // tiles that precede it in the file, until those tiles have been
+    // written.  Depending on the order of the writeTile() calls, this
+    // can take as much memory as the whole compressed image.
+    //
+    // setTileBufferLimit(maxBytes) limits the total size of the
+    // buffered tiles.  A tile that does not fit into the buffer is
+    // written to the file immediately, out of order; the tile offset
+    // table still records the position of every tile, so the file
+    // can be read normally, but reading it in line order may require
+    // more seeks.  With maxBytes == 0, nothing is buffered, and the
+    // tiles are stored in the file in the order in which they are
+    // written, as for RANDOM_Y.
+    //
+    // By default, the amount of buffered data is not limited.
+    //------------------------------------------------------------------
+
+    IMF_EXPORT
+    void setTileBufferLimit (size_t maxBytes);
+
+    IMF_EXPORT
+    size_t tileBufferLimit () const;
+
     //------------------------------------------------------------------
     // Shortcut to copy all pixels from a TiledInputFile into this file,
     // without uncompressing and then recompressing the pixel data.
@@ -160,6 +160,18 @@ TiledOutputPart::writeTiles (int dx1, int dx2, int dy1, int dy2, int l)
     file->writeTiles (dx1, dx2, dy1, dy2, l);
 }
 
+void
+TiledOutputPart::setTileBufferLimit (size_t maxBytes)
+{
+    file->setTileBufferLimit (maxBytes);
+}
+
+size_t
+TiledOutputPart::tileBufferLimit () const
+{
+    return file->tileBufferLimit ();
+}
+
 void
 TiledOutputPart::copyPixels (TiledInputFile& in)
 {
@@ -75,6 +75,10 @@ public:
     IMF_EXPORT
     void writeTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
     IMF_EXPORT
+    void setTileBufferLimit (size_t maxBytes);
+    IMF_EXPORT
+    size_t tileBufferLimit () const;
+    IMF_EXPORT
     void copyPixels (TiledInputFile& in);
     IMF_EXPORT
     void copyPixels (InputFile& in);
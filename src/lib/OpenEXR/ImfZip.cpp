@@ -50,45 +50,10 @@ int
 Zip::compress (const char* raw, int rawSize, char* compressed)
 {
     //
-    // Reorder the pixel data.
+    // Reorder the pixel data and apply the predictor.
     //
 
-    {
-        char*       t1   = _tmpBuffer;
-        char*       t2   = _tmpBuffer + (rawSize + 1) / 2;
-        const char* stop = raw + rawSize;
-
-        while (true)
-        {
-            if (raw < stop)
-                *(t1++) = *(raw++);
-            else
-                break;
-
-            if (raw < stop)
-                *(t2++) = *(raw++);
-            else
-                break;
-        }
-    }
-
-    //
-    // Predictor.
-    //
-
-    {
-        unsigned char* t    = (unsigned char*) _tmpBuffer + 1;
-        unsigned char* stop = (unsigned char*) _tmpBuffer + rawSize;
-        int            p    = t[-1];
-
-        while (t < stop)
-        {
-            int d = int (t[0]) - p + (128 + 256);
-            p     = t[0];
-            t[0]  = d;
-            ++t;
-        }
-    }
+    deconstructBytes (raw, rawSize, _tmpBuffer);
 
     //
     // Compress the data using zlib
@@ -160,6 +125,53 @@ reconstruct_sse41 (char* buf, size_t outSize)
 
 #endif
 
+#ifdef IMF_HAVE_SSE2
+
+void
+reconstruct_sse2 (char* buf, size_t outSize)
+{
+    static const size_t bytesPerChunk = sizeof (__m128i);
+    const size_t        vOutSize      = outSize / bytesPerChunk;
+
+    const __m128i c = _mm_set1_epi8 (-128);
+
+    // See reconstruct_sse41().
+    buf[0] += -128;
+
+    __m128i* vBuf  = reinterpret_cast<__m128i*> (buf);
+    __m128i  vPrev = _mm_setzero_si128 ();
+    for (size_t i = 0; i < vOutSize; ++i)
+    {
+        __m128i d = _mm_add_epi8 (_mm_loadu_si128 (vBuf), c);
+
+        // Compute the prefix sum of elements.
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 1));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 2));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 4));
+        d = _mm_add_epi8 (d, _mm_slli_si128 (d, 8));
+        d = _mm_add_epi8 (d, vPrev);
+
+        _mm_storeu_si128 (vBuf++, d);
+
+        // Broadcast the high byte in our result to all lanes of the prev
+        // value for the next iteration, without SSSE3's byte shuffle.
+        vPrev = _mm_srli_si128 (d, 15);
+        vPrev = _mm_unpacklo_epi8 (vPrev, vPrev);
+        vPrev = _mm_unpacklo_epi16 (vPrev, vPrev);
+        vPrev = _mm_shuffle_epi32 (vPrev, 0);
+    }
+
+    unsigned char prev = _mm_cvtsi128_si32 (vPrev);
+    for (size_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
+    {
+        unsigned char d = prev + buf[i] - 128;
+        buf[i]          = d;
+        prev            = d;
+    }
+}
+
+#endif
+
 #ifdef IMF_HAVE_NEON
 
 void
@@ -322,8 +334,123 @@ interleave_scalar (const char* source, size_t outSize, char* out)
     }
 }
 
+#ifdef IMF_HAVE_SSE2
+
+void
+deinterleave_sse2 (const char* source, size_t size, char* out)
+{
+    static const size_t bytesPerChunk = 2 * sizeof (__m128i);
+
+    const size_t vSize = size / bytesPerChunk;
+
+    const __m128i lowBytes = _mm_set1_epi16 (0xff);
+
+    const __m128i* vIn = reinterpret_cast<const __m128i*> (source);
+    __m128i*       v1  = reinterpret_cast<__m128i*> (out);
+    __m128i*       v2  = reinterpret_cast<__m128i*> (out + (size + 1) / 2);
+
+    for (size_t i = 0; i < vSize; ++i)
+    {
+        __m128i a = _mm_loadu_si128 (vIn++);
+        __m128i b = _mm_loadu_si128 (vIn++);
+
+        __m128i even = _mm_packus_epi16 (
+            _mm_and_si128 (a, lowBytes), _mm_and_si128 (b, lowBytes));
+        __m128i odd =
+            _mm_packus_epi16 (_mm_srli_epi16 (a, 8), _mm_srli_epi16 (b, 8));
+
+        _mm_storeu_si128 (v1++, even);
+        _mm_storeu_si128 (v2++, odd);
+    }
+
+    char* t1 = reinterpret_cast<char*> (v1);
+    char* t2 = reinterpret_cast<char*> (v2);
+
+    for (size_t i = vSize * bytesPerChunk; i < size; ++i)
+    {
+        if (i % 2 == 0)
+            *(t1++) = source[i];
+        else
+            *(t2++) = source[i];
+    }
+}
+
+void
+predict_sse2 (char* buf, size_t size)
+{
+    const __m128i c = _mm_set1_epi8 (-128);
+
+    //
+    // Work backwards, so that every byte is still unmodified when
+    // the difference to its right neighbour is computed.
+    //
+
+    size_t i = size;
+
+    while (i > sizeof (__m128i))
+    {
+        i -= sizeof (__m128i);
+
+        __m128i* v     = reinterpret_cast<__m128i*> (buf + i);
+        __m128i* vLeft = reinterpret_cast<__m128i*> (buf + i - 1);
+        __m128i  d     = _mm_loadu_si128 (v);
+
+        d = _mm_sub_epi8 (d, _mm_loadu_si128 (vLeft));
+        _mm_storeu_si128 (v, _mm_add_epi8 (d, c));
+    }
+
+    unsigned char* t = reinterpret_cast<unsigned char*> (buf);
+
+    while (i > 1)
+    {
+        --i;
+        t[i] = t[i] - t[i - 1] + 128;
+    }
+}
+
+#endif
+
+void
+deinterleave_scalar (const char* source, size_t size, char* out)
+{
+    char*       t1   = out;
+    char*       t2   = out + (size + 1) / 2;
+    const char* stop = source + size;
+
+    while (true)
+    {
+        if (source < stop)
+            *(t1++) = *(source++);
+        else
+            break;
+
+        if (source < stop)
+            *(t2++) = *(source++);
+        else
+            break;
+    }
+}
+
+void
+predict_scalar (char* buf, size_t size)
+{
+    unsigned char* t    = (unsigned char*) buf + 1;
+    unsigned char* stop = (unsigned char*) buf + size;
+    int            p    = t[-1];
+
+    while (t < stop)
+    {
+        int d = int (t[0]) - p + (128 + 256);
+        p     = t[0];
+        t[0]  = d;
+        ++t;
+    }
+}
+
 auto reconstruct = reconstruct_scalar;
 auto interleave = interleave_scalar;
+auto deinterleave = deinterleave_scalar;
+auto predict = predict_scalar;
 
 } // namespace
 
@@ -349,34 +476,50 @@ Zip::uncompress (const char* compressed, int compressedSize, char* raw)
     if (outSize == 0) { return outSize; }
 
     //
-    // Predictor.
-    //
-    reconstruct (_tmpBuffer, outSize);
-
-    //
-    // Reorder the pixel data.
+    // Predictor, and reorder the pixel data.
     //
-    interleave (_tmpBuffer, outSize, raw);
+    reconstructBytes (_tmpBuffer, outSize, raw);
 
     return outSize;
 }
 
+void
+Zip::deconstructBytes (const char* raw, size_t rawSize, char* out)
+{
+    if (rawSize == 0) return;
+
+    deinterleave (raw, rawSize, out);
+    predict (out, rawSize);
+}
+
+void
+Zip::reconstructBytes (char* buf, size_t size, char* raw)
+{
+    if (size == 0) return;
+
+    reconstruct (buf, size);
+    interleave (buf, size, raw);
+}
+
 void
 Zip::initializeFuncs ()
 {
     CpuId cpuId;
 
-#ifdef IMF_HAVE_SSE4_1
-    if (cpuId.sse4_1)
+#ifdef IMF_HAVE_SSE2
+    if (cpuId.sse2)
     {
-        reconstruct = reconstruct_sse41;
+        reconstruct  = reconstruct_sse2;
+        interleave   = interleave_sse2;
+        deinterleave = deinterleave_sse2;
+        predict      = predict_sse2;
     }
 #endif
 
-#ifdef IMF_HAVE_SSE2
-    if (cpuId.sse2) 
+#ifdef IMF_HAVE_SSE4_1
+    if (cpuId.sse4_1)
     {
-        interleave = interleave_sse2;
+        reconstruct = reconstruct_sse41;
     }
 #endif
 
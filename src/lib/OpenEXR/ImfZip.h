@@ -40,6 +40,19 @@ public:
     //
     int uncompress (const char* compressed, int compressedSize, char* raw);
 
+    //
+    // Reorder the bytes of the raw data and apply the predictor, as
+    // done before compression, writing the result to out.  Also used
+    // by RleCompressor.
+    //
+    static void deconstructBytes (const char* raw, size_t rawSize, char* out);
+
+    //
+    // Undo deconstructBytes(): undo the predictor in buf, which is
+    // modified, and write the reordered bytes to raw.
+    //
+    static void reconstructBytes (char* buf, size_t size, char* raw);
+
     static void initializeFuncs ();
 
 private:
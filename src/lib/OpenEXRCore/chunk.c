@@ -189,7 +189,7 @@ validate_and_compute_tile_chunk_off (
 
             for (int ly = 0; ly < levely; ++ly)
             {
-                for (int lx = 0; lx < levelx; ++lx)
+                for (int lx = 0; lx < part->num_tile_levels_x; ++lx)
                 {
                     chunkoff +=
                         ((int64_t) part->tile_level_tile_count_x[lx] *
@@ -1749,6 +1749,7 @@ exr_write_tile_chunk_info (
     const exr_attr_chlist_t*   chanlist;
     const exr_attr_tiledesc_t* tiledesc;
     int                        tilew, tileh;
+    int64_t                    tend, dend;
     uint64_t                   unpacksize = 0;
     exr_chunk_info_t           nil        = {0};
 
@@ -1779,28 +1780,25 @@ exr_write_tile_chunk_info (
         pctxt, part, tilex, tiley, levelx, levely, &cidx);
     if (rv != EXR_ERR_SUCCESS) return EXR_UNLOCK_AND_RETURN_PCTXT (rv);
 
+    /* tile_level_tile_size_x/y hold the size of each level, clip the
+     * last tile of a row / column against it like the read path does */
     tiledesc = part->tiles->tiledesc;
-    tilew    = part->tile_level_tile_size_x[levelx];
-    if (tiledesc->x_size < (uint32_t) tilew) tilew = (int) tiledesc->x_size;
-    tileh = part->tile_level_tile_size_y[levely];
-    if (tiledesc->y_size < (uint32_t) tileh) tileh = (int) tiledesc->y_size;
-
-    if (((int64_t) (tilex) * (int64_t) (tilew) + (int64_t) (tilew) +
-         (int64_t) (part->data_window.min.x) - 1) >
-        (int64_t) (part->data_window.max.x))
+    tilew    = (int) (tiledesc->x_size);
+    dend  = ((int64_t) part->tile_level_tile_size_x[levelx]);
+    tend  = ((int64_t) tilew) * ((int64_t) (tilex + 1));
+    if (tend > dend)
     {
-        int64_t sz = (int64_t) (part->data_window.max.x) -
-                     (int64_t) (part->data_window.min.x) + 1;
-        tilew = (int) (sz - ((int64_t) (tilex) * (int64_t) (tilew)));
+        tend -= dend;
+        if (tend < tilew) tilew = tilew - ((int) tend);
     }
 
-    if (((int64_t) (tiley) * (int64_t) (tileh) + (int64_t) (tileh) +
-         (int64_t) (part->data_window.min.y) - 1) >
-        (int64_t) (part->data_window.max.y))
+    tileh = (int) (tiledesc->y_size);
+    dend  = ((int64_t) part->tile_level_tile_size_y[levely]);
+    tend  = ((int64_t) tileh) * ((int64_t) (tiley + 1));
+    if (tend > dend)
     {
-        int64_t sz = (int64_t) (part->data_window.max.y) -
-                     (int64_t) (part->data_window.min.y) + 1;
-        tileh = (int) (sz - ((int64_t) (tiley) * (int64_t) (tileh)));
+        tend -= dend;
+        if (tend < tileh) tileh = tileh - ((int) tend);
     }
 
     *cinfo             = nil;
@@ -11,6 +11,7 @@
 
 #include "internal_constants.h"
 #include "internal_file.h"
+#include "internal_stats.h"
 #include "backward_compatibility.h"
 
 #include <IlmThreadConfig.h>
@@ -34,6 +35,7 @@ dispatch_read (
 {
     int64_t      rval = -1;
     exr_result_t rv   = EXR_ERR_UNKNOWN;
+    uint64_t     start;
 
     if (nread) *nread = rval;
 
@@ -45,6 +47,8 @@ dispatch_read (
             EXR_ERR_INVALID_ARGUMENT,
             "read requested with no output offset pointer");
 
+    start = internal_exr_stat_start (ctxt);
+
     if (ctxt->read_fn)
         rval = ctxt->read_fn (
             (exr_const_context_t) ctxt,
@@ -56,6 +60,11 @@ dispatch_read (
     else
         return ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_READ);
 
+    internal_exr_add_stat_time (ctxt, EXR_STAT_READ_NS, start);
+    internal_exr_add_stat (ctxt, EXR_STAT_READS, 1);
+    if (rval > 0)
+        internal_exr_add_stat (ctxt, EXR_STAT_BYTES_READ, (uint64_t) rval);
+
     if (nread) *nread = rval;
     if (rval > 0) *offsetp += (uint64_t) rval;
 
@@ -76,7 +85,8 @@ dispatch_write (
     uint64_t                      sz,
     uint64_t*                     offsetp)
 {
-    int64_t rval = -1;
+    int64_t  rval = -1;
+    uint64_t start;
 
     if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
 
@@ -86,6 +96,8 @@ dispatch_write (
             EXR_ERR_INVALID_ARGUMENT,
             "write requested with no output offset pointer");
 
+    start = internal_exr_stat_start (ctxt);
+
     if (ctxt->write_fn)
         rval = ctxt->write_fn (
             (exr_const_context_t) ctxt,
@@ -97,6 +109,11 @@ dispatch_write (
     else
         return ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_WRITE);
 
+    internal_exr_add_stat_time (ctxt, EXR_STAT_WRITE_NS, start);
+    internal_exr_add_stat (ctxt, EXR_STAT_WRITES, 1);
+    if (rval > 0)
+        internal_exr_add_stat (ctxt, EXR_STAT_BYTES_WRITTEN, (uint64_t) rval);
+
     if (rval > 0) *offsetp += (uint64_t) rval;
 
     return (rval == (int64_t) sz) ? EXR_ERR_SUCCESS : EXR_ERR_WRITE_IO;
@@ -377,11 +394,78 @@ exr_start_inplace_header_update (
     const char*                      filename,
     const exr_context_initializer_t* ctxtdata)
 {
-    /* TODO: not yet implemented */
-    (void) ctxt;
-    (void) filename;
-    (void) ctxtdata;
-    return EXR_ERR_INVALID_ARGUMENT;
+    exr_result_t                  rv    = EXR_ERR_UNKNOWN;
+    struct _internal_exr_context* ret   = NULL;
+    exr_context_initializer_t     inits = fill_context_data (ctxtdata);
+
+    if (!ctxt)
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Invalid context handle passed to start_inplace_header_update function");
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!filename || filename[0] == '\0')
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Invalid filename passed to start_inplace_header_update function");
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    if ((inits.read_fn == NULL) != (inits.write_fn == NULL))
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Updating a header in place requires both a read and a write function");
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    /* the header is parsed as for a read, the mode is switched once
+     * the original size of the header is known */
+    rv = internal_exr_alloc_context (
+        &ret,
+        &inits,
+        EXR_CONTEXT_READ,
+        sizeof (struct _internal_exr_filehandle));
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        ret->do_read  = &dispatch_read;
+        ret->do_write = &dispatch_write;
+
+        rv = exr_attr_string_create (
+            (exr_context_t) ret, &(ret->filename), filename);
+        if (rv == EXR_ERR_SUCCESS)
+        {
+            if (!inits.read_fn)
+            {
+                inits.size_fn = &default_query_size_func;
+                rv            = default_init_update_file (ret);
+            }
+
+            if (rv == EXR_ERR_SUCCESS) rv = process_query_size (ret, &inits);
+            if (rv == EXR_ERR_SUCCESS) rv = internal_exr_parse_header (ret);
+        }
+
+        if (rv == EXR_ERR_SUCCESS)
+        {
+            ret->mode = EXR_CONTEXT_UPDATE_HEADER;
+            /* the chunk offset table of the first part directly
+             * follows the header */
+            ret->output_file_offset = ret->parts[0]->chunk_table_offset;
+        }
+        else
+            exr_finish ((exr_context_t*) &ret);
+    }
+    else
+        rv = EXR_ERR_OUT_OF_MEMORY;
+
+    *ctxt = (exr_context_t) ret;
+    return rv;
 }
 
 /**************************************/
@@ -628,12 +712,62 @@ exr_set_longname_support (exr_context_t ctxt, int onoff)
 
 /**************************************/
 
+static exr_result_t
+count_write (
+    struct _internal_exr_context* ctxt,
+    const void*                   buf,
+    uint64_t                      sz,
+    uint64_t*                     offsetp)
+{
+    (void) ctxt;
+    (void) buf;
+    *offsetp += sz;
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+update_header_in_place (struct _internal_exr_context* pctxt)
+{
+    exr_result_t rv;
+    uint64_t     oldsize = pctxt->output_file_offset;
+
+    /* the magic number and version flags are left untouched, only
+     * the attributes are re-written, and only if they take up
+     * exactly the same space as before, so the chunk offset tables
+     * (and the chunks they point at) stay where they are */
+    pctxt->do_write           = &count_write;
+    pctxt->output_file_offset = sizeof (uint32_t) * 2;
+    rv                        = internal_exr_write_part_headers (pctxt);
+    pctxt->do_write           = &dispatch_write;
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (pctxt->output_file_offset != oldsize)
+        return pctxt->print_error (
+            pctxt,
+            EXR_ERR_MODIFY_SIZE_CHANGE,
+            "Updated header is %" PRIu64
+            " bytes, but must match the original size of %" PRIu64
+            " bytes to be written in place",
+            pctxt->output_file_offset,
+            oldsize);
+
+    pctxt->output_file_offset = sizeof (uint32_t) * 2;
+    rv                        = internal_exr_write_part_headers (pctxt);
+    if (rv == EXR_ERR_SUCCESS) pctxt->mode = EXR_CONTEXT_WRITE_FINISHED;
+    return rv;
+}
+
+/**************************************/
+
 exr_result_t
 exr_write_header (exr_context_t ctxt)
 {
     exr_result_t rv = EXR_ERR_SUCCESS;
     EXR_PROMOTE_LOCKED_CONTEXT_OR_ERROR (ctxt);
 
+    if (pctxt->mode == EXR_CONTEXT_UPDATE_HEADER)
+        return EXR_UNLOCK_AND_RETURN_PCTXT (update_header_in_place (pctxt));
+
     if (pctxt->mode != EXR_CONTEXT_WRITE)
         return EXR_UNLOCK_AND_RETURN_PCTXT (
             pctxt->standard_error (pctxt, EXR_ERR_NOT_OPEN_WRITE));
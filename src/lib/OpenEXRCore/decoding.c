@@ -7,6 +7,7 @@
 
 #include "internal_coding.h"
 #include "internal_decompress.h"
+#include "internal_stats.h"
 #include "internal_structs.h"
 #include "internal_xdr.h"
 
@@ -217,8 +218,9 @@ decompress_data (
 
     if (packsz == 0) return EXR_ERR_SUCCESS;
 
-    if (packsz == unpacksz && ctype != EXR_COMPRESSION_B44 &&
-        ctype != EXR_COMPRESSION_B44A)
+    /* the C++ library stores chunks that do not get smaller
+     * uncompressed, for every compression method, B44 included */
+    if (packsz == unpacksz)
     {
         if (unpackbufptr != packbufptr)
             memcpy (unpackbufptr, packbufptr, unpacksz);
@@ -624,6 +626,7 @@ exr_decoding_run (
     exr_const_context_t ctxt, int part_index, exr_decode_pipeline_t* decode)
 {
     exr_result_t rv;
+    uint64_t     start;
     EXR_PROMOTE_READ_CONST_CONTEXT_AND_PART_OR_ERROR (ctxt, part_index);
 
     if (!decode) return pctxt->standard_error (pctxt, EXR_ERR_INVALID_ARGUMENT);
@@ -650,11 +653,17 @@ exr_decoding_run (
             rv,
             "Decode pipeline unable to update pack / unpack pointers");
 
+    start = internal_exr_stat_start (pctxt);
     if (rv == EXR_ERR_SUCCESS && decode->decompress_fn)
         rv = decode->decompress_fn (decode);
     if (rv != EXR_ERR_SUCCESS)
         return pctxt->report_error (
             pctxt, rv, "Decode pipeline unable to decompress data");
+    internal_exr_add_stat_time (pctxt, EXR_STAT_DECOMPRESS_NS, start);
+    internal_exr_add_stat (
+        pctxt, EXR_STAT_CHUNKS_DECODED + (int) part->comp_type, 1);
+    internal_exr_add_stat (
+        pctxt, EXR_STAT_BYTES_DECOMPRESSED, decode->chunk.unpacked_size);
 
     if (rv == EXR_ERR_SUCCESS &&
         (part->storage_mode == EXR_STORAGE_DEEP_SCANLINE ||
@@ -677,11 +686,13 @@ exr_decoding_run (
             rv,
             "Decode pipeline unable to realloc deep sample table info");
 
+    start = internal_exr_stat_start (pctxt);
     if (rv == EXR_ERR_SUCCESS && decode->unpack_and_convert_fn)
         rv = decode->unpack_and_convert_fn (decode);
     if (rv != EXR_ERR_SUCCESS)
         return pctxt->report_error (
             pctxt, rv, "Decode pipeline unable to unpack and convert data");
+    internal_exr_add_stat_time (pctxt, EXR_STAT_UNPACK_NS, start);
 
     return rv;
 }
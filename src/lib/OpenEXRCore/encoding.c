@@ -7,9 +7,12 @@
 
 #include "internal_coding.h"
 #include "internal_compress.h"
+#include "internal_stats.h"
 #include "internal_structs.h"
 #include "internal_xdr.h"
 
+#include <string.h>
+
 /**************************************/
 
 static exr_result_t
@@ -55,6 +58,20 @@ default_compress_chunk (exr_encode_pipeline_t* encode)
                 "Compression technique 0x%02X invalid",
                 (int) part->comp_type);
     }
+
+    /* like the C++ library, store chunks that did not get smaller
+     * uncompressed: readers take packed == unpacked size to mean the
+     * chunk is not compressed, and reject larger packed sizes */
+    if (rv == EXR_ERR_SUCCESS &&
+        encode->compressed_bytes >= encode->packed_bytes &&
+        encode->compressed_buffer != encode->packed_buffer)
+    {
+        memcpy (
+            encode->compressed_buffer,
+            encode->packed_buffer,
+            encode->packed_bytes);
+        encode->compressed_bytes = encode->packed_bytes;
+    }
     return rv;
 }
 
@@ -260,6 +277,7 @@ exr_encoding_run (
 {
     exr_result_t rv           = EXR_ERR_SUCCESS;
     uint64_t     packed_bytes = 0;
+    uint64_t     start;
     EXR_PROMOTE_CONST_CONTEXT_AND_PART_OR_ERROR (ctxt, part_index);
 
     if (!encode)
@@ -335,9 +353,9 @@ exr_encoding_run (
              (uint64_t) (encc->bytes_per_element));
     }
 
-    encode->packed_bytes = 0;
     if (encode->convert_and_pack_fn)
     {
+        encode->packed_bytes = 0;
         if (packed_bytes > 0)
         {
             rv = internal_encode_alloc_buffer (
@@ -347,11 +365,13 @@ exr_encoding_run (
                 &(encode->packed_alloc_size),
                 packed_bytes);
 
+            start = internal_exr_stat_start (pctxt);
             if (rv == EXR_ERR_SUCCESS)
                 rv = encode->convert_and_pack_fn (encode);
+            internal_exr_add_stat_time (pctxt, EXR_STAT_PACK_NS, start);
         }
     }
-    else if (!encode->packed_buffer || packed_bytes != encode->compressed_bytes)
+    else if (!encode->packed_buffer || packed_bytes != encode->packed_bytes)
     {
         return EXR_UNLOCK_WRITE_AND_RETURN_PCTXT (pctxt->report_error (
             pctxt,
@@ -371,9 +391,16 @@ exr_encoding_run (
 
     if (rv == EXR_ERR_SUCCESS)
     {
+        internal_exr_add_stat (
+            pctxt, EXR_STAT_CHUNKS_ENCODED + (int) part->comp_type, 1);
+        internal_exr_add_stat (
+            pctxt, EXR_STAT_BYTES_PACKED, encode->packed_bytes);
+
         if (encode->compress_fn && encode->packed_bytes > 0)
         {
-            rv = encode->compress_fn (encode);
+            start = internal_exr_stat_start (pctxt);
+            rv    = encode->compress_fn (encode);
+            internal_exr_add_stat_time (pctxt, EXR_STAT_COMPRESS_NS, start);
         }
         else
         {
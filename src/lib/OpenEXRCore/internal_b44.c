@@ -11,6 +11,13 @@
 
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(_M_X64)) &&                               \
+    (defined(__GNUC__) || defined(__clang__))
+#    define IMF_HAVE_TARGET_SSE4_1 1
+#    include <cpuid.h>
+#    include <smmintrin.h>
+#endif
+
 /**************************************/
 
 extern const uint16_t* exrcore_expTable;
@@ -53,58 +60,56 @@ shiftAndRound (int x, int shift)
     return (x + a + b) >> shift;
 }
 
+static inline void
+runningDifferences (const int d[16], int r[15])
+{
+    //
+    // Convert the absolute differences, d[0] ... d[15], of a 4 by 4
+    // pixel block into running differences, r[0] ... r[14], biased
+    // so that they end up between 0 and 63 for a valid shift.
+    //
+
+    const int bias = 0x20;
+
+    r[0] = d[0] - d[4] + bias;
+    r[1] = d[4] - d[8] + bias;
+    r[2] = d[8] - d[12] + bias;
+
+    r[3] = d[0] - d[1] + bias;
+    r[4] = d[4] - d[5] + bias;
+    r[5] = d[8] - d[9] + bias;
+    r[6] = d[12] - d[13] + bias;
+
+    r[7]  = d[1] - d[2] + bias;
+    r[8]  = d[5] - d[6] + bias;
+    r[9]  = d[9] - d[10] + bias;
+    r[10] = d[13] - d[14] + bias;
+
+    r[11] = d[2] - d[3] + bias;
+    r[12] = d[6] - d[7] + bias;
+    r[13] = d[10] - d[11] + bias;
+    r[14] = d[14] - d[15] + bias;
+}
+
 /*
- * Pack a block of 4 by 4 16-bit pixels (32 bytes) into
- * either 14 or 3 bytes.
- *
- *
- * Integers s[0] ... s[15] represent floating-point numbers
- * in what is essentially a sign-magnitude format.  Convert
- * s[0] .. s[15] into a new set of integers, t[0] ... t[15],
- * such that if t[i] is greater than t[j], the floating-point
- * number that corresponds to s[i] is always greater than
- * the floating-point number that corresponds to s[j].
- *
- * Also, replace any bit patterns that represent NaNs or
- * infinities with bit patterns that represent floating-point
- * zeroes.
- *
- *	bit pattern	floating-point		bit pattern
- *	in s[i]		value			in t[i]
- *
- *  0x7fff		NAN			0x8000
- *  0x7ffe		NAN			0x8000
- *	  ...					  ...
- *  0x7c01		NAN			0x8000
- *  0x7c00		+infinity		0x8000
- *  0x7bff		+HALF_MAX		0xfbff
- *  0x7bfe					0xfbfe
- *  0x7bfd					0xfbfd
- *	  ...					  ...
- *  0x0002		+2 * HALF_MIN		0x8002
- *  0x0001		+HALF_MIN		0x8001
- *  0x0000		+0.0			0x8000
- *  0x8000		-0.0			0x7fff
- *  0x8001		-HALF_MIN		0x7ffe
- *  0x8002		-2 * HALF_MIN		0x7ffd
- *	  ...					  ...
- *  0xfbfd					0x0f02
- *  0xfbfe					0x0401
- *  0xfbff		-HALF_MAX		0x0400
- *  0xfc00		-infinity		0x8000
- *  0xfc01		NAN			0x8000
- *	  ...					  ...
- *  0xfffe		NAN			0x8000
- *  0xffff		NAN			0x8000
+ * Find a shift value such that after rounding off the rightmost
+ * bits and shifting, all running differences between the pixels of
+ * a block are between -32 and +31 (see pack()).  Returns the shift
+ * value; t, tMax, d, rMin and rMax receive the values pack() needs.
  */
+
 static int
-pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
+roundDifferences_scalar (
+    const uint16_t s[16],
+    uint16_t       t[16],
+    uint16_t*      tMaxOut,
+    int            d[16],
+    int*           rMinOut,
+    int*           rMaxOut)
 {
-    int      d[16];
     int      r[15];
     int      rMin;
     int      rMax;
-    uint16_t t[16];
     uint16_t tMax;
     int      shift = -1;
 
@@ -131,8 +136,6 @@ pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
     // end up between 0 and 63.
     //
 
-    const int bias = 0x20;
-
     do
     {
         shift += 1;
@@ -151,24 +154,7 @@ pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
         // Convert d[0] .. d[15] into running differences
         //
 
-        r[0] = d[0] - d[4] + bias;
-        r[1] = d[4] - d[8] + bias;
-        r[2] = d[8] - d[12] + bias;
-
-        r[3] = d[0] - d[1] + bias;
-        r[4] = d[4] - d[5] + bias;
-        r[5] = d[8] - d[9] + bias;
-        r[6] = d[12] - d[13] + bias;
-
-        r[7]  = d[1] - d[2] + bias;
-        r[8]  = d[5] - d[6] + bias;
-        r[9]  = d[9] - d[10] + bias;
-        r[10] = d[13] - d[14] + bias;
-
-        r[11] = d[2] - d[3] + bias;
-        r[12] = d[6] - d[7] + bias;
-        r[13] = d[10] - d[11] + bias;
-        r[14] = d[14] - d[15] + bias;
+        runningDifferences (d, r);
 
         rMin = r[0];
         rMax = r[0];
@@ -181,58 +167,14 @@ pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
         }
     } while (rMin < 0 || rMax > 0x3f);
 
-    if (rMin == bias && rMax == bias && flatfields)
-    {
-        //
-        // Special case - all pixels have the same value.
-        // We encode this in 3 instead of 14 bytes by
-        // storing the value 0xfc in the third output byte,
-        // which cannot occur in the 14-byte encoding.
-        //
-
-        b[0] = (uint8_t) (t[0] >> 8);
-        b[1] = (uint8_t) t[0];
-        b[2] = 0xfc;
-
-        return 3;
-    }
-
-    if (exactmax)
-    {
-        //
-        // Adjust t[0] so that the pixel whose value is equal
-        // to tMax gets represented as accurately as possible.
-        //
-
-        t[0] = tMax - (uint16_t) (d[0] << shift);
-    }
-
-    //
-    // Pack t[0], shift and r[0] ... r[14] into 14 bytes:
-    //
-
-    b[0]  = (uint8_t) (t[0] >> 8);
-    b[1]  = (uint8_t) t[0];
-    b[2]  = (uint8_t) ((shift << 2) | (r[0] >> 4));
-    b[3]  = (uint8_t) ((r[0] << 4) | (r[1] >> 2));
-    b[4]  = (uint8_t) ((r[1] << 6) | r[2]);
-    b[5]  = (uint8_t) ((r[3] << 2) | (r[4] >> 4));
-    b[6]  = (uint8_t) ((r[4] << 4) | (r[5] >> 2));
-    b[7]  = (uint8_t) ((r[5] << 6) | r[6]);
-    b[8]  = (uint8_t) ((r[7] << 2) | (r[8] >> 4));
-    b[9]  = (uint8_t) ((r[8] << 4) | (r[9] >> 2));
-    b[10] = (uint8_t) ((r[9] << 6) | r[10]);
-    b[11] = (uint8_t) ((r[11] << 2) | (r[12] >> 4));
-    b[12] = (uint8_t) ((r[12] << 4) | (r[13] >> 2));
-    b[13] = (uint8_t) ((r[13] << 6) | r[14]);
-
-    return 14;
+    *tMaxOut = tMax;
+    *rMinOut = rMin;
+    *rMaxOut = rMax;
+    return shift;
 }
 
-/**************************************/
-
-static inline void
-unpack14 (const uint8_t b[14], uint16_t s[16])
+static void
+unpack14_scalar (const uint8_t b[14], uint16_t s[16])
 {
     s[0] = ((uint16_t) (b[0] << 8)) | ((uint16_t) b[1]);
 
@@ -282,6 +224,343 @@ unpack14 (const uint8_t b[14], uint16_t s[16])
     }
 }
 
+#ifdef IMF_HAVE_TARGET_SSE4_1
+
+/*
+ * SSE4.1 versions of roundDifferences() and unpack14().  They
+ * perform the same integer operations as the scalar code, on all
+ * sixteen pixels of a block at once, so the results are bit-for-bit
+ * identical.  They are compiled with a target attribute and chosen
+ * at run time if the processor supports SSE4.1.  A 4 by 4 block
+ * fits in two registers of eight 16-bit lanes; each 64-bit half of
+ * a register holds one row.
+ */
+
+__attribute__ ((target ("sse4.1"))) static inline __m128i
+orderedBits (__m128i s)
+{
+    const __m128i sign    = _mm_set1_epi16 ((short) 0x8000);
+    const __m128i expMask = _mm_set1_epi16 (0x7c00);
+
+    __m128i special = _mm_cmpeq_epi16 (_mm_and_si128 (s, expMask), expMask);
+    __m128i t = _mm_xor_si128 (s, _mm_or_si128 (_mm_srai_epi16 (s, 15), sign));
+
+    return _mm_blendv_epi8 (t, sign, special);
+}
+
+__attribute__ ((target ("sse4.1"))) static int
+roundDifferences_sse4 (
+    const uint16_t s[16],
+    uint16_t       t[16],
+    uint16_t*      tMax,
+    int            d[16],
+    int*           rMin,
+    int*           rMax)
+{
+    const int     bias = 0x20;
+    const __m128i ones = _mm_set1_epi32 (-1);
+    const __m128i one  = _mm_set1_epi32 (1);
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i       t0, t1, notMax, vMax, x0, x1;
+    __m128i       x[4], dv[4];
+    int           shift = -1;
+
+    t0 = orderedBits (_mm_loadu_si128 ((const __m128i*) s));
+    t1 = orderedBits (_mm_loadu_si128 ((const __m128i*) (s + 8)));
+
+    _mm_storeu_si128 ((__m128i*) t, t0);
+    _mm_storeu_si128 ((__m128i*) (t + 8), t1);
+
+    // the maximum of t is the complement of the minimum of ~t
+    notMax = _mm_xor_si128 (_mm_max_epu16 (t0, t1), ones);
+    *tMax  = (uint16_t) ~_mm_extract_epi16 (_mm_minpos_epu16 (notMax), 0);
+
+    // twice the differences between tMax and t, one row per register
+    vMax = _mm_set1_epi16 ((short) *tMax);
+    x0   = _mm_sub_epi16 (vMax, t0);
+    x1   = _mm_sub_epi16 (vMax, t1);
+
+    x[0] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (x0), 1);
+    x[1] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (_mm_srli_si128 (x0, 8)), 1);
+    x[2] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (x1), 1);
+    x[3] = _mm_slli_epi32 (_mm_cvtepu16_epi32 (_mm_srli_si128 (x1, 8)), 1);
+
+    do
+    {
+        __m128i a, count, minDiff, maxDiff;
+
+        shift += 1;
+
+        a     = _mm_set1_epi32 ((1 << shift) - 1);
+        count = _mm_cvtsi32_si128 (shift + 1);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i b = _mm_and_si128 (_mm_srl_epi32 (x[i], count), one);
+
+            dv[i] = _mm_srl_epi32 (
+                _mm_add_epi32 (_mm_add_epi32 (x[i], a), b), count);
+        }
+
+        //
+        // Horizontal differences (lane 3 of each row is unused) and
+        // vertical differences in the first column (only lane 0 is
+        // used).  Unused lanes are zero, which is always in range.
+        //
+
+        minDiff = zero;
+        maxDiff = zero;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i h = _mm_blend_epi16 (
+                _mm_sub_epi32 (dv[i], _mm_srli_si128 (dv[i], 4)), zero, 0xc0);
+
+            minDiff = _mm_min_epi32 (minDiff, h);
+            maxDiff = _mm_max_epi32 (maxDiff, h);
+
+            if (i < 3)
+            {
+                __m128i v = _mm_blend_epi16 (
+                    _mm_sub_epi32 (dv[i], dv[i + 1]), zero, 0xfc);
+
+                minDiff = _mm_min_epi32 (minDiff, v);
+                maxDiff = _mm_max_epi32 (maxDiff, v);
+            }
+        }
+
+        minDiff = _mm_min_epi32 (minDiff, _mm_srli_si128 (minDiff, 8));
+        minDiff = _mm_min_epi32 (minDiff, _mm_srli_si128 (minDiff, 4));
+        maxDiff = _mm_max_epi32 (maxDiff, _mm_srli_si128 (maxDiff, 8));
+        maxDiff = _mm_max_epi32 (maxDiff, _mm_srli_si128 (maxDiff, 4));
+
+        *rMin = _mm_cvtsi128_si32 (minDiff) + bias;
+        *rMax = _mm_cvtsi128_si32 (maxDiff) + bias;
+    } while (*rMin < 0 || *rMax > 0x3f);
+
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_si128 ((__m128i*) (d + 4 * i), dv[i]);
+
+    return shift;
+}
+
+__attribute__ ((target ("sse4.1"))) static void
+unpack14_sse4 (const uint8_t b[14], uint16_t s[16])
+{
+    const __m128i shuffle0 = _mm_setr_epi8 (
+        1, 0, 6, 5, 11, 10, 14, 13, 3, 2, 6, 5, 11, 10, 14, 13);
+    const __m128i shuffle1 = _mm_setr_epi8 (
+        4, 3, 7, 6, 12, 11, 15, 14, 5, 4, 10, 7, 13, 12, -128, 15);
+    const __m128i scale0 =
+        _mm_setr_epi16 (0, 64, 64, 64, 4096, 4096, 4096, 4096);
+    const __m128i scale1 =
+        _mm_setr_epi16 (1024, 1024, 1024, 1024, 256, 256, 256, 256);
+    const __m128i mask  = _mm_set1_epi16 (0x3f);
+    const __m128i lane0 = _mm_setr_epi16 (-1, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i lane4 = _mm_setr_epi16 (0, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i ones  = _mm_set1_epi32 (-1);
+    const __m128i mag   = _mm_set1_epi16 (0x7fff);
+    __m128i       in, w0, w1, s0, s1, shift, bias;
+
+    //
+    // Load bytes 0 to 7 into positions 0 to 7, and bytes 6 to 13
+    // into positions 8 to 15, without reading past the block.
+    //
+
+    in = _mm_unpacklo_epi64 (
+        _mm_loadl_epi64 ((const __m128i*) b),
+        _mm_loadl_epi64 ((const __m128i*) (b + 6)));
+
+    //
+    // Move the big-endian word containing each 6-bit difference into
+    // the lane of its pixel (lane 0 receives t[0]), shift it right by
+    // keeping the high half of a multiply with a power of two, and
+    // mask off the difference.
+    //
+
+    w0 = _mm_shuffle_epi8 (in, shuffle0);
+    w1 = _mm_shuffle_epi8 (in, shuffle1);
+
+    s0 = _mm_and_si128 (_mm_mulhi_epu16 (w0, scale0), mask);
+    s1 = _mm_and_si128 (_mm_mulhi_epu16 (w1, scale1), mask);
+
+    // scale and unbias the differences, and put t[0] in lane 0
+    shift = _mm_cvtsi32_si128 (b[2] >> 2);
+    bias  = _mm_sll_epi16 (_mm_set1_epi16 (0x20), shift);
+
+    s0 = _mm_sub_epi16 (_mm_sll_epi16 (s0, shift), bias);
+    s1 = _mm_sub_epi16 (_mm_sll_epi16 (s1, shift), bias);
+    s0 = _mm_insert_epi16 (s0, _mm_extract_epi16 (w0, 0), 0);
+
+    // running sums down the first column, then along each row
+    s0 = _mm_add_epi16 (s0, _mm_slli_si128 (_mm_and_si128 (s0, lane0), 8));
+    s1 = _mm_add_epi16 (s1, _mm_srli_si128 (_mm_and_si128 (s0, lane4), 8));
+    s1 = _mm_add_epi16 (s1, _mm_slli_si128 (_mm_and_si128 (s1, lane0), 8));
+
+    s0 = _mm_add_epi16 (s0, _mm_slli_epi64 (s0, 16));
+    s0 = _mm_add_epi16 (s0, _mm_slli_epi64 (s0, 32));
+    s1 = _mm_add_epi16 (s1, _mm_slli_epi64 (s1, 16));
+    s1 = _mm_add_epi16 (s1, _mm_slli_epi64 (s1, 32));
+
+    // back to half bit patterns: t & 0x7fff if t < 0, ~t otherwise
+    s0 = _mm_xor_si128 (
+        _mm_xor_si128 (s0, ones), _mm_and_si128 (_mm_srai_epi16 (s0, 15), mag));
+    s1 = _mm_xor_si128 (
+        _mm_xor_si128 (s1, ones), _mm_and_si128 (_mm_srai_epi16 (s1, 15), mag));
+
+    _mm_storeu_si128 ((__m128i*) s, s0);
+    _mm_storeu_si128 ((__m128i*) (s + 8), s1);
+}
+
+static void (*unpack14) (const uint8_t*, uint16_t*) = &unpack14_scalar;
+static int (*roundDifferences) (
+    const uint16_t*, uint16_t*, uint16_t*, int*, int*, int*) =
+    &roundDifferences_scalar;
+
+static void
+choose_b44_impl (void)
+{
+    unsigned int regs[4] = {0, 0, 0, 0};
+
+    __get_cpuid (0, &regs[0], &regs[1], &regs[2], &regs[3]);
+    if (regs[0] >= 1)
+    {
+        __get_cpuid (1, &regs[0], &regs[1], &regs[2], &regs[3]);
+    }
+    else
+        regs[2] = 0;
+
+    /* SSE4.1 is indicated by bit 19 */
+    if (regs[2] & (1 << 19))
+    {
+        unpack14         = &unpack14_sse4;
+        roundDifferences = &roundDifferences_sse4;
+    }
+}
+
+#else
+
+#    define unpack14 unpack14_scalar
+#    define roundDifferences roundDifferences_scalar
+
+static void
+choose_b44_impl (void)
+{}
+
+#endif /* IMF_HAVE_TARGET_SSE4_1 */
+
+static int init_cpu_check = 1;
+
+/*
+ * Pack a block of 4 by 4 16-bit pixels (32 bytes) into
+ * either 14 or 3 bytes.
+ *
+ *
+ * Integers s[0] ... s[15] represent floating-point numbers
+ * in what is essentially a sign-magnitude format.  Convert
+ * s[0] .. s[15] into a new set of integers, t[0] ... t[15],
+ * such that if t[i] is greater than t[j], the floating-point
+ * number that corresponds to s[i] is always greater than
+ * the floating-point number that corresponds to s[j].
+ *
+ * Also, replace any bit patterns that represent NaNs or
+ * infinities with bit patterns that represent floating-point
+ * zeroes.
+ *
+ *	bit pattern	floating-point		bit pattern
+ *	in s[i]		value			in t[i]
+ *
+ *  0x7fff		NAN			0x8000
+ *  0x7ffe		NAN			0x8000
+ *	  ...					  ...
+ *  0x7c01		NAN			0x8000
+ *  0x7c00		+infinity		0x8000
+ *  0x7bff		+HALF_MAX		0xfbff
+ *  0x7bfe					0xfbfe
+ *  0x7bfd					0xfbfd
+ *	  ...					  ...
+ *  0x0002		+2 * HALF_MIN		0x8002
+ *  0x0001		+HALF_MIN		0x8001
+ *  0x0000		+0.0			0x8000
+ *  0x8000		-0.0			0x7fff
+ *  0x8001		-HALF_MIN		0x7ffe
+ *  0x8002		-2 * HALF_MIN		0x7ffd
+ *	  ...					  ...
+ *  0xfbfd					0x0f02
+ *  0xfbfe					0x0401
+ *  0xfbff		-HALF_MAX		0x0400
+ *  0xfc00		-infinity		0x8000
+ *  0xfc01		NAN			0x8000
+ *	  ...					  ...
+ *  0xfffe		NAN			0x8000
+ *  0xffff		NAN			0x8000
+ */
+static int
+pack (const uint16_t s[16], uint8_t b[14], int flatfields, int exactmax)
+{
+    int      d[16];
+    int      r[15];
+    int      rMin;
+    int      rMax;
+    uint16_t t[16];
+    uint16_t tMax;
+    int      shift;
+
+    const int bias = 0x20;
+
+    shift = roundDifferences (s, t, &tMax, d, &rMin, &rMax);
+    runningDifferences (d, r);
+
+    if (rMin == bias && rMax == bias && flatfields)
+    {
+        //
+        // Special case - all pixels have the same value.
+        // We encode this in 3 instead of 14 bytes by
+        // storing the value 0xfc in the third output byte,
+        // which cannot occur in the 14-byte encoding.
+        //
+
+        b[0] = (uint8_t) (t[0] >> 8);
+        b[1] = (uint8_t) t[0];
+        b[2] = 0xfc;
+
+        return 3;
+    }
+
+    if (exactmax)
+    {
+        //
+        // Adjust t[0] so that the pixel whose value is equal
+        // to tMax gets represented as accurately as possible.
+        //
+
+        t[0] = tMax - (uint16_t) (d[0] << shift);
+    }
+
+    //
+    // Pack t[0], shift and r[0] ... r[14] into 14 bytes:
+    //
+
+    b[0]  = (uint8_t) (t[0] >> 8);
+    b[1]  = (uint8_t) t[0];
+    b[2]  = (uint8_t) ((shift << 2) | (r[0] >> 4));
+    b[3]  = (uint8_t) ((r[0] << 4) | (r[1] >> 2));
+    b[4]  = (uint8_t) ((r[1] << 6) | r[2]);
+    b[5]  = (uint8_t) ((r[3] << 2) | (r[4] >> 4));
+    b[6]  = (uint8_t) ((r[4] << 4) | (r[5] >> 2));
+    b[7]  = (uint8_t) ((r[5] << 6) | r[6]);
+    b[8]  = (uint8_t) ((r[7] << 2) | (r[8] >> 4));
+    b[9]  = (uint8_t) ((r[8] << 4) | (r[9] >> 2));
+    b[10] = (uint8_t) ((r[9] << 6) | r[10]);
+    b[11] = (uint8_t) ((r[11] << 2) | (r[12] >> 4));
+    b[12] = (uint8_t) ((r[12] << 4) | (r[13] >> 2));
+    b[13] = (uint8_t) ((r[13] << 6) | r[14]);
+
+    return 14;
+}
+
+/**************************************/
+
 static inline void
 unpack3 (const uint8_t b[3], uint16_t s[16])
 {
@@ -309,6 +588,12 @@ compress_b44_impl (exr_encode_pipeline_t* encode, int flat_field)
     uint64_t       bpl, nBytes;
     exr_result_t   rv;
 
+    if (init_cpu_check)
+    {
+        choose_b44_impl ();
+        init_cpu_check = 0;
+    }
+
     rv = internal_encode_alloc_buffer (
         encode,
         EXR_TRANSCODE_BUFFER_SCRATCH1,
@@ -486,6 +771,12 @@ uncompress_b44_impl (
     int            nx, ny;
     uint16_t       s[16];
 
+    if (init_cpu_check)
+    {
+        choose_b44_impl ();
+        init_cpu_check = 0;
+    }
+
     for (int c = 0; c < decode->channel_count; ++c)
     {
         const exr_coding_channel_info_t* curc = decode->channels + c;
@@ -11,6 +11,13 @@
 uint64_t internal_rle_compress (
     void* out, uint64_t outbytes, const void* src, uint64_t srcbytes);
 
+/*
+ * splits the bytes of the packed data into two halves and replaces
+ * them with their differences, as done before RLE and ZIP compression
+ */
+void internal_zip_deconstruct_bytes (
+    uint8_t* scratch, const uint8_t* source, uint64_t count);
+
 exr_result_t internal_exr_apply_rle (exr_encode_pipeline_t* encode);
 
 exr_result_t internal_exr_apply_zip (exr_encode_pipeline_t* encode);
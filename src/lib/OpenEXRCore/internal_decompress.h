@@ -17,6 +17,10 @@
 uint64_t internal_rle_decompress (
     uint8_t* out, uint64_t outbytes, const uint8_t* src, uint64_t srcbytes);
 
+/* undoes internal_zip_deconstruct_bytes, modifying scratch as it goes */
+void internal_zip_reconstruct_bytes (
+    uint8_t* out, uint8_t* scratch, uint64_t source_size);
+
 exr_result_t internal_exr_undo_rle (
     exr_decode_pipeline_t* decode,
     const void*            compressed_data,
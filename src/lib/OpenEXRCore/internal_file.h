@@ -30,6 +30,9 @@ int32_t
 internal_exr_compute_chunk_offset_size (struct _internal_exr_part* curpart);
 
 exr_result_t internal_exr_write_header (struct _internal_exr_context* ctxt);
+/* writes the attributes of every part, but not the magic number and flags */
+exr_result_t
+internal_exr_write_part_headers (struct _internal_exr_context* ctxt);
 
 /* in openexr_validate.c, functions to validate the header during read / pre-write */
 exr_result_t internal_exr_validate_read_part (
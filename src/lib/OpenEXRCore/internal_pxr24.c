@@ -12,6 +12,11 @@
 #include <string.h>
 #include <zlib.h>
 
+#if defined __SSE2__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
+#    define IMF_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
 /**************************************/
 
 static inline uint32_t
@@ -86,6 +91,450 @@ float_to_float24 (float f)
 
 /**************************************/
 
+//
+// Conversion of the pixels of one channel in one scan line to and
+// from byte planes.  The split functions replace each of the n pixel
+// values with the difference between the value and its left neighbor,
+// and store the most significant bytes of the differences in out[0]
+// ... out[n-1], the next bytes in out[n] ... out[2*n-1], and so on.
+// The join functions undo this.  Pixels begin ... n-1 are converted;
+// prev is the (24-bit) value of pixel begin-1.
+//
+
+static inline void
+split_uint_pixels (
+    const uint8_t* in, int begin, int n, uint32_t prev, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        uint32_t pixel = unaligned_load32 (in + 4 * x);
+        uint32_t diff  = pixel - prev;
+        prev           = pixel;
+
+        out[x]         = (uint8_t) (diff >> 24);
+        out[n + x]     = (uint8_t) (diff >> 16);
+        out[2 * n + x] = (uint8_t) (diff >> 8);
+        out[3 * n + x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+split_half_pixels (
+    const uint8_t* in, int begin, int n, uint32_t prev, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        uint32_t pixel = (uint32_t) unaligned_load16 (in + 2 * x);
+        uint32_t diff  = pixel - prev;
+        prev           = pixel;
+
+        out[x]     = (uint8_t) (diff >> 8);
+        out[n + x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+split_float_pixels (
+    const uint8_t* in, int begin, int n, uint32_t prev, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        union
+        {
+            uint32_t i;
+            float    f;
+        } v;
+        uint32_t pixel24, diff;
+        v.i     = unaligned_load32 (in + 4 * x);
+        pixel24 = float_to_float24 (v.f);
+        diff    = pixel24 - prev;
+        prev    = pixel24;
+
+        out[x]         = (uint8_t) (diff >> 16);
+        out[n + x]     = (uint8_t) (diff >> 8);
+        out[2 * n + x] = (uint8_t) (diff);
+    }
+}
+
+static inline void
+join_uint_pixels (
+    const uint8_t* in, int begin, int n, uint32_t pixel, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        uint32_t diff =
+            (((uint32_t) in[x] << 24) | ((uint32_t) in[n + x] << 16) |
+             ((uint32_t) in[2 * n + x] << 8) | ((uint32_t) in[3 * n + x]));
+        pixel += diff;
+        unaligned_store32 (out + 4 * x, pixel);
+    }
+}
+
+static inline void
+join_half_pixels (
+    const uint8_t* in, int begin, int n, uint32_t pixel, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        uint32_t diff = (((uint32_t) in[x] << 8) | ((uint32_t) in[n + x]));
+        pixel += diff;
+        unaligned_store16 (out + 2 * x, (uint16_t) pixel);
+    }
+}
+
+static inline void
+join_float_pixels (
+    const uint8_t* in, int begin, int n, uint32_t pixel, uint8_t* out)
+{
+    for (int x = begin; x < n; ++x)
+    {
+        uint32_t diff =
+            (((uint32_t) in[x] << 24) | ((uint32_t) in[n + x] << 16) |
+             ((uint32_t) in[2 * n + x] << 8));
+        pixel += diff;
+        unaligned_store32 (out + 4 * x, pixel);
+    }
+}
+
+#ifdef IMF_HAVE_SSE2
+
+//
+// SSE2 versions of the split and join functions process sixteen
+// pixels at a time, with the same integer arithmetic as the scalar
+// loops, so the results are bit-for-bit identical.  The remaining
+// pixels are converted by the scalar loops.
+//
+
+static inline __m128i
+float_to_float24_sse2 (__m128i u)
+{
+    const __m128i exp_mask = _mm_set1_epi32 (0x7f800000);
+    const __m128i zero     = _mm_setzero_si128 ();
+
+    __m128i s  = _mm_and_si128 (u, _mm_set1_epi32 ((int) 0x80000000));
+    __m128i e  = _mm_and_si128 (u, exp_mask);
+    __m128i m  = _mm_and_si128 (u, _mm_set1_epi32 (0x007fffff));
+    __m128i em = _mm_or_si128 (e, m);
+    __m128i m8 = _mm_srli_epi32 (m, 8);
+    __m128i r, overflow, finite, force_nan, special, is_special, i;
+
+    //
+    // Finite values: round the significand, or truncate it if
+    // rounding would overflow the exponent.  The rounded values
+    // are less than 2^24, so a signed comparison is safe.
+    //
+
+    r = _mm_srli_epi32 (
+        _mm_add_epi32 (em, _mm_and_si128 (m, _mm_set1_epi32 (0x80))), 8);
+    overflow = _mm_cmpgt_epi32 (r, _mm_set1_epi32 (0x7f7fff));
+    finite   = _mm_or_si128 (
+        _mm_and_si128 (overflow, _mm_srli_epi32 (em, 8)),
+        _mm_andnot_si128 (overflow, r));
+
+    //
+    // NANs keep the 15 leftmost bits of the significand, with at
+    // least one bit set; infinities keep the exponent.
+    //
+
+    force_nan = _mm_andnot_si128 (
+        _mm_cmpeq_epi32 (m, zero),
+        _mm_and_si128 (_mm_cmpeq_epi32 (m8, zero), _mm_set1_epi32 (1)));
+    special =
+        _mm_or_si128 (_mm_srli_epi32 (e, 8), _mm_or_si128 (m8, force_nan));
+
+    is_special = _mm_cmpeq_epi32 (e, exp_mask);
+    i          = _mm_or_si128 (
+        _mm_and_si128 (is_special, special),
+        _mm_andnot_si128 (is_special, finite));
+
+    return _mm_or_si128 (_mm_srli_epi32 (s, 8), i);
+}
+
+static inline __m128i
+differences32 (__m128i v, __m128i prev)
+{
+    return _mm_sub_epi32 (
+        v, _mm_or_si128 (_mm_slli_si128 (v, 4), _mm_srli_si128 (prev, 12)));
+}
+
+static inline void
+transpose32 (__m128i v[4])
+{
+    //
+    // Transpose the bytes of sixteen 32-bit values, so that v[k]
+    // holds byte k, counting from the least significant byte, of
+    // each value.  Each pass interleaves the first 32 bytes with the
+    // last 32; four passes move byte k of value j from position
+    // 4*j+k to position 16*k+j.
+    //
+
+    for (int pass = 0; pass < 4; ++pass)
+    {
+        __m128i a = _mm_unpacklo_epi8 (v[0], v[2]);
+        __m128i b = _mm_unpackhi_epi8 (v[0], v[2]);
+        __m128i c = _mm_unpacklo_epi8 (v[1], v[3]);
+        __m128i d = _mm_unpackhi_epi8 (v[1], v[3]);
+
+        v[0] = a;
+        v[1] = b;
+        v[2] = c;
+        v[3] = d;
+    }
+}
+
+static inline __m128i
+prefix_sum32 (__m128i v, __m128i* prev)
+{
+    v     = _mm_add_epi32 (v, _mm_slli_si128 (v, 4));
+    v     = _mm_add_epi32 (v, _mm_slli_si128 (v, 8));
+    v     = _mm_add_epi32 (v, *prev);
+    *prev = _mm_shuffle_epi32 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    return v;
+}
+
+static inline __m128i
+prefix_sum16 (__m128i v, __m128i* prev)
+{
+    v     = _mm_add_epi16 (v, _mm_slli_si128 (v, 2));
+    v     = _mm_add_epi16 (v, _mm_slli_si128 (v, 4));
+    v     = _mm_add_epi16 (v, _mm_slli_si128 (v, 8));
+    v     = _mm_add_epi16 (v, *prev);
+    *prev = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3));
+    *prev = _mm_unpackhi_epi64 (*prev, *prev);
+    return v;
+}
+
+static inline uint32_t
+last_value32 (__m128i v)
+{
+    return (uint32_t) _mm_cvtsi128_si32 (
+        _mm_shuffle_epi32 (v, _MM_SHUFFLE (3, 3, 3, 3)));
+}
+
+static void
+split_uint (const uint8_t* in, int n, uint8_t* out)
+{
+    __m128i prev = _mm_setzero_si128 ();
+    int     x    = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128i v[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i pixels =
+                _mm_loadu_si128 ((const __m128i*) (in + 4 * x) + k);
+            v[k] = differences32 (pixels, prev);
+            prev = pixels;
+        }
+
+        transpose32 (v);
+
+        _mm_storeu_si128 ((__m128i*) (out + x), v[3]);
+        _mm_storeu_si128 ((__m128i*) (out + n + x), v[2]);
+        _mm_storeu_si128 ((__m128i*) (out + 2 * n + x), v[1]);
+        _mm_storeu_si128 ((__m128i*) (out + 3 * n + x), v[0]);
+    }
+
+    split_uint_pixels (in, x, n, last_value32 (prev), out);
+}
+
+static void
+split_half (const uint8_t* in, int n, uint8_t* out)
+{
+    const __m128i low_bytes = _mm_set1_epi16 (0xff);
+    __m128i       prev      = _mm_setzero_si128 ();
+    int           x         = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128i d[2], hi, lo;
+
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i pixels =
+                _mm_loadu_si128 ((const __m128i*) (in + 2 * x) + k);
+            d[k] = _mm_sub_epi16 (
+                pixels,
+                _mm_or_si128 (
+                    _mm_slli_si128 (pixels, 2), _mm_srli_si128 (prev, 14)));
+            prev = pixels;
+        }
+
+        hi = _mm_packus_epi16 (
+            _mm_srli_epi16 (d[0], 8), _mm_srli_epi16 (d[1], 8));
+        lo = _mm_packus_epi16 (
+            _mm_and_si128 (d[0], low_bytes), _mm_and_si128 (d[1], low_bytes));
+
+        _mm_storeu_si128 ((__m128i*) (out + x), hi);
+        _mm_storeu_si128 ((__m128i*) (out + n + x), lo);
+    }
+
+    split_half_pixels (
+        in, x, n, (uint32_t) (uint16_t) _mm_extract_epi16 (prev, 7), out);
+}
+
+static void
+split_float (const uint8_t* in, int n, uint8_t* out)
+{
+    __m128i prev = _mm_setzero_si128 ();
+    int     x    = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128i v[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i pixels = float_to_float24_sse2 (
+                _mm_loadu_si128 ((const __m128i*) (in + 4 * x) + k));
+            v[k] = differences32 (pixels, prev);
+            prev = pixels;
+        }
+
+        transpose32 (v);
+
+        _mm_storeu_si128 ((__m128i*) (out + x), v[2]);
+        _mm_storeu_si128 ((__m128i*) (out + n + x), v[1]);
+        _mm_storeu_si128 ((__m128i*) (out + 2 * n + x), v[0]);
+    }
+
+    split_float_pixels (in, x, n, last_value32 (prev), out);
+}
+
+static inline void
+join32 (
+    __m128i  b0,
+    __m128i  b1,
+    __m128i  b2,
+    __m128i  b3,
+    __m128i* prev,
+    uint8_t* out)
+{
+    //
+    // Reassemble sixteen 32-bit differences from their bytes, b0
+    // being the least significant, and store their running sums.
+    //
+
+    __m128i  lo[2] = {_mm_unpacklo_epi8 (b0, b1), _mm_unpackhi_epi8 (b0, b1)};
+    __m128i  hi[2] = {_mm_unpacklo_epi8 (b2, b3), _mm_unpackhi_epi8 (b2, b3)};
+    __m128i* dout  = (__m128i*) out;
+
+    for (int k = 0; k < 2; ++k)
+    {
+        __m128i v0 = _mm_unpacklo_epi16 (lo[k], hi[k]);
+        __m128i v1 = _mm_unpackhi_epi16 (lo[k], hi[k]);
+
+        _mm_storeu_si128 (dout + 2 * k, prefix_sum32 (v0, prev));
+        _mm_storeu_si128 (dout + 2 * k + 1, prefix_sum32 (v1, prev));
+    }
+}
+
+static void
+join_uint (const uint8_t* in, int n, uint8_t* out)
+{
+    __m128i prev = _mm_setzero_si128 ();
+    int     x    = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        join32 (
+            _mm_loadu_si128 ((const __m128i*) (in + 3 * n + x)),
+            _mm_loadu_si128 ((const __m128i*) (in + 2 * n + x)),
+            _mm_loadu_si128 ((const __m128i*) (in + n + x)),
+            _mm_loadu_si128 ((const __m128i*) (in + x)),
+            &prev,
+            out + 4 * x);
+    }
+
+    join_uint_pixels (in, x, n, (uint32_t) _mm_cvtsi128_si32 (prev), out);
+}
+
+static void
+join_half (const uint8_t* in, int n, uint8_t* out)
+{
+    __m128i prev = _mm_setzero_si128 ();
+    int     x    = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128i  hi   = _mm_loadu_si128 ((const __m128i*) (in + x));
+        __m128i  lo   = _mm_loadu_si128 ((const __m128i*) (in + n + x));
+        __m128i* dout = (__m128i*) (out + 2 * x);
+
+        _mm_storeu_si128 (
+            dout, prefix_sum16 (_mm_unpacklo_epi8 (lo, hi), &prev));
+        _mm_storeu_si128 (
+            dout + 1, prefix_sum16 (_mm_unpackhi_epi8 (lo, hi), &prev));
+    }
+
+    join_half_pixels (
+        in, x, n, (uint32_t) (uint16_t) _mm_extract_epi16 (prev, 0), out);
+}
+
+static void
+join_float (const uint8_t* in, int n, uint8_t* out)
+{
+    __m128i prev = _mm_setzero_si128 ();
+    int     x    = 0;
+
+    for (; x + 16 <= n; x += 16)
+    {
+        join32 (
+            _mm_setzero_si128 (),
+            _mm_loadu_si128 ((const __m128i*) (in + 2 * n + x)),
+            _mm_loadu_si128 ((const __m128i*) (in + n + x)),
+            _mm_loadu_si128 ((const __m128i*) (in + x)),
+            &prev,
+            out + 4 * x);
+    }
+
+    join_float_pixels (in, x, n, (uint32_t) _mm_cvtsi128_si32 (prev), out);
+}
+
+#else
+
+static void
+split_uint (const uint8_t* in, int n, uint8_t* out)
+{
+    split_uint_pixels (in, 0, n, 0, out);
+}
+
+static void
+split_half (const uint8_t* in, int n, uint8_t* out)
+{
+    split_half_pixels (in, 0, n, 0, out);
+}
+
+static void
+split_float (const uint8_t* in, int n, uint8_t* out)
+{
+    split_float_pixels (in, 0, n, 0, out);
+}
+
+static void
+join_uint (const uint8_t* in, int n, uint8_t* out)
+{
+    join_uint_pixels (in, 0, n, 0, out);
+}
+
+static void
+join_half (const uint8_t* in, int n, uint8_t* out)
+{
+    join_half_pixels (in, 0, n, 0, out);
+}
+
+static void
+join_float (const uint8_t* in, int n, uint8_t* out)
+{
+    join_float_pixels (in, 0, n, 0, out);
+}
+
+#endif
+
+/**************************************/
+
 static exr_result_t
 apply_pxr24_impl (exr_encode_pipeline_t* encode)
 {
@@ -110,106 +559,33 @@ apply_pxr24_impl (exr_encode_pipeline_t* encode)
 
             switch (curc->data_type)
             {
-                case EXR_PIXEL_UINT: {
-                    uint8_t*        ptr[4];
-                    uint32_t        prevPixel = 0;
-                    const uint32_t* din       = (const uint32_t*) (lastIn);
-
+                case EXR_PIXEL_UINT:
                     nBytes *= sizeof (uint32_t);
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_uint (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += nBytes;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-                    ptr[2] = out;
-                    out += w;
-                    ptr[3] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t pixel = unaligned_load32 (din);
-                        uint32_t diff  = pixel - prevPixel;
-                        prevPixel      = pixel;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 24);
-                        *(ptr[1]++) = (uint8_t) (diff >> 16);
-                        *(ptr[2]++) = (uint8_t) (diff >> 8);
-                        *(ptr[3]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
-                case EXR_PIXEL_HALF: {
-                    uint8_t*        ptr[2];
-                    uint32_t        prevPixel = 0;
-                    const uint16_t* din       = (const uint16_t*) (lastIn);
-
+                case EXR_PIXEL_HALF:
                     nBytes *= sizeof (uint16_t);
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_half (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += nBytes;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t pixel = (uint32_t) unaligned_load16 (din);
-                        uint32_t diff  = pixel - prevPixel;
-                        prevPixel      = pixel;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 8);
-                        *(ptr[1]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
-                case EXR_PIXEL_FLOAT: {
-                    uint8_t*     ptr[3];
-                    uint32_t     prevPixel = 0;
-                    const float* din       = (const float*) (lastIn);
-
+                case EXR_PIXEL_FLOAT:
                     nBytes *= 3;
                     if (nOut + nBytes > encode->scratch_alloc_size_1)
                         return EXR_ERR_OUT_OF_MEMORY;
+                    split_float (lastIn, w, out);
                     nOut += nBytes;
                     lastIn += w * 4;
-
-                    ptr[0] = out;
-                    out += w;
-                    ptr[1] = out;
-                    out += w;
-                    ptr[2] = out;
-                    out += w;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        union
-                        {
-                            uint32_t i;
-                            float    f;
-                        } v;
-                        uint32_t pixel24, diff;
-                        v.i       = unaligned_load32 (din);
-                        pixel24   = float_to_float24 (v.f);
-                        diff      = pixel24 - prevPixel;
-                        prevPixel = pixel24;
-
-                        ++din;
-                        *(ptr[0]++) = (uint8_t) (diff >> 16);
-                        *(ptr[1]++) = (uint8_t) (diff >> 8);
-                        *(ptr[2]++) = (uint8_t) (diff);
-                    }
+                    out += nBytes;
                     break;
-                }
                 default: return EXR_ERR_INVALID_ARGUMENT;
             }
         }
@@ -298,88 +674,25 @@ undo_pxr24_impl (
 
             switch (curc->data_type)
             {
-                case EXR_PIXEL_UINT: {
-                    const uint8_t* ptr[4];
-                    uint32_t       pixel = 0;
-                    uint32_t*      dout  = (uint32_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-                    ptr[2] = lastIn;
-                    lastIn += w;
-                    ptr[3] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_UINT:
                     if (nDec + nBytes > outSize) return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 24) |
-                             ((uint32_t) (*(ptr[1]++)) << 16) |
-                             ((uint32_t) (*(ptr[2]++)) << 8) |
-                             ((uint32_t) (*(ptr[3]++))));
-                        pixel += diff;
-                        unaligned_store32 (dout, pixel);
-                        ++dout;
-                    }
+                    join_uint (lastIn, w, out);
+                    lastIn += nBytes;
                     nDec += nBytes;
                     break;
-                }
-                case EXR_PIXEL_HALF: {
-                    const uint8_t* ptr[2];
-                    uint32_t       pixel = 0;
-                    uint16_t*      dout  = (uint16_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_HALF:
                     if (nDec + nBytes > outSize) return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 8) |
-                             ((uint32_t) (*(ptr[1]++))));
-                        pixel += diff;
-                        unaligned_store16 (dout, (uint16_t) pixel);
-                        ++dout;
-                    }
+                    join_half (lastIn, w, out);
+                    lastIn += nBytes;
                     nDec += nBytes;
                     break;
-                }
-                case EXR_PIXEL_FLOAT: {
-                    const uint8_t* ptr[3];
-                    uint32_t       pixel = 0;
-                    uint32_t*      dout  = (uint32_t*) (out);
-
-                    ptr[0] = lastIn;
-                    lastIn += w;
-                    ptr[1] = lastIn;
-                    lastIn += w;
-                    ptr[2] = lastIn;
-                    lastIn += w;
-
+                case EXR_PIXEL_FLOAT:
                     if (nDec + (uint64_t) (w * 3) > outSize)
                         return EXR_ERR_CORRUPT_CHUNK;
-
-                    for (int x = 0; x < w; ++x)
-                    {
-                        uint32_t diff =
-                            (((uint32_t) (*(ptr[0]++)) << 24) |
-                             ((uint32_t) (*(ptr[1]++)) << 16) |
-                             ((uint32_t) (*(ptr[2]++)) << 8));
-                        pixel += diff;
-                        unaligned_store32 (dout, pixel);
-                        ++dout;
-                    }
+                    join_float (lastIn, w, out);
+                    lastIn += w * 3;
                     nDec += (uint64_t) (w * 3);
                     break;
-                }
                 default: return EXR_ERR_INVALID_ARGUMENT;
             }
             out += nBytes;
@@ -11,9 +11,97 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined __SSE2__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
+#    define IMF_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
 #define MIN_RUN_LENGTH 3
 #define MAX_RUN_LENGTH 127
 
+/**************************************/
+
+#ifdef IMF_HAVE_SSE2
+
+static inline int
+first_set_bit (uint32_t mask)
+{
+#    if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward (&idx, mask);
+    return (int) idx;
+#    elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz (mask);
+#    else
+    int idx = 0;
+    while (0 == (mask & 1))
+    {
+        mask >>= 1;
+        ++idx;
+    }
+    return idx;
+#    endif
+}
+
+#endif
+
+/*
+ * returns the first byte at or after rune, and before limit, that
+ * differs from *runs, or limit if there is none
+ */
+static inline const int8_t*
+equal_run_end (const int8_t* runs, const int8_t* rune, const int8_t* limit)
+{
+#ifdef IMF_HAVE_SSE2
+    const __m128i v = _mm_set1_epi8 (*runs);
+
+    while (limit - rune >= (ptrdiff_t) sizeof (__m128i))
+    {
+        __m128i d    = _mm_loadu_si128 ((const __m128i*) rune);
+        int     mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (d, v));
+
+        if (mask != 0xffff) return rune + first_set_bit (~mask & 0xffff);
+
+        rune += sizeof (__m128i);
+    }
+#endif
+
+    while (rune < limit && *runs == *rune)
+        ++rune;
+    return rune;
+}
+
+/*
+ * returns the first byte at or after rune, and before limit, that
+ * starts a run of MIN_RUN_LENGTH equal bytes, or limit if there is
+ * none
+ */
+static inline const int8_t*
+literal_run_end (const int8_t* rune, const int8_t* limit, const int8_t* end)
+{
+#ifdef IMF_HAVE_SSE2
+    /* the comparisons look up to two bytes past each block */
+    while (limit - rune >= (ptrdiff_t) sizeof (__m128i) &&
+           end - rune >= (ptrdiff_t) sizeof (__m128i) + 2)
+    {
+        __m128i a    = _mm_loadu_si128 ((const __m128i*) rune);
+        __m128i b    = _mm_loadu_si128 ((const __m128i*) (rune + 1));
+        __m128i c    = _mm_loadu_si128 ((const __m128i*) (rune + 2));
+        int     mask = _mm_movemask_epi8 (
+            _mm_and_si128 (_mm_cmpeq_epi8 (a, b), _mm_cmpeq_epi8 (b, c)));
+
+        if (mask != 0) return rune + first_set_bit ((uint32_t) mask);
+
+        rune += sizeof (__m128i);
+    }
+#endif
+
+    while (rune < limit &&
+           (end - rune <= 2 || rune[0] != rune[1] || rune[1] != rune[2]))
+        ++rune;
+    return rune;
+}
+
 uint64_t
 internal_rle_compress (
     void* out, uint64_t outbytes, const void* src, uint64_t srcbytes)
@@ -22,20 +110,18 @@ internal_rle_compress (
     const int8_t* runs = src;
     const int8_t* end  = runs + srcbytes;
     const int8_t* rune = runs + 1;
+    const int8_t* limit;
     uint64_t      outb = 0;
 
     while (runs < end)
     {
-        uint8_t curcount = 0;
-        while (rune < end && *runs == *rune && curcount < MAX_RUN_LENGTH)
-        {
-            ++rune;
-            ++curcount;
-        }
+        limit = (end - runs > MAX_RUN_LENGTH + 1) ? runs + MAX_RUN_LENGTH + 1
+                                                   : end;
+        rune  = equal_run_end (runs, rune, limit);
 
-        if (curcount >= (MIN_RUN_LENGTH - 1))
+        if (rune - runs >= MIN_RUN_LENGTH)
         {
-            cbuf[outb++] = (int8_t) curcount;
+            cbuf[outb++] = (int8_t) (rune - runs - 1);
             cbuf[outb++] = *runs;
 
             runs = rune;
@@ -43,18 +129,13 @@ internal_rle_compress (
         else
         {
             /* incompressible */
-            ++curcount;
-            while (rune < end &&
-                   ((rune + 1 >= end || *rune != *(rune + 1)) ||
-                    (rune + 2 >= end || *(rune + 1) != *(rune + 2))) &&
-                   curcount < MAX_RUN_LENGTH)
-            {
-                ++curcount;
-                ++rune;
-            }
-            cbuf[outb++] = (int8_t) (-((int) curcount));
-            while (runs < rune)
-                cbuf[outb++] = *runs++;
+            limit = (end - runs > MAX_RUN_LENGTH) ? runs + MAX_RUN_LENGTH : end;
+            rune  = literal_run_end (rune, limit, end);
+
+            cbuf[outb++] = (int8_t) (runs - rune);
+            memcpy (cbuf + outb, runs, (size_t) (rune - runs));
+            outb += (uint64_t) (rune - runs);
+            runs = rune;
         }
         ++rune;
         if (outb >= outbytes) break;
@@ -64,30 +145,6 @@ internal_rle_compress (
 
 /**************************************/
 
-static void
-reorder_and_predict (void* scratch, const void* packed, uint64_t packedbytes)
-{
-    int8_t*       t1   = scratch;
-    int8_t*       t2   = t1 + (packedbytes + 1) / 2;
-    const int8_t* in   = packed;
-    const int8_t* stop = in + packedbytes;
-    while (in < stop)
-    {
-        *(t1++) = *(in++);
-        if (in < stop) *(t2++) = *(in++);
-    }
-
-    t1    = scratch;
-    stop  = t1 + packedbytes;
-    int p = *(t1++);
-    while (t1 < stop)
-    {
-        int d = (int) (*t1) - p + (128 + 256);
-        p     = *t1;
-        *t1++ = (int8_t) (d);
-    }
-}
-
 exr_result_t
 internal_exr_apply_rle (exr_encode_pipeline_t* encode)
 {
@@ -104,7 +161,8 @@ internal_exr_apply_rle (exr_encode_pipeline_t* encode)
         srcb);
     if (rv != EXR_ERR_SUCCESS) return rv;
 
-    reorder_and_predict (encode->scratch_buffer_1, encode->packed_buffer, srcb);
+    internal_zip_deconstruct_bytes (
+        encode->scratch_buffer_1, encode->packed_buffer, srcb);
 
     outb = internal_rle_compress (
         encode->compressed_buffer,
@@ -123,6 +181,38 @@ internal_exr_apply_rle (exr_encode_pipeline_t* encode)
 
 /**************************************/
 
+#ifdef IMF_HAVE_SSE2
+
+/*
+ * calling memcpy and memset costs more than the copy itself for the
+ * short runs RLE produces: when both buffers have room past the end
+ * of a run, copy or fill whole blocks instead
+ */
+static inline uint64_t
+block_bytes (uint64_t count)
+{
+    return (count + sizeof (__m128i) - 1) & ~(uint64_t) (sizeof (__m128i) - 1);
+}
+
+static inline void
+copy_blocks (uint8_t* dst, const uint8_t* src, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i += sizeof (__m128i))
+        _mm_storeu_si128 (
+            (__m128i*) (dst + i), _mm_loadu_si128 ((const __m128i*) (src + i)));
+}
+
+static inline void
+fill_blocks (uint8_t* dst, uint8_t value, uint64_t count)
+{
+    const __m128i v = _mm_set1_epi8 ((char) value);
+
+    for (uint64_t i = 0; i < count; i += sizeof (__m128i))
+        _mm_storeu_si128 ((__m128i*) (dst + i), v);
+}
+
+#endif
+
 uint64_t
 internal_rle_decompress (
     uint8_t* out, uint64_t outsz, const uint8_t* src, uint64_t packsz)
@@ -141,7 +231,13 @@ internal_rle_decompress (
             if (unpackbytes + count > packsz) return EXR_ERR_CORRUPT_CHUNK;
             if (outbytes + count > outsz) return EXR_ERR_CORRUPT_CHUNK;
 
-            memcpy (dst, in, count);
+#ifdef IMF_HAVE_SSE2
+            if (packsz - unpackbytes >= block_bytes (count) &&
+                outsz - outbytes >= block_bytes (count))
+                copy_blocks (dst, (const uint8_t*) in, count);
+            else
+#endif
+                memcpy (dst, in, count);
             in += count;
             dst += count;
             unpackbytes += count;
@@ -156,7 +252,12 @@ internal_rle_decompress (
             ++count;
             if (outbytes + count > outsz) return EXR_ERR_CORRUPT_CHUNK;
 
-            memset (dst, *(const uint8_t*) in, count);
+#ifdef IMF_HAVE_SSE2
+            if (outsz - outbytes >= block_bytes (count))
+                fill_blocks (dst, *(const uint8_t*) in, count);
+            else
+#endif
+                memset (dst, *(const uint8_t*) in, count);
             dst += count;
             outbytes += count;
             ++in;
@@ -165,31 +266,6 @@ internal_rle_decompress (
     return outbytes;
 }
 
-static void
-unpredict_and_reorder (void* out, void* scratch, uint64_t packedbytes)
-{
-    int8_t*       t1   = scratch;
-    int8_t*       t2   = t1 + (packedbytes + 1) / 2;
-    int8_t*       s    = out;
-    const int8_t* stop = t1 + packedbytes;
-
-    ++t1;
-    while (t1 < stop)
-    {
-        int d = (int) (t1[-1]) + (int) (t1[0]) - 128;
-        t1[0] = (int8_t) d;
-        ++t1;
-    }
-
-    t1   = scratch;
-    stop = s + packedbytes;
-    while (s < stop)
-    {
-        *(s++) = *(t1++);
-        if (s < stop) *(s++) = *(t2++);
-    }
-}
-
 exr_result_t
 internal_exr_undo_rle (
     exr_decode_pipeline_t* decode,
@@ -212,6 +288,6 @@ internal_exr_undo_rle (
         internal_rle_decompress (decode->scratch_buffer_1, outsz, src, packsz);
     if (unpackb != outsz) return EXR_ERR_CORRUPT_CHUNK;
 
-    unpredict_and_reorder (out, decode->scratch_buffer_1, outsz);
+    internal_zip_reconstruct_bytes (out, decode->scratch_buffer_1, outsz);
     return EXR_ERR_SUCCESS;
 }
@@ -0,0 +1,67 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_STATS_H
+#define OPENEXR_PRIVATE_STATS_H
+
+#include "internal_structs.h"
+
+/* the counters behind exr_stats_t, the chunk counts are indexed by
+ * compression type */
+enum _INTERNAL_EXR_STAT
+{
+    EXR_STAT_BYTES_READ = 0,
+    EXR_STAT_READS,
+    EXR_STAT_BYTES_WRITTEN,
+    EXR_STAT_WRITES,
+    EXR_STAT_BYTES_DECOMPRESSED,
+    EXR_STAT_BYTES_PACKED,
+    EXR_STAT_READ_NS,
+    EXR_STAT_DECOMPRESS_NS,
+    EXR_STAT_UNPACK_NS,
+    EXR_STAT_PACK_NS,
+    EXR_STAT_COMPRESS_NS,
+    EXR_STAT_WRITE_NS,
+    EXR_STAT_CHUNKS_DECODED,
+    EXR_STAT_CHUNKS_ENCODED =
+        EXR_STAT_CHUNKS_DECODED + EXR_COMPRESSION_LAST_TYPE,
+    EXR_STAT_COUNT = EXR_STAT_CHUNKS_ENCODED + EXR_COMPRESSION_LAST_TYPE
+};
+
+/* size of the counters, which are stored after the context */
+size_t internal_exr_stats_size (void);
+
+void internal_exr_init_stats (struct _internal_exr_stats* stats);
+
+void internal_exr_add_stat_impl (
+    struct _internal_exr_stats* stats, int stat, uint64_t value);
+
+uint64_t internal_exr_stats_now (void);
+
+/* all of these do nothing unless the context collects statistics */
+
+static inline void
+internal_exr_add_stat (
+    const struct _internal_exr_context* ctxt, int stat, uint64_t value)
+{
+    if (ctxt->stats) internal_exr_add_stat_impl (ctxt->stats, stat, value);
+}
+
+static inline uint64_t
+internal_exr_stat_start (const struct _internal_exr_context* ctxt)
+{
+    return ctxt->stats ? internal_exr_stats_now () : 0;
+}
+
+static inline void
+internal_exr_add_stat_time (
+    const struct _internal_exr_context* ctxt, int stat, uint64_t start)
+{
+    if (ctxt->stats)
+        internal_exr_add_stat_impl (
+            ctxt->stats, stat, internal_exr_stats_now () - start);
+}
+
+#endif /* OPENEXR_PRIVATE_STATS_H */
@@ -7,6 +7,7 @@
 #include "internal_attr.h"
 #include "internal_constants.h"
 #include "internal_memory.h"
+#include "internal_stats.h"
 
 #include <IlmThreadConfig.h>
 
@@ -338,12 +339,21 @@ internal_exr_alloc_context (
     *out = NULL;
     int    gmaxw, gmaxh;
     size_t extra_data;
+    size_t stats_offset = 0;
 
     if (initializers->read_fn || initializers->write_fn)
         extra_data = 0;
     else
         extra_data = default_size;
 
+    if (initializers->flags & EXR_CONTEXT_FLAG_COLLECT_STATS)
+    {
+        stats_offset = sizeof (struct _internal_exr_context) + extra_data;
+        stats_offset = (stats_offset + 15) & ~((size_t) 15);
+        extra_data   = stats_offset - sizeof (struct _internal_exr_context) +
+                     internal_exr_stats_size ();
+    }
+
     memptr = (initializers->alloc_fn) (
         sizeof (struct _internal_exr_context) + extra_data);
     if (memptr)
@@ -417,6 +427,13 @@ internal_exr_alloc_context (
             (initializers->flags &
              EXR_CONTEXT_FLAG_DISABLE_CHUNK_RECONSTRUCTION);
 
+        if (stats_offset > 0)
+        {
+            ret->stats = (struct _internal_exr_stats*) (((uint8_t*) memptr) +
+                                                        stats_offset);
+            internal_exr_init_stats (ret->stats);
+        }
+
         ret->file_size       = -1;
         ret->max_name_length = EXR_SHORTNAME_MAXLEN;
 
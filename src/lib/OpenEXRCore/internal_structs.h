@@ -213,6 +213,10 @@ struct _internal_exr_context
 #    endif
 #endif
     uint8_t disable_chunk_reconstruct;
+
+    /* counters, stored after the context and any extra data, null
+     * unless the context collects statistics */
+    struct _internal_exr_stats* stats;
 };
 
 #define EXR_CTXT(c) ((struct _internal_exr_context*) (c))
@@ -32,16 +32,18 @@
 
 /**************************************/
 
-#ifdef IMF_HAVE_SSE4_1
+#if defined(IMF_HAVE_SSE4_1) || defined(IMF_HAVE_SSE2)
 static void
 reconstruct (uint8_t* buf, uint64_t outSize)
 {
     static const uint64_t bytesPerChunk = sizeof (__m128i);
     const uint64_t        vOutSize      = outSize / bytesPerChunk;
     const __m128i         c             = _mm_set1_epi8 (-128);
-    const __m128i         shuffleMask   = _mm_set1_epi8 (15);
     __m128i *             vBuf, vPrev;
     uint8_t               prev;
+#    ifdef IMF_HAVE_SSE4_1
+    const __m128i shuffleMask = _mm_set1_epi8 (15);
+#    endif
 
     /*
      * The first element doesn't have its high bit flipped during compression,
@@ -67,10 +69,17 @@ reconstruct (uint8_t* buf, uint64_t outSize)
 
         // Broadcast the high byte in our result to all lanes of the prev
         // value for the next iteration.
+#    ifdef IMF_HAVE_SSE4_1
         vPrev = _mm_shuffle_epi8 (d, shuffleMask);
+#    else
+        vPrev = _mm_srli_si128 (d, 15);
+        vPrev = _mm_unpacklo_epi8 (vPrev, vPrev);
+        vPrev = _mm_unpacklo_epi16 (vPrev, vPrev);
+        vPrev = _mm_shuffle_epi32 (vPrev, 0);
+#    endif
     }
 
-    prev = _mm_extract_epi8 (vPrev, 15);
+    prev = (uint8_t) _mm_cvtsi128_si32 (vPrev);
     for (uint64_t i = vOutSize * bytesPerChunk; i < outSize; ++i)
     {
         uint8_t d = prev + buf[i] - 128;
@@ -226,6 +235,129 @@ interleave (uint8_t* out, const uint8_t* source, uint64_t outSize)
 
 /**************************************/
 
+#ifdef IMF_HAVE_SSE2
+static void
+deinterleave (uint8_t* out, const uint8_t* source, uint64_t count)
+{
+    static const uint64_t bytesPerChunk = 2 * sizeof (__m128i);
+    const uint64_t        vCount        = count / bytesPerChunk;
+    const __m128i         lowBytes      = _mm_set1_epi16 (0xff);
+    const __m128i*        vIn           = (const __m128i*) source;
+    __m128i*              v1            = (__m128i*) out;
+    __m128i*              v2 = (__m128i*) (out + (count + 1) / 2);
+    uint8_t *             t1, *t2;
+
+    for (uint64_t i = 0; i < vCount; ++i)
+    {
+        __m128i a    = _mm_loadu_si128 (vIn++);
+        __m128i b    = _mm_loadu_si128 (vIn++);
+        __m128i even = _mm_packus_epi16 (
+            _mm_and_si128 (a, lowBytes), _mm_and_si128 (b, lowBytes));
+        __m128i odd = _mm_packus_epi16 (
+            _mm_srli_epi16 (a, 8), _mm_srli_epi16 (b, 8));
+
+        _mm_storeu_si128 (v1++, even);
+        _mm_storeu_si128 (v2++, odd);
+    }
+
+    t1 = (uint8_t*) v1;
+    t2 = (uint8_t*) v2;
+
+    for (uint64_t i = vCount * bytesPerChunk; i < count; ++i)
+    {
+        if (i % 2 == 0)
+            *(t1++) = source[i];
+        else
+            *(t2++) = source[i];
+    }
+}
+
+static void
+predict (uint8_t* buf, uint64_t count)
+{
+    const __m128i c = _mm_set1_epi8 (-128);
+    uint64_t      i = count;
+
+    /*
+     * Work backwards, so that every byte is still unmodified when
+     * the difference to its right neighbour is computed.
+     */
+    while (i > sizeof (__m128i))
+    {
+        __m128i cur, left;
+
+        i -= sizeof (__m128i);
+        cur  = _mm_loadu_si128 ((const __m128i*) (buf + i));
+        left = _mm_loadu_si128 ((const __m128i*) (buf + i - 1));
+        _mm_storeu_si128 (
+            (__m128i*) (buf + i), _mm_add_epi8 (_mm_sub_epi8 (cur, left), c));
+    }
+
+    while (i > 1)
+    {
+        --i;
+        buf[i] = (uint8_t) (buf[i] - buf[i - 1] + 128);
+    }
+}
+
+#else
+
+static void
+deinterleave (uint8_t* out, const uint8_t* source, uint64_t count)
+{
+    uint8_t*       t1   = out;
+    uint8_t*       t2   = t1 + (count + 1) / 2;
+    const uint8_t* stop = source + count;
+
+    while (source < stop)
+    {
+        *(t1++) = *(source++);
+        if (source < stop) *(t2++) = *(source++);
+    }
+}
+
+static void
+predict (uint8_t* buf, uint64_t count)
+{
+    uint8_t* t    = buf + 1;
+    uint8_t* stop = buf + count;
+    int      p    = (int) buf[0];
+
+    while (t < stop)
+    {
+        int d = (int) (t[0]) - p + (128 + 256);
+        p     = (int) t[0];
+        t[0]  = (uint8_t) d;
+        ++t;
+    }
+}
+
+#endif
+
+/**************************************/
+
+void
+internal_zip_deconstruct_bytes (
+    uint8_t* scratch, const uint8_t* source, uint64_t count)
+{
+    if (count == 0) return;
+
+    deinterleave (scratch, source, count);
+    predict (scratch, count);
+}
+
+void
+internal_zip_reconstruct_bytes (
+    uint8_t* out, uint8_t* scratch, uint64_t source_size)
+{
+    if (source_size == 0) return;
+
+    reconstruct (scratch, source_size);
+    interleave (out, scratch, source_size);
+}
+
+/**************************************/
+
 static exr_result_t
 undo_zip_impl (
     const void* compressed_data,
@@ -249,8 +381,8 @@ undo_zip_impl (
     {
         if (outSize == uncompressed_size)
         {
-            reconstruct (scratch_data, outSize);
-            interleave (uncompressed_data, scratch_data, outSize);
+            internal_zip_reconstruct_bytes (
+                uncompressed_data, scratch_data, outSize);
             rstat = EXR_ERR_SUCCESS;
         }
         else
@@ -302,37 +434,16 @@ internal_exr_undo_zip (
 static exr_result_t
 apply_zip_impl (exr_encode_pipeline_t* encode)
 {
-    uint8_t*       t1   = encode->scratch_buffer_1;
-    uint8_t*       t2   = t1 + (encode->packed_bytes + 1) / 2;
-    const uint8_t* raw  = encode->packed_buffer;
-    const uint8_t* stop = raw + encode->packed_bytes;
-    int            p, level;
-    uLong          compbufsz = (uLong) encode->compressed_alloc_size;
-    exr_result_t   rv        = EXR_ERR_SUCCESS;
+    int          level;
+    uLong        compbufsz = (uLong) encode->compressed_alloc_size;
+    exr_result_t rv        = EXR_ERR_SUCCESS;
 
     rv = exr_get_zip_compression_level (
         encode->context, encode->part_index, &level);
     if (rv != EXR_ERR_SUCCESS) return rv;
 
-    /* reorder */
-    while (raw < stop)
-    {
-        *(t1++) = *(raw++);
-        if (raw < stop) *(t2++) = *(raw++);
-    }
-
-    /* reorder */
-    t1 = encode->scratch_buffer_1;
-    t2 = t1 + encode->packed_bytes;
-    t1++;
-    p = (int) t1[-1];
-    while (t1 < t2)
-    {
-        int d = (int) (t1[0]) - p + (128 + 256);
-        p     = (int) t1[0];
-        t1[0] = (uint8_t) d;
-        ++t1;
-    }
+    internal_zip_deconstruct_bytes (
+        encode->scratch_buffer_1, encode->packed_buffer, encode->packed_bytes);
 
     if (Z_OK != compress2 (
                     (Bytef*) encode->compressed_buffer,
@@ -342,6 +342,12 @@ typedef struct _exr_context_initializer_v3
  */
 #define EXR_CONTEXT_FLAG_DISABLE_CHUNK_RECONSTRUCTION (1 << 2)
 
+/** @brief Collect statistics about reading and writing the file
+ *
+ * See @ref exr_get_stats.
+ */
+#define EXR_CONTEXT_FLAG_COLLECT_STATS (1 << 3)
+
 /** @brief Simple macro to initialize the context initializer with default values. */
 #define EXR_DEFAULT_CONTEXT_INITIALIZER                                        \
     {                                                                          \
@@ -450,6 +456,13 @@ EXR_EXPORT exr_result_t exr_start_write (
  * metadata entry, although not to change the size of the header, or
  * any of the image data.
  *
+ * The header is read as by exr_start_read(). Existing attributes may
+ * then be changed with the exr_attr_set_* functions, as long as their
+ * size stays the same (a string of the same length, a preview image of
+ * the same dimensions, etc.). Attributes can not be added or removed.
+ * Call exr_write_header() to write the changes to the file; calling
+ * exr_finish() without it leaves the file as it was.
+ *
  * If you have custom I/O requirements, see the initializer context
  * documentation \ref exr_context_initializer_t. The @p ctxtdata parameter
  * is optional, if `NULL`, default values will be used.
@@ -524,6 +537,12 @@ exr_set_longname_support (exr_context_t ctxt, int onoff);
  * It will recompute the number of chunks that will be written, and
  * reset the chunk offsets. If you modify file attributes or part
  * information after a call to this, it will error.
+ *
+ * For a context created with exr_start_inplace_header_update(), this
+ * writes the modified attributes back to the file instead. This fails
+ * with \c EXR_ERR_MODIFY_SIZE_CHANGE, leaving the file untouched, if
+ * the updated header would not occupy exactly the same number of bytes
+ * as the original one.
  */
 EXR_EXPORT exr_result_t exr_write_header (exr_context_t ctxt);
 
@@ -225,6 +225,10 @@ typedef struct _exr_encode_pipeline
      * If the user has a custom method for the
      * compression on this part, this can be changed after
      * initialization.
+     *
+     * If `NULL`, the data is assumed to already be packed: the caller
+     * must provide packed_buffer and set packed_bytes to the full
+     * packed size of the chunk.
      */
     exr_result_t (*convert_and_pack_fn) (struct _exr_encode_pipeline* pipeline);
 
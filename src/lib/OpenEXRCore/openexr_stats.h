@@ -0,0 +1,89 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_STATS_H
+#define OPENEXR_STATS_H
+
+#include "openexr_attr.h"
+#include "openexr_context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file */
+
+/**
+ * @defgroup Statistics Statistics about reading and writing files
+ *
+ * A context that is created with the flag
+ * @ref EXR_CONTEXT_FLAG_COLLECT_STATS counts the bytes it reads and
+ * writes and the chunks it decodes and encodes, and measures the
+ * time spent in each stage of the decode and encode pipelines. The
+ * counters are updated atomically, so contexts may be used from
+ * several threads at once. Every update of a context's counters
+ * also updates a set of global counters, which sum the statistics
+ * of all contexts.
+ *
+ * The times are in nanoseconds, summed over all threads.
+ *
+ * @{
+ */
+
+/** Capacity of the per compression method arrays in @ref exr_stats_t.
+ *
+ * The arrays are indexed by @ref exr_compression_t, and have room for
+ * compression methods that may be added later, so that the layout of
+ * the struct does not change when one is.
+ */
+#define EXR_STATS_COMPRESSION_SLOTS 32
+
+/** Counters of a context, or of all contexts. */
+typedef struct
+{
+    size_t size; /**< Size of the struct, for future expansion. */
+
+    uint64_t bytes_read;    /**< Bytes read by the read function. */
+    uint64_t reads;         /**< Number of calls to the read function. */
+    uint64_t bytes_written; /**< Bytes written by the write function. */
+    uint64_t writes;        /**< Number of calls to the write function. */
+
+    /** Chunks decoded by exr_decoding_run, by compression method. */
+    uint64_t chunks_decoded[EXR_STATS_COMPRESSION_SLOTS];
+    /** Chunks encoded by exr_encoding_run, by compression method. */
+    uint64_t chunks_encoded[EXR_STATS_COMPRESSION_SLOTS];
+
+    uint64_t bytes_decompressed; /**< Unpacked size of the decoded chunks. */
+    uint64_t bytes_packed;       /**< Packed size of the encoded chunks. */
+
+    uint64_t read_ns;       /**< Time spent in the read function. */
+    uint64_t decompress_ns; /**< Time spent decompressing chunks. */
+    uint64_t unpack_ns;     /**< Time spent unpacking decoded chunks. */
+    uint64_t pack_ns;       /**< Time spent packing chunks to encode. */
+    uint64_t compress_ns;   /**< Time spent compressing chunks. */
+    uint64_t write_ns;      /**< Time spent in the write function. */
+} exr_stats_t;
+
+/** Retrieve the counters of a context.
+ *
+ * The counters are all zero if the context was created without
+ * @ref EXR_CONTEXT_FLAG_COLLECT_STATS.
+ */
+EXR_EXPORT exr_result_t
+exr_get_stats (exr_const_context_t ctxt, exr_stats_t* stats);
+
+/** Retrieve the sums of the counters of all contexts. */
+EXR_EXPORT exr_result_t exr_get_global_stats (exr_stats_t* stats);
+
+/** Reset the global counters to zero. */
+EXR_EXPORT void exr_reset_global_stats (void);
+
+/** @} */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* OPENEXR_STATS_H */
@@ -626,6 +626,16 @@ exr_copy_unset_attributes (
             #name));                                                           \
     attr = part->name
 
+/* attributes that describe the layout of the chunks can not change
+ * when the header is updated in place */
+#define REQ_ATTR_CHECK_LAYOUT(name)                                            \
+    if (pctxt->mode == EXR_CONTEXT_UPDATE_HEADER)                              \
+        return EXR_UNLOCK_AND_RETURN_PCTXT (pctxt->print_error (               \
+            pctxt,                                                             \
+            EXR_ERR_NOT_OPEN_WRITE,                                            \
+            "Unable to change '%s' when updating the header in place",         \
+            #name))
+
 /**************************************/
 
 exr_result_t
@@ -648,6 +658,7 @@ exr_add_channel (
     int32_t                    ysamp)
 {
     REQ_ATTR_FIND_CREATE (channels, EXR_ATTR_CHLIST);
+    REQ_ATTR_CHECK_LAYOUT (channels);
     if (rv == EXR_ERR_SUCCESS)
     {
         rv = exr_attr_chlist_add (
@@ -669,6 +680,7 @@ exr_set_channels (
             "No channels provided for channel list");
 
     REQ_ATTR_FIND_CREATE (channels, EXR_ATTR_CHLIST);
+    REQ_ATTR_CHECK_LAYOUT (channels);
     if (rv == EXR_ERR_SUCCESS)
     {
         exr_attr_chlist_t clist;
@@ -698,6 +710,7 @@ exr_set_compression (
     exr_context_t ctxt, int part_index, exr_compression_t ctype)
 {
     REQ_ATTR_FIND_CREATE (compression, EXR_ATTR_COMPRESSION);
+    REQ_ATTR_CHECK_LAYOUT (compression);
     if (rv == EXR_ERR_SUCCESS)
     {
         attr->uc        = (uint8_t) ctype;
@@ -728,6 +741,7 @@ exr_set_data_window (
             "Missing value for data window assignment");
 
     REQ_ATTR_FIND_CREATE (dataWindow, EXR_ATTR_BOX2I);
+    REQ_ATTR_CHECK_LAYOUT (dataWindow);
 
     if (rv == EXR_ERR_SUCCESS)
     {
@@ -795,6 +809,7 @@ exr_set_lineorder (exr_context_t ctxt, int part_index, exr_lineorder_t lo)
             (int) EXR_LINEORDER_LAST_TYPE);
 
     REQ_ATTR_FIND_CREATE (lineOrder, EXR_ATTR_LINEORDER);
+    REQ_ATTR_CHECK_LAYOUT (lineOrder);
     if (rv == EXR_ERR_SUCCESS)
     {
         attr->uc        = (uint8_t) lo;
@@ -923,6 +938,7 @@ exr_set_tile_descriptor (
     if (pctxt->mode == EXR_CONTEXT_WRITING_DATA)
         return EXR_UNLOCK_AND_RETURN_PCTXT (
             pctxt->standard_error (pctxt, EXR_ERR_ALREADY_WROTE_ATTRS));
+    REQ_ATTR_CHECK_LAYOUT (tiles);
     if (part->storage_mode == EXR_STORAGE_SCANLINE ||
         part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
         return EXR_UNLOCK_AND_RETURN_PCTXT (pctxt->report_error (
@@ -1055,6 +1071,7 @@ exr_set_version (exr_context_t ctxt, int part_index, int32_t val)
     if (val <= 0 || val > 1) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
 
     REQ_ATTR_FIND_CREATE (version, EXR_ATTR_INT);
+    REQ_ATTR_CHECK_LAYOUT (version);
     if (rv == EXR_ERR_SUCCESS) { attr->i = val; }
     return EXR_UNLOCK_AND_RETURN_PCTXT (rv);
 }
@@ -1065,6 +1082,7 @@ exr_result_t
 exr_set_chunk_count (exr_context_t ctxt, int part_index, int32_t val)
 {
     REQ_ATTR_FIND_CREATE (chunkCount, EXR_ATTR_INT);
+    REQ_ATTR_CHECK_LAYOUT (chunkCount);
     if (rv == EXR_ERR_SUCCESS)
     {
         attr->i           = val;
@@ -0,0 +1,148 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#include "openexr_stats.h"
+
+#include "internal_stats.h"
+
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+
+#ifdef EXR_HAS_STD_ATOMICS
+typedef atomic_uint_least64_t exr_stat_counter_t;
+#    define stat_add(c, v)                                                     \
+        atomic_fetch_add_explicit (&(c), (v), memory_order_relaxed)
+#    define stat_load(c) atomic_load_explicit (&(c), memory_order_relaxed)
+#    define stat_store(c, v)                                                   \
+        atomic_store_explicit (&(c), (v), memory_order_relaxed)
+#elif defined(_MSC_VER)
+typedef volatile int64_t exr_stat_counter_t;
+#    define stat_add(c, v) InterlockedExchangeAdd64 (&(c), (int64_t) (v))
+#    define stat_load(c) ((uint64_t) InterlockedOr64 (&(c), 0))
+#    define stat_store(c, v) InterlockedExchange64 (&(c), (int64_t) (v))
+#else
+#    error OS unimplemented support for atomics
+#endif
+
+struct _internal_exr_stats
+{
+    exr_stat_counter_t counters[EXR_STAT_COUNT];
+};
+
+static struct _internal_exr_stats global_stats;
+
+/**************************************/
+
+size_t
+internal_exr_stats_size (void)
+{
+    return sizeof (struct _internal_exr_stats);
+}
+
+void
+internal_exr_init_stats (struct _internal_exr_stats* stats)
+{
+    for (int i = 0; i < EXR_STAT_COUNT; ++i)
+        stat_store (stats->counters[i], 0);
+}
+
+void
+internal_exr_add_stat_impl (
+    struct _internal_exr_stats* stats, int stat, uint64_t value)
+{
+    stat_add (stats->counters[stat], value);
+    stat_add (global_stats.counters[stat], value);
+}
+
+uint64_t
+internal_exr_stats_now (void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter (&count);
+    QueryPerformanceFrequency (&freq);
+    return (uint64_t) ((double) count.QuadPart * 1e9 / (double) freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/**************************************/
+
+/* the public arrays must have room for every compression method */
+typedef char exr_stats_compression_slots_check
+    [EXR_COMPRESSION_LAST_TYPE <= EXR_STATS_COMPRESSION_SLOTS ? 1 : -1];
+
+static void
+get_stats (const struct _internal_exr_stats* stats, exr_stats_t* out)
+{
+    struct _internal_exr_stats* s =
+        EXR_CONST_CAST (struct _internal_exr_stats*, stats);
+
+    memset (out, 0, sizeof (exr_stats_t));
+    out->size = sizeof (exr_stats_t);
+    if (!s) return;
+
+    out->bytes_read         = stat_load (s->counters[EXR_STAT_BYTES_READ]);
+    out->reads              = stat_load (s->counters[EXR_STAT_READS]);
+    out->bytes_written      = stat_load (s->counters[EXR_STAT_BYTES_WRITTEN]);
+    out->writes             = stat_load (s->counters[EXR_STAT_WRITES]);
+    out->bytes_decompressed =
+        stat_load (s->counters[EXR_STAT_BYTES_DECOMPRESSED]);
+    out->bytes_packed  = stat_load (s->counters[EXR_STAT_BYTES_PACKED]);
+    out->read_ns       = stat_load (s->counters[EXR_STAT_READ_NS]);
+    out->decompress_ns = stat_load (s->counters[EXR_STAT_DECOMPRESS_NS]);
+    out->unpack_ns     = stat_load (s->counters[EXR_STAT_UNPACK_NS]);
+    out->pack_ns       = stat_load (s->counters[EXR_STAT_PACK_NS]);
+    out->compress_ns   = stat_load (s->counters[EXR_STAT_COMPRESS_NS]);
+    out->write_ns      = stat_load (s->counters[EXR_STAT_WRITE_NS]);
+
+    for (int c = 0; c < EXR_COMPRESSION_LAST_TYPE; ++c)
+    {
+        out->chunks_decoded[c] =
+            stat_load (s->counters[EXR_STAT_CHUNKS_DECODED + c]);
+        out->chunks_encoded[c] =
+            stat_load (s->counters[EXR_STAT_CHUNKS_ENCODED + c]);
+    }
+}
+
+/**************************************/
+
+exr_result_t
+exr_get_stats (exr_const_context_t ctxt, exr_stats_t* stats)
+{
+    INTERN_EXR_PROMOTE_CONST_CONTEXT_OR_ERROR (ctxt);
+
+    if (!stats) return pctxt->standard_error (pctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    get_stats (pctxt->stats, stats);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+exr_result_t
+exr_get_global_stats (exr_stats_t* stats)
+{
+    if (!stats) return EXR_ERR_INVALID_ARGUMENT;
+
+    get_stats (&global_stats, stats);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+void
+exr_reset_global_stats (void)
+{
+    internal_exr_init_stats (&global_stats);
+}
@@ -606,7 +606,6 @@ internal_exr_write_header (struct _internal_exr_context* ctxt)
     exr_result_t rv;
     uint32_t     magic_and_version[2];
     uint32_t     flags;
-    uint8_t      next_byte;
 
     flags = 2;
     if (ctxt->is_multipart) flags |= EXR_MULTI_PART_FLAG;
@@ -627,6 +626,17 @@ internal_exr_write_header (struct _internal_exr_context* ctxt)
         &(ctxt->output_file_offset));
     if (rv != EXR_ERR_SUCCESS) return rv;
 
+    return internal_exr_write_part_headers (ctxt);
+}
+
+/**************************************/
+
+exr_result_t
+internal_exr_write_part_headers (struct _internal_exr_context* ctxt)
+{
+    exr_result_t rv = EXR_ERR_SUCCESS;
+    uint8_t      next_byte;
+
     for (int p = 0; rv == EXR_ERR_SUCCESS && p < ctxt->num_parts; ++p)
     {
         struct _internal_exr_part* curp = ctxt->parts[p];
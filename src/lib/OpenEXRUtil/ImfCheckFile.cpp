@@ -24,10 +24,19 @@
 #include "ImfTiledInputPart.h"
 #include "ImfTiledMisc.h"
 
+#include "ImfThreading.h"
+#include "IlmThreadPool.h"
+
 #include "openexr.h"
 
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <stdlib.h>
+#include <string>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -36,6 +45,7 @@ namespace
 {
 
 using IMATH_NAMESPACE::Box2i;
+using IMATH_NAMESPACE::V2i;
 using std::max;
 using std::vector;
 
@@ -1615,6 +1625,667 @@ runCoreChecks (
     return hadfail;
 }
 
+////////////////////////////////////////
+//
+// parallel validation of all chunks with the core library
+//
+
+//
+// the core library reports details of an error through the error handler
+// of the context, on the thread that made the failing call. The first
+// message is the most specific one; later ones only add context.
+//
+
+thread_local std::string tChunkCheckMessage;
+
+static void
+chunk_check_error_handler_cb (exr_const_context_t f, int code, const char* msg)
+{
+    if (tChunkCheckMessage.empty ()) tChunkCheckMessage = msg;
+    core_error_handler_cb (f, code, msg);
+}
+
+struct ChunkRef
+{
+    int  part;
+    int  chunk;
+    bool tiled;
+    int tileX, tileY;
+    int levelX, levelY;
+    int y;
+};
+
+//
+// bounds the bytes of chunk data in use by all tasks together
+//
+
+class MemoryBudget
+{
+public:
+    MemoryBudget (uint64_t limit) : _limit (limit), _used (0) {}
+
+    void acquire (uint64_t bytes)
+    {
+        std::unique_lock<std::mutex> lock (_mutex);
+
+        // a chunk that exceeds the budget waits until it runs alone
+        while (_used > 0 && _used + bytes > _limit)
+            _released.wait (lock);
+
+        _used += bytes;
+    }
+
+    void release (uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock (_mutex);
+        _used -= bytes;
+        _released.notify_all ();
+    }
+
+private:
+    uint64_t                _limit;
+    uint64_t                _used;
+    std::mutex              _mutex;
+    std::condition_variable _released;
+};
+
+struct ChunkChecker
+{
+    ChunkChecker (exr_context_t f, uint64_t memoryBudget)
+        : file (f), budget (memoryBudget), next (0)
+    {}
+
+    void report (const ChunkRef& ref, exr_result_t rv, const std::string& msg)
+    {
+        ChunkCheckReport r;
+        r.part      = ref.part;
+        r.chunk     = ref.chunk;
+        r.tiled     = ref.tiled;
+        r.tileX     = ref.tileX;
+        r.tileY     = ref.tileY;
+        r.levelX    = ref.levelX;
+        r.levelY    = ref.levelY;
+        r.y         = ref.y;
+        r.errorCode = rv;
+        r.message   = msg.empty () ? exr_get_default_error_message (rv) : msg;
+
+        std::lock_guard<std::mutex> lock (mutex);
+        reports.push_back (r);
+    }
+
+    exr_context_t         file;
+    std::vector<Header>   headers; // for parts the core cannot decompress
+    std::vector<ChunkRef> chunks;
+    MemoryBudget          budget;
+    std::atomic<size_t>   next;
+
+    std::mutex                    mutex;
+    std::vector<ChunkCheckReport> reports;
+};
+
+//
+// the sample count table of a deep chunk holds, for every scan line of the
+// chunk, the cumulative number of samples up to each pixel, and the total
+// number of samples determines the size of the sample data.
+//
+
+exr_result_t
+checkSampleCounts (const exr_decode_pipeline_t& decoder, std::string& msg)
+{
+    const int32_t* counts = decoder.sample_count_table;
+    int32_t        w      = decoder.chunk.width;
+    int32_t        h      = decoder.chunk.height;
+    uint64_t       total  = 0;
+    uint64_t       bytesPerSample = 0;
+
+    for (int c = 0; c < decoder.channel_count; ++c)
+        bytesPerSample += decoder.channels[c].bytes_per_element;
+
+    for (int32_t y = 0; y < h; ++y)
+    {
+        int32_t prev = 0;
+
+        for (int32_t x = 0; x < w; ++x)
+        {
+            int32_t n = counts[(int64_t) y * w + x];
+
+            if (n < prev)
+            {
+                msg = "Sample count table decreases at pixel (" +
+                      std::to_string (x) + ", " + std::to_string (y) +
+                      ") of the chunk";
+                return EXR_ERR_INVALID_SAMPLE_DATA;
+            }
+            prev = n;
+        }
+
+        total += (uint64_t) prev;
+    }
+
+    if (total * bytesPerSample != decoder.chunk.unpacked_size)
+    {
+        msg = "Sample count table holds " + std::to_string (total) +
+              " samples of " + std::to_string (bytesPerSample) +
+              " bytes, but the chunk holds " +
+              std::to_string (decoder.chunk.unpacked_size) +
+              " bytes of sample data";
+        return EXR_ERR_INVALID_SAMPLE_DATA;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+//
+// the core library cannot decompress DWAA and DWAB data yet; such chunks
+// are decompressed with the compressors of the C++ library instead, which
+// produce the same uncompressed data
+//
+
+bool
+coreCanDecompress (exr_compression_t c)
+{
+    return c != EXR_COMPRESSION_DWAA && c != EXR_COMPRESSION_DWAB;
+}
+
+exr_result_t
+decompressChunk (
+    ChunkChecker&           checker,
+    const ChunkRef&         ref,
+    const exr_chunk_info_t& cinfo,
+    std::string&            msg)
+{
+    exr_context_t f = checker.file;
+    exr_result_t  rv;
+
+    std::vector<uint8_t> packed (cinfo.packed_size);
+
+    rv = exr_read_chunk (f, ref.part, &cinfo, packed.data ());
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    // chunks that do not get smaller are stored uncompressed
+    if (cinfo.packed_size == cinfo.unpacked_size) return EXR_ERR_SUCCESS;
+
+    if (cinfo.packed_size > cinfo.unpacked_size ||
+        cinfo.unpacked_size > uint64_t (INT_MAX))
+    {
+        msg = "Invalid packed size " + std::to_string (cinfo.packed_size) +
+              " vs unpacked size " + std::to_string (cinfo.unpacked_size);
+        return EXR_ERR_CORRUPT_CHUNK;
+    }
+
+    const Header&      hdr = checker.headers[ref.part];
+    const ChannelList& channels = hdr.channels ();
+    const Box2i&       dw       = hdr.dataWindow ();
+    size_t             pixelSize = 0;
+
+    for (ChannelList::ConstIterator c = channels.begin (); c != channels.end ();
+         ++c)
+        pixelSize += (c.channel ().type == HALF) ? 2 : 4;
+
+    try
+    {
+        const char* outPtr = NULL;
+        int         size;
+
+        if (ref.tiled)
+        {
+            const TileDescription& td = hdr.tileDescription ();
+
+            std::unique_ptr<Compressor> compressor (newTileCompressor (
+                hdr.compression (), td.xSize * pixelSize, td.ySize, hdr));
+
+            V2i   min (dw.min.x + ref.tileX * int (td.xSize),
+                     dw.min.y + ref.tileY * int (td.ySize));
+            Box2i range (min, min + V2i (cinfo.width - 1, cinfo.height - 1));
+
+            size = compressor->uncompressTile (
+                (const char*) packed.data (),
+                int (cinfo.packed_size),
+                range,
+                outPtr);
+        }
+        else
+        {
+            std::unique_ptr<Compressor> compressor (newCompressor (
+                hdr.compression (),
+                size_t (dw.max.x - dw.min.x + 1) * pixelSize,
+                hdr));
+
+            size = compressor->uncompress (
+                (const char*) packed.data (),
+                int (cinfo.packed_size),
+                cinfo.start_y,
+                outPtr);
+        }
+
+        if (uint64_t (size) != cinfo.unpacked_size)
+        {
+            msg = "Chunk decompresses to " + std::to_string (size) +
+                  " bytes instead of " + std::to_string (cinfo.unpacked_size);
+            return EXR_ERR_CORRUPT_CHUNK;
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        throw;
+    }
+    catch (const std::exception& e)
+    {
+        msg = e.what ();
+        return EXR_ERR_CORRUPT_CHUNK;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+exr_result_t
+checkChunk (
+    ChunkChecker& checker, const ChunkRef& ref, std::string& msg)
+{
+    exr_context_t    f = checker.file;
+    exr_storage_t    store;
+    exr_chunk_info_t cinfo;
+    exr_result_t     rv;
+
+    rv = exr_get_storage (f, ref.part, &store);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    bool deep = (store == EXR_STORAGE_DEEP_SCANLINE ||
+                 store == EXR_STORAGE_DEEP_TILED);
+
+    if (store == EXR_STORAGE_TILED || store == EXR_STORAGE_DEEP_TILED)
+        rv = exr_read_tile_chunk_info (
+            f, ref.part, ref.tileX, ref.tileY, ref.levelX, ref.levelY, &cinfo);
+    else
+        rv = exr_read_scanline_chunk_info (f, ref.part, ref.y, &cinfo);
+
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    //
+    // the decoder holds the packed and the unpacked data, and the
+    // unpacked pixels are copied to a buffer of the same size
+    //
+
+    uint64_t bytes = cinfo.packed_size + 2 * cinfo.unpacked_size;
+    if (deep)
+        bytes += cinfo.sample_count_table_size +
+                 (uint64_t) cinfo.width * (uint64_t) cinfo.height * 4;
+
+    exr_compression_t compression;
+    rv = exr_get_compression (f, ref.part, &compression);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    checker.budget.acquire (bytes);
+
+    if (!coreCanDecompress (compression))
+    {
+        try
+        {
+            rv = decompressChunk (checker, ref, cinfo, msg);
+        }
+        catch (...)
+        {
+            checker.budget.release (bytes);
+            throw;
+        }
+
+        checker.budget.release (bytes);
+        return rv;
+    }
+
+    std::vector<uint8_t>  pixels;
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+
+    rv = exr_decoding_initialize (f, ref.part, &cinfo, &decoder);
+
+    if (rv == EXR_ERR_SUCCESS && !deep)
+    {
+        uint64_t size = 0;
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            const exr_coding_channel_info_t& chan = decoder.channels[c];
+            size += (uint64_t) chan.width * (uint64_t) chan.height *
+                    (uint64_t) chan.bytes_per_element;
+        }
+
+        pixels.resize (size);
+
+        uint8_t* dptr = pixels.data ();
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& chan = decoder.channels[c];
+            if (chan.height == 0) continue;
+
+            chan.decode_to_ptr     = dptr;
+            chan.user_pixel_stride = chan.user_bytes_per_element;
+            chan.user_line_stride  = chan.user_pixel_stride * chan.width;
+            dptr += (uint64_t) chan.width * (uint64_t) chan.height *
+                    (uint64_t) chan.bytes_per_element;
+        }
+    }
+
+    //
+    // a chunk of a part with only subsampled channels may not contain
+    // any pixels, in which case there is nothing to decode
+    //
+
+    bool empty = !deep && pixels.empty ();
+
+    if (rv == EXR_ERR_SUCCESS && empty && cinfo.packed_size != 0)
+    {
+        msg = "Chunk contains no pixels, but holds " +
+              std::to_string (cinfo.packed_size) + " bytes of data";
+        rv  = EXR_ERR_CORRUPT_CHUNK;
+    }
+
+    if (rv == EXR_ERR_SUCCESS && !empty)
+    {
+        rv = exr_decoding_choose_default_routines (f, ref.part, &decoder);
+
+        //
+        // deep sample data are only decompressed, their layout follows
+        // from the sample count table
+        //
+
+        if (deep) decoder.unpack_and_convert_fn = NULL;
+
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_decoding_run (f, ref.part, &decoder);
+
+        if (rv == EXR_ERR_SUCCESS && deep)
+            rv = checkSampleCounts (decoder, msg);
+    }
+
+    exr_decoding_destroy (f, &decoder);
+    pixels.clear ();
+    pixels.shrink_to_fit ();
+
+    checker.budget.release (bytes);
+
+    return rv;
+}
+
+class ChunkCheckTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    ChunkCheckTask (ILMTHREAD_NAMESPACE::TaskGroup* group, ChunkChecker& checker)
+        : ILMTHREAD_NAMESPACE::Task (group), _checker (checker)
+    {}
+
+    void execute () override
+    {
+        for (size_t i = _checker.next++; i < _checker.chunks.size ();
+             i       = _checker.next++)
+        {
+            const ChunkRef& ref = _checker.chunks[i];
+            std::string     msg;
+
+            tChunkCheckMessage.clear ();
+
+            exr_result_t rv;
+
+            try
+            {
+                rv = checkChunk (_checker, ref, msg);
+            }
+            catch (const std::bad_alloc&)
+            {
+                rv  = EXR_ERR_OUT_OF_MEMORY;
+                msg = "Unable to allocate memory for chunk data";
+            }
+
+            if (rv != EXR_ERR_SUCCESS)
+                _checker.report (
+                    ref, rv, msg.empty () ? tChunkCheckMessage : msg);
+        }
+    }
+
+private:
+    ChunkChecker& _checker;
+};
+
+//
+// list the chunks of a part in the order of its chunk offset table
+//
+
+exr_result_t
+listChunks (ChunkChecker& checker, int part)
+{
+    exr_context_t f = checker.file;
+    exr_result_t  rv;
+    exr_storage_t store;
+    int32_t       count;
+
+    rv = exr_get_storage (f, part, &store);
+    if (rv == EXR_ERR_SUCCESS) rv = exr_get_chunk_count (f, part, &count);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    ChunkRef ref = {part, 0, false, 0, 0, 0, 0, 0};
+
+    if (store == EXR_STORAGE_SCANLINE || store == EXR_STORAGE_DEEP_SCANLINE)
+    {
+        exr_attr_box2i_t datawin;
+        int32_t          lines_per_chunk;
+
+        rv = exr_get_data_window (f, part, &datawin);
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_get_scanlines_per_chunk (f, part, &lines_per_chunk);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        for (int64_t y = datawin.min.y; y <= datawin.max.y;
+             y += lines_per_chunk, ++ref.chunk)
+        {
+            ref.y = (int) y;
+            checker.chunks.push_back (ref);
+        }
+    }
+    else
+    {
+        uint32_t              txsz, tysz;
+        exr_tile_level_mode_t levelmode;
+        exr_tile_round_mode_t roundingmode;
+        int32_t               levelsx, levelsy;
+
+        rv = exr_get_tile_descriptor (
+            f, part, &txsz, &tysz, &levelmode, &roundingmode);
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_get_tile_levels (f, part, &levelsx, &levelsy);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        ref.tiled = true;
+
+        for (int32_t ly = 0; ly < levelsy; ++ly)
+        {
+            for (int32_t lx = 0; lx < levelsx; ++lx)
+            {
+                if (levelmode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
+
+                int32_t levw, levh;
+                rv = exr_get_level_sizes (f, part, lx, ly, &levw, &levh);
+                if (rv != EXR_ERR_SUCCESS) return rv;
+
+                ref.levelX = lx;
+                ref.levelY = ly;
+
+                for (int64_t y = 0; y < levh; y += tysz)
+                {
+                    for (int64_t x = 0; x < levw; x += txsz, ++ref.chunk)
+                    {
+                        ref.tileX = (int) (x / txsz);
+                        ref.tileY = (int) (y / tysz);
+                        checker.chunks.push_back (ref);
+                    }
+                }
+            }
+        }
+    }
+
+    if (ref.chunk != count)
+    {
+        tChunkCheckMessage = "Chunk table holds " + std::to_string (count) +
+                             " chunks, but the part requires " +
+                             std::to_string (ref.chunk);
+        return EXR_ERR_BAD_CHUNK_LEADER;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+template <class T>
+bool
+checkCoreChunks (
+    exr_context_t                  f,
+    T&                             source,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget)
+{
+    ChunkChecker checker (f, memoryBudget ? memoryBudget : (1 << 28));
+    int          numparts;
+    exr_result_t rv;
+    bool         needHeaders = false;
+    std::vector<bool> coreParts;
+
+    tChunkCheckMessage.clear ();
+    rv = exr_get_count (f, &numparts);
+
+    if (rv != EXR_ERR_SUCCESS) numparts = 0;
+
+    for (int p = 0; p < numparts; ++p)
+    {
+        exr_compression_t compression;
+
+        tChunkCheckMessage.clear ();
+        rv = exr_get_compression (f, p, &compression);
+        if (rv == EXR_ERR_SUCCESS)
+        {
+            coreParts.push_back (coreCanDecompress (compression));
+            if (!coreParts.back ()) needHeaders = true;
+            rv = listChunks (checker, p);
+        }
+
+        else
+            coreParts.push_back (true);
+
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            ChunkRef ref = {p, -1, false, 0, 0, 0, 0, 0};
+            checker.report (ref, rv, tChunkCheckMessage);
+        }
+    }
+
+    if (needHeaders)
+    {
+        try
+        {
+            MultiPartInputFile in (source);
+
+            for (int p = 0; p < in.parts (); ++p)
+                checker.headers.push_back (in.header (p));
+        }
+        catch (const std::exception& e)
+        {
+            ChunkRef ref = {-1, -1, false, 0, 0, 0, 0, 0};
+            checker.report (ref, EXR_ERR_FILE_BAD_HEADER, e.what ());
+        }
+
+        //
+        // without headers, only the parts the core can decompress are
+        // checked
+        //
+
+        if (checker.headers.size () != size_t (numparts))
+        {
+            checker.chunks.erase (
+                std::remove_if (
+                    checker.chunks.begin (),
+                    checker.chunks.end (),
+                    [&] (const ChunkRef& r) { return !coreParts[r.part]; }),
+                checker.chunks.end ());
+        }
+    }
+
+    if (rv != EXR_ERR_SUCCESS && numparts == 0)
+    {
+        ChunkRef ref = {-1, -1, false, 0, 0, 0, 0, 0};
+        checker.report (ref, rv, tChunkCheckMessage);
+    }
+
+    {
+        //
+        // one task per thread; the tasks take chunks from the list until
+        // none are left
+        //
+
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+        int numTasks = std::max (1, globalThreadCount ());
+
+        for (int i = 0; i < numTasks; ++i)
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new ChunkCheckTask (&group, checker));
+    }
+
+    std::sort (
+        checker.reports.begin (),
+        checker.reports.end (),
+        [] (const ChunkCheckReport& a, const ChunkCheckReport& b) {
+            return a.part < b.part || (a.part == b.part && a.chunk < b.chunk);
+        });
+
+    reports.insert (
+        reports.end (), checker.reports.begin (), checker.reports.end ());
+
+    return !checker.reports.empty ();
+}
+
+bool
+runCoreChunkChecks (
+    const char*                    filename,
+    const memdata*                 md,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget)
+{
+    exr_result_t              rv;
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    cinit.error_handler_fn = &chunk_check_error_handler_cb;
+
+    if (md)
+    {
+        cinit.user_data = const_cast<memdata*> (md);
+        cinit.read_fn   = &memstream_read;
+        cinit.size_fn   = &memstream_size;
+    }
+
+    tChunkCheckMessage.clear ();
+    rv = exr_start_read (&f, filename, &cinit);
+
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        ChunkCheckReport r = {
+            -1, -1, false, 0, 0, 0, 0, 0, rv, tChunkCheckMessage};
+        if (r.message.empty ()) r.message = exr_get_default_error_message (rv);
+        reports.push_back (r);
+        return true;
+    }
+
+    bool hadfail;
+
+    if (md)
+    {
+        PtrIStream stream (md->data, md->bytes);
+        hadfail = checkCoreChunks (f, stream, reports, memoryBudget);
+    }
+    else
+    {
+        hadfail = checkCoreChunks (f, filename, reports, memoryBudget);
+    }
+
+    exr_finish (&f);
+
+    return hadfail;
+}
+
 } // namespace
 
 bool
@@ -1659,4 +2330,27 @@ checkOpenEXRFile (
 
 }
 
+bool
+checkOpenEXRFileChunks (
+    const char*                    fileName,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget)
+{
+    return runCoreChunkChecks (fileName, NULL, reports, memoryBudget);
+}
+
+bool
+checkOpenEXRFileChunks (
+    const char*                    data,
+    size_t                         numBytes,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget)
+{
+    memdata md;
+    md.data  = data;
+    md.bytes = numBytes;
+
+    return runCoreChunkChecks ("<memstream>", &md, reports, memoryBudget);
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
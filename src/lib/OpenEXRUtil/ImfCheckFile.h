@@ -8,6 +8,8 @@
 #include "ImfUtilExport.h"
 
 #include <cstddef>
+#include <string>
+#include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
@@ -45,6 +47,59 @@ IMFUTIL_EXPORT bool checkOpenEXRFile (
     bool        reduceTime      = false,
     bool        runCoreCheck = false);
 
+//
+// a problem found by checkOpenEXRFileChunks (). Chunks are identified by
+// their index in the chunk offset table of their part and, if tiled is
+// true, by their tile coordinates and level, or otherwise by their first
+// scan line y. Problems that concern a whole part or file
+// have chunk == -1.
+//
+
+struct IMFUTIL_EXPORT_TYPE ChunkCheckReport
+{
+    int         part;
+    int         chunk;
+    bool        tiled;
+    int         tileX, tileY;
+    int         levelX, levelY;
+    int         y;
+    int         errorCode; // an exr_result_t, see openexr_errors.h
+    std::string message;
+};
+
+//
+// validate every chunk of the given file with the OpenEXRCore (C) API:
+// the chunk table, the chunk headers, decompression and unpacking of all
+// pixel data and, for deep parts, the consistency of the sample count
+// tables with the sample data. Unlike checkOpenEXRFile (), no chunk is
+// skipped; instead, the chunks are decoded in parallel by the tasks of the
+// global thread pool (see ImfThreading.h), so the time spent scales with
+// the number of threads.
+//
+// memoryBudget bounds the memory used for chunk data by all threads
+// together, in bytes; 0 selects a default of 256 MB. A chunk larger than
+// the budget is still decoded, while no other chunk is.
+//
+// returns true if any problem was found; the problems are appended to
+// reports, sorted by part and chunk.
+//
+
+IMFUTIL_EXPORT bool checkOpenEXRFileChunks (
+    const char*                    fileName,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget = 0);
+
+//
+// overloaded version of checkOpenEXRFileChunks that takes a pointer to
+// in-memory data
+//
+
+IMFUTIL_EXPORT bool checkOpenEXRFileChunks (
+    const char*                    data,
+    size_t                         numBytes,
+    std::vector<ChunkCheckReport>& reports,
+    size_t                         memoryBudget = 0);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
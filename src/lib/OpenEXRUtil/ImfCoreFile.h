@@ -0,0 +1,116 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_CORE_FILE_H
+#define INCLUDED_IMF_CORE_FILE_H
+
+//----------------------------------------------------------------------------
+//
+//      class CoreFile -- an internal class, not exported
+//
+//      An OpenEXRCore context.  Core reports errors through a callback;
+//      the first message is kept so that it can be thrown as an
+//      exception when the failing call returns.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+#include <Iex.h>
+#include <openexr.h>
+
+#include <mutex>
+#include <string>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class CoreFile
+{
+public:
+    //
+    // Errors are reported as "Cannot <action> "<fileName>". <message>".
+    //
+
+    CoreFile (const char fileName[], const char action[])
+        : _ctxt (0), _fileName (fileName), _action (action)
+    {}
+
+    ~CoreFile ()
+    {
+        if (_ctxt) exr_finish (&_ctxt);
+    }
+
+    CoreFile (const CoreFile&)            = delete;
+    CoreFile& operator= (const CoreFile&) = delete;
+
+    void startRead ()
+    {
+        exr_context_initializer_t init = initializer ();
+        check (exr_start_read (&_ctxt, _fileName, &init));
+    }
+
+    void startWrite ()
+    {
+        exr_context_initializer_t init = initializer ();
+        check (exr_start_write (
+            &_ctxt, _fileName, EXR_INTERMEDIATE_TEMP_FILE, &init));
+    }
+
+    void startUpdate ()
+    {
+        exr_context_initializer_t init = initializer ();
+        check (exr_start_inplace_header_update (&_ctxt, _fileName, &init));
+    }
+
+    void finish () { check (exr_finish (&_ctxt)); }
+
+    void check (exr_result_t rv) const
+    {
+        if (rv == EXR_ERR_SUCCESS) return;
+
+        std::lock_guard<std::mutex> lock (_mutex);
+
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Cannot " << _action << " \"" << _fileName << "\". "
+                      << (_message.empty ()
+                              ? exr_get_error_code_as_string (rv)
+                              : _message.c_str ()));
+    }
+
+    exr_context_t ctxt () const { return _ctxt; }
+
+private:
+    exr_context_initializer_t initializer ()
+    {
+        exr_context_initializer_t init = EXR_DEFAULT_CONTEXT_INITIALIZER;
+        init.error_handler_fn          = &errorHandler;
+        init.user_data                 = this;
+        return init;
+    }
+
+    static void
+    errorHandler (exr_const_context_t ctxt, int, const char* msg)
+    {
+        void* data = 0;
+
+        if (exr_get_user_data (ctxt, &data) != EXR_ERR_SUCCESS || !data)
+            return;
+
+        CoreFile*                   file = static_cast<CoreFile*> (data);
+        std::lock_guard<std::mutex> lock (file->_mutex);
+
+        if (file->_message.empty ()) file->_message = msg;
+    }
+
+    exr_context_t      _ctxt;
+    const char*        _fileName;
+    const char*        _action;
+    mutable std::mutex _mutex;
+    std::string        _message;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,587 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      Generation of the lower-resolution levels of flat images.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfFlatImageLevels.h"
+#include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImathFun.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// Number of output pixels that a ReductionTask should compute
+//
+
+const int pixelsPerTask = 16384;
+
+const char*
+extrapolationName (Extrapolation ext)
+{
+    switch (ext)
+    {
+        case EXTRAPOLATE_BLACK: return "black";
+
+        case EXTRAPOLATE_CLAMP: return "clamp";
+
+        case EXTRAPOLATE_PERIODIC: return "periodic";
+
+        case EXTRAPOLATE_MIRROR: return "mirror";
+    }
+
+    throw ArgExc ("Unknown extrapolation mode.");
+}
+
+int
+mirror (int x, int w)
+{
+    int d = divp (x, w);
+    int m = modp (x, w);
+    return (d & 1) ? w - 1 - m : m;
+}
+
+int
+extrapolate (int x, int w, Extrapolation ext, int black)
+{
+    //
+    // Map a pixel index, x, that may be outside the range [0, w)
+    // to the index of the pixel whose value is used at x.  With
+    // EXTRAPOLATE_BLACK, indices outside the range are mapped to
+    // black, the index of a pixel whose value is zero.
+    //
+
+    switch (ext)
+    {
+        case EXTRAPOLATE_BLACK: return (x >= 0 && x < w) ? x : black;
+
+        case EXTRAPOLATE_CLAMP: return IMATH_NAMESPACE::clamp (x, 0, w - 1);
+
+        case EXTRAPOLATE_PERIODIC: return modp (x, w);
+
+        case EXTRAPOLATE_MIRROR: return mirror (x, w);
+    }
+
+    return x;
+}
+
+template <class T>
+void
+filterRowX (const T in[], T out[], int w, const LevelFilterTaps taps[])
+{
+    for (int x = 0; x < w; ++x)
+    {
+        const LevelFilterTaps& f = taps[x];
+
+        double v0 = f.weight[0][0] * double (in[f.index[0][0]]) +
+                    f.weight[0][1] * double (in[f.index[0][1]]);
+
+        double v1 = f.weight[1][0] * double (in[f.index[1][0]]) +
+                    f.weight[1][1] * double (in[f.index[1][1]]);
+
+        double v2 = f.weight[2][0] * double (in[f.index[2][0]]) +
+                    f.weight[2][1] * double (in[f.index[2][1]]);
+
+        double v3 = f.weight[3][0] * double (in[f.index[3][0]]) +
+                    f.weight[3][1] * double (in[f.index[3][1]]);
+
+        out[x] = T (0.125 * v0 + 0.375 * v1 + 0.375 * v2 + 0.125 * v3);
+    }
+}
+
+template <class T>
+void
+filterRowY (const T* const in[4][2], T out[], int w, const LevelFilterTaps& f)
+{
+    //
+    // The weights are the same for all pixels in the row, and the
+    // source rows are accessed sequentially, which allows the
+    // compiler to vectorize this loop.
+    //
+
+    const T* in00 = in[0][0];
+    const T* in01 = in[0][1];
+    const T* in10 = in[1][0];
+    const T* in11 = in[1][1];
+    const T* in20 = in[2][0];
+    const T* in21 = in[2][1];
+    const T* in30 = in[3][0];
+    const T* in31 = in[3][1];
+
+    const double s0 = f.weight[0][0];
+    const double t0 = f.weight[0][1];
+    const double s1 = f.weight[1][0];
+    const double t1 = f.weight[1][1];
+    const double s2 = f.weight[2][0];
+    const double t2 = f.weight[2][1];
+    const double s3 = f.weight[3][0];
+    const double t3 = f.weight[3][1];
+
+    for (int x = 0; x < w; ++x)
+    {
+        double v0 = s0 * double (in00[x]) + t0 * double (in01[x]);
+        double v1 = s1 * double (in10[x]) + t1 * double (in11[x]);
+        double v2 = s2 * double (in20[x]) + t2 * double (in21[x]);
+        double v3 = s3 * double (in30[x]) + t3 * double (in31[x]);
+
+        out[x] = T (0.125 * v0 + 0.375 * v1 + 0.375 * v2 + 0.125 * v3);
+    }
+}
+
+//
+// A Reduction shrinks the channels of an image by a factor
+// of two, either horizontally or vertically.
+//
+
+class Reduction
+{
+public:
+    Reduction (
+        const FlatImageLevel& in,
+        FlatImageLevel&       out,
+        bool                  horizontal,
+        Extrapolation         ext,
+        bool                  odd,
+        const set<string>&    doNotFilter);
+
+    void execute ();
+    void reduceRows (int y1, int y2) const;
+
+private:
+    struct ChannelData
+    {
+        PixelType   type;
+        const char* in;
+        char*       out;
+        bool        filter;
+    };
+
+    template <class T>
+    void reduceRows (const ChannelData& channel, int y1, int y2) const;
+
+    bool                    _horizontal;
+    int                     _inWidth;
+    int                     _outWidth;
+    int                     _outHeight;
+    int                     _offset;
+    vector<LevelFilterTaps> _taps;
+    vector<ChannelData>     _channels;
+    vector<char>            _zeroRow;
+};
+
+class ReductionTask : public Task
+{
+public:
+    ReductionTask (TaskGroup* group, const Reduction& reduction, int y1, int y2)
+        : Task (group), _reduction (reduction), _y1 (y1), _y2 (y2)
+    {}
+
+    void execute () override { _reduction.reduceRows (_y1, _y2); }
+
+private:
+    const Reduction& _reduction;
+    int              _y1;
+    int              _y2;
+};
+
+template <class T>
+char*
+firstPixel (FlatImageChannel& channel)
+{
+    const Box2i& dw = channel.level ().dataWindow ();
+
+    TypedFlatImageChannel<T>& tc =
+        dynamic_cast<TypedFlatImageChannel<T>&> (channel);
+
+    return reinterpret_cast<char*> (&tc (dw.min.x, dw.min.y));
+}
+
+char*
+firstPixel (FlatImageChannel& channel)
+{
+    switch (channel.pixelType ())
+    {
+        case HALF: return firstPixel<half> (channel);
+
+        case FLOAT: return firstPixel<float> (channel);
+
+        case UINT: return firstPixel<unsigned int> (channel);
+
+        default: throw ArgExc ("Unknown pixel type.");
+    }
+}
+
+Reduction::Reduction (
+    const FlatImageLevel& in,
+    FlatImageLevel&       out,
+    bool                  horizontal,
+    Extrapolation         ext,
+    bool                  odd,
+    const set<string>&    doNotFilter)
+    : _horizontal (horizontal)
+    , _inWidth (in.dataWindow ().max.x - in.dataWindow ().min.x + 1)
+    , _outWidth (out.dataWindow ().max.x - out.dataWindow ().min.x + 1)
+    , _outHeight (out.dataWindow ().max.y - out.dataWindow ().min.y + 1)
+{
+    int inHeight = in.dataWindow ().max.y - in.dataWindow ().min.y + 1;
+
+    //
+    // For output pixels 0 and n1 - 1, the low-pass filter is centered
+    // on source pixels 0.5 and n0 - 1.5 respectively.  Without low-pass
+    // filtering, in order to keep the image from sliding if it is
+    // resampled repeatedly, we skip the last pixel of every row or
+    // column on even passes, and the first pixel on odd passes.
+    //
+
+    int    n0 = horizontal ? _inWidth : inHeight;
+    int    n1 = horizontal ? _outWidth : _outHeight;
+    double f  = (n1 > 1) ? double (n0 - 2) / (n1 - 1) : 1;
+
+    //
+    // With EXTRAPOLATE_BLACK, pixels outside the source image refer
+    // to an extra pixel with value zero at the end of each row or,
+    // vertically, to _zeroRow.
+    //
+
+    _taps.resize (n1);
+
+    for (int i = 0; i < n1; ++i)
+        computeLevelFilterTaps (i * f, n0, ext, horizontal ? n0 : -1, _taps[i]);
+
+    _offset = odd ? ((n0 - 1) - 2 * (n1 - 1)) : 0;
+
+    if (!horizontal) _zeroRow.resize (_inWidth * sizeof (float));
+
+    for (FlatImageLevel::ConstIterator i = in.begin (); i != in.end (); ++i)
+    {
+        FlatImageChannel& inChannel =
+            const_cast<FlatImageChannel&> (i.channel ());
+
+        ChannelData channel;
+        channel.type   = inChannel.pixelType ();
+        channel.in     = firstPixel (inChannel);
+        channel.out    = firstPixel (out.channel (i.name ()));
+        channel.filter = (doNotFilter.find (i.name ()) == doNotFilter.end ());
+
+        _channels.push_back (channel);
+    }
+}
+
+void
+Reduction::execute ()
+{
+    int rowsPerTask = max (1, pixelsPerTask / _outWidth);
+
+    TaskGroup taskGroup;
+
+    for (int y = 0; y < _outHeight; y += rowsPerTask)
+    {
+        ThreadPool::addGlobalTask (new ReductionTask (
+            &taskGroup, *this, y, min (y + rowsPerTask, _outHeight)));
+    }
+}
+
+void
+Reduction::reduceRows (int y1, int y2) const
+{
+    for (size_t c = 0; c < _channels.size (); ++c)
+    {
+        switch (_channels[c].type)
+        {
+            case HALF: reduceRows<half> (_channels[c], y1, y2); break;
+
+            case FLOAT: reduceRows<float> (_channels[c], y1, y2); break;
+
+            case UINT: reduceRows<unsigned int> (_channels[c], y1, y2); break;
+
+            default: break;
+        }
+    }
+}
+
+template <class T>
+void
+Reduction::reduceRows (const ChannelData& channel, int y1, int y2) const
+{
+    const T* in  = reinterpret_cast<const T*> (channel.in);
+    T*       out = reinterpret_cast<T*> (channel.out);
+
+    if (_horizontal)
+    {
+        vector<T> row (_inWidth + 1);
+        row[_inWidth] = T (0);
+
+        for (int y = y1; y < y2; ++y)
+        {
+            const T* inRow  = in + size_t (y) * _inWidth;
+            T*       outRow = out + size_t (y) * _outWidth;
+
+            if (channel.filter)
+            {
+                memcpy (&row[0], inRow, _inWidth * sizeof (T));
+                filterRowX (&row[0], outRow, _outWidth, &_taps[0]);
+            }
+            else
+            {
+                for (int x = 0; x < _outWidth; ++x)
+                    outRow[x] = inRow[2 * x + _offset];
+            }
+        }
+    }
+    else
+    {
+        for (int y = y1; y < y2; ++y)
+        {
+            T* outRow = out + size_t (y) * _outWidth;
+
+            if (channel.filter)
+            {
+                const LevelFilterTaps& f = _taps[y];
+                const T*               inRows[4][2];
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        inRows[i][j] =
+                            (f.index[i][j] < 0)
+                                ? reinterpret_cast<const T*> (&_zeroRow[0])
+                                : in + size_t (f.index[i][j]) * _inWidth;
+                    }
+                }
+
+                filterRowY (inRows, outRow, _outWidth, f);
+            }
+            else
+            {
+                memcpy (
+                    outRow,
+                    in + size_t (2 * y + _offset) * _inWidth,
+                    _outWidth * sizeof (T));
+            }
+        }
+    }
+}
+
+void
+reduce (
+    const FlatImageLevel& in,
+    FlatImageLevel&       out,
+    bool                  horizontal,
+    Extrapolation         ext,
+    bool                  odd,
+    const set<string>&    doNotFilter)
+{
+    Reduction reduction (in, out, horizontal, ext, odd, doNotFilter);
+    reduction.execute ();
+}
+
+} // namespace
+
+void
+generateFlatImageLevels (
+    FlatImage&         img,
+    Extrapolation      extX,
+    Extrapolation      extY,
+    const set<string>& doNotFilter)
+{
+    const FlatImageLevel& level0 = img.level (0, 0);
+
+    if (img.levelMode () == ONE_LEVEL) return;
+
+    for (FlatImageLevel::ConstIterator i = level0.begin (); i != level0.end ();
+         ++i)
+    {
+        if (i.channel ().xSampling () != 1 || i.channel ().ySampling () != 1)
+        {
+            THROW (
+                ArgExc,
+                "Cannot generate the levels of image channel \""
+                    << i.name ()
+                    << "\".  Subsampled channels are not supported.");
+        }
+    }
+
+    switch (img.levelMode ())
+    {
+        case MIPMAP_LEVELS:
+
+        {
+            //
+            // Shrink each level first horizontally, into a temporary
+            // image, and then vertically.
+            //
+
+            FlatImage tmp;
+
+            for (FlatImageLevel::ConstIterator i = level0.begin ();
+                 i != level0.end ();
+                 ++i)
+            {
+                tmp.insertChannel (i.name (), i.channel ().pixelType ());
+            }
+
+            for (int l = 1; l < img.numLevels (); ++l)
+            {
+                const Box2i& dw0 = img.dataWindowForLevel (l - 1);
+                const Box2i& dw1 = img.dataWindowForLevel (l);
+
+                tmp.resize (Box2i (dw0.min, V2i (dw1.max.x, dw0.max.y)));
+
+                reduce (
+                    img.level (l - 1),
+                    tmp.level (),
+                    true,
+                    extX,
+                    l & 1,
+                    doNotFilter);
+
+                reduce (
+                    tmp.level (),
+                    img.level (l),
+                    false,
+                    extY,
+                    l & 1,
+                    doNotFilter);
+            }
+        }
+        break;
+
+        case RIPMAP_LEVELS:
+
+            //
+            // Level (0, ly) is computed from level (0, ly - 1),
+            // level (lx, ly) from level (lx - 1, ly).
+            //
+
+            for (int ly = 0; ly < img.numYLevels (); ++ly)
+            {
+                if (ly > 0)
+                {
+                    reduce (
+                        img.level (0, ly - 1),
+                        img.level (0, ly),
+                        false,
+                        extY,
+                        (ly - 1) & 1,
+                        doNotFilter);
+                }
+
+                for (int lx = 1; lx < img.numXLevels (); ++lx)
+                {
+                    reduce (
+                        img.level (lx - 1, ly),
+                        img.level (lx, ly),
+                        true,
+                        extX,
+                        (lx - 1) & 1,
+                        doNotFilter);
+                }
+            }
+            break;
+
+        default: break;
+    }
+}
+
+string
+wrapmodesForExtrapolation (Extrapolation extX, Extrapolation extY)
+{
+    return string (extrapolationName (extX)) + "," + extrapolationName (extY);
+}
+
+void
+computeLevelFilterTaps (
+    double x, int w, Extrapolation ext, int black, LevelFilterTaps& taps)
+{
+    const double pos[4] = {x - 1, x, x + 1, x + 2};
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int    xs = IMATH_NAMESPACE::floor (pos[i]);
+        int    xt = xs + 1;
+        double s  = xt - pos[i];
+        double t  = 1 - s;
+
+        taps.index[i][0]  = extrapolate (xs, w, ext, black);
+        taps.index[i][1]  = extrapolate (xt, w, ext, black);
+        taps.weight[i][0] = s;
+        taps.weight[i][1] = t;
+
+        if (i == 0) taps.first = xs;
+
+        if (i == 3) taps.last = xt;
+    }
+}
+
+void
+filterLevelRowX (
+    const half in[], half out[], int w, const LevelFilterTaps taps[])
+{
+    filterRowX (in, out, w, taps);
+}
+
+void
+filterLevelRowX (
+    const float in[], float out[], int w, const LevelFilterTaps taps[])
+{
+    filterRowX (in, out, w, taps);
+}
+
+void
+filterLevelRowX (
+    const unsigned int    in[],
+    unsigned int          out[],
+    int                   w,
+    const LevelFilterTaps taps[])
+{
+    filterRowX (in, out, w, taps);
+}
+
+void
+filterLevelRowY (
+    const half* const in[4][2], half out[], int w, const LevelFilterTaps& taps)
+{
+    filterRowY (in, out, w, taps);
+}
+
+void
+filterLevelRowY (
+    const float* const     in[4][2],
+    float                  out[],
+    int                    w,
+    const LevelFilterTaps& taps)
+{
+    filterRowY (in, out, w, taps);
+}
+
+void
+filterLevelRowY (
+    const unsigned int* const in[4][2],
+    unsigned int              out[],
+    int                       w,
+    const LevelFilterTaps&    taps)
+{
+    filterRowY (in, out, w, taps);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,180 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_FLAT_IMAGE_LEVELS_H
+#define INCLUDED_IMF_FLAT_IMAGE_LEVELS_H
+
+//----------------------------------------------------------------------------
+//
+//      enum Extrapolation,
+//      function generateFlatImageLevels(),
+//      function wrapmodesForExtrapolation(),
+//      struct LevelFilterTaps,
+//      function computeLevelFilterTaps(),
+//      functions filterLevelRowX(), filterLevelRowY()
+//
+//      Functions to compute the lower-resolution levels of
+//      MIPMAP_LEVELS and RIPMAP_LEVELS flat images.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfFlatImage.h"
+#include "ImfUtilExport.h"
+
+#include <set>
+#include <string>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// How an image is extended beyond its data window when the low-pass
+// filter in generateFlatImageLevels() takes samples outside the data
+// window:
+//
+//      EXTRAPOLATE_BLACK       pixels outside the data window are zero
+//
+//      EXTRAPOLATE_CLAMP       pixels outside the data window repeat
+//                              the nearest pixel on the edge of the
+//                              data window
+//
+//      EXTRAPOLATE_PERIODIC    the image repeats periodically
+//
+//      EXTRAPOLATE_MIRROR      the image repeats periodically, with
+//                              every other copy mirrored
+//
+
+enum IMFUTIL_EXPORT_ENUM Extrapolation
+{
+    EXTRAPOLATE_BLACK,
+    EXTRAPOLATE_CLAMP,
+    EXTRAPOLATE_PERIODIC,
+    EXTRAPOLATE_MIRROR
+};
+
+//
+// generateFlatImageLevels (i, ex, ey, nf)
+//
+//      Computes all levels of image i, other than level (0, 0), from
+//      level (0, 0).  The number and the size of the levels are given
+//      by the level mode and the level rounding mode of i; if the level
+//      mode is ONE_LEVEL, then the image is not modified.
+//
+//      Each level is shrunk by a factor of two, horizontally, vertically
+//      or both, from the next larger level.  The pixels are low-pass
+//      filtered with a four-tap filter and resampled.  Horizontally,
+//      the image is extrapolated as specified by ex; vertically, as
+//      specified by ey.  Channels whose names are in set nf are not
+//      low-pass filtered; every other pixel is skipped instead.
+//
+//      The work is divided into tasks that run in the global thread
+//      pool (see ImfThreading.h).
+//
+//      Subsampled channels are not supported; if the level mode of i
+//      is not ONE_LEVEL and i has a channel whose x or y sampling rate
+//      is not 1, generateFlatImageLevels() throws an exception.
+//
+
+IMFUTIL_EXPORT
+void generateFlatImageLevels (
+    FlatImage&                   img,
+    Extrapolation                extX        = EXTRAPOLATE_CLAMP,
+    Extrapolation                extY        = EXTRAPOLATE_CLAMP,
+    const std::set<std::string>& doNotFilter = std::set<std::string> ());
+
+//
+// wrapmodesForExtrapolation (ex, ey)
+//
+//      Returns a string, such as "clamp,periodic", that can be stored
+//      in the wrapmodes attribute (see ImfStandardAttributes.h) of a
+//      file whose levels were generated with extrapolation modes ex
+//      and ey.
+//
+
+IMFUTIL_EXPORT
+std::string wrapmodesForExtrapolation (Extrapolation extX, Extrapolation extY);
+
+//
+// The filter that generateFlatImageLevels() uses, for programs, such
+// as exrmaketiled, that compute the levels of an image piece by piece
+// instead of holding the whole image in a FlatImage.
+//
+// struct LevelFilterTaps
+//
+//      The four-tap low-pass filter for one output pixel.  Each tap
+//      interpolates linearly between two adjacent source pixels:
+//      index[i][0] and index[i][1] are the extrapolated indices of
+//      the two source pixels, weight[i][0] and weight[i][1] are the
+//      corresponding weights.  first and last are the indices of the
+//      leftmost and rightmost source pixel, before extrapolation.
+//
+// computeLevelFilterTaps (x, w, ext, black, taps)
+//
+//      Sets up taps for a filter centered on position x + 0.5 in a
+//      row or column of w source pixels, which is extended beyond
+//      its ends as specified by ext.  With EXTRAPOLATE_BLACK, source
+//      indices outside the range [0, w) are replaced by black, the
+//      index of a pixel whose value is zero.
+//
+// filterLevelRowX (in, out, w, taps)
+//
+//      Horizontally low-pass filters and resamples a row of source
+//      pixels, in, into w pixels, out.  taps[x] is the filter for
+//      out[x].
+//
+// filterLevelRowY (in, out, w, taps)
+//
+//      Vertically low-pass filters and resamples a row of w pixels,
+//      out.  in[i][j] are the source rows that correspond to
+//      taps.index[i][j].
+//
+
+struct IMFUTIL_EXPORT_TYPE LevelFilterTaps
+{
+    int    index[4][2];
+    double weight[4][2];
+    int    first;
+    int    last;
+};
+
+IMFUTIL_EXPORT
+void computeLevelFilterTaps (
+    double x, int w, Extrapolation ext, int black, LevelFilterTaps& taps);
+
+IMFUTIL_EXPORT
+void filterLevelRowX (
+    const half in[], half out[], int w, const LevelFilterTaps taps[]);
+
+IMFUTIL_EXPORT
+void filterLevelRowX (
+    const float in[], float out[], int w, const LevelFilterTaps taps[]);
+
+IMFUTIL_EXPORT
+void filterLevelRowX (
+    const unsigned int    in[],
+    unsigned int          out[],
+    int                   w,
+    const LevelFilterTaps taps[]);
+
+IMFUTIL_EXPORT
+void filterLevelRowY (
+    const half* const in[4][2], half out[], int w, const LevelFilterTaps& taps);
+
+IMFUTIL_EXPORT
+void filterLevelRowY (
+    const float* const     in[4][2],
+    float                  out[],
+    int                    w,
+    const LevelFilterTaps& taps);
+
+IMFUTIL_EXPORT
+void filterLevelRowY (
+    const unsigned int* const in[4][2],
+    unsigned int              out[],
+    int                       w,
+    const LevelFilterTaps&    taps);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,574 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      Generation of preview images from reduced-resolution reads,
+//      and in-place update of the preview image attribute.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfPreviewFile.h"
+#include "ImfCoreFile.h"
+#include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImathFun.h>
+#include <ImfArray.h>
+#include <ImfRgbaFile.h>
+#include <ImfTiledRgbaFile.h>
+#include <ImfThreading.h>
+#include <openexr.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// Conversion from half to unsigned char pixel data, with gamma
+// correction.  The conversion is the same as in the exrdisplay
+// program's ImageView class, except with defog, kneeLow, and
+// kneeHigh fixed at 0.0, 0.0, and 5.0 respectively.  Rather than
+// evaluating the curve for every pixel, it is tabulated for all
+// 65536 half values once per preview.
+//
+
+float
+knee (float x, float f)
+{
+    return log (x * f + 1) / f;
+}
+
+unsigned char
+gamma (half h, float m)
+{
+    float x = max (0.f, h * m);
+
+    if (x > 1) x = 1 + knee (x - 1, 0.184874f);
+
+    return (unsigned char) (IMATH_NAMESPACE::clamp (
+        std::pow (x, 0.4545f) * 84.66f, 0.f, 255.f));
+}
+
+class ToneMap
+{
+public:
+    ToneMap (float exposure) : _color (1 << 16), _alpha (1 << 16)
+    {
+        float m = std::pow (
+            2.f, IMATH_NAMESPACE::clamp (exposure + 2.47393f, -20.f, 20.f));
+
+        for (int i = 0; i < (1 << 16); ++i)
+        {
+            half h;
+            h.setBits ((unsigned short) i);
+
+            _color[i] = gamma (h, m);
+            _alpha[i] = (unsigned char) int (
+                IMATH_NAMESPACE::clamp (h * 255.f, 0.f, 255.f) + .5f);
+        }
+    }
+
+    PreviewRgba operator() (const Rgba& pixel) const
+    {
+        return PreviewRgba (
+            _color[pixel.r.bits ()],
+            _color[pixel.g.bits ()],
+            _color[pixel.b.bits ()],
+            _alpha[pixel.a.bits ()]);
+    }
+
+private:
+    vector<unsigned char> _color;
+    vector<unsigned char> _alpha;
+};
+
+//
+// Nearest-pixel sampling of a w by h image, at the resolution of the
+// preview.  Only the lines returned by sourceLine() are needed.
+//
+
+struct Sampler
+{
+    Sampler (int w, int h, int previewWidth, int previewHeight)
+        : w (w)
+        , h (h)
+        , fx ((previewWidth > 1) ? (double (w - 1) / (previewWidth - 1)) : 1)
+        , fy ((previewHeight > 1) ? (double (h - 1) / (previewHeight - 1))
+                                  : 1)
+    {}
+
+    int sourceLine (int y) const { return int (y * fy + .5f); }
+
+    void sampleLine (
+        const Rgba*    line,
+        const ToneMap& toneMap,
+        PreviewRgba*   preview,
+        int            previewWidth) const
+    {
+        for (int x = 0; x < previewWidth; ++x)
+            preview[x] = toneMap (line[int (x * fx + .5f)]);
+    }
+
+    int    w, h;
+    double fx, fy;
+};
+
+int
+computePreviewHeight (const Box2i& dw, float a, int previewWidth)
+{
+    int w = dw.max.x - dw.min.x + 1;
+    int h = dw.max.y - dw.min.y + 1;
+
+    return max (int (h / (w * a) * previewWidth + .5f), 1);
+}
+
+//
+// Tiled files: only the tile rows that contain sampled lines of the
+// smallest sufficiently large level are read.  The tiles of a row
+// are decoded in parallel by TiledRgbaInputFile.
+//
+
+void
+sampleTiledFile (
+    const char     fileName[],
+    const ToneMap& toneMap,
+    int            previewWidth,
+    PreviewImage&  preview)
+{
+    TiledRgbaInputFile in (fileName);
+
+    int previewHeight = computePreviewHeight (
+        in.dataWindow (), in.pixelAspectRatio (), previewWidth);
+
+    int lx = 0;
+    int ly = 0;
+
+    if (in.levelMode () == MIPMAP_LEVELS)
+    {
+        while (lx + 1 < in.numLevels () &&
+               in.levelWidth (lx + 1) >= previewWidth &&
+               in.levelHeight (lx + 1) >= previewHeight)
+            ++lx;
+
+        ly = lx;
+    }
+    else if (in.levelMode () == RIPMAP_LEVELS)
+    {
+        while (lx + 1 < in.numXLevels () &&
+               in.levelWidth (lx + 1) >= previewWidth)
+            ++lx;
+
+        while (ly + 1 < in.numYLevels () &&
+               in.levelHeight (ly + 1) >= previewHeight)
+            ++ly;
+    }
+
+    Box2i   dw = in.dataWindowForLevel (lx, ly);
+    Sampler sampler (
+        dw.max.x - dw.min.x + 1,
+        dw.max.y - dw.min.y + 1,
+        previewWidth,
+        previewHeight);
+
+    preview = PreviewImage (previewWidth, previewHeight);
+
+    int           tileHeight = in.tileYSize ();
+    Array2D<Rgba> tileRow (tileHeight, sampler.w);
+    int           currentTileRow = -1;
+
+    for (int y = 0; y < previewHeight; ++y)
+    {
+        int line = sampler.sourceLine (y);
+        int dy   = line / tileHeight;
+
+        if (dy != currentTileRow)
+        {
+            V2i origin (dw.min.x, dw.min.y + dy * tileHeight);
+
+            in.setFrameBuffer (
+                ComputeBasePointer (&tileRow[0][0], origin, sampler.w),
+                1,
+                sampler.w);
+
+            in.readTiles (0, in.numXTiles (lx) - 1, dy, dy, lx, ly);
+            currentTileRow = dy;
+        }
+
+        sampler.sampleLine (
+            tileRow[line % tileHeight],
+            toneMap,
+            &preview.pixel (0, y),
+            previewWidth);
+    }
+}
+
+//
+// Scan line files whose RGBA channels OpenEXRCore can decode: the
+// chunks that contain sampled lines are decoded in parallel, each
+// task taking the next chunk until all are done.  Every preview line
+// is written by the task that decodes its source line.
+//
+
+struct ScanLineSampling
+{
+    ScanLineSampling (
+        const CoreFile& file,
+        const Box2i&    dw,
+        const ToneMap&  toneMap,
+        const Sampler&  sampler,
+        PreviewImage&   preview)
+        : file (file)
+        , dw (dw)
+        , toneMap (toneMap)
+        , sampler (sampler)
+        , preview (preview)
+        , next (0)
+    {}
+
+    const CoreFile& file;
+    Box2i           dw;
+    const ToneMap&  toneMap;
+    Sampler         sampler;
+    PreviewImage&   preview;
+    vector<int>     chunks; // first line of each chunk to be decoded
+    atomic<size_t>  next;
+    mutex           errorMutex;
+    string          error;
+};
+
+uint8_t*
+rgbaTarget (Rgba& pixel, const char name[])
+{
+    if (!strcmp (name, "R")) return (uint8_t*) &pixel.r;
+    if (!strcmp (name, "G") || !strcmp (name, "Y")) return (uint8_t*) &pixel.g;
+    if (!strcmp (name, "B")) return (uint8_t*) &pixel.b;
+    if (!strcmp (name, "A")) return (uint8_t*) &pixel.a;
+    return 0;
+}
+
+void
+sampleChunk (ScanLineSampling& s, int chunkY, vector<Rgba>& buffer)
+{
+    const CoreFile&  file = s.file;
+    exr_chunk_info_t cinfo;
+
+    file.check (exr_read_scanline_chunk_info (file.ctxt (), 0, chunkY, &cinfo));
+
+    buffer.assign (size_t (cinfo.height) * s.sampler.w, Rgba (0, 0, 0, 1));
+
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    file.check (exr_decoding_initialize (file.ctxt (), 0, &cinfo, &decoder));
+
+    bool luminance = true;
+
+    try
+    {
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& chan = decoder.channels[c];
+            uint8_t* target = rgbaTarget (buffer[0], chan.channel_name);
+
+            if (strcmp (chan.channel_name, "Y") && target &&
+                strcmp (chan.channel_name, "A"))
+                luminance = false;
+
+            chan.decode_to_ptr          = target;
+            chan.user_data_type         = EXR_PIXEL_HALF;
+            chan.user_bytes_per_element = 2;
+            chan.user_pixel_stride      = sizeof (Rgba);
+            chan.user_line_stride       = int32_t (sizeof (Rgba)) * s.sampler.w;
+        }
+
+        file.check (exr_decoding_choose_default_routines (
+            file.ctxt (), 0, &decoder));
+        file.check (exr_decoding_run (file.ctxt (), 0, &decoder));
+    }
+    catch (...)
+    {
+        exr_decoding_destroy (file.ctxt (), &decoder);
+        throw;
+    }
+
+    exr_decoding_destroy (file.ctxt (), &decoder);
+
+    //
+    // A luminance-only image was decoded into the green channel.
+    //
+
+    if (luminance)
+    {
+        for (size_t i = 0; i < buffer.size (); ++i)
+            buffer[i].r = buffer[i].b = buffer[i].g;
+    }
+
+    int first = cinfo.start_y - s.dw.min.y;
+    int last  = first + cinfo.height - 1;
+
+    for (unsigned int y = 0; y < s.preview.height (); ++y)
+    {
+        int line = s.sampler.sourceLine (y);
+
+        if (line < first || line > last) continue;
+
+        s.sampler.sampleLine (
+            &buffer[size_t (line - first) * s.sampler.w],
+            s.toneMap,
+            &s.preview.pixel (0, y),
+            s.preview.width ());
+    }
+}
+
+class SampleChunksTask : public Task
+{
+public:
+    SampleChunksTask (TaskGroup* group, ScanLineSampling& sampling)
+        : Task (group), _sampling (sampling)
+    {}
+
+    void execute () override
+    {
+        vector<Rgba> buffer;
+
+        try
+        {
+            for (size_t i = _sampling.next++; i < _sampling.chunks.size ();
+                 i            = _sampling.next++)
+                sampleChunk (_sampling, _sampling.chunks[i], buffer);
+        }
+        catch (const std::exception& e)
+        {
+            lock_guard<mutex> lock (_sampling.errorMutex);
+            if (_sampling.error.empty ()) _sampling.error = e.what ();
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock (_sampling.errorMutex);
+            if (_sampling.error.empty ())
+                _sampling.error = "Unexpected exception while decoding.";
+        }
+    }
+
+private:
+    ScanLineSampling& _sampling;
+};
+
+//
+// Returns true if the RGBA channels of the first part of file can be
+// decoded with OpenEXRCore.  Luminance/chroma images and DWA
+// compression are left to RgbaInputFile.
+//
+
+bool
+coreCanSample (const CoreFile& file)
+{
+    exr_compression_t        comp;
+    const exr_attr_chlist_t* channels;
+
+    file.check (exr_get_compression (file.ctxt (), 0, &comp));
+    file.check (exr_get_channels (file.ctxt (), 0, &channels));
+
+    if (comp == EXR_COMPRESSION_DWAA || comp == EXR_COMPRESSION_DWAB)
+        return false;
+
+    int numRgba = 0;
+
+    for (int c = 0; c < channels->num_channels; ++c)
+    {
+        const exr_attr_chlist_entry_t& e    = channels->entries[c];
+        const char*                    name = e.name.str;
+
+        if (!strcmp (name, "RY") || !strcmp (name, "BY")) return false;
+
+        if (!strcmp (name, "R") || !strcmp (name, "G") ||
+            !strcmp (name, "B") || !strcmp (name, "A") || !strcmp (name, "Y"))
+        {
+            if (e.x_sampling != 1 || e.y_sampling != 1) return false;
+            ++numRgba;
+        }
+    }
+
+    return numRgba > 0;
+}
+
+void
+sampleScanLineFileWithCore (
+    const CoreFile& file,
+    const ToneMap&  toneMap,
+    int             previewWidth,
+    PreviewImage&   preview)
+{
+    exr_attr_box2i_t box;
+    float            a;
+    int32_t          linesPerChunk;
+
+    file.check (exr_get_data_window (file.ctxt (), 0, &box));
+    file.check (exr_get_pixel_aspect_ratio (file.ctxt (), 0, &a));
+    file.check (exr_get_scanlines_per_chunk (file.ctxt (), 0, &linesPerChunk));
+
+    Box2i dw (V2i (box.min.x, box.min.y), V2i (box.max.x, box.max.y));
+    int   previewHeight = computePreviewHeight (dw, a, previewWidth);
+
+    preview = PreviewImage (previewWidth, previewHeight);
+
+    ScanLineSampling s (
+        file,
+        dw,
+        toneMap,
+        Sampler (
+            dw.max.x - dw.min.x + 1,
+            dw.max.y - dw.min.y + 1,
+            previewWidth,
+            previewHeight),
+        preview);
+
+    for (int y = 0; y < previewHeight; ++y)
+    {
+        int chunkY = dw.min.y + s.sampler.sourceLine (y) / linesPerChunk *
+                                    linesPerChunk;
+
+        if (s.chunks.empty () || s.chunks.back () != chunkY)
+            s.chunks.push_back (chunkY);
+    }
+
+    {
+        TaskGroup taskGroup;
+        int       numTasks = min<int> (
+            max (globalThreadCount (), 1), int (s.chunks.size ()));
+
+        for (int i = 0; i < numTasks; ++i)
+            ThreadPool::addGlobalTask (new SampleChunksTask (&taskGroup, s));
+    }
+
+    if (!s.error.empty ()) throw IoExc (s.error);
+}
+
+//
+// Everything else is read with RgbaInputFile, one sampled line at a
+// time; the line buffer holding a line is only decoded once.
+//
+
+void
+sampleScanLineFile (
+    const char     fileName[],
+    const ToneMap& toneMap,
+    int            previewWidth,
+    PreviewImage&  preview)
+{
+    RgbaInputFile in (fileName);
+
+    Box2i dw            = in.dataWindow ();
+    int   previewHeight = computePreviewHeight (
+        dw, in.pixelAspectRatio (), previewWidth);
+
+    Sampler sampler (
+        dw.max.x - dw.min.x + 1,
+        dw.max.y - dw.min.y + 1,
+        previewWidth,
+        previewHeight);
+
+    preview = PreviewImage (previewWidth, previewHeight);
+
+    vector<Rgba> line (sampler.w);
+
+    for (int y = 0; y < previewHeight; ++y)
+    {
+        int fileY = dw.min.y + sampler.sourceLine (y);
+
+        in.setFrameBuffer (
+            ComputeBasePointer (&line[0], V2i (dw.min.x, fileY), sampler.w),
+            1,
+            sampler.w);
+
+        in.readPixels (fileY);
+        sampler.sampleLine (
+            &line[0], toneMap, &preview.pixel (0, y), previewWidth);
+    }
+}
+
+} // namespace
+
+PreviewImage
+makePreviewImage (const char fileName[], int previewWidth, float exposure)
+{
+    if (previewWidth <= 0)
+        THROW (ArgExc, "Invalid preview image width " << previewWidth << ".");
+
+    ToneMap      toneMap (exposure);
+    PreviewImage preview;
+
+    {
+        CoreFile file (fileName, "read");
+        file.startRead ();
+
+        exr_storage_t storage;
+        file.check (exr_get_storage (file.ctxt (), 0, &storage));
+
+        if (storage == EXR_STORAGE_TILED)
+        {
+            file.finish ();
+            sampleTiledFile (fileName, toneMap, previewWidth, preview);
+            return preview;
+        }
+
+        if (storage == EXR_STORAGE_SCANLINE && coreCanSample (file))
+        {
+            sampleScanLineFileWithCore (file, toneMap, previewWidth, preview);
+            return preview;
+        }
+    }
+
+    sampleScanLineFile (fileName, toneMap, previewWidth, preview);
+    return preview;
+}
+
+bool
+updatePreviewImage (const char fileName[], const PreviewImage& preview)
+{
+    CoreFile file (fileName, "read");
+    file.startUpdate ();
+
+    const exr_attribute_t* attr = 0;
+    exr_result_t           rv =
+        exr_get_attribute_by_name (file.ctxt (), 0, "preview", &attr);
+
+    if (rv == EXR_ERR_NO_ATTR_BY_NAME) return false;
+
+    file.check (rv);
+
+    if (attr->type != EXR_ATTR_PREVIEW ||
+        attr->preview->width != preview.width () ||
+        attr->preview->height != preview.height ())
+        return false;
+
+    exr_attr_preview_t value;
+    value.width      = preview.width ();
+    value.height     = preview.height ();
+    value.alloc_size = 0;
+    value.rgba       = (const uint8_t*) preview.pixels ();
+
+    file.check (exr_attr_set_preview (file.ctxt (), 0, "preview", &value));
+    file.check (exr_write_header (file.ctxt ()));
+    file.finish ();
+
+    return true;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,66 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_PREVIEW_FILE_H
+#define INCLUDED_IMF_PREVIEW_FILE_H
+
+//----------------------------------------------------------------------------
+//
+//      functions makePreviewImage(), updatePreviewImage()
+//
+//      Generation of preview images (thumbnails) from the pixels of
+//      an OpenEXR file, and storage of preview images in the header
+//      of an existing file without rewriting its pixel data.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+#include "ImfPreviewImage.h"
+#include "ImfUtilExport.h"
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// makePreviewImage (fileName, previewWidth, exposure)
+//
+//      Returns a preview image, previewWidth pixels wide, of the RGBA
+//      pixels of the first part of file fileName.  The height of the
+//      preview follows from the aspect ratio of the data window and
+//      the pixel aspect ratio.  The pixel values are adjusted by
+//      exposure f-stops, and then mapped to 8 bits with the same knee
+//      and gamma curve as exrdisplay.
+//
+//      The preview samples the nearest pixel, so only a fraction of
+//      the image needs to be read:
+//
+//      - if the file is tiled and has mipmap or ripmap levels, only
+//        the smallest level that is at least as large as the preview
+//        is read;
+//
+//      - otherwise only the scan line chunks that contain the sampled
+//        lines are read, and they are decoded in parallel by tasks in
+//        the global thread pool (see ImfThreading.h).
+//
+
+IMFUTIL_EXPORT
+PreviewImage
+makePreviewImage (const char fileName[], int previewWidth, float exposure = 0);
+
+//
+// updatePreviewImage (fileName, preview)
+//
+//      Replaces the preview image in the header of the first part of
+//      file fileName with preview, by rewriting only the header of
+//      the file.  This is possible only if the file already contains
+//      a preview image with the same width and height; otherwise the
+//      file is left unchanged and updatePreviewImage() returns false.
+//
+
+IMFUTIL_EXPORT
+bool updatePreviewImage (const char fileName[], const PreviewImage& preview);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
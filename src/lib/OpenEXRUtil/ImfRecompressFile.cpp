@@ -0,0 +1,910 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      Re-encoding of the pixel data of OpenEXR files, built on
+//      the decode and encode pipelines of the OpenEXRCore library.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfRecompressFile.h"
+#include "ImfCoreFile.h"
+#include <Iex.h>
+#include <IlmThreadPool.h>
+#include <IlmThreadSemaphore.h>
+#include <ImfCompressor.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfThreading.h>
+#include <openexr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+using ILMTHREAD_NAMESPACE::Semaphore;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+typedef chrono::steady_clock Clock;
+
+double
+secondsSince (Clock::time_point start)
+{
+    return chrono::duration<double> (Clock::now () - start).count ();
+}
+
+//
+// OpenEXRCore cannot compress or uncompress DWAA and DWAB data yet;
+// such chunks are handled by the compressors of the OpenEXR library,
+// which operate on the same uncompressed pixel layout.
+//
+
+bool
+coreSupports (exr_compression_t c)
+{
+    return c != EXR_COMPRESSION_DWAA && c != EXR_COMPRESSION_DWAB;
+}
+
+//
+// What the tasks need to know about a part.  The headers are only
+// set up for parts whose input or output compression method is not
+// supported by OpenEXRCore.
+//
+
+struct PartInfo
+{
+    bool              tiled;
+    bool              raw;
+    exr_compression_t inCompression;
+    exr_compression_t outCompression;
+    int               inLinesPerChunk;
+    int               tileWidth;
+    int               tileHeight;
+    size_t            lineSize; // bytes per scan line or line of a tile
+    float             dwaLevel; // for DWAA and DWAB output
+    Box2i             dataWindow;
+    Header            inHeader;
+    Header            outHeader;
+};
+
+//
+// A unit of work: one tile, or a band of scan lines that starts
+// and ends on a chunk boundary of both the input and the output.
+//
+
+struct Unit
+{
+    int part;
+    int x, y, levelX, levelY; // tile coordinates and level
+    int yEnd;                 // end of the band of scan lines
+};
+
+//
+// The state of one slot of the pipeline.  The main thread fills in
+// the unit and the output chunk descriptions, a RecompressTask
+// produces the compressed output chunks, and the main thread writes
+// them once the task has posted the semaphore.
+//
+
+struct Slot
+{
+    Slot () : done (0) {}
+
+    Unit                     unit;
+    vector<exr_chunk_info_t> outChunks;
+    vector<vector<uint8_t>>  outData;
+    vector<uint8_t>          unpacked;
+    vector<uint8_t>          packed;
+    string                   error;
+
+    uint64_t chunksRead;
+    uint64_t bytesRead;
+    uint64_t bytesUnpacked;
+    double   readTime;
+    double   decompressTime;
+    double   compressTime;
+
+    Semaphore done;
+};
+
+struct TimedRead
+{
+    exr_result_t (*read) (exr_decode_pipeline_t*);
+    double time;
+};
+
+exr_result_t
+timedRead (exr_decode_pipeline_t* decode)
+{
+    TimedRead* t = static_cast<TimedRead*> (decode->decoding_user_data);
+    Clock::time_point start = Clock::now ();
+    exr_result_t      rv    = t->read (decode);
+    t->time += secondsSince (start);
+    return rv;
+}
+
+class RecompressTask : public Task
+{
+public:
+    RecompressTask (
+        TaskGroup*      group,
+        const CoreFile& in,
+        const CoreFile& out,
+        const PartInfo& part,
+        Slot&           slot)
+        : Task (group), _in (in), _out (out), _part (part), _slot (slot)
+    {}
+
+    void execute () override;
+
+private:
+    void        readChunkInfo (int i, exr_chunk_info_t& cinfo) const;
+    Box2i       tileRange (const exr_chunk_info_t& cinfo) const;
+    Compressor* newCompressor (Compression c, const Header& hdr) const;
+    void        copyChunks ();
+    void        decodeChunks ();
+    void        encodeChunks ();
+    void        coreDecode (const exr_chunk_info_t& cinfo);
+    void coreEncode (const exr_chunk_info_t& cinfo, uint8_t* packed, int i);
+
+    const CoreFile& _in;
+    const CoreFile& _out;
+    const PartInfo& _part;
+    Slot&           _slot;
+};
+
+void
+RecompressTask::execute ()
+{
+    _slot.chunksRead     = 0;
+    _slot.bytesRead      = 0;
+    _slot.bytesUnpacked  = 0;
+    _slot.readTime       = 0;
+    _slot.decompressTime = 0;
+    _slot.compressTime   = 0;
+
+    try
+    {
+        if (_part.raw)
+        {
+            copyChunks ();
+        }
+        else
+        {
+            decodeChunks ();
+            encodeChunks ();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        _slot.error = e.what ();
+    }
+    catch (...)
+    {
+        _slot.error = "Unexpected exception while recompressing a chunk.";
+    }
+
+    _slot.done.post ();
+}
+
+void
+RecompressTask::readChunkInfo (int i, exr_chunk_info_t& cinfo) const
+{
+    const Unit& u = _slot.unit;
+
+    if (_part.tiled)
+    {
+        _in.check (exr_read_tile_chunk_info (
+            _in.ctxt (), u.part, u.x, u.y, u.levelX, u.levelY, &cinfo));
+    }
+    else
+    {
+        _in.check (exr_read_scanline_chunk_info (
+            _in.ctxt (), u.part, u.y + i * _part.inLinesPerChunk, &cinfo));
+    }
+}
+
+Box2i
+RecompressTask::tileRange (const exr_chunk_info_t& cinfo) const
+{
+    V2i min = _part.dataWindow.min + V2i (cinfo.start_x * _part.tileWidth,
+                                          cinfo.start_y * _part.tileHeight);
+
+    return Box2i (min, min + V2i (cinfo.width - 1, cinfo.height - 1));
+}
+
+Compressor*
+RecompressTask::newCompressor (Compression c, const Header& hdr) const
+{
+    if (_part.tiled)
+        return newTileCompressor (c, _part.lineSize, _part.tileHeight, hdr);
+    else
+        return OPENEXR_IMF_INTERNAL_NAMESPACE::newCompressor (
+            c, _part.lineSize, hdr);
+}
+
+void
+RecompressTask::copyChunks ()
+{
+    //
+    // The input and the output use the same compression method,
+    // and therefore the same chunks; copy them without decoding.
+    //
+
+    for (size_t i = 0; i < _slot.outChunks.size (); ++i)
+    {
+        Clock::time_point start = Clock::now ();
+        exr_chunk_info_t  cinfo;
+
+        readChunkInfo (i, cinfo);
+
+        vector<uint8_t>& data = _slot.outData[i];
+        data.resize (cinfo.packed_size);
+
+        _in.check (exr_read_chunk (
+            _in.ctxt (), _slot.unit.part, &cinfo, data.data ()));
+
+        _slot.readTime += secondsSince (start);
+        _slot.chunksRead += 1;
+        _slot.bytesRead += cinfo.packed_size;
+        _slot.bytesUnpacked += cinfo.unpacked_size;
+    }
+}
+
+void
+RecompressTask::decodeChunks ()
+{
+    //
+    // Uncompress the input chunks of the unit, and concatenate the
+    // results.  Uncompressed pixel data are stored scan line by scan
+    // line, so the concatenation is what the output chunks contain
+    // before they are compressed.
+    //
+
+    const Unit& u = _slot.unit;
+
+    int numChunks = _part.tiled ? 1
+                                : (u.yEnd - u.y + _part.inLinesPerChunk - 1) /
+                                      _part.inLinesPerChunk;
+
+    unique_ptr<Compressor> compressor;
+
+    if (!coreSupports (_part.inCompression))
+    {
+        compressor.reset (newCompressor (
+            Compression (_part.inCompression), _part.inHeader));
+    }
+
+    _slot.unpacked.clear ();
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        exr_chunk_info_t  cinfo;
+        Clock::time_point start = Clock::now ();
+
+        readChunkInfo (i, cinfo);
+
+        if (!compressor)
+        {
+            _slot.readTime += secondsSince (start);
+            coreDecode (cinfo);
+        }
+        else
+        {
+            _slot.packed.resize (cinfo.packed_size);
+
+            _in.check (exr_read_chunk (
+                _in.ctxt (), u.part, &cinfo, _slot.packed.data ()));
+
+            _slot.readTime += secondsSince (start);
+            start = Clock::now ();
+
+            const char* inPtr  = (const char*) _slot.packed.data ();
+            int         inSize = int (cinfo.packed_size);
+            const char* outPtr = inPtr;
+            int         size   = inSize;
+
+            //
+            // Chunks that would not get smaller are stored uncompressed.
+            //
+
+            if (cinfo.packed_size < cinfo.unpacked_size)
+            {
+                if (_part.tiled)
+                {
+                    size = compressor->uncompressTile (
+                        inPtr, inSize, tileRange (cinfo), outPtr);
+                }
+                else
+                {
+                    size = compressor->uncompress (
+                        inPtr, inSize, cinfo.start_y, outPtr);
+                }
+            }
+
+            if (uint64_t (size) != cinfo.unpacked_size)
+            {
+                THROW (
+                    InputExc,
+                    "Cannot recompress part "
+                        << u.part
+                        << ": unexpected size of uncompressed chunk.");
+            }
+
+            const uint8_t* p = (const uint8_t*) outPtr;
+            _slot.unpacked.insert (_slot.unpacked.end (), p, p + size);
+            _slot.decompressTime += secondsSince (start);
+        }
+
+        _slot.chunksRead += 1;
+        _slot.bytesRead += cinfo.packed_size;
+        _slot.bytesUnpacked += cinfo.unpacked_size;
+    }
+}
+
+void
+RecompressTask::coreDecode (const exr_chunk_info_t& cinfo)
+{
+    Clock::time_point     start  = Clock::now ();
+    exr_decode_pipeline_t decode = EXR_DECODE_PIPELINE_INITIALIZER;
+    int                   part   = _slot.unit.part;
+
+    exr_result_t rv =
+        exr_decoding_initialize (_in.ctxt (), part, &cinfo, &decode);
+
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_decoding_choose_default_routines (_in.ctxt (), part, &decode);
+
+    TimedRead timed = {decode.read_fn, 0};
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        //
+        // Stop the pipeline after decompression, and time the read
+        // stage separately.
+        //
+
+        decode.unpack_and_convert_fn = 0;
+        decode.read_fn               = &timedRead;
+        decode.decoding_user_data    = &timed;
+
+        rv = exr_decoding_run (_in.ctxt (), part, &decode);
+    }
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        const uint8_t* p = static_cast<const uint8_t*> (decode.unpacked_buffer);
+
+        _slot.unpacked.insert (
+            _slot.unpacked.end (), p, p + cinfo.unpacked_size);
+    }
+
+    exr_decoding_destroy (_in.ctxt (), &decode);
+    _in.check (rv);
+
+    _slot.readTime += timed.time;
+    _slot.decompressTime += secondsSince (start) - timed.time;
+}
+
+void
+RecompressTask::encodeChunks ()
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < _slot.outChunks.size (); ++i)
+        total += _slot.outChunks[i].unpacked_size;
+
+    if (total != _slot.unpacked.size ())
+    {
+        THROW (
+            LogicExc,
+            "Cannot recompress part " << _slot.unit.part
+                                      << ": input and output chunks do not "
+                                         "cover the same pixels.");
+    }
+
+    unique_ptr<Compressor> compressor;
+
+    if (!coreSupports (_part.outCompression))
+    {
+        compressor.reset (newCompressor (
+            Compression (_part.outCompression), _part.outHeader));
+    }
+
+    uint8_t* packed = _slot.unpacked.data ();
+
+    for (size_t i = 0; i < _slot.outChunks.size (); ++i)
+    {
+        Clock::time_point       start = Clock::now ();
+        const exr_chunk_info_t& cinfo = _slot.outChunks[i];
+
+        if (!compressor)
+        {
+            coreEncode (cinfo, packed, i);
+        }
+        else
+        {
+            const char* inPtr  = (const char*) packed;
+            int         inSize = int (cinfo.unpacked_size);
+            const char* outPtr;
+            int         size;
+
+            if (_part.tiled)
+            {
+                size = compressor->compressTile (
+                    inPtr, inSize, tileRange (cinfo), outPtr);
+            }
+            else
+            {
+                size = compressor->compress (
+                    inPtr, inSize, cinfo.start_y, outPtr);
+            }
+
+            //
+            // Chunks that would not get smaller are stored uncompressed.
+            //
+
+            if (size >= inSize)
+            {
+                outPtr = inPtr;
+                size   = inSize;
+            }
+
+            const uint8_t* p = (const uint8_t*) outPtr;
+            _slot.outData[i].assign (p, p + size);
+        }
+
+        packed += cinfo.unpacked_size;
+        _slot.compressTime += secondsSince (start);
+    }
+}
+
+void
+RecompressTask::coreEncode (
+    const exr_chunk_info_t& cinfo, uint8_t* packed, int i)
+{
+    exr_encode_pipeline_t encode = EXR_ENCODE_PIPELINE_INITIALIZER;
+    int                   part   = _slot.unit.part;
+
+    exr_result_t rv =
+        exr_encoding_initialize (_out.ctxt (), part, &cinfo, &encode);
+
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_encoding_choose_default_routines (_out.ctxt (), part, &encode);
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        //
+        // The data are already packed: skip the packing stage, and
+        // keep the compressed chunk instead of writing it here.
+        // The channel pointers are not used, but must be set.
+        //
+
+        for (int c = 0; c < encode.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& ch = encode.channels[c];
+            ch.encode_from_ptr            = packed;
+            ch.user_bytes_per_element     = ch.bytes_per_element;
+            ch.user_data_type             = ch.data_type;
+        }
+
+        encode.convert_and_pack_fn  = 0;
+        encode.yield_until_ready_fn = 0;
+        encode.write_fn             = 0;
+        encode.packed_buffer        = packed;
+        encode.packed_bytes         = cinfo.unpacked_size;
+        encode.packed_alloc_size    = 0;
+
+        rv = exr_encoding_run (_out.ctxt (), part, &encode);
+    }
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        const uint8_t* p =
+            static_cast<const uint8_t*> (encode.compressed_buffer);
+        _slot.outData[i].assign (p, p + encode.compressed_bytes);
+    }
+
+    //
+    // The packed buffer belongs to the slot; the compressed buffer
+    // is the packed buffer if the output is not compressed.
+    //
+
+    if (encode.compressed_buffer == encode.packed_buffer)
+    {
+        encode.compressed_buffer     = 0;
+        encode.compressed_alloc_size = 0;
+    }
+
+    encode.packed_buffer     = 0;
+    encode.packed_alloc_size = 0;
+
+    exr_encoding_destroy (_out.ctxt (), &encode);
+    _out.check (rv);
+}
+
+void
+addTiledUnits (const CoreFile& in, Unit u, PartInfo& info, vector<Unit>& units)
+{
+    uint32_t              tileW, tileH;
+    exr_tile_level_mode_t levelMode;
+    exr_tile_round_mode_t roundMode;
+    int32_t               numXLevels, numYLevels;
+
+    in.check (exr_get_tile_descriptor (
+        in.ctxt (), u.part, &tileW, &tileH, &levelMode, &roundMode));
+
+    in.check (
+        exr_get_tile_levels (in.ctxt (), u.part, &numXLevels, &numYLevels));
+
+    info.tileWidth  = int (tileW);
+    info.tileHeight = int (tileH);
+    info.lineSize *= tileW;
+
+    //
+    // Tiles are listed in the order of the chunk offset table.
+    //
+
+    for (int ly = 0; ly < numYLevels; ++ly)
+    {
+        for (int lx = 0; lx < numXLevels; ++lx)
+        {
+            if (levelMode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
+
+            int32_t levelW, levelH;
+
+            in.check (exr_get_level_sizes (
+                in.ctxt (), u.part, lx, ly, &levelW, &levelH));
+
+            int numX = (levelW + info.tileWidth - 1) / info.tileWidth;
+            int numY = (levelH + info.tileHeight - 1) / info.tileHeight;
+
+            u.levelX = lx;
+            u.levelY = ly;
+
+            for (u.y = 0; u.y < numY; ++u.y)
+                for (u.x = 0; u.x < numX; ++u.x)
+                    units.push_back (u);
+        }
+    }
+}
+
+void
+addScanLineUnits (
+    const CoreFile& in,
+    const CoreFile& out,
+    Unit            u,
+    PartInfo&       info,
+    vector<Unit>&   units)
+{
+    int32_t inLinesPerChunk, outLinesPerChunk;
+
+    in.check (
+        exr_get_scanlines_per_chunk (in.ctxt (), u.part, &inLinesPerChunk));
+
+    out.check (
+        exr_get_scanlines_per_chunk (out.ctxt (), u.part, &outLinesPerChunk));
+
+    info.inLinesPerChunk = inLinesPerChunk;
+    info.lineSize *= info.dataWindow.max.x - info.dataWindow.min.x + 1;
+
+    //
+    // The number of scan lines per chunk is a power of two for all
+    // compression methods, so the larger of the two chunk heights is
+    // a multiple of the smaller one.
+    //
+
+    int64_t linesPerUnit = max (inLinesPerChunk, outLinesPerChunk);
+
+    for (int64_t y = info.dataWindow.min.y; y <= info.dataWindow.max.y;
+         y += linesPerUnit)
+    {
+        u.y    = int (y);
+        u.yEnd =
+            int (min (y + linesPerUnit, int64_t (info.dataWindow.max.y) + 1));
+        units.push_back (u);
+    }
+}
+
+void
+launch (
+    TaskGroup&      group,
+    const CoreFile& in,
+    const CoreFile& out,
+    const PartInfo& info,
+    const Unit&     u,
+    Slot&           slot)
+{
+    slot.unit = u;
+    slot.error.clear ();
+    slot.outChunks.clear ();
+
+    if (info.tiled)
+    {
+        exr_chunk_info_t cinfo;
+
+        out.check (exr_write_tile_chunk_info (
+            out.ctxt (), u.part, u.x, u.y, u.levelX, u.levelY, &cinfo));
+
+        slot.outChunks.push_back (cinfo);
+    }
+    else
+    {
+        for (int y = u.y; y < u.yEnd;)
+        {
+            exr_chunk_info_t cinfo;
+
+            out.check (
+                exr_write_scanline_chunk_info (out.ctxt (), u.part, y, &cinfo));
+
+            slot.outChunks.push_back (cinfo);
+            y = cinfo.start_y + cinfo.height;
+        }
+    }
+
+    slot.outData.resize (slot.outChunks.size ());
+
+    ThreadPool::addGlobalTask (
+        new RecompressTask (&group, in, out, info, slot));
+}
+
+} // namespace
+
+void
+recompressFile (
+    const char*      inFileName,
+    const char*      outFileName,
+    Compression      compression,
+    RecompressStats* stats,
+    float            dwaCompressionLevel)
+{
+    if (compression < NO_COMPRESSION || compression >= NUM_COMPRESSION_METHODS)
+        THROW (
+            ArgExc, "Invalid compression method " << int (compression) << ".");
+
+    Clock::time_point start = Clock::now ();
+    RecompressStats   s;
+    memset (&s, 0, sizeof (s));
+
+    CoreFile in (inFileName, "recompress");
+    CoreFile out (outFileName, "recompress");
+
+    in.startRead ();
+    out.startWrite ();
+
+    //
+    // Define the output parts: copy every attribute of the input
+    // parts, and then replace the compression method.
+    //
+
+    int numParts;
+    in.check (exr_get_count (in.ctxt (), &numParts));
+
+    vector<PartInfo> parts (numParts);
+    bool             needHeaders = false;
+
+    for (int p = 0; p < numParts; ++p)
+    {
+        PartInfo&     info = parts[p];
+        exr_storage_t storage;
+        const char*   name = 0;
+        int           index;
+
+        in.check (exr_get_storage (in.ctxt (), p, &storage));
+        in.check (exr_get_compression (in.ctxt (), p, &info.inCompression));
+
+        if (storage == EXR_STORAGE_DEEP_SCANLINE ||
+            storage == EXR_STORAGE_DEEP_TILED)
+        {
+            THROW (
+                ArgExc,
+                "Cannot recompress \"" << inFileName << "\". Part " << p
+                                       << " contains deep data, which is not "
+                                          "supported.");
+        }
+
+        info.tiled          = (storage == EXR_STORAGE_TILED);
+        info.outCompression = (exr_compression_t) compression;
+        info.raw            = (info.inCompression == info.outCompression);
+
+        if (!info.raw && (!coreSupports (info.inCompression) ||
+                          !coreSupports (info.outCompression)))
+            needHeaders = true;
+
+        if (exr_get_name (in.ctxt (), p, &name) != EXR_ERR_SUCCESS) name = 0;
+
+        out.check (exr_add_part (out.ctxt (), name, storage, &index));
+        out.check (
+            exr_copy_unset_attributes (out.ctxt (), index, in.ctxt (), p));
+        out.check (
+            exr_set_compression (out.ctxt (), index, info.outCompression));
+
+        //
+        // The DWA compression level is stored in the output header,
+        // so that it matches the level that is actually used.
+        //
+
+        info.dwaLevel = -1;
+
+        if (!info.raw && !coreSupports (info.outCompression))
+        {
+            const exr_attribute_t* attr;
+
+            info.dwaLevel = dwaCompressionLevel;
+
+            if (info.dwaLevel < 0 &&
+                exr_get_attribute_by_name (
+                    in.ctxt (), p, "dwaCompressionLevel", &attr) ==
+                    EXR_ERR_SUCCESS &&
+                attr->type == EXR_ATTR_FLOAT)
+            {
+                info.dwaLevel = attr->f;
+            }
+
+            if (info.dwaLevel < 0)
+                exr_get_default_dwa_compression_quality (&info.dwaLevel);
+
+            out.check (exr_set_dwa_compression_level (
+                out.ctxt (), index, info.dwaLevel));
+            out.check (exr_attr_set_float (
+                out.ctxt (), index, "dwaCompressionLevel", info.dwaLevel));
+        }
+    }
+
+    if (needHeaders)
+    {
+        MultiPartInputFile file (inFileName);
+
+        for (int p = 0; p < numParts; ++p)
+        {
+            parts[p].inHeader  = file.header (p);
+            parts[p].outHeader = file.header (p);
+            parts[p].outHeader.compression () = compression;
+
+            if (parts[p].dwaLevel >= 0)
+                parts[p].outHeader.dwaCompressionLevel () = parts[p].dwaLevel;
+        }
+    }
+
+    out.check (exr_write_header (out.ctxt ()));
+
+    vector<Unit> units;
+
+    for (int p = 0; p < numParts; ++p)
+    {
+        PartInfo&               info = parts[p];
+        const exr_attr_chlist_t* channels;
+        exr_attr_box2i_t         dw;
+
+        in.check (exr_get_channels (in.ctxt (), p, &channels));
+        in.check (exr_get_data_window (in.ctxt (), p, &dw));
+
+        info.dataWindow =
+            Box2i (V2i (dw.min.x, dw.min.y), V2i (dw.max.x, dw.max.y));
+        info.inLinesPerChunk = 1;
+        info.tileWidth       = 1;
+        info.tileHeight      = 1;
+        info.lineSize        = 0;
+
+        for (int c = 0; c < channels->num_channels; ++c)
+            info.lineSize +=
+                (channels->entries[c].pixel_type == EXR_PIXEL_HALF) ? 2 : 4;
+
+        Unit u;
+        u.part   = p;
+        u.x      = 0;
+        u.y      = 0;
+        u.levelX = 0;
+        u.levelY = 0;
+        u.yEnd   = 0;
+
+        if (info.tiled)
+            addTiledUnits (in, u, info, units);
+        else
+            addScanLineUnits (in, out, u, info, units);
+    }
+
+    //
+    // Run the pipeline.  Up to two units per thread are being
+    // processed while the main thread writes the chunks of the
+    // oldest unit; chunks must be written in file order.
+    //
+
+    size_t       numSlots = 2 * max (1, globalThreadCount ());
+    vector<Slot> slots (min (numSlots, max (units.size (), size_t (1))));
+
+    {
+        //
+        // If an exception is thrown, the destructor of the task group
+        // waits for the running tasks before the slots are destroyed.
+        //
+
+        TaskGroup group;
+        size_t    next = 0;
+
+        for (size_t i = 0; i < units.size (); ++i)
+        {
+            for (; next < units.size () && next < i + slots.size (); ++next)
+            {
+                const Unit& u = units[next];
+
+                launch (
+                    group,
+                    in,
+                    out,
+                    parts[u.part],
+                    u,
+                    slots[next % slots.size ()]);
+            }
+
+            Slot& slot = slots[i % slots.size ()];
+            slot.done.wait ();
+
+            if (!slot.error.empty ()) throw IoExc (slot.error);
+
+            Clock::time_point writeStart = Clock::now ();
+
+            for (size_t c = 0; c < slot.outChunks.size (); ++c)
+            {
+                const exr_chunk_info_t& cinfo = slot.outChunks[c];
+                const vector<uint8_t>&  data  = slot.outData[c];
+
+                if (parts[slot.unit.part].tiled)
+                {
+                    out.check (exr_write_tile_chunk (
+                        out.ctxt (),
+                        slot.unit.part,
+                        cinfo.start_x,
+                        cinfo.start_y,
+                        cinfo.level_x,
+                        cinfo.level_y,
+                        data.data (),
+                        data.size ()));
+                }
+                else
+                {
+                    out.check (exr_write_scanline_chunk (
+                        out.ctxt (),
+                        slot.unit.part,
+                        cinfo.start_y,
+                        data.data (),
+                        data.size ()));
+                }
+
+                s.chunksWritten += 1;
+                s.bytesWritten += data.size ();
+            }
+
+            s.writeTime += secondsSince (writeStart);
+            s.chunksRead += slot.chunksRead;
+            s.bytesRead += slot.bytesRead;
+            s.bytesUnpacked += slot.bytesUnpacked;
+            s.readTime += slot.readTime;
+            s.decompressTime += slot.decompressTime;
+            s.compressTime += slot.compressTime;
+        }
+    }
+
+    out.finish ();
+
+    s.totalTime = secondsSince (start);
+    if (stats) *stats = s;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,95 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_RECOMPRESS_FILE_H
+#define INCLUDED_IMF_RECOMPRESS_FILE_H
+
+//----------------------------------------------------------------------------
+//
+//      struct RecompressStats,
+//      function recompressFile()
+//
+//      Re-encodes the pixel data of an OpenEXR file with a different
+//      compression method, without converting the pixels to an
+//      in-memory image.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfCompression.h"
+#include "ImfNamespace.h"
+#include "ImfUtilExport.h"
+
+#include <cstdint>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// Statistics gathered by recompressFile().  The time spent in the
+// read, decompress and compress stages is summed over all threads,
+// so the throughput of a stage is the number of bytes it processed
+// divided by its time, per thread.  Writing is done by a single
+// thread.  totalTime is the wall-clock time of the whole conversion.
+//
+
+struct IMFUTIL_EXPORT_TYPE RecompressStats
+{
+    uint64_t chunksRead;
+    uint64_t chunksWritten;
+
+    uint64_t bytesRead;     // compressed pixel data read from the input
+    uint64_t bytesUnpacked; // uncompressed pixel data
+    uint64_t bytesWritten;  // compressed pixel data written to the output
+
+    double readTime;
+    double decompressTime;
+    double compressTime;
+    double writeTime;
+    double totalTime;
+};
+
+//
+// recompressFile (in, out, c, s, l)
+//
+//      Reads OpenEXR file in and writes a copy of it, with the pixel
+//      data of every part compressed with method c, to file out.  All
+//      header attributes except compression (and chunkCount, which
+//      depends on the compression) are preserved, as are the part
+//      structure and the tile layout.  Parts that already use method
+//      c are copied without decompressing them.
+//
+//      The conversion runs in a bounded pipeline: chunks are read,
+//      decompressed and compressed by tasks in the global thread pool
+//      (see ImfThreading.h), and written in file order by the calling
+//      thread.  At most a few chunks per thread are held in memory.
+//
+//      Pixel data are not converted between pixel types; lossy
+//      methods (B44, DWAA, ...) are applied to the values in the
+//      input file.  Deep parts are not supported.  The output is
+//      written to a temporary file that replaces file out only once
+//      the conversion has succeeded.
+//
+//      If s is not 0, *s is filled with statistics about the
+//      conversion.
+//
+//      Parts that are converted to DWAA or DWAB are compressed at
+//      level l if l is not negative.  Otherwise they keep the level
+//      in the dwaCompressionLevel attribute of the input part, if
+//      there is one, or they use the default level (see
+//      exr_set_default_dwa_compression_quality()).  The level that
+//      is used is stored in the dwaCompressionLevel attribute of
+//      the output part.
+//
+
+IMFUTIL_EXPORT
+void recompressFile (
+    const char*      inFileName,
+    const char*      outFileName,
+    Compression      compression,
+    RecompressStats* stats               = 0,
+    float            dwaCompressionLevel = -1);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,733 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      class SequenceReader
+//
+//----------------------------------------------------------------------------
+
+#include "ImfSequenceReader.h"
+#include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfThreading.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+using ILMTHREAD_NAMESPACE::TASK_PRIORITY_BACKGROUND;
+using ILMTHREAD_NAMESPACE::TASK_PRIORITY_INTERACTIVE;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+typedef chrono::steady_clock Clock;
+
+double
+secondsBetween (Clock::time_point start, Clock::time_point end)
+{
+    return chrono::duration<double> (end - start).count ();
+}
+
+//
+// Weight of the newest measurement in the running averages of the
+// frame read time and the frame period.
+//
+
+const double AVERAGE_WEIGHT = 0.25;
+
+void
+addToAverage (double& average, double value)
+{
+    if (average == 0)
+        average = value;
+    else
+        average += AVERAGE_WEIGHT * (value - average);
+}
+
+//
+// A frame that is being read ahead, or the current frame.
+//
+
+struct Frame
+{
+    enum State
+    {
+        QUEUED,  // waiting for the loader thread
+        OPENING, // being opened by the loader thread
+        OPEN
+    };
+
+    Frame (int number, const string& fileName);
+
+    int               number;
+    string            fileName;
+    InputFile*        file;
+    FlatImage*        image;
+    State             state;  // guarded by SequenceReader::Data::loaderMutex
+    exception_ptr     error;  // opening the file failed
+    future<void>      pixels; // ready once the pixels have been read
+    atomic<int>       linesLeft;
+    Clock::time_point queued;
+    Clock::time_point finished; // when the last scan line was read
+    bool              done;     // pixels have been waited for
+};
+
+Frame::Frame (int number, const string& fileName)
+    : number (number)
+    , fileName (fileName)
+    , file (0)
+    , image (0)
+    , state (OPEN)
+    , linesLeft (0)
+    , queued (Clock::now ())
+    , done (false)
+{
+    // empty
+}
+
+//
+// Returns the name of the file of frame number in a sequence whose
+// files are named according to pattern (see ImfSequenceReader.h).
+//
+
+string
+formatFrameFileName (const string& pattern, int number)
+{
+    char   buf[32];
+    size_t begin;
+    size_t end;
+
+    size_t percent = pattern.find ('%');
+
+    if (percent != string::npos)
+    {
+        //
+        // %d or %0Nd
+        //
+
+        bool zeroPad = false;
+        int  width   = 0;
+
+        end = percent + 1;
+
+        if (end < pattern.size () && pattern[end] == '0')
+        {
+            zeroPad = true;
+            ++end;
+        }
+
+        while (end < pattern.size () && pattern[end] >= '0' &&
+               pattern[end] <= '9' && width < 16)
+        {
+            width = width * 10 + (pattern[end] - '0');
+            ++end;
+        }
+
+        if (end >= pattern.size () || pattern[end] != 'd')
+            THROW (
+                ArgExc,
+                "Invalid frame number format in frame pattern \""
+                    << pattern << "\".");
+
+        begin = percent;
+        ++end;
+
+        snprintf (buf, sizeof (buf), zeroPad ? "%0*d" : "%*d", width, number);
+    }
+    else
+    {
+        //
+        // A run of '#' characters; the last one, if there are several.
+        //
+
+        size_t last = pattern.rfind ('#');
+
+        if (last == string::npos)
+            THROW (
+                ArgExc,
+                "Frame pattern \"" << pattern
+                                   << "\" contains no frame number "
+                                      "(%d or #).");
+
+        begin = last;
+
+        while (begin > 0 && pattern[begin - 1] == '#')
+            --begin;
+
+        end = last + 1;
+
+        int width = int (min (end - begin, size_t (16)));
+        snprintf (buf, sizeof (buf), "%0*d", width, number);
+    }
+
+    return pattern.substr (0, begin) + buf + pattern.substr (end);
+}
+
+//
+// Returns true if image img has data window dw and exactly the
+// channels in channel list cl.
+//
+
+bool
+sameLayout (const FlatImage& img, const Box2i& dw, const ChannelList& cl)
+{
+    if (img.dataWindow () != dw) return false;
+
+    const FlatImageLevel& level = img.level ();
+    int                   n     = 0;
+
+    for (ChannelList::ConstIterator i = cl.begin (); i != cl.end (); ++i, ++n)
+    {
+        const FlatImageChannel* c = level.findChannel (i.name ());
+
+        if (!c || !(c->channel () == i.channel ())) return false;
+    }
+
+    for (FlatImageLevel::ConstIterator i = level.begin (); i != level.end ();
+         ++i)
+    {
+        --n;
+    }
+
+    return n == 0;
+}
+
+} // namespace
+
+struct SequenceReader::Data
+{
+    Data (const string& framePattern, int firstFrame, int lastFrame);
+    ~Data ();
+
+    FlatImage* newImage (const Header& header);
+    void       openFrame (Frame* frame, int priority);
+    void       waitUntilOpen (Frame* frame, bool openNow);
+    void       waitForFrame (Frame* frame);
+    void       releaseFrame (Frame* frame);
+    void       readAheadFrom (int number);
+    void       runLoader ();
+
+    string    framePattern;
+    int       firstFrame;
+    int       lastFrame;
+    Direction direction;
+    int       minReadAhead;
+    int       maxReadAhead;
+    int       readAhead;
+
+    double            readTime; // running averages, in seconds
+    double            period;
+    int               lastNumber; // last frame returned by frame()
+    Clock::time_point lastCall;
+
+    Frame*             current;
+    map<int, Frame*>   ahead; // frames being read ahead, by number
+    mutex              spareMutex;
+    vector<FlatImage*> spare; // images of released frames
+
+    //
+    // The frames that are read ahead are opened by a thread of their
+    // own, the loader, rather than by tasks in the global thread pool:
+    // opening a file and starting to read it can block until tasks
+    // in the pool have finished, for example for tiled and deep files,
+    // whose pixels are read before readPixelsAsync() returns.
+    //
+
+    thread             loader;
+    mutex              loaderMutex;
+    condition_variable loaderCond;
+    deque<Frame*>      toOpen; // frames in state QUEUED, oldest first
+    bool               stopLoader;
+};
+
+SequenceReader::Data::Data (
+    const string& framePattern, int firstFrame, int lastFrame)
+    : framePattern (framePattern)
+    , firstFrame (firstFrame)
+    , lastFrame (lastFrame)
+    , direction (FORWARD)
+    , minReadAhead (1)
+    , maxReadAhead (8)
+    , readAhead (1)
+    , readTime (0)
+    , period (0)
+    , lastNumber (0)
+    , current (0)
+    , stopLoader (false)
+{
+    // empty
+}
+
+SequenceReader::Data::~Data ()
+{
+    if (loader.joinable ())
+    {
+        {
+            lock_guard<mutex> lock (loaderMutex);
+            stopLoader = true;
+        }
+
+        loaderCond.notify_all ();
+        loader.join ();
+    }
+
+    for (map<int, Frame*>::iterator i = ahead.begin (); i != ahead.end (); ++i)
+        releaseFrame (i->second);
+
+    if (current) releaseFrame (current);
+
+    for (size_t i = 0; i < spare.size (); ++i)
+        delete spare[i];
+}
+
+//
+// Returns an image with the data window and channels of a header,
+// reusing the image of a released frame if one matches.
+//
+
+FlatImage*
+SequenceReader::Data::newImage (const Header& header)
+{
+    const Box2i&       dw = header.dataWindow ();
+    const ChannelList& cl = header.channels ();
+
+    {
+        lock_guard<mutex> lock (spareMutex);
+
+        for (size_t i = 0; i < spare.size (); ++i)
+        {
+            if (sameLayout (*spare[i], dw, cl))
+            {
+                FlatImage* img = spare[i];
+                spare.erase (spare.begin () + i);
+                return img;
+            }
+        }
+    }
+
+    FlatImage* img = new FlatImage;
+
+    for (ChannelList::ConstIterator i = cl.begin (); i != cl.end (); ++i)
+        img->insertChannel (i.name (), i.channel ());
+
+    img->resize (dw, ONE_LEVEL, ROUND_DOWN);
+    return img;
+}
+
+//
+// Opens the file of a frame and starts reading its pixels.  Called by
+// the loader thread for a frame that is read ahead, or by frame() for
+// a frame that has not been read ahead.
+//
+
+void
+SequenceReader::Data::openFrame (Frame* frame, int priority)
+{
+    try
+    {
+        frame->file =
+            new InputFile (frame->fileName.c_str (), globalThreadCount ());
+
+        frame->file->setTaskPriority (priority);
+
+        const Header& header = frame->file->header ();
+        const Box2i&  dw     = header.dataWindow ();
+
+        frame->image     = newImage (header);
+        frame->linesLeft = dw.max.y - dw.min.y + 1;
+
+        FlatImageLevel& level = frame->image->level ();
+        FrameBuffer     fb;
+
+        for (FlatImageLevel::ConstIterator i = level.begin ();
+             i != level.end ();
+             ++i)
+            fb.insert (i.name (), i.channel ().slice ());
+
+        frame->file->setFrameBuffer (fb);
+
+        frame->pixels = frame->file->readPixelsAsync (
+            dw.min.y, dw.max.y, [frame] (int scanLineMin, int scanLineMax) {
+                int n = scanLineMax - scanLineMin + 1;
+                if (frame->linesLeft.fetch_sub (n) == n)
+                    frame->finished = Clock::now ();
+            });
+    }
+    catch (...)
+    {
+        frame->error = current_exception ();
+    }
+}
+
+//
+// Waits until the loader thread has opened a frame.  If the loader
+// has not started on the frame yet, the frame is taken off its queue,
+// and, if openNow is true, opened by the calling thread.
+//
+
+void
+SequenceReader::Data::waitUntilOpen (Frame* frame, bool openNow)
+{
+    {
+        unique_lock<mutex> lock (loaderMutex);
+
+        if (frame->state != Frame::QUEUED)
+        {
+            while (frame->state != Frame::OPEN)
+                loaderCond.wait (lock);
+
+            return;
+        }
+
+        toOpen.erase (find (toOpen.begin (), toOpen.end (), frame));
+        frame->state = Frame::OPEN;
+    }
+
+    if (openNow) openFrame (frame, TASK_PRIORITY_INTERACTIVE);
+}
+
+//
+// Waits until the pixels of a frame have been read, rethrowing the
+// error if reading failed, and updates the average read time.
+//
+
+void
+SequenceReader::Data::waitForFrame (Frame* frame)
+{
+    if (frame->done)
+    {
+        if (frame->error) rethrow_exception (frame->error);
+        return;
+    }
+
+    waitUntilOpen (frame, true);
+
+    frame->done = true;
+
+    if (frame->error) rethrow_exception (frame->error);
+
+    try
+    {
+        frame->pixels.get ();
+    }
+    catch (...)
+    {
+        frame->error = current_exception ();
+        throw;
+    }
+
+    addToAverage (readTime, secondsBetween (frame->queued, frame->finished));
+}
+
+//
+// Deletes a frame, waiting for it to be read if necessary, and keeps
+// its image for reuse.
+//
+
+void
+SequenceReader::Data::releaseFrame (Frame* frame)
+{
+    waitUntilOpen (frame, false);
+
+    //
+    // The destructor of the file waits for the pixels.
+    //
+
+    delete frame->file;
+
+    if (frame->image)
+    {
+        lock_guard<mutex> lock (spareMutex);
+        spare.push_back (frame->image);
+
+        //
+        // Keep enough images for a full read-ahead window.
+        //
+
+        if (spare.size () > size_t (maxReadAhead + 1))
+        {
+            delete spare.front ();
+            spare.erase (spare.begin ());
+        }
+    }
+
+    delete frame;
+}
+
+//
+// The loader thread: opens the queued frames, oldest first.
+//
+
+void
+SequenceReader::Data::runLoader ()
+{
+    unique_lock<mutex> lock (loaderMutex);
+
+    while (true)
+    {
+        while (toOpen.empty () && !stopLoader)
+            loaderCond.wait (lock);
+
+        if (stopLoader) return;
+
+        Frame* frame = toOpen.front ();
+        toOpen.pop_front ();
+        frame->state = Frame::OPENING;
+
+        lock.unlock ();
+        openFrame (frame, TASK_PRIORITY_BACKGROUND);
+        lock.lock ();
+
+        frame->state = Frame::OPEN;
+        loaderCond.notify_all ();
+    }
+}
+
+//
+// Drops the frames that are read ahead but are no longer within the
+// window that follows frame number, and queues the frames of the
+// window that are not being read yet.
+//
+
+void
+SequenceReader::Data::readAheadFrom (int number)
+{
+    int step = direction == FORWARD ? 1 : -1;
+    int n    = readAhead;
+
+    if (ThreadPool::globalThreadPool ().numThreads () == 0) n = 0;
+
+    for (map<int, Frame*>::iterator i = ahead.begin (); i != ahead.end ();)
+    {
+        int distance = (i->first - number) * step;
+
+        if (distance < 1 || distance > n)
+        {
+            releaseFrame (i->second);
+            ahead.erase (i++);
+        }
+        else
+            ++i;
+    }
+
+    for (int i = 1; i <= n; ++i)
+    {
+        int f = number + i * step;
+
+        if (f < firstFrame || f > lastFrame) break;
+
+        if (ahead.find (f) != ahead.end ()) continue;
+
+        Frame* frame = new Frame (f, formatFrameFileName (framePattern, f));
+        frame->state = Frame::QUEUED;
+        ahead[f]     = frame;
+
+        {
+            lock_guard<mutex> lock (loaderMutex);
+            toOpen.push_back (frame);
+        }
+
+        if (!loader.joinable ()) loader = thread (&Data::runLoader, this);
+
+        loaderCond.notify_all ();
+    }
+}
+
+SequenceReader::SequenceReader (
+    const string& framePattern, int firstFrame, int lastFrame)
+    : _data (0)
+{
+    if (firstFrame > lastFrame)
+        THROW (
+            ArgExc,
+            "Invalid frame range " << firstFrame << " to " << lastFrame
+                                   << ".");
+
+    formatFrameFileName (framePattern, firstFrame);
+
+    _data = new Data (framePattern, firstFrame, lastFrame);
+}
+
+SequenceReader::~SequenceReader ()
+{
+    delete _data;
+}
+
+int
+SequenceReader::firstFrame () const
+{
+    return _data->firstFrame;
+}
+
+int
+SequenceReader::lastFrame () const
+{
+    return _data->lastFrame;
+}
+
+string
+SequenceReader::frameFileName (int frameNumber) const
+{
+    return formatFrameFileName (_data->framePattern, frameNumber);
+}
+
+void
+SequenceReader::setDirection (Direction direction)
+{
+    _data->direction = direction;
+}
+
+SequenceReader::Direction
+SequenceReader::direction () const
+{
+    return _data->direction;
+}
+
+void
+SequenceReader::setReadAheadLimits (int minFrames, int maxFrames)
+{
+    if (minFrames < 0 || maxFrames < minFrames)
+        THROW (
+            ArgExc,
+            "Invalid read-ahead limits " << minFrames << " and " << maxFrames
+                                         << ".");
+
+    _data->minReadAhead = minFrames;
+    _data->maxReadAhead = maxFrames;
+    _data->readAhead    = max (minFrames, min (_data->readAhead, maxFrames));
+}
+
+int
+SequenceReader::minReadAhead () const
+{
+    return _data->minReadAhead;
+}
+
+int
+SequenceReader::maxReadAhead () const
+{
+    return _data->maxReadAhead;
+}
+
+int
+SequenceReader::readAhead () const
+{
+    return _data->readAhead;
+}
+
+double
+SequenceReader::frameReadTime () const
+{
+    return _data->readTime;
+}
+
+double
+SequenceReader::framePeriod () const
+{
+    return _data->period;
+}
+
+const FlatImage&
+SequenceReader::frame (int frameNumber)
+{
+    if (frameNumber < _data->firstFrame || frameNumber > _data->lastFrame)
+        THROW (
+            ArgExc,
+            "Frame " << frameNumber << " is not in the sequence ("
+                     << _data->firstFrame << " to " << _data->lastFrame
+                     << ").");
+
+    Clock::time_point now  = Clock::now ();
+    int               step = _data->direction == FORWARD ? 1 : -1;
+
+    if (_data->current && frameNumber == _data->lastNumber + step)
+        addToAverage (_data->period, secondsBetween (_data->lastCall, now));
+
+    _data->lastNumber = frameNumber;
+    _data->lastCall   = now;
+
+    if (!_data->current || _data->current->number != frameNumber)
+    {
+        if (_data->current)
+        {
+            _data->releaseFrame (_data->current);
+            _data->current = 0;
+        }
+
+        map<int, Frame*>::iterator i = _data->ahead.find (frameNumber);
+
+        if (i != _data->ahead.end ())
+        {
+            _data->current = i->second;
+            _data->ahead.erase (i);
+        }
+        else
+        {
+            //
+            // The frame has not been read ahead; its tasks go ahead
+            // of those of the frames that are.
+            //
+
+            _data->current = new Frame (
+                frameNumber,
+                formatFrameFileName (_data->framePattern, frameNumber));
+
+            _data->openFrame (_data->current, TASK_PRIORITY_INTERACTIVE);
+        }
+    }
+
+    _data->waitForFrame (_data->current);
+
+    //
+    // Read far enough ahead to cover the time it takes to read a
+    // frame, plus one frame.
+    //
+
+    if (_data->readTime > 0 && _data->period > 0)
+    {
+        int n = int (ceil (_data->readTime / _data->period)) + 1;
+
+        _data->readAhead =
+            max (_data->minReadAhead, min (n, _data->maxReadAhead));
+    }
+
+    _data->readAheadFrom (frameNumber);
+
+    return *_data->current->image;
+}
+
+const Header&
+SequenceReader::header () const
+{
+    if (!_data->current || !_data->current->file || !_data->current->done ||
+        _data->current->error)
+        throw ArgExc ("No frame has been read.");
+
+    return _data->current->file->header ();
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
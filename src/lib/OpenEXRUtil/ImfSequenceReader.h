@@ -0,0 +1,167 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_SEQUENCE_READER_H
+#define INCLUDED_IMF_SEQUENCE_READER_H
+
+//----------------------------------------------------------------------------
+//
+//      class SequenceReader
+//
+//      Reads the frames of an image sequence for playback, keeping a
+//      window of frames ahead of the current frame open and decoding
+//      in the background.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfFlatImage.h"
+#include "ImfForward.h"
+#include "ImfNamespace.h"
+#include "ImfUtilExport.h"
+
+#include <string>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMFUTIL_EXPORT_TYPE SequenceReader
+{
+public:
+    enum Direction
+    {
+        FORWARD,
+        BACKWARD
+    };
+
+    //------------------------------------------------------------
+    // Constructor:
+    //
+    // framePattern is the name of the frame files, with the frame
+    // number replaced either by a printf-style %d or %0Nd, or by
+    // a run of N '#' characters, which stands for a number that
+    // is padded with zeroes to N digits, for example
+    // "plate.%04d.exr" or "plate.####.exr".  The sequence consists
+    // of frames firstFrame to lastFrame, inclusive.  No files are
+    // opened until the first call to frame().
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    SequenceReader (
+        const std::string& framePattern, int firstFrame, int lastFrame);
+
+    //------------------------------------------------------------
+    // Destructor: waits for the frames that are still being read
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    virtual ~SequenceReader ();
+
+    IMFUTIL_EXPORT
+    int firstFrame () const;
+
+    IMFUTIL_EXPORT
+    int lastFrame () const;
+
+    //------------------------------------------------------------
+    // The name of the file that holds a given frame
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    std::string frameFileName (int frameNumber) const;
+
+    //------------------------------------------------------------
+    // Playback direction:
+    //
+    // The frames that are read ahead are the frames that follow
+    // the current frame in the playback direction, FORWARD by
+    // default.  The frames on the other side of the current frame
+    // are dropped when the direction changes.
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    void setDirection (Direction direction);
+
+    IMFUTIL_EXPORT
+    Direction direction () const;
+
+    //------------------------------------------------------------
+    // Read-ahead:
+    //
+    // While the current frame is shown, up to readAhead() frames
+    // after it are opened by a background thread that belongs to
+    // the SequenceReader, and their pixels are read and decoded
+    // by tasks in the global thread pool (see ImfThreading.h),
+    // with priority IlmThread::TASK_PRIORITY_BACKGROUND.
+    //
+    // readAhead() adapts to the playback: it is the time from
+    // queueing a frame to having its pixels, divided by the time
+    // between successive calls to frame(), both averaged over the
+    // last few frames, plus one.  It is kept within the limits
+    // set with setReadAheadLimits(), by default 1 and 8 frames.
+    // If the global thread pool has no threads, no frames are read
+    // ahead.
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    void setReadAheadLimits (int minFrames, int maxFrames);
+
+    IMFUTIL_EXPORT
+    int minReadAhead () const;
+
+    IMFUTIL_EXPORT
+    int maxReadAhead () const;
+
+    IMFUTIL_EXPORT
+    int readAhead () const;
+
+    //------------------------------------------------------------
+    // The measurements that readAhead() is based on, in seconds:
+    // the average time from queueing a frame to having its pixels,
+    // and the average time between calls to frame() for successive
+    // frames.  Both are 0 until they have been measured.
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    double frameReadTime () const;
+
+    IMFUTIL_EXPORT
+    double framePeriod () const;
+
+    //------------------------------------------------------------
+    // Access to the frames:
+    //
+    // frame(f) makes f the current frame, and returns its pixels.
+    // If f has not been read ahead, it is read before frame()
+    // returns, with priority IlmThread::TASK_PRIORITY_INTERACTIVE.
+    // All channels of the frame's data window are read; tiled files
+    // are read at level (0, 0).
+    //
+    // The returned image, and the header returned by header(), stay
+    // valid until the next call to frame().  Their memory is then
+    // reused for frames that have the same data window and channels.
+    //
+    // Errors, for example a missing frame file, are thrown by the
+    // call to frame() for that frame.
+    //------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    const FlatImage& frame (int frameNumber);
+
+    IMFUTIL_EXPORT
+    const Header& header () const;
+
+    struct IMFUTIL_HIDDEN Data;
+
+private:
+    SequenceReader (const SequenceReader&)            = delete;
+    SequenceReader& operator= (const SequenceReader&) = delete;
+    SequenceReader (SequenceReader&&)                 = delete;
+    SequenceReader& operator= (SequenceReader&&)      = delete;
+
+    Data* _data;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,384 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      Replacement of the headers of OpenEXR files, either in place
+//      or by copying the chunks of pixel data verbatim.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfUpdateHeaders.h"
+#include <Iex.h>
+#include <ImfHeader.h>
+#include <ImfMisc.h>
+#include <ImfPartType.h>
+#include <ImfStdIO.h>
+#include <ImfVersion.h>
+#include <ImfXdr.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// Attributes that determine the number, the order and the contents
+// of the chunks of a part.
+//
+
+const char* layoutAttributes[] = {
+    "channels",
+    "chunkCount",
+    "compression",
+    "dataWindow",
+    "lineOrder",
+    "tiles",
+    "type",
+    "version"};
+
+//
+// The headers of a file as they are stored in the file, without
+// the type that MultiPartInputFile invents for single-part files.
+//
+
+struct FileHeaders
+{
+    int            version;
+    uint64_t       size; // magic number, version field and headers
+    vector<Header> headers;
+    vector<int>    chunkCounts;
+};
+
+void
+openStream (fstream& f, const char fileName[], ios_base::openmode mode)
+{
+#ifdef _WIN32
+    f.open (WidenFilename (fileName).c_str (), mode | ios_base::binary);
+#else
+    f.open (fileName, mode | ios_base::binary);
+#endif
+
+    if (!f) THROW_ERRNO ("Cannot open file \"" << fileName << "\" (%T).");
+}
+
+void
+readFileHeaders (const char fileName[], FileHeaders& file)
+{
+    StdIFStream is (fileName);
+    int         magic;
+
+    Xdr::read<StreamIO> (is, magic);
+    Xdr::read<StreamIO> (is, file.version);
+
+    if (magic != MAGIC)
+        THROW (InputExc, "File \"" << fileName << "\" is not an image file.");
+
+    if (getVersion (file.version) != EXR_VERSION ||
+        !supportsFlags (getFlags (file.version)))
+    {
+        THROW (
+            InputExc,
+            "Cannot read file \"" << fileName
+                                  << "\". Unsupported file format version.");
+    }
+
+    bool multiPart = isMultiPart (file.version);
+
+    while (true)
+    {
+        Header header;
+        header.readFrom (is, file.version);
+
+        if (header.readsNothing ()) break;
+
+        file.headers.push_back (header);
+
+        if (!multiPart) break;
+    }
+
+    if (file.headers.empty ())
+        THROW (InputExc, "File \"" << fileName << "\" contains no headers.");
+
+    file.size = is.tellg ();
+
+    for (size_t i = 0; i < file.headers.size (); ++i)
+    {
+        Header header = file.headers[i];
+
+        if (!header.hasType ())
+            header.setType (
+                isTiled (file.version) ? TILEDIMAGE : SCANLINEIMAGE);
+
+        file.chunkCounts.push_back (getChunkOffsetTableSize (header));
+    }
+}
+
+string
+valueBytes (const Attribute& attr)
+{
+    StdOSStream os;
+    attr.writeValueTo (os, EXR_VERSION);
+    return os.str ();
+}
+
+void
+checkLayout (
+    const char    fileName[],
+    int           part,
+    const Header& oldHeader,
+    const Header& newHeader,
+    bool          checkType)
+{
+    for (size_t i = 0; i < sizeof (layoutAttributes) / sizeof (char*); ++i)
+    {
+        const char* name = layoutAttributes[i];
+
+        if (!checkType && !strcmp (name, "type")) continue;
+
+        Header::ConstIterator o = oldHeader.find (name);
+        Header::ConstIterator n = newHeader.find (name);
+
+        if (o == oldHeader.end () && n == newHeader.end ()) continue;
+
+        if (o != oldHeader.end () && n != newHeader.end () &&
+            !strcmp (o.attribute ().typeName (), n.attribute ().typeName ()) &&
+            valueBytes (o.attribute ()) == valueBytes (n.attribute ()))
+        {
+            continue;
+        }
+
+        THROW (
+            ArgExc,
+            "Cannot update the headers of file \""
+                << fileName << "\". The " << name << " attribute of part "
+                << part << " cannot change without rewriting the pixel data.");
+    }
+}
+
+//
+// The checks that MultiPartOutputFile applies to the headers of a
+// new file.  Of the attributes that must be the same in all parts
+// of a multi-part file, MultiPartInputFile insists on the display
+// window and the pixel aspect ratio.
+//
+
+void
+checkHeaders (const char fileName[], vector<Header>& headers, bool multiPart)
+{
+    for (size_t i = 0; i < headers.size (); ++i)
+    {
+        headers[i].sanityCheck (headers[i].hasTileDescription (), multiPart);
+
+        if (headers[i].displayWindow () != headers[0].displayWindow () ||
+            headers[i].pixelAspectRatio () != headers[0].pixelAspectRatio ())
+        {
+            THROW (
+                ArgExc,
+                "Cannot update the headers of file \""
+                    << fileName << "\". The display window and the pixel "
+                    << "aspect ratio of part " << i
+                    << " differ from those of part 0.");
+        }
+    }
+}
+
+//
+// Serialize the magic number, the version field and the headers,
+// the way MultiPartOutputFile writes them.
+//
+
+string
+headerBytes (int version, const vector<Header>& headers)
+{
+    for (size_t i = 0; i < headers.size (); ++i)
+        if (usesLongNames (headers[i])) version |= LONG_NAMES_FLAG;
+
+    StdOSStream os;
+    Xdr::write<StreamIO> (os, MAGIC);
+    Xdr::write<StreamIO> (os, version);
+
+    for (size_t i = 0; i < headers.size (); ++i)
+        headers[i].writeTo (os);
+
+    if (isMultiPart (version)) Xdr::write<StreamIO> (os, "");
+
+    return os.str ();
+}
+
+void
+writeInPlace (const char fileName[], const string& bytes)
+{
+    fstream f;
+    openStream (f, fileName, ios_base::in | ios_base::out);
+
+    f.write (bytes.data (), bytes.size ());
+    f.flush ();
+
+    if (!f) THROW_ERRNO ("Cannot write file \"" << fileName << "\" (%T).");
+}
+
+void
+copyWithHeaders (
+    const char         inFileName[],
+    const char         outFileName[],
+    const FileHeaders& file,
+    const string&      bytes)
+{
+    fstream in;
+    fstream out;
+    openStream (in, inFileName, ios_base::in);
+    openStream (out, outFileName, ios_base::out | ios_base::trunc);
+
+    out.write (bytes.data (), bytes.size ());
+
+    //
+    // The chunks move by the difference in the size of the headers.
+    // Offsets of zero (chunks missing from an incomplete file) and
+    // other offsets that do not point past the tables are kept.
+    //
+
+    size_t numChunks = 0;
+
+    for (size_t i = 0; i < file.chunkCounts.size (); ++i)
+        numChunks += file.chunkCounts[i];
+
+    vector<char> tables (numChunks * sizeof (uint64_t));
+    uint64_t     tablesEnd = file.size + tables.size ();
+    int64_t      shift     = int64_t (bytes.size ()) - int64_t (file.size);
+
+    in.seekg (file.size);
+    in.read (tables.data (), tables.size ());
+
+    if (!in)
+        THROW (
+            InputExc,
+            "Cannot read the chunk offset tables of file \"" << inFileName
+                                                             << "\".");
+
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        const char* readPtr = &tables[i * sizeof (uint64_t)];
+        uint64_t    offset;
+
+        Xdr::read<CharPtrIO> (readPtr, offset);
+
+        if (offset >= tablesEnd) offset += shift;
+
+        char* writePtr = &tables[i * sizeof (uint64_t)];
+        Xdr::write<CharPtrIO> (writePtr, offset);
+    }
+
+    out.write (tables.data (), tables.size ());
+
+    vector<char> buffer (4 << 20);
+
+    while (in)
+    {
+        in.read (buffer.data (), buffer.size ());
+        out.write (buffer.data (), in.gcount ());
+    }
+
+    out.flush ();
+
+    if (!out) THROW_ERRNO ("Cannot write file \"" << outFileName << "\" (%T).");
+}
+
+} // namespace
+
+bool
+updateFileHeaders (
+    const char    inFileName[],
+    const char    outFileName[],
+    const Header* headers,
+    int           numParts)
+{
+    FileHeaders file;
+    readFileHeaders (inFileName, file);
+
+    if (numParts != int (file.headers.size ()))
+        THROW (
+            ArgExc,
+            "Cannot update the headers of file \""
+                << inFileName << "\". " << numParts
+                << " headers were given, but the file has "
+                << file.headers.size () << " parts.");
+
+    //
+    // The type of a single-part image is defined by the version field;
+    // MultiPartInputFile and MultiPartOutputFile add or correct the
+    // type attribute to match it.
+    //
+
+    bool singlePartImage =
+        !isMultiPart (file.version) && !isNonImage (file.version);
+
+    vector<Header> newHeaders (headers, headers + numParts);
+    vector<Header> storedHeaders (headers, headers + numParts);
+
+    for (int p = 0; p < numParts; ++p)
+    {
+        checkLayout (
+            inFileName, p, file.headers[p], newHeaders[p], !singlePartImage);
+
+        if (!singlePartImage) continue;
+
+        newHeaders[p].setType (
+            isTiled (file.version) ? TILEDIMAGE : SCANLINEIMAGE);
+
+        if (file.headers[p].hasType ())
+            storedHeaders[p].setType (file.headers[p].type ());
+        else
+            storedHeaders[p].erase ("type");
+    }
+
+    checkHeaders (inFileName, newHeaders, isMultiPart (file.version));
+
+    if (!strcmp (inFileName, outFileName))
+    {
+        string bytes = headerBytes (file.version, storedHeaders);
+
+        if (bytes.size () == file.size)
+        {
+            writeInPlace (inFileName, bytes);
+            return true;
+        }
+    }
+
+    string tmpFileName = string (outFileName) + ".tmp";
+
+    try
+    {
+        copyWithHeaders (
+            inFileName,
+            tmpFileName.c_str (),
+            file,
+            headerBytes (file.version, newHeaders));
+    }
+    catch (...)
+    {
+        remove (tmpFileName.c_str ());
+        throw;
+    }
+
+    remove (outFileName);
+    if (rename (tmpFileName.c_str (), outFileName))
+        THROW_ERRNO (
+            "Cannot rename " << tmpFileName << " to " << outFileName
+                             << " (%T).");
+
+    return false;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,62 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_UPDATE_HEADERS_H
+#define INCLUDED_IMF_UPDATE_HEADERS_H
+
+//----------------------------------------------------------------------------
+//
+//      function updateFileHeaders()
+//
+//      Replaces the headers of an OpenEXR file without decompressing
+//      or recompressing its pixel data.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+#include "ImfNamespace.h"
+#include "ImfUtilExport.h"
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// updateFileHeaders (inFileName, outFileName, headers, numParts)
+//
+//      Stores a copy of OpenEXR file inFileName, with its headers
+//      replaced by headers[0] ... headers[numParts-1], in file
+//      outFileName.  The new headers are typically copies of the
+//      headers of the input file (see MultiPartInputFile::header())
+//      with some attributes added or changed.  numParts must be equal
+//      to the number of parts in the input file, and the attributes
+//      that define the chunks of a part (channels, compression,
+//      dataWindow, lineOrder, tiles, type, chunkCount and version)
+//      must not change.  The new headers must also pass the checks
+//      that MultiPartOutputFile applies to the headers of a new file;
+//      otherwise an ArgExc is thrown.
+//
+//      If inFileName and outFileName are the same file, and the new
+//      headers take up exactly as many bytes as the old ones, the old
+//      headers are overwritten in place, and updateFileHeaders()
+//      returns true.  (A single-part file without a type attribute
+//      keeps it that way, since the type is implied by the file's
+//      version field.)
+//
+//      Otherwise the new headers are written to a temporary file,
+//      followed by the chunk offset tables, adjusted for the change
+//      in the size of the headers, and a byte-for-byte copy of the
+//      chunks of the input file.  The temporary file then replaces
+//      file outFileName, and updateFileHeaders() returns false.
+//
+
+IMFUTIL_EXPORT
+bool updateFileHeaders (
+    const char    inFileName[],
+    const char    outFileName[],
+    const Header* headers,
+    int           numParts);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,117 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_OPENEXR_BENCH_H
+#define INCLUDED_OPENEXR_BENCH_H
+
+#include <ImfCompression.h>
+#include <ImfPixelType.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+// The pixels of an image of the corpus, one plane of floats per
+// channel.  The planes are converted to the pixel type and channel
+// count of each benchmark case.
+//
+
+struct CorpusImage
+{
+    std::string                     name;
+    int                             width;
+    int                             height;
+    std::vector<std::vector<float>> planes;
+};
+
+enum Storage
+{
+    SCANLINE,
+    TILED,
+    DEEP
+};
+
+enum Api
+{
+    API_IMF,
+    API_CORE
+};
+
+struct BenchCase
+{
+    Api                                api;
+    Storage                            storage;
+    OPENEXR_IMF_NAMESPACE::Compression compression;
+    OPENEXR_IMF_NAMESPACE::PixelType   type;
+    int                                channels;
+    int                                threads;
+    int                                tileSize;
+};
+
+//
+// The pixels of a benchmark case, in the layout both APIs read and
+// write: one plane per channel, and for deep images a sample count
+// per pixel with the samples of each pixel stored contiguously.
+//
+
+struct BenchPixels
+{
+    OPENEXR_IMF_NAMESPACE::PixelType type;
+    int                              width;
+    int                              height;
+    std::vector<std::string>         names;
+    std::vector<std::vector<char>>   planes;
+
+    std::vector<unsigned int> sampleCounts;
+    std::vector<size_t>       sampleOffsets;
+    size_t                    totalSamples;
+
+    size_t sampleSize () const;
+    size_t rawBytes () const;
+};
+
+//
+// openSeconds is the part of decodeSeconds spent opening the file
+// and setting up the frame buffer, which dominates the decode time
+// of small images with many channels.
+//
+
+struct BenchResult
+{
+    double   encodeSeconds;
+    double   decodeSeconds;
+    double   openSeconds;
+    uint64_t fileBytes;
+    bool     exact;
+};
+
+void makeBenchPixels (
+    const CorpusImage& image, const BenchCase& bc, BenchPixels& pixels);
+
+bool samePixels (const BenchPixels& a, const BenchPixels& b);
+
+//
+// Encode the pixels into an in-memory file, and decode the file
+// again, through the C++ or the Core API.  Both return the best time
+// of the given number of iterations.  They throw on errors.
+//
+
+BenchResult runImf (
+    const BenchCase& bc, const BenchPixels& pixels, int iterations);
+
+BenchResult runCore (
+    const BenchCase& bc, const BenchPixels& pixels, int iterations);
+
+//
+// Corpus generators, and a loader for real images.
+//
+
+void makeSyntheticImage (
+    const std::string& kind, int width, int height, CorpusImage& image);
+
+void loadImage (const std::string& fileName, CorpusImage& image);
+
+#endif
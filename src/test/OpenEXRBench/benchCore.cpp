@@ -0,0 +1,547 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "bench.h"
+
+#include <IlmThreadPool.h>
+#include <openexr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string.h>
+
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+double
+secondsSince (steady_clock::time_point start)
+{
+    return duration<double> (steady_clock::now () - start).count ();
+}
+
+void
+check (exr_result_t rv, const char* what)
+{
+    if (rv != EXR_ERR_SUCCESS)
+        throw runtime_error (
+            string (what) + ": " + exr_get_default_error_message (rv));
+}
+
+//
+// The file is kept in memory, so that the benchmark measures the
+// library rather than the file system.
+//
+
+int64_t
+memRead (
+    exr_const_context_t,
+    void*    userdata,
+    void*    buffer,
+    uint64_t sz,
+    uint64_t offset,
+    exr_stream_error_func_ptr_t)
+{
+    const string& data = *static_cast<const string*> (userdata);
+
+    if (offset >= data.size ()) return 0;
+
+    uint64_t n = min (sz, uint64_t (data.size ()) - offset);
+    memcpy (buffer, data.data () + offset, n);
+    return int64_t (n);
+}
+
+int64_t
+memSize (exr_const_context_t, void* userdata)
+{
+    return int64_t (static_cast<const string*> (userdata)->size ());
+}
+
+int64_t
+memWrite (
+    exr_const_context_t,
+    void*       userdata,
+    const void* buffer,
+    uint64_t    sz,
+    uint64_t    offset,
+    exr_stream_error_func_ptr_t)
+{
+    string& data = *static_cast<string*> (userdata);
+
+    if (offset + sz > data.size ()) data.resize (offset + sz);
+
+    memcpy (&data[offset], buffer, sz);
+    return int64_t (sz);
+}
+
+void
+quietErrors (exr_const_context_t, int, const char*)
+{}
+
+//
+// A chunk is a block of scan lines, or a tile, in the order the
+// chunks are written.  x and y are the pixel coordinates of its
+// first pixel.
+//
+
+struct Chunk
+{
+    int x;
+    int y;
+    int tileX;
+    int tileY;
+};
+
+vector<Chunk>
+makeChunks (exr_const_context_t f, const BenchCase& bc, int w, int h)
+{
+    vector<Chunk> chunks;
+
+    if (bc.storage == TILED)
+    {
+        int nx = (w + bc.tileSize - 1) / bc.tileSize;
+        int ny = (h + bc.tileSize - 1) / bc.tileSize;
+
+        for (int ty = 0; ty < ny; ++ty)
+            for (int tx = 0; tx < nx; ++tx)
+                chunks.push_back ({tx * bc.tileSize, ty * bc.tileSize, tx, ty});
+    }
+    else
+    {
+        int32_t lines = 1;
+        check (
+            exr_get_scanlines_per_chunk (f, 0, &lines),
+            "exr_get_scanlines_per_chunk");
+
+        for (int y = 0; y < h; y += lines)
+            chunks.push_back ({0, y, 0, 0});
+    }
+
+    return chunks;
+}
+
+//
+// The plane of a channel of a pipeline, or null for a channel that
+// is not in the image.
+//
+
+const char*
+planeData (const BenchPixels& pixels, const char* name, size_t offset)
+{
+    for (size_t c = 0; c < pixels.names.size (); ++c)
+        if (pixels.names[c] == name) return pixels.planes[c].data () + offset;
+
+    return nullptr;
+}
+
+//
+// Encodes a chunk, without writing it: chunks must be written in
+// order, so the caller writes them once they are all compressed.
+//
+
+class EncodeTask : public Task
+{
+public:
+    EncodeTask (
+        TaskGroup*             group,
+        exr_context_t          f,
+        const BenchCase&       bc,
+        const BenchPixels&     pixels,
+        const Chunk&           chunk,
+        exr_encode_pipeline_t& encoder,
+        exr_result_t&          result)
+        : Task (group)
+        , _f (f)
+        , _bc (bc)
+        , _pixels (pixels)
+        , _chunk (chunk)
+        , _encoder (encoder)
+        , _result (result)
+    {}
+
+    void execute () override;
+
+private:
+    exr_context_t          _f;
+    const BenchCase&       _bc;
+    const BenchPixels&     _pixels;
+    const Chunk&           _chunk;
+    exr_encode_pipeline_t& _encoder;
+    exr_result_t&          _result;
+};
+
+void
+EncodeTask::execute ()
+{
+    exr_chunk_info_t cinfo;
+    exr_result_t     rv;
+
+    if (_bc.storage == TILED)
+        rv = exr_write_tile_chunk_info (
+            _f, 0, _chunk.tileX, _chunk.tileY, 0, 0, &cinfo);
+    else
+        rv = exr_write_scanline_chunk_info (_f, 0, _chunk.y, &cinfo);
+
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_encoding_initialize (_f, 0, &cinfo, &_encoder);
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        size_t ss     = _pixels.sampleSize ();
+        size_t offset = (size_t (_chunk.y) * _pixels.width + _chunk.x) * ss;
+
+        for (int c = 0; c < _encoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& ch = _encoder.channels[c];
+
+            const char* data = planeData (_pixels, ch.channel_name, offset);
+
+            if (!data)
+            {
+                rv = EXR_ERR_INVALID_ARGUMENT;
+                break;
+            }
+
+            ch.encode_from_ptr        = (const uint8_t*) data;
+            ch.user_pixel_stride      = int32_t (ss);
+            ch.user_line_stride       = int32_t (ss * _pixels.width);
+            ch.user_data_type         = ch.data_type;
+            ch.user_bytes_per_element = ch.bytes_per_element;
+        }
+
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_encoding_choose_default_routines (_f, 0, &_encoder);
+    }
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        _encoder.write_fn = nullptr;
+        rv                = exr_encoding_run (_f, 0, &_encoder);
+    }
+
+    _result = rv;
+}
+
+class DecodeTask : public Task
+{
+public:
+    DecodeTask (
+        TaskGroup*       group,
+        exr_context_t    f,
+        const BenchCase& bc,
+        BenchPixels&     pixels,
+        const Chunk&     chunk,
+        exr_result_t&    result)
+        : Task (group)
+        , _f (f)
+        , _bc (bc)
+        , _pixels (pixels)
+        , _chunk (chunk)
+        , _result (result)
+    {}
+
+    void execute () override;
+
+private:
+    exr_context_t    _f;
+    const BenchCase& _bc;
+    BenchPixels&     _pixels;
+    const Chunk&     _chunk;
+    exr_result_t&    _result;
+};
+
+void
+DecodeTask::execute ()
+{
+    exr_chunk_info_t      cinfo;
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    exr_result_t          rv;
+
+    if (_bc.storage == TILED)
+        rv = exr_read_tile_chunk_info (
+            _f, 0, _chunk.tileX, _chunk.tileY, 0, 0, &cinfo);
+    else
+        rv = exr_read_scanline_chunk_info (_f, 0, _chunk.y, &cinfo);
+
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_decoding_initialize (_f, 0, &cinfo, &decoder);
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        size_t ss     = _pixels.sampleSize ();
+        size_t offset = (size_t (_chunk.y) * _pixels.width + _chunk.x) * ss;
+
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& ch = decoder.channels[c];
+
+            const char* data = planeData (_pixels, ch.channel_name, offset);
+
+            if (!data)
+            {
+                rv = EXR_ERR_INVALID_ARGUMENT;
+                break;
+            }
+
+            ch.decode_to_ptr          = (uint8_t*) data;
+            ch.user_pixel_stride      = int32_t (ss);
+            ch.user_line_stride       = int32_t (ss * _pixels.width);
+            ch.user_data_type         = ch.data_type;
+            ch.user_bytes_per_element = ch.bytes_per_element;
+        }
+
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_decoding_choose_default_routines (_f, 0, &decoder);
+    }
+
+    if (rv == EXR_ERR_SUCCESS) rv = exr_decoding_run (_f, 0, &decoder);
+
+    exr_decoding_destroy (_f, &decoder);
+    _result = rv;
+}
+
+void
+encode (const BenchCase& bc, const BenchPixels& pixels, string& data)
+{
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    cinit.user_data        = &data;
+    cinit.write_fn         = &memWrite;
+    cinit.error_handler_fn = &quietErrors;
+
+    check (
+        exr_start_write (&f, "bench.exr", EXR_WRITE_FILE_DIRECTLY, &cinit),
+        "exr_start_write");
+
+    exr_result_t rv = EXR_ERR_SUCCESS;
+
+    try
+    {
+        int part;
+        check (
+            exr_add_part (
+                f,
+                "bench",
+                bc.storage == TILED ? EXR_STORAGE_TILED : EXR_STORAGE_SCANLINE,
+                &part),
+            "exr_add_part");
+        check (
+            exr_initialize_required_attr_simple (
+                f,
+                part,
+                pixels.width,
+                pixels.height,
+                exr_compression_t (bc.compression)),
+            "exr_initialize_required_attr_simple");
+
+        for (size_t c = 0; c < pixels.names.size (); ++c)
+            check (
+                exr_add_channel (
+                    f,
+                    part,
+                    pixels.names[c].c_str (),
+                    exr_pixel_type_t (pixels.type),
+                    EXR_PERCEPTUALLY_LOGARITHMIC,
+                    1,
+                    1),
+                "exr_add_channel");
+
+        //
+        // The Core library only lets chunks be encoded in parallel,
+        // in any order, if the line order is random.  The chunks are
+        // still written in increasing order.
+        //
+
+        check (
+            exr_set_lineorder (f, part, EXR_LINEORDER_RANDOM_Y),
+            "exr_set_lineorder");
+
+        if (bc.storage == TILED)
+            check (
+                exr_set_tile_descriptor (
+                    f,
+                    part,
+                    bc.tileSize,
+                    bc.tileSize,
+                    EXR_TILE_ONE_LEVEL,
+                    EXR_TILE_ROUND_DOWN),
+                "exr_set_tile_descriptor");
+
+        check (exr_write_header (f), "exr_write_header");
+
+        vector<Chunk> chunks =
+            makeChunks (f, bc, pixels.width, pixels.height);
+        vector<exr_encode_pipeline_t> encoders (chunks.size ());
+        vector<exr_result_t>          results (chunks.size ());
+
+        {
+            TaskGroup   group;
+            ThreadPool& pool = ThreadPool::globalThreadPool ();
+
+            for (size_t i = 0; i < chunks.size (); ++i)
+            {
+                pool.addTask (new EncodeTask (
+                    &group, f, bc, pixels, chunks[i], encoders[i], results[i]));
+            }
+        }
+
+        for (size_t i = 0; i < chunks.size (); ++i)
+        {
+            exr_encode_pipeline_t& e = encoders[i];
+
+            if (rv == EXR_ERR_SUCCESS) rv = results[i];
+
+            if (rv == EXR_ERR_SUCCESS && bc.storage == TILED)
+                rv = exr_write_tile_chunk (
+                    f,
+                    0,
+                    chunks[i].tileX,
+                    chunks[i].tileY,
+                    0,
+                    0,
+                    e.compressed_buffer,
+                    e.compressed_bytes);
+            else if (rv == EXR_ERR_SUCCESS)
+                rv = exr_write_scanline_chunk (
+                    f, 0, chunks[i].y, e.compressed_buffer, e.compressed_bytes);
+
+            exr_encoding_destroy (f, &e);
+        }
+    }
+    catch (...)
+    {
+        exr_finish (&f);
+        throw;
+    }
+
+    if (rv == EXR_ERR_SUCCESS)
+        rv = exr_finish (&f);
+    else
+        exr_finish (&f);
+
+    check (rv, "encoding");
+}
+
+//
+// Returns the time taken to open the file.  The Core library has no
+// frame buffer; the channels are looked up for each chunk.
+//
+
+double
+decode (const BenchCase& bc, const string& data, BenchPixels& pixels)
+{
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    cinit.user_data        = const_cast<string*> (&data);
+    cinit.read_fn          = &memRead;
+    cinit.size_fn          = &memSize;
+    cinit.error_handler_fn = &quietErrors;
+
+    auto start = steady_clock::now ();
+
+    check (exr_start_read (&f, "bench.exr", &cinit), "exr_start_read");
+
+    double       openSeconds = secondsSince (start);
+    exr_result_t rv          = EXR_ERR_SUCCESS;
+
+    try
+    {
+        vector<Chunk> chunks =
+            makeChunks (f, bc, pixels.width, pixels.height);
+        vector<exr_result_t> results (chunks.size ());
+
+        {
+            TaskGroup   group;
+            ThreadPool& pool = ThreadPool::globalThreadPool ();
+
+            for (size_t i = 0; i < chunks.size (); ++i)
+            {
+                pool.addTask (new DecodeTask (
+                    &group, f, bc, pixels, chunks[i], results[i]));
+            }
+        }
+
+        for (size_t i = 0; i < chunks.size () && rv == EXR_ERR_SUCCESS; ++i)
+            rv = results[i];
+    }
+    catch (...)
+    {
+        exr_finish (&f);
+        throw;
+    }
+
+    exr_finish (&f);
+    check (rv, "decoding");
+
+    return openSeconds;
+}
+
+} // namespace
+
+BenchResult
+runCore (const BenchCase& bc, const BenchPixels& pixels, int iterations)
+{
+    //
+    // The Core library has no packing routine for deep data, and no
+    // DWA codec, yet.
+    //
+
+    if (bc.storage == DEEP)
+        throw invalid_argument ("the Core API cannot encode deep images");
+
+    if (bc.compression == OPENEXR_IMF_NAMESPACE::DWAA_COMPRESSION ||
+        bc.compression == OPENEXR_IMF_NAMESPACE::DWAB_COMPRESSION)
+        throw invalid_argument ("the Core API has no DWA codec");
+
+    BenchResult result;
+    string      data;
+
+    result.encodeSeconds = 0;
+    result.decodeSeconds = 0;
+    result.openSeconds   = 0;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        string out;
+
+        auto start = steady_clock::now ();
+        encode (bc, pixels, out);
+        double seconds = secondsSince (start);
+
+        if (i == 0 || seconds < result.encodeSeconds)
+            result.encodeSeconds = seconds;
+
+        if (i == 0) data.swap (out);
+    }
+
+    result.fileBytes = data.size ();
+
+    BenchPixels decoded = pixels;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (size_t c = 0; c < decoded.planes.size (); ++c)
+            fill (decoded.planes[c].begin (), decoded.planes[c].end (), 0);
+
+        auto   start       = steady_clock::now ();
+        double openSeconds = decode (bc, data, decoded);
+        double seconds     = secondsSince (start);
+
+        if (i == 0 || seconds < result.decodeSeconds)
+            result.decodeSeconds = seconds;
+
+        if (i == 0 || openSeconds < result.openSeconds)
+            result.openSeconds = openSeconds;
+    }
+
+    result.exact = samePixels (pixels, decoded);
+    return result;
+}
@@ -0,0 +1,282 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "bench.h"
+
+#include <ImfChannelList.h>
+#include <ImfDeepFrameBuffer.h>
+#include <ImfDeepScanLineInputPart.h>
+#include <ImfDeepScanLineOutputFile.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfPartType.h>
+#include <ImfStdIO.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledOutputFile.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+double
+secondsSince (steady_clock::time_point start)
+{
+    return duration<double> (steady_clock::now () - start).count ();
+}
+
+Header
+makeHeader (const BenchCase& bc, const BenchPixels& pixels)
+{
+    Header header (pixels.width, pixels.height);
+
+    header.compression () = bc.compression;
+
+    for (size_t c = 0; c < pixels.names.size (); ++c)
+        header.channels ().insert (pixels.names[c], Channel (pixels.type));
+
+    if (bc.storage == TILED)
+        header.setTileDescription (
+            TileDescription (bc.tileSize, bc.tileSize, ONE_LEVEL));
+
+    if (bc.storage == DEEP) header.setType (DEEPSCANLINE);
+
+    return header;
+}
+
+FrameBuffer
+makeFrameBuffer (const BenchPixels& pixels)
+{
+    FrameBuffer fb;
+    size_t      ss = pixels.sampleSize ();
+
+    for (size_t c = 0; c < pixels.names.size (); ++c)
+    {
+        fb.insert (
+            pixels.names[c],
+            Slice (
+                pixels.type,
+                (char*) pixels.planes[c].data (),
+                ss,
+                ss * pixels.width));
+    }
+
+    return fb;
+}
+
+//
+// The deep slices point at arrays of per-pixel sample pointers,
+// which are filled in by setSamplePointers() once the sample counts
+// are known.
+//
+
+DeepFrameBuffer
+makeDeepFrameBuffer (
+    const BenchPixels& pixels, vector<vector<char*>>& pointers)
+{
+    DeepFrameBuffer fb;
+    size_t          ss = pixels.sampleSize ();
+
+    fb.insertSampleCountSlice (Slice (
+        UINT,
+        (char*) pixels.sampleCounts.data (),
+        sizeof (unsigned int),
+        sizeof (unsigned int) * pixels.width));
+
+    pointers.resize (pixels.names.size ());
+
+    for (size_t c = 0; c < pixels.names.size (); ++c)
+    {
+        pointers[c].resize (pixels.sampleCounts.size ());
+
+        fb.insert (
+            pixels.names[c],
+            DeepSlice (
+                pixels.type,
+                (char*) pointers[c].data (),
+                sizeof (char*),
+                sizeof (char*) * pixels.width,
+                ss));
+    }
+
+    return fb;
+}
+
+void
+setSamplePointers (const BenchPixels& pixels, vector<vector<char*>>& pointers)
+{
+    size_t ss = pixels.sampleSize ();
+
+    for (size_t c = 0; c < pixels.planes.size (); ++c)
+    {
+        char* base = (char*) pixels.planes[c].data ();
+
+        for (size_t i = 0; i < pointers[c].size (); ++i)
+            pointers[c][i] = base + pixels.sampleOffsets[i] * ss;
+    }
+}
+
+//
+// Lay out the samples of decoded pixels for the sample counts that
+// were read from the file.
+//
+
+void
+layoutSamples (BenchPixels& pixels)
+{
+    size_t total = 0;
+
+    pixels.sampleOffsets.resize (pixels.sampleCounts.size ());
+
+    for (size_t i = 0; i < pixels.sampleCounts.size (); ++i)
+    {
+        pixels.sampleOffsets[i] = total;
+        total += pixels.sampleCounts[i];
+    }
+
+    pixels.totalSamples = total;
+
+    for (size_t c = 0; c < pixels.planes.size (); ++c)
+        pixels.planes[c].resize (total * pixels.sampleSize ());
+}
+
+void
+encode (const BenchCase& bc, const BenchPixels& pixels, StdOSStream& os)
+{
+    Header header = makeHeader (bc, pixels);
+
+    if (bc.storage == SCANLINE)
+    {
+        OutputFile out (os, header);
+        out.setFrameBuffer (makeFrameBuffer (pixels));
+        out.writePixels (pixels.height);
+    }
+    else if (bc.storage == TILED)
+    {
+        TiledOutputFile out (os, header);
+        out.setFrameBuffer (makeFrameBuffer (pixels));
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        //
+        // The sample pointers are set up while the clock runs, as an
+        // application writing deep data would.
+        //
+
+        vector<vector<char*>> pointers;
+        DeepFrameBuffer       fb = makeDeepFrameBuffer (pixels, pointers);
+
+        setSamplePointers (pixels, pointers);
+
+        DeepScanLineOutputFile out (os, header);
+        out.setFrameBuffer (fb);
+        out.writePixels (pixels.height);
+    }
+}
+
+//
+// Returns the time taken to open the file and set the frame buffer.
+//
+
+double
+decode (const BenchCase& bc, const string& data, BenchPixels& pixels)
+{
+    StdISStream is;
+    is.str (data);
+
+    auto   start = steady_clock::now ();
+    double openSeconds;
+
+    if (bc.storage == SCANLINE)
+    {
+        InputFile in (is);
+        in.setFrameBuffer (makeFrameBuffer (pixels));
+        openSeconds = secondsSince (start);
+        in.readPixels (0, pixels.height - 1);
+    }
+    else if (bc.storage == TILED)
+    {
+        TiledInputFile in (is);
+        in.setFrameBuffer (makeFrameBuffer (pixels));
+        openSeconds = secondsSince (start);
+        in.readTiles (0, in.numXTiles () - 1, 0, in.numYTiles () - 1);
+    }
+    else
+    {
+        MultiPartInputFile    file (is);
+        DeepScanLineInputPart in (file, 0);
+        vector<vector<char*>> pointers;
+
+        in.setFrameBuffer (makeDeepFrameBuffer (pixels, pointers));
+        openSeconds = secondsSince (start);
+        in.readPixelSampleCounts (0, pixels.height - 1);
+        layoutSamples (pixels);
+        setSamplePointers (pixels, pointers);
+        in.readPixels (0, pixels.height - 1);
+    }
+
+    return openSeconds;
+}
+
+} // namespace
+
+BenchResult
+runImf (const BenchCase& bc, const BenchPixels& pixels, int iterations)
+{
+    BenchResult result;
+    string      data;
+
+    result.encodeSeconds = 0;
+    result.decodeSeconds = 0;
+    result.openSeconds   = 0;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        StdOSStream os;
+
+        auto start = steady_clock::now ();
+        encode (bc, pixels, os);
+        double seconds = secondsSince (start);
+
+        if (i == 0 || seconds < result.encodeSeconds)
+            result.encodeSeconds = seconds;
+
+        if (i == 0) data = os.str ();
+    }
+
+    result.fileBytes = data.size ();
+
+    BenchPixels decoded = pixels;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (size_t c = 0; c < decoded.planes.size (); ++c)
+            fill (decoded.planes[c].begin (), decoded.planes[c].end (), 0);
+
+        fill (decoded.sampleCounts.begin (), decoded.sampleCounts.end (), 0);
+
+        auto   start       = steady_clock::now ();
+        double openSeconds = decode (bc, data, decoded);
+        double seconds     = secondsSince (start);
+
+        if (i == 0 || seconds < result.decodeSeconds)
+            result.decodeSeconds = seconds;
+
+        if (i == 0 || openSeconds < result.openSeconds)
+            result.openSeconds = openSeconds;
+    }
+
+    result.exact = samePixels (pixels, decoded);
+    return result;
+}
@@ -0,0 +1,166 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "bench.h"
+
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfPartType.h>
+
+#include <math.h>
+#include <random>
+#include <stdexcept>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int SYNTHETIC_PLANES = 4;
+
+//
+// Smooth ramps, in a different direction in each plane: the best
+// case for the predictors of the lossless codecs.
+//
+
+float
+ramp (int plane, float u, float v)
+{
+    switch (plane)
+    {
+        case 0: return u;
+        case 1: return v;
+        case 2: return 0.5f * (u + v);
+        default: return 1.0f - u * v;
+    }
+}
+
+//
+// Large soft shapes with some fine texture and film grain, and a few
+// highlights above 1.0, which is roughly what rendered or scanned
+// plates look like to the codecs.
+//
+
+float
+natural (int plane, float u, float v, float grain)
+{
+    float shape = 0.5f + 0.25f * sinf (6.0f * u + plane) * cosf (4.0f * v) +
+                  0.15f * sinf (23.0f * (u + v) + 2.0f * plane);
+
+    float texture = 0.05f * sinf (310.0f * u) * sinf (270.0f * v);
+
+    float highlight = 0.0f;
+    float du        = u - 0.7f;
+    float dv        = v - 0.3f;
+    float d         = du * du + dv * dv;
+
+    if (d < 0.01f) highlight = 8.0f * (0.01f - d) / 0.01f;
+
+    if (plane == 3) return shape > 0.4f ? 1.0f : shape / 0.4f;
+
+    return shape + texture + highlight + grain;
+}
+
+} // namespace
+
+void
+makeSyntheticImage (
+    const string& kind, int width, int height, CorpusImage& image)
+{
+    if (kind != "ramp" && kind != "natural" && kind != "noise")
+        throw invalid_argument ("unknown synthetic image \"" + kind + "\"");
+
+    image.name   = kind;
+    image.width  = width;
+    image.height = height;
+    image.planes.assign (
+        SYNTHETIC_PLANES, vector<float> (size_t (width) * height));
+
+    //
+    // A fixed seed, so every run benchmarks the same pixels.
+    //
+
+    mt19937                          rng (20090331);
+    uniform_real_distribution<float> uniform (0.0f, 1.0f);
+    normal_distribution<float>       gaussian (0.0f, 0.01f);
+
+    for (int p = 0; p < SYNTHETIC_PLANES; ++p)
+    {
+        float* out = image.planes[p].data ();
+
+        for (int y = 0; y < height; ++y)
+        {
+            float v = float (y) / height;
+
+            for (int x = 0; x < width; ++x)
+            {
+                float u = float (x) / width;
+
+                if (kind == "ramp")
+                    *out++ = ramp (p, u, v);
+                else if (kind == "natural")
+                    *out++ = natural (p, u, v, gaussian (rng));
+                else
+                    *out++ = uniform (rng);
+            }
+        }
+    }
+}
+
+void
+loadImage (const string& fileName, CorpusImage& image)
+{
+    InputFile     in (fileName.c_str ());
+    const Header& header = in.header ();
+
+    if (header.hasType () && isDeepData (header.type ()))
+        throw invalid_argument (
+            fileName + ": deep images cannot be used as a corpus");
+
+    const Box2i& dw = header.dataWindow ();
+    int          w  = dw.max.x - dw.min.x + 1;
+    int          h  = dw.max.y - dw.min.y + 1;
+
+    image.name   = fileName;
+    image.width  = w;
+    image.height = h;
+    image.planes.clear ();
+
+    FrameBuffer fb;
+
+    for (ChannelList::ConstIterator i = header.channels ().begin ();
+         i != header.channels ().end ();
+         ++i)
+    {
+        //
+        // Subsampled channels would need a different layout for
+        // every case, so only full-resolution channels are used.
+        //
+
+        if (i.channel ().xSampling != 1 || i.channel ().ySampling != 1)
+            continue;
+
+        image.planes.push_back (vector<float> (size_t (w) * h));
+
+        char* base = (char*) image.planes.back ().data () -
+                     (ptrdiff_t (dw.min.x) + ptrdiff_t (dw.min.y) * w) *
+                         ptrdiff_t (sizeof (float));
+
+        fb.insert (
+            i.name (),
+            Slice (FLOAT, base, sizeof (float), sizeof (float) * w));
+    }
+
+    if (image.planes.empty ())
+        throw invalid_argument (
+            fileName + ": the image has no full-resolution channels");
+
+    in.setFrameBuffer (fb);
+    in.readPixels (dw.min.y, dw.max.y);
+}
@@ -0,0 +1,573 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//
+// OpenEXRBench: encode and decode throughput of every codec, for a
+// matrix of pixel types, channel counts, storage types, thread counts
+// and APIs, over synthetic images and optionally real images.  The
+// results are written as JSON, for tracking regressions.
+//
+
+#include "bench.h"
+
+#include <ImfThreading.h>
+#include <OpenEXRConfig.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const char* compressionNames[] = {
+    "none",
+    "rle",
+    "zips",
+    "zip",
+    "piz",
+    "pxr24",
+    "b44",
+    "b44a",
+    "dwaa",
+    "dwab"};
+
+const char* typeNames[]    = {"uint", "half", "float"};
+const char* storageNames[] = {"scanline", "tiled", "deep"};
+const char* apiNames[]     = {"imf", "core"};
+
+void
+usageMessage (ostream& stream, const char* program_name, bool verbose = false)
+{
+    stream << "Usage: " << program_name << " [options] [imagefile ...]\n";
+
+    if (verbose)
+    {
+        stream
+            << "\n"
+               "Measure the encode and decode throughput of the OpenEXR\n"
+               "codecs, and write the results as JSON. Each list option\n"
+               "takes a comma-separated list; every combination is run.\n"
+               "The images given on the command line are benchmarked in\n"
+               "addition to the synthetic images.\n"
+               "\n"
+               "Options:\n"
+               "  -c, --compression list  codecs (default: rle,zips,zip,piz,\n"
+               "                          pxr24,b44,b44a,dwaa,dwab)\n"
+               "  -p, --pixel-type list   half, float, uint (default: all)\n"
+               "  -n, --channels list     channel counts (default: 1,3,4)\n"
+               "  -s, --storage list      scanline, tiled, deep (default: "
+               "all)\n"
+               "  -t, --threads list      thread counts (default: 0 and the\n"
+               "                          number of hardware threads)\n"
+               "  -a, --api list          imf, core (default: both)\n"
+               "  -g, --synthetic list    ramp, natural, noise or none\n"
+               "                          (default: ramp,natural,noise)\n"
+               "  -r, --resolution WxH    size of the synthetic images\n"
+               "                          (default: 1024x1024)\n"
+               "  -i, --iterations n      runs per case, the best time is\n"
+               "                          reported (default: 3)\n"
+               "  -T, --tile-size n       tile size (default: 64)\n"
+               "  -o, --output file       write the JSON to a file\n"
+               "  -e, --verify            fail if a lossless codec does not\n"
+               "                          reproduce its input exactly\n"
+               "  -v, --verbose           print each case as it runs\n"
+               "  -h, --help              print this message\n"
+               "\n"
+               "Deep images are benchmarked with the codecs that support\n"
+               "them. Deep images and DWA compression are benchmarked\n"
+               "through the C++ API only.\n"
+               "\n"
+               "open_seconds is the part of the decode time spent opening\n"
+               "the file and setting up the frame buffer. To measure it\n"
+               "for files with many channels, use for example\n"
+               "-n 400 -r 64x64.\n"
+               "";
+    }
+}
+
+vector<string>
+splitList (const string& list)
+{
+    vector<string> items;
+    stringstream   ss (list);
+    string         item;
+
+    while (getline (ss, item, ','))
+        if (!item.empty ()) items.push_back (item);
+
+    return items;
+}
+
+template <class T, size_t N>
+vector<T>
+parseNames (const char* option, const string& list, const char* (&names)[N])
+{
+    vector<T> values;
+
+    for (const string& item: splitList (list))
+    {
+        size_t i = 0;
+
+        while (i < N && item != names[i])
+            ++i;
+
+        if (i == N)
+            throw invalid_argument (
+                string ("unknown value \"") + item + "\" for " + option);
+
+        values.push_back (T (i));
+    }
+
+    return values;
+}
+
+vector<int>
+parseInts (const char* option, const string& list, int minimum)
+{
+    vector<int> values;
+
+    for (const string& item: splitList (list))
+    {
+        char* end;
+        long  v = strtol (item.c_str (), &end, 10);
+
+        if (*end != '\0' || v < minimum || v > 1024 * 1024)
+            throw invalid_argument (
+                string ("invalid value \"") + item + "\" for " + option);
+
+        values.push_back (int (v));
+    }
+
+    return values;
+}
+
+bool
+isDeepCompression (Compression c)
+{
+    return c == NO_COMPRESSION || c == RLE_COMPRESSION ||
+           c == ZIPS_COMPRESSION;
+}
+
+//
+// The Core library cannot encode deep images, and has no DWA codec
+// yet.
+//
+
+bool
+isCoreCase (const BenchCase& bc)
+{
+    return bc.storage != DEEP && bc.compression != DWAA_COMPRESSION &&
+           bc.compression != DWAB_COMPRESSION;
+}
+
+//
+// Whether a codec must reproduce pixels of a type exactly.  PXR24
+// rounds 32-bit floats to 24 bits.  B44 and DWA are not checked.
+//
+
+bool
+isLossless (Compression c, PixelType type)
+{
+    switch (c)
+    {
+        case NO_COMPRESSION:
+        case RLE_COMPRESSION:
+        case ZIPS_COMPRESSION:
+        case ZIP_COMPRESSION:
+        case PIZ_COMPRESSION: return true;
+        case PXR24_COMPRESSION: return type != FLOAT;
+        default: return false;
+    }
+}
+
+string
+jsonString (const string& s)
+{
+    string out = "\"";
+
+    for (char c: s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char) c < 0x20)
+        {
+            char buf[8];
+            snprintf (buf, sizeof (buf), "\\u%04x", (unsigned char) c);
+            out += buf;
+        }
+        else
+            out += c;
+    }
+
+    return out + "\"";
+}
+
+//
+// A rate, or null if the time was too short to measure.
+//
+
+string
+jsonRate (double bytes, double seconds)
+{
+    if (seconds <= 0) return "null";
+
+    ostringstream ss;
+    ss.precision (6);
+    ss << bytes / seconds / 1e6;
+    return ss.str ();
+}
+
+struct Options
+{
+    vector<Compression> compressions;
+    vector<PixelType>   types;
+    vector<int>         channels;
+    vector<Storage>     storages;
+    vector<int>         threads;
+    vector<Api>         apis;
+    vector<string>      synthetic;
+    vector<string>      files;
+    int                 width;
+    int                 height;
+    int                 iterations;
+    int                 tileSize;
+    string              output;
+    bool                verify;
+    bool                verbose;
+};
+
+//
+// Every combination of the options, except deep images with codecs
+// that do not support them, and cases the Core library cannot run.
+//
+
+vector<BenchCase>
+makeCases (const Options& opts)
+{
+    vector<BenchCase> cases;
+    BenchCase         bc;
+
+    bc.tileSize = opts.tileSize;
+
+    for (Storage storage: opts.storages)
+    {
+        bc.storage = storage;
+
+        for (Compression compression: opts.compressions)
+        {
+            bc.compression = compression;
+
+            if (storage == DEEP && !isDeepCompression (compression))
+                continue;
+
+            for (PixelType type: opts.types)
+            {
+                bc.type = type;
+
+                for (int channels: opts.channels)
+                {
+                    bc.channels = channels;
+
+                    for (int threads: opts.threads)
+                    {
+                        bc.threads = threads;
+
+                        for (Api api: opts.apis)
+                        {
+                            bc.api = api;
+
+                            if (api != API_CORE || isCoreCase (bc))
+                                cases.push_back (bc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return cases;
+}
+
+bool
+samePixelLayout (const BenchCase& a, const BenchCase& b)
+{
+    return a.storage == b.storage && a.type == b.type &&
+           a.channels == b.channels;
+}
+
+string
+describe (const BenchCase& bc)
+{
+    return string (apiNames[bc.api]) + " " + storageNames[bc.storage] + " " +
+           compressionNames[bc.compression] + " " + typeNames[bc.type] +
+           " x" + to_string (bc.channels) + " threads " +
+           to_string (bc.threads);
+}
+
+void
+writeResult (
+    ostream&           out,
+    const CorpusImage& image,
+    const BenchCase&   bc,
+    const BenchPixels& pixels,
+    const BenchResult& r)
+{
+    double raw = double (pixels.rawBytes ());
+
+    out << "    {\"image\": " << jsonString (image.name)
+        << ", \"width\": " << image.width << ", \"height\": " << image.height
+        << ", \"api\": \"" << apiNames[bc.api] << "\", \"storage\": \""
+        << storageNames[bc.storage] << "\", \"compression\": \""
+        << compressionNames[bc.compression] << "\", \"pixel_type\": \""
+        << typeNames[bc.type] << "\", \"channels\": " << bc.channels
+        << ", \"threads\": " << bc.threads
+        << ", \"raw_bytes\": " << pixels.rawBytes ()
+        << ", \"file_bytes\": " << r.fileBytes
+        << ", \"ratio\": " << raw / double (r.fileBytes)
+        << ", \"encode_seconds\": " << r.encodeSeconds
+        << ", \"decode_seconds\": " << r.decodeSeconds
+        << ", \"open_seconds\": " << r.openSeconds
+        << ", \"encode_mb_per_s\": " << jsonRate (raw, r.encodeSeconds)
+        << ", \"decode_mb_per_s\": " << jsonRate (raw, r.decodeSeconds)
+        << ", \"exact\": " << (r.exact ? "true" : "false") << "}";
+}
+
+int
+runBenchmarks (const Options& opts, ostream& out)
+{
+    vector<CorpusImage> corpus;
+
+    for (const string& kind: opts.synthetic)
+    {
+        corpus.push_back (CorpusImage ());
+        makeSyntheticImage (kind, opts.width, opts.height, corpus.back ());
+    }
+
+    for (const string& file: opts.files)
+    {
+        corpus.push_back (CorpusImage ());
+        loadImage (file, corpus.back ());
+    }
+
+    int  failures = 0;
+    bool first    = true;
+
+    out.precision (6);
+    out << "{\n"
+        << "  \"benchmark\": \"OpenEXRBench\",\n"
+        << "  \"openexr_version\": \"" << OPENEXR_VERSION_STRING << "\",\n"
+        << "  \"hardware_threads\": " << thread::hardware_concurrency ()
+        << ",\n"
+        << "  \"iterations\": " << opts.iterations << ",\n"
+        << "  \"tile_size\": " << opts.tileSize << ",\n"
+        << "  \"results\": [";
+
+    vector<BenchCase> cases = makeCases (opts);
+
+    for (const CorpusImage& image: corpus)
+    {
+        BenchPixels pixels;
+
+        for (size_t i = 0; i < cases.size (); ++i)
+        {
+            const BenchCase& bc = cases[i];
+
+            //
+            // The cases that differ only in their thread count and
+            // API are consecutive, and share their pixels.
+            //
+
+            if (i == 0 || !samePixelLayout (bc, cases[i - 1]))
+                makeBenchPixels (image, bc, pixels);
+
+            string what = image.name + " " + describe (bc);
+
+            if (opts.verbose) cerr << what << endl;
+
+            setGlobalThreadCount (bc.threads);
+
+            try
+            {
+                BenchResult r = bc.api == API_IMF
+                                    ? runImf (bc, pixels, opts.iterations)
+                                    : runCore (bc, pixels, opts.iterations);
+
+                out << (first ? "\n" : ",\n");
+                writeResult (out, image, bc, pixels, r);
+                first = false;
+
+                if (opts.verify && !r.exact &&
+                    isLossless (bc.compression, bc.type))
+                {
+                    cerr << "error: " << what
+                         << ": the decoded pixels differ from the original"
+                         << endl;
+                    ++failures;
+                }
+            }
+            catch (const exception& e)
+            {
+                cerr << "error: " << what << ": " << e.what () << endl;
+                ++failures;
+            }
+        }
+    }
+
+    out << "\n  ]\n}\n";
+    return failures;
+}
+
+} // namespace
+
+int
+main (int argc, char** argv)
+{
+    Options opts;
+
+    opts.compressions = {
+        RLE_COMPRESSION,
+        ZIPS_COMPRESSION,
+        ZIP_COMPRESSION,
+        PIZ_COMPRESSION,
+        PXR24_COMPRESSION,
+        B44_COMPRESSION,
+        B44A_COMPRESSION,
+        DWAA_COMPRESSION,
+        DWAB_COMPRESSION};
+    opts.types      = {HALF, FLOAT, UINT};
+    opts.channels   = {1, 3, 4};
+    opts.storages   = {SCANLINE, TILED, DEEP};
+    opts.threads    = {0, int (thread::hardware_concurrency ())};
+    opts.apis       = {API_IMF, API_CORE};
+    opts.synthetic  = {"ramp", "natural", "noise"};
+    opts.width      = 1024;
+    opts.height     = 1024;
+    opts.iterations = 3;
+    opts.tileSize   = 64;
+    opts.verify     = false;
+    opts.verbose    = false;
+
+    if (opts.threads[1] <= 0) opts.threads.pop_back ();
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            string      arg   = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+            const char* opt   = argv[i];
+
+            if (arg == "-h" || arg == "--help")
+            {
+                usageMessage (cout, "OpenEXRBench", true);
+                return 0;
+            }
+            else if (arg == "-e" || arg == "--verify")
+            {
+                opts.verify = true;
+                continue;
+            }
+            else if (arg == "-v" || arg == "--verbose")
+            {
+                opts.verbose = true;
+                continue;
+            }
+            else if (arg[0] != '-')
+            {
+                opts.files.push_back (arg);
+                continue;
+            }
+
+            //
+            // All the other options take a value.
+            //
+
+            if (!value) throw invalid_argument ("missing value for " + arg);
+
+            ++i;
+
+            if (arg == "-c" || arg == "--compression")
+                opts.compressions =
+                    parseNames<Compression> (opt, value, compressionNames);
+            else if (arg == "-p" || arg == "--pixel-type")
+                opts.types = parseNames<PixelType> (opt, value, typeNames);
+            else if (arg == "-n" || arg == "--channels")
+                opts.channels = parseInts (opt, value, 1);
+            else if (arg == "-s" || arg == "--storage")
+                opts.storages = parseNames<Storage> (opt, value, storageNames);
+            else if (arg == "-t" || arg == "--threads")
+                opts.threads = parseInts (opt, value, 0);
+            else if (arg == "-a" || arg == "--api")
+                opts.apis = parseNames<Api> (opt, value, apiNames);
+            else if (arg == "-g" || arg == "--synthetic")
+            {
+                opts.synthetic = splitList (value);
+                if (opts.synthetic.size () == 1 && opts.synthetic[0] == "none")
+                    opts.synthetic.clear ();
+            }
+            else if (arg == "-r" || arg == "--resolution")
+            {
+                if (sscanf (value, "%dx%d", &opts.width, &opts.height) != 2 ||
+                    opts.width < 1 || opts.height < 1)
+                    throw invalid_argument ("invalid resolution");
+            }
+            else if (arg == "-i" || arg == "--iterations")
+            {
+                vector<int> v = parseInts (opt, value, 1);
+                if (v.size () != 1)
+                    throw invalid_argument ("invalid iteration count");
+                opts.iterations = v[0];
+            }
+            else if (arg == "-T" || arg == "--tile-size")
+            {
+                vector<int> v = parseInts (opt, value, 1);
+                if (v.size () != 1)
+                    throw invalid_argument ("invalid tile size");
+                opts.tileSize = v[0];
+            }
+            else if (arg == "-o" || arg == "--output")
+                opts.output = value;
+            else
+                throw invalid_argument ("unknown option " + arg);
+        }
+        if (opts.synthetic.empty () && opts.files.empty ())
+            throw invalid_argument ("no images to benchmark");
+
+        int failures;
+
+        if (opts.output.empty ())
+            failures = runBenchmarks (opts, cout);
+        else
+        {
+            ofstream out (opts.output.c_str ());
+            if (!out) throw runtime_error ("cannot open " + opts.output);
+            failures = runBenchmarks (opts, out);
+        }
+
+        return failures == 0 ? 0 : 1;
+    }
+    catch (const invalid_argument& e)
+    {
+        cerr << "OpenEXRBench: " << e.what () << endl;
+        usageMessage (cerr, "OpenEXRBench");
+        return 1;
+    }
+    catch (const exception& e)
+    {
+        cerr << "OpenEXRBench: " << e.what () << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,136 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "bench.h"
+
+#include <half.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+string
+channelName (int c, int channels)
+{
+    //
+    // Use the names the lossy codecs recognize, so that B44 and DWA
+    // see the same data they would see in a production image.
+    //
+
+    static const char* rgba[] = {"R", "G", "B", "A"};
+
+    if (channels == 1) return "Y";
+    if (c < 4) return rgba[c];
+    return "C" + to_string (c);
+}
+
+void
+storeSample (PixelType type, float v, char* out)
+{
+    switch (type)
+    {
+        case HALF: {
+            uint16_t bits = half (v).bits ();
+            memcpy (out, &bits, sizeof (bits));
+            break;
+        }
+        case FLOAT: memcpy (out, &v, sizeof (v)); break;
+        default: {
+            unsigned int u = (unsigned int) (max (v, 0.0f) * 1000.0f + 0.5f);
+            memcpy (out, &u, sizeof (u));
+            break;
+        }
+    }
+}
+
+} // namespace
+
+size_t
+BenchPixels::sampleSize () const
+{
+    return type == HALF ? 2 : 4;
+}
+
+size_t
+BenchPixels::rawBytes () const
+{
+    if (sampleCounts.empty ())
+        return size_t (width) * height * sampleSize () * planes.size ();
+
+    return totalSamples * sampleSize () * planes.size () +
+           sampleCounts.size () * sizeof (unsigned int);
+}
+
+void
+makeBenchPixels (
+    const CorpusImage& image, const BenchCase& bc, BenchPixels& pixels)
+{
+    size_t numPixels = size_t (image.width) * image.height;
+
+    pixels.type   = bc.type;
+    pixels.width  = image.width;
+    pixels.height = image.height;
+    pixels.names.clear ();
+    pixels.planes.clear ();
+    pixels.sampleCounts.clear ();
+    pixels.sampleOffsets.clear ();
+    pixels.totalSamples = numPixels;
+
+    if (bc.storage == DEEP)
+    {
+        //
+        // Between one and three samples per pixel, in a pattern the
+        // sample count compression cannot collapse entirely.
+        //
+
+        pixels.sampleCounts.resize (numPixels);
+        pixels.sampleOffsets.resize (numPixels);
+        pixels.totalSamples = 0;
+
+        for (int y = 0; y < image.height; ++y)
+        {
+            for (int x = 0; x < image.width; ++x)
+            {
+                size_t i                = size_t (y) * image.width + x;
+                pixels.sampleCounts[i]  = 1 + ((x / 3) ^ (y / 5)) % 3;
+                pixels.sampleOffsets[i] = pixels.totalSamples;
+                pixels.totalSamples += pixels.sampleCounts[i];
+            }
+        }
+    }
+
+    size_t ss = pixels.sampleSize ();
+
+    for (int c = 0; c < bc.channels; ++c)
+    {
+        const vector<float>& src = image.planes[c % image.planes.size ()];
+
+        pixels.names.push_back (channelName (c, bc.channels));
+        pixels.planes.push_back (vector<char> (pixels.totalSamples * ss));
+
+        char* out = pixels.planes.back ().data ();
+
+        for (size_t i = 0; i < numPixels; ++i)
+        {
+            unsigned int n = bc.storage == DEEP ? pixels.sampleCounts[i] : 1;
+
+            for (unsigned int s = 0; s < n; ++s, out += ss)
+                storeSample (bc.type, src[i] / float (s + 1), out);
+        }
+    }
+}
+
+bool
+samePixels (const BenchPixels& a, const BenchPixels& b)
+{
+    return a.type == b.type && a.width == b.width && a.height == b.height &&
+           a.names == b.names && a.sampleCounts == b.sampleCounts &&
+           a.planes == b.planes;
+}
@@ -18,10 +18,12 @@
 #include <memory.h>
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <algorithm>
 
@@ -1542,6 +1544,1366 @@ testB44ACompression (const std::string& tempdir)
     testComp (tempdir, EXR_COMPRESSION_B44A);
 }
 
+////////////////////////////////////////
+
+//
+// The B44 compressors in the C++ library and in the core select
+// vectorized versions of their block packing and unpacking code at
+// run time.  Check that both produce exactly the same bits as the
+// scalar code, which is reproduced here, for random, special and
+// flat blocks, and for arbitrary compressed blocks.
+//
+
+static const int B44_WIDTH  = 256;
+static const int B44_HEIGHT = 32;
+
+//
+// Pixels whose difference is stored in r[0] ... r[14]
+//
+
+static const int b44Pairs[15][2] = {
+    {0, 4},
+    {4, 8},
+    {8, 12},
+    {0, 1},
+    {4, 5},
+    {8, 9},
+    {12, 13},
+    {1, 2},
+    {5, 6},
+    {9, 10},
+    {13, 14},
+    {2, 3},
+    {6, 7},
+    {10, 11},
+    {14, 15}};
+
+static int
+refB44Pack (const uint16_t s[16], uint8_t b[14], bool flatfields)
+{
+    uint16_t t[16];
+    uint16_t tMax = 0;
+    int      d[16];
+    int      r[15];
+    int      rMin, rMax;
+    int      shift = -1;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if ((s[i] & 0x7c00) == 0x7c00)
+            t[i] = 0x8000;
+        else if (s[i] & 0x8000)
+            t[i] = ~s[i];
+        else
+            t[i] = s[i] | 0x8000;
+
+        if (tMax < t[i]) tMax = t[i];
+    }
+
+    do
+    {
+        shift += 1;
+
+        for (int i = 0; i < 16; ++i)
+            d[i] = shiftAndRound (tMax - t[i], shift);
+
+        for (int i = 0; i < 15; ++i)
+            r[i] = d[b44Pairs[i][0]] - d[b44Pairs[i][1]] + 0x20;
+
+        rMin = *std::min_element (r, r + 15);
+        rMax = *std::max_element (r, r + 15);
+    } while (rMin < 0 || rMax > 0x3f);
+
+    if (rMin == 0x20 && rMax == 0x20 && flatfields)
+    {
+        b[0] = (uint8_t) (t[0] >> 8);
+        b[1] = (uint8_t) t[0];
+        b[2] = 0xfc;
+        return 3;
+    }
+
+    t[0] = tMax - (uint16_t) (d[0] << shift);
+
+    b[0]  = (uint8_t) (t[0] >> 8);
+    b[1]  = (uint8_t) t[0];
+    b[2]  = (uint8_t) ((shift << 2) | (r[0] >> 4));
+    b[3]  = (uint8_t) ((r[0] << 4) | (r[1] >> 2));
+    b[4]  = (uint8_t) ((r[1] << 6) | r[2]);
+    b[5]  = (uint8_t) ((r[3] << 2) | (r[4] >> 4));
+    b[6]  = (uint8_t) ((r[4] << 4) | (r[5] >> 2));
+    b[7]  = (uint8_t) ((r[5] << 6) | r[6]);
+    b[8]  = (uint8_t) ((r[7] << 2) | (r[8] >> 4));
+    b[9]  = (uint8_t) ((r[8] << 4) | (r[9] >> 2));
+    b[10] = (uint8_t) ((r[9] << 6) | r[10]);
+    b[11] = (uint8_t) ((r[11] << 2) | (r[12] >> 4));
+    b[12] = (uint8_t) ((r[12] << 4) | (r[13] >> 2));
+    b[13] = (uint8_t) ((r[13] << 6) | r[14]);
+    return 14;
+}
+
+static int
+refB44Unpack (const uint8_t* b, uint16_t s[16])
+{
+    if (b[2] >= (13 << 2))
+    {
+        uint16_t t = (uint16_t) ((b[0] << 8) | b[1]);
+
+        t = (t & 0x8000) ? (t & 0x7fff) : (uint16_t) ~t;
+
+        for (int i = 0; i < 16; ++i)
+            s[i] = t;
+        return 3;
+    }
+
+    //
+    // The six-bit differences follow the shift value, most
+    // significant bit first.
+    //
+
+    int      shift = b[2] >> 2;
+    uint32_t bits  = b[2] & 0x3;
+    int      nbits = 2;
+    int      in    = 3;
+
+    s[0] = (uint16_t) ((b[0] << 8) | b[1]);
+
+    for (int i = 0; i < 15; ++i)
+    {
+        while (nbits < 6)
+        {
+            bits = (bits << 8) | b[in++];
+            nbits += 8;
+        }
+
+        uint32_t r = (bits >> (nbits - 6)) & 0x3f;
+        nbits -= 6;
+
+        s[b44Pairs[i][1]] = (uint16_t) (
+            s[b44Pairs[i][0]] + (r << shift) - (0x20u << shift));
+    }
+
+    for (int i = 0; i < 16; ++i)
+        s[i] = (s[i] & 0x8000) ? (s[i] & 0x7fff) : (uint16_t) ~s[i];
+
+    return 14;
+}
+
+static void
+fillB44Block (Rand32& rand, uint16_t s[16])
+{
+    static const uint16_t specials[] = {
+        0x0000,
+        0x8000,
+        0x7c00,
+        0xfc00,
+        0x7e00,
+        0xfe01,
+        0x0001,
+        0x8001,
+        0x7bff,
+        0xfbff,
+        0x3c00,
+        0xbc00};
+    const int nspecials = sizeof (specials) / sizeof (specials[0]);
+
+    uint16_t base = (uint16_t) rand.nexti ();
+
+    switch (rand.nexti () % 6)
+    {
+        case 0:
+            // arbitrary bit patterns, including NaNs and infinities
+            for (int i = 0; i < 16; ++i)
+                s[i] = (uint16_t) rand.nexti ();
+            break;
+        case 1:
+            // flat block
+            for (int i = 0; i < 16; ++i)
+                s[i] = base;
+            break;
+        case 2:
+            // special values
+            for (int i = 0; i < 16; ++i)
+                s[i] = specials[rand.nexti () % nspecials];
+            break;
+        case 3:
+        {
+            // differences that need a particular shift
+            int range = 1 << (rand.nexti () % 16);
+            base &= 0x7bff;
+            for (int i = 0; i < 16; ++i)
+                s[i] = (uint16_t) (base + rand.nexti () % range);
+            break;
+        }
+        case 4:
+            // small values of either sign, around zero
+            for (int i = 0; i < 16; ++i)
+                s[i] = (uint16_t) (rand.nexti () & 0x80ff);
+            break;
+        default:
+            // mostly flat, with one outlier
+            for (int i = 0; i < 16; ++i)
+                s[i] = base;
+            s[rand.nexti () % 16] = (uint16_t) rand.nexti ();
+            break;
+    }
+}
+
+//
+// Write and read single channel HALF images that fit in one chunk.
+//
+
+static exr_context_t
+startHalfCore (
+    const std::string& filename, exr_compression_t comp, int width, int height)
+{
+    exr_context_t             f;
+    int                       partidx;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &f, filename.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (f, "scan", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (
+        exr_initialize_required_attr_simple (f, partidx, width, height, comp));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "Y", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    return f;
+}
+
+static void
+encodeHalfCore (
+    const std::string&           filename,
+    exr_compression_t            comp,
+    int                          width,
+    int                          height,
+    const std::vector<uint16_t>& pixels)
+{
+    exr_context_t         f = startHalfCore (filename, comp, width, height);
+    exr_chunk_info_t      cinfo;
+    exr_encode_pipeline_t encoder;
+
+    EXRCORE_TEST_RVAL (exr_write_scanline_chunk_info (f, 0, 0, &cinfo));
+    EXRCORE_TEST (cinfo.height == height);
+    EXRCORE_TEST_RVAL (exr_encoding_initialize (f, 0, &cinfo, &encoder));
+    encoder.channels[0].encode_from_ptr   = (const uint8_t*) pixels.data ();
+    encoder.channels[0].user_pixel_stride = 2;
+    encoder.channels[0].user_line_stride  = width * 2;
+    EXRCORE_TEST_RVAL (exr_encoding_choose_default_routines (f, 0, &encoder));
+    EXRCORE_TEST_RVAL (exr_encoding_run (f, 0, &encoder));
+    EXRCORE_TEST_RVAL (exr_encoding_destroy (f, &encoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static void
+writeChunkCore (
+    const std::string&          filename,
+    exr_compression_t           comp,
+    int                         width,
+    int                         height,
+    const std::vector<uint8_t>& packed)
+{
+    exr_context_t f = startHalfCore (filename, comp, width, height);
+
+    EXRCORE_TEST_RVAL (
+        exr_write_scanline_chunk (f, 0, 0, packed.data (), packed.size ()));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static void
+readHalfCore (
+    const std::string&     filename,
+    int                    width,
+    int                    height,
+    std::vector<uint8_t>&  packed,
+    std::vector<uint16_t>& pixels)
+{
+    exr_context_t             f;
+    exr_chunk_info_t          cinfo;
+    exr_decode_pipeline_t     decoder;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, filename.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, 0, &cinfo));
+    EXRCORE_TEST (cinfo.height == height);
+    EXRCORE_TEST (cinfo.unpacked_size == (uint64_t) (width * height * 2));
+
+    packed.resize (cinfo.packed_size);
+    EXRCORE_TEST_RVAL (exr_read_chunk (f, 0, &cinfo, packed.data ()));
+
+    pixels.assign (width * height, 0);
+    EXRCORE_TEST_RVAL (exr_decoding_initialize (f, 0, &cinfo, &decoder));
+    decoder.channels[0].decode_to_ptr     = (uint8_t*) pixels.data ();
+    decoder.channels[0].user_pixel_stride = 2;
+    decoder.channels[0].user_line_stride  = width * 2;
+    EXRCORE_TEST_RVAL (exr_decoding_choose_default_routines (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static void
+testB44Exact (const std::string& tempdir, exr_compression_t comp)
+{
+    const bool        flat     = (comp == EXR_COMPRESSION_B44A);
+    const int         nblocks  = (B44_WIDTH / 4) * (B44_HEIGHT / 4);
+    const size_t      npixels  = B44_WIDTH * B44_HEIGHT;
+    const std::string filename = tempdir + "imf_test_b44_exact.exr";
+
+    Header hdr (B44_WIDTH, B44_HEIGHT);
+    hdr.compression () = flat ? B44A_COMPRESSION : B44_COMPRESSION;
+    hdr.channels ().insert ("Y", Channel (IMF::HALF));
+
+    std::unique_ptr<Compressor> cppcomp (
+        newCompressor (hdr.compression (), B44_WIDTH * 2, hdr));
+    EXRCORE_TEST (cppcomp->numScanLines () == B44_HEIGHT);
+    EXRCORE_TEST (cppcomp->format () == Compressor::NATIVE);
+
+    Rand32 rand (comp);
+
+    for (int round = 0; round < 8; ++round)
+    {
+        //
+        // Compress an image and compare the result with the
+        // reference compressor.
+        //
+
+        std::vector<uint16_t> image (npixels);
+        std::vector<uint8_t>  expected;
+        uint16_t              s[16];
+        uint8_t               b[14];
+
+        for (int by = 0; by < B44_HEIGHT / 4; ++by)
+        {
+            for (int bx = 0; bx < B44_WIDTH / 4; ++bx)
+            {
+                fillB44Block (rand, s);
+
+                for (int i = 0; i < 16; ++i)
+                    image[(by * 4 + i / 4) * B44_WIDTH + bx * 4 + i % 4] =
+                        s[i];
+
+                int n = refB44Pack (s, b, flat);
+                expected.insert (expected.end (), b, b + n);
+            }
+        }
+
+        const char* out;
+        int         outSize = cppcomp->compress (
+            (const char*) image.data (), (int) npixels * 2, 0, out);
+
+        EXRCORE_TEST (outSize == (int) expected.size ());
+        EXRCORE_TEST (memcmp (out, expected.data (), outSize) == 0);
+
+        std::vector<uint8_t>  packed;
+        std::vector<uint16_t> decoded;
+
+        encodeHalfCore (filename, comp, B44_WIDTH, B44_HEIGHT, image);
+        readHalfCore (filename, B44_WIDTH, B44_HEIGHT, packed, decoded);
+        EXRCORE_TEST (packed == expected);
+
+        //
+        // Uncompress the compressed image, and a stream of arbitrary
+        // compressed blocks, and compare the results with the
+        // reference decompressor.
+        //
+
+        std::vector<uint8_t> arbitrary;
+
+        for (int i = 0; i < nblocks; ++i)
+        {
+            for (int j = 0; j < 14; ++j)
+                b[j] = (uint8_t) rand.nexti ();
+
+            if (rand.nexti () % 4 == 0)
+            {
+                b[2] = (uint8_t) (b[2] | 0xfc);
+                arbitrary.insert (arbitrary.end (), b, b + 3);
+            }
+            else
+            {
+                b[2] = (uint8_t) (((b[2] >> 2) % 13) << 2 | (b[2] & 3));
+                arbitrary.insert (arbitrary.end (), b, b + 14);
+            }
+        }
+
+        for (const std::vector<uint8_t>* in: {&expected, &arbitrary})
+        {
+            std::vector<uint16_t> ref (npixels);
+            const uint8_t*        inPtr = in->data ();
+
+            for (int by = 0; by < B44_HEIGHT / 4; ++by)
+            {
+                for (int bx = 0; bx < B44_WIDTH / 4; ++bx)
+                {
+                    inPtr += refB44Unpack (inPtr, s);
+
+                    for (int i = 0; i < 16; ++i)
+                        ref[(by * 4 + i / 4) * B44_WIDTH + bx * 4 + i % 4] =
+                            s[i];
+                }
+            }
+
+            outSize = cppcomp->uncompress (
+                (const char*) in->data (), (int) in->size (), 0, out);
+
+            EXRCORE_TEST (outSize == (int) npixels * 2);
+            EXRCORE_TEST (memcmp (out, ref.data (), outSize) == 0);
+
+            writeChunkCore (filename, comp, B44_WIDTH, B44_HEIGHT, *in);
+            readHalfCore (filename, B44_WIDTH, B44_HEIGHT, packed, decoded);
+            EXRCORE_TEST (packed == *in);
+            EXRCORE_TEST (decoded == ref);
+        }
+    }
+
+    remove (filename.c_str ());
+}
+
+void
+testB44SimdCompression (const std::string& tempdir)
+{
+    testB44Exact (tempdir, EXR_COMPRESSION_B44);
+    testB44Exact (tempdir, EXR_COMPRESSION_B44A);
+}
+
+////////////////////////////////////////
+
+//
+// The PXR24 compressors in the C++ library and in the core convert
+// pixels to and from byte planes with vector code.  Check that the
+// byte planes, and the pixels that are reconstructed from them, are
+// exactly the same as with the scalar code, which is reproduced
+// here, for line widths that end with a partial vector.
+//
+
+static const int PXR24_HEIGHT = 16;
+
+static uint32_t
+refFloatToFloat24 (uint32_t u)
+{
+    uint32_t s = u & 0x80000000;
+    uint32_t e = u & 0x7f800000;
+    uint32_t m = u & 0x007fffff;
+    uint32_t i;
+
+    if (e == 0x7f800000)
+    {
+        if (m)
+        {
+            m >>= 8;
+            i = (e >> 8) | m | (m == 0);
+        }
+        else
+        {
+            i = e >> 8;
+        }
+    }
+    else
+    {
+        i = ((e | m) + (m & 0x00000080)) >> 8;
+
+        if (i >= 0x7f8000) i = (e | m) >> 8;
+    }
+
+    return (s >> 8) | i;
+}
+
+//
+// The pixels of an image with a FLOAT, a HALF and a UINT channel,
+// stored as the C++ compressor expects them, one scan line of each
+// channel after the other.
+//
+
+struct Pxr24Image
+{
+    int                   width;
+    std::vector<uint32_t> f;
+    std::vector<uint16_t> h;
+    std::vector<uint32_t> u;
+
+    std::vector<char> lines () const
+    {
+        std::vector<char> buf (width * PXR24_HEIGHT * 10);
+        char*             out = buf.data ();
+
+        for (int y = 0; y < PXR24_HEIGHT; ++y)
+        {
+            memcpy (out, &f[y * width], width * 4);
+            out += width * 4;
+            memcpy (out, &h[y * width], width * 2);
+            out += width * 2;
+            memcpy (out, &u[y * width], width * 4);
+            out += width * 4;
+        }
+
+        return buf;
+    }
+};
+
+static uint32_t
+randomUint (Rand32& rand)
+{
+    return ((rand.nexti () >> 16) << 16) | (rand.nexti () >> 16);
+}
+
+static void
+fillPxr24Image (Rand32& rand, int width, Pxr24Image& img)
+{
+    static const uint32_t specials[] = {
+        0x00000000,
+        0x80000000,
+        0x7f800000, // infinity
+        0xff800000,
+        0x7f800001, // NaNs with and without upper significand bits
+        0xff800080,
+        0x7fc00000,
+        0x7f7fffff, // rounding to 24 bits would overflow
+        0xff7fff80,
+        0x7f7fff7f, // the largest values that do not overflow
+        0xff7ffe80,
+        0x00000080, // denormals
+        0x807fffff,
+        0x3f7fff80, // rounding carries into the exponent
+        0x3f8000ff};
+    const int nspecials = sizeof (specials) / sizeof (specials[0]);
+
+    const size_t npixels = (size_t) width * PXR24_HEIGHT;
+
+    img.width = width;
+    img.f.resize (npixels);
+    img.h.resize (npixels);
+    img.u.resize (npixels);
+
+    for (int y = 0; y < PXR24_HEIGHT; ++y)
+    {
+        int mode = rand.nexti () % 3;
+
+        for (int x = 0; x < width; ++x)
+        {
+            size_t i = (size_t) y * width + x;
+
+            switch (mode)
+            {
+                case 0:
+                    // arbitrary bit patterns
+                    img.f[i] = randomUint (rand);
+                    img.h[i] = (uint16_t) (rand.nexti () >> 16);
+                    img.u[i] = randomUint (rand);
+                    break;
+                case 1:
+                    // special values, and differences of either sign
+                    img.f[i] = specials[(rand.nexti () >> 16) % nspecials];
+                    img.h[i] = (uint16_t) img.f[i];
+                    img.u[i] = img.f[i] ^ (rand.nexti () >> 24);
+                    break;
+                default:
+                    // slowly varying values
+                    img.f[i] = 0x3f800000 + x * 0x1234 + y;
+                    img.h[i] = (uint16_t) (0x3c00 + x * 3 + y);
+                    img.u[i] = (uint32_t) (x * x - y);
+                    break;
+            }
+        }
+    }
+}
+
+static std::vector<uint8_t>
+refPxr24Split (const Pxr24Image& img)
+{
+    const int            w = img.width;
+    std::vector<uint8_t> out (w * PXR24_HEIGHT * 9);
+    uint8_t*             p = out.data ();
+
+    for (int y = 0; y < PXR24_HEIGHT; ++y)
+    {
+        uint32_t prev = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            uint32_t v    = refFloatToFloat24 (img.f[y * w + x]);
+            uint32_t diff = v - prev;
+            prev          = v;
+
+            p[x]         = (uint8_t) (diff >> 16);
+            p[w + x]     = (uint8_t) (diff >> 8);
+            p[2 * w + x] = (uint8_t) diff;
+        }
+
+        p += 3 * w;
+        prev = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            uint32_t v    = img.h[y * w + x];
+            uint32_t diff = v - prev;
+            prev          = v;
+
+            p[x]     = (uint8_t) (diff >> 8);
+            p[w + x] = (uint8_t) diff;
+        }
+
+        p += 2 * w;
+        prev = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            uint32_t v    = img.u[y * w + x];
+            uint32_t diff = v - prev;
+            prev          = v;
+
+            p[x]         = (uint8_t) (diff >> 24);
+            p[w + x]     = (uint8_t) (diff >> 16);
+            p[2 * w + x] = (uint8_t) (diff >> 8);
+            p[3 * w + x] = (uint8_t) diff;
+        }
+
+        p += 4 * w;
+    }
+
+    return out;
+}
+
+static void
+refPxr24Join (const std::vector<uint8_t>& planes, int w, Pxr24Image& img)
+{
+    const uint8_t* p = planes.data ();
+
+    img.width = w;
+    img.f.resize ((size_t) w * PXR24_HEIGHT);
+    img.h.resize ((size_t) w * PXR24_HEIGHT);
+    img.u.resize ((size_t) w * PXR24_HEIGHT);
+
+    for (int y = 0; y < PXR24_HEIGHT; ++y)
+    {
+        uint32_t pixel = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            pixel += ((uint32_t) p[x] << 24) | ((uint32_t) p[w + x] << 16) |
+                     ((uint32_t) p[2 * w + x] << 8);
+            img.f[y * w + x] = pixel;
+        }
+
+        p += 3 * w;
+        pixel = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            pixel += ((uint32_t) p[x] << 8) | p[w + x];
+            img.h[y * w + x] = (uint16_t) pixel;
+        }
+
+        p += 2 * w;
+        pixel = 0;
+
+        for (int x = 0; x < w; ++x)
+        {
+            pixel += ((uint32_t) p[x] << 24) | ((uint32_t) p[w + x] << 16) |
+                     ((uint32_t) p[2 * w + x] << 8) | p[3 * w + x];
+            img.u[y * w + x] = pixel;
+        }
+
+        p += 4 * w;
+    }
+}
+
+static std::vector<uint8_t>
+inflatePxr24 (const void* data, size_t size, size_t expectedSize)
+{
+    std::vector<uint8_t> out (expectedSize + 1);
+    uLongf               outSize = (uLongf) out.size ();
+
+    EXRCORE_TEST (
+        uncompress (out.data (), &outSize, (const Bytef*) data, (uLong) size) ==
+        Z_OK);
+    out.resize (outSize);
+    return out;
+}
+
+static std::vector<uint8_t>
+deflatePxr24 (const std::vector<uint8_t>& planes)
+{
+    std::vector<uint8_t> out (compressBound ((uLong) planes.size ()));
+    uLongf               outSize = (uLongf) out.size ();
+
+    EXRCORE_TEST (
+        compress (
+            out.data (), &outSize, planes.data (), (uLong) planes.size ()) ==
+        Z_OK);
+    out.resize (outSize);
+    return out;
+}
+
+static exr_context_t
+startPxr24Core (const std::string& filename, int width)
+{
+    exr_context_t             f;
+    int                       partidx;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &f, filename.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (f, "scan", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        f, partidx, width, PXR24_HEIGHT, EXR_COMPRESSION_PXR24));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "F", EXR_PIXEL_FLOAT, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "H", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "U", EXR_PIXEL_UINT, EXR_PERCEPTUALLY_LINEAR, 1, 1));
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    return f;
+}
+
+static void
+setPxr24Strides (exr_coding_channel_info_t* channels, int width)
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        int size = channels[c].bytes_per_element;
+
+        channels[c].user_bytes_per_element = size;
+        channels[c].user_data_type         = channels[c].data_type;
+        channels[c].user_pixel_stride      = size;
+        channels[c].user_line_stride       = width * size;
+    }
+}
+
+static void
+encodePxr24Core (const std::string& filename, const Pxr24Image& img)
+{
+    exr_context_t         f = startPxr24Core (filename, img.width);
+    exr_chunk_info_t      cinfo;
+    exr_encode_pipeline_t encoder;
+
+    EXRCORE_TEST_RVAL (exr_write_scanline_chunk_info (f, 0, 0, &cinfo));
+    EXRCORE_TEST (cinfo.height == PXR24_HEIGHT);
+    EXRCORE_TEST_RVAL (exr_encoding_initialize (f, 0, &cinfo, &encoder));
+    EXRCORE_TEST (encoder.channel_count == 3);
+    setPxr24Strides (encoder.channels, img.width);
+    encoder.channels[0].encode_from_ptr = (const uint8_t*) img.f.data ();
+    encoder.channels[1].encode_from_ptr = (const uint8_t*) img.h.data ();
+    encoder.channels[2].encode_from_ptr = (const uint8_t*) img.u.data ();
+    EXRCORE_TEST_RVAL (exr_encoding_choose_default_routines (f, 0, &encoder));
+    EXRCORE_TEST_RVAL (exr_encoding_run (f, 0, &encoder));
+    EXRCORE_TEST_RVAL (exr_encoding_destroy (f, &encoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static void
+writePxr24Core (
+    const std::string& filename, int width, const std::vector<uint8_t>& packed)
+{
+    exr_context_t f = startPxr24Core (filename, width);
+
+    EXRCORE_TEST_RVAL (
+        exr_write_scanline_chunk (f, 0, 0, packed.data (), packed.size ()));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static void
+readPxr24Core (
+    const std::string&    filename,
+    int                   width,
+    std::vector<uint8_t>& packed,
+    Pxr24Image&           img)
+{
+    exr_context_t             f;
+    exr_chunk_info_t          cinfo;
+    exr_decode_pipeline_t     decoder;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, filename.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, 0, &cinfo));
+    EXRCORE_TEST (
+        cinfo.unpacked_size == (uint64_t) (width * PXR24_HEIGHT * 10));
+
+    packed.resize (cinfo.packed_size);
+    EXRCORE_TEST_RVAL (exr_read_chunk (f, 0, &cinfo, packed.data ()));
+
+    img.width = width;
+    img.f.assign ((size_t) width * PXR24_HEIGHT, 0);
+    img.h.assign ((size_t) width * PXR24_HEIGHT, 0);
+    img.u.assign ((size_t) width * PXR24_HEIGHT, 0);
+
+    EXRCORE_TEST_RVAL (exr_decoding_initialize (f, 0, &cinfo, &decoder));
+    EXRCORE_TEST (decoder.channel_count == 3);
+    setPxr24Strides (decoder.channels, width);
+    decoder.channels[0].decode_to_ptr = (uint8_t*) img.f.data ();
+    decoder.channels[1].decode_to_ptr = (uint8_t*) img.h.data ();
+    decoder.channels[2].decode_to_ptr = (uint8_t*) img.u.data ();
+    EXRCORE_TEST_RVAL (exr_decoding_choose_default_routines (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+static bool
+operator== (const Pxr24Image& a, const Pxr24Image& b)
+{
+    return a.width == b.width && a.f == b.f && a.h == b.h && a.u == b.u;
+}
+
+void
+testPxr24SimdCompression (const std::string& tempdir)
+{
+    const std::string filename = tempdir + "imf_test_pxr24_exact.exr";
+    Rand32            rand (24);
+
+    for (int width: {1, 15, 16, 17, 47, 64, 301})
+    {
+        const size_t unpackedSize = (size_t) width * PXR24_HEIGHT * 10;
+        const size_t planesSize   = (size_t) width * PXR24_HEIGHT * 9;
+
+        Header hdr (width, PXR24_HEIGHT);
+        hdr.compression () = PXR24_COMPRESSION;
+        hdr.channels ().insert ("F", Channel (IMF::FLOAT));
+        hdr.channels ().insert ("H", Channel (IMF::HALF));
+        hdr.channels ().insert ("U", Channel (IMF::UINT));
+
+        std::unique_ptr<Compressor> cppcomp (
+            newCompressor (hdr.compression (), width * 10, hdr));
+        EXRCORE_TEST (cppcomp->numScanLines () == PXR24_HEIGHT);
+        EXRCORE_TEST (cppcomp->format () == Compressor::NATIVE);
+
+        for (int round = 0; round < 4; ++round)
+        {
+            //
+            // Compress an image, and compare the byte planes with
+            // the reference conversion.
+            //
+
+            Pxr24Image image;
+            fillPxr24Image (rand, width, image);
+
+            std::vector<uint8_t> expected = refPxr24Split (image);
+            std::vector<char>    lines    = image.lines ();
+            const char*          out;
+
+            int outSize = cppcomp->compress (
+                lines.data (), (int) unpackedSize, 0, out);
+
+            EXRCORE_TEST (inflatePxr24 (out, outSize, planesSize) == expected);
+
+            std::vector<uint8_t> packed;
+            Pxr24Image           decoded;
+
+            encodePxr24Core (filename, image);
+            readPxr24Core (filename, width, packed, decoded);
+            EXRCORE_TEST (packed.size () < unpackedSize);
+            EXRCORE_TEST (
+                inflatePxr24 (packed.data (), packed.size (), planesSize) ==
+                expected);
+
+            //
+            // Uncompress the byte planes of the image, and arbitrary
+            // byte planes, and compare the results with the reference
+            // conversion.
+            //
+
+            std::vector<uint8_t> arbitrary (planesSize);
+
+            for (auto& b: arbitrary)
+                b = (uint8_t) (rand.nexti () >> 24);
+
+            for (const std::vector<uint8_t>* planes: {&expected, &arbitrary})
+            {
+                Pxr24Image ref;
+                refPxr24Join (*planes, width, ref);
+
+                std::vector<uint8_t> compressed = deflatePxr24 (*planes);
+                EXRCORE_TEST (compressed.size () < unpackedSize);
+
+                outSize = cppcomp->uncompress (
+                    (const char*) compressed.data (),
+                    (int) compressed.size (),
+                    0,
+                    out);
+
+                EXRCORE_TEST (outSize == (int) unpackedSize);
+                EXRCORE_TEST (
+                    memcmp (out, ref.lines ().data (), unpackedSize) == 0);
+
+                writePxr24Core (filename, width, compressed);
+                readPxr24Core (filename, width, packed, decoded);
+                EXRCORE_TEST (packed == compressed);
+                EXRCORE_TEST (decoded == ref);
+            }
+        }
+    }
+
+    remove (filename.c_str ());
+}
+
+////////////////////////////////////////
+
+//
+// The RLE compressors in the C++ library and in the core find runs
+// and undo the predictor with vector code.  Check that they produce
+// and decode exactly the same bytes as the scalar code, which is
+// reproduced here.  Decoding undoes the predictor with a prefix sum;
+// unless the libraries are compiled for SSE4.1, that is the SSE2
+// version.
+//
+
+static std::vector<uint8_t>
+refRleCompress (const std::vector<uint8_t>& in)
+{
+    const int            minRunLength = 3;
+    const int            maxRunLength = 127;
+    const int            inLength     = (int) in.size ();
+    std::vector<uint8_t> out;
+
+    int runStart = 0;
+    int runEnd   = 1;
+
+    while (runStart < inLength)
+    {
+        while (runEnd < inLength && in[runStart] == in[runEnd] &&
+               runEnd - runStart - 1 < maxRunLength)
+        {
+            ++runEnd;
+        }
+
+        if (runEnd - runStart >= minRunLength)
+        {
+            out.push_back ((uint8_t) (runEnd - runStart - 1));
+            out.push_back (in[runStart]);
+            runStart = runEnd;
+        }
+        else
+        {
+            while (runEnd < inLength &&
+                   ((runEnd + 1 >= inLength || in[runEnd] != in[runEnd + 1]) ||
+                    (runEnd + 2 >= inLength ||
+                     in[runEnd + 1] != in[runEnd + 2])) &&
+                   runEnd - runStart < maxRunLength)
+            {
+                ++runEnd;
+            }
+
+            out.push_back ((uint8_t) (runStart - runEnd));
+
+            while (runStart < runEnd)
+                out.push_back (in[runStart++]);
+        }
+
+        ++runEnd;
+    }
+
+    return out;
+}
+
+static std::vector<uint8_t>
+refRleUncompress (const std::vector<uint8_t>& in)
+{
+    std::vector<uint8_t> out;
+    size_t               i = 0;
+
+    while (i < in.size ())
+    {
+        int count = (int8_t) in[i++];
+
+        if (count < 0)
+        {
+            out.insert (out.end (), &in[i], &in[i] + -count);
+            i += -count;
+        }
+        else
+        {
+            out.insert (out.end (), count + 1, in[i++]);
+        }
+    }
+
+    return out;
+}
+
+//
+// Reorder the bytes of raw data and apply the predictor, and undo it.
+//
+
+static std::vector<uint8_t>
+refDeconstructBytes (const std::vector<uint8_t>& raw)
+{
+    const size_t         n = raw.size ();
+    std::vector<uint8_t> out (n);
+
+    for (size_t i = 0; i < n; ++i)
+        out[(i % 2) ? (n + 1) / 2 + i / 2 : i / 2] = raw[i];
+
+    for (size_t i = n; i-- > 1;)
+        out[i] = (uint8_t) (out[i] - out[i - 1] + 128);
+
+    return out;
+}
+
+static std::vector<uint8_t>
+refReconstructBytes (std::vector<uint8_t> buf)
+{
+    const size_t         n = buf.size ();
+    std::vector<uint8_t> raw (n);
+
+    for (size_t i = 1; i < n; ++i)
+        buf[i] = (uint8_t) (buf[i - 1] + buf[i] - 128);
+
+    for (size_t i = 0; i < n; ++i)
+        raw[i] = buf[(i % 2) ? (n + 1) / 2 + i / 2 : i / 2];
+
+    return raw;
+}
+
+//
+// Predicted bytes with runs of all lengths, including runs that are
+// longer than an RLE run or that straddle vector boundaries, and
+// literal runs that nearly, but not quite, contain equal runs.
+//
+
+static std::vector<uint8_t>
+fillRleBytes (Rand32& rand, size_t size)
+{
+    std::vector<uint8_t> out;
+
+    while (out.size () < size)
+    {
+        uint8_t b = (uint8_t) (rand.nexti () >> 24);
+
+        switch (rand.nexti () % 5)
+        {
+            case 0:
+                // noise
+                for (int n = rand.nexti () % 40; n > 0; --n)
+                    out.push_back ((uint8_t) (rand.nexti () >> 24));
+                break;
+            case 1:
+                // short runs
+                out.insert (out.end (), 1 + rand.nexti () % 4, b);
+                break;
+            case 2:
+                // long runs
+                out.insert (out.end (), 100 + rand.nexti () % 200, b);
+                break;
+            case 3:
+                // pairs of equal bytes
+                for (int n = rand.nexti () % 20; n > 0; --n)
+                    out.insert (out.end (), 2, (uint8_t) (b + n));
+                break;
+            default:
+                // flat areas
+                out.insert (out.end (), rand.nexti () % 40, 128);
+                break;
+        }
+    }
+
+    out.resize (size);
+    return out;
+}
+
+//
+// A valid RLE stream of arbitrary runs that decodes to size bytes.
+//
+
+static std::vector<uint8_t>
+fillRleStream (Rand32& rand, size_t size)
+{
+    std::vector<uint8_t> out;
+    size_t               decoded = 0;
+
+    while (decoded < size)
+    {
+        int count = 1 + rand.nexti () % 128;
+
+        if (rand.nexti () % 2)
+        {
+            count = std::min<int> (count, (int) (size - decoded));
+            out.push_back ((uint8_t) (count - 1));
+            out.push_back ((uint8_t) (rand.nexti () >> 24));
+        }
+        else
+        {
+            count = std::min<int> (count, (int) (size - decoded));
+            count = std::min (count, 127);
+            out.push_back ((uint8_t) -count);
+            for (int i = 0; i < count; ++i)
+                out.push_back ((uint8_t) (rand.nexti () >> 24));
+        }
+
+        decoded += count;
+    }
+
+    return out;
+}
+
+void
+testRleSimdCompression (const std::string& tempdir)
+{
+    const std::string filename = tempdir + "imf_test_rle_exact.exr";
+    Rand32            rand (50);
+
+    for (int width: {1, 7, 8, 9, 16, 17, 63, 64, 65, 500, 4099})
+    {
+        const size_t rawSize = (size_t) width * 2;
+
+        Header hdr (width, 1);
+        hdr.compression () = RLE_COMPRESSION;
+        hdr.channels ().insert ("Y", Channel (IMF::HALF));
+
+        std::unique_ptr<Compressor> cppcomp (
+            newCompressor (hdr.compression (), rawSize, hdr));
+        EXRCORE_TEST (cppcomp->numScanLines () == 1);
+        EXRCORE_TEST (cppcomp->format () == Compressor::XDR);
+
+        for (int round = 0; round < 8; ++round)
+        {
+            //
+            // Compress a line of pixels, and compare the result with
+            // the reference compressor.  The core stores lines that do
+            // not get smaller uncompressed.
+            //
+
+            std::vector<uint8_t> raw =
+                refReconstructBytes (fillRleBytes (rand, rawSize));
+            std::vector<uint8_t> expected =
+                refRleCompress (refDeconstructBytes (raw));
+            std::vector<uint16_t> image (width);
+            std::vector<uint16_t> decoded;
+            std::vector<uint8_t>  packed;
+            const char*           out;
+
+            memcpy (image.data (), raw.data (), rawSize);
+
+            int outSize = cppcomp->compress (
+                (const char*) raw.data (), (int) rawSize, 0, out);
+
+            EXRCORE_TEST (outSize == (int) expected.size ());
+            EXRCORE_TEST (memcmp (out, expected.data (), outSize) == 0);
+
+            encodeHalfCore (filename, EXR_COMPRESSION_RLE, width, 1, image);
+            readHalfCore (filename, width, 1, packed, decoded);
+            EXRCORE_TEST (
+                packed == (expected.size () < rawSize ? expected : raw));
+            EXRCORE_TEST (decoded == image);
+
+            //
+            // Uncompress the compressed line, and an arbitrary stream
+            // of runs, and compare the results with the reference
+            // decompressor.
+            //
+
+            std::vector<uint8_t> arbitrary = fillRleStream (rand, rawSize);
+
+            for (const std::vector<uint8_t>* in: {&expected, &arbitrary})
+            {
+                std::vector<uint8_t> ref =
+                    refReconstructBytes (refRleUncompress (*in));
+
+                EXRCORE_TEST (ref.size () == rawSize);
+
+                outSize = cppcomp->uncompress (
+                    (const char*) in->data (), (int) in->size (), 0, out);
+
+                EXRCORE_TEST (outSize == (int) rawSize);
+                EXRCORE_TEST (memcmp (out, ref.data (), rawSize) == 0);
+
+                if (in->size () >= rawSize) continue;
+
+                memcpy (image.data (), ref.data (), rawSize);
+                writeChunkCore (filename, EXR_COMPRESSION_RLE, width, 1, *in);
+                readHalfCore (filename, width, 1, packed, decoded);
+                EXRCORE_TEST (packed == *in);
+                EXRCORE_TEST (decoded == image);
+            }
+        }
+    }
+
+    remove (filename.c_str ());
+}
+
+////////////////////////////////////////
+
+static void
+readHalfCpp (
+    const std::string&     filename,
+    int                    width,
+    int                    height,
+    std::vector<uint16_t>& pixels)
+{
+    InputFile   in (filename.c_str ());
+    FrameBuffer fb;
+
+    pixels.assign (width * height, 0);
+    fb.insert (
+        "Y",
+        Slice (
+            IMF::HALF,
+            (char*) pixels.data (),
+            sizeof (uint16_t),
+            width * sizeof (uint16_t)));
+    in.setFrameBuffer (fb);
+    in.readPixels (0, height - 1);
+}
+
+void
+testIncompressibleChunks (const std::string& tempdir)
+{
+    //
+    // Like the C++ library, the core must store chunks that do not
+    // get smaller uncompressed: readers take a packed size that is
+    // equal to the unpacked size to mean that a chunk is stored
+    // uncompressed, and reject larger packed sizes.  Noise does not
+    // compress with the lossless methods, and a single 4 by 4 block
+    // of B44 data is larger than a 2 by 2 pixel image.
+    //
+
+    struct
+    {
+        exr_compression_t comp;
+        int               width;
+        int               height;
+    } cases[] = {
+        {EXR_COMPRESSION_RLE, 64, 1},
+        {EXR_COMPRESSION_ZIPS, 64, 1},
+        {EXR_COMPRESSION_ZIP, 64, 16},
+        {EXR_COMPRESSION_PXR24, 64, 16},
+        {EXR_COMPRESSION_B44, 2, 2},
+        {EXR_COMPRESSION_B44A, 2, 2}};
+
+    const std::string filename = tempdir + "imf_test_incompressible.exr";
+    Rand32            rand (17);
+
+    for (const auto& c: cases)
+    {
+        std::vector<uint16_t> image (c.width * c.height);
+        std::vector<uint16_t> decoded;
+        std::vector<uint8_t>  packed;
+
+        for (auto& p: image)
+            p = (uint16_t) (rand.nexti () >> 16);
+
+        encodeHalfCore (filename, c.comp, c.width, c.height, image);
+        readHalfCore (filename, c.width, c.height, packed, decoded);
+        EXRCORE_TEST (packed.size () == image.size () * 2);
+        EXRCORE_TEST (decoded == image);
+
+        readHalfCpp (filename, c.width, c.height, decoded);
+        EXRCORE_TEST (decoded == image);
+    }
+
+    remove (filename.c_str ());
+}
+
+void
+testB44UncompressedChunks (const std::string& tempdir)
+{
+    //
+    // The C++ library stores B44 and B44A chunks that do not get
+    // smaller uncompressed, like chunks of the other methods.  The
+    // core must read them as they are, not as compressed blocks.
+    //
+
+    const std::string filename = tempdir + "imf_test_b44_uncompressed.exr";
+    const int         width = 2, height = 2;
+    Rand32            rand (23);
+
+    for (Compression comp: {B44_COMPRESSION, B44A_COMPRESSION})
+    {
+        std::vector<uint16_t> image (width * height);
+        std::vector<uint16_t> decoded;
+        std::vector<uint8_t>  packed;
+
+        //
+        // Finite values with all mantissa bits in use, which B44
+        // compression would not preserve.
+        //
+
+        for (auto& p: image)
+            p = (uint16_t) (((rand.nexti () >> 16) & 0xbfff) | 0x3ff);
+
+        Header hdr (width, height);
+        hdr.compression () = comp;
+        hdr.channels ().insert ("Y", Channel (IMF::HALF));
+
+        {
+            OutputFile  out (filename.c_str (), hdr);
+            FrameBuffer fb;
+
+            fb.insert (
+                "Y",
+                Slice (
+                    IMF::HALF,
+                    (char*) image.data (),
+                    sizeof (uint16_t),
+                    width * sizeof (uint16_t)));
+            out.setFrameBuffer (fb);
+            out.writePixels (height);
+        }
+
+        readHalfCore (filename, width, height, packed, decoded);
+        EXRCORE_TEST (packed.size () == image.size () * 2);
+        EXRCORE_TEST (decoded == image);
+    }
+
+    remove (filename.c_str ());
+}
+
+void
+testEncodePackedChunks (const std::string& tempdir)
+{
+    //
+    // exr_encoding_run () compresses data that the caller has
+    // already packed if convert_and_pack_fn is NULL.
+    //
+
+    const std::string filename = tempdir + "imf_test_encode_packed.exr";
+    const int         width = 64, height = 16;
+
+    std::vector<uint16_t> image (width * height);
+    std::vector<uint8_t>  packedIn (image.size () * 2);
+
+    for (size_t i = 0; i < image.size (); ++i)
+    {
+        image[i]            = (uint16_t) (0x3c00 + i / 8);
+        packedIn[2 * i]     = (uint8_t) image[i];
+        packedIn[2 * i + 1] = (uint8_t) (image[i] >> 8);
+    }
+
+    exr_context_t         f;
+    exr_chunk_info_t      cinfo;
+    exr_encode_pipeline_t encoder;
+
+    f = startHalfCore (filename, EXR_COMPRESSION_ZIP, width, height);
+
+    EXRCORE_TEST_RVAL (exr_write_scanline_chunk_info (f, 0, 0, &cinfo));
+    EXRCORE_TEST_RVAL (exr_encoding_initialize (f, 0, &cinfo, &encoder));
+    encoder.channels[0].encode_from_ptr   = packedIn.data ();
+    encoder.channels[0].user_pixel_stride = 2;
+    encoder.channels[0].user_line_stride  = width * 2;
+    EXRCORE_TEST_RVAL (exr_encoding_choose_default_routines (f, 0, &encoder));
+
+    encoder.convert_and_pack_fn = NULL;
+    encoder.packed_buffer       = packedIn.data ();
+    encoder.packed_bytes        = packedIn.size ();
+    encoder.packed_alloc_size   = 0;
+    EXRCORE_TEST_RVAL (exr_encoding_run (f, 0, &encoder));
+    EXRCORE_TEST (encoder.compressed_bytes < packedIn.size ());
+
+    encoder.packed_buffer = NULL;
+    EXRCORE_TEST_RVAL (exr_encoding_destroy (f, &encoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    std::vector<uint16_t> decoded;
+    std::vector<uint8_t>  packed;
+
+    readHalfCore (filename, width, height, packed, decoded);
+    EXRCORE_TEST (packed.size () < packedIn.size ());
+    EXRCORE_TEST (decoded == image);
+
+    remove (filename.c_str ());
+}
+
 void
 testDWAACompression (const std::string& tempdir)
 {
@@ -16,6 +16,12 @@ void testPIZCompression (const std::string& tempdir);
 void testPXR24Compression (const std::string& tempdir);
 void testB44Compression (const std::string& tempdir);
 void testB44ACompression (const std::string& tempdir);
+void testB44SimdCompression (const std::string& tempdir);
+void testPxr24SimdCompression (const std::string& tempdir);
+void testRleSimdCompression (const std::string& tempdir);
+void testIncompressibleChunks (const std::string& tempdir);
+void testB44UncompressedChunks (const std::string& tempdir);
+void testEncodePackedChunks (const std::string& tempdir);
 void testDWAACompression (const std::string& tempdir);
 void testDWABCompression (const std::string& tempdir);
 
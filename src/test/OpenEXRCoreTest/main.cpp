@@ -172,6 +172,7 @@ main (int argc, char* argv[])
     TEST (testReadMultiPart, "core_read");
     TEST (testReadDeep, "core_read");
     TEST (testReadUnpack, "core_read");
+    TEST (testReadStats, "core_read");
 
     TEST (testWriteBadArgs, "core_write");
     TEST (testWriteBadFiles, "core_write");
@@ -184,6 +185,8 @@ main (int argc, char* argv[])
     TEST (testStartWriteDeepTile, "core_write");
     TEST (testWriteScans, "core_write");
     TEST (testWriteTiles, "core_write");
+    TEST (testWriteTileClipping, "core_write");
+    TEST (testWriteRipmapTiles, "core_write");
     TEST (testWriteMultiPart, "core_write");
     TEST (testWriteDeep, "core_write");
 
@@ -196,6 +199,12 @@ main (int argc, char* argv[])
     TEST (testPXR24Compression, "core_compression");
     TEST (testB44Compression, "core_compression");
     TEST (testB44ACompression, "core_compression");
+    TEST (testB44SimdCompression, "core_compression");
+    TEST (testPxr24SimdCompression, "core_compression");
+    TEST (testRleSimdCompression, "core_compression");
+    TEST (testIncompressibleChunks, "core_compression");
+    TEST (testB44UncompressedChunks, "core_compression");
+    TEST (testEncodePackedChunks, "core_compression");
     TEST (testDWAACompression, "core_compression");
     TEST (testDWABCompression, "core_compression");
 
@@ -590,3 +590,82 @@ testReadUnpack (const std::string& tempdir)
 
     exr_finish (&f);
 }
+
+void
+testReadStats (const std::string&)
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    exr_stats_t stats, global;
+
+    fn += "v1.7.test.interleaved.exr";
+
+    /* without the flag, nothing is collected */
+    exr_reset_global_stats ();
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_MISSING_CONTEXT_ARG, exr_get_stats (NULL, &stats));
+    EXRCORE_TEST_RVAL_FAIL (EXR_ERR_INVALID_ARGUMENT, exr_get_stats (f, NULL));
+    EXRCORE_TEST_RVAL (exr_get_stats (f, &stats));
+    EXRCORE_TEST (stats.size == sizeof (exr_stats_t));
+    EXRCORE_TEST (stats.reads == 0 && stats.bytes_read == 0);
+    exr_finish (&f);
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT, exr_get_global_stats (NULL));
+    EXRCORE_TEST_RVAL (exr_get_global_stats (&global));
+    EXRCORE_TEST (global.reads == 0 && global.bytes_read == 0);
+
+    cinit.flags |= EXR_CONTEXT_FLAG_COLLECT_STATS;
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+
+    /* reading the header and the chunk table counts */
+    EXRCORE_TEST_RVAL (exr_get_stats (f, &stats));
+    EXRCORE_TEST (stats.reads > 0 && stats.bytes_read > 0);
+    EXRCORE_TEST (stats.chunks_decoded[EXR_COMPRESSION_NONE] == 0);
+
+    exr_chunk_info_t cinfo;
+    exr_attr_box2i_t dw;
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+    EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, dw.min.y, &cinfo));
+
+    exr_decode_pipeline_t decoder;
+    EXRCORE_TEST_RVAL (exr_decoding_initialize (f, 0, &cinfo, &decoder));
+
+    std::unique_ptr<uint8_t[]> rptr{new uint8_t[178 * 2]};
+    std::unique_ptr<uint8_t[]> zptr{new uint8_t[178 * 4]};
+    decoder.channels[0].decode_to_ptr     = rptr.get ();
+    decoder.channels[0].user_pixel_stride = 2;
+    decoder.channels[0].user_line_stride  = 2 * 178;
+    decoder.channels[1].decode_to_ptr     = zptr.get ();
+    decoder.channels[1].user_pixel_stride = 4;
+    decoder.channels[1].user_line_stride  = 4 * 178;
+
+    EXRCORE_TEST_RVAL (exr_decoding_choose_default_routines (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+
+    EXRCORE_TEST_RVAL (exr_get_stats (f, &stats));
+    EXRCORE_TEST (stats.chunks_decoded[EXR_COMPRESSION_NONE] == 1);
+    EXRCORE_TEST (stats.bytes_decompressed == 178 * (2 + 4));
+    EXRCORE_TEST (stats.writes == 0 && stats.bytes_written == 0);
+    for (int c = 0; c < EXR_COMPRESSION_LAST_TYPE; ++c)
+        EXRCORE_TEST (stats.chunks_encoded[c] == 0);
+    for (int c = EXR_COMPRESSION_LAST_TYPE; c < EXR_STATS_COMPRESSION_SLOTS;
+         ++c)
+        EXRCORE_TEST (stats.chunks_decoded[c] == 0);
+
+    EXRCORE_TEST_RVAL (exr_get_global_stats (&global));
+    EXRCORE_TEST (global.reads == stats.reads);
+    EXRCORE_TEST (global.bytes_read == stats.bytes_read);
+    EXRCORE_TEST (global.chunks_decoded[EXR_COMPRESSION_NONE] == 1);
+
+    exr_reset_global_stats ();
+    EXRCORE_TEST_RVAL (exr_get_global_stats (&global));
+    EXRCORE_TEST (global.reads == 0);
+
+    exr_finish (&f);
+}
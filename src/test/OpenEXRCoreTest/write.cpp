@@ -12,9 +12,12 @@
 #include <math.h>
 #include <string.h>
 
+#include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 static void
 err_cb (exr_const_context_t f, exr_result_t code, const char* msg)
@@ -1244,7 +1247,59 @@ testWriteAttrs (const std::string& tempdir)
 
 void
 testUpdateMeta (const std::string& tempdir)
-{}
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    std::string               outfn = tempdir + "v1.7.test.1.exr";
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    exr_chunk_info_t          cinfo;
+    uint64_t                  chunksize;
+    float                     fval;
+    cinit.error_handler_fn = &err_cb;
+
+    fn += "v1.7.test.1.exr";
+
+    {
+        std::ifstream in (fn.c_str (), std::ios::binary);
+        std::ofstream out (outfn.c_str (), std::ios::binary);
+        out << in.rdbuf ();
+    }
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_inplace_header_update (NULL, outfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_inplace_header_update (&f, NULL, &cinit));
+
+    EXRCORE_TEST_RVAL (
+        exr_start_inplace_header_update (&f, outfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_attr_set_float (f, 0, "screenWindowWidth", 2.5f));
+
+    /* attributes can not be added or change type */
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_NO_ATTR_BY_NAME, exr_attr_set_int (f, 0, "newattr", 3));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_ATTR_TYPE_MISMATCH,
+        exr_attr_set_int (f, 0, "screenWindowWidth", 3));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_NOT_OPEN_WRITE,
+        exr_set_compression (f, 0, EXR_COMPRESSION_NONE));
+
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    /* the pixel data must not have moved */
+    EXRCORE_TEST_RVAL (exr_start_read (&f, outfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_attr_get_float (f, 0, "screenWindowWidth", &fval));
+    EXRCORE_TEST (fval == 2.5f);
+    EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, 20, &cinfo));
+    EXRCORE_TEST_RVAL (exr_get_chunk_unpacked_size (f, 0, &chunksize));
+    EXRCORE_TEST (cinfo.unpacked_size == chunksize);
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    remove (outfn.c_str ());
+}
 
 void
 testWriteScans (const std::string& tempdir)
@@ -1339,6 +1394,163 @@ testWriteTiles (const std::string& tempdir)
     remove (outfn.c_str ());
 }
 
+////////////////////////////////////////
+
+static uint8_t
+tileByte (int tx, int ty, int lx, int ly, size_t i)
+{
+    return (uint8_t) (tx * 7 + ty * 13 + lx * 29 + ly * 31 + i);
+}
+
+static void
+writeTileLevels (
+    const std::string&    tempdir,
+    exr_tile_level_mode_t levelmode,
+    exr_tile_round_mode_t roundmode)
+{
+    exr_context_t             f;
+    std::string               fn = tempdir + "testtilelevels.exr";
+    int                       partidx;
+    int32_t                   levelsx, levelsy, levw, levh;
+    exr_attr_box2i_t          dw    = {{3, -2}, {39, 20}};
+    exr_attr_v2f_t            swc   = {0.f, 0.f};
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    //
+    // Write an uncompressed, 37 by 23 pixel image with 8 by 8 tiles,
+    // so that the last row and column of tiles of most levels are
+    // partial.  The chunk info must describe tiles clipped against
+    // the size of their level, and every tile must map to its own
+    // chunk, in the order of the chunks in the file.
+    //
+
+    EXRCORE_TEST_RVAL (
+        exr_start_write (&f, fn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (exr_add_part (f, "levels", EXR_STORAGE_TILED, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr (
+        f,
+        partidx,
+        &dw,
+        &dw,
+        1.f,
+        &swc,
+        1.f,
+        EXR_LINEORDER_INCREASING_Y,
+        EXR_COMPRESSION_NONE));
+    EXRCORE_TEST_RVAL (
+        exr_set_tile_descriptor (f, partidx, 8, 8, levelmode, roundmode));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "Y", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+
+    EXRCORE_TEST_RVAL (exr_get_tile_levels (f, 0, &levelsx, &levelsy));
+
+    std::vector<uint8_t> data;
+    int                  nchunks = 0;
+
+    for (int ly = 0; ly < levelsy; ++ly)
+    {
+        for (int lx = 0; lx < levelsx; ++lx)
+        {
+            if (levelmode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
+
+            EXRCORE_TEST_RVAL (
+                exr_get_level_sizes (f, 0, lx, ly, &levw, &levh));
+
+            for (int ty = 0; ty * 8 < levh; ++ty)
+            {
+                for (int tx = 0; tx * 8 < levw; ++tx)
+                {
+                    exr_chunk_info_t cinfo;
+
+                    EXRCORE_TEST_RVAL (exr_write_tile_chunk_info (
+                        f, 0, tx, ty, lx, ly, &cinfo));
+                    EXRCORE_TEST (cinfo.width == std::min (8, levw - tx * 8));
+                    EXRCORE_TEST (cinfo.height == std::min (8, levh - ty * 8));
+                    EXRCORE_TEST (
+                        cinfo.unpacked_size ==
+                        (uint64_t) (cinfo.width * cinfo.height * 2));
+
+                    data.resize (cinfo.unpacked_size);
+                    for (size_t i = 0; i < data.size (); ++i)
+                        data[i] = tileByte (tx, ty, lx, ly, i);
+
+                    EXRCORE_TEST_RVAL (exr_write_tile_chunk (
+                        f, 0, tx, ty, lx, ly, data.data (), data.size ()));
+                    ++nchunks;
+                }
+            }
+        }
+    }
+
+    int32_t ccount;
+    EXRCORE_TEST_RVAL (exr_get_chunk_count (f, 0, &ccount));
+    EXRCORE_TEST (ccount == nchunks);
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    //
+    // Read the tiles back.
+    //
+
+    std::vector<uint8_t> readdata;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+
+    for (int ly = 0; ly < levelsy; ++ly)
+    {
+        for (int lx = 0; lx < levelsx; ++lx)
+        {
+            if (levelmode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
+
+            EXRCORE_TEST_RVAL (
+                exr_get_level_sizes (f, 0, lx, ly, &levw, &levh));
+
+            for (int ty = 0; ty * 8 < levh; ++ty)
+            {
+                for (int tx = 0; tx * 8 < levw; ++tx)
+                {
+                    exr_chunk_info_t cinfo;
+
+                    EXRCORE_TEST_RVAL (exr_read_tile_chunk_info (
+                        f, 0, tx, ty, lx, ly, &cinfo));
+                    EXRCORE_TEST (cinfo.level_x == lx);
+                    EXRCORE_TEST (cinfo.level_y == ly);
+                    EXRCORE_TEST (cinfo.width == std::min (8, levw - tx * 8));
+                    EXRCORE_TEST (cinfo.height == std::min (8, levh - ty * 8));
+                    EXRCORE_TEST (cinfo.packed_size == cinfo.unpacked_size);
+
+                    readdata.resize (cinfo.packed_size);
+                    EXRCORE_TEST_RVAL (
+                        exr_read_chunk (f, 0, &cinfo, readdata.data ()));
+
+                    for (size_t i = 0; i < readdata.size (); ++i)
+                        EXRCORE_TEST (
+                            readdata[i] == tileByte (tx, ty, lx, ly, i));
+                }
+            }
+        }
+    }
+
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+    remove (fn.c_str ());
+}
+
+void
+testWriteTileClipping (const std::string& tempdir)
+{
+    writeTileLevels (tempdir, EXR_TILE_ONE_LEVEL, EXR_TILE_ROUND_DOWN);
+    writeTileLevels (tempdir, EXR_TILE_MIPMAP_LEVELS, EXR_TILE_ROUND_DOWN);
+    writeTileLevels (tempdir, EXR_TILE_MIPMAP_LEVELS, EXR_TILE_ROUND_UP);
+}
+
+void
+testWriteRipmapTiles (const std::string& tempdir)
+{
+    writeTileLevels (tempdir, EXR_TILE_RIPMAP_LEVELS, EXR_TILE_ROUND_DOWN);
+    writeTileLevels (tempdir, EXR_TILE_RIPMAP_LEVELS, EXR_TILE_ROUND_UP);
+}
+
 void
 testWriteMultiPart (const std::string& tempdir)
 {
@@ -21,6 +21,8 @@ void testUpdateMeta (const std::string& tempdir);
 
 void testWriteScans (const std::string& tempdir);
 void testWriteTiles (const std::string& tempdir);
+void testWriteTileClipping (const std::string& tempdir);
+void testWriteRipmapTiles (const std::string& tempdir);
 void testWriteMultiPart (const std::string& tempdir);
 
 #endif // OPENEXR_CORE_TEST_WRITE_H
@@ -31,7 +31,9 @@
 #include "testDwaCompressorSimd.h"
 #include "testDwaLookups.h"
 #include "testExistingStreams.h"
+#include "testFileThreadPool.h"
 #include "testFutureProofing.h"
+#include "testHeaderCache.h"
 #include "testHuf.h"
 #include "testIDManifest.h"
 #include "testInputPart.h"
@@ -52,6 +54,7 @@
 #include "testOptimizedInterleavePatterns.h"
 #include "testPartHelper.h"
 #include "testPreviewImage.h"
+#include "testReadAsync.h"
 #include "testRgba.h"
 #include "testRgbaThreading.h"
 #include "testRle.h"
@@ -59,6 +62,8 @@
 #include "testScanLineApi.h"
 #include "testSharedFrameBuffer.h"
 #include "testStandardAttributes.h"
+#include "testStatistics.h"
+#include "testTaskPriority.h"
 #include "testTiledCompression.h"
 #include "testTiledCopyPixels.h"
 #include "testTiledLineOrder.h"
@@ -201,6 +206,11 @@ main (int argc, char* argv[])
     TEST (testScanLineApi, "basic");
     TEST (testExistingStreams, "core");
     TEST (testStandardAttributes, "core");
+    TEST (testStatistics, "basic");
+    TEST (testTaskPriority, "basic");
+    TEST (testFileThreadPool, "basic");
+    TEST (testReadAsync, "basic");
+    TEST (testHeaderCache, "basic");
     TEST (testOptimized, "basic");
     TEST (testOptimizedInterleavePatterns, "basic");
     TEST (testYca, "basic");
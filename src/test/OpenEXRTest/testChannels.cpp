@@ -10,13 +10,20 @@
 #include "half.h"
 #include <ImfArray.h>
 #include <ImfChannelList.h>
+#include <ImfChannelListAttribute.h>
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
+#include <ImfStdIO.h>
+#include <ImfVersion.h>
 
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace std;
@@ -218,6 +225,391 @@ writeRead (
     cout << endl;
 }
 
+string
+aovName (int i)
+{
+    static const char* const components[] = {"R", "G", "B", "A"};
+
+    char buf[64];
+    snprintf (buf, sizeof (buf), "aov%03d.%s", i / 4, components[i % 4]);
+    return buf;
+}
+
+void
+testChannelListOrder (int numChannels)
+{
+    cout << "channel list with " << numChannels << " channels" << endl;
+
+    //
+    // Insert the channels in a scrambled order; iteration must
+    // still visit them in sorted order, exactly as std::map did.
+    //
+
+    vector<string> names;
+
+    for (int i = 0; i < numChannels; ++i)
+        names.push_back (aovName (i));
+
+    vector<string> scrambled (names);
+
+    for (size_t i = 0; i < scrambled.size (); ++i)
+        swap (scrambled[i], scrambled[(i * 7919) % scrambled.size ()]);
+
+    ChannelList channels;
+
+    for (size_t i = 0; i < scrambled.size (); ++i)
+        channels.insert (scrambled[i], Channel (FLOAT));
+
+    sort (names.begin (), names.end ());
+
+    size_t n = 0;
+
+    for (ChannelList::ConstIterator i = channels.begin ();
+         i != channels.end ();
+         ++i, ++n)
+    {
+        assert (names[n] == i.name ());
+        assert (channels.findChannel (names[n]) == &i.channel ());
+        assert (channels.find (names[n]) == i);
+    }
+
+    assert (n == names.size ());
+    assert (channels.findChannel ("aov") == 0);
+    assert (channels.find ("zzz") == channels.end ());
+
+    //
+    // Re-inserting an existing channel replaces it.
+    //
+
+    channels.insert (names[1], Channel (HALF, 2, 2));
+    assert (channels[names[1]].type == HALF);
+    assert (channels[names[1]].xSampling == 2);
+
+    size_t count = 0;
+    for (ChannelList::ConstIterator i = channels.begin ();
+         i != channels.end ();
+         ++i)
+        ++count;
+    assert (count == names.size ());
+
+    //
+    // Layer and prefix queries rely on the sorted order.
+    //
+
+    ChannelList::ConstIterator first, last;
+    channels.channelsInLayer ("aov001", first, last);
+
+    const char* expected[] = {"aov001.A", "aov001.B", "aov001.G", "aov001.R"};
+
+    n = 0;
+    for (ChannelList::ConstIterator i = first; i != last; ++i, ++n)
+        assert (!strcmp (i.name (), expected[n]));
+    assert (n == 4);
+
+    set<string> layers;
+    channels.layers (layers);
+    assert (layers.size () == size_t ((numChannels + 3) / 4));
+
+    //
+    // Names longer than Name::MAX_LENGTH are truncated, both when
+    // inserting and when looking them up.
+    //
+
+    string longName (Name::MAX_LENGTH + 20, 'x');
+    channels.insert (longName, Channel (UINT));
+
+    assert (channels.findChannel (longName) != 0);
+    assert (
+        channels.findChannel (longName.substr (0, Name::MAX_LENGTH)) ==
+        channels.findChannel (longName));
+    assert (channels.findChannel (longName)->type == UINT);
+
+    //
+    // Frame buffers behave the same way.
+    //
+
+    FrameBuffer fb;
+
+    for (size_t i = 0; i < scrambled.size (); ++i)
+        fb.insert (scrambled[i], Slice (FLOAT, (char*) 0, 0, 0));
+
+    n = 0;
+    for (FrameBuffer::ConstIterator i = fb.begin (); i != fb.end (); ++i, ++n)
+    {
+        assert (names[n] == i.name ());
+        assert (fb.findSlice (names[n]) == &i.slice ());
+    }
+
+    assert (n == names.size ());
+    assert (fb.findSlice ("aov") == 0);
+}
+
+void
+writeReadManyChannels (const char fileName[], int numChannels)
+{
+    //
+    // Write a file with many channels and read it back, setting up
+    // the frame buffer from the channel list of the input file.
+    //
+
+    const int width  = 16;
+    const int height = 4;
+
+    cout << "file with " << numChannels << " channels" << endl;
+
+    Header hdr (width, height);
+
+    for (int c = 0; c < numChannels; ++c)
+        hdr.channels ().insert (aovName (c), Channel (FLOAT));
+
+    vector<float> pixels (size_t (numChannels) * width * height);
+
+    {
+        FrameBuffer fb;
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            float* base = &pixels[size_t (c) * width * height];
+
+            for (int i = 0; i < width * height; ++i)
+                base[i] = float (c * 1000 + i);
+
+            fb.insert (
+                aovName (c),
+                Slice (
+                    FLOAT,
+                    (char*) base,
+                    sizeof (float),
+                    sizeof (float) * width));
+        }
+
+        remove (fileName);
+        OutputFile out (fileName, hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (height);
+    }
+
+    {
+        fill (pixels.begin (), pixels.end (), -1.f);
+
+        InputFile in (fileName);
+
+        FrameBuffer fb;
+
+        for (ChannelList::ConstIterator i = in.header ().channels ().begin ();
+             i != in.header ().channels ().end ();
+             ++i)
+        {
+            int c = atoi (i.name () + 3) * 4;
+
+            switch (i.name ()[strlen (i.name ()) - 1])
+            {
+                case 'G': c += 1; break;
+                case 'B': c += 2; break;
+                case 'A': c += 3; break;
+            }
+
+            fb.insert (
+                i.name (),
+                Slice (
+                    FLOAT,
+                    (char*) &pixels[size_t (c) * width * height],
+                    sizeof (float),
+                    sizeof (float) * width));
+        }
+
+        in.setFrameBuffer (fb);
+        in.readPixels (0, height - 1);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < width * height; ++i)
+                assert (
+                    pixels[size_t (c) * width * height + i] ==
+                    float (c * 1000 + i));
+    }
+
+    {
+        //
+        // Read every third channel, interleaved with slices that are
+        // not in the file, so that the channels and the slices only
+        // partly overlap.
+        //
+
+        fill (pixels.begin (), pixels.end (), -1.f);
+
+        vector<float> extra (size_t (numChannels) * width * height, -1.f);
+
+        InputFile   in (fileName);
+        FrameBuffer fb;
+
+        for (int c = 0; c < numChannels; c += 3)
+        {
+            fb.insert (
+                aovName (c),
+                Slice (
+                    FLOAT,
+                    (char*) &pixels[size_t (c) * width * height],
+                    sizeof (float),
+                    sizeof (float) * width));
+
+            fb.insert (
+                aovName (c) + "x",
+                Slice (
+                    FLOAT,
+                    (char*) &extra[size_t (c) * width * height],
+                    sizeof (float),
+                    sizeof (float) * width,
+                    1,
+                    1,
+                    0.5));
+        }
+
+        in.setFrameBuffer (fb);
+        in.readPixels (0, height - 1);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            for (int i = 0; i < width * height; ++i)
+            {
+                size_t k = size_t (c) * width * height + i;
+
+                assert (pixels[k] == (c % 3 ? -1.f : float (c * 1000 + i)));
+                assert (extra[k] == (c % 3 ? -1.f : 0.5f));
+            }
+        }
+
+        //
+        // A slice whose sampling does not match the channel
+        // in the file is rejected.
+        //
+
+        fb.insert (
+            aovName (numChannels - 1),
+            Slice (FLOAT, (char*) &pixels[0], 0, 0, 2, 2));
+
+        bool caught = false;
+
+        try
+        {
+            in.setFrameBuffer (fb);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            caught = true;
+        }
+
+        assert (caught);
+    }
+
+    remove (fileName);
+}
+
+void
+testChannelListAttribute ()
+{
+    cout << "channel list attribute values" << endl;
+
+    ChannelList channels;
+
+    for (int c = 0; c < 40; ++c)
+        channels.insert (aovName (c), Channel (c % 2 ? HALF : FLOAT, 1, 1));
+
+    StdOSStream os;
+    ChannelListAttribute (channels).writeValueTo (os, EXR_VERSION);
+
+    string value = os.str ();
+    int    size  = int (value.size ());
+    string data  = value + "tail";
+
+    //
+    // The list ends at its end of list marker, whether the size field
+    // is right, too small or too large.
+    //
+
+    int sizes[] = {size, size - 5, 1, size + 3};
+
+    for (int s: sizes)
+    {
+        StdISStream is;
+        is.str (data);
+
+        ChannelListAttribute a;
+        a.readValueFrom (is, s, EXR_VERSION);
+
+        assert (a.value () == channels);
+        assert (is.tellg () == uint64_t (size));
+    }
+
+    //
+    // A size field that reaches past the end of the stream is an
+    // error, as for other attribute types.
+    //
+
+    {
+        StdISStream is;
+        is.str (data);
+
+        ChannelListAttribute a;
+        bool                 caught = false;
+
+        try
+        {
+            a.readValueFrom (is, size + 1000, EXR_VERSION);
+        }
+        catch (const IEX_NAMESPACE::InputExc&)
+        {
+            caught = true;
+        }
+
+        assert (caught);
+    }
+
+    //
+    // Unknown pixel types are kept as NUM_PIXELTYPES.
+    //
+
+    {
+        const char* first = channels.begin ().name ();
+        string      bad   = value;
+        bad[strlen (first) + 1] = 7;
+
+        StdISStream is;
+        is.str (bad);
+
+        ChannelListAttribute a;
+        a.readValueFrom (is, size, EXR_VERSION);
+
+        assert (a.value ()[first].type == NUM_PIXELTYPES);
+    }
+
+    //
+    // Names must be at most Name::MAX_LENGTH characters long.
+    //
+
+    string tooLong (Name::SIZE, 'x');
+    string longData = tooLong + string (17, '\0');
+
+    for (int s: {int (longData.size ()), int (Name::SIZE) + 1})
+    {
+        StdISStream is;
+        is.str (longData);
+
+        ChannelListAttribute a;
+        bool                 caught = false;
+
+        try
+        {
+            a.readValueFrom (is, s, EXR_VERSION);
+        }
+        catch (const IEX_NAMESPACE::InputExc&)
+        {
+            caught = true;
+        }
+
+        assert (caught);
+    }
+}
+
 } // namespace
 
 void
@@ -238,6 +630,14 @@ testChannels (const std::string& tempDir)
 
         writeRead (ph1, ph2, filename.c_str (), W, H);
 
+        cout << "Testing files with many channels" << endl;
+
+        testChannelListOrder (16);
+        testChannelListOrder (1203);
+
+        writeReadManyChannels (filename.c_str (), 400);
+        testChannelListAttribute ();
+
         cout << "ok\n" << endl;
     }
     catch (const std::exception& e)
@@ -14,13 +14,17 @@
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
+#include <ImfMisc.h>
 #include <ImfOutputFile.h>
 #include <ImfTiledInputFile.h>
 #include <ImfTiledOutputFile.h>
+#include <ImfXdr.h>
 #include <half.h>
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 
 namespace IMF = OPENEXR_IMF_NAMESPACE;
 using namespace IMF;
@@ -121,6 +125,381 @@ testNumbers ()
     testUintToHalf (0xffffffff, 0x7c00);
 }
 
+//
+// Functions to test the row copy kernels returned by
+// findCopyIntoFrameBuffer() and findCopyFromFrameBuffer()
+// against the conversion functions in ImfConvert.h, for all
+// combinations of pixel types, buffer formats and strides.
+//
+
+template <class T> struct PixelTypeOf;
+
+template <> struct PixelTypeOf<unsigned int>
+{
+    static const PixelType type = IMF::UINT;
+};
+
+template <> struct PixelTypeOf<half>
+{
+    static const PixelType type = IMF::HALF;
+};
+
+template <> struct PixelTypeOf<float>
+{
+    static const PixelType type = IMF::FLOAT;
+};
+
+template <class T>
+T
+testValue (int i)
+{
+    //
+    // A mix of ordinary values and values that need clamping
+    // when they are converted to other types.
+    //
+
+    switch (i % 8)
+    {
+        case 0: return T (float (i));
+        case 1: return T (float (i) * 0.25f);
+        case 2: return T (float (i) * 1000.0f);
+        case 3: return T (float (i) + 65500.0f);
+        default: return T (float (i % 2048));
+    }
+}
+
+template <>
+unsigned int
+testValue<unsigned int> (int i)
+{
+    //
+    // Values above 2^24 cannot all be represented exactly as floats.
+    //
+
+    switch (i % 8)
+    {
+        case 0: return unsigned (i);
+        case 1: return unsigned (i) * 1000U;
+        case 2: return unsigned (i) + 65500U;
+        case 3: return 0xffffffffU - unsigned (i) * 12345U;
+        case 4: return 0x80000000U + unsigned (i) * 54321U;
+        default: return unsigned (i % 2048);
+    }
+}
+
+template <>
+float
+testValue<float> (int i)
+{
+    //
+    // The special values are placed after the first three groups of
+    // eight pixels, so that the vector kernels see both groups that
+    // they convert themselves and groups that they hand back to the
+    // scalar code.
+    //
+
+    static const unsigned int special[] = {
+        0x7fc00000, // quiet NaN
+        0xff800000, // -infinity
+        0x4f32d05e, // 3e9, which does not fit in 31 bits
+        0x477fef00, // 65519, rounds to HALF_MAX but converts to infinity
+        0x7f812345, // NaN with a payload
+        0x7f800000, // infinity
+    };
+
+    switch (i % 8)
+    {
+        case 0: return -float (i);
+        case 1: return float (i) * 0.25f;
+        case 2: return float (i) * 1e6f;
+        case 3: return float (i) + 65500.0f;
+        case 4: return float (i) * 1e-7f;
+        case 5:
+
+            if (i >= 24)
+            {
+                float f;
+                memcpy (&f, &special[(i / 8) % 6], sizeof (f));
+                return f;
+            }
+
+            return float (i);
+
+        default: return float (i % 2048);
+    }
+}
+
+template <>
+half
+testValue<half> (int i)
+{
+    switch (i % 8)
+    {
+        case 0: return -half (float (i % 2048));
+        case 1: return half (float (i) * 0.25f);
+        case 2: return half::posInf ();
+        case 3: return half (float (i % 100) * 1e-6f);
+        default: return half (float (i % 2048));
+    }
+}
+
+inline void
+convert (unsigned int& out, unsigned int in)
+{
+    out = in;
+}
+
+inline void
+convert (unsigned int& out, half in)
+{
+    out = halfToUint (in);
+}
+
+inline void
+convert (unsigned int& out, float in)
+{
+    out = floatToUint (in);
+}
+
+inline void
+convert (half& out, unsigned int in)
+{
+    out = uintToHalf (in);
+}
+
+inline void
+convert (half& out, half in)
+{
+    out = in;
+}
+
+inline void
+convert (half& out, float in)
+{
+    out = floatToHalf (in);
+}
+
+inline void
+convert (float& out, unsigned int in)
+{
+    out = float (in);
+}
+
+inline void
+convert (float& out, half in)
+{
+    out = float (in);
+}
+
+inline void
+convert (float& out, float in)
+{
+    out = in;
+}
+
+template <class FbType, class FileType>
+void
+testCopyIntoRow (Compressor::Format format, size_t xStride, int numPixels)
+{
+    //
+    // Build a line buffer, in the requested format, and a frame
+    // buffer row that is prefilled with a marker byte so that we
+    // can detect writes between strided pixels.
+    //
+
+    vector<char> lineBuffer (numPixels * sizeof (FileType) + 1);
+    char*        writeLinePtr = &lineBuffer[0];
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        FileType value = testValue<FileType> (i);
+
+        if (format == Compressor::XDR)
+        {
+            Xdr::write<CharPtrIO> (writeLinePtr, value);
+        }
+        else
+        {
+            memcpy (writeLinePtr, &value, sizeof (value));
+            writeLinePtr += sizeof (value);
+        }
+    }
+
+    vector<char> frameBuffer (numPixels * xStride + 1, char (0x5a));
+    char*        writePtr = &frameBuffer[0];
+    char*        endPtr   = writePtr + (numPixels - 1) * xStride;
+    const char*  readPtr  = &lineBuffer[0];
+
+    CopyIntoFrameBufferFunc copy = findCopyIntoFrameBuffer (
+        false,
+        format,
+        PixelTypeOf<FbType>::type,
+        PixelTypeOf<FileType>::type,
+        xStride);
+
+    copy (readPtr, writePtr, endPtr, xStride, 0.0);
+
+    assert (readPtr == &lineBuffer[0] + numPixels * sizeof (FileType));
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        FbType expected;
+        convert (expected, testValue<FileType> (i));
+
+        assert (!memcmp (
+            &frameBuffer[i * xStride], &expected, sizeof (FbType)));
+
+        for (size_t j = sizeof (FbType); j < xStride; ++j)
+            assert (frameBuffer[i * xStride + j] == char (0x5a));
+    }
+
+    assert (frameBuffer[numPixels * xStride] == char (0x5a));
+
+    //
+    // The generic entry point must produce the same results.
+    //
+
+    vector<char> frameBuffer2 (frameBuffer.size (), char (0x5a));
+    readPtr = &lineBuffer[0];
+
+    copyIntoFrameBuffer (
+        readPtr,
+        &frameBuffer2[0],
+        &frameBuffer2[0] + (numPixels - 1) * xStride,
+        xStride,
+        false,
+        0.0,
+        format,
+        PixelTypeOf<FbType>::type,
+        PixelTypeOf<FileType>::type);
+
+    assert (frameBuffer == frameBuffer2);
+
+    //
+    // Filling must store the fill value, without touching readPtr.
+    //
+
+    copy = findCopyIntoFrameBuffer (
+        true,
+        format,
+        PixelTypeOf<FbType>::type,
+        PixelTypeOf<FileType>::type,
+        xStride);
+
+    readPtr = &lineBuffer[0];
+    copy (readPtr, writePtr, endPtr, xStride, 3.0);
+    assert (readPtr == &lineBuffer[0]);
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        FbType value;
+        memcpy (&value, &frameBuffer[i * xStride], sizeof (FbType));
+        assert (value == FbType (3));
+    }
+}
+
+template <class T>
+void
+testCopyFromRow (Compressor::Format format, size_t xStride, int numPixels)
+{
+    vector<char> frameBuffer (numPixels * xStride);
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        T value = testValue<T> (i);
+        memcpy (&frameBuffer[i * xStride], &value, sizeof (T));
+    }
+
+    vector<char> lineBuffer (numPixels * sizeof (T) + 1, char (0x5a));
+    char*        writePtr = &lineBuffer[0];
+    const char*  readPtr  = &frameBuffer[0];
+    const char*  endPtr   = readPtr + (numPixels - 1) * xStride;
+
+    CopyFromFrameBufferFunc copy = findCopyFromFrameBuffer (
+        format, PixelTypeOf<T>::type, xStride);
+
+    copy (writePtr, readPtr, endPtr, xStride);
+
+    assert (writePtr == &lineBuffer[0] + numPixels * sizeof (T));
+    assert (readPtr == &frameBuffer[0] + numPixels * xStride);
+    assert (lineBuffer[numPixels * sizeof (T)] == char (0x5a));
+
+    const char* readLinePtr = &lineBuffer[0];
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        T value;
+
+        if (format == Compressor::XDR)
+        {
+            Xdr::read<CharPtrIO> (readLinePtr, value);
+        }
+        else
+        {
+            memcpy (&value, readLinePtr, sizeof (value));
+            readLinePtr += sizeof (value);
+        }
+
+        T expected = testValue<T> (i);
+        assert (!memcmp (&value, &expected, sizeof (T)));
+    }
+}
+
+template <class FbType, class FileType>
+void
+testCopyRows ()
+{
+    for (int f = 0; f < 2; ++f)
+    {
+        Compressor::Format format = f ? Compressor::XDR : Compressor::NATIVE;
+
+        for (int numPixels = 1; numPixels < 40; numPixels += 3)
+        {
+            testCopyIntoRow<FbType, FileType> (
+                format, sizeof (FbType), numPixels);
+
+            testCopyIntoRow<FbType, FileType> (
+                format, 3 * sizeof (FbType) + 2, numPixels);
+        }
+
+        testCopyIntoRow<FbType, FileType> (format, sizeof (FbType), 200);
+    }
+}
+
+template <class T>
+void
+testCopyFromRows ()
+{
+    for (int f = 0; f < 2; ++f)
+    {
+        Compressor::Format format = f ? Compressor::XDR : Compressor::NATIVE;
+
+        for (int numPixels = 1; numPixels < 40; numPixels += 3)
+        {
+            testCopyFromRow<T> (format, sizeof (T), numPixels);
+            testCopyFromRow<T> (format, 4 * sizeof (T), numPixels);
+        }
+    }
+}
+
+void
+testRowKernels ()
+{
+    testCopyRows<unsigned int, unsigned int> ();
+    testCopyRows<unsigned int, half> ();
+    testCopyRows<unsigned int, float> ();
+    testCopyRows<half, unsigned int> ();
+    testCopyRows<half, half> ();
+    testCopyRows<half, float> ();
+    testCopyRows<float, unsigned int> ();
+    testCopyRows<float, half> ();
+    testCopyRows<float, float> ();
+
+    testCopyFromRows<unsigned int> ();
+    testCopyFromRows<half> ();
+    testCopyFromRows<float> ();
+}
+
 template <class T>
 bool
 isEquivalent (T t1, T t2, Compression compression)
@@ -332,6 +711,10 @@ testConversion (const std::string& tempDir)
 
         testNumbers ();
 
+        cout << "row copy kernels" << endl;
+
+        testRowKernels ();
+
         cout << "conversion of image channels while reading a file " << endl;
 
         for (int comp = 0; comp < NUM_COMPRESSION_METHODS; ++comp)
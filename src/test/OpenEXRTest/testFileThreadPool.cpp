@@ -0,0 +1,269 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <IlmThreadPool.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputPart.h>
+#include <ImfTiledOutputFile.h>
+
+#include <assert.h>
+#include <atomic>
+#include <iostream>
+#include <stdio.h>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int W = 131;
+const int H = 77;
+
+//
+// A provider that runs every task in the calling thread, and counts
+// the tasks.
+//
+
+class CountingProvider : public ThreadPoolProvider
+{
+public:
+    CountingProvider (atomic<int>& count) : _count (count) {}
+
+    int  numThreads () const override { return 0; }
+    void setNumThreads (int) override {}
+    void addTask (Task* task) override
+    {
+        ++_count;
+        task->execute ();
+        task->group ()->finishOneTask ();
+        delete task;
+    }
+    void finish () override {}
+
+private:
+    atomic<int>& _count;
+};
+
+void
+testNodes ()
+{
+    cout << "NUMA nodes: " << ThreadPool::numNodes () << endl;
+
+    assert (ThreadPool::numNodes () >= 1);
+    assert (ThreadPool::estimateThreadCountForFileIO () > 0);
+
+    for (int n = 0; n < ThreadPool::numNodes (); ++n)
+    {
+        cout << "node " << n << ": " << ThreadPool::numNodeProcessors (n)
+             << " processors" << endl;
+
+        assert (ThreadPool::numNodeProcessors (n) > 0);
+    }
+
+    ThreadPool& pool = ThreadPool::nodeThreadPool (0);
+
+    assert (&pool == &ThreadPool::nodeThreadPool (0));
+    assert (pool.node () == 0 || pool.node () == -1);
+
+    if (ILMTHREAD_NAMESPACE::supportsThreads ())
+        assert (pool.numThreads () == int (ThreadPool::numNodeProcessors (0)));
+
+    try
+    {
+        ThreadPool::nodeThreadPool (ThreadPool::numNodes ());
+        assert (false);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        // expected
+    }
+
+    ThreadPool unbound (2);
+    assert (unbound.node () == -1);
+
+    ThreadPool bound (2, 0);
+    assert (bound.node () == pool.node ());
+
+    bound.setNumThreads (0);
+    bound.setNumThreads (3);
+    assert (bound.node () == pool.node ());
+
+    ThreadPool none (2, ThreadPool::numNodes ());
+    assert (none.node () == -1);
+}
+
+void
+writeFile (const string& fileName, bool tiled, Array2D<float>& pixels)
+{
+    Header hdr (W, H);
+    hdr.compression () = PIZ_COMPRESSION;
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            pixels[y][x] = x + y * 0.5f;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Z", Slice (FLOAT, (char*) &pixels[0][0], sizeof (float), W * 4));
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (16, 16, ONE_LEVEL));
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+template <class In>
+void
+readAndCompare (In& in, const Array2D<float>& pixels)
+{
+    Array2D<float> read (H, W);
+
+    FrameBuffer fb;
+    fb.insert ("Z", Slice (FLOAT, (char*) &read[0][0], sizeof (float), W * 4));
+
+    in.setFrameBuffer (fb);
+    in.readPixels (0, H - 1);
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            assert (read[y][x] == pixels[y][x]);
+}
+
+void
+testFile (const string& fileName, bool tiled)
+{
+    cout << (tiled ? "tiled file" : "scan line file") << endl;
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, tiled, pixels);
+
+    //
+    // The tasks of a file bound to a pool go to that pool.
+    //
+
+    if (ILMTHREAD_NAMESPACE::supportsThreads ())
+    {
+        atomic<int> count (0);
+        ThreadPool  pool;
+        pool.setThreadProvider (new CountingProvider (count));
+
+        InputFile in (fileName.c_str (), 2);
+        assert (in.threadPool () == &ThreadPool::globalThreadPool ());
+
+        in.setThreadPool (&pool);
+        assert (in.threadPool () == &pool);
+
+        readAndCompare (in, pixels);
+        assert (count > 0);
+
+        int n = count;
+        in.setThreadPool (nullptr);
+        assert (in.threadPool () == &ThreadPool::globalThreadPool ());
+
+        readAndCompare (in, pixels);
+        assert (count == n);
+    }
+
+    //
+    // Reading with a pool that has threads, which reallocates the
+    // chunk buffers; reading the same lines again must not see the
+    // discarded contents of the old buffers.
+    //
+
+    if (ILMTHREAD_NAMESPACE::supportsThreads ())
+    {
+        ThreadPool pool (3, 0);
+
+        InputFile in (fileName.c_str (), 3);
+        readAndCompare (in, pixels);
+        in.setThreadPool (&pool);
+        readAndCompare (in, pixels);
+        readAndCompare (in, pixels);
+
+        MultiPartInputFile file (fileName.c_str (), 3);
+        InputPart          part (file, 0);
+
+        part.setThreadPool (&ThreadPool::nodeThreadPool (0));
+        assert (part.threadPool () == &ThreadPool::nodeThreadPool (0));
+        readAndCompare (part, pixels);
+
+        if (tiled)
+        {
+            MultiPartInputFile tfile (fileName.c_str (), 3);
+            TiledInputPart     tpart (tfile, 0);
+
+            tpart.setThreadPool (&pool);
+            assert (tpart.threadPool () == &pool);
+
+            Array2D<float> read (H, W);
+
+            FrameBuffer fb;
+            fb.insert (
+                "Z",
+                Slice (FLOAT, (char*) &read[0][0], sizeof (float), W * 4));
+
+            tpart.setFrameBuffer (fb);
+            tpart.readTiles (
+                0, tpart.numXTiles () - 1, 0, tpart.numYTiles () - 1);
+
+            for (int y = 0; y < H; ++y)
+                for (int x = 0; x < W; ++x)
+                    assert (read[y][x] == pixels[y][x]);
+        }
+    }
+
+    remove (fileName.c_str ());
+}
+
+} // namespace
+
+void
+testFileThreadPool (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing per-file thread pools" << endl;
+
+        testNodes ();
+
+        string fileName = tempDir + "imf_test_file_thread_pool.exr";
+
+        testFile (fileName, false);
+        testFile (fileName, true);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
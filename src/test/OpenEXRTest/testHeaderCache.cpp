@@ -0,0 +1,525 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfHeaderCache.h>
+#include <ImfIO.h>
+#include <ImfInputFile.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
+#include <ImfStandardAttributes.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledOutputFile.h>
+#include <ImfXdr.h>
+
+#include <assert.h>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int W = 53;
+const int H = 37;
+
+Header
+makeHeader (const string& comment)
+{
+    Header hdr (W, H);
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+    addComments (hdr, comment);
+    addOwner (hdr, "imf_test");
+    hdr.insert ("cameraOffset", V2fAttribute (V2f (1.5f, -2.25f)));
+    return hdr;
+}
+
+float
+pixelValue (int frame, int x, int y)
+{
+    return frame * 1000 + x + y * 0.5f;
+}
+
+void
+fillPixels (Array2D<float>& z, int frame)
+{
+    z.resizeErase (H, W);
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            z[y][x] = pixelValue (frame, x, y);
+}
+
+FrameBuffer
+frameBuffer (Array2D<float>& z)
+{
+    FrameBuffer fb;
+    fb.insert (
+        "Z",
+        Slice (FLOAT, (char*) &z[0][0], sizeof (float), sizeof (float) * W));
+    return fb;
+}
+
+void
+writeScanLineFile (const string& fileName, const Header& hdr, int frame)
+{
+    Array2D<float> z;
+    fillPixels (z, frame);
+
+    OutputFile out (fileName.c_str (), hdr);
+    out.setFrameBuffer (frameBuffer (z));
+    out.writePixels (H);
+}
+
+void
+writeTiledFile (const string& fileName, Header hdr, int frame)
+{
+    Array2D<float> z;
+    fillPixels (z, frame);
+
+    hdr.setTileDescription (TileDescription (16, 16, ONE_LEVEL));
+    TiledOutputFile out (fileName.c_str (), hdr);
+    out.setFrameBuffer (frameBuffer (z));
+    out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+}
+
+void
+writeMultiPartFile (const string& fileName, int frame)
+{
+    vector<Header> headers;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Header hdr = makeHeader ("multi-part");
+        hdr.setName (i == 0 ? "left" : "right");
+        hdr.setType (SCANLINEIMAGE);
+        headers.push_back (hdr);
+    }
+
+    MultiPartOutputFile out (fileName.c_str (), &headers[0], 2);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Array2D<float> z;
+        fillPixels (z, frame + i);
+
+        OutputPart part (out, i);
+        part.setFrameBuffer (frameBuffer (z));
+        part.writePixels (H);
+    }
+}
+
+void
+checkHeader (const Header& hdr, const string& comment)
+{
+    assert (hdr.dataWindow () == Box2i (V2i (0, 0), V2i (W - 1, H - 1)));
+    assert (hdr.compression () == ZIP_COMPRESSION);
+    assert (hdr.channels ().findChannel ("Z") != 0);
+    assert (hdr.channels ().findChannel ("Z")->type == FLOAT);
+    assert (comments (hdr) == comment);
+    assert (owner (hdr) == "imf_test");
+    assert (
+        hdr.typedAttribute<V2fAttribute> ("cameraOffset").value () ==
+        V2f (1.5f, -2.25f));
+}
+
+void
+checkPixels (Array2D<float>& z, int frame)
+{
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            assert (z[y][x] == pixelValue (frame, x, y));
+}
+
+void
+readScanLineFile (const string& fileName, const string& comment, int frame)
+{
+    InputFile in (fileName.c_str ());
+    checkHeader (in.header (), comment);
+
+    Array2D<float> z (H, W);
+    in.setFrameBuffer (frameBuffer (z));
+    in.readPixels (0, H - 1);
+    checkPixels (z, frame);
+}
+
+void
+checkStatistics (uint64_t hits, uint64_t misses)
+{
+    HeaderCacheStatistics s = headerCacheStatistics ();
+    assert (s.hits == hits);
+    assert (s.misses == misses);
+}
+
+void
+testScanLineFiles (const string& tempDir)
+{
+    cout << "scan line files" << endl;
+
+    string a = tempDir + "imf_test_header_cache_a.exr";
+    string b = tempDir + "imf_test_header_cache_b.exr";
+    string c = tempDir + "imf_test_header_cache_c.exr";
+
+    writeScanLineFile (a, makeHeader ("frame"), 1);
+    writeScanLineFile (b, makeHeader ("frame"), 2);
+    writeScanLineFile (c, makeHeader ("another frame"), 3);
+
+    clearHeaderCache ();
+    resetHeaderCacheStatistics ();
+
+    readScanLineFile (a, "frame", 1);
+    checkStatistics (0, 1);
+
+    //
+    // b has the same header as a, but different pixels.
+    //
+
+    readScanLineFile (b, "frame", 2);
+    checkStatistics (1, 1);
+
+    readScanLineFile (c, "another frame", 3);
+    checkStatistics (1, 2);
+
+    readScanLineFile (a, "frame", 1);
+    readScanLineFile (c, "another frame", 3);
+    checkStatistics (3, 2);
+
+    //
+    // With room for only one header, a and c replace each other.
+    //
+
+    setHeaderCacheSize (1);
+    assert (headerCacheSize () == 1);
+
+    readScanLineFile (a, "frame", 1);
+    readScanLineFile (c, "another frame", 3);
+    readScanLineFile (b, "frame", 2);
+    checkStatistics (3, 5);
+
+    readScanLineFile (a, "frame", 1);
+    checkStatistics (4, 5);
+
+    //
+    // A disabled cache is neither searched nor filled.
+    //
+
+    setHeaderCacheSize (0);
+    resetHeaderCacheStatistics ();
+
+    readScanLineFile (a, "frame", 1);
+    readScanLineFile (b, "frame", 2);
+    checkStatistics (0, 0);
+
+    setHeaderCacheSize (16);
+
+    readScanLineFile (a, "frame", 1);
+    readScanLineFile (b, "frame", 2);
+    checkStatistics (1, 1);
+
+    remove (a.c_str ());
+    remove (b.c_str ());
+    remove (c.c_str ());
+}
+
+void
+testTiledAndMultiPartFiles (const string& tempDir)
+{
+    cout << "tiled and multi-part files" << endl;
+
+    string a = tempDir + "imf_test_header_cache_a.exr";
+    string b = tempDir + "imf_test_header_cache_b.exr";
+
+    clearHeaderCache ();
+    resetHeaderCacheStatistics ();
+
+    writeTiledFile (a, makeHeader ("tiled"), 4);
+    writeTiledFile (b, makeHeader ("tiled"), 5);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        TiledInputFile in ((i == 0 ? a : b).c_str ());
+        checkHeader (in.header (), "tiled");
+        assert (in.header ().tileDescription ().xSize == 16);
+
+        Array2D<float> z (H, W);
+        in.setFrameBuffer (frameBuffer (z));
+        in.readTiles (0, in.numXTiles () - 1, 0, in.numYTiles () - 1);
+        checkPixels (z, 4 + i);
+    }
+
+    checkStatistics (1, 1);
+
+    writeMultiPartFile (a, 6);
+    writeMultiPartFile (b, 8);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        MultiPartInputFile in ((i == 0 ? a : b).c_str ());
+        assert (in.parts () == 2);
+
+        for (int p = 0; p < 2; ++p)
+        {
+            checkHeader (in.header (p), "multi-part");
+            assert (in.header (p).name () == (p == 0 ? "left" : "right"));
+
+            Array2D<float> z (H, W);
+            InputPart      part (in, p);
+            part.setFrameBuffer (frameBuffer (z));
+            part.readPixels (0, H - 1);
+            checkPixels (z, 6 + 2 * i + p);
+        }
+    }
+
+    checkStatistics (3, 3);
+
+    remove (a.c_str ());
+    remove (b.c_str ());
+}
+
+vector<char>
+fileBytes (const string& fileName)
+{
+    ifstream in (fileName.c_str (), ios_base::binary);
+    return vector<char> (
+        (istreambuf_iterator<char> (in)), istreambuf_iterator<char> ());
+}
+
+//
+// An in-memory stream that counts how it is accessed.
+//
+
+class CountingIStream : public IStream
+{
+public:
+    CountingIStream (const vector<char>& data)
+        : IStream ("counting stream")
+        , bytesRead (0)
+        , tells (0)
+        , seeks (0)
+        , _data (data)
+        , _pos (0)
+    {}
+
+    bool read (char c[], int n) override
+    {
+        if (_pos + n > _data.size ())
+            throw IEX_NAMESPACE::InputExc ("Unexpected end of file.");
+
+        memcpy (c, &_data[_pos], n);
+        _pos += n;
+        bytesRead += n;
+        return _pos < _data.size ();
+    }
+
+    uint64_t tellg () override
+    {
+        ++tells;
+        return _pos;
+    }
+
+    void seekg (uint64_t pos) override
+    {
+        ++seeks;
+        _pos = pos;
+    }
+
+    size_t position () const { return _pos; }
+
+    size_t bytesRead;
+    int    tells;
+    int    seeks;
+
+private:
+    const vector<char>& _data;
+    size_t              _pos;
+};
+
+//
+// Reads the header of a single-part file from a CountingIStream, and
+// returns the size of the header.  The counters cover only the header.
+//
+
+size_t
+readHeader (CountingIStream& is)
+{
+    int magic, version;
+    Xdr::read<StreamIO> (is, magic);
+    Xdr::read<StreamIO> (is, version);
+
+    size_t start = is.position ();
+    is.bytesRead = 0;
+    is.tells     = 0;
+    is.seeks     = 0;
+
+    Header hdr;
+    hdr.readFrom (is, version);
+
+    return is.position () - start;
+}
+
+void
+testStreamAccess (const string& tempDir)
+{
+    cout << "stream access" << endl;
+
+    string a = tempDir + "imf_test_header_cache_a.exr";
+    string c = tempDir + "imf_test_header_cache_c.exr";
+
+    writeScanLineFile (a, makeHeader ("frame"), 1);
+    writeScanLineFile (c, makeHeader ("another frame"), 3);
+
+    vector<char> dataA = fileBytes (a);
+    vector<char> dataC = fileBytes (c);
+
+    //
+    // A disabled cache does not touch the stream.
+    //
+
+    int size = headerCacheSize ();
+    setHeaderCacheSize (0);
+
+    {
+        CountingIStream is (dataA);
+        size_t          n = readHeader (is);
+        assert (is.bytesRead == n);
+        assert (is.tells == 0 && is.seeks == 0);
+    }
+
+    //
+    // When the cache is enabled, a header is read twice if it is
+    // not found, and once if it is.  A header that differs early
+    // from the cached one is read only a little beyond the point
+    // where it differs.
+    //
+
+    setHeaderCacheSize (size);
+    clearHeaderCache ();
+
+    size_t sizeA;
+
+    {
+        CountingIStream is (dataA);
+        sizeA = readHeader (is);
+        assert (is.bytesRead == 2 * sizeA);
+    }
+
+    {
+        CountingIStream is (dataA);
+        assert (readHeader (is) == sizeA);
+        assert (is.bytesRead == sizeA);
+    }
+
+    {
+        CountingIStream is (dataC);
+        size_t          sizeC = readHeader (is);
+        assert (sizeA > 256);
+        assert (is.bytesRead <= 256 + 2 * sizeC);
+    }
+
+    remove (a.c_str ());
+    remove (c.c_str ());
+}
+
+void
+testTruncatedFiles (const string& tempDir)
+{
+    cout << "truncated files" << endl;
+
+    string a = tempDir + "imf_test_header_cache_a.exr";
+    string b = tempDir + "imf_test_header_cache_b.exr";
+
+    writeScanLineFile (a, makeHeader ("frame"), 1);
+
+    clearHeaderCache ();
+    readScanLineFile (a, "frame", 1);
+
+    vector<char> data = fileBytes (a);
+
+    //
+    // Files that end within the header, and within the pixels.
+    //
+
+    size_t sizes[] = {30, 100, data.size () / 2, data.size () - 8};
+
+    for (int i = 0; i < 4; ++i)
+    {
+        {
+            ofstream out (b.c_str (), ios_base::binary);
+            out.write (&data[0], sizes[i]);
+        }
+
+        try
+        {
+            readScanLineFile (b, "frame", 1);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::BaseExc&)
+        {
+            // expected
+        }
+    }
+
+    //
+    // The cache is unaffected by the truncated files.
+    //
+
+    resetHeaderCacheStatistics ();
+    readScanLineFile (a, "frame", 1);
+    checkStatistics (1, 0);
+
+    remove (a.c_str ());
+    remove (b.c_str ());
+}
+
+} // namespace
+
+void
+testHeaderCache (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing the header cache" << endl;
+
+        //
+        // The cache is disabled by default.
+        //
+
+        assert (headerCacheSize () == 0);
+        setHeaderCacheSize (16);
+
+        testScanLineFiles (tempDir);
+        testTiledAndMultiPartFiles (tempDir);
+        testStreamAccess (tempDir);
+        testTruncatedFiles (tempDir);
+
+        setHeaderCacheSize (0);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -110,6 +110,38 @@ operator<< (std::ostream& out, const IDManifest& mfst)
     return out;
 }
 
+//
+// check every entry of 'mfst' can be found through 'lookup'
+//
+void
+compareLookup (const IDManifestLookup& lookup, const IDManifest& mfst)
+{
+    assert (lookup.size () == mfst.size ());
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m = mfst[g];
+        assert (lookup.header (g).getChannels () == m.getChannels ());
+        assert (lookup.header (g).getComponents () == m.getComponents ());
+        assert (lookup.header (g).getHashScheme () == m.getHashScheme ());
+        assert (lookup.entries (g) == m.size ());
+        const string& channel = *m.getChannels ().begin ();
+        assert (lookup.find (channel) == mfst.find (channel));
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i = m.begin ();
+             i != m.end ();
+             ++i)
+        {
+            assert (lookup.contains (g, i.id ()));
+            for (size_t c = 0; c < i.text ().size (); ++c)
+            {
+                const string* text = lookup.lookup (g, i.id (), c);
+                assert (text && *text == i.text ()[c]);
+            }
+            assert (lookup.lookup (g, i.id (), i.text ().size ()) == nullptr);
+        }
+    }
+}
+
 void
 doReadWriteManifest (const IDManifest& mfst, const string& fn, bool dump)
 {
@@ -156,6 +188,9 @@ doReadWriteManifest (const IDManifest& mfst, const string& fn, bool dump)
         cerr << "read manifest didn't match written manifest\n";
         assert (read == mfst);
     }
+
+    compareLookup (IDManifestLookup (cmpd), mfst);
+
     remove (fn.c_str ());
 }
 
@@ -564,6 +599,83 @@ testMerge ()
         }
     }
 }
+
+void
+testLookup ()
+{
+    IDManifest mfst;
+    mfst.add ("objectId");
+    mfst.add ("materialId");
+
+    IDManifest::ChannelGroupManifest& objects = mfst[0];
+    objects.setComponent ("object");
+    objects.setHashScheme (IDManifest::MURMURHASH3_32);
+
+    IDManifest::ChannelGroupManifest& materials = mfst[1];
+    materials.setComponents (vector<string>{"material", "object"});
+    materials.setHashScheme (IDManifest::MURMURHASH3_64);
+
+    vector<string> names (10000);
+    for (size_t i = 0; i < names.size (); ++i)
+    {
+        std::ostringstream name;
+        name << "/world/geo/object" << i;
+        names[i] = name.str ();
+        objects.insert (names[i]);
+        materials.insert (
+            vector<string>{"material" + std::to_string (i % 17), names[i]});
+    }
+
+    //
+    // batch hashing gives the same IDs as hashing one string at a time
+    //
+    vector<unsigned int> hashes32 (names.size ());
+    vector<uint64_t>     hashes64 (names.size ());
+    IDManifest::MurmurHash32 (names.data (), names.size (), hashes32.data ());
+    IDManifest::MurmurHash64 (names.data (), names.size (), hashes64.data ());
+    for (size_t i = 0; i < names.size (); ++i)
+    {
+        assert (hashes32[i] == IDManifest::MurmurHash32 (names[i]));
+        assert (hashes64[i] == IDManifest::MurmurHash64 (names[i]));
+        assert (objects.find (hashes32[i]) != objects.end ());
+    }
+
+    //
+    // lookups built from a compressed manifest or a manifest agree
+    //
+    CompressedIDManifest compressed (mfst);
+    compareLookup (IDManifestLookup (compressed), mfst);
+    compareLookup (IDManifestLookup (mfst), mfst);
+
+    //
+    // strings are interned: each object name is stored once, though it
+    // appears in both groups
+    //
+    IDManifestLookup lookup (mfst);
+    assert (lookup.uniqueStrings () == names.size () + 17);
+    uint64_t materialId =
+        IDManifest::MurmurHash64 (vector<string>{"material0", names[0]});
+    assert (lookup.lookup (0, hashes32[0]) == lookup.lookup (1, materialId, 1));
+    assert (lookup.find ("noSuchChannel") == lookup.size ());
+
+    //
+    // identical compressed manifests share the same decoded tables
+    //
+    CompressedIDManifest copy (compressed);
+    IDManifestLookup     a = IDManifestLookup::shared (compressed);
+    IDManifestLookup     b = IDManifestLookup::shared (copy);
+    assert (a.lookup (0, hashes32[0]) == b.lookup (0, hashes32[0]));
+
+    IDManifestLookup c (compressed);
+    assert (a.lookup (0, hashes32[0]) != c.lookup (0, hashes32[0]));
+    assert (*a.lookup (0, hashes32[0]) == *c.lookup (0, hashes32[0]));
+
+    //
+    // an empty lookup has no channel groups
+    //
+    assert (IDManifestLookup ().size () == 0);
+}
+
 } // namespace
 
 void
@@ -579,6 +691,11 @@ testIDManifest (const std::string& tempDir)
     //
     testMerge ();
 
+    //
+    // test hash-indexed lookups and batch hashing
+    //
+    testLookup ();
+
     // stress test - will randomly generate 'edge cases'
     testLargeManifest (tempDir);
 
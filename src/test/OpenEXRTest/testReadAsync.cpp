@@ -0,0 +1,502 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <IlmThreadPool.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledInputPart.h>
+#include <ImfTiledOutputFile.h>
+
+#include <assert.h>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int W = 97;
+const int H = 211;
+
+void
+writeFile (
+    const string&   fileName,
+    bool            tiled,
+    LineOrder       lineOrder,
+    Array2D<float>& pixels)
+{
+    Header hdr (W, H);
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.lineOrder ()   = lineOrder;
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            pixels[y][x] = x * 0.5f - y;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Z", Slice (FLOAT, (char*) &pixels[0][0], sizeof (float), W * 4));
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (16, 24, ONE_LEVEL));
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+void
+insertSlice (FrameBuffer& fb, Array2D<float>& read)
+{
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            read[y][x] = -1;
+
+    fb.insert ("Z", Slice (FLOAT, (char*) &read[0][0], sizeof (float), W * 4));
+}
+
+//
+// Reads a range of scan lines asynchronously and checks that the
+// callback ranges cover exactly that range.
+//
+
+template <class In>
+void
+readScanLines (
+    In& in, int y1, int y2, Array2D<float>& read, const Array2D<float>& pixels)
+{
+    mutex       m;
+    vector<int> count (H, 0);
+
+    future<void> done =
+        in.readPixelsAsync (y1, y2, [&] (int scanLineMin, int scanLineMax) {
+            assert (scanLineMin <= scanLineMax);
+
+            lock_guard<mutex> lock (m);
+
+            for (int y = scanLineMin; y <= scanLineMax; ++y)
+                ++count[y];
+        });
+
+    done.get ();
+
+    for (int y = 0; y < H; ++y)
+    {
+        bool inside = y >= min (y1, y2) && y <= max (y1, y2);
+        assert (count[y] == (inside ? 1 : 0));
+
+        for (int x = 0; x < W; ++x)
+            assert (read[y][x] == (inside ? pixels[y][x] : -1));
+    }
+}
+
+void
+testScanLines (const string& fileName, LineOrder lineOrder)
+{
+    cout << "scan line file, "
+         << (lineOrder == INCREASING_Y ? "increasing" : "decreasing")
+         << " y" << endl;
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, false, lineOrder, pixels);
+
+    {
+        //
+        // The frame buffer is declared first, so that it outlives
+        // the last read, which is still in flight when the file is
+        // destroyed.
+        //
+
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+        InputFile      in (fileName.c_str (), globalThreadCount ());
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readScanLines (in, 0, H - 1, read, pixels);
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readScanLines (in, 150, 17, read, pixels);
+
+        //
+        // A second read, and the destructor, wait for the first.
+        //
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        future<void> done = in.readPixelsAsync (0, H - 1);
+        in.readPixels (5, 9);
+        done.get ();
+
+        in.readPixelsAsync (0, H - 1);
+    }
+
+    {
+        MultiPartInputFile file (fileName.c_str ());
+        InputPart          part (file, 0);
+        Array2D<float>     read (H, W);
+        FrameBuffer        fb;
+
+        insertSlice (fb, read);
+        part.setFrameBuffer (fb);
+        readScanLines (part, 40, 41, read, pixels);
+    }
+
+    //
+    // Invalid arguments throw immediately; the errors of the read
+    // and of the callback are rethrown by the future.
+    //
+
+    {
+        InputFile      in (fileName.c_str ());
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+
+        try
+        {
+            in.readPixelsAsync (0, H - 1);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+
+        try
+        {
+            in.readPixelsAsync (0, H);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+
+        future<void> done = in.readPixelsAsync (0, H - 1, [] (int, int) {
+            throw IEX_NAMESPACE::ArgExc ("callback failed");
+        });
+
+        try
+        {
+            done.get ();
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::BaseExc& e)
+        {
+            assert (string (e.what ()).find ("callback failed") !=
+                    string::npos);
+        }
+    }
+
+    remove (fileName.c_str ());
+}
+
+void
+testBrokenFile (const string& fileName)
+{
+    cout << "broken scan line file" << endl;
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, false, INCREASING_Y, pixels);
+
+    //
+    // Overwrite the second half of the file, so that the offset
+    // table is intact but the compressed data is not.
+    //
+
+    {
+        fstream f (fileName.c_str (), ios::in | ios::out | ios::binary);
+        f.seekg (0, ios::end);
+        streamoff size = f.tellg ();
+        f.seekp (size / 2);
+
+        for (streamoff i = size / 2; i < size; ++i)
+            f.put (char (0xff));
+    }
+
+    InputFile      in (fileName.c_str ());
+    Array2D<float> read (H, W);
+    FrameBuffer    fb;
+
+    insertSlice (fb, read);
+    in.setFrameBuffer (fb);
+
+    future<void> done = in.readPixelsAsync (0, H - 1);
+
+    try
+    {
+        done.get ();
+        assert (false);
+    }
+    catch (const IEX_NAMESPACE::BaseExc& e)
+    {
+        cout << "expected error: " << e.what () << endl;
+    }
+
+    remove (fileName.c_str ());
+}
+
+template <class In>
+void
+readTiles (In& in, Array2D<float>& read, const Array2D<float>& pixels)
+{
+    int nx = in.numXTiles ();
+    int ny = in.numYTiles ();
+
+    mutex       m;
+    vector<int> count (nx * ny, 0);
+
+    future<void> done = in.readTilesAsync (
+        nx - 1, 0, ny - 1, 0, 0, 0, [&] (int dx, int dy, int lx, int ly) {
+            assert (lx == 0 && ly == 0);
+
+            lock_guard<mutex> lock (m);
+            ++count[dy * nx + dx];
+        });
+
+    done.get ();
+
+    for (int i = 0; i < nx * ny; ++i)
+        assert (count[i] == 1);
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            assert (read[y][x] == pixels[y][x]);
+}
+
+void
+testTiles (const string& fileName, LineOrder lineOrder)
+{
+    cout << "tiled file, "
+         << (lineOrder == INCREASING_Y ? "increasing" : "decreasing")
+         << " y" << endl;
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, true, lineOrder, pixels);
+
+    {
+        TiledInputFile in (fileName.c_str (), globalThreadCount ());
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readTiles (in, read, pixels);
+
+        try
+        {
+            in.readTilesAsync (0, in.numXTiles (), 0, 0, 0, 0);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+    }
+
+    {
+        MultiPartInputFile file (fileName.c_str ());
+        TiledInputPart     part (file, 0);
+        Array2D<float>     read (H, W);
+        FrameBuffer        fb;
+
+        insertSlice (fb, read);
+        part.setFrameBuffer (fb);
+        readTiles (part, read, pixels);
+    }
+
+    //
+    // InputFile reads tiled files synchronously.
+    //
+
+    {
+        InputFile      in (fileName.c_str ());
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readScanLines (in, 3, H - 4, read, pixels);
+    }
+
+    remove (fileName.c_str ());
+}
+
+//
+// A thread pool provider with a single thread that always runs the
+// most recently queued task first.  Asynchronous reads must not
+// depend on the order in which a provider runs their tasks.
+//
+
+class LifoProvider : public ThreadPoolProvider
+{
+public:
+    LifoProvider () : _stop (false), _thread (&LifoProvider::run, this) {}
+    ~LifoProvider () override { finish (); }
+
+    int  numThreads () const override { return 1; }
+    void setNumThreads (int) override {}
+
+    void addTask (Task* task) override
+    {
+        {
+            lock_guard<mutex> lock (_mutex);
+            _tasks.push_back (task);
+        }
+
+        _cond.notify_one ();
+    }
+
+    void finish () override
+    {
+        {
+            lock_guard<mutex> lock (_mutex);
+            _stop = true;
+        }
+
+        _cond.notify_one ();
+
+        if (_thread.joinable ()) _thread.join ();
+    }
+
+private:
+    void run ()
+    {
+        unique_lock<mutex> lock (_mutex);
+
+        while (true)
+        {
+            while (_tasks.empty () && !_stop)
+                _cond.wait (lock);
+
+            if (_tasks.empty ()) return;
+
+            Task* task = _tasks.back ();
+            _tasks.pop_back ();
+            lock.unlock ();
+
+            TaskGroup* group = task->group ();
+            task->execute ();
+            delete task;
+            group->finishOneTask ();
+
+            lock.lock ();
+        }
+    }
+
+    mutex              _mutex;
+    condition_variable _cond;
+    vector<Task*>      _tasks;
+    bool               _stop;
+    thread             _thread;
+};
+
+void
+testLifoPool (const string& fileName)
+{
+    cout << "one thread, last in, first out" << endl;
+
+    ThreadPool pool (0);
+    pool.setThreadProvider (new LifoProvider);
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, false, INCREASING_Y, pixels);
+
+    {
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+        InputFile      in (fileName.c_str (), 2);
+
+        in.setThreadPool (&pool);
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readScanLines (in, 0, H - 1, read, pixels);
+    }
+
+    writeFile (fileName, true, INCREASING_Y, pixels);
+
+    {
+        Array2D<float> read (H, W);
+        FrameBuffer    fb;
+        TiledInputFile in (fileName.c_str (), 2);
+
+        in.setThreadPool (&pool);
+        insertSlice (fb, read);
+        in.setFrameBuffer (fb);
+        readTiles (in, read, pixels);
+    }
+
+    remove (fileName.c_str ());
+}
+
+} // namespace
+
+void
+testReadAsync (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing asynchronous reads" << endl;
+
+        string fileName = tempDir + "imf_test_read_async.exr";
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            setGlobalThreadCount (n);
+            cout << "number of threads: " << globalThreadCount () << endl;
+
+            testScanLines (fileName, INCREASING_Y);
+            testScanLines (fileName, DECREASING_Y);
+            testBrokenFile (fileName);
+            testTiles (fileName, INCREASING_Y);
+            testTiles (fileName, DECREASING_Y);
+        }
+
+        if (ILMTHREAD_NAMESPACE::supportsThreads ()) testLifoPool (fileName);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -0,0 +1,210 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <IlmThread.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfStatistics.h>
+#include <ImfThreading.h>
+#include <ImfTiledOutputFile.h>
+#include <half.h>
+
+#include <assert.h>
+#include <iostream>
+#include <stdio.h>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+const int W = 150;
+const int H = 100;
+
+void
+writeFile (const string& fileName, Compression comp, bool tiled)
+{
+    Header hdr (W, H);
+    hdr.compression () = comp;
+    hdr.channels ().insert ("G", Channel (HALF));
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+
+    Array2D<half>  ph (H, W);
+    Array2D<float> pf (H, W);
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            ph[y][x] = x % 7 + y % 5;
+            pf[y][x] = x * 0.5f + y;
+        }
+    }
+
+    FrameBuffer fb;
+    fb.insert ("G", Slice (HALF, (char*) &ph[0][0], sizeof (half), W * 2));
+    fb.insert ("Z", Slice (FLOAT, (char*) &pf[0][0], sizeof (float), W * 4));
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (64, 64, ONE_LEVEL));
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+template <class In>
+void
+readAll (In& in)
+{
+    Array2D<half>  ph (H, W);
+    Array2D<float> pf (H, W);
+
+    FrameBuffer fb;
+    fb.insert ("G", Slice (HALF, (char*) &ph[0][0], sizeof (half), W * 2));
+    fb.insert ("Z", Slice (FLOAT, (char*) &pf[0][0], sizeof (float), W * 4));
+
+    in.setFrameBuffer (fb);
+    in.readPixels (0, H - 1);
+}
+
+void
+checkEqual (const Statistics& a, const Statistics& b)
+{
+    assert (a.bytesRead == b.bytesRead);
+    assert (a.reads == b.reads);
+    assert (a.seeks == b.seeks);
+    assert (a.bytesDecompressed == b.bytesDecompressed);
+
+    for (int i = 0; i < NUM_COMPRESSION_METHODS; ++i)
+        assert (a.chunksDecoded[i] == b.chunksDecoded[i]);
+}
+
+void
+checkZero (const Statistics& s)
+{
+    checkEqual (s, Statistics ());
+    assert (s.readTime == 0 && s.decompressTime == 0 && s.copyTime == 0);
+}
+
+void
+testFile (const string& fileName, Compression comp, bool tiled, int chunks)
+{
+    cout << "compression " << comp << (tiled ? ", tiled" : ", scan lines")
+         << endl;
+
+    writeFile (fileName, comp, tiled);
+
+    //
+    // Files opened while statistics are disabled collect nothing.
+    //
+
+    setStatisticsEnabled (false);
+    resetGlobalStatistics ();
+
+    {
+        InputFile in (fileName.c_str ());
+        readAll (in);
+        checkZero (in.statistics ());
+        checkZero (globalStatistics ());
+    }
+
+    setStatisticsEnabled (true);
+
+    {
+        InputFile in (fileName.c_str ());
+        readAll (in);
+
+        Statistics s = in.statistics ();
+
+        assert (s.reads == uint64_t (chunks));
+        assert (s.seeks <= s.reads);
+        assert (s.bytesRead > 0);
+        assert (s.chunksDecoded[comp] == uint64_t (chunks));
+        assert (s.bytesDecompressed == uint64_t (W * H * (2 + 4)));
+        assert (s.readTime >= 0 && s.decompressTime >= 0);
+
+        for (int i = 0; i < NUM_COMPRESSION_METHODS; ++i)
+            if (i != comp) assert (s.chunksDecoded[i] == 0);
+
+        checkEqual (globalStatistics (), s);
+
+        //
+        // Reading the same file through a MultiPartInputFile
+        // yields the same counts.
+        //
+
+        MultiPartInputFile file (fileName.c_str ());
+        InputPart          part (file, 0);
+        readAll (part);
+
+        checkEqual (file.statistics (), s);
+        checkEqual (part.statistics (), s);
+
+        Statistics g = globalStatistics ();
+        assert (g.reads == 2 * s.reads);
+        assert (g.chunksDecoded[comp] == 2 * s.chunksDecoded[comp]);
+
+        resetGlobalStatistics ();
+        checkZero (globalStatistics ());
+        checkEqual (in.statistics (), s);
+    }
+
+    setStatisticsEnabled (false);
+    remove (fileName.c_str ());
+}
+
+} // namespace
+
+void
+testStatistics (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing statistics" << endl;
+
+        string fileName = tempDir + "imf_test_statistics.exr";
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            setGlobalThreadCount (n);
+            cout << "number of threads: " << globalThreadCount () << endl;
+
+            testFile (fileName, NO_COMPRESSION, false, H);
+            testFile (fileName, ZIP_COMPRESSION, false, (H + 15) / 16);
+            testFile (fileName, PIZ_COMPRESSION, false, (H + 31) / 32);
+            testFile (fileName, ZIP_COMPRESSION, true, 3 * 2);
+            testFile (fileName, PIZ_COMPRESSION, true, 3 * 2);
+        }
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
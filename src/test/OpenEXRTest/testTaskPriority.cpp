@@ -0,0 +1,269 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <IlmThread.h>
+#include <IlmThreadPool.h>
+#include <IlmThreadSemaphore.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputPart.h>
+#include <ImfTiledOutputFile.h>
+
+#include <assert.h>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <vector>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int W = 117;
+const int H = 93;
+
+//
+// Records the order in which the tasks are executed.
+//
+
+struct Log
+{
+    mutex       m;
+    vector<int> order;
+};
+
+class LogTask : public Task
+{
+public:
+    LogTask (TaskGroup* group, Log& log, int id)
+        : Task (group), _log (log), _id (id)
+    {}
+
+    void execute () override
+    {
+        lock_guard<mutex> lock (_log.m);
+        _log.order.push_back (_id);
+    }
+
+private:
+    Log& _log;
+    int  _id;
+};
+
+//
+// Keeps the only worker thread of a pool busy until released,
+// so that the tasks added in the meantime stay in the queue.
+//
+
+class BlockTask : public Task
+{
+public:
+    BlockTask (TaskGroup* group, Semaphore& started, Semaphore& release)
+        : Task (group), _started (started), _release (release)
+    {}
+
+    void execute () override
+    {
+        _started.post ();
+        _release.wait ();
+    }
+
+private:
+    Semaphore& _started;
+    Semaphore& _release;
+};
+
+void
+testQueueOrder ()
+{
+    cout << "queue order" << endl;
+
+    ThreadPool pool (1);
+    Log        log;
+    Semaphore  started (0);
+    Semaphore  release (0);
+
+    {
+        TaskGroup blocker;
+        TaskGroup background (TASK_PRIORITY_BACKGROUND);
+        TaskGroup normal;
+        TaskGroup interactive (TASK_PRIORITY_INTERACTIVE);
+
+        assert (blocker.priority () == TASK_PRIORITY_NORMAL);
+        assert (background.priority () == TASK_PRIORITY_BACKGROUND);
+        assert (interactive.priority () == TASK_PRIORITY_INTERACTIVE);
+
+        pool.addTask (new BlockTask (&blocker, started, release));
+        started.wait ();
+
+        //
+        // Tasks of the three groups are queued interleaved; their
+        // ids are 100 * level + sequence number.
+        //
+
+        for (int i = 0; i < 5; ++i)
+        {
+            pool.addTask (new LogTask (&background, log, i));
+            pool.addTask (new LogTask (&normal, log, 100 + i));
+            pool.addTask (new LogTask (&interactive, log, 200 + i));
+        }
+
+        release.post ();
+    }
+
+    assert (log.order.size () == 15);
+
+    for (int i = 0; i < 15; ++i)
+        assert (log.order[i] == 100 * (2 - i / 5) + i % 5);
+}
+
+void
+writeFile (const string& fileName, bool tiled, Array2D<float>& pixels)
+{
+    Header hdr (W, H);
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            pixels[y][x] = x * 0.25f + y;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Z", Slice (FLOAT, (char*) &pixels[0][0], sizeof (float), W * 4));
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (32, 32, ONE_LEVEL));
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+template <class In>
+void
+readAndCompare (In& in, const Array2D<float>& pixels)
+{
+    Array2D<float> read (H, W);
+
+    FrameBuffer fb;
+    fb.insert ("Z", Slice (FLOAT, (char*) &read[0][0], sizeof (float), W * 4));
+
+    in.setFrameBuffer (fb);
+    in.readPixels (0, H - 1);
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            assert (read[y][x] == pixels[y][x]);
+}
+
+void
+testFile (const string& fileName, bool tiled)
+{
+    cout << (tiled ? "tiled file" : "scan line file") << endl;
+
+    Array2D<float> pixels (H, W);
+    writeFile (fileName, tiled, pixels);
+
+    {
+        InputFile in (fileName.c_str ());
+        assert (in.taskPriority () == TASK_PRIORITY_NORMAL);
+
+        in.setTaskPriority (TASK_PRIORITY_INTERACTIVE);
+        assert (in.taskPriority () == TASK_PRIORITY_INTERACTIVE);
+
+        readAndCompare (in, pixels);
+
+        in.setTaskPriority (TASK_PRIORITY_BACKGROUND);
+        readAndCompare (in, pixels);
+    }
+
+    {
+        MultiPartInputFile file (fileName.c_str ());
+        InputPart          part (file, 0);
+
+        part.setTaskPriority (TASK_PRIORITY_BACKGROUND);
+        assert (part.taskPriority () == TASK_PRIORITY_BACKGROUND);
+        readAndCompare (part, pixels);
+    }
+
+    if (tiled)
+    {
+        MultiPartInputFile file (fileName.c_str ());
+        TiledInputPart     part (file, 0);
+
+        part.setTaskPriority (TASK_PRIORITY_INTERACTIVE);
+        assert (part.taskPriority () == TASK_PRIORITY_INTERACTIVE);
+
+        Array2D<float> read (H, W);
+
+        FrameBuffer fb;
+        fb.insert (
+            "Z", Slice (FLOAT, (char*) &read[0][0], sizeof (float), W * 4));
+
+        part.setFrameBuffer (fb);
+        part.readTiles (0, part.numXTiles () - 1, 0, part.numYTiles () - 1);
+
+        for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x)
+                assert (read[y][x] == pixels[y][x]);
+    }
+
+    remove (fileName.c_str ());
+}
+
+} // namespace
+
+void
+testTaskPriority (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing task priorities" << endl;
+
+        if (ILMTHREAD_NAMESPACE::supportsThreads ()) testQueueOrder ();
+
+        string fileName = tempDir + "imf_test_task_priority.exr";
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            setGlobalThreadCount (n);
+            cout << "number of threads: " << globalThreadCount () << endl;
+
+            testFile (fileName, false);
+            testFile (fileName, true);
+        }
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
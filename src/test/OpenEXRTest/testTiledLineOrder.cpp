@@ -20,6 +20,7 @@
 #include <half.h>
 
 #include <assert.h>
+#include <limits>
 #include <stdio.h>
 #include <vector>
 
@@ -678,6 +679,106 @@ writeCopyRead (const std::string& tempDir, int w, int h, int xs, int ys)
     }
 }
 
+void
+writeReadBufferLimit (
+    const std::string& tempDir, LineOrder lorder, size_t bufferLimit)
+{
+    cout << "LineOrder " << lorder << ", tile buffer limit " << bufferLimit
+         << endl;
+
+    std::string fileName = tempDir + "imf_test_buffer_limit.exr";
+
+    const int width  = 171;
+    const int height = 259;
+
+    Header hdr (width, height);
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.lineOrder ()   = lorder;
+    hdr.channels ().insert ("H", Channel (HALF, 1, 1));
+    hdr.setTileDescription (TileDescription (16, 16, MIPMAP_LEVELS));
+
+    Array<Array2D<half>> levels;
+
+    {
+        cout << " writing" << flush;
+
+        remove (fileName.c_str ());
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setTileBufferLimit (bufferLimit);
+        assert (out.tileBufferLimit () == bufferLimit);
+
+        levels.resizeErase (out.numLevels ());
+
+        //
+        // Write the tiles in the reverse of the order in which
+        // they are stored in the file, so that every tile except
+        // the last one arrives too early.
+        //
+
+        for (int l = out.numLevels () - 1; l >= 0; --l)
+        {
+            levels[l].resizeErase (out.levelHeight (l), out.levelWidth (l));
+            fillPixels (levels[l], out.levelWidth (l), out.levelHeight (l));
+
+            FrameBuffer fb;
+
+            fb.insert (
+                "H",
+                Slice (
+                    HALF,
+                    (char*) &levels[l][0][0],
+                    sizeof (levels[l][0][0]),
+                    sizeof (levels[l][0][0]) * out.levelWidth (l)));
+
+            out.setFrameBuffer (fb);
+
+            for (int y = 0; y < out.numYTiles (l); ++y)
+            {
+                int dy = (lorder == DECREASING_Y) ? y
+                                                  : out.numYTiles (l) - 1 - y;
+
+                for (int dx = out.numXTiles (l) - 1; dx >= 0; --dx)
+                    out.writeTile (dx, dy, l);
+            }
+        }
+    }
+
+    {
+        cout << " reading" << flush;
+
+        TiledInputFile in (fileName.c_str ());
+        assert (in.isComplete ());
+        assert (in.header ().lineOrder () == lorder);
+
+        cout << " comparing" << flush;
+
+        for (int l = 0; l < in.numLevels (); ++l)
+        {
+            Array2D<half> ph (in.levelHeight (l), in.levelWidth (l));
+
+            FrameBuffer fb;
+
+            fb.insert (
+                "H",
+                Slice (
+                    HALF,
+                    (char*) &ph[0][0],
+                    sizeof (ph[0][0]),
+                    sizeof (ph[0][0]) * in.levelWidth (l)));
+
+            in.setFrameBuffer (fb);
+            in.readTiles (0, in.numXTiles (l) - 1, 0, in.numYTiles (l) - 1, l);
+
+            for (int y = 0; y < in.levelHeight (l); ++y)
+                for (int x = 0; x < in.levelWidth (l); ++x)
+                    assert (ph[y][x] == levels[l][y][x]);
+        }
+    }
+
+    remove (fileName.c_str ());
+    cout << endl;
+}
+
 } // namespace
 
 void
@@ -705,6 +806,16 @@ testTiledLineOrder (const std::string& tempDir)
             }
 
             writeCopyRead (tempDir, W, H, XS, YS);
+
+            for (int lorder = 0; lorder < RANDOM_Y; ++lorder)
+            {
+                writeReadBufferLimit (tempDir, LineOrder (lorder), 0);
+                writeReadBufferLimit (tempDir, LineOrder (lorder), 2000);
+                writeReadBufferLimit (
+                    tempDir,
+                    LineOrder (lorder),
+                    std::numeric_limits<size_t>::max ());
+            }
         }
 
         cout << "ok\n" << endl;
@@ -11,10 +11,12 @@
 #include "ImathMath.h"
 #include <ImfArray.h>
 #include <ImfRgbaFile.h>
+#include <ImfRgbaYca.h>
 #include <ImfThreading.h>
 #include <algorithm>
 #include <assert.h>
 #include <stdio.h>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace std;
@@ -178,6 +180,314 @@ writeReadYca (
     remove (fileName);
 }
 
+void
+readLines (RgbaInputFile& in, const Box2i& dw, Array2D<Rgba>& pixels)
+{
+    int w = dw.max.x - dw.min.x + 1;
+
+    in.setFrameBuffer (&pixels[-dw.min.y][-dw.min.x], 1, w);
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        in.readPixels (y);
+}
+
+void
+comparePixels (
+    const Array2D<Rgba>& pixels1, const Array2D<Rgba>& pixels2, int w, int h)
+{
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            const Rgba& p1 = pixels1[y][x];
+            const Rgba& p2 = pixels2[y][x];
+
+            assert (p1.r.bits () == p2.r.bits ());
+            assert (p1.g.bits () == p2.g.bits ());
+            assert (p1.b.bits () == p2.b.bits ());
+            assert (p1.a.bits () == p2.a.bits ());
+        }
+    }
+}
+
+void
+writeReadYcaBlocks (
+    const char   fileName[],
+    const Box2i& dw,
+    RgbaChannels channels,
+    LineOrder    writeOrder,
+    void (*fillPixels) (Array2D<Rgba>& pixels, int w, int h))
+{
+    //
+    // Reading many scan lines with a single readPixels() call
+    // converts the luminance/chroma data in bands, in parallel.
+    // Verify that the results are identical to reading the
+    // scan lines one at a time.
+    //
+
+    int           w = dw.max.x - dw.min.x + 1;
+    int           h = dw.max.y - dw.min.y + 1;
+    Array2D<Rgba> pixels1 (h, w);
+    Array2D<Rgba> pixels2 (h, w);
+    Array2D<Rgba> pixels3 (h, w);
+
+    cout << w << " by " << h
+         << " pixels, "
+            "channels "
+         << channels
+         << ", "
+            "write order "
+         << writeOrder << endl;
+
+    fillPixels (pixels1, w, h);
+
+    {
+        RgbaOutputFile out (
+            fileName,
+            dw,
+            dw, // display window, data window
+            channels,
+            1,          // pixelAspectRatio
+            V2f (0, 0), // screenWindowCenter
+            1,          // screenWindowWidth
+            writeOrder);
+
+        out.setYCRounding (9, 9);
+        out.setFrameBuffer (&pixels1[-dw.min.y][-dw.min.x], 1, w);
+        out.writePixels (h);
+    }
+
+    {
+        RgbaInputFile in (fileName);
+        readLines (in, dw, pixels1);
+    }
+
+    {
+        RgbaInputFile in (fileName);
+        in.setFrameBuffer (&pixels2[-dw.min.y][-dw.min.x], 1, w);
+        in.readPixels (dw.min.y, dw.max.y);
+    }
+
+    comparePixels (pixels1, pixels2, w, h);
+
+    {
+        //
+        // Two blocks, in reverse order, followed by single scan lines
+        // that must still be served correctly from the line cache.
+        //
+
+        int yMid = dw.min.y + h / 3;
+
+        RgbaInputFile in (fileName);
+        in.setFrameBuffer (&pixels3[-dw.min.y][-dw.min.x], 1, w);
+        in.readPixels (dw.max.y, yMid + 1);
+        in.readPixels (yMid - 1, dw.min.y);
+        in.readPixels (yMid);
+    }
+
+    comparePixels (pixels1, pixels3, w, h);
+
+    remove (fileName);
+}
+
+//
+// Straightforward versions of the chroma reconstruction filters and
+// of YCAtoRGBA(), which add the products in the same order as the
+// library, to check that its vector code produces the same bits.
+//
+
+const float reconstructCoeffs[RgbaYca::N2 + 1] = {
+    0.002128f,
+    -0.007540f,
+    0.019597f,
+    -0.043159f,
+    0.087929f,
+    -0.186077f,
+    0.627123f,
+    0.627123f,
+    -0.186077f,
+    0.087929f,
+    -0.043159f,
+    0.019597f,
+    -0.007540f,
+    0.002128f};
+
+half
+filterRef (const half* const taps[])
+{
+    float sum = *taps[0] * reconstructCoeffs[0];
+
+    for (int k = 1; k < RgbaYca::N2 + 1; ++k)
+        sum = sum + *taps[k] * reconstructCoeffs[k];
+
+    return sum;
+}
+
+void
+reconstructChromaHorizRef (int n, const Rgba ycaIn[], Rgba ycaOut[])
+{
+    for (int j = 0; j < n; ++j)
+    {
+        const Rgba& center = ycaIn[j + RgbaYca::N2];
+
+        ycaOut[j] = center;
+
+        if (j & 1)
+        {
+            const half* r[RgbaYca::N2 + 1];
+            const half* b[RgbaYca::N2 + 1];
+
+            for (int k = 0; k < RgbaYca::N2 + 1; ++k)
+            {
+                r[k] = &ycaIn[j + 2 * k].r;
+                b[k] = &ycaIn[j + 2 * k].b;
+            }
+
+            ycaOut[j].r = filterRef (r);
+            ycaOut[j].b = filterRef (b);
+        }
+    }
+}
+
+void
+reconstructChromaVertRef (int n, const Rgba* const ycaIn[], Rgba ycaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const half* r[RgbaYca::N2 + 1];
+        const half* b[RgbaYca::N2 + 1];
+
+        for (int k = 0; k < RgbaYca::N2 + 1; ++k)
+        {
+            r[k] = &ycaIn[2 * k][i].r;
+            b[k] = &ycaIn[2 * k][i].b;
+        }
+
+        ycaOut[i]   = ycaIn[RgbaYca::N2][i];
+        ycaOut[i].r = filterRef (r);
+        ycaOut[i].b = filterRef (b);
+    }
+}
+
+void
+YCAtoRGBARef (const V3f& yw, int n, const Rgba ycaIn[], Rgba rgbaOut[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const Rgba& in = ycaIn[i];
+
+        if (in.r == 0 && in.b == 0)
+        {
+            rgbaOut[i] = Rgba (in.g, in.g, in.g, in.a);
+        }
+        else
+        {
+            float Y = in.g;
+            float r = (in.r + 1) * Y;
+            float b = (in.b + 1) * Y;
+            float g = (Y - r * yw.x - b * yw.z) / yw.y;
+
+            rgbaOut[i] = Rgba (r, g, b, in.a);
+        }
+    }
+}
+
+void
+compareBits (int n, const Rgba p1[], const Rgba p2[])
+{
+    for (int i = 0; i < n; ++i)
+    {
+        assert (p1[i].r.bits () == p2[i].r.bits ());
+        assert (p1[i].g.bits () == p2[i].g.bits ());
+        assert (p1[i].b.bits () == p2[i].b.bits ());
+        assert (p1[i].a.bits () == p2[i].a.bits ());
+    }
+}
+
+void
+compareFilters (
+    const V3f& yw, int n, const Rgba yca[], const Rgba* const lines[])
+{
+    vector<Rgba> out1 (n);
+    vector<Rgba> out2 (n);
+
+    RgbaYca::reconstructChromaHoriz (n, yca, &out1[0]);
+    reconstructChromaHorizRef (n, yca, &out2[0]);
+    compareBits (n, &out1[0], &out2[0]);
+
+    RgbaYca::reconstructChromaVert (n, lines, &out1[0]);
+    reconstructChromaVertRef (n, lines, &out2[0]);
+    compareBits (n, &out1[0], &out2[0]);
+
+    RgbaYca::YCAtoRGBA (yw, n, yca, &out1[0]);
+    YCAtoRGBARef (yw, n, yca, &out2[0]);
+    compareBits (n, &out1[0], &out2[0]);
+}
+
+void
+testFilters ()
+{
+    cout << "comparing the chroma filters with reference code" << endl;
+
+    //
+    // Random halfs, mixed with zeros of either sign, infinities,
+    // NaNs, denormals and large values.  The NaNs have the same bits
+    // as those that invalid operations such as inf - inf produce:
+    // which of two different NaNs an addition returns depends on the
+    // order of its operands, which is up to the compiler.
+    //
+
+    const unsigned short special[] = {
+        0x0000, 0x8000, 0x7c00, 0xfc00, 0xfe00, 0x0001, 0x83ff, 0x7bff, 0xfbff};
+
+    const int    maxN   = 4000;
+    const int    numYca = maxN + RgbaYca::N - 1;
+    vector<Rgba> yca (RgbaYca::N * numYca);
+    unsigned int seed = 1;
+
+    for (int round = 0; round < 20; ++round)
+    {
+        for (size_t i = 0; i < yca.size (); ++i)
+        {
+            half* h = &yca[i].r;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                seed = seed * 1103515245 + 12345;
+
+                if (round > 0 && (seed >> 16) % 16 == 0)
+                {
+                    h[c].setBits (special[(seed >> 8) % 9]);
+                }
+                else
+                {
+                    seed = seed * 1103515245 + 12345;
+                    h[c] = (float (seed >> 8) / (1 << 24) - 0.5f) * 4;
+                }
+            }
+
+            if (round > 0 && i % 7 == 0) yca[i].r = yca[i].b = 0;
+        }
+
+        const Rgba* lines[RgbaYca::N];
+
+        for (int k = 0; k < RgbaYca::N; ++k)
+            lines[k] = &yca[k * numYca];
+
+        V3f yw = RgbaYca::computeYw (Chromaticities ());
+
+        //
+        // Short lines exercise the scalar code for odd pixels at the
+        // end; a long line makes rounding differences likely to show.
+        //
+
+        for (int n = 1; n <= 40; ++n)
+            compareFilters (yw, n, &yca[0], lines);
+
+        compareFilters (yw, maxN, &yca[0], lines);
+    }
+}
+
 } // namespace
 
 void
@@ -189,6 +499,8 @@ testYca (const std::string& tempDir)
 
         std::string fileName = tempDir + "imf_test_yca.exr";
 
+        testFilters ();
+
         Box2i dataWindow[6];
         dataWindow[0] = Box2i (V2i (0, 0), V2i (1, 17));
         dataWindow[1] = Box2i (V2i (0, 0), V2i (5, 17));
@@ -251,6 +563,50 @@ testYca (const std::string& tempDir)
             }
         }
 
+        cout << "\ncomparing line-by-line and block reads" << endl;
+
+        Box2i blockWindow[3];
+        blockWindow[0] = Box2i (V2i (-18, -28), V2i (247, 555));
+        blockWindow[1] = Box2i (V2i (0, 0), V2i (101, 301));
+        blockWindow[2] = Box2i (V2i (0, 0), V2i (1, 41));
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            if (ILMTHREAD_NAMESPACE::supportsThreads ())
+            {
+                setGlobalThreadCount (n);
+                cout << "\nnumber of threads: " << globalThreadCount () << endl;
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int writeOrder = INCREASING_Y; writeOrder <= DECREASING_Y;
+                     ++writeOrder)
+                {
+                    writeReadYcaBlocks (
+                        fileName.c_str (),
+                        blockWindow[i],
+                        WRITE_YCA,
+                        LineOrder (writeOrder),
+                        fillPixelsColor);
+
+                    writeReadYcaBlocks (
+                        fileName.c_str (),
+                        blockWindow[i],
+                        WRITE_YC,
+                        LineOrder (writeOrder),
+                        fillPixelsColor);
+
+                    writeReadYcaBlocks (
+                        fileName.c_str (),
+                        blockWindow[i],
+                        WRITE_Y,
+                        LineOrder (writeOrder),
+                        fillPixelsGray);
+                }
+            }
+        }
+
         cout << "ok\n" << endl;
     }
     catch (const std::exception& e)
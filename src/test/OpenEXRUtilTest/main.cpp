@@ -10,9 +10,14 @@
 #include "ImfNamespace.h"
 #include "OpenEXRConfigInternal.h"
 
+#include "testCheckFileChunks.h"
 #include "testDeepImage.h"
 #include "testFlatImage.h"
 #include "testIO.h"
+#include "testPreviewFile.h"
+#include "testRecompressFile.h"
+#include "testSequenceReader.h"
+#include "testUpdateHeaders.h"
 #include "tmpDir.h"
 #include <ImathRandom.h>
 
@@ -89,6 +94,11 @@ main (int argc, char* argv[])
     TEST (testFlatImage);
     TEST (testDeepImage);
     TEST (testIO);
+    TEST (testRecompressFile);
+    TEST (testCheckFileChunks);
+    TEST (testPreviewFile);
+    TEST (testUpdateHeaders);
+    TEST (testSequenceReader);
     // NB: If you add a test here, make sure to enumerate it in the
     // CMakeLists.txt so it runs as part of the test suite
 
@@ -0,0 +1,281 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <ImathRandom.h>
+#include <ImfCheckFile.h>
+#include <ImfDeepImage.h>
+#include <ImfDeepImageIO.h>
+#include <ImfFlatImage.h>
+#include <ImfFlatImageIO.h>
+#include <ImfHeader.h>
+#include <ImfTileDescription.h>
+#include <openexr.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+vector<char>
+readFile (const string& fileName)
+{
+    ifstream in (fileName.c_str (), ios::binary);
+    return vector<char> (
+        (istreambuf_iterator<char> (in)), istreambuf_iterator<char> ());
+}
+
+void
+writeFile (const string& fileName, const vector<char>& data)
+{
+    ofstream out (fileName.c_str (), ios::binary);
+    out.write (data.data (), data.size ());
+}
+
+void
+checkValid (const string& fileName)
+{
+    vector<ChunkCheckReport> reports;
+
+    assert (!checkOpenEXRFileChunks (fileName.c_str (), reports));
+    assert (reports.empty ());
+
+    //
+    // in-memory version, with a budget smaller than a chunk
+    //
+
+    vector<char> data = readFile (fileName);
+
+    assert (!checkOpenEXRFileChunks (data.data (), data.size (), reports, 1));
+    assert (reports.empty ());
+}
+
+void
+checkInvalid (const string& fileName, int part)
+{
+    vector<ChunkCheckReport> reports;
+
+    assert (checkOpenEXRFileChunks (fileName.c_str (), reports));
+    assert (!reports.empty ());
+
+    cout << "        " << reports.size () << " reports, first: part "
+         << reports[0].part << " chunk " << reports[0].chunk << ": "
+         << reports[0].message << endl;
+
+    for (size_t i = 0; i < reports.size (); ++i)
+    {
+        assert (reports[i].part == part);
+        assert (reports[i].errorCode != EXR_ERR_SUCCESS);
+        assert (!reports[i].message.empty ());
+        assert (i == 0 || reports[i - 1].chunk <= reports[i].chunk);
+    }
+}
+
+void
+fillFlatImage (FlatImage& img)
+{
+    img.insertChannel ("H", HALF);
+    img.insertChannel ("F", FLOAT);
+    img.insertChannel ("UI", UINT);
+
+    Rand48 random (0);
+
+    for (int y = 0; y < img.numYLevels (); ++y)
+    {
+        for (int x = 0; x < img.numXLevels (); ++x)
+        {
+            if (img.levelMode () != RIPMAP_LEVELS && x != y) continue;
+
+            FlatImageLevel& level = img.level (x, y);
+            const Box2i&    dw    = level.dataWindow ();
+
+            TypedFlatImageChannel<half>& h = level.typedChannel<half> ("H");
+            TypedFlatImageChannel<float>& f = level.typedChannel<float> ("F");
+
+            for (int j = dw.min.y; j <= dw.max.y; ++j)
+            {
+                for (int i = dw.min.x; i <= dw.max.x; ++i)
+                {
+                    h.at (i, j) = random.nextf (0, 1);
+                    f.at (i, j) = random.nextf (0, 1);
+                }
+            }
+        }
+    }
+}
+
+void
+testFlatScanLines (const string& fileName, Compression compression)
+{
+    cout << "    scan lines, compression " << compression << endl;
+
+    FlatImage img (Box2i (V2i (-4, 2), V2i (161, 121)));
+    fillFlatImage (img);
+    img.insertChannel ("H22", HALF, 2, 2, true);
+
+    Header hdr;
+    hdr.compression () = compression;
+    saveFlatScanLineImage (fileName, hdr, img);
+
+    checkValid (fileName);
+}
+
+void
+testFlatTiles (const string& fileName, Compression compression)
+{
+    cout << "    tiles, compression " << compression << endl;
+
+    FlatImage img (Box2i (V2i (0, 0), V2i (99, 70)), RIPMAP_LEVELS, ROUND_UP);
+    fillFlatImage (img);
+
+    Header hdr;
+    hdr.compression () = compression;
+    hdr.setTileDescription (TileDescription (16, 32, RIPMAP_LEVELS, ROUND_UP));
+    saveFlatTiledImage (fileName, hdr, img);
+
+    checkValid (fileName);
+}
+
+void
+makeDeepImage (const string& fileName, Compression compression, bool tiled)
+{
+    DeepImage img (Box2i (V2i (0, 0), V2i (40, 30)), ONE_LEVEL);
+    img.insertChannel ("Z", FLOAT);
+    img.insertChannel ("A", HALF);
+
+    //
+    // every pixel has at least one sample, so the cumulative sample
+    // counts in the file increase along each scan line
+    //
+
+    Rand48              random (0);
+    SampleCountChannel& scc = img.level ().sampleCounts ();
+    size_t numPixels        = scc.pixelsPerRow () * scc.pixelsPerColumn ();
+
+    {
+        SampleCountChannel::Edit edit (scc);
+        for (size_t i = 0; i < numPixels; ++i)
+            edit.sampleCounts ()[i] = 1 + random.nexti () % 5;
+    }
+
+    Header hdr;
+    hdr.compression () = compression;
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (16, 16));
+        saveDeepTiledImage (fileName, hdr, img);
+    }
+    else
+    {
+        saveDeepScanLineImage (fileName, hdr, img);
+    }
+}
+
+void
+testDeep (const string& fileName)
+{
+    cout << "    deep scan lines and tiles" << endl;
+
+    makeDeepImage (fileName, ZIPS_COMPRESSION, false);
+    checkValid (fileName);
+
+    makeDeepImage (fileName, ZIP_COMPRESSION, true);
+    checkValid (fileName);
+
+    //
+    // make the cumulative sample counts of the first chunk decrease
+    //
+
+    cout << "    inconsistent sample count table" << endl;
+
+    makeDeepImage (fileName, NO_COMPRESSION, false);
+
+    exr_context_t    f;
+    exr_chunk_info_t cinfo;
+
+    assert (exr_start_read (&f, fileName.c_str (), NULL) == EXR_ERR_SUCCESS);
+    assert (
+        exr_read_scanline_chunk_info (f, 0, 0, &cinfo) == EXR_ERR_SUCCESS);
+    exr_finish (&f);
+
+    vector<char> data = readFile (fileName);
+    int32_t      counts[2];
+
+    memcpy (counts, &data[cinfo.sample_count_data_offset], sizeof (counts));
+    assert (counts[0] < counts[1]);
+    counts[0] = counts[1] + 1;
+    memcpy (&data[cinfo.sample_count_data_offset], counts, sizeof (counts));
+
+    writeFile (fileName, data);
+    checkInvalid (fileName, 0);
+}
+
+void
+testCorruptChunks (const string& fileName)
+{
+    cout << "    corrupt chunk data" << endl;
+
+    testFlatScanLines (fileName, ZIP_COMPRESSION);
+
+    vector<char> data = readFile (fileName);
+    for (size_t i = data.size () / 2; i < data.size () / 2 + 32; ++i)
+        data[i] ^= 0x5a;
+
+    writeFile (fileName, data);
+    checkInvalid (fileName, 0);
+
+    cout << "    truncated file" << endl;
+
+    testFlatTiles (fileName, PIZ_COMPRESSION);
+
+    data = readFile (fileName);
+    data.resize (data.size () - data.size () / 4);
+
+    writeFile (fileName, data);
+    checkInvalid (fileName, 0);
+}
+
+} // namespace
+
+void
+testCheckFileChunks (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing parallel validation of chunks" << endl;
+
+        string fileName = tempDir + "checkChunks.exr";
+
+        testFlatScanLines (fileName, NO_COMPRESSION);
+        testFlatScanLines (fileName, PIZ_COMPRESSION);
+        testFlatScanLines (fileName, B44_COMPRESSION);
+        testFlatScanLines (fileName, DWAB_COMPRESSION);
+        testFlatTiles (fileName, RLE_COMPRESSION);
+        testFlatTiles (fileName, DWAA_COMPRESSION);
+        testDeep (fileName);
+        testCorruptChunks (fileName);
+
+        remove (fileName.c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
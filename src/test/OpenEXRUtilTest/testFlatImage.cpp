@@ -11,9 +11,11 @@
 #include <ImathRandom.h>
 #include <ImfFlatImage.h>
 #include <ImfFlatImageIO.h>
+#include <ImfFlatImageLevels.h>
 #include <ImfHeader.h>
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 
 using namespace OPENEXR_IMF_NAMESPACE;
@@ -571,6 +573,325 @@ testRenameChannels ()
     assert (caught);
 }
 
+int
+referenceIndex (int x, int w, Extrapolation ext)
+{
+    //
+    // Straightforward extrapolation of pixel index x in a row or
+    // column of w pixels; returns -1 for black pixels.
+    //
+
+    if (x >= 0 && x < w) return x;
+
+    switch (ext)
+    {
+        case EXTRAPOLATE_BLACK: return -1;
+
+        case EXTRAPOLATE_CLAMP: return (x < 0) ? 0 : w - 1;
+
+        case EXTRAPOLATE_PERIODIC: return ((x % w) + w) % w;
+
+        case EXTRAPOLATE_MIRROR:
+        {
+            int m = ((x % (2 * w)) + 2 * w) % (2 * w);
+            return (m < w) ? m : 2 * w - 1 - m;
+        }
+    }
+
+    return -1;
+}
+
+template <class T>
+double
+referencePixel (
+    const FlatImageChannel& c, bool horizontal, int i, int j, Extrapolation ext)
+{
+    //
+    // Returns the value of pixel i in row j (horizontal) or pixel i
+    // in column j (vertical), relative to the data window origin.
+    //
+
+    const TypedFlatImageChannel<T>& tc =
+        dynamic_cast<const TypedFlatImageChannel<T>&> (c);
+
+    const Box2i& dw = c.level ().dataWindow ();
+    int w = horizontal ? dw.max.x - dw.min.x + 1 : dw.max.y - dw.min.y + 1;
+    int k = referenceIndex (i, w, ext);
+
+    if (k < 0) return 0;
+
+    return horizontal ? double (tc.at (dw.min.x + k, dw.min.y + j))
+                      : double (tc.at (dw.min.x + j, dw.min.y + k));
+}
+
+template <class T>
+void
+referenceReduce (
+    const FlatImageChannel& in,
+    FlatImageChannel&       out,
+    bool                    horizontal,
+    Extrapolation           ext,
+    bool                    odd,
+    bool                    filter)
+{
+    TypedFlatImageChannel<T>& tc =
+        dynamic_cast<TypedFlatImageChannel<T>&> (out);
+
+    const Box2i& inDw  = in.level ().dataWindow ();
+    const Box2i& outDw = out.level ().dataWindow ();
+
+    int n0 = horizontal ? inDw.max.x - inDw.min.x + 1
+                        : inDw.max.y - inDw.min.y + 1;
+
+    int n1 = horizontal ? outDw.max.x - outDw.min.x + 1
+                        : outDw.max.y - outDw.min.y + 1;
+
+    double f = (n1 > 1) ? double (n0 - 2) / (n1 - 1) : 1;
+
+    for (int y = 0; y <= outDw.max.y - outDw.min.y; ++y)
+    {
+        for (int x = 0; x <= outDw.max.x - outDw.min.x; ++x)
+        {
+            int i = horizontal ? x : y;
+            int j = horizontal ? y : x;
+            T&  p = tc.at (outDw.min.x + x, outDw.min.y + y);
+
+            if (!filter)
+            {
+                int k = 2 * i + (odd ? (n0 - 1) - 2 * (n1 - 1) : 0);
+                p     = T (referencePixel<T> (in, horizontal, k, j, ext));
+                continue;
+            }
+
+            double v[4];
+
+            for (int t = 0; t < 4; ++t)
+            {
+                double pos = i * f + (t - 1);
+                int    xs  = int (floor (pos));
+                double s   = xs + 1 - pos;
+
+                v[t] = s * referencePixel<T> (in, horizontal, xs, j, ext) +
+                       (1 - s) *
+                           referencePixel<T> (in, horizontal, xs + 1, j, ext);
+            }
+
+            p = T (0.125 * v[0] + 0.375 * v[1] + 0.375 * v[2] + 0.125 * v[3]);
+        }
+    }
+}
+
+void
+referenceReduce (
+    const FlatImageLevel& in,
+    FlatImageLevel&       out,
+    bool                  horizontal,
+    Extrapolation         ext,
+    bool                  odd,
+    const set<string>&    doNotFilter)
+{
+    for (FlatImageLevel::ConstIterator i = in.begin (); i != in.end (); ++i)
+    {
+        FlatImageChannel& c      = out.channel (i.name ());
+        bool              filter = doNotFilter.count (i.name ()) == 0;
+
+        switch (i.channel ().pixelType ())
+        {
+            case HALF:
+                referenceReduce<half> (
+                    i.channel (), c, horizontal, ext, odd, filter);
+                break;
+
+            case FLOAT:
+                referenceReduce<float> (
+                    i.channel (), c, horizontal, ext, odd, filter);
+                break;
+
+            case UINT:
+                referenceReduce<unsigned int> (
+                    i.channel (), c, horizontal, ext, odd, filter);
+                break;
+
+            default: assert (false);
+        }
+    }
+}
+
+void
+referenceLevels (
+    FlatImage&         img,
+    Extrapolation      extX,
+    Extrapolation      extY,
+    const set<string>& doNotFilter)
+{
+    if (img.levelMode () == MIPMAP_LEVELS)
+    {
+        for (int l = 1; l < img.numLevels (); ++l)
+        {
+            const Box2i& dw0 = img.dataWindowForLevel (l - 1);
+            const Box2i& dw1 = img.dataWindowForLevel (l);
+
+            FlatImage tmp (Box2i (dw0.min, V2i (dw1.max.x, dw0.max.y)));
+
+            for (FlatImageLevel::ConstIterator i = img.level ().begin ();
+                 i != img.level ().end ();
+                 ++i)
+            {
+                tmp.insertChannel (i.name (), i.channel ().pixelType ());
+            }
+
+            referenceReduce (
+                img.level (l - 1),
+                tmp.level (),
+                true,
+                extX,
+                l & 1,
+                doNotFilter);
+
+            referenceReduce (
+                tmp.level (), img.level (l), false, extY, l & 1, doNotFilter);
+        }
+    }
+    else if (img.levelMode () == RIPMAP_LEVELS)
+    {
+        for (int ly = 0; ly < img.numYLevels (); ++ly)
+        {
+            if (ly > 0)
+            {
+                referenceReduce (
+                    img.level (0, ly - 1),
+                    img.level (0, ly),
+                    false,
+                    extY,
+                    (ly - 1) & 1,
+                    doNotFilter);
+            }
+
+            for (int lx = 1; lx < img.numXLevels (); ++lx)
+            {
+                referenceReduce (
+                    img.level (lx - 1, ly),
+                    img.level (lx, ly),
+                    true,
+                    extX,
+                    (lx - 1) & 1,
+                    doNotFilter);
+            }
+        }
+    }
+}
+
+void
+testGenerateLevels (
+    const Box2i&      dataWindow,
+    LevelMode         levelMode,
+    LevelRoundingMode roundingMode,
+    Extrapolation     extX,
+    Extrapolation     extY)
+{
+    cout << "    levels " << dataWindow.max.x - dataWindow.min.x + 1 << " x "
+         << dataWindow.max.y - dataWindow.min.y + 1 << ", mode " << levelMode
+         << ", rounding " << roundingMode << ", "
+         << wrapmodesForExtrapolation (extX, extY) << endl;
+
+    FlatImage img1 (dataWindow, levelMode, roundingMode);
+    img1.insertChannel ("A", HALF);
+    img1.insertChannel ("B", FLOAT);
+    img1.insertChannel ("C", UINT);
+    img1.insertChannel ("Z", FLOAT);
+
+    FlatImage img2 (dataWindow, levelMode, roundingMode);
+    img2.insertChannel ("A", HALF);
+    img2.insertChannel ("B", FLOAT);
+    img2.insertChannel ("C", UINT);
+    img2.insertChannel ("Z", FLOAT);
+
+    {
+        Rand48 random (1);
+        fillChannels (random, img1.level ());
+    }
+
+    {
+        Rand48 random (1);
+        fillChannels (random, img2.level ());
+    }
+
+    set<string> doNotFilter;
+    doNotFilter.insert ("Z");
+
+    generateFlatImageLevels (img1, extX, extY, doNotFilter);
+    referenceLevels (img2, extX, extY, doNotFilter);
+
+    verifyImagesAreEqual (img1, img2);
+}
+
+void
+testGenerateLevels ()
+{
+    cout << "generating image levels" << endl;
+
+    const Box2i dataWindows[] = {
+        Box2i (V2i (0, 0), V2i (0, 0)),
+        Box2i (V2i (-3, 5), V2i (36, 44)),
+        Box2i (V2i (10, -20), V2i (40, 2)),
+        Box2i (V2i (0, 0), V2i (1, 6))};
+
+    const Extrapolation extrapolations[] = {
+        EXTRAPOLATE_BLACK,
+        EXTRAPOLATE_CLAMP,
+        EXTRAPOLATE_PERIODIC,
+        EXTRAPOLATE_MIRROR};
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int r = 0; r < 2; ++r)
+        {
+            LevelRoundingMode rm = r ? ROUND_UP : ROUND_DOWN;
+
+            for (int e = 0; e < 4; ++e)
+            {
+                testGenerateLevels (
+                    dataWindows[i],
+                    MIPMAP_LEVELS,
+                    rm,
+                    extrapolations[e],
+                    extrapolations[3 - e]);
+
+                testGenerateLevels (
+                    dataWindows[i],
+                    RIPMAP_LEVELS,
+                    rm,
+                    extrapolations[e],
+                    extrapolations[(e + 1) % 4]);
+            }
+        }
+    }
+
+    //
+    // Subsampled channels are rejected, either when they are inserted
+    // into a multiresolution image, or when the levels are generated.
+    //
+
+    cout << "    subsampled channels" << endl;
+
+    bool caught = false;
+
+    try
+    {
+        FlatImage img (Box2i (V2i (0, 0), V2i (15, 15)), MIPMAP_LEVELS);
+        img.insertChannel ("Y", HALF);
+        img.insertChannel ("RY", HALF, 2, 2);
+        generateFlatImageLevels (img);
+        assert (false);
+    }
+    catch (...)
+    {
+        // expecting exception
+        caught = true;
+    }
+    assert (caught);
+}
+
 } // namespace
 
 void
@@ -586,6 +907,7 @@ testFlatImage (const string& tempDir)
         testCropping (tempDir + "cropped.exr");
         testRenameChannel ();
         testRenameChannels ();
+        testGenerateLevels ();
 
         cout << "ok\n" << endl;
     }
@@ -0,0 +1,382 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <ImathFun.h>
+#include <ImathRandom.h>
+#include <ImfArray.h>
+#include <ImfFlatImage.h>
+#include <ImfFlatImageIO.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfPreviewFile.h>
+#include <ImfRgbaFile.h>
+#include <ImfTileDescription.h>
+#include <ImfTiledRgbaFile.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+//
+// The preview image computation of the original exrmakepreview
+// program, applied to a whole image level.
+//
+
+unsigned char
+gamma (half h, float m)
+{
+    float x = max (0.f, h * m);
+
+    if (x > 1) x = 1 + log ((x - 1) * 0.184874f + 1) / 0.184874f;
+
+    return (unsigned char) (IMATH_NAMESPACE::clamp (
+        std::pow (x, 0.4545f) * 84.66f, 0.f, 255.f));
+}
+
+void
+referencePreview (
+    const Array2D<Rgba>& pixels,
+    int                  w,
+    int                  h,
+    float                exposure,
+    PreviewImage&        preview)
+{
+    int previewWidth  = preview.width ();
+    int previewHeight = preview.height ();
+
+    double fx = (previewWidth > 1) ? (double (w - 1) / (previewWidth - 1)) : 1;
+    double fy = (previewHeight > 1) ? (double (h - 1) / (previewHeight - 1))
+                                    : 1;
+    float  m  = std::pow (
+        2.f, IMATH_NAMESPACE::clamp (exposure + 2.47393f, -20.f, 20.f));
+
+    for (int y = 0; y < previewHeight; ++y)
+    {
+        for (int x = 0; x < previewWidth; ++x)
+        {
+            PreviewRgba& p     = preview.pixel (x, y);
+            const Rgba&  pixel = pixels[int (y * fy + .5f)][int (x * fx + .5f)];
+
+            p.r = gamma (pixel.r, m);
+            p.g = gamma (pixel.g, m);
+            p.b = gamma (pixel.b, m);
+            p.a = int (
+                IMATH_NAMESPACE::clamp (pixel.a * 255.f, 0.f, 255.f) + .5f);
+        }
+    }
+}
+
+void
+comparePreviews (const PreviewImage& p1, const PreviewImage& p2)
+{
+    assert (p1.width () == p2.width ());
+    assert (p1.height () == p2.height ());
+
+    assert (!memcmp (
+        p1.pixels (),
+        p2.pixels (),
+        p1.width () * p1.height () * sizeof (PreviewRgba)));
+}
+
+void
+fillImage (FlatImage& img, bool luminance)
+{
+    const char* names[] = {"R", "G", "B", "A"};
+
+    if (luminance)
+        img.insertChannel ("Y", HALF);
+    else
+        for (int c = 0; c < 4; ++c)
+            img.insertChannel (names[c], HALF);
+
+    img.insertChannel ("Z", FLOAT);
+
+    Rand48 random (0);
+
+    for (int ly = 0; ly < img.numYLevels (); ++ly)
+    {
+        for (int lx = 0; lx < img.numXLevels (); ++lx)
+        {
+            if (img.levelMode () != RIPMAP_LEVELS && lx != ly) continue;
+
+            FlatImageLevel& level = img.level (lx, ly);
+            const Box2i&    dw    = level.dataWindow ();
+
+            for (FlatImageLevel::Iterator i = level.begin (); i != level.end ();
+                 ++i)
+            {
+                if (i.channel ().pixelType () != HALF) continue;
+
+                TypedFlatImageChannel<half>& c =
+                    dynamic_cast<TypedFlatImageChannel<half>&> (i.channel ());
+
+                //
+                // alpha in [-0.5, 1.5], colors in [-1, 16]
+                //
+
+                bool alpha = i.name () == "A";
+
+                for (int y = dw.min.y; y <= dw.max.y; ++y)
+                    for (int x = dw.min.x; x <= dw.max.x; ++x)
+                        c.at (x, y) = alpha ? random.nextf (-0.5, 1.5)
+                                            : random.nextf (-1, 16);
+            }
+        }
+    }
+}
+
+void
+readLevel (
+    const string&  fileName,
+    int            lx,
+    int            ly,
+    Array2D<Rgba>& pixels,
+    int&           w,
+    int&           h)
+{
+    Box2i dw;
+
+    if (lx < 0)
+    {
+        RgbaInputFile in (fileName.c_str ());
+        dw = in.dataWindow ();
+        w  = dw.max.x - dw.min.x + 1;
+        h  = dw.max.y - dw.min.y + 1;
+
+        pixels.resizeErase (h, w);
+        in.setFrameBuffer (ComputeBasePointer (&pixels[0][0], dw), 1, w);
+        in.readPixels (dw.min.y, dw.max.y);
+    }
+    else
+    {
+        TiledRgbaInputFile in (fileName.c_str ());
+        dw = in.dataWindowForLevel (lx, ly);
+        w  = dw.max.x - dw.min.x + 1;
+        h  = dw.max.y - dw.min.y + 1;
+
+        pixels.resizeErase (h, w);
+        in.setFrameBuffer (ComputeBasePointer (&pixels[0][0], dw), 1, w);
+        in.readTiles (
+            0, in.numXTiles (lx) - 1, 0, in.numYTiles (ly) - 1, lx, ly);
+    }
+}
+
+//
+// Make a preview of fileName and compare it with the reference
+// preview of level (lx, ly) of the file, or of the whole file if
+// lx is negative.
+//
+
+void
+checkPreview (
+    const string& fileName,
+    int           previewWidth,
+    int           previewHeight,
+    float         exposure,
+    int           lx,
+    int           ly)
+{
+    PreviewImage preview =
+        makePreviewImage (fileName.c_str (), previewWidth, exposure);
+
+    assert (int (preview.width ()) == previewWidth);
+    assert (int (preview.height ()) == previewHeight);
+
+    Array2D<Rgba> pixels;
+    int           w, h;
+    readLevel (fileName, lx, ly, pixels, w, h);
+
+    PreviewImage reference (previewWidth, previewHeight);
+    referencePreview (pixels, w, h, exposure, reference);
+
+    comparePreviews (preview, reference);
+}
+
+void
+testScanLines (const string& fileName)
+{
+    static const Compression methods[] = {
+        NO_COMPRESSION, ZIP_COMPRESSION, PIZ_COMPRESSION, DWAB_COMPRESSION};
+
+    for (int luminance = 0; luminance < 2; ++luminance)
+    {
+        FlatImage img (Box2i (V2i (-3, 5), V2i (236, 124)));
+        fillImage (img, luminance != 0);
+
+        for (size_t i = 0; i < sizeof (methods) / sizeof (methods[0]); ++i)
+        {
+            cout << "    scan lines, compression " << methods[i]
+                 << (luminance ? ", luminance" : "") << endl;
+
+            Header hdr;
+            hdr.compression () = methods[i];
+            saveFlatScanLineImage (fileName, hdr, img);
+
+            checkPreview (fileName, 60, 30, 0, -1, -1);
+            checkPreview (fileName, 1, 1, 2.5, -1, -1);
+            checkPreview (fileName, 300, 150, -1, -1, -1);
+        }
+    }
+}
+
+void
+testTiles (const string& fileName)
+{
+    cout << "    tiles, one level" << endl;
+
+    {
+        FlatImage img (Box2i (V2i (0, 0), V2i (199, 99)), ONE_LEVEL);
+        fillImage (img, false);
+
+        Header hdr;
+        hdr.compression () = ZIP_COMPRESSION;
+        hdr.setTileDescription (TileDescription (32, 16));
+        saveFlatTiledImage (fileName, hdr, img);
+
+        checkPreview (fileName, 60, 30, 0, 0, 0);
+    }
+
+    //
+    // A 40x20 preview of a 200x100 image with levels is made from the
+    // 50x25 level (2, 2), or from levels 2 and 2 in x and y.
+    //
+
+    cout << "    tiles, mipmap" << endl;
+
+    {
+        FlatImage img (
+            Box2i (V2i (0, 0), V2i (199, 99)), MIPMAP_LEVELS, ROUND_DOWN);
+        fillImage (img, false);
+
+        Header hdr;
+        hdr.compression () = PIZ_COMPRESSION;
+        hdr.setTileDescription (
+            TileDescription (16, 16, MIPMAP_LEVELS, ROUND_DOWN));
+        saveFlatTiledImage (fileName, hdr, img);
+
+        checkPreview (fileName, 40, 20, 0, 2, 2);
+        checkPreview (fileName, 200, 100, 0, 0, 0);
+    }
+
+    cout << "    tiles, ripmap" << endl;
+
+    {
+        FlatImage img (
+            Box2i (V2i (0, 0), V2i (199, 99)), RIPMAP_LEVELS, ROUND_DOWN);
+        fillImage (img, false);
+
+        Header hdr;
+        hdr.compression () = ZIP_COMPRESSION;
+        hdr.setTileDescription (
+            TileDescription (16, 16, RIPMAP_LEVELS, ROUND_DOWN));
+        hdr.pixelAspectRatio () = 2;
+        saveFlatTiledImage (fileName, hdr, img);
+
+        //
+        // with pixel aspect ratio 2, a 40 pixel wide preview is 10
+        // pixels high: level 2 in x and level 3 in y
+        //
+
+        checkPreview (fileName, 40, 10, 0, 2, 3);
+    }
+}
+
+void
+testUpdate (const string& fileName)
+{
+    cout << "    in-place update" << endl;
+
+    FlatImage img (Box2i (V2i (0, 0), V2i (99, 49)));
+    fillImage (img, false);
+
+    //
+    // no preview image in the file: nothing can be updated
+    //
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    saveFlatScanLineImage (fileName, hdr, img);
+
+    PreviewImage preview = makePreviewImage (fileName.c_str (), 20);
+    assert (!updatePreviewImage (fileName.c_str (), preview));
+    assert (!InputFile (fileName.c_str ()).header ().hasPreviewImage ());
+
+    //
+    // a blank preview image of the same size is replaced
+    //
+
+    hdr.setPreviewImage (PreviewImage (20, 10));
+    saveFlatScanLineImage (fileName, hdr, img);
+
+    assert (updatePreviewImage (fileName.c_str (), preview));
+
+    {
+        InputFile in (fileName.c_str ());
+        comparePreviews (in.header ().previewImage (), preview);
+    }
+
+    FlatImage img2;
+    loadFlatImage (fileName, img2);
+
+    const TypedFlatImageChannel<half>& r1 =
+        img.level ().typedChannel<half> ("R");
+    const TypedFlatImageChannel<half>& r2 =
+        img2.level ().typedChannel<half> ("R");
+
+    for (int y = 0; y < 50; ++y)
+        for (int x = 0; x < 100; ++x)
+            assert (r1.at (x, y).bits () == r2.at (x, y).bits ());
+
+    //
+    // a preview image of a different size does not fit
+    //
+
+    PreviewImage preview2 = makePreviewImage (fileName.c_str (), 30);
+    assert (!updatePreviewImage (fileName.c_str (), preview2));
+
+    {
+        InputFile in (fileName.c_str ());
+        comparePreviews (in.header ().previewImage (), preview);
+    }
+}
+
+} // namespace
+
+void
+testPreviewFile (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing preview image generation and update" << endl;
+
+        string fileName = tempDir + "previewFile.exr";
+
+        testScanLines (fileName);
+        testTiles (fileName);
+        testUpdate (fileName);
+
+        remove (fileName.c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -0,0 +1,372 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <ImathRandom.h>
+#include <ImfFlatImage.h>
+#include <ImfFlatImageIO.h>
+#include <ImfHeader.h>
+#include <ImfRecompressFile.h>
+#include <ImfStandardAttributes.h>
+#include <ImfTileDescription.h>
+
+#include <cassert>
+#include <cstdio>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+template <class T>
+void
+verifyPixelsAreEqual (const FlatImageChannel& c1, const FlatImageChannel& c2)
+{
+    const TypedFlatImageChannel<T>& tc1 =
+        dynamic_cast<const TypedFlatImageChannel<T>&> (c1);
+
+    const TypedFlatImageChannel<T>& tc2 =
+        dynamic_cast<const TypedFlatImageChannel<T>&> (c2);
+
+    const Box2i& dataWindow = c1.level ().dataWindow ();
+
+    for (int y = dataWindow.min.y; y <= dataWindow.max.y; y += c1.ySampling ())
+        for (int x = dataWindow.min.x; x <= dataWindow.max.x;
+             x += c1.xSampling ())
+            if (tc1.at (x, y) != tc2.at (x, y))
+                throw ArgExc ("different pixel values");
+}
+
+void
+verifyLevelsAreEqual (
+    const FlatImageLevel& level1, const FlatImageLevel& level2)
+{
+    if (level1.dataWindow () != level2.dataWindow ())
+        throw ArgExc ("different data windows");
+
+    FlatImageLevel::ConstIterator i1 = level1.begin ();
+    FlatImageLevel::ConstIterator i2 = level2.begin ();
+
+    for (; i1 != level1.end () && i2 != level2.end (); ++i1, ++i2)
+    {
+        if (i1.name () != i2.name () ||
+            i1.channel ().pixelType () != i2.channel ().pixelType ())
+            throw ArgExc ("different channels");
+
+        switch (i1.channel ().pixelType ())
+        {
+            case HALF:
+                verifyPixelsAreEqual<half> (i1.channel (), i2.channel ());
+                break;
+
+            case FLOAT:
+                verifyPixelsAreEqual<float> (i1.channel (), i2.channel ());
+                break;
+
+            case UINT:
+                verifyPixelsAreEqual<unsigned int> (
+                    i1.channel (), i2.channel ());
+                break;
+
+            default: assert (false);
+        }
+    }
+
+    if (i1 != level1.end () || i2 != level2.end ())
+        throw ArgExc ("different channel lists");
+}
+
+void
+verifyImagesAreEqual (const FlatImage& img1, const FlatImage& img2)
+{
+    if (img1.levelMode () != img2.levelMode () ||
+        img1.numXLevels () != img2.numXLevels () ||
+        img1.numYLevels () != img2.numYLevels ())
+        throw ArgExc ("different levels");
+
+    for (int y = 0; y < img1.numYLevels (); ++y)
+    {
+        for (int x = 0; x < img1.numXLevels (); ++x)
+        {
+            if (img1.levelMode () != RIPMAP_LEVELS && x != y) continue;
+
+            verifyLevelsAreEqual (img1.level (x, y), img2.level (x, y));
+        }
+    }
+}
+
+template <class T>
+void
+fillChannel (Rand48& random, FlatImageChannel& c)
+{
+    TypedFlatImageChannel<T>& tc = dynamic_cast<TypedFlatImageChannel<T>&> (c);
+
+    const Box2i& dataWindow = tc.level ().dataWindow ();
+
+    for (int y = dataWindow.min.y; y <= dataWindow.max.y; y += tc.ySampling ())
+        for (int x = dataWindow.min.x; x <= dataWindow.max.x;
+             x += tc.xSampling ())
+            tc.at (x, y) = T (random.nextf (0.0, 100.0));
+}
+
+void
+fillChannels (Rand48& random, FlatImage& img)
+{
+    for (int y = 0; y < img.numYLevels (); ++y)
+    {
+        for (int x = 0; x < img.numXLevels (); ++x)
+        {
+            if (img.levelMode () != RIPMAP_LEVELS && x != y) continue;
+
+            FlatImageLevel& level = img.level (x, y);
+
+            for (FlatImageLevel::Iterator i = level.begin (); i != level.end ();
+                 ++i)
+            {
+                switch (i.channel ().pixelType ())
+                {
+                    case HALF:
+                        fillChannel<half> (random, i.channel ());
+                        break;
+
+                    case FLOAT:
+                        fillChannel<float> (random, i.channel ());
+                        break;
+
+                    case UINT:
+                        fillChannel<unsigned int> (random, i.channel ());
+                        break;
+
+                    default: assert (false);
+                }
+            }
+        }
+    }
+}
+
+void
+recompressAndVerify (
+    const FlatImage& img1,
+    const string&    inFileName,
+    const string&    outFileName,
+    Compression      compression)
+{
+    cout << "        compression " << compression << endl;
+
+    RecompressStats stats;
+    recompressFile (
+        inFileName.c_str (), outFileName.c_str (), compression, &stats);
+
+    assert (stats.chunksRead > 0 && stats.chunksWritten > 0);
+    assert (stats.bytesWritten > 0);
+
+    Header    hdr;
+    FlatImage img2;
+    loadFlatImage (outFileName, hdr, img2);
+
+    assert (hdr.compression () == compression);
+    assert (hasComments (hdr) && comments (hdr) == "recompressed");
+
+    verifyImagesAreEqual (img1, img2);
+}
+
+void
+testRecompress (
+    FlatImage&    img1,
+    const Header& hdr,
+    bool          tiled,
+    string        fileName1,
+    string        fileName2)
+{
+    Rand48 random (0);
+    fillChannels (random, img1);
+
+    if (tiled)
+        saveFlatTiledImage (fileName1, hdr, img1);
+    else
+        saveFlatScanLineImage (fileName1, hdr, img1);
+
+    //
+    // Lossless methods must reproduce the pixels exactly.  Each
+    // conversion starts from the output of the previous one, so
+    // that every method is both decompressed and compressed.
+    //
+
+    static const Compression methods[] = {
+        RLE_COMPRESSION,
+        PIZ_COMPRESSION,
+        ZIPS_COMPRESSION,
+        NO_COMPRESSION,
+        ZIP_COMPRESSION,
+        ZIP_COMPRESSION};
+
+    for (size_t i = 0; i < sizeof (methods) / sizeof (methods[0]); ++i)
+    {
+        recompressAndVerify (img1, fileName1, fileName2, methods[i]);
+        swap (fileName1, fileName2);
+    }
+
+    //
+    // Lossy methods: converting the lossy file to a lossless method
+    // must preserve its pixels.
+    //
+
+    static const Compression lossy[] = {
+        PXR24_COMPRESSION, B44_COMPRESSION, DWAB_COMPRESSION};
+
+    for (size_t i = 0; i < sizeof (lossy) / sizeof (lossy[0]); ++i)
+    {
+        cout << "        compression " << lossy[i] << endl;
+
+        recompressFile (fileName1.c_str (), fileName2.c_str (), lossy[i]);
+
+        FlatImage img2;
+        loadFlatImage (fileName2, img2);
+
+        recompressAndVerify (img2, fileName2, fileName1, PIZ_COMPRESSION);
+    }
+
+    remove (fileName1.c_str ());
+    remove (fileName2.c_str ());
+}
+
+void
+testScanLineImage (const string& fileName1, const string& fileName2)
+{
+    cout << "    scan lines" << endl;
+
+    FlatImage img (Box2i (V2i (-10, -4), V2i (131, 101)));
+    img.insertChannel ("H", HALF);
+    img.insertChannel ("F", FLOAT);
+    img.insertChannel ("UI", UINT);
+    img.insertChannel ("H22", HALF, 2, 2, true);
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    addComments (hdr, "recompressed");
+
+    testRecompress (img, hdr, false, fileName1, fileName2);
+}
+
+void
+testTiledImage (
+    LevelMode     levelMode,
+    const string& fileName1,
+    const string& fileName2)
+{
+    cout << "    tiles, level mode " << levelMode << endl;
+
+    FlatImage img (Box2i (V2i (3, -5), V2i (99, 70)), levelMode, ROUND_UP);
+    img.insertChannel ("H", HALF);
+    img.insertChannel ("F", FLOAT);
+    img.insertChannel ("UI", UINT);
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.setTileDescription (TileDescription (16, 32, levelMode, ROUND_UP));
+    addComments (hdr, "recompressed");
+
+    testRecompress (img, hdr, true, fileName1, fileName2);
+}
+
+float
+dwaLevel (const string& fileName)
+{
+    Header    hdr;
+    FlatImage img;
+    loadFlatImage (fileName, hdr, img);
+
+    const FloatAttribute* attr =
+        hdr.findTypedAttribute<FloatAttribute> ("dwaCompressionLevel");
+
+    assert (attr && hdr.dwaCompressionLevel () == attr->value ());
+    return attr->value ();
+}
+
+void
+testDwaLevel (
+    const string& fileName1, const string& fileName2, const string& fileName3)
+{
+    cout << "    dwa compression level" << endl;
+
+    FlatImage img1 (Box2i (V2i (0, 0), V2i (127, 63)));
+    img1.insertChannel ("H", HALF);
+    img1.insertChannel ("F", FLOAT);
+
+    Rand48 random (1);
+    fillChannels (random, img1);
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    saveFlatScanLineImage (fileName1, hdr, img1);
+
+    //
+    // An explicit level is used, and stored in the output header.
+    // The pixels match those of a file that the OpenEXR library
+    // compresses at the same level.
+    //
+
+    recompressFile (
+        fileName1.c_str (), fileName2.c_str (), DWAB_COMPRESSION, 0, 100);
+    assert (dwaLevel (fileName2) == 100);
+
+    hdr.compression ()         = DWAB_COMPRESSION;
+    hdr.dwaCompressionLevel () = 100;
+    saveFlatScanLineImage (fileName3, hdr, img1);
+
+    FlatImage img2, img3;
+    loadFlatImage (fileName2, img2);
+    loadFlatImage (fileName3, img3);
+    verifyImagesAreEqual (img2, img3);
+
+    //
+    // Without an explicit level, the level of the input is kept.
+    //
+
+    recompressFile (fileName2.c_str (), fileName1.c_str (), DWAA_COMPRESSION);
+    assert (dwaLevel (fileName1) == 100);
+
+    recompressFile (
+        fileName2.c_str (), fileName1.c_str (), DWAA_COMPRESSION, 0, 20);
+    assert (dwaLevel (fileName1) == 20);
+
+    remove (fileName1.c_str ());
+    remove (fileName2.c_str ());
+    remove (fileName3.c_str ());
+}
+
+} // namespace
+
+void
+testRecompressFile (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing recompression of files" << endl;
+
+        string fileName1 = tempDir + "recompress1.exr";
+        string fileName2 = tempDir + "recompress2.exr";
+
+        testScanLineImage (fileName1, fileName2);
+        testTiledImage (ONE_LEVEL, fileName1, fileName2);
+        testTiledImage (MIPMAP_LEVELS, fileName1, fileName2);
+        testTiledImage (RIPMAP_LEVELS, fileName1, fileName2);
+        testDwaLevel (fileName1, fileName2, tempDir + "recompress3.exr");
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -0,0 +1,351 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFlatImage.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfOutputFile.h>
+#include <ImfSequenceReader.h>
+#include <ImfThreading.h>
+#include <ImfTiledOutputFile.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int FIRST   = 10;
+const int LAST    = 21;
+const int MISSING = 17; // this frame has no file
+
+//
+// Most frames have the same layout; frame 14 has a larger data
+// window and an extra channel, and frame 15 is tiled.  A second
+// sequence consists only of tiled frames.
+//
+
+const int TILED_FIRST = 1;
+const int TILED_LAST  = 10;
+
+Box2i
+frameDataWindow (int frame)
+{
+    if (frame == 14) return Box2i (V2i (-3, -2), V2i (80, 50));
+
+    return Box2i (V2i (0, 0), V2i (63, 47));
+}
+
+float
+pixelValue (int frame, int x, int y)
+{
+    return frame * 1000 + x + y * 0.5f;
+}
+
+void
+writeFrame (const string& fileName, int frame, bool tiled)
+{
+    Box2i  dw = frameDataWindow (frame);
+    int    w  = dw.max.x - dw.min.x + 1;
+    int    h  = dw.max.y - dw.min.y + 1;
+    Header hdr (dw, dw);
+
+    hdr.compression () = ZIP_COMPRESSION;
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+
+    if (frame == 14) hdr.channels ().insert ("A", Channel (HALF));
+
+    Array2D<float> z (h, w);
+    Array2D<half>  a (h, w);
+
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            z[y][x] = pixelValue (frame, x + dw.min.x, y + dw.min.y);
+            a[y][x] = 0.5f;
+        }
+    }
+
+    FrameBuffer fb;
+    ptrdiff_t   offset = dw.min.x + ptrdiff_t (dw.min.y) * w;
+
+    fb.insert (
+        "Z",
+        Slice (
+            FLOAT,
+            (char*) (&z[0][0] - offset),
+            sizeof (float),
+            sizeof (float) * w));
+
+    fb.insert (
+        "A",
+        Slice (
+            HALF,
+            (char*) (&a[0][0] - offset),
+            sizeof (half),
+            sizeof (half) * w));
+
+    if (tiled)
+    {
+        hdr.setTileDescription (TileDescription (16, 16, ONE_LEVEL));
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (h);
+    }
+}
+
+void
+checkFrame (SequenceReader& reader, int frame, bool allTiled = false)
+{
+    if (frame == MISSING && !allTiled)
+    {
+        try
+        {
+            reader.frame (frame);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::BaseExc&)
+        {
+            // expected
+        }
+
+        return;
+    }
+
+    const FlatImage& img = reader.frame (frame);
+    Box2i            dw  = frameDataWindow (frame);
+
+    assert (img.dataWindow () == dw);
+    assert (reader.header ().dataWindow () == dw);
+    assert ((img.level ().findChannel ("A") != 0) == (frame == 14));
+
+    const TypedFlatImageChannel<float>& z =
+        img.level ().typedChannel<float> ("Z");
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+            assert (z.at (x, y) == pixelValue (frame, x, y));
+
+    assert (reader.readAhead () >= reader.minReadAhead ());
+    assert (reader.readAhead () <= reader.maxReadAhead ());
+}
+
+void
+testFileNames ()
+{
+    cout << "frame file names" << endl;
+
+    SequenceReader a ("plate.%04d.exr", 1, 10);
+    assert (a.frameFileName (7) == "plate.0007.exr");
+    assert (a.frameFileName (12345) == "plate.12345.exr");
+
+    SequenceReader b ("v2/plate.###.exr", 1, 10);
+    assert (b.frameFileName (42) == "v2/plate.042.exr");
+
+    SequenceReader c ("%d.exr", -5, 10);
+    assert (c.frameFileName (-5) == "-5.exr");
+
+    const char* invalid[] = {"plate.exr", "plate.%f.exr", "plate.%04"};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        try
+        {
+            SequenceReader r (invalid[i], 1, 10);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+    }
+
+    try
+    {
+        SequenceReader r ("plate.#.exr", 10, 1);
+        assert (false);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        // expected
+    }
+}
+
+void
+testPlayback (const string& pattern)
+{
+    {
+        cout << "forward" << endl;
+
+        SequenceReader reader (pattern, FIRST, LAST);
+        reader.setReadAheadLimits (2, 4);
+        assert (reader.readAhead () == 2);
+
+        for (int f = FIRST; f <= LAST; ++f)
+            checkFrame (reader, f);
+
+        //
+        // Playing the sequence again, as a loop would.
+        //
+
+        for (int f = FIRST; f <= LAST; ++f)
+            checkFrame (reader, f);
+
+        assert (reader.frameReadTime () > 0);
+        assert (reader.framePeriod () > 0);
+
+        try
+        {
+            reader.frame (LAST + 1);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+    }
+
+    {
+        cout << "backward, then forward" << endl;
+
+        SequenceReader reader (pattern, FIRST, LAST);
+        reader.setDirection (SequenceReader::BACKWARD);
+        assert (reader.direction () == SequenceReader::BACKWARD);
+
+        for (int f = LAST; f >= FIRST + 4; --f)
+            checkFrame (reader, f);
+
+        reader.setDirection (SequenceReader::FORWARD);
+
+        for (int f = FIRST + 4; f <= LAST; ++f)
+            checkFrame (reader, f);
+    }
+
+    {
+        cout << "random access" << endl;
+
+        SequenceReader reader (pattern, FIRST, LAST);
+        reader.setReadAheadLimits (0, 3);
+
+        int frames[] = {20, 11, 11, 12, 16, 17, 18, 14, 21, 10, 13, 15};
+
+        for (int i = 0; i < 12; ++i)
+            checkFrame (reader, frames[i]);
+
+        try
+        {
+            reader.setReadAheadLimits (3, 2);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::ArgExc&)
+        {
+            // expected
+        }
+    }
+
+    {
+        //
+        // Destroying a reader while frames are read ahead.
+        //
+
+        SequenceReader reader (pattern, FIRST, LAST);
+        reader.setReadAheadLimits (8, 8);
+        checkFrame (reader, FIRST);
+    }
+}
+
+void
+testTiledPlayback (const string& pattern)
+{
+    //
+    // Reading tiled frames ahead must not block the threads that
+    // decode the tiles.
+    //
+
+    cout << "tiled frames" << endl;
+
+    SequenceReader reader (pattern, TILED_FIRST, TILED_LAST);
+    reader.setReadAheadLimits (4, 4);
+
+    for (int f = TILED_FIRST; f <= TILED_LAST; ++f)
+        checkFrame (reader, f, true);
+
+    reader.setDirection (SequenceReader::BACKWARD);
+
+    for (int f = TILED_LAST; f >= TILED_FIRST; --f)
+        checkFrame (reader, f, true);
+}
+
+} // namespace
+
+void
+testSequenceReader (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing SequenceReader" << endl;
+
+        testFileNames ();
+
+        string         pattern = tempDir + "imf_test_sequence.####.exr";
+        SequenceReader names (pattern, FIRST, LAST);
+
+        for (int f = FIRST; f <= LAST; ++f)
+            if (f != MISSING)
+                writeFrame (names.frameFileName (f), f, f == 15);
+
+        string         tiledPattern = tempDir + "imf_test_tiled.####.exr";
+        SequenceReader tiledNames (tiledPattern, TILED_FIRST, TILED_LAST);
+
+        for (int f = TILED_FIRST; f <= TILED_LAST; ++f)
+            writeFrame (tiledNames.frameFileName (f), f, true);
+
+        const int threads[] = {0, 1, 3};
+        int       numTests  = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 1;
+
+        for (int i = 0; i < numTests; ++i)
+        {
+            setGlobalThreadCount (threads[i]);
+            cout << "number of threads: " << globalThreadCount () << endl;
+
+            testPlayback (pattern);
+            testTiledPlayback (tiledPattern);
+        }
+
+        for (int f = FIRST; f <= LAST; ++f)
+            remove (names.frameFileName (f).c_str ());
+
+        for (int f = TILED_FIRST; f <= TILED_LAST; ++f)
+            remove (tiledNames.frameFileName (f).c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
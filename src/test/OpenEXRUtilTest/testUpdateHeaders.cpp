@@ -0,0 +1,412 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <ImathRandom.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfDeepImage.h>
+#include <ImfDeepImageIO.h>
+#include <ImfFlatImage.h>
+#include <ImfFlatImageIO.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
+#include <ImfStandardAttributes.h>
+#include <ImfTiledInputPart.h>
+#include <ImfTiledOutputPart.h>
+#include <ImfUpdateHeaders.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+uint64_t
+fileSize (const string& fileName)
+{
+    ifstream in (fileName.c_str (), ios::binary | ios::ate);
+    return uint64_t (in.tellg ());
+}
+
+vector<Header>
+readHeaders (const string& fileName)
+{
+    MultiPartInputFile in (fileName.c_str ());
+    vector<Header>     headers;
+
+    for (int p = 0; p < in.parts (); ++p)
+        headers.push_back (in.header (p));
+
+    return headers;
+}
+
+bool
+update (const string& inFileName, const string& outFileName, vector<Header>& h)
+{
+    return updateFileHeaders (
+        inFileName.c_str (), outFileName.c_str (), &h[0], int (h.size ()));
+}
+
+void
+fillFlatImage (FlatImage& img)
+{
+    img.insertChannel ("H", HALF);
+
+    Rand48                       random (0);
+    TypedFlatImageChannel<half>& h  = img.level ().typedChannel<half> ("H");
+    const Box2i&                 dw = img.dataWindow ();
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+            h.at (x, y) = random.nextf (0, 1);
+}
+
+void
+compareFlatImages (const FlatImage& img1, const FlatImage& img2)
+{
+    assert (img1.dataWindow () == img2.dataWindow ());
+
+    const TypedFlatImageChannel<half>& h1 =
+        img1.level ().typedChannel<half> ("H");
+    const TypedFlatImageChannel<half>& h2 =
+        img2.level ().typedChannel<half> ("H");
+    const Box2i& dw = img1.dataWindow ();
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+            assert (h1.at (x, y).bits () == h2.at (x, y).bits ());
+}
+
+void
+testScanLines (const string& fileName, const string& fileName2)
+{
+    cout << "    single-part scan lines" << endl;
+
+    FlatImage img (Box2i (V2i (-2, 3), V2i (90, 70)));
+    fillFlatImage (img);
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    addOwner (hdr, "abc");
+    saveFlatScanLineImage (fileName, hdr, img);
+
+    uint64_t size = fileSize (fileName);
+
+    //
+    // a value of the same size is written in place
+    //
+
+    vector<Header> headers = readHeaders (fileName);
+    addOwner (headers[0], "xyz");
+    addExpTime (headers[0], 0.5f);
+
+    assert (!update (fileName, fileName, headers));
+
+    headers = readHeaders (fileName);
+    assert (headers[0].typedAttribute<StringAttribute> ("owner").value () ==
+            "xyz");
+
+    size = fileSize (fileName);
+    addOwner (headers[0], "uvw");
+    headers[0].typedAttribute<FloatAttribute> ("expTime").value () = 2;
+
+    assert (update (fileName, fileName, headers));
+    assert (fileSize (fileName) == size);
+
+    FlatImage img2;
+    loadFlatImage (fileName, hdr, img2);
+    compareFlatImages (img, img2);
+
+    assert (owner (hdr) == "uvw");
+    assert (expTime (hdr) == 2);
+
+    //
+    // a longer value moves the pixel data
+    //
+
+    cout << "    header larger than the original" << endl;
+
+    addComments (headers[0], string (1000, 'c'));
+
+    assert (!update (fileName, fileName, headers));
+    assert (fileSize (fileName) > size + 1000);
+
+    loadFlatImage (fileName, hdr, img2);
+    compareFlatImages (img, img2);
+    assert (comments (hdr) == string (1000, 'c'));
+
+    //
+    // and a shorter one moves it back
+    //
+
+    cout << "    header smaller than the original" << endl;
+
+    headers[0].erase ("comments");
+    headers[0].erase ("owner");
+
+    assert (!update (fileName, fileName2, headers));
+    assert (fileSize (fileName2) < size);
+
+    Header hdr2;
+    loadFlatImage (fileName2, hdr2, img2);
+    compareFlatImages (img, img2);
+    assert (!hasOwner (hdr2) && !hasComments (hdr2));
+
+    //
+    // attributes that define the chunks cannot change
+    //
+
+    cout << "    layout attributes" << endl;
+
+    headers = readHeaders (fileName2);
+    headers[0].compression () = PIZ_COMPRESSION;
+
+    bool caught = false;
+
+    try
+    {
+        update (fileName2, fileName2, headers);
+    }
+    catch (const IEX_NAMESPACE::ArgExc& e)
+    {
+        cout << "        " << e.what () << endl;
+        caught = true;
+    }
+
+    assert (caught);
+
+    loadFlatImage (fileName2, hdr2, img2);
+    compareFlatImages (img, img2);
+    assert (hdr2.compression () == ZIP_COMPRESSION);
+}
+
+void
+testMultiPart (const string& fileName)
+{
+    cout << "    multi-part file" << endl;
+
+    const int w = 70;
+    const int h = 45;
+
+    Array2D<half> pixels[2];
+    Rand48        random (1);
+
+    for (int p = 0; p < 2; ++p)
+    {
+        pixels[p].resizeErase (h, w);
+
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                pixels[p][y][x] = random.nextf (0, 1);
+    }
+
+    Header headers[2];
+
+    for (int p = 0; p < 2; ++p)
+    {
+        headers[p] = Header (w, h);
+        headers[p].channels ().insert ("H", Channel (HALF));
+        headers[p].compression () = p ? PIZ_COMPRESSION : RLE_COMPRESSION;
+        headers[p].setName (p ? "tiled" : "scanlines");
+    }
+
+    headers[0].setType (SCANLINEIMAGE);
+    headers[1].setType (TILEDIMAGE);
+    headers[1].setTileDescription (TileDescription (16, 16));
+
+    {
+        MultiPartOutputFile out (fileName.c_str (), headers, 2);
+
+        for (int p = 0; p < 2; ++p)
+        {
+            FrameBuffer fb;
+            fb.insert (
+                "H",
+                Slice (
+                    HALF,
+                    (char*) &pixels[p][0][0],
+                    sizeof (half),
+                    sizeof (half) * w));
+
+            if (p == 0)
+            {
+                OutputPart part (out, p);
+                part.setFrameBuffer (fb);
+                part.writePixels (h);
+            }
+            else
+            {
+                TiledOutputPart part (out, p);
+                part.setFrameBuffer (fb);
+                part.writeTiles (
+                    0, part.numXTiles () - 1, 0, part.numYTiles () - 1);
+            }
+        }
+    }
+
+    vector<Header> newHeaders = readHeaders (fileName);
+    addOwner (newHeaders[1], string (300, 'o'));
+    newHeaders[0].setName ("s");
+
+    assert (!update (fileName, fileName, newHeaders));
+
+    //
+    // a float attribute has the same size in every part, but shared
+    // attributes must stay the same in all parts
+    //
+
+    newHeaders = readHeaders (fileName);
+    newHeaders[0].pixelAspectRatio () = 2;
+
+    bool caught = false;
+
+    try
+    {
+        update (fileName, fileName, newHeaders);
+    }
+    catch (const IEX_NAMESPACE::ArgExc& e)
+    {
+        cout << "        " << e.what () << endl;
+        caught = true;
+    }
+
+    assert (caught);
+
+    newHeaders[1].pixelAspectRatio () = 2;
+    assert (update (fileName, fileName, newHeaders));
+
+    MultiPartInputFile in (fileName.c_str ());
+    assert (in.parts () == 2);
+    assert (in.header (0).name () == "s");
+    assert (in.header (0).pixelAspectRatio () == 2);
+    assert (owner (in.header (1)) == string (300, 'o'));
+
+    for (int p = 0; p < 2; ++p)
+    {
+        Array2D<half> pixels2 (h, w);
+        FrameBuffer   fb;
+        fb.insert (
+            "H",
+            Slice (
+                HALF,
+                (char*) &pixels2[0][0],
+                sizeof (half),
+                sizeof (half) * w));
+
+        if (p == 0)
+        {
+            InputPart part (in, p);
+            part.setFrameBuffer (fb);
+            part.readPixels (0, h - 1);
+        }
+        else
+        {
+            TiledInputPart part (in, p);
+            part.setFrameBuffer (fb);
+            part.readTiles (0, part.numXTiles () - 1, 0, part.numYTiles () - 1);
+        }
+
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                assert (pixels[p][y][x].bits () == pixels2[y][x].bits ());
+    }
+}
+
+void
+testDeep (const string& fileName)
+{
+    cout << "    deep scan lines" << endl;
+
+    DeepImage img (Box2i (V2i (0, 0), V2i (30, 20)), ONE_LEVEL);
+    img.insertChannel ("Z", FLOAT);
+
+    Rand48              random (2);
+    SampleCountChannel& scc = img.level ().sampleCounts ();
+
+    {
+        SampleCountChannel::Edit edit (scc);
+        size_t numPixels = scc.pixelsPerRow () * scc.pixelsPerColumn ();
+
+        for (size_t i = 0; i < numPixels; ++i)
+            edit.sampleCounts ()[i] = random.nexti () % 4;
+    }
+
+    TypedDeepImageChannel<float>& z = img.level ().typedChannel<float> ("Z");
+
+    for (int y = 0; y <= 20; ++y)
+        for (int x = 0; x <= 30; ++x)
+            for (unsigned int s = 0; s < scc.at (x, y); ++s)
+                z.at (x, y)[s] = random.nextf (0, 100);
+
+    Header hdr;
+    hdr.compression () = ZIPS_COMPRESSION;
+    saveDeepScanLineImage (fileName, hdr, img);
+
+    vector<Header> headers = readHeaders (fileName);
+    addComments (headers[0], "deep");
+
+    assert (!update (fileName, fileName, headers));
+
+    DeepImage img2;
+    loadDeepImage (fileName, hdr, img2);
+    assert (comments (hdr) == "deep");
+
+    const SampleCountChannel& scc2 = img2.level ().sampleCounts ();
+    const TypedDeepImageChannel<float>& z2 =
+        img2.level ().typedChannel<float> ("Z");
+
+    for (int y = 0; y <= 20; ++y)
+    {
+        for (int x = 0; x <= 30; ++x)
+        {
+            assert (scc.at (x, y) == scc2.at (x, y));
+
+            for (unsigned int s = 0; s < scc.at (x, y); ++s)
+                assert (z.at (x, y)[s] == z2.at (x, y)[s]);
+        }
+    }
+}
+
+} // namespace
+
+void
+testUpdateHeaders (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing header updates without rewriting pixels" << endl;
+
+        string fileName  = tempDir + "updateHeaders.exr";
+        string fileName2 = tempDir + "updateHeaders2.exr";
+
+        testScanLines (fileName, fileName2);
+        testMultiPart (fileName);
+        testDeep (fileName);
+
+        remove (fileName.c_str ());
+        remove (fileName2.c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -49,6 +49,31 @@ assert(result.returncode == 0)
 # confirm the output has the proper chromaticities
 assert("chromaticities: chromaticities r[0.7347, 0.2653] g[0, 1] b[0.0001, -0.077] w[0.32168, 0.33767]" in result.stdout)
 
+# an ACES image file is copied without recompressing it
+fd, outimage2 = tempfile.mkstemp(".exr")
+os.close(fd)
+atexit.register(os.unlink, outimage2)
+
+result = run ([exr2aces, "-v", "-j", "2", outimage, outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("Copying pixels" in result.stdout)
+assert(os.path.getsize(outimage) == os.path.getsize(outimage2))
+
+# a tiled, multiresolution image is converted to scan lines
+image = f"{image_dir}/MultiResolution/ColorCodedLevels.exr"
+result = run ([exr2aces, "-v", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("ERROR" not in result.stdout + result.stderr)
+assert("lineOrder 0 (increasing)" in result.stdout)
+assert("scanlineimage" in result.stdout)
+assert("tiles:" not in result.stdout)
+
 print("success")
 
 
@@ -125,6 +125,39 @@ assert(os.path.isfile(outimage))
 file_size = os.path.getsize(outimage)
 assert(file_size != default_file_size)
 
+# -bsh (spherical harmonics blur)
+result = run ([exrenvmap, "-bsh", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert(os.path.isfile(outimage))
+file_size = os.path.getsize(outimage)
+assert(file_size != default_file_size)
+
+# -g (glossy blur)
+result = run ([exrenvmap, "-g", "8", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert(os.path.isfile(outimage))
+
+result = run ([exrenvmap, "-g", "0", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0)
+
+# -bw (blur resolution)
+result = run ([exrenvmap, "-b", "-bw", "16", "24", "-c", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert(os.path.isfile(outimage))
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert('envmap: envmap cube' in result.stdout)
+os.unlink(outimage)
+
+result = run ([exrenvmap, "-b", "-bw", "0", "24", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0)
+
 # -t 
 result = run ([exrenvmap, "-t", "32", "48", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
 print(" ".join(result.args))
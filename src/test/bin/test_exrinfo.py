@@ -26,6 +26,13 @@ assert ('800 x 800' in output[2])
 assert ('800 x 800' in output[3])
 assert ('1 channels' in output[4])
 
+result = run ([exrinfo, "--stats", image], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert ('statistics:' in result.stdout)
+assert ("decoded: 50 'pxr24' chunks" in result.stdout)
+assert ('decompressed: 1280000 bytes' in result.stdout)
+
 # test image as stdio
 with open(image, 'rb') as f:
     data = f.read()
@@ -52,6 +52,24 @@ assert(result.returncode == 0)
 output = result.stdout.split('\n')
 assert("preview 50 x 50" in find_line("  preview", output))
 
+# same size preview on the same file: only the header is rewritten
+result = run ([exrmakepreview, "-w", "50", "-e", "2", "-v", outimage, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("updated header of" in result.stdout)
+
+# different size: the file is copied
+result = run ([exrmakepreview, "-w", "40", "-v", outimage, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("updated header of" not in result.stdout)
+
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+output = result.stdout.split('\n')
+assert("preview 40 x 40" in find_line("  preview", output))
+
 print("success")
 
 
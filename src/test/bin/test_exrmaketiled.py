@@ -48,4 +48,15 @@ print(" ".join(result.args))
 assert(result.returncode == 0)
 assert('tiled image has levels: x 1 y 1' in result.stdout)
 
+# multiresolution images keep INCREASING_Y line order
+for mode in ["-m", "-r"]:
+    result = run ([exrmaketiled, mode, "-j", "2", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+
+    result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+    assert("lineOrder 0 (increasing)" in result.stdout)
+
 print("success")
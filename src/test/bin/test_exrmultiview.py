@@ -28,9 +28,14 @@ right_image = f"{image_dir}/TestImages/GrayRampsHorizontal.exr"
 fd, outimage = tempfile.mkstemp(".exr")
 os.close(fd)
 
+fd, tiledimage = tempfile.mkstemp(".exr")
+os.close(fd)
+
 def cleanup():
     print(f"deleting {outimage}")
     os.unlink(outimage)
+    print(f"deleting {tiledimage}")
+    os.unlink(tiledimage)
 atexit.register(cleanup)
 
 command = [exrmultiview, "left", left_image, "right", right_image, outimage]
@@ -46,5 +51,57 @@ assert('\'G\': half samp 1 1' in result.stdout)
 assert('\'R\': half samp 1 1' in result.stdout)
 assert('\'right.Y\': half samp 1 1' in result.stdout)
 
+# -p: one part per view, chunks copied without recompression
+
+command = [exrmultiview, "-p", "-v", "left", left_image, "right", right_image, outimage]
+result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("copying file" in result.stdout)
+
+result = run ([exrinfo, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("part 1: left" in result.stdout)
+assert("part 2: right" in result.stdout)
+assert('\'Y\': half samp 1 1' in result.stdout)
+
+# -p with a new compression method converts the views
+
+command = [exrmultiview, "-p", "-z", "zip", "-j", "2", "-v",
+           "left", left_image, "right", right_image, outimage]
+result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("converting file" in result.stdout)
+
+result = run ([exrinfo, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert(result.stdout.count("compression: 'zip'") == 2)
+
+# a tiled multiresolution image with RANDOM_Y line order is converted
+# to INCREASING_Y scan lines
+
+with open(f"{image_dir}/MultiResolution/ColorCodedLevels.exr", "rb") as f:
+    data = bytearray(f.read())
+lineorder = data.find(b"lineOrder\0lineOrder\0") + 24
+data[lineorder] = 2
+with open(tiledimage, "wb") as f:
+    f.write(data)
+
+for args in [[], ["-p", "-z", "piz"]]:
+    command = [exrmultiview] + args + ["left", tiledimage, "right", tiledimage, outimage]
+    result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+
+    result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+    assert("ERROR" not in result.stdout + result.stderr)
+    assert("lineOrder 0 (increasing)" in result.stdout)
+    assert("tiles:" not in result.stdout)
+
 print("success")
 
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) Contributors to the OpenEXR Project.
+
+import sys, os, tempfile, atexit
+from subprocess import PIPE, run
+
+print(f"testing exrrecompress: {sys.argv}")
+
+exrrecompress = sys.argv[1]
+exrinfo = sys.argv[2]
+image_dir = sys.argv[3]
+
+image = f"{image_dir}/TestImages/GammaChart.exr"
+
+assert(os.path.isfile(exrrecompress))
+assert(os.path.isfile(exrinfo))
+assert(os.path.isdir(image_dir))
+assert(os.path.isfile(image))
+
+fd, outimage = tempfile.mkstemp(".exr")
+os.close(fd)
+
+def cleanup():
+    print(f"deleting {outimage}")
+atexit.register(cleanup)
+
+# no args = usage message
+result = run ([exrrecompress], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 1)
+assert(result.stderr.startswith ("Usage: "))
+
+# -h = usage message
+result = run ([exrrecompress, "-h"], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 1)
+assert(result.stderr.startswith ("Usage: "))
+
+# bad compression method
+result = run ([exrrecompress, "-z", "foo", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 1)
+
+for z in ["none", "rle", "zips", "zip", "piz", "pxr24", "b44", "b44a", "dwaa", "dwab"]:
+
+    result = run ([exrrecompress, "-v", "-j", "2", "-z", z, image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+    assert("stage times" in result.stdout)
+
+    result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+    assert(f"compression: compression '{z}'" in result.stdout)
+
+# bad compression levels
+for z, l in [("dwaa", "abc"), ("dwaa", "-1"), ("dwab", "45x"), ("zip", "5x"), ("zip", "10")]:
+    result = run ([exrrecompress, "-z", z, "-l", l, image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 1)
+    assert("Compression level must be" in result.stderr)
+
+# the dwa level is stored in the output, and kept when no level is given
+fd, outimage2 = tempfile.mkstemp(".exr")
+os.close(fd)
+
+result = run ([exrrecompress, "-z", "dwaa", "-l", "100", image, outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+
+for z, l, expected in [("dwab", [], "100"), ("dwab", ["-l", "60"], "60")]:
+    result = run ([exrrecompress, "-z", z] + l + [outimage2, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+
+    result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0)
+    assert(f"dwaCompressionLevel: float {expected}" in result.stdout)
+
+os.unlink(outimage2)
+
+print("success")
@@ -112,4 +112,26 @@ assert('whiteLuminance: float 17.1' in result.stdout)
 assert('wrapmodes: string \'clamp\'' in result.stdout)
 assert('xDensity: float 10' in result.stdout)
 
+# same file, same size: only the headers are rewritten
+size = os.path.getsize(outimage)
+result = run ([exrstdattr, "-v", "-owner", "florina", "-expTime", "5.3", outimage, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("updated headers of" in result.stdout)
+assert(os.path.getsize(outimage) == size)
+
+# same file, longer value: the pixel data are copied
+result = run ([exrstdattr, "-v", "-owner", "florian and florina", outimage, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert("updated headers of" not in result.stdout)
+assert(os.path.getsize(outimage) == size + 12)
+
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0)
+assert('expTime: float 5.3' in result.stdout)
+assert('owner: string \'florian and florina\'' in result.stdout)
+assert('dataWindow: box2i [ 0, 0 - 799 799 ] 800 x 800' in result.stdout)
+
 print("success")